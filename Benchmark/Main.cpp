@@ -0,0 +1,5198 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: main.cpp
+////////////////////////////////////////////////////////////////////////////////
+/*The Benchmark project is a console program that runs the engine's benchmarks without a window, so it can run on the
+build machines. Each benchmark is a suite picked by the first argument, "frame" is the default.
+
+Benchmark frame [-frames N] [-warmup N] [-instances N] [-objects N] [-model file.obj] [-no-lod] [-output file]
+                [-baseline file] [-threshold fraction] [-update-baseline] [-trace file] [-replay file]
+
+The frame suite draws N frames on the headless device, writes the timings to the output file and compares them with
+the baseline file. The program returns 1 when a stage got slower than the threshold allows, so the build fails.
+The scene is a grid of -instances copies of the model (1 by default) drawn with one instanced draw call plus -objects
+copies (0 by default) that are each drawn on their own, compare against a baseline taken with the same scene. The
+model is the one of the engine or the -model OBJ file, drawn with levels of detail unless -no-lod is given.
+With -trace the profiler zones of the measured frames are written as a Chrome trace, this needs a build with the
+profiler compiled in. With -replay the camera follows the input log instead of the scripted path, a log recorded by
+starting the engine with "-record file" or written by the replay suite.
+
+Benchmark transform [-count N] [-output file]
+
+The transform suite times the TransformBatchClass paths (scalar, SSE and AVX2 where the processor has it) on 1k, 10k,
+100k and 1M world matrices, or only on -count matrices, and checks that the SIMD paths give the same matrices as the
+scalar one. The results are written to the output file, transform.json by default.
+
+Benchmark cull [-count N] [-output file]
+
+The cull suite times the FrustumCullerClass paths with spheres and boxes on 10k, 100k and 1M objects scattered around
+the camera, or only on -count objects, on one thread and on the job system. Every path must find the same visible
+objects as the scalar one. The results are written to the output file, cull.json by default.
+
+Benchmark mesh [-triangles N] [-output file]
+
+The mesh suite writes a grid OBJ file of 100k, 1M and 4M triangles, or only of -triangles triangles, imports it into
+a mesh file and times parsing the OBJ, writing the mesh file and loading it again: mapping it and creating the vertex
+and index buffers of the headless device straight from the mapped pages. The loaded mesh must match the imported one.
+The results are written to the output file, mesh.json by default.
+
+Benchmark vcache [-input file.obj] [-triangles N] [-output file]
+
+The vcache suite is the report of the mesh optimizer. It prints the ACMR and ATVR (see MeshOptimizerClass) of the
+model of the engine, of the -input OBJ file, of a grid of -triangles triangles (1M by default) in row order and of the
+same grid with its triangles shuffled, before and after optimizing them, with the time the optimizer took and the
+size of the index buffer. The optimized meshes must still have the same triangles. The results are written to the
+output file, vcache.json by default.
+
+Benchmark vformat [-input file.obj] [-triangles N] [-output file]
+
+The vformat suite is the report of the vertex formats (see VertexFormatClass). For the model of the engine, the -input
+OBJ file and a grid of -triangles triangles (1M by default), optimized the way the importer does, it prints for every
+format the size of a vertex, of the vertex and index buffers and how much smaller they are than with float vertices,
+the bytes the vertex shader fetches per draw after the vertex cache, the time encoding took and the largest position,
+color and normal error after decoding. The results are written to the output file, vformat.json by default.
+
+Benchmark lod [-triangles N] [-objects N] [-frames N] [-warmup N] [-output file]
+
+The lod suite imports a rolling terrain of -triangles triangles (200k by default) with its levels of detail, prints the
+triangles and error of every level and the time the import took, and then runs the frame suite's scene with -objects
+copies of it (400 by default) once with every copy in full and once with levels of detail. It compares the triangles
+drawn per frame and the time spent submitting and executing the draws. The results are written to the output file,
+lod.json by default.
+
+Benchmark texture [-input file.tga] [-repeats N] [-output file]
+
+The texture suite times the texture importer on the -input TGA file (resources/stone01.tga by default): decoding it
+from the mapped file as it is and run length encoded, building its mip chain with the SIMD box filter and with a plain
+scalar one, importing it into a texture file and loading that texture file onto the headless device. The decoders are
+reported in MB of RGBA texels per second, the mip chain in MB of the top level per second, each the best of -repeats
+runs (20 by default). Both decoders must give the same texels, both filters the same mip chain and the loaded texture
+the imported one.
+
+It then compresses the top level to BC1, BC3 and BC7 with the fast, normal and high presets, on one thread and on the
+job system, and reports the time, the ratio and the PSNR of the decompressed texels over RGB and RGBA. The job system
+must write the same blocks and a better preset must not lose quality. Last it imports and loads the file with the
+default preset. The results are written to the output file, texture.json by default.
+
+Benchmark shader [-repeats N] [-cache directory] [-output file]
+
+The shader suite times starting the color shader without a shader archive, cold, with none of its shaders in the
+-cache directory (shader_benchmark_cache by default) so all of them are compiled and written to it, and warm, with all
+of them read from it, each the best of -repeats runs (20 by default). A cold start must compile every shader and a
+warm one none, and what comes out of the cache must be exactly the bytecode and reflection the compiler makes. It also
+checks that the key changes with the defines and that changing a file the shader includes compiles it again, and that
+the reflection catches a changed constant buffer, a parameter of the wrong size and an input layout without the inputs
+of the vertex shader of every vertex format. The headless device takes the reflection from the fixtures next to the
+sources, the suite writes one for the shader of its include test. The results are written to the output file,
+shader.json by default.
+
+Benchmark permutation [-repeats N] [-output file]
+
+The permutation suite builds the shader archive of color.permutations on one thread and on the job system, which must
+write the same file, and checks that every valid variant in it is exactly what the compiler makes of it and that the
+others aren't there. It times getting every variant out of the archive and starting the color shader from it, which
+must not compile anything, each the best of -repeats runs (20 by default). Last it checks that an archive is no longer
+used once a source it was built from changes. The results are written to the output file, permutation.json by default.
+
+Benchmark reload [-edits N] [-interval ms] [-cache directory] [-output file]
+
+The reload suite starts the color shader from copies of its sources with a shader reloader that looks at them every
+-interval milliseconds (250 by default) and runs empty frames that swap in what it reloads, the way Graphics::Frame
+does. It edits the pixel shader -edits times (5 by default), each of which has to reach the frames once, then breaks
+the vertex shader, which must be seen as a failure while the old shader stays, and fixes it again. It reports the time
+from an edit to the frame that uses it and the longest start of a frame, which must not wait for the compiler, and
+checks that every swapped out shader was released. A reloader without a description, like in a game that ships only
+the archive, has to start without watching anything. The results are written to the output file, reload.json by default.
+
+Benchmark record [-draws N] [-threads N] [-repeats N] [-output file]
+
+The record suite issues a sorted render queue of 10k, 30k and 100k draws, or only -draws draws, of 64 meshes with 8
+shaders and constants of their own on the headless device, once with Execute on the immediate context and then with
+ExecuteParallel recording command lists on 1 up to -threads threads (every core, but at least 2, by default), each the
+best of -repeats runs (10 by default). With every thread count the immediate context must end up with the same draws
+in the same order as with Execute, each with the same objects bound inside the command list it was recorded in. It
+reports the time, the speedup over one thread and the binds the extra command lists cost. Last the queue is issued
+once more with a device that can't bind constant buffers at an offset, which has to draw the same on the immediate
+context with every constant slice copied into the buffer of its slot right before the draw that binds it. The results
+are written to the output file, record.json by default.
+
+Benchmark jobs [-jobs N] [-threads N] [-repeats N] [-output file]
+
+The jobs suite measures the JobSystemClass on 1 up to -threads threads (every core, but at least 4, by default). It
+times spawning -jobs empty jobs (100k by default) as children of one job and an empty parallel for with a job for every
+item, in ns per job. For load balancing it runs a parallel for over items whose cost grows with the square of their
+index and reports the time, the speedup over one thread and how many jobs each thread ran and stole. Every item must be done exactly once, a chain and a diamond of jobs
+with dependencies must run in order and a main thread job must run on the main thread. Each time is the best of
+-repeats runs (10 by default). The results are written to the output file, jobs.json by default.
+
+Benchmark simulation [-objects N] [-seconds N] [-output file]
+
+The simulation suite runs the SimulationClass with -objects spinning objects (10k by default). It first steps it by
+hand, checking every snapshot and the blend and interpolation between its two states, and times a step. Then it runs
+the simulation thread for -seconds seconds (1 by default) next to frames that take 1, 16, 50 and 100 ms. The simulation
+must run 60 steps a second with every frame time and drop none, and every snapshot a frame gets must be one whole step.
+Last it draws the objects with Graphics on the headless device with and without the simulation; every object that was
+visible standing still must still be visible while it spins. The results are written to the output file,
+simulation.json by default.
+
+Benchmark pacing [-frames N] [-output file]
+
+The pacing suite runs the FramePacerClass on the SimulatedClockClass for -frames frames (600 by default) in a few
+scenes: bound by the GPU, on a 60 Hz vsync and with a frame rate cap of 100, each with 1 up to 3 frames in flight,
+while input events come in at random times. It reports the frame time and how long the input waits for the present
+and for the screen, on average and at worst. There must never be more frames in flight than allowed, the cap must
+hold the frame time to 10 ms and 1 frame in flight must not wait longer for the screen than 3. Last it paces the
+headless device on the real clock of a DeviceClockClass: capped at 200 frames a second, which must come out at 5 ms a
+frame, and with 1 frame in flight on a GPU that takes 4 ms a frame, which must come out at the GPU's frame time
+without a second frame in flight. The results are written to the output file, pacing.json by default.
+
+Benchmark input [-events N] [-output file]
+
+The input suite first checks the key state of the Input: a tap between two updates is pressed and released but not
+down, a held key is down and was down at the update before, and events that don't fit in the queue are dropped and
+counted. Then one thread pushes -events events (10 million by default) into the InputQueueClass while another pops
+them, once one at a time from both ends and once on a single thread in batches, and every event must come out once and
+in order. Last a thread feeds key events into an Input that another thread updates like the simulation thread would,
+and the key state must end up the same as the events say. The results are written to the output file, input.json by
+default.
+
+Benchmark replay [-frames N] [-output file] [-log file]
+
+The replay suite records -frames frames (2000 by default) of scripted key presses with uneven frame times into an input
+log, saves it as the -log file (replay.inputlog by default) and loads it again. Replaying it into a new Input and
+CameraControllerClass must give the same frame times and events and put the camera at exactly the same spot in every
+frame. Then the frame suite's scene is drawn twice along the log and both runs must draw the same objects and
+triangles. It reports the size of the log and the time recording and replaying took. The results are written to the
+output file, replay.json by default.
+
+Benchmark scene [-nodes N] [-threads N] [-output file]
+
+The scene suite builds a SceneGraphClass of 100k and 1M nodes, or only of -nodes nodes, as a tree of 8 children a node
+added depth first, so the first update has to sort it. It times three updates on one thread and with the job system on
+-threads threads (every core, but at least 2, by default): one where the root turned and every node moves, one where 1%
+of the nodes moved and one where nothing did. After each the world matrices must match the ones worked out node by
+node from the root down, the update must have rebuilt exactly the nodes under a moved node and the still scene must
+skip every level. The results are written to the output file, scene.json by default.*/
+#include "benchmarkclass.h"
+#include "profilerclass.h"
+#include "timerclass.h"
+#include "transformbatchclass.h"
+#include "frustumcullerclass.h"
+#include "jobsystemclass.h"
+#include "simulationclass.h"
+#include "framepacerclass.h"
+#include "simulatedclockclass.h"
+#include "deviceclockclass.h"
+#include "Input.h"
+#include "inputlogclass.h"
+#include "cameracontrollerclass.h"
+#include "scenegraphclass.h"
+#include "meshfileclass.h"
+#include "meshoptimizerclass.h"
+#include "meshsimplifierclass.h"
+#include "vertexformatclass.h"
+#include "texturefileclass.h"
+#include "textureclass.h"
+#include "shadercacheclass.h"
+#include "shaderarchiveclass.h"
+#include "shaderreflectionclass.h"
+#include "shaderreloaderclass.h"
+#include "colorshaderclass.h"
+#include "renderqueueclass.h"
+#include "headlessdeviceclass.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+using namespace std;
+
+
+/////////////
+// GLOBALS //
+/////////////
+/*The jobs suite's check jobs take their place in the order they ran from this.*/
+static atomic<int> s_jobSequence;
+
+
+///////////////////////
+// FUNCTION PROTOTYPES //
+///////////////////////
+static int RunFrameBenchmark(int, char**);
+static int RunTransformBenchmark(int, char**);
+static int RunCullBenchmark(int, char**);
+static int RunMeshBenchmark(int, char**);
+static int RunVertexCacheReport(int, char**);
+static int RunVertexFormatReport(int, char**);
+static int RunLodBenchmark(int, char**);
+static int RunTextureBenchmark(int, char**);
+static int RunShaderBenchmark(int, char**);
+static int RunPermutationBenchmark(int, char**);
+static int RunReloadBenchmark(int, char**);
+static int RunRecordBenchmark(int, char**);
+static int RunJobBenchmark(int, char**);
+static int RunSimulationBenchmark(int, char**);
+static int RunPacingBenchmark(int, char**);
+static int RunInputBenchmark(int, char**);
+static int RunReplayBenchmark(int, char**);
+static int RunSceneBenchmark(int, char**);
+static void MakeGridMesh(int, vector<MeshVertexType>&, vector<unsigned int>&);
+static void GetSortedTriangles(const vector<MeshVertexType>&, const vector<unsigned int>&, vector<XMFLOAT3>&);
+static void GetMeshBounds(const vector<MeshVertexType>&, XMFLOAT3&, XMFLOAT3&);
+static bool WriteGridObj(const char*, int);
+static bool WriteObj(const char*, const vector<MeshVertexType>&, const vector<unsigned int>&);
+static bool WriteRleTga(const char*, const vector<unsigned char>&, int, int);
+static void DownsampleReference(const unsigned char*, int, int, unsigned char*);
+static bool IsSameReflection(const RenderShaderReflection&, const RenderShaderReflection&);
+static unsigned int GetVertexFormatMask(ShaderArchiveClass*, const VertexFormatType&);
+static int WaitForReload(ShaderReloaderClass*, ColorShaderClass*&, int&, double&, double&);
+static void GetBoundDraws(const vector<HeadlessCommandType>&, vector<unsigned int>&);
+static bool RunJobChecks(JobSystemClass*);
+static void EmptyJob(void*);
+static void EmptyRange(void*, int, int);
+static void SequenceJob(void*);
+static void ThreadIdJob(void*);
+static void BalanceRange(void*, int, int);
+static int CheckSnapshot(const SimulationSnapshotType*, long long, const vector<float>&);
+static float GetAngleDistance(float, float);
+static double GetSceneError(SceneGraphClass*, vector<XMFLOAT4X4>&);
+static bool ReadTextFile(const char*, string&);
+static bool WriteTextFile(const char*, const string&);
+static long GetFileSize(const char*);
+static const char* GetArgument(int, char**, const char*, const char*);
+static bool HasArgument(int, char**, const char*);
+
+
+int main(int argc, char** argv)
+{
+	const char* suite;
+
+	// The suite is the first argument, as long as it isn't an option.
+	suite = "frame";
+	if (argc > 1 && argv[1][0] != '-')
+	{
+		suite = argv[1];
+	}
+
+	if (strcmp(suite, "frame") == 0)
+	{
+		return RunFrameBenchmark(argc, argv);
+	}
+
+	if (strcmp(suite, "transform") == 0)
+	{
+		return RunTransformBenchmark(argc, argv);
+	}
+
+	if (strcmp(suite, "cull") == 0)
+	{
+		return RunCullBenchmark(argc, argv);
+	}
+
+	if (strcmp(suite, "mesh") == 0)
+	{
+		return RunMeshBenchmark(argc, argv);
+	}
+
+	if (strcmp(suite, "vcache") == 0)
+	{
+		return RunVertexCacheReport(argc, argv);
+	}
+
+	if (strcmp(suite, "vformat") == 0)
+	{
+		return RunVertexFormatReport(argc, argv);
+	}
+
+	if (strcmp(suite, "lod") == 0)
+	{
+		return RunLodBenchmark(argc, argv);
+	}
+
+	if (strcmp(suite, "texture") == 0)
+	{
+		return RunTextureBenchmark(argc, argv);
+	}
+
+	if (strcmp(suite, "shader") == 0)
+	{
+		return RunShaderBenchmark(argc, argv);
+	}
+
+	if (strcmp(suite, "permutation") == 0)
+	{
+		return RunPermutationBenchmark(argc, argv);
+	}
+
+	if (strcmp(suite, "reload") == 0)
+	{
+		return RunReloadBenchmark(argc, argv);
+	}
+
+	if (strcmp(suite, "record") == 0)
+	{
+		return RunRecordBenchmark(argc, argv);
+	}
+
+	if (strcmp(suite, "jobs") == 0)
+	{
+		return RunJobBenchmark(argc, argv);
+	}
+
+	if (strcmp(suite, "simulation") == 0)
+	{
+		return RunSimulationBenchmark(argc, argv);
+	}
+
+	if (strcmp(suite, "pacing") == 0)
+	{
+		return RunPacingBenchmark(argc, argv);
+	}
+
+	if (strcmp(suite, "input") == 0)
+	{
+		return RunInputBenchmark(argc, argv);
+	}
+
+	if (strcmp(suite, "replay") == 0)
+	{
+		return RunReplayBenchmark(argc, argv);
+	}
+
+	if (strcmp(suite, "scene") == 0)
+	{
+		return RunSceneBenchmark(argc, argv);
+	}
+
+	printf("Unknown benchmark suite %s\n", suite);
+	return 1;
+}
+
+/*RunFrameBenchmark runs the BenchmarkClass and checks the results against the stored baseline.*/
+static int RunFrameBenchmark(int argc, char** argv)
+{
+	BenchmarkClass* benchmark;
+	int frameCount, warmupFrames, instanceCount, objectCount, i;
+	const char* outputFile;
+	const char* baselineFile;
+	const char* traceFile;
+	const char* modelFile;
+	const char* replayFile;
+	double threshold;
+	bool result, passed;
+	string report;
+	StageStatisticsType statistics;
+	RenderQueueStatisticsType queueStatistics;
+	FILE* baseline;
+
+	frameCount = atoi(GetArgument(argc, argv, "-frames", "2000"));
+	warmupFrames = atoi(GetArgument(argc, argv, "-warmup", "200"));
+	outputFile = GetArgument(argc, argv, "-output", "benchmark.json");
+	baselineFile = GetArgument(argc, argv, "-baseline", "baseline.json");
+	threshold = atof(GetArgument(argc, argv, "-threshold", "0.10"));
+	instanceCount = atoi(GetArgument(argc, argv, "-instances", "1"));
+	objectCount = atoi(GetArgument(argc, argv, "-objects", "0"));
+	traceFile = GetArgument(argc, argv, "-trace", 0);
+	modelFile = GetArgument(argc, argv, "-model", 0);
+	replayFile = GetArgument(argc, argv, "-replay", 0);
+
+	// Create and run the benchmark.
+	benchmark = new BenchmarkClass;
+	if (!benchmark)
+	{
+		return 1;
+	}
+
+	result = benchmark->Initialize(frameCount, warmupFrames, instanceCount, objectCount, modelFile, !HasArgument(argc, argv, "-no-lod"));
+	if (result && replayFile)
+	{
+		result = benchmark->SetReplay(replayFile);
+		if (!result)
+		{
+			printf("Could not load the input log %s\n", replayFile);
+		}
+	}
+	if (result)
+	{
+		result = benchmark->Run();
+	}
+	if (!result)
+	{
+		printf("The frame benchmark failed to run.\n");
+		benchmark->Shutdown();
+		delete benchmark;
+		return 1;
+	}
+
+	// Print a short summary.
+	printf("%d frames (%d warm up) of %d instances and %d objects\n", frameCount, warmupFrames, instanceCount, objectCount);
+	for (i = 0; i < BenchmarkClass::GetStageCount(); i++)
+	{
+		statistics = benchmark->GetStageStatistics(i);
+		printf("%-18s p50 %10.6f  p95 %10.6f  p99 %10.6f  max %10.6f ms\n", BenchmarkClass::GetStageName(i),
+			statistics.p50, statistics.p95, statistics.p99, statistics.max);
+	}
+
+	// Show how many binds the render queue saved.
+	queueStatistics = benchmark->GetRenderQueueStatistics();
+	printf("render queue: %d draws, binds issued/elided: shader %d/%d, layout %d/%d, vertex buffer %d/%d, index buffer %d/%d, constant buffer %d/%d\n",
+		queueStatistics.commands, queueStatistics.shaderBinds, queueStatistics.shaderBindsElided, queueStatistics.inputLayoutBinds,
+		queueStatistics.inputLayoutBindsElided, queueStatistics.vertexBufferBinds, queueStatistics.vertexBufferBindsElided,
+		queueStatistics.indexBufferBinds, queueStatistics.indexBufferBindsElided, queueStatistics.constantBufferBinds,
+		queueStatistics.constantBufferBindsElided);
+	printf("culling: %.1f of %d objects visible per frame on average\n", benchmark->GetMeanVisibleObjects(), objectCount);
+	printf("levels of detail: %.0f of %.0f triangles drawn per frame on average\n", benchmark->GetMeanTriangles(), benchmark->GetMeanFullTriangles());
+
+	benchmark->WriteResults(outputFile);
+
+	// Write the profiler zones when asked for.
+	if (traceFile)
+	{
+		if (ProfilerClass::WriteChromeTrace(traceFile))
+		{
+			printf("Wrote the profiler trace to %s\n", traceFile);
+		}
+		else
+		{
+			printf("Could not write the profiler trace, the profiler is compiled out of release builds.\n");
+		}
+	}
+
+	// Either store this run as the new baseline or compare against the old one.
+	passed = true;
+	if (HasArgument(argc, argv, "-update-baseline"))
+	{
+		benchmark->WriteResults(baselineFile);
+		printf("Stored the results as the new baseline in %s\n", baselineFile);
+	}
+	else
+	{
+		baseline = fopen(baselineFile, "r");
+		if (baseline)
+		{
+			fclose(baseline);
+
+			passed = benchmark->CompareWithBaseline(baselineFile, threshold, report);
+			printf("\n%s", report.c_str());
+			printf("%s (threshold %.1f%%)\n", passed ? "No regressions" : "Frame time regressed", threshold * 100.0);
+		}
+		else
+		{
+			printf("No baseline at %s, run with -update-baseline to store one.\n", baselineFile);
+		}
+	}
+
+	benchmark->Shutdown();
+	delete benchmark;
+	benchmark = 0;
+
+	ProfilerClass::Shutdown();
+
+	return passed ? 0 : 1;
+}
+
+/*RunTransformBenchmark multiplies the same world matrices with every supported path. Each path runs often enough to
+take a while (about 20 million matrices in total) and the fastest run counts, so the numbers are not thrown off by
+the first run warming the caches.*/
+static int RunTransformBenchmark(int argc, char** argv)
+{
+	const TransformPath paths[] = { TRANSFORM_PATH_SCALAR, TRANSFORM_PATH_SSE, TRANSFORM_PATH_AVX2 };
+	const int pathCount = sizeof(paths) / sizeof(paths[0]);
+	vector<int> counts;
+	vector<XMFLOAT4X4> worldMatrices, reference, output;
+	XMMATRIX viewProjectionMatrix;
+	TimerClass timer;
+	const char* outputFile;
+	int count, countIndex, pathIndex, repeats, repeat, i, element;
+	double best, elapsed, nanoseconds, scalarNanoseconds, error, maxError;
+	bool passed, firstResult;
+	FILE* file;
+
+	outputFile = GetArgument(argc, argv, "-output", "transform.json");
+
+	count = atoi(GetArgument(argc, argv, "-count", "0"));
+	if (count > 0)
+	{
+		counts.push_back(count);
+	}
+	else
+	{
+		counts.push_back(1000);
+		counts.push_back(10000);
+		counts.push_back(100000);
+		counts.push_back(1000000);
+	}
+
+	file = fopen(outputFile, "w");
+	if (!file)
+	{
+		printf("Could not open %s\n", outputFile);
+		return 1;
+	}
+
+	// A view-projection matrix like the one of the camera.
+	viewProjectionMatrix = XMMatrixMultiply(XMMatrixLookAtLH(XMVectorSet(-2.9f, 0.0f, -5.0f, 1.0f), XMVectorSet(-2.5f, 0.0f, -4.0f, 1.0f),
+		XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f)), XMMatrixPerspectiveFovLH(XM_PI / 4.0f, 16.0f / 9.0f, 0.1f, 1000.0f));
+
+	printf("best path: %s\n", TransformBatchClass::GetPathName(TransformBatchClass::GetBestPath()));
+	fprintf(file, "{\n  \"best_path\": \"%s\",\n  \"units\": \"ns per matrix\",\n  \"results\": [\n",
+		TransformBatchClass::GetPathName(TransformBatchClass::GetBestPath()));
+
+	passed = true;
+	firstResult = true;
+	for (countIndex = 0; countIndex < (int)counts.size(); countIndex++)
+	{
+		count = counts[countIndex];
+
+		// Rotated, scaled and moved objects, so no element of the matrices is trivially zero or one.
+		worldMatrices.resize(count);
+		for (i = 0; i < count; i++)
+		{
+			XMStoreFloat4x4(&worldMatrices[i], XMMatrixMultiply(XMMatrixMultiply(XMMatrixScaling(1.0f + (float)(i % 7) * 0.1f, 1.0f, 1.0f),
+				XMMatrixRotationRollPitchYaw((float)i * 0.001f, (float)i * 0.002f, (float)i * 0.003f)),
+				XMMatrixTranslation((float)(i % 100), (float)((i / 100) % 100), (float)(i / 10000))));
+		}
+		reference.resize(count);
+		output.resize(count);
+
+		repeats = 20000000 / count;
+		if (repeats < 3)
+		{
+			repeats = 3;
+		}
+
+		scalarNanoseconds = 0.0;
+		for (pathIndex = 0; pathIndex < pathCount; pathIndex++)
+		{
+			if (!TransformBatchClass::IsPathSupported(paths[pathIndex]))
+			{
+				continue;
+			}
+
+			best = 0.0;
+			for (repeat = 0; repeat < repeats; repeat++)
+			{
+				timer.Start();
+				TransformBatchClass::Multiply(paths[pathIndex], &worldMatrices[0], count, viewProjectionMatrix, &output[0]);
+				elapsed = timer.GetElapsedMilliseconds();
+
+				if (repeat == 0 || elapsed < best)
+				{
+					best = elapsed;
+				}
+			}
+			nanoseconds = best * 1000000.0 / (double)count;
+
+			// The scalar path is the reference for the others.
+			if (paths[pathIndex] == TRANSFORM_PATH_SCALAR)
+			{
+				reference = output;
+				scalarNanoseconds = nanoseconds;
+			}
+
+			maxError = 0.0;
+			for (i = 0; i < count; i++)
+			{
+				for (element = 0; element < 16; element++)
+				{
+					error = fabs((double)(&output[i]._11)[element] - (double)(&reference[i]._11)[element]);
+					error /= 1.0 + fabs((double)(&reference[i]._11)[element]);
+					if (error > maxError)
+					{
+						maxError = error;
+					}
+				}
+			}
+			if (maxError > 1.0e-5)
+			{
+				passed = false;
+			}
+
+			printf("%8d matrices  %-6s %8.3f ns/matrix  %8.1f M matrices/s  %5.2fx  max error %.2g\n", count,
+				TransformBatchClass::GetPathName(paths[pathIndex]), nanoseconds, 1000.0 / nanoseconds, scalarNanoseconds / nanoseconds, maxError);
+			fprintf(file, "%s    { \"count\": %d, \"path\": \"%s\", \"ns_per_matrix\": %.4f, \"speedup\": %.3f, \"max_error\": %.3g }",
+				firstResult ? "" : ",\n", count, TransformBatchClass::GetPathName(paths[pathIndex]), nanoseconds, scalarNanoseconds / nanoseconds, maxError);
+			firstResult = false;
+		}
+	}
+
+	fprintf(file, "\n  ]\n}\n");
+	fclose(file);
+
+	if (!passed)
+	{
+		printf("A SIMD path gave different matrices than the scalar path.\n");
+	}
+
+	ProfilerClass::Shutdown();
+
+	return passed ? 0 : 1;
+}
+
+/*RunCullBenchmark culls the same objects with every supported path and volume, on one thread and on all of them.
+Like the transform suite each combination runs about 20 million object tests and the fastest run counts.*/
+static int RunCullBenchmark(int argc, char** argv)
+{
+	const CullPath paths[] = { CULL_PATH_SCALAR, CULL_PATH_SSE, CULL_PATH_AVX2 };
+	const int pathCount = sizeof(paths) / sizeof(paths[0]);
+	const CullVolume volumes[] = { CULL_VOLUME_SPHERE, CULL_VOLUME_BOX };
+	const char* volumeNames[] = { "sphere", "box" };
+	vector<int> counts;
+	vector<unsigned char> reference;
+	JobSystemClass* jobSystem;
+	FrustumCullerClass* culler;
+	XMFLOAT3 center, extents;
+	XMMATRIX viewProjectionMatrix;
+	TimerClass timer;
+	const char* outputFile;
+	int count, countIndex, volumeIndex, pathIndex, parallel, repeats, repeat, i, mismatches, threadCount;
+	unsigned int random;
+	double best, elapsed, nanoseconds;
+	bool passed, firstResult;
+	CullStatisticsType statistics;
+	FILE* file;
+
+	outputFile = GetArgument(argc, argv, "-output", "cull.json");
+
+	count = atoi(GetArgument(argc, argv, "-count", "0"));
+	if (count > 0)
+	{
+		counts.push_back(count);
+	}
+	else
+	{
+		counts.push_back(10000);
+		counts.push_back(100000);
+		counts.push_back(1000000);
+	}
+
+	file = fopen(outputFile, "w");
+	if (!file)
+	{
+		printf("Could not open %s\n", outputFile);
+		return 1;
+	}
+
+	jobSystem = new JobSystemClass;
+	if (!jobSystem)
+	{
+		fclose(file);
+		return 1;
+	}
+	threadCount = (int)thread::hardware_concurrency() - 1;
+	jobSystem->Initialize(threadCount > 0 ? threadCount : 0);
+
+	culler = new FrustumCullerClass;
+	if (!culler)
+	{
+		fclose(file);
+		return 1;
+	}
+	culler->Initialize(jobSystem);
+
+	// The camera at the origin looking down z, the objects are all around it so most of them get culled.
+	viewProjectionMatrix = XMMatrixMultiply(XMMatrixLookAtLH(XMVectorSet(0.0f, 0.0f, 0.0f, 1.0f), XMVectorSet(0.0f, 0.0f, 1.0f, 1.0f),
+		XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f)), XMMatrixPerspectiveFovLH(XM_PI / 4.0f, 16.0f / 9.0f, 0.1f, 1000.0f));
+
+	printf("best path: %s, %d job threads\n", FrustumCullerClass::GetPathName(FrustumCullerClass::GetBestPath()), jobSystem->GetThreadCount());
+	fprintf(file, "{\n  \"best_path\": \"%s\",\n  \"worker_threads\": %d,\n  \"units\": \"ns per object\",\n  \"results\": [\n",
+		FrustumCullerClass::GetPathName(FrustumCullerClass::GetBestPath()), jobSystem->GetThreadCount());
+
+	passed = true;
+	firstResult = true;
+	for (countIndex = 0; countIndex < (int)counts.size(); countIndex++)
+	{
+		count = counts[countIndex];
+
+		// Scatter the objects with a fixed seed so every run tests the same ones.
+		culler->Clear();
+		random = 12345;
+		for (i = 0; i < count; i++)
+		{
+			random = random * 1664525 + 1013904223;
+			center.x = (float)(random >> 8) / (float)(1 << 24) * 1000.0f - 500.0f;
+			random = random * 1664525 + 1013904223;
+			center.y = (float)(random >> 8) / (float)(1 << 24) * 1000.0f - 500.0f;
+			random = random * 1664525 + 1013904223;
+			center.z = (float)(random >> 8) / (float)(1 << 24) * 1000.0f - 500.0f;
+			extents = XMFLOAT3(1.0f, 2.0f, 0.5f);
+
+			culler->AddObject(XMMatrixIdentity(), center, extents, 2.3f);
+		}
+		culler->SetFrustum(viewProjectionMatrix);
+
+		repeats = 20000000 / count;
+		if (repeats < 3)
+		{
+			repeats = 3;
+		}
+
+		for (volumeIndex = 0; volumeIndex < 2; volumeIndex++)
+		{
+			// The scalar path on one thread is the reference.
+			culler->Cull(volumes[volumeIndex], CULL_PATH_SCALAR, false);
+			reference.resize(count);
+			for (i = 0; i < count; i++)
+			{
+				reference[i] = culler->IsVisible(i) ? 1 : 0;
+			}
+
+			for (pathIndex = 0; pathIndex < pathCount; pathIndex++)
+			{
+				if (!FrustumCullerClass::IsPathSupported(paths[pathIndex]))
+				{
+					continue;
+				}
+
+				for (parallel = 0; parallel < 2; parallel++)
+				{
+					best = 0.0;
+					for (repeat = 0; repeat < repeats; repeat++)
+					{
+						timer.Start();
+						culler->Cull(volumes[volumeIndex], paths[pathIndex], parallel != 0);
+						elapsed = timer.GetElapsedMilliseconds();
+
+						if (repeat == 0 || elapsed < best)
+						{
+							best = elapsed;
+						}
+					}
+					nanoseconds = best * 1000000.0 / (double)count;
+					statistics = culler->GetStatistics();
+
+					// Fused multiply-adds round a little differently, only objects right on a plane may differ.
+					mismatches = 0;
+					for (i = 0; i < count; i++)
+					{
+						if ((culler->IsVisible(i) ? 1 : 0) != reference[i])
+						{
+							mismatches++;
+						}
+					}
+					if (mismatches > count / 100000)
+					{
+						passed = false;
+					}
+
+					printf("%8d %-6s %-6s %-8s %8.3f ns/object  %8d visible  %d mismatches\n", count, volumeNames[volumeIndex],
+						FrustumCullerClass::GetPathName(paths[pathIndex]), parallel ? "parallel" : "single", nanoseconds, statistics.visible, mismatches);
+					fprintf(file, "%s    { \"count\": %d, \"volume\": \"%s\", \"path\": \"%s\", \"parallel\": %s, \"ns_per_object\": %.4f, \"visible\": %d, \"mismatches\": %d }",
+						firstResult ? "" : ",\n", count, volumeNames[volumeIndex], FrustumCullerClass::GetPathName(paths[pathIndex]),
+						parallel ? "true" : "false", nanoseconds, statistics.visible, mismatches);
+					firstResult = false;
+				}
+			}
+		}
+	}
+
+	fprintf(file, "\n  ]\n}\n");
+	fclose(file);
+
+	culler->Shutdown();
+	delete culler;
+	culler = 0;
+
+	jobSystem->Shutdown();
+	delete jobSystem;
+	jobSystem = 0;
+
+	if (!passed)
+	{
+		printf("A SIMD path found different objects visible than the scalar path.\n");
+	}
+
+	ProfilerClass::Shutdown();
+
+	return passed ? 0 : 1;
+}
+
+/*RunMeshBenchmark imports grid meshes and loads them back. Parsing and writing are done once, as the import only
+runs once per asset. Loading is what happens every time the game starts, it is repeated and the fastest run counts.
+The mesh file was just written so it is in the file cache, like on any start but the very first.*/
+static int RunMeshBenchmark(int argc, char** argv)
+{
+	const char* objFile = "mesh_benchmark.obj";
+	const char* meshFile = "mesh_benchmark.mesh";
+	const int loadRepeats = 5;
+	vector<int> counts;
+	vector<MeshVertexType> vertices;
+	vector<unsigned int> indices;
+	vector<unsigned char> packedVertices;
+	string errors;
+	XMFLOAT3 boundsCenter, boundsExtents;
+	float boundsRadius;
+	HeadlessDeviceClass* device;
+	MeshFileClass mesh;
+	RenderBuffer vertexBuffer, indexBuffer;
+	TimerClass timer;
+	const char* outputFile;
+	int count, countIndex, repeat, i;
+	double parseTime, writeTime, openTime, uploadTime, loadTime, elapsed;
+	long objBytes, meshBytes;
+	bool passed, result, firstResult;
+	FILE* file;
+
+	outputFile = GetArgument(argc, argv, "-output", "mesh.json");
+
+	count = atoi(GetArgument(argc, argv, "-triangles", "0"));
+	if (count > 0)
+	{
+		counts.push_back(count);
+	}
+	else
+	{
+		counts.push_back(100000);
+		counts.push_back(1000000);
+		counts.push_back(4000000);
+	}
+
+	file = fopen(outputFile, "w");
+	if (!file)
+	{
+		printf("Could not open %s\n", outputFile);
+		return 1;
+	}
+
+	// The buffers are created on the headless device, which copies them like a driver would.
+	device = new HeadlessDeviceClass;
+	if (!device)
+	{
+		fclose(file);
+		return 1;
+	}
+	device->Initialize(800, 600, 1000.0f, 0.1f);
+
+	fprintf(file, "{\n  \"units\": \"ms\",\n  \"results\": [\n");
+
+	passed = true;
+	firstResult = true;
+	for (countIndex = 0; countIndex < (int)counts.size(); countIndex++)
+	{
+		result = WriteGridObj(objFile, counts[countIndex]);
+		if (!result)
+		{
+			printf("Could not write %s\n", objFile);
+			passed = false;
+			break;
+		}
+
+		// Import the OBJ file.
+		timer.Start();
+		result = MeshFileClass::ParseObj(objFile, vertices, indices);
+		parseTime = timer.GetElapsedMilliseconds();
+		if (!result)
+		{
+			printf("Could not parse %s\n", objFile);
+			passed = false;
+			break;
+		}
+
+		timer.Start();
+		result = MeshFileClass::WriteMesh(meshFile, MODEL_VERTEX_FORMAT, vertices, indices, vector<MeshLodType>());
+		writeTime = timer.GetElapsedMilliseconds();
+		if (!result)
+		{
+			printf("Could not write %s\n", meshFile);
+			passed = false;
+			break;
+		}
+
+		// Load the mesh file the way the ModelClass does.
+		packedVertices.clear();
+		openTime = 0.0;
+		uploadTime = 0.0;
+		loadTime = 0.0;
+		for (repeat = 0; repeat < loadRepeats; repeat++)
+		{
+			timer.Start();
+			result = mesh.Open(meshFile, MODEL_VERTEX_FORMAT, errors);
+			elapsed = timer.GetElapsedMilliseconds();
+			if (!result)
+			{
+				printf("%sCould not open %s\n", errors.c_str(), meshFile);
+				passed = false;
+				break;
+			}
+			if (repeat == 0 || elapsed < openTime)
+			{
+				openTime = elapsed;
+			}
+
+			timer.Start();
+			device->CreateBuffer(RENDER_VERTEX_BUFFER, RENDER_USAGE_DEFAULT, mesh.GetVertexStride() * mesh.GetVertexCount(), mesh.GetVertices(), vertexBuffer);
+			device->CreateBuffer(RENDER_INDEX_BUFFER, RENDER_USAGE_DEFAULT, mesh.GetIndexSize() * mesh.GetIndexCount(), mesh.GetIndices(), indexBuffer);
+			elapsed = timer.GetElapsedMilliseconds();
+			if (repeat == 0 || elapsed < uploadTime)
+			{
+				uploadTime = elapsed;
+			}
+
+			// The mapped mesh must be exactly what was imported, encoded in the vertex format of the model.
+			if (packedVertices.empty())
+			{
+				mesh.GetBounds(boundsCenter, boundsExtents, boundsRadius);
+				packedVertices.resize((size_t)VertexFormatClass::GetStride(MODEL_VERTEX_FORMAT) * vertices.size());
+				VertexFormatClass::Encode(MODEL_VERTEX_FORMAT, &vertices[0], (int)vertices.size(), boundsCenter, boundsExtents, &packedVertices[0]);
+			}
+			if (mesh.GetVertexCount() != (int)vertices.size() || mesh.GetIndexCount() != (int)indices.size() ||
+				memcmp(mesh.GetVertices(), &packedVertices[0], packedVertices.size()) != 0)
+			{
+				passed = false;
+			}
+			for (i = 0; passed && i < (int)indices.size(); i++)
+			{
+				if (mesh.GetIndexSize() == sizeof(unsigned short) ? ((const unsigned short*)mesh.GetIndices())[i] != indices[i] :
+					((const unsigned int*)mesh.GetIndices())[i] != indices[i])
+				{
+					passed = false;
+				}
+			}
+
+			device->ReleaseBuffer(indexBuffer);
+			device->ReleaseBuffer(vertexBuffer);
+			mesh.Close();
+		}
+		loadTime = openTime + uploadTime;
+
+		objBytes = GetFileSize(objFile);
+		meshBytes = GetFileSize(meshFile);
+
+		printf("%8d triangles %8d vertices  obj %7.1f MB  mesh %7.1f MB  parse %9.2f ms  write %8.2f ms  open %7.3f ms  upload %8.2f ms  load %8.2f ms  %6.1fx\n",
+			(int)indices.size() / 3, (int)vertices.size(), (double)objBytes / 1048576.0, (double)meshBytes / 1048576.0, parseTime, writeTime,
+			openTime, uploadTime, loadTime, parseTime / loadTime);
+		fprintf(file, "%s    { \"triangles\": %d, \"vertices\": %d, \"obj_bytes\": %ld, \"mesh_bytes\": %ld, \"parse_ms\": %.3f, \"write_ms\": %.3f, \"open_ms\": %.4f, \"upload_ms\": %.3f, \"load_ms\": %.3f, \"speedup\": %.2f }",
+			firstResult ? "" : ",\n", (int)indices.size() / 3, (int)vertices.size(), objBytes, meshBytes, parseTime, writeTime, openTime,
+			uploadTime, loadTime, parseTime / loadTime);
+		firstResult = false;
+	}
+
+	fprintf(file, "\n  ]\n}\n");
+	fclose(file);
+
+	remove(objFile);
+	remove(meshFile);
+
+	device->Shutdown();
+	delete device;
+	device = 0;
+
+	if (!passed)
+	{
+		printf("The mesh benchmark failed.\n");
+	}
+
+	ProfilerClass::Shutdown();
+
+	return passed ? 0 : 1;
+}
+
+/*RunVertexCacheReport optimizes a few meshes the way the importer does and reports how much better they use the
+vertex cache afterwards.*/
+static int RunVertexCacheReport(int argc, char** argv)
+{
+	vector<string> names;
+	vector<vector<MeshVertexType> > meshVertices;
+	vector<vector<unsigned int> > meshIndices;
+	vector<MeshVertexType> vertices;
+	vector<unsigned int> indices;
+	vector<XMFLOAT3> trianglesBefore, trianglesAfter;
+	VertexCacheStatisticsType before, after;
+	TimerClass timer;
+	const char* outputFile;
+	const char* inputFile;
+	int triangleCount, meshIndex, i, swapWith, indexSize;
+	unsigned int random, temporary;
+	double cacheTime, fetchTime;
+	bool passed, result, firstResult;
+	FILE* file;
+
+	outputFile = GetArgument(argc, argv, "-output", "vcache.json");
+	inputFile = GetArgument(argc, argv, "-input", 0);
+	triangleCount = atoi(GetArgument(argc, argv, "-triangles", "1000000"));
+
+	// The model of the engine and the file asked for, as the importer reads them.
+	result = MeshFileClass::ParseObj(MODEL_FILE, vertices, indices);
+	if (result)
+	{
+		names.push_back(MODEL_FILE);
+		meshVertices.push_back(vertices);
+		meshIndices.push_back(indices);
+	}
+
+	if (inputFile)
+	{
+		result = MeshFileClass::ParseObj(inputFile, vertices, indices);
+		if (!result)
+		{
+			printf("Could not read %s\n", inputFile);
+			return 1;
+		}
+		names.push_back(inputFile);
+		meshVertices.push_back(vertices);
+		meshIndices.push_back(indices);
+	}
+
+	// A grid in row order and the same grid shuffled, which is about the worst order a mesh can come in.
+	MakeGridMesh(triangleCount, vertices, indices);
+	names.push_back("grid");
+	meshVertices.push_back(vertices);
+	meshIndices.push_back(indices);
+
+	random = 12345;
+	for (i = (int)indices.size() / 3 - 1; i > 0; i--)
+	{
+		random = random * 1664525 + 1013904223;
+		swapWith = (int)((random >> 8) % (unsigned int)(i + 1));
+		temporary = indices[i * 3];
+		indices[i * 3] = indices[swapWith * 3];
+		indices[swapWith * 3] = temporary;
+		temporary = indices[i * 3 + 1];
+		indices[i * 3 + 1] = indices[swapWith * 3 + 1];
+		indices[swapWith * 3 + 1] = temporary;
+		temporary = indices[i * 3 + 2];
+		indices[i * 3 + 2] = indices[swapWith * 3 + 2];
+		indices[swapWith * 3 + 2] = temporary;
+	}
+	names.push_back("shuffled grid");
+	meshVertices.push_back(vertices);
+	meshIndices.push_back(indices);
+
+	file = fopen(outputFile, "w");
+	if (!file)
+	{
+		printf("Could not open %s\n", outputFile);
+		return 1;
+	}
+
+	fprintf(file, "{\n  \"cache_size\": %d,\n  \"results\": [\n", MESH_ANALYZER_CACHE_SIZE);
+	printf("FIFO cache of %d vertices\n", MESH_ANALYZER_CACHE_SIZE);
+
+	passed = true;
+	firstResult = true;
+	for (meshIndex = 0; meshIndex < (int)names.size(); meshIndex++)
+	{
+		vertices = meshVertices[meshIndex];
+		indices = meshIndices[meshIndex];
+		before = MeshOptimizerClass::AnalyzeVertexCache(indices, (int)vertices.size(), MESH_ANALYZER_CACHE_SIZE);
+		GetSortedTriangles(vertices, indices, trianglesBefore);
+
+		timer.Start();
+		MeshOptimizerClass::OptimizeVertexCache(indices, (int)vertices.size());
+		cacheTime = timer.GetElapsedMilliseconds();
+
+		timer.Start();
+		MeshOptimizerClass::OptimizeVertexFetch(vertices, indices);
+		fetchTime = timer.GetElapsedMilliseconds();
+
+		after = MeshOptimizerClass::AnalyzeVertexCache(indices, (int)vertices.size(), MESH_ANALYZER_CACHE_SIZE);
+
+		// Reordering may not lose, add or turn around a single triangle.
+		GetSortedTriangles(vertices, indices, trianglesAfter);
+		if (trianglesBefore.size() != trianglesAfter.size() ||
+			memcmp(&trianglesBefore[0], &trianglesAfter[0], sizeof(XMFLOAT3) * trianglesBefore.size()) != 0)
+		{
+			printf("%s lost triangles while being optimized\n", names[meshIndex].c_str());
+			passed = false;
+		}
+
+		indexSize = (int)vertices.size() < MESH_SHORT_INDEX_LIMIT ? 2 : 4;
+
+		printf("%-24s %8d triangles  ACMR %.3f -> %.3f  ATVR %.3f -> %.3f  cache %8.2f ms  fetch %7.2f ms  indices %d bit %.1f KB\n",
+			names[meshIndex].c_str(), before.triangles, before.acmr, after.acmr, before.atvr, after.atvr, cacheTime, fetchTime,
+			indexSize * 8, (double)indexSize * indices.size() / 1024.0);
+		fprintf(file, "%s    { \"mesh\": \"%s\", \"triangles\": %d, \"vertices\": %d, \"acmr_before\": %.4f, \"acmr_after\": %.4f, \"atvr_before\": %.4f, \"atvr_after\": %.4f, \"cache_ms\": %.3f, \"fetch_ms\": %.3f, \"index_bits\": %d }",
+			firstResult ? "" : ",\n", names[meshIndex].c_str(), before.triangles, after.vertices, before.acmr, after.acmr, before.atvr, after.atvr,
+			cacheTime, fetchTime, indexSize * 8);
+		firstResult = false;
+	}
+
+	fprintf(file, "\n  ]\n}\n");
+	fclose(file);
+
+	ProfilerClass::Shutdown();
+
+	return passed ? 0 : 1;
+}
+
+/*RunVertexFormatReport encodes a few meshes in every vertex format and reports what each format costs in memory and in
+the bandwidth of the vertex shader, and what it loses in precision. The meshes are optimized for the vertex cache
+first, like the importer does, so the fetched bytes are the ones of a real draw.*/
+static int RunVertexFormatReport(int argc, char** argv)
+{
+	const VertexFormatType formats[] = { VERTEX_FORMAT_FLOAT, VERTEX_FORMAT_FLOAT_NORMAL, VERTEX_FORMAT_COMPACT, VERTEX_FORMAT_COMPACT_NORMAL };
+	const int formatCount = sizeof(formats) / sizeof(formats[0]);
+	const int encodeRepeats = 3;
+	vector<string> names;
+	vector<vector<MeshVertexType> > meshVertices;
+	vector<vector<unsigned int> > meshIndices;
+	vector<MeshVertexType> vertices, decoded;
+	vector<unsigned int> indices;
+	vector<unsigned char> packedVertices;
+	VertexCacheStatisticsType statistics;
+	XMFLOAT3 boundsCenter, boundsExtents;
+	TimerClass timer;
+	const char* outputFile;
+	const char* inputFile;
+	int triangleCount, meshIndex, formatIndex, repeat, stride, indexSize, i;
+	long long vertexBytes, indexBytes, floatBytes, fetchBytes;
+	double encodeTime, elapsed, positionError, colorError, normalError, cosine, sine, difference;
+	bool result, firstResult;
+	FILE* file;
+
+	outputFile = GetArgument(argc, argv, "-output", "vformat.json");
+	inputFile = GetArgument(argc, argv, "-input", 0);
+	triangleCount = atoi(GetArgument(argc, argv, "-triangles", "1000000"));
+
+	// The model of the engine, the file asked for and a grid, as the importer reads them.
+	result = MeshFileClass::ParseObj(MODEL_FILE, vertices, indices);
+	if (result)
+	{
+		names.push_back(MODEL_FILE);
+		meshVertices.push_back(vertices);
+		meshIndices.push_back(indices);
+	}
+
+	if (inputFile)
+	{
+		result = MeshFileClass::ParseObj(inputFile, vertices, indices);
+		if (!result)
+		{
+			printf("Could not read %s\n", inputFile);
+			return 1;
+		}
+		names.push_back(inputFile);
+		meshVertices.push_back(vertices);
+		meshIndices.push_back(indices);
+	}
+
+	MakeGridMesh(triangleCount, vertices, indices);
+	names.push_back("grid");
+	meshVertices.push_back(vertices);
+	meshIndices.push_back(indices);
+
+	file = fopen(outputFile, "w");
+	if (!file)
+	{
+		printf("Could not open %s\n", outputFile);
+		return 1;
+	}
+
+	fprintf(file, "{\n  \"cache_size\": %d,\n  \"results\": [\n", MESH_ANALYZER_CACHE_SIZE);
+
+	firstResult = true;
+	for (meshIndex = 0; meshIndex < (int)names.size(); meshIndex++)
+	{
+		vertices = meshVertices[meshIndex];
+		indices = meshIndices[meshIndex];
+		MeshOptimizerClass::OptimizeVertexCache(indices, (int)vertices.size());
+		MeshOptimizerClass::OptimizeVertexFetch(vertices, indices);
+		statistics = MeshOptimizerClass::AnalyzeVertexCache(indices, (int)vertices.size(), MESH_ANALYZER_CACHE_SIZE);
+		GetMeshBounds(vertices, boundsCenter, boundsExtents);
+
+		indexSize = (int)vertices.size() < MESH_SHORT_INDEX_LIMIT ? 2 : 4;
+		indexBytes = (long long)indexSize * indices.size();
+		floatBytes = (long long)VertexFormatClass::GetStride(VERTEX_FORMAT_FLOAT) * vertices.size() + indexBytes;
+
+		printf("%s: %d triangles, %d vertices, %d transformed\n", names[meshIndex].c_str(), statistics.triangles, (int)vertices.size(),
+			statistics.transformedVertices);
+
+		for (formatIndex = 0; formatIndex < formatCount; formatIndex++)
+		{
+			stride = VertexFormatClass::GetStride(formats[formatIndex]);
+			vertexBytes = (long long)stride * vertices.size();
+			fetchBytes = (long long)stride * statistics.transformedVertices;
+
+			// Encoding is part of every import, the fastest run counts.
+			packedVertices.resize((size_t)vertexBytes);
+			encodeTime = 0.0;
+			for (repeat = 0; repeat < encodeRepeats; repeat++)
+			{
+				timer.Start();
+				VertexFormatClass::Encode(formats[formatIndex], &vertices[0], (int)vertices.size(), boundsCenter, boundsExtents, &packedVertices[0]);
+				elapsed = timer.GetElapsedMilliseconds();
+				if (repeat == 0 || elapsed < encodeTime)
+				{
+					encodeTime = elapsed;
+				}
+			}
+
+			// Decode the vertices again to see how far they moved. The normal error is the angle in degrees.
+			decoded.resize(vertices.size());
+			VertexFormatClass::Decode(formats[formatIndex], &packedVertices[0], (int)vertices.size(), boundsCenter, boundsExtents, &decoded[0]);
+
+			positionError = 0.0;
+			colorError = 0.0;
+			normalError = 0.0;
+			for (i = 0; i < (int)vertices.size(); i++)
+			{
+				difference = max(max(fabs((double)decoded[i].position.x - vertices[i].position.x), fabs((double)decoded[i].position.y - vertices[i].position.y)),
+					fabs((double)decoded[i].position.z - vertices[i].position.z));
+				positionError = max(positionError, difference);
+
+				difference = max(max(fabs((double)decoded[i].color.x - vertices[i].color.x), fabs((double)decoded[i].color.y - vertices[i].color.y)),
+					max(fabs((double)decoded[i].color.z - vertices[i].color.z), fabs((double)decoded[i].color.w - vertices[i].color.w)));
+				colorError = max(colorError, difference);
+
+				if (VertexFormatClass::HasAttribute(formats[formatIndex], VERTEX_ATTRIBUTE_NORMAL))
+				{
+					// The angle from the sine and the cosine, acos alone loses the small angles.
+					cosine = (double)decoded[i].normal.x * vertices[i].normal.x + (double)decoded[i].normal.y * vertices[i].normal.y +
+						(double)decoded[i].normal.z * vertices[i].normal.z;
+					sine = sqrt(pow((double)decoded[i].normal.y * vertices[i].normal.z - (double)decoded[i].normal.z * vertices[i].normal.y, 2.0) +
+						pow((double)decoded[i].normal.z * vertices[i].normal.x - (double)decoded[i].normal.x * vertices[i].normal.z, 2.0) +
+						pow((double)decoded[i].normal.x * vertices[i].normal.y - (double)decoded[i].normal.y * vertices[i].normal.x, 2.0));
+					normalError = max(normalError, atan2(sine, cosine) * 180.0 / 3.14159265358979);
+				}
+			}
+
+			printf("  %-16s %2d bytes  vertices %9.1f KB  indices %9.1f KB  %5.1f%% of float  fetched %9.1f KB  encode %7.2f ms  error position %.6f color %.4f normal %.3f deg\n",
+				formats[formatIndex].name, stride, (double)vertexBytes / 1024.0, (double)indexBytes / 1024.0,
+				100.0 * (double)(vertexBytes + indexBytes) / (double)floatBytes, (double)fetchBytes / 1024.0, encodeTime, positionError, colorError,
+				normalError);
+			fprintf(file, "%s    { \"mesh\": \"%s\", \"format\": \"%s\", \"stride\": %d, \"vertices\": %d, \"triangles\": %d, \"vertex_bytes\": %lld, \"index_bytes\": %lld, \"size_ratio\": %.4f, \"fetch_bytes\": %lld, \"encode_ms\": %.3f, \"position_error\": %.7f, \"color_error\": %.5f, \"normal_error_degrees\": %.4f }",
+				firstResult ? "" : ",\n", names[meshIndex].c_str(), formats[formatIndex].name, stride, (int)vertices.size(), statistics.triangles,
+				vertexBytes, indexBytes, (double)(vertexBytes + indexBytes) / (double)floatBytes, fetchBytes, encodeTime, positionError, colorError,
+				normalError);
+			firstResult = false;
+		}
+	}
+
+	fprintf(file, "\n  ]\n}\n");
+	fclose(file);
+
+	ProfilerClass::Shutdown();
+
+	return 0;
+}
+
+/*RunLodBenchmark builds the levels of detail of a heavy mesh and draws a scene of copies of it with and without them.
+The terrain is a gentle roll with small bumps on top, a square of two units standing up in front of the camera like
+the quad of the engine. The import is done from scratch so its time includes simplifying.*/
+static int RunLodBenchmark(int argc, char** argv)
+{
+	const char* objFile = "lod_benchmark.obj";
+	const char* submitStages[] = { "total", "queue_submit", "queue_execute" };
+	const int submitStageCount = sizeof(submitStages) / sizeof(submitStages[0]);
+	vector<MeshVertexType> vertices, gridVertices;
+	vector<unsigned int> indices, lodIndices;
+	vector<MeshLodType> lods;
+	string meshFile;
+	string errors;
+	MeshFileClass mesh;
+	MeshLodType lod;
+	BenchmarkClass* benchmark;
+	StageStatisticsType statistics;
+	TimerClass timer;
+	const char* outputFile;
+	int triangleCount, objectCount, frameCount, warmupFrames, run, stage, stageIndex, i;
+	float size, u, v;
+	double importTime, simplifyTime, triangles[2], stageTimes[2][submitStageCount];
+	bool result, passed;
+	FILE* file;
+
+	outputFile = GetArgument(argc, argv, "-output", "lod.json");
+	triangleCount = atoi(GetArgument(argc, argv, "-triangles", "200000"));
+	objectCount = atoi(GetArgument(argc, argv, "-objects", "400"));
+	frameCount = atoi(GetArgument(argc, argv, "-frames", "1000"));
+	warmupFrames = atoi(GetArgument(argc, argv, "-warmup", "50"));
+
+	// Stand the grid up in the xy plane and give it its hills and bumps along z.
+	MakeGridMesh(triangleCount, gridVertices, indices);
+	size = 0.0f;
+	for (i = 0; i < (int)gridVertices.size(); i++)
+	{
+		size = max(size, max(gridVertices[i].position.x, gridVertices[i].position.z));
+	}
+
+	vertices = gridVertices;
+	for (i = 0; i < (int)vertices.size(); i++)
+	{
+		u = gridVertices[i].position.x / size;
+		v = gridVertices[i].position.z / size;
+		vertices[i].position = XMFLOAT3(u * 2.0f - 1.0f, v * 2.0f - 1.0f, 0.15f * sinf(u * 6.0f) * cosf(v * 5.0f) + 0.01f * sinf(u * 90.0f) * sinf(v * 80.0f));
+	}
+
+	result = WriteObj(objFile, vertices, indices);
+	if (!result)
+	{
+		printf("Could not write %s\n", objFile);
+		return 1;
+	}
+
+	// Import it the way the model does, from scratch.
+	meshFile = MeshFileClass::GetCacheFileName(objFile);
+	timer.Start();
+	result = MeshFileClass::ImportObj(objFile, meshFile.c_str(), MODEL_VERTEX_FORMAT, errors);
+	importTime = timer.GetElapsedMilliseconds();
+	if (!result)
+	{
+		printf("%s", errors.c_str());
+		remove(objFile);
+		return 1;
+	}
+
+	// Time the simplifier on its own as well.
+	MeshFileClass::ParseObj(objFile, vertices, indices);
+	MeshOptimizerClass::OptimizeVertexCache(indices, (int)vertices.size());
+	timer.Start();
+	MeshSimplifierClass::GenerateLods(vertices, indices, lodIndices, lods);
+	simplifyTime = timer.GetElapsedMilliseconds();
+
+	result = mesh.Open(objFile, MODEL_VERTEX_FORMAT, errors);
+	if (!result)
+	{
+		printf("%sCould not open %s\n", errors.c_str(), meshFile.c_str());
+		remove(objFile);
+		remove(meshFile.c_str());
+		return 1;
+	}
+
+	file = fopen(outputFile, "w");
+	if (!file)
+	{
+		printf("Could not open %s\n", outputFile);
+		mesh.Close();
+		remove(objFile);
+		remove(meshFile.c_str());
+		return 1;
+	}
+
+	printf("%d vertices, import %.2f ms of which simplifying %.2f ms\n", mesh.GetVertexCount(), importTime, simplifyTime);
+	fprintf(file, "{\n  \"vertices\": %d,\n  \"import_ms\": %.3f,\n  \"simplify_ms\": %.3f,\n  \"lods\": [\n", mesh.GetVertexCount(), importTime, simplifyTime);
+	for (i = 0; i < mesh.GetLodCount(); i++)
+	{
+		lod = mesh.GetLod(i);
+		printf("  lod %d  %8d triangles  error %.6f\n", i, lod.indexCount / 3, lod.error);
+		fprintf(file, "    { \"lod\": %d, \"triangles\": %d, \"error\": %.7f }%s\n", i, lod.indexCount / 3, lod.error,
+			i + 1 < mesh.GetLodCount() ? "," : "");
+	}
+	fprintf(file, "  ],\n  \"results\": [\n");
+
+	// A mesh this size has to simplify.
+	passed = mesh.GetLodCount() > 1;
+	mesh.Close();
+
+	// The same scene without and with levels of detail.
+	for (run = 0; run < 2; run++)
+	{
+		benchmark = new BenchmarkClass;
+		if (!benchmark)
+		{
+			passed = false;
+			break;
+		}
+
+		result = benchmark->Initialize(frameCount, warmupFrames, 1, objectCount, objFile, run == 1);
+		if (result)
+		{
+			result = benchmark->Run();
+		}
+		if (!result)
+		{
+			printf("The lod benchmark failed to run.\n");
+			benchmark->Shutdown();
+			delete benchmark;
+			passed = false;
+			break;
+		}
+
+		triangles[run] = benchmark->GetMeanTriangles();
+		for (stage = 0; stage < submitStageCount; stage++)
+		{
+			stageTimes[run][stage] = 0.0;
+			for (stageIndex = 0; stageIndex < BenchmarkClass::GetStageCount(); stageIndex++)
+			{
+				if (strcmp(BenchmarkClass::GetStageName(stageIndex), submitStages[stage]) == 0)
+				{
+					statistics = benchmark->GetStageStatistics(stageIndex);
+					stageTimes[run][stage] = statistics.mean;
+				}
+			}
+		}
+
+		printf("%-8s %.1f of %d objects visible, %12.0f triangles per frame  total %8.4f ms  submit %8.4f ms  execute %8.4f ms\n",
+			run == 1 ? "lod" : "full", benchmark->GetMeanVisibleObjects(), objectCount, triangles[run], stageTimes[run][0], stageTimes[run][1],
+			stageTimes[run][2]);
+		fprintf(file, "%s    { \"lod\": %s, \"objects\": %d, \"visible_mean\": %.2f, \"triangles_mean\": %.1f, \"total_ms\": %.5f, \"queue_submit_ms\": %.5f, \"queue_execute_ms\": %.5f }",
+			run == 0 ? "" : ",\n", run == 1 ? "true" : "false", objectCount, benchmark->GetMeanVisibleObjects(), triangles[run], stageTimes[run][0],
+			stageTimes[run][1], stageTimes[run][2]);
+
+		benchmark->Shutdown();
+		delete benchmark;
+	}
+
+	if (passed)
+	{
+		printf("levels of detail draw %.1f%% of the triangles\n", 100.0 * triangles[1] / max(triangles[0], 1.0));
+	}
+
+	fprintf(file, "\n  ]\n}\n");
+	fclose(file);
+
+	remove(objFile);
+	remove(meshFile.c_str());
+
+	if (!passed)
+	{
+		printf("The lod benchmark failed.\n");
+	}
+
+	ProfilerClass::Shutdown();
+
+	return passed ? 0 : 1;
+}
+
+/*RunTextureBenchmark times the texture importer and the loader on a TGA file, see the texture suite above.*/
+static int RunTextureBenchmark(int argc, char** argv)
+{
+	const char* rleFile = "texture_benchmark.tga";
+	const char* textureFile = "texture_benchmark.texture";
+	const RenderFormat formats[3] = { RENDER_FORMAT_BC1_UNORM, RENDER_FORMAT_BC3_UNORM, RENDER_FORMAT_BC7_UNORM };
+	const char* formatNames[3] = { "bc1", "bc3", "bc7" };
+	const TextureQuality qualities[3] = { TEXTURE_QUALITY_FAST, TEXTURE_QUALITY_NORMAL, TEXTURE_QUALITY_HIGH };
+	const char* qualityNames[3] = { "fast", "normal", "high" };
+	vector<unsigned char> texels, rleTexels, chain, referenceChain, blocks, parallelBlocks, decoded;
+	vector<TextureMipType> mips;
+	string errors;
+	HeadlessDeviceClass* device;
+	JobSystemClass* jobSystem;
+	RenderFormat compressedFormat;
+	TextureClass texture;
+	TextureFileClass loadedFile;
+	TimerClass timer;
+	const char* inputFile;
+	const char* outputFile;
+	int width, height, rleWidth, rleHeight, repeats, repeat, level, formatIndex, qualityIndex, compressRepeats, threadCount;
+	double decodeTime, rleDecodeTime, mipTime, referenceMipTime, importTime, loadTime, elapsed, megabytes, compressedImportTime, compressedLoadTime;
+	double compressTime[3][3], parallelCompressTime[3][3], psnr[3][3], alphaPsnr[3][3];
+	long tgaBytes, rleBytes, textureBytes, compressedTextureBytes, compressedBytes[3];
+	size_t blockBytes;
+	bool passed, result;
+	FILE* file;
+
+	inputFile = GetArgument(argc, argv, "-input", "../resources/stone01.tga");
+	outputFile = GetArgument(argc, argv, "-output", "texture.json");
+	repeats = atoi(GetArgument(argc, argv, "-repeats", "20"));
+	if (repeats < 1)
+	{
+		repeats = 1;
+	}
+
+	// Decode the file as it is, mapping it every time like the importer does.
+	decodeTime = 0.0;
+	for (repeat = 0; repeat < repeats; repeat++)
+	{
+		timer.Start();
+		result = TextureFileClass::ReadTga(inputFile, texels, width, height);
+		elapsed = timer.GetElapsedMilliseconds();
+		if (!result)
+		{
+			printf("Could not read %s\n", inputFile);
+			return 1;
+		}
+		if (repeat == 0 || elapsed < decodeTime)
+		{
+			decodeTime = elapsed;
+		}
+	}
+	megabytes = (double)texels.size() / 1048576.0;
+
+	passed = true;
+
+	// The same texels run length encoded must decode to the same thing.
+	result = WriteRleTga(rleFile, texels, width, height);
+	if (!result)
+	{
+		printf("Could not write %s\n", rleFile);
+		return 1;
+	}
+
+	rleDecodeTime = 0.0;
+	for (repeat = 0; repeat < repeats; repeat++)
+	{
+		timer.Start();
+		result = TextureFileClass::ReadTga(rleFile, rleTexels, rleWidth, rleHeight);
+		elapsed = timer.GetElapsedMilliseconds();
+		if (!result)
+		{
+			printf("Could not read %s\n", rleFile);
+			passed = false;
+			break;
+		}
+		if (repeat == 0 || elapsed < rleDecodeTime)
+		{
+			rleDecodeTime = elapsed;
+		}
+	}
+	if (!result || rleWidth != width || rleHeight != height || rleTexels != texels)
+	{
+		printf("The run length encoded file decoded to different texels.\n");
+		passed = false;
+	}
+
+	// Build the mip chain with the SIMD filter, the copy of the top level is not timed.
+	mipTime = 0.0;
+	for (repeat = 0; repeat < repeats; repeat++)
+	{
+		chain.reserve(texels.size() * 2);
+		chain.assign(texels.begin(), texels.end());
+
+		timer.Start();
+		TextureFileClass::GenerateMips(chain, width, height, mips);
+		elapsed = timer.GetElapsedMilliseconds();
+		if (repeat == 0 || elapsed < mipTime)
+		{
+			mipTime = elapsed;
+		}
+	}
+
+	// And with the scalar one into the same layout, which must give the same levels.
+	referenceMipTime = 0.0;
+	referenceChain.assign(chain.size(), 0);
+	for (repeat = 0; repeat < repeats; repeat++)
+	{
+		memcpy(&referenceChain[0], &texels[0], texels.size());
+
+		timer.Start();
+		for (level = 1; level < (int)mips.size(); level++)
+		{
+			DownsampleReference(&referenceChain[(size_t)mips[level - 1].offset], (int)mips[level - 1].width, (int)mips[level - 1].height,
+				&referenceChain[(size_t)mips[level].offset]);
+		}
+		elapsed = timer.GetElapsedMilliseconds();
+		if (repeat == 0 || elapsed < referenceMipTime)
+		{
+			referenceMipTime = elapsed;
+		}
+	}
+	for (level = 1; level < (int)mips.size(); level++)
+	{
+		if (memcmp(&chain[(size_t)mips[level].offset], &referenceChain[(size_t)mips[level].offset], mips[level].size) != 0)
+		{
+			printf("Mip level %d of the SIMD filter differs from the scalar one.\n", level);
+			passed = false;
+		}
+	}
+
+	// Import the file into a texture file once, then load that the way the engine does.
+	remove(textureFile);
+	timer.Start();
+	result = TextureFileClass::ImportTga(inputFile, textureFile, TEXTURE_PRESET_UNCOMPRESSED, NULL, errors);
+	importTime = timer.GetElapsedMilliseconds();
+	if (!result)
+	{
+		printf("%s", errors.c_str());
+		return 1;
+	}
+
+	device = new HeadlessDeviceClass;
+	if (!device)
+	{
+		return 1;
+	}
+	device->Initialize(800, 600, 1000.0f, 0.1f);
+
+	loadTime = 0.0;
+	for (repeat = 0; repeat < repeats; repeat++)
+	{
+		timer.Start();
+		result = texture.Initialize(device, textureFile, TEXTURE_PRESET_UNCOMPRESSED, NULL, errors);
+		elapsed = timer.GetElapsedMilliseconds();
+		if (!result)
+		{
+			printf("%sCould not load %s\n", errors.c_str(), textureFile);
+			passed = false;
+			break;
+		}
+		if (repeat == 0 || elapsed < loadTime)
+		{
+			loadTime = elapsed;
+		}
+		texture.Shutdown();
+	}
+
+	// The texture file must hold exactly the mip chain built above.
+	result = loadedFile.Open(textureFile, TEXTURE_PRESET_UNCOMPRESSED, NULL, errors);
+	if (!result || loadedFile.GetMipCount() != (int)mips.size() || loadedFile.GetFormat() != RENDER_FORMAT_R8G8B8A8_UNORM)
+	{
+		printf("The texture file does not match the mip chain.\n");
+		passed = false;
+	}
+	for (level = 0; result && level < loadedFile.GetMipCount(); level++)
+	{
+		if (loadedFile.GetMip(level).size != mips[level].size ||
+			memcmp(loadedFile.GetMipData(level), &chain[(size_t)mips[level].offset], mips[level].size) != 0)
+		{
+			printf("Mip level %d of the texture file does not match the mip chain.\n", level);
+			passed = false;
+		}
+	}
+	loadedFile.Close();
+
+	tgaBytes = GetFileSize(inputFile);
+	rleBytes = GetFileSize(rleFile);
+	textureBytes = GetFileSize(textureFile);
+
+	// Compress the top level in every format with every preset, on this thread and on the job system.
+	jobSystem = new JobSystemClass;
+	if (!jobSystem)
+	{
+		return 1;
+	}
+	threadCount = (int)thread::hardware_concurrency() - 1;
+	jobSystem->Initialize(threadCount > 0 ? threadCount : 0);
+
+	// Small textures are padded to whole blocks, which can take more bytes than the texels.
+	blockBytes = (size_t)TextureCompressorClass::GetRowPitch(RENDER_FORMAT_BC7_UNORM, width) * TextureCompressorClass::GetRowCount(RENDER_FORMAT_BC7_UNORM, height);
+	blocks.resize(blockBytes > texels.size() ? blockBytes : texels.size());
+	parallelBlocks.resize(blocks.size());
+	decoded.resize(texels.size());
+	compressRepeats = repeats < 3 ? repeats : 3;
+	for (formatIndex = 0; formatIndex < 3; formatIndex++)
+	{
+		for (qualityIndex = 0; qualityIndex < 3; qualityIndex++)
+		{
+			compressTime[formatIndex][qualityIndex] = 0.0;
+			parallelCompressTime[formatIndex][qualityIndex] = 0.0;
+			for (repeat = 0; repeat < compressRepeats; repeat++)
+			{
+				timer.Start();
+				TextureCompressorClass::Compress(&texels[0], width, height, formats[formatIndex], qualities[qualityIndex], NULL, &blocks[0]);
+				elapsed = timer.GetElapsedMilliseconds();
+				if (repeat == 0 || elapsed < compressTime[formatIndex][qualityIndex])
+				{
+					compressTime[formatIndex][qualityIndex] = elapsed;
+				}
+
+				timer.Start();
+				TextureCompressorClass::Compress(&texels[0], width, height, formats[formatIndex], qualities[qualityIndex], jobSystem, &parallelBlocks[0]);
+				elapsed = timer.GetElapsedMilliseconds();
+				if (repeat == 0 || elapsed < parallelCompressTime[formatIndex][qualityIndex])
+				{
+					parallelCompressTime[formatIndex][qualityIndex] = elapsed;
+				}
+			}
+
+			// Every block is compressed on its own, so the job system must write the same blocks.
+			blockBytes = (size_t)TextureCompressorClass::GetRowPitch(formats[formatIndex], width) * TextureCompressorClass::GetRowCount(formats[formatIndex], height);
+			if (memcmp(&blocks[0], &parallelBlocks[0], blockBytes) != 0)
+			{
+				printf("The job system compressed %s differently.\n", formatNames[formatIndex]);
+				passed = false;
+			}
+
+			TextureCompressorClass::Decompress(&blocks[0], width, height, formats[formatIndex], &decoded[0]);
+			psnr[formatIndex][qualityIndex] = TextureCompressorClass::GetPsnr(&texels[0], &decoded[0], width, height, false);
+			alphaPsnr[formatIndex][qualityIndex] = TextureCompressorClass::GetPsnr(&texels[0], &decoded[0], width, height, true);
+			compressedBytes[formatIndex] = (long)blockBytes;
+
+			// A better preset only ever keeps endpoints that fit the block better.
+			if (qualityIndex > 0 && psnr[formatIndex][qualityIndex] < psnr[formatIndex][qualityIndex - 1] - 0.001)
+			{
+				printf("The %s preset of %s is worse than the %s one.\n", qualityNames[qualityIndex], formatNames[formatIndex], qualityNames[qualityIndex - 1]);
+				passed = false;
+			}
+		}
+	}
+
+	// Import and load the texture with the default preset, compressed on the job system.
+	remove(textureFile);
+	timer.Start();
+	result = TextureFileClass::ImportTga(inputFile, textureFile, TEXTURE_PRESET_DEFAULT, jobSystem, errors);
+	compressedImportTime = timer.GetElapsedMilliseconds();
+	if (!result)
+	{
+		printf("%s", errors.c_str());
+		passed = false;
+	}
+
+	compressedLoadTime = 0.0;
+	compressedFormat = RENDER_FORMAT_UNKNOWN;
+	for (repeat = 0; result && repeat < repeats; repeat++)
+	{
+		timer.Start();
+		result = texture.Initialize(device, textureFile, TEXTURE_PRESET_DEFAULT, jobSystem, errors);
+		elapsed = timer.GetElapsedMilliseconds();
+		if (!result)
+		{
+			printf("%sCould not load %s\n", errors.c_str(), textureFile);
+			passed = false;
+			break;
+		}
+		if (repeat == 0 || elapsed < compressedLoadTime)
+		{
+			compressedLoadTime = elapsed;
+		}
+		compressedFormat = texture.GetFormat();
+		texture.Shutdown();
+	}
+	compressedTextureBytes = GetFileSize(textureFile);
+
+	jobSystem->Shutdown();
+	delete jobSystem;
+	jobSystem = 0;
+
+	printf("%s  %dx%d  %d mip levels  tga %.2f MB  rle %.2f MB  texture %.2f MB\n", inputFile, width, height, (int)mips.size(),
+		(double)tgaBytes / 1048576.0, (double)rleBytes / 1048576.0, (double)textureBytes / 1048576.0);
+	printf("decode         %8.3f ms  %8.1f MB/s\n", decodeTime, megabytes / (decodeTime / 1000.0));
+	printf("decode rle     %8.3f ms  %8.1f MB/s\n", rleDecodeTime, megabytes / (rleDecodeTime / 1000.0));
+	printf("mips simd      %8.3f ms  %8.1f MB/s\n", mipTime, megabytes / (mipTime / 1000.0));
+	printf("mips scalar    %8.3f ms  %8.1f MB/s  %.1fx slower\n", referenceMipTime, megabytes / (referenceMipTime / 1000.0), referenceMipTime / mipTime);
+	printf("import         %8.3f ms\n", importTime);
+	printf("load           %8.3f ms  %.1fx faster than importing\n", loadTime, importTime / loadTime);
+	for (formatIndex = 0; formatIndex < 3; formatIndex++)
+	{
+		for (qualityIndex = 0; qualityIndex < 3; qualityIndex++)
+		{
+			printf("%s %-6s  %4.1f:1  1 thread %9.2f ms %7.1f MB/s  %2d threads %8.2f ms %7.1f MB/s  psnr rgb %6.2f dB  rgba %6.2f dB\n",
+				formatNames[formatIndex], qualityNames[qualityIndex], (double)texels.size() / compressedBytes[formatIndex], compressTime[formatIndex][qualityIndex],
+				megabytes / (compressTime[formatIndex][qualityIndex] / 1000.0), threadCount + 1, parallelCompressTime[formatIndex][qualityIndex],
+				megabytes / (parallelCompressTime[formatIndex][qualityIndex] / 1000.0), psnr[formatIndex][qualityIndex], alphaPsnr[formatIndex][qualityIndex]);
+		}
+	}
+	printf("default preset %s  texture %.2f MB  import %.3f ms  load %.3f ms\n", compressedFormat == RENDER_FORMAT_BC1_UNORM ? "bc1" :
+		(compressedFormat == RENDER_FORMAT_BC3_UNORM ? "bc3" : (compressedFormat == RENDER_FORMAT_BC7_UNORM ? "bc7" : "rgba")),
+		(double)compressedTextureBytes / 1048576.0, compressedImportTime, compressedLoadTime);
+
+	file = fopen(outputFile, "w");
+	if (file)
+	{
+		fprintf(file, "{\n  \"units\": \"ms\",\n  \"input\": \"%s\",\n  \"width\": %d,\n  \"height\": %d,\n  \"mip_levels\": %d,\n", inputFile, width,
+			height, (int)mips.size());
+		fprintf(file, "  \"tga_bytes\": %ld,\n  \"rle_bytes\": %ld,\n  \"texture_bytes\": %ld,\n", tgaBytes, rleBytes, textureBytes);
+		fprintf(file, "  \"decode_ms\": %.4f,\n  \"decode_mb_per_s\": %.1f,\n", decodeTime, megabytes / (decodeTime / 1000.0));
+		fprintf(file, "  \"decode_rle_ms\": %.4f,\n  \"decode_rle_mb_per_s\": %.1f,\n", rleDecodeTime, megabytes / (rleDecodeTime / 1000.0));
+		fprintf(file, "  \"mips_ms\": %.4f,\n  \"mips_mb_per_s\": %.1f,\n", mipTime, megabytes / (mipTime / 1000.0));
+		fprintf(file, "  \"mips_scalar_ms\": %.4f,\n  \"mips_scalar_mb_per_s\": %.1f,\n", referenceMipTime, megabytes / (referenceMipTime / 1000.0));
+		fprintf(file, "  \"import_ms\": %.4f,\n  \"load_ms\": %.4f,\n", importTime, loadTime);
+		fprintf(file, "  \"compressed_texture_bytes\": %ld,\n  \"compressed_import_ms\": %.4f,\n  \"compressed_load_ms\": %.4f,\n", compressedTextureBytes,
+			compressedImportTime, compressedLoadTime);
+		fprintf(file, "  \"compression\": [\n");
+		for (formatIndex = 0; formatIndex < 3; formatIndex++)
+		{
+			for (qualityIndex = 0; qualityIndex < 3; qualityIndex++)
+			{
+				fprintf(file, "%s    { \"format\": \"%s\", \"preset\": \"%s\", \"bytes\": %ld, \"compress_ms\": %.3f, \"compress_threads\": %d, \"compress_parallel_ms\": %.3f, \"psnr_rgb\": %.3f, \"psnr_rgba\": %.3f }",
+					formatIndex == 0 && qualityIndex == 0 ? "" : ",\n", formatNames[formatIndex], qualityNames[qualityIndex], compressedBytes[formatIndex],
+					compressTime[formatIndex][qualityIndex], threadCount + 1, parallelCompressTime[formatIndex][qualityIndex], psnr[formatIndex][qualityIndex],
+					alphaPsnr[formatIndex][qualityIndex]);
+			}
+		}
+		fprintf(file, "\n  ]\n}\n");
+		fclose(file);
+	}
+	else
+	{
+		printf("Could not open %s\n", outputFile);
+		passed = false;
+	}
+
+	remove(rleFile);
+	remove(textureFile);
+
+	device->Shutdown();
+	delete device;
+	device = 0;
+
+	if (!passed)
+	{
+		printf("The texture benchmark failed.\n");
+	}
+
+	ProfilerClass::Shutdown();
+
+	return passed ? 0 : 1;
+}
+
+/*RunShaderBenchmark times starting the color shader with an empty and with a full shader cache, see the shader suite
+above.*/
+static int RunShaderBenchmark(int argc, char** argv)
+{
+	const char* testFile = "shader_benchmark.hlsl";
+	const char* includeFile = "shader_benchmark_include.hlsl";
+	const char* fixtureFile = "shader_benchmark.reflection";
+	const char* descriptionFile = "../Tutorial2.0/color.permutations";
+	const char* names[3] = { "ColorVertexShader", "ColorVertexShader INSTANCED", "ColorPixelShader" };
+	const VertexFormatType formats[] = { VERTEX_FORMAT_FLOAT, VERTEX_FORMAT_FLOAT_NORMAL, VERTEX_FORMAT_COMPACT, VERTEX_FORMAT_COMPACT_NORMAL };
+	const int formatCount = sizeof(formats) / sizeof(formats[0]);
+	ShaderDescriptionType description;
+	wstring filenames[3];
+	const char* entryPoints[3];
+	const char* profiles[3];
+	vector<RenderShaderDefine> defines[3];
+	vector<char> bytecode, compiledBytecode;
+	vector<unsigned long long> testKeys;
+	RenderShaderReflection reflection, compiledReflection, tintReflection, pixelReflection;
+	vector<RenderInputElement> layout;
+	ShaderParameterType parameter;
+	HeadlessDeviceClass* device;
+	ShaderCacheClass* shaderCache;
+	ShaderArchiveClass* shaderArchive;
+	ColorShaderClass* colorShader;
+	int stages[3];
+	unsigned int masks[3];
+	ShaderCacheStatisticsType coldStatistics, warmStatistics, statistics;
+	TimerClass timer;
+	const char* cacheDirectory;
+	const char* outputFile;
+	string errors;
+	unsigned long long key, otherKey;
+	double coldTime, warmTime, elapsed;
+	int repeats, repeat, shader, hits, layoutFormat, shaderFormat;
+	size_t i, j;
+	bool passed, result, expected;
+	FILE* file;
+
+	cacheDirectory = GetArgument(argc, argv, "-cache", "shader_benchmark_cache");
+	outputFile = GetArgument(argc, argv, "-output", "shader.json");
+	repeats = atoi(GetArgument(argc, argv, "-repeats", "20"));
+	if (repeats < 1)
+	{
+		repeats = 1;
+	}
+
+	device = new HeadlessDeviceClass;
+	if (!device)
+	{
+		return 1;
+	}
+	device->Initialize(800, 600, 1000.0f, 0.1f);
+
+	shaderCache = new ShaderCacheClass;
+	if (!shaderCache)
+	{
+		return 1;
+	}
+	shaderCache->Initialize(device, cacheDirectory);
+
+	// There is no archive, so every shader goes through the cache.
+	shaderArchive = new ShaderArchiveClass;
+	if (!shaderArchive)
+	{
+		return 1;
+	}
+	result = shaderArchive->Initialize(device, shaderCache, descriptionFile, "shader_benchmark.shaderarchive", errors);
+	if (!result || !ShaderArchiveClass::ReadDescription(descriptionFile, description, errors))
+	{
+		printf("%sCould not read %s\n", errors.c_str(), descriptionFile);
+		return 1;
+	}
+
+	colorShader = new ColorShaderClass;
+	if (!colorShader)
+	{
+		return 1;
+	}
+
+	passed = true;
+
+	// The color shader starts with the vertex shader of the model's vertex format, its instanced variant and the pixel shader.
+	stages[0] = shaderArchive->GetStage("vertex");
+	stages[1] = stages[0];
+	stages[2] = shaderArchive->GetStage("pixel");
+	masks[0] = GetVertexFormatMask(shaderArchive, MODEL_VERTEX_FORMAT);
+	masks[1] = masks[0] | shaderArchive->GetOption("INSTANCED");
+	masks[2] = masks[0];
+	for (shader = 0; shader < 3; shader++)
+	{
+		shaderArchive->GetShaderFilename(stages[shader], filenames[shader]);
+		shaderArchive->GetShaderDefines(stages[shader], masks[shader], defines[shader]);
+		entryPoints[shader] = description.stages[stages[shader]].entryPoint.c_str();
+		profiles[shader] = description.stages[stages[shader]].profile.c_str();
+	}
+
+	// Start the color shader with none of its shaders in the cache, they all have to be compiled.
+	coldTime = 0.0;
+	for (repeat = 0; repeat < repeats && passed; repeat++)
+	{
+		for (shader = 0; shader < 3; shader++)
+		{
+			shaderCache->GetKey(filenames[shader].c_str(), entryPoints[shader], profiles[shader], &defines[shader][0], key);
+			remove(shaderCache->GetCacheFileName(key).c_str());
+		}
+
+		timer.Start();
+		result = colorShader->Initialize(device, shaderArchive, NULL, MODEL_VERTEX_FORMAT);
+		elapsed = timer.GetElapsedMilliseconds();
+		colorShader->Shutdown();
+		if (!result)
+		{
+			printf("Could not initialize the color shader.\n");
+			passed = false;
+		}
+		if (repeat == 0 || elapsed < coldTime)
+		{
+			coldTime = elapsed;
+		}
+	}
+	coldStatistics = shaderCache->GetStatistics();
+
+	// Start it again with everything cached, nothing may be compiled.
+	warmTime = 0.0;
+	for (repeat = 0; repeat < repeats && passed; repeat++)
+	{
+		timer.Start();
+		result = colorShader->Initialize(device, shaderArchive, NULL, MODEL_VERTEX_FORMAT);
+		elapsed = timer.GetElapsedMilliseconds();
+		colorShader->Shutdown();
+		if (!result)
+		{
+			printf("Could not initialize the color shader.\n");
+			passed = false;
+		}
+		if (repeat == 0 || elapsed < warmTime)
+		{
+			warmTime = elapsed;
+		}
+	}
+	warmStatistics = shaderCache->GetStatistics();
+	warmStatistics.hits -= coldStatistics.hits;
+	warmStatistics.misses -= coldStatistics.misses;
+	warmStatistics.loadMilliseconds -= coldStatistics.loadMilliseconds;
+	warmStatistics.compileMilliseconds -= coldStatistics.compileMilliseconds;
+
+	if (passed && (coldStatistics.hits != 0 || coldStatistics.misses != 3 * repeats || warmStatistics.hits != 3 * repeats || warmStatistics.misses != 0))
+	{
+		printf("Expected %d misses and then %d hits, got %d and %d misses and then %d and %d hits.\n", 3 * repeats, 3 * repeats, coldStatistics.misses,
+			warmStatistics.misses, coldStatistics.hits, warmStatistics.hits);
+		passed = false;
+	}
+
+	// What comes out of the cache must be exactly what the compiler makes.
+	for (shader = 0; shader < 3 && passed; shader++)
+	{
+		shaderCache->GetShader(filenames[shader].c_str(), entryPoints[shader], profiles[shader], &defines[shader][0], bytecode, reflection, errors);
+		device->CompileShader(filenames[shader].c_str(), entryPoints[shader], profiles[shader], &defines[shader][0], compiledBytecode, errors);
+		device->ReflectShader(&compiledBytecode[0], compiledBytecode.size(), compiledReflection);
+		if (bytecode != compiledBytecode || !IsSameReflection(reflection, compiledReflection))
+		{
+			printf("The cached %s is not the compiled one.\n", names[shader]);
+			passed = false;
+		}
+
+		printf("%-28s %s  %6d bytes\n", names[shader], profiles[shader], (int)bytecode.size());
+		for (i = 0; i < reflection.constantBuffers.size(); i++)
+		{
+			printf("  cbuffer %-12s b%u  %3u bytes ", reflection.constantBuffers[i].name.c_str(), reflection.constantBuffers[i].slot, reflection.constantBuffers[i].size);
+			for (j = 0; j < reflection.constantBuffers[i].variables.size(); j++)
+			{
+				printf(" %s@%u", reflection.constantBuffers[i].variables[j].name.c_str(), reflection.constantBuffers[i].variables[j].offset);
+			}
+			printf("\n");
+		}
+		for (i = 0; i < reflection.inputs.size(); i++)
+		{
+			printf("  input   %s%u  %u components\n", reflection.inputs[i].semanticName.c_str(), reflection.inputs[i].semanticIndex,
+				reflection.inputs[i].componentCount);
+		}
+	}
+
+	// The key has to change with the defines, and a changed include has to be compiled again.
+	shaderCache->GetKey(filenames[0].c_str(), entryPoints[0], profiles[0], &defines[0][0], key);
+	shaderCache->GetKey(filenames[1].c_str(), entryPoints[1], profiles[1], &defines[1][0], otherKey);
+	if (key == otherKey)
+	{
+		printf("The key doesn't change with the defines.\n");
+		passed = false;
+	}
+
+	hits = shaderCache->GetStatistics().hits;
+	for (repeat = 0; repeat < 3 && passed; repeat++)
+	{
+		file = fopen(includeFile, "w");
+		if (file)
+		{
+			fprintf(file, repeat < 2 ? "cbuffer TintBuffer\n{\n\tfloat4 tint;\n};\n" : "cbuffer TintBuffer\n{\n\tfloat3 tint;\n\tfloat strength;\n};\n");
+			fclose(file);
+		}
+		file = fopen(testFile, "w");
+		if (file)
+		{
+			fprintf(file, "#include \"%s\"\n\nfloat4 TintPixelShader(float4 color : COLOR) : SV_TARGET\n{\n\treturn color * tint.x;\n}\n", includeFile);
+			fclose(file);
+		}
+
+		// What the compiler reports for each TintBuffer, for the headless device.
+		file = fopen(fixtureFile, "w");
+		if (file)
+		{
+			fprintf(file, "shader TintPixelShader ps_5_0\ncbuffer TintBuffer 0 16\n%sinput COLOR 0 4 float\n",
+				repeat < 2 ? "variable tint 0 16\n" : "variable tint 0 12\nvariable strength 12 4\n");
+			fclose(file);
+		}
+
+		// The first run must not find a file of an earlier run of the benchmark.
+		shaderCache->GetKey(L"shader_benchmark.hlsl", "TintPixelShader", "ps_5_0", NULL, key);
+		if (repeat == 0)
+		{
+			remove(shaderCache->GetCacheFileName(key).c_str());
+		}
+		testKeys.push_back(key);
+
+		result = shaderCache->GetShader(L"shader_benchmark.hlsl", "TintPixelShader", "ps_5_0", NULL, bytecode, reflection, errors);
+		if (!result || reflection.constantBuffers.size() != 1 || reflection.constantBuffers[0].variables.size() != (repeat < 2 ? 1 : 2))
+		{
+			printf("Could not compile the include test: %s\n", errors.c_str());
+			passed = false;
+		}
+		if (shaderCache->GetStatistics().hits - hits != (repeat == 1 ? 1 : 0))
+		{
+			printf("The include test was %s on run %d.\n", repeat == 1 ? "compiled again" : "cached", repeat + 1);
+			passed = false;
+		}
+		hits = shaderCache->GetStatistics().hits;
+
+		if (repeat == 0)
+		{
+			tintReflection = reflection;
+		}
+	}
+
+	/*The reflection has to catch what doesn't match: the TintBuffer changed between the first and the last run, a vertex
+	shader that reads a normal can't take the layout of a format without one, and the engine writing a matrix of the
+	wrong size has to be refused. What does match has to pass.*/
+	if (passed && ShaderReflectionClass::ValidateConstantBuffers(tintReflection, reflection, errors))
+	{
+		printf("The changed TintBuffer was not caught.\n");
+		passed = false;
+	}
+
+	shaderArchive->GetShader(stages[2], masks[2], bytecode, pixelReflection, errors);
+	for (shaderFormat = 0; shaderFormat < formatCount && passed; shaderFormat++)
+	{
+		shaderArchive->GetShader(stages[0], GetVertexFormatMask(shaderArchive, formats[shaderFormat]), bytecode, reflection, errors);
+		if (!ShaderReflectionClass::ValidateConstantBuffers(reflection, pixelReflection, errors) ||
+			!ShaderReflectionClass::GetParameter(reflection, "ObjectBuffer", "worldViewProjectionMatrix", 64, parameter, errors))
+		{
+			printf("The %s vertex shader doesn't match the pixel shader or the engine: %s", formats[shaderFormat].name, errors.c_str());
+			passed = false;
+		}
+		if (ShaderReflectionClass::GetParameter(reflection, "ObjectBuffer", "worldViewProjectionMatrix", 48, parameter, errors))
+		{
+			printf("A worldViewProjectionMatrix of the wrong size was not caught.\n");
+			passed = false;
+		}
+
+		for (layoutFormat = 0; layoutFormat < formatCount; layoutFormat++)
+		{
+			VertexFormatClass::GetInputLayout(formats[layoutFormat], layout);
+			expected = VertexFormatClass::HasAttribute(formats[layoutFormat], VERTEX_ATTRIBUTE_NORMAL) ||
+				!VertexFormatClass::HasAttribute(formats[shaderFormat], VERTEX_ATTRIBUTE_NORMAL);
+			if (ShaderReflectionClass::ValidateInputLayout(reflection, &layout[0], (unsigned int)layout.size(), errors) != expected)
+			{
+				printf("The %s layout was %s by the %s vertex shader.\n", formats[layoutFormat].name, expected ? "refused" : "accepted",
+					formats[shaderFormat].name);
+				passed = false;
+			}
+		}
+	}
+	errors.clear();
+
+	for (i = 0; i < testKeys.size(); i++)
+	{
+		remove(shaderCache->GetCacheFileName(testKeys[i]).c_str());
+	}
+	remove(testFile);
+	remove(includeFile);
+	remove(fixtureFile);
+
+	statistics = shaderCache->GetStatistics();
+	printf("cold start  %8.3f ms  %d compiled  %.3f ms compiling on average\n", coldTime, coldStatistics.misses / repeats,
+		coldStatistics.compileMilliseconds / repeats);
+	printf("warm start  %8.3f ms  %d cached    %.3f ms loading on average    %.1fx faster\n", warmTime, warmStatistics.hits / repeats,
+		warmStatistics.loadMilliseconds / repeats, coldTime / warmTime);
+
+	file = fopen(outputFile, "w");
+	if (file)
+	{
+		fprintf(file, "{\n  \"units\": \"ms\",\n  \"compiler\": \"%s\",\n  \"cold_start_ms\": %.4f,\n  \"warm_start_ms\": %.4f,\n", device->GetShaderCompiler(),
+			coldTime, warmTime);
+		fprintf(file, "  \"compile_ms_per_start\": %.4f,\n  \"load_ms_per_start\": %.4f,\n", coldStatistics.compileMilliseconds / repeats,
+			warmStatistics.loadMilliseconds / repeats);
+		fprintf(file, "  \"hits\": %d,\n  \"misses\": %d\n}\n", statistics.hits, statistics.misses);
+		fclose(file);
+	}
+	else
+	{
+		printf("Could not open %s\n", outputFile);
+		passed = false;
+	}
+
+	delete colorShader;
+	colorShader = 0;
+
+	shaderArchive->Shutdown();
+	delete shaderArchive;
+	shaderArchive = 0;
+
+	shaderCache->Shutdown();
+	delete shaderCache;
+	shaderCache = 0;
+
+	device->Shutdown();
+	delete device;
+	device = 0;
+
+	if (!passed)
+	{
+		printf("The shader benchmark failed.\n");
+	}
+
+	ProfilerClass::Shutdown();
+
+	return passed ? 0 : 1;
+}
+
+/*RunPermutationBenchmark builds the shader archive of the color shader on one thread and on the job system, checks
+every variant in it against the compiler and times looking them up and starting the color shader from it.*/
+static int RunPermutationBenchmark(int argc, char** argv)
+{
+	const char* descriptionFile = "../Tutorial2.0/color.permutations";
+	const char* archiveFile = "permutation_benchmark.shaderarchive";
+	const char* parallelArchiveFile = "permutation_benchmark_parallel.shaderarchive";
+	const char* testDescription = "permutation_benchmark.permutations";
+	const char* testSource = "permutation_benchmark.hlsl";
+	const char* testFixture = "permutation_benchmark.reflection";
+	const char* testArchive = "permutation_benchmark_test.shaderarchive";
+	ShaderDescriptionType description;
+	vector<RenderShaderDefine> defines;
+	vector<char> bytecode, compiledBytecode;
+	RenderShaderReflection reflection, compiledReflection;
+	HeadlessDeviceClass* device;
+	JobSystemClass* jobSystem;
+	ShaderCacheClass* shaderCache;
+	ShaderArchiveClass* shaderArchive;
+	ColorShaderClass* colorShader;
+	MappedFileClass archive, parallelArchive;
+	TimerClass timer;
+	const char* outputFile;
+	string errors;
+	wstring filename;
+	double buildTime, parallelBuildTime, lookupTime, startTime, elapsed;
+	int repeats, repeat, threadCount, variantCount, blobCount, stage;
+	unsigned int mask;
+	bool passed, result;
+	FILE* file;
+
+	outputFile = GetArgument(argc, argv, "-output", "permutation.json");
+	repeats = atoi(GetArgument(argc, argv, "-repeats", "20"));
+	if (repeats < 1)
+	{
+		repeats = 1;
+	}
+
+	device = new HeadlessDeviceClass;
+	if (!device)
+	{
+		return 1;
+	}
+	device->Initialize(800, 600, 1000.0f, 0.1f);
+
+	jobSystem = new JobSystemClass;
+	if (!jobSystem)
+	{
+		return 1;
+	}
+	threadCount = (int)thread::hardware_concurrency() - 1;
+	jobSystem->Initialize(threadCount > 0 ? threadCount : 0);
+
+	shaderCache = new ShaderCacheClass;
+	if (!shaderCache)
+	{
+		return 1;
+	}
+	shaderCache->Initialize(device, "permutation_benchmark_cache");
+
+	shaderArchive = new ShaderArchiveClass;
+	if (!shaderArchive)
+	{
+		return 1;
+	}
+
+	colorShader = new ColorShaderClass;
+	if (!colorShader)
+	{
+		return 1;
+	}
+
+	passed = ShaderArchiveClass::ReadDescription(descriptionFile, description, errors);
+	if (!passed)
+	{
+		printf("Could not read %s: %s\n", descriptionFile, errors.c_str());
+	}
+
+	// Build the archive on one thread and on the job system, both must write exactly the same file.
+	buildTime = 0.0;
+	parallelBuildTime = 0.0;
+	for (repeat = 0; repeat < 3 && passed; repeat++)
+	{
+		timer.Start();
+		result = ShaderArchiveClass::Build(device, NULL, descriptionFile, archiveFile, errors);
+		elapsed = timer.GetElapsedMilliseconds();
+		if (repeat == 0 || elapsed < buildTime)
+		{
+			buildTime = elapsed;
+		}
+
+		timer.Start();
+		result = ShaderArchiveClass::Build(device, jobSystem, descriptionFile, parallelArchiveFile, errors) && result;
+		elapsed = timer.GetElapsedMilliseconds();
+		if (repeat == 0 || elapsed < parallelBuildTime)
+		{
+			parallelBuildTime = elapsed;
+		}
+
+		if (!result)
+		{
+			printf("Could not build the shader archive:\n%s", errors.c_str());
+			passed = false;
+		}
+	}
+
+	if (passed)
+	{
+		result = archive.Open(archiveFile) && parallelArchive.Open(parallelArchiveFile);
+		if (!result || archive.GetSize() != parallelArchive.GetSize() || memcmp(archive.GetData(), parallelArchive.GetData(), archive.GetSize()) != 0)
+		{
+			printf("The job system built another archive.\n");
+			passed = false;
+		}
+		archive.Close();
+		parallelArchive.Close();
+	}
+
+	if (passed && !ShaderArchiveClass::IsCurrent(device, descriptionFile, archiveFile))
+	{
+		printf("The archive that was just built is out of date.\n");
+		passed = false;
+	}
+
+	if (passed)
+	{
+		result = shaderArchive->Initialize(device, shaderCache, descriptionFile, archiveFile, errors);
+		if (!result || !shaderArchive->IsArchived())
+		{
+			printf("%sCould not open the shader archive.\n", errors.c_str());
+			passed = false;
+		}
+	}
+
+	// Every valid variant must be exactly what the compiler makes of it, and every other one must not be there.
+	variantCount = 0;
+	for (stage = 0; stage < (int)description.stages.size() && passed; stage++)
+	{
+		shaderArchive->GetShaderFilename(stage, filename);
+		for (mask = 0; mask < (1u << description.options.size()) && passed; mask++)
+		{
+			if ((mask & ~description.stages[stage].optionMask) != 0)
+			{
+				continue;
+			}
+
+			result = shaderArchive->GetShader(stage, mask, bytecode, reflection, errors);
+			if (result != ShaderArchiveClass::IsValidVariant(description, mask))
+			{
+				printf("Variant 0x%03x of the %s stage is %s the archive.\n", mask, description.stages[stage].name.c_str(), result ? "in" : "not in");
+				passed = false;
+			}
+			if (!result)
+			{
+				continue;
+			}
+			variantCount++;
+
+			shaderArchive->GetShaderDefines(stage, mask, defines);
+			device->CompileShader(filename.c_str(), description.stages[stage].entryPoint.c_str(), description.stages[stage].profile.c_str(), &defines[0],
+				compiledBytecode, errors);
+			device->ReflectShader(&compiledBytecode[0], compiledBytecode.size(), compiledReflection);
+			if (bytecode != compiledBytecode || !IsSameReflection(reflection, compiledReflection))
+			{
+				printf("Variant 0x%03x of the %s stage is not the compiled one.\n", mask, description.stages[stage].name.c_str());
+				passed = false;
+			}
+		}
+	}
+
+	// Time getting a variant out of the archive and starting the color shader with it.
+	lookupTime = 0.0;
+	startTime = 0.0;
+	for (repeat = 0; repeat < repeats && passed; repeat++)
+	{
+		timer.Start();
+		for (stage = 0; stage < (int)description.stages.size(); stage++)
+		{
+			for (mask = 0; mask < (1u << description.options.size()); mask++)
+			{
+				if ((mask & ~description.stages[stage].optionMask) == 0)
+				{
+					shaderArchive->GetShader(stage, mask, bytecode, reflection, errors);
+				}
+			}
+		}
+		elapsed = timer.GetElapsedMilliseconds();
+		if (repeat == 0 || elapsed < lookupTime)
+		{
+			lookupTime = elapsed;
+		}
+
+		timer.Start();
+		result = colorShader->Initialize(device, shaderArchive, NULL, MODEL_VERTEX_FORMAT);
+		elapsed = timer.GetElapsedMilliseconds();
+		colorShader->Shutdown();
+		if (!result)
+		{
+			printf("Could not initialize the color shader from the archive.\n");
+			passed = false;
+		}
+		if (repeat == 0 || elapsed < startTime)
+		{
+			startTime = elapsed;
+		}
+	}
+	if (shaderCache->GetStatistics().hits + shaderCache->GetStatistics().misses != 0)
+	{
+		printf("The color shader was compiled while the archive was there.\n");
+		passed = false;
+	}
+	blobCount = shaderArchive->GetBlobCount();
+	shaderArchive->Shutdown();
+
+	// An archive of sources that changed after it was built is not used, the shaders are compiled instead.
+	for (repeat = 0; repeat < 2 && passed; repeat++)
+	{
+		file = fopen(testDescription, "w");
+		if (file)
+		{
+			fprintf(file, "stage pixel %s TintPixelShader ps_5_0\noption TINT pixel\noption BRIGHT pixel\nrequire BRIGHT TINT\n", testSource);
+			fclose(file);
+		}
+		file = fopen(testSource, "w");
+		if (file)
+		{
+			fprintf(file, "float4 TintPixelShader(float4 color : COLOR) : SV_TARGET\n{\n#if TINT\n\tcolor.r = %s;\n#endif\n#if BRIGHT\n\tcolor *= 2.0f;\n#endif\n"
+				"\treturn color;\n}\n", repeat == 0 ? "1.0f" : "0.5f");
+			fclose(file);
+		}
+		file = fopen(testFixture, "w");
+		if (file)
+		{
+			fprintf(file, "shader TintPixelShader ps_5_0\ninput COLOR 0 4 float\n");
+			fclose(file);
+		}
+		if (repeat == 0)
+		{
+			result = ShaderArchiveClass::Build(device, jobSystem, testDescription, testArchive, errors);
+			if (!result || !ShaderArchiveClass::IsCurrent(device, testDescription, testArchive))
+			{
+				printf("Could not build the test archive:\n%s", errors.c_str());
+				passed = false;
+			}
+		}
+
+		result = shaderArchive->Initialize(device, shaderCache, testDescription, testArchive, errors);
+		if (!result || shaderArchive->IsArchived() != (repeat == 0) || shaderArchive->GetShader(0, 2, bytecode, reflection, errors) ||
+			!shaderArchive->GetShader(0, 3, bytecode, reflection, errors))
+		{
+			printf("The test archive was %s after %s.\n", repeat == 0 ? "not used" : "used", repeat == 0 ? "it was built" : "its source changed");
+			passed = false;
+		}
+		shaderArchive->Shutdown();
+	}
+	remove(testDescription);
+	remove(testSource);
+	remove(testFixture);
+	remove(testArchive);
+
+	printf("%d variants of %d stages in %d blobs, %ld bytes\n", variantCount, (int)description.stages.size(), blobCount,
+		GetFileSize(archiveFile));
+	printf("build on 1 thread        %8.3f ms\n", buildTime);
+	printf("build on %2d threads      %8.3f ms  %.1fx faster\n", jobSystem->GetThreadCount() + 1, parallelBuildTime, buildTime / parallelBuildTime);
+	printf("get every variant        %8.3f ms  %.3f us per variant\n", lookupTime, lookupTime * 1000.0 / (variantCount > 0 ? variantCount : 1));
+	printf("start the color shader   %8.3f ms\n", startTime);
+
+	file = fopen(outputFile, "w");
+	if (file)
+	{
+		fprintf(file, "{\n  \"units\": \"ms\",\n  \"compiler\": \"%s\",\n  \"variants\": %d,\n  \"archive_bytes\": %ld,\n", device->GetShaderCompiler(),
+			variantCount, GetFileSize(archiveFile));
+		fprintf(file, "  \"threads\": %d,\n  \"build_ms\": %.4f,\n  \"build_parallel_ms\": %.4f,\n", jobSystem->GetThreadCount() + 1, buildTime, parallelBuildTime);
+		fprintf(file, "  \"lookup_all_ms\": %.4f,\n  \"color_shader_start_ms\": %.4f\n}\n", lookupTime, startTime);
+		fclose(file);
+	}
+	else
+	{
+		printf("Could not open %s\n", outputFile);
+		passed = false;
+	}
+
+	remove(archiveFile);
+	remove(parallelArchiveFile);
+
+	delete colorShader;
+	colorShader = 0;
+
+	delete shaderArchive;
+	shaderArchive = 0;
+
+	shaderCache->Shutdown();
+	delete shaderCache;
+	shaderCache = 0;
+
+	jobSystem->Shutdown();
+	delete jobSystem;
+	jobSystem = 0;
+
+	device->Shutdown();
+	delete device;
+	device = 0;
+
+	if (!passed)
+	{
+		printf("The permutation benchmark failed.\n");
+	}
+
+	ProfilerClass::Shutdown();
+
+	return passed ? 0 : 1;
+}
+
+/*RunReloadBenchmark edits copies of the color shader sources while empty frames run and times how long a change takes
+to reach the frames, see the reload suite above.*/
+static int RunReloadBenchmark(int argc, char** argv)
+{
+	const char* descriptionFile = "../Tutorial2.0/color.permutations";
+	const char* vertexFile = "../Tutorial2.0/color_vs.hlsl";
+	const char* pixelFile = "../Tutorial2.0/color_ps.hlsl";
+	const char* vertexFixture = "../Tutorial2.0/color_vs.reflection";
+	const char* pixelFixture = "../Tutorial2.0/color_ps.reflection";
+	const char* testDescription = "reload_benchmark.permutations";
+	const char* testVertexFile = "reload_benchmark_vs.hlsl";
+	const char* testPixelFile = "reload_benchmark_ps.hlsl";
+	const char* testVertexFixture = "reload_benchmark_vs.reflection";
+	const char* testPixelFixture = "reload_benchmark_ps.reflection";
+	const char* testArchive = "reload_benchmark.shaderarchive";
+	HeadlessDeviceClass* device;
+	ShaderCacheClass* shaderCache;
+	ShaderArchiveClass* shaderArchive;
+	ShaderReloaderClass* shaderReloader;
+	ColorShaderClass* colorShader;
+	ShaderReloadStatisticsType statistics;
+	string description, vertexSource, pixelSource, vertexReflection, pixelReflection;
+	string errors;
+	const char* cacheDirectory;
+	const char* outputFile;
+	double maxSwapTime, latency, totalLatency;
+	size_t position;
+	int interval, edits, edit, frames, swapped, liveObjects;
+	bool passed, result;
+	FILE* file;
+
+	cacheDirectory = GetArgument(argc, argv, "-cache", "reload_benchmark_cache");
+	outputFile = GetArgument(argc, argv, "-output", "reload.json");
+	interval = atoi(GetArgument(argc, argv, "-interval", "250"));
+	edits = atoi(GetArgument(argc, argv, "-edits", "5"));
+	if (edits < 1)
+	{
+		edits = 1;
+	}
+
+	/*The sources are copied so they can be edited, the copy of the description names the copies and the fixtures of the
+	headless device go with them. Nothing else changes, the fog include is only read by variants the color shader
+	doesn't use.*/
+	result = ReadTextFile(descriptionFile, description) && ReadTextFile(vertexFile, vertexSource) && ReadTextFile(pixelFile, pixelSource) &&
+		ReadTextFile(vertexFixture, vertexReflection) && ReadTextFile(pixelFixture, pixelReflection);
+	if (!result)
+	{
+		printf("Could not read the color shader sources.\n");
+		return 1;
+	}
+	position = description.find("color_vs.hlsl");
+	if (position != string::npos)
+	{
+		description.replace(position, strlen("color_vs.hlsl"), testVertexFile);
+	}
+	position = description.find("color_ps.hlsl");
+	if (position != string::npos)
+	{
+		description.replace(position, strlen("color_ps.hlsl"), testPixelFile);
+	}
+	result = WriteTextFile(testDescription, description) && WriteTextFile(testVertexFile, vertexSource) && WriteTextFile(testPixelFile, pixelSource) &&
+		WriteTextFile(testVertexFixture, vertexReflection) && WriteTextFile(testPixelFixture, pixelReflection);
+	if (!result)
+	{
+		printf("Could not write the copies of the color shader sources.\n");
+		return 1;
+	}
+
+	device = new HeadlessDeviceClass;
+	if (!device)
+	{
+		return 1;
+	}
+	device->Initialize(800, 600, 1000.0f, 0.1f);
+	liveObjects = device->GetLiveObjectCount();
+
+	shaderCache = new ShaderCacheClass;
+	if (!shaderCache)
+	{
+		return 1;
+	}
+	shaderCache->Initialize(device, cacheDirectory);
+
+	// Start the color shader the way Graphics does, there is no archive so it is compiled through the cache.
+	shaderArchive = new ShaderArchiveClass;
+	if (!shaderArchive)
+	{
+		return 1;
+	}
+	colorShader = new ColorShaderClass;
+	if (!colorShader)
+	{
+		return 1;
+	}
+	result = shaderArchive->Initialize(device, shaderCache, testDescription, testArchive, errors) &&
+		colorShader->Initialize(device, shaderArchive, NULL, MODEL_VERTEX_FORMAT);
+	shaderArchive->Shutdown();
+	delete shaderArchive;
+	shaderArchive = 0;
+	if (!result)
+	{
+		printf("Could not initialize the color shader.\n");
+		return 1;
+	}
+
+	// Without a description there is nothing to watch, which must not keep the game from starting.
+	shaderReloader = new ShaderReloaderClass;
+	if (!shaderReloader)
+	{
+		return 1;
+	}
+	result = shaderReloader->Initialize(device, shaderCache, "reload_benchmark_missing.permutations", testArchive, MODEL_VERTEX_FORMAT, interval);
+	if (!result || shaderReloader->IsWatching())
+	{
+		printf("The shader reloader did not stay off without a description.\n");
+		return 1;
+	}
+	shaderReloader->Shutdown();
+	delete shaderReloader;
+	shaderReloader = 0;
+
+	shaderReloader = new ShaderReloaderClass;
+	if (!shaderReloader)
+	{
+		return 1;
+	}
+	result = shaderReloader->Initialize(device, shaderCache, testDescription, testArchive, MODEL_VERTEX_FORMAT, interval);
+	if (!result || !shaderReloader->IsWatching())
+	{
+		printf("Could not initialize the shader reloader.\n");
+		return 1;
+	}
+
+	passed = true;
+	frames = 0;
+	maxSwapTime = 0.0;
+	totalLatency = 0.0;
+
+	// Nothing changed yet, so nothing may be reloaded.
+	swapped = WaitForReload(shaderReloader, colorShader, frames, maxSwapTime, latency);
+	if (swapped != 0)
+	{
+		printf("A shader was reloaded without a change.\n");
+		passed = false;
+	}
+
+	/*Every edit changes the pixel shader, which has to reach the frames. After the last one the vertex shader is broken,
+	that must leave the shader alone, and then fixed again, which has to reach the frames again.*/
+	for (edit = 0; edit < edits && passed; edit++)
+	{
+		pixelSource += "// Edited by the reload benchmark.\n";
+		WriteTextFile(testPixelFile, pixelSource);
+
+		swapped = WaitForReload(shaderReloader, colorShader, frames, maxSwapTime, latency);
+		if (swapped != 1)
+		{
+			printf("Edit %d swapped in %d shaders instead of one.\n", edit + 1, swapped);
+			passed = false;
+		}
+		totalLatency += latency;
+	}
+
+	if (passed)
+	{
+		WriteTextFile(testVertexFile, vertexSource + "\n#error broken by the reload benchmark\n");
+		swapped = WaitForReload(shaderReloader, colorShader, frames, maxSwapTime, latency);
+		statistics = shaderReloader->GetStatistics();
+		if (swapped != 0 || statistics.failures != 1)
+		{
+			printf("A shader that doesn't compile was swapped in or not seen, %d swaps and %d failures.\n", swapped, statistics.failures);
+			passed = false;
+		}
+
+		WriteTextFile(testVertexFile, vertexSource);
+		swapped = WaitForReload(shaderReloader, colorShader, frames, maxSwapTime, latency);
+		if (swapped != 1)
+		{
+			printf("The fixed vertex shader was not swapped in.\n");
+			passed = false;
+		}
+	}
+
+	statistics = shaderReloader->GetStatistics();
+	if (passed && statistics.reloads != edits + 1)
+	{
+		printf("Expected %d reloads, got %d.\n", edits + 1, statistics.reloads);
+		passed = false;
+	}
+
+	shaderReloader->Shutdown();
+	delete shaderReloader;
+	shaderReloader = 0;
+
+	colorShader->Shutdown();
+	delete colorShader;
+	colorShader = 0;
+
+	// Every shader that was reloaded and swapped out again has to be released.
+	if (device->GetLiveObjectCount() != liveObjects)
+	{
+		printf("%d objects of the reloaded shaders were not released.\n", device->GetLiveObjectCount() - liveObjects);
+		passed = false;
+	}
+
+	remove(testDescription);
+	remove(testVertexFile);
+	remove(testPixelFile);
+	remove(testVertexFixture);
+	remove(testPixelFixture);
+	remove("shader-error.txt");
+
+	printf("%d edits, %d reloads, %d failed, %d checks in %d frames\n", edits, statistics.reloads, statistics.failures, statistics.checks, frames);
+	printf("edit to frame            %8.3f ms on average\n", totalLatency / edits);
+	printf("last compile             %8.3f ms\n", statistics.lastCompileMilliseconds);
+	printf("longest frame boundary   %8.4f ms\n", maxSwapTime);
+
+	file = fopen(outputFile, "w");
+	if (file)
+	{
+		fprintf(file, "{\n  \"units\": \"ms\",\n  \"compiler\": \"%s\",\n  \"edits\": %d,\n  \"reloads\": %d,\n  \"failures\": %d,\n", device->GetShaderCompiler(),
+			edits, statistics.reloads, statistics.failures);
+		fprintf(file, "  \"edit_to_frame_ms\": %.4f,\n  \"last_compile_ms\": %.4f,\n  \"max_frame_boundary_ms\": %.4f\n}\n", totalLatency / edits,
+			statistics.lastCompileMilliseconds, maxSwapTime);
+		fclose(file);
+	}
+	else
+	{
+		printf("Could not open %s\n", outputFile);
+		passed = false;
+	}
+
+	shaderCache->Shutdown();
+	delete shaderCache;
+	shaderCache = 0;
+
+	device->Shutdown();
+	delete device;
+	device = 0;
+
+	if (!passed)
+	{
+		printf("The reload benchmark failed.\n");
+	}
+
+	ProfilerClass::Shutdown();
+
+	return passed ? 0 : 1;
+}
+
+/*RunRecordBenchmark issues the same sorted render queue with Execute and with ExecuteParallel on more and more threads,
+see the record suite above.*/
+static int RunRecordBenchmark(int argc, char** argv)
+{
+	const int meshCount = 64;
+	const int shaderCount = 8;
+	const int layoutCount = 2;
+	const char bytecode[4] = { 0, 0, 0, 0 };
+	RenderInputElement element;
+	vector<int> counts;
+	vector<unsigned int> reference, draws;
+	vector<RenderBuffer> buffers;
+	RenderVertexShader vertexShaders[shaderCount];
+	RenderPixelShader pixelShaders[shaderCount];
+	RenderInputLayout layouts[layoutCount];
+	RenderCommandType command;
+	HeadlessDeviceClass* device;
+	HeadlessContextClass* context;
+	RenderQueueClass* renderQueue;
+	ConstantAllocatorClass* constantAllocator;
+	ConstantAllocatorClass* fallbackAllocator;
+	JobSystemClass* jobSystem;
+	RenderQueueStatisticsType serialStatistics, statistics;
+	HeadlessStatisticsType contextStatistics;
+	TimerClass timer;
+	const char* outputFile;
+	float* constants;
+	float* fallbackConstants;
+	unsigned int random, frameOffset, frameSize, offset, size, vertices[64];
+	size_t j;
+	int count, countIndex, maxThreads, threads, repeats, repeat, mesh, shader, i;
+	double serialBest, oneThreadBest, best, elapsed;
+	bool passed, firstResult, result, same;
+	FILE* file;
+
+	outputFile = GetArgument(argc, argv, "-output", "record.json");
+	repeats = atoi(GetArgument(argc, argv, "-repeats", "10"));
+	if (repeats < 1)
+	{
+		repeats = 1;
+	}
+
+	// Every core, but at least two threads so the command lists are checked on any machine.
+	maxThreads = atoi(GetArgument(argc, argv, "-threads", "0"));
+	if (maxThreads < 1)
+	{
+		maxThreads = (int)thread::hardware_concurrency();
+		if (maxThreads < 2)
+		{
+			maxThreads = 2;
+		}
+	}
+
+	count = atoi(GetArgument(argc, argv, "-draws", "0"));
+	if (count > 0)
+	{
+		counts.push_back(count);
+	}
+	else
+	{
+		counts.push_back(10000);
+		counts.push_back(30000);
+		counts.push_back(100000);
+	}
+
+	file = fopen(outputFile, "w");
+	if (!file)
+	{
+		printf("Could not open %s\n", outputFile);
+		return 1;
+	}
+
+	device = new HeadlessDeviceClass;
+	if (!device)
+	{
+		fclose(file);
+		return 1;
+	}
+	device->Initialize(800, 600, 1000.0f, 0.1f);
+	context = device->GetHeadlessContext();
+
+	// A few shaders and layouts and a vertex and an index buffer for every mesh, the headless device doesn't look at
+	// the bytecode.
+	memset(&element, 0, sizeof(element));
+	element.SemanticName = "POSITION";
+	element.Format = RENDER_FORMAT_R32G32B32_FLOAT;
+	memset(vertices, 0, sizeof(vertices));
+	result = true;
+	for (shader = 0; shader < shaderCount; shader++)
+	{
+		result = device->CreateVertexShader(bytecode, sizeof(bytecode), vertexShaders[shader]) && result;
+		result = device->CreatePixelShader(bytecode, sizeof(bytecode), pixelShaders[shader]) && result;
+	}
+	for (i = 0; i < layoutCount; i++)
+	{
+		result = device->CreateInputLayout(&element, 1, bytecode, sizeof(bytecode), layouts[i]) && result;
+	}
+	buffers.resize(meshCount * 2);
+	for (mesh = 0; mesh < meshCount; mesh++)
+	{
+		result = device->CreateBuffer(RENDER_VERTEX_BUFFER, RENDER_USAGE_DEFAULT, sizeof(vertices), vertices, buffers[mesh * 2]) && result;
+		result = device->CreateBuffer(RENDER_INDEX_BUFFER, RENDER_USAGE_DEFAULT, sizeof(vertices), vertices, buffers[mesh * 2 + 1]) && result;
+	}
+
+	renderQueue = new RenderQueueClass;
+	constantAllocator = new ConstantAllocatorClass;
+	fallbackAllocator = new ConstantAllocatorClass;
+	if (!result || !renderQueue || !constantAllocator || !fallbackAllocator)
+	{
+		fclose(file);
+		return 1;
+	}
+	renderQueue->Initialize(counts.back(), 1000.0f);
+	result = renderQueue->InitializeDeferredContexts(device, maxThreads) && constantAllocator->Initialize(device, CONSTANT_SLICE_SIZE * 1024);
+
+	// The second allocator gets the same slices, but is created while the device can't bind at an offset.
+	device->SetConstantBufferOffsets(false);
+	result = result && fallbackAllocator->Initialize(device, CONSTANT_SLICE_SIZE * 1024);
+	device->SetConstantBufferOffsets(true);
+	if (!result)
+	{
+		printf("Could not create the deferred contexts.\n");
+		fclose(file);
+		return 1;
+	}
+
+	printf("%d cores, up to %d threads\n", (int)thread::hardware_concurrency(), maxThreads);
+	fprintf(file, "{\n  \"cores\": %d,\n  \"units\": \"ms\",\n  \"results\": [\n", (int)thread::hardware_concurrency());
+
+	passed = true;
+	firstResult = true;
+	for (countIndex = 0; countIndex < (int)counts.size(); countIndex++)
+	{
+		count = counts[countIndex];
+
+		// Fill the queue with a fixed seed so every run draws the same. All draws share the per frame slice and have
+		// a slice of their own, like the objects of Graphics.
+		renderQueue->Clear();
+		constantAllocator->BeginFrame();
+		fallbackAllocator->BeginFrame();
+		constants = (float*)constantAllocator->Allocate(128, frameOffset, frameSize);
+		memset(constants, 0, 128);
+		fallbackConstants = (float*)fallbackAllocator->Allocate(128, offset, size);
+		memset(fallbackConstants, 0, 128);
+		random = 12345;
+		for (i = 0; i < count; i++)
+		{
+			random = random * 1664525 + 1013904223;
+			shader = (random >> 8) % shaderCount;
+			random = random * 1664525 + 1013904223;
+			mesh = (random >> 8) % meshCount;
+
+			memset(&command, 0, sizeof(command));
+			command.vertexShader = vertexShaders[shader];
+			command.pixelShader = pixelShaders[shader];
+			command.inputLayout = layouts[shader % layoutCount];
+			command.topology = RENDER_TOPOLOGY_TRIANGLELIST;
+			command.vertexBuffers[0] = buffers[mesh * 2];
+			command.strides[0] = 12;
+			command.indexBuffer = buffers[mesh * 2 + 1];
+			command.indexFormat = RENDER_FORMAT_R32_UINT;
+			command.indexCount = 3 * (1 + mesh);
+			command.constantOffsets[0] = frameOffset;
+			command.constantSizes[0] = frameSize;
+
+			constants = (float*)constantAllocator->Allocate(64, offset, size);
+			memset(constants, 0, 64);
+			constants[0] = (float)i;
+			command.constantOffsets[1] = offset;
+			command.constantSizes[1] = size;
+			fallbackConstants = (float*)fallbackAllocator->Allocate(64, offset, size);
+			memcpy(fallbackConstants, constants, 64);
+
+			random = random * 1664525 + 1013904223;
+			renderQueue->Submit(command, (float)(random >> 8) / (float)(1 << 24) * 1000.0f);
+		}
+		renderQueue->Sort();
+		constantAllocator->Upload(context);
+		fallbackAllocator->Upload(context);
+
+		// Execute on the immediate context is the reference.
+		serialBest = 0.0;
+		for (repeat = 0; repeat < repeats; repeat++)
+		{
+			context->BeginFrame();
+			timer.Start();
+			renderQueue->Execute(context, constantAllocator);
+			elapsed = timer.GetElapsedMilliseconds();
+
+			if (repeat == 0 || elapsed < serialBest)
+			{
+				serialBest = elapsed;
+			}
+		}
+		serialStatistics = renderQueue->GetStatistics();
+		reference.clear();
+		GetBoundDraws(context->GetCommands(), reference);
+
+		printf("%7d draws  execute        %8.3f ms\n", count, serialBest);
+
+		oneThreadBest = serialBest;
+		for (threads = 1; threads <= maxThreads; threads++)
+		{
+			jobSystem = new JobSystemClass;
+			if (!jobSystem)
+			{
+				passed = false;
+				break;
+			}
+			jobSystem->Initialize(threads - 1);
+
+			best = 0.0;
+			result = true;
+			for (repeat = 0; repeat < repeats; repeat++)
+			{
+				context->BeginFrame();
+				timer.Start();
+				result = renderQueue->ExecuteParallel(context, constantAllocator, jobSystem, threads) && result;
+				elapsed = timer.GetElapsedMilliseconds();
+
+				if (repeat == 0 || elapsed < best)
+				{
+					best = elapsed;
+				}
+			}
+			if (threads == 1)
+			{
+				oneThreadBest = best;
+			}
+
+			jobSystem->Shutdown();
+			delete jobSystem;
+			jobSystem = 0;
+
+			// The same draws in the same order, each with the same objects bound.
+			statistics = renderQueue->GetStatistics();
+			draws.clear();
+			GetBoundDraws(context->GetCommands(), draws);
+			same = result && draws == reference && statistics.commands == count;
+			if (!same)
+			{
+				passed = false;
+			}
+
+			printf("%7d draws  %2d thread%s     %8.3f ms  %5.2fx  %6d binds (%+d)  %s\n", count, threads, threads == 1 ? " " : "s", best,
+				oneThreadBest / best, statistics.shaderBinds + statistics.inputLayoutBinds + statistics.vertexBufferBinds + statistics.indexBufferBinds,
+				(statistics.shaderBinds + statistics.inputLayoutBinds + statistics.vertexBufferBinds + statistics.indexBufferBinds) -
+				(serialStatistics.shaderBinds + serialStatistics.inputLayoutBinds + serialStatistics.vertexBufferBinds + serialStatistics.indexBufferBinds),
+				same ? "same draws" : "DIFFERENT DRAWS");
+			fprintf(file, "%s    { \"draws\": %d, \"threads\": %d, \"constant_offsets\": true, \"ms\": %.4f, \"execute_ms\": %.4f, \"speedup\": %.3f, \"constant_buffer_binds\": %d, \"same_draws\": %s }",
+				firstResult ? "" : ",\n", count, threads, best, serialBest, oneThreadBest / best, statistics.constantBufferBinds, same ? "true" : "false");
+			firstResult = false;
+		}
+
+		// Without binding at an offset ExecuteParallel has to fall back to the immediate context, and every slice that
+		// is bound is copied into the buffer of its slot first. Apart from the constant buffers the draws are the same.
+		jobSystem = new JobSystemClass;
+		if (!jobSystem)
+		{
+			passed = false;
+			break;
+		}
+		jobSystem->Initialize(maxThreads - 1);
+
+		best = 0.0;
+		result = true;
+		for (repeat = 0; repeat < repeats; repeat++)
+		{
+			context->BeginFrame();
+			timer.Start();
+			result = renderQueue->ExecuteParallel(context, fallbackAllocator, jobSystem, maxThreads) && result;
+			elapsed = timer.GetElapsedMilliseconds();
+
+			if (repeat == 0 || elapsed < best)
+			{
+				best = elapsed;
+			}
+		}
+
+		jobSystem->Shutdown();
+		delete jobSystem;
+		jobSystem = 0;
+
+		statistics = renderQueue->GetStatistics();
+		contextStatistics = context->GetStatistics();
+		draws.clear();
+		GetBoundDraws(context->GetCommands(), draws);
+
+		// Every draw takes 20 entries, the constant buffers are the 6 from the eleventh on.
+		same = result && draws.size() == reference.size() && statistics.commands == count &&
+			statistics.constantBufferBinds == serialStatistics.constantBufferBinds && contextStatistics.bufferUpdates == statistics.constantBufferBinds;
+		for (j = 0; same && j < draws.size(); j++)
+		{
+			if ((j % 20 < 10 || j % 20 >= 16) && draws[j] != reference[j])
+			{
+				same = false;
+			}
+		}
+		if (!same)
+		{
+			passed = false;
+		}
+
+		printf("%7d draws  no offsets     %8.3f ms  %5.2fx  %6d constant updates  %s\n", count, best, serialBest / best, contextStatistics.bufferUpdates,
+			same ? "same draws" : "DIFFERENT DRAWS");
+		fprintf(file, ",\n    { \"draws\": %d, \"threads\": %d, \"constant_offsets\": false, \"ms\": %.4f, \"execute_ms\": %.4f, \"speedup\": %.3f, \"constant_buffer_binds\": %d, \"same_draws\": %s }",
+			count, maxThreads, best, serialBest, serialBest / best, statistics.constantBufferBinds, same ? "true" : "false");
+	}
+
+	fprintf(file, "\n  ]\n}\n");
+	fclose(file);
+
+	fallbackAllocator->Shutdown();
+	delete fallbackAllocator;
+	fallbackAllocator = 0;
+
+	constantAllocator->Shutdown();
+	delete constantAllocator;
+	constantAllocator = 0;
+
+	renderQueue->Shutdown();
+	delete renderQueue;
+	renderQueue = 0;
+
+	for (shader = 0; shader < shaderCount; shader++)
+	{
+		device->ReleaseVertexShader(vertexShaders[shader]);
+		device->ReleasePixelShader(pixelShaders[shader]);
+	}
+	for (i = 0; i < layoutCount; i++)
+	{
+		device->ReleaseInputLayout(layouts[i]);
+	}
+	for (i = 0; i < (int)buffers.size(); i++)
+	{
+		device->ReleaseBuffer(buffers[i]);
+	}
+
+	// The deferred contexts count as objects of the device too.
+	if (device->GetLiveObjectCount() != 0)
+	{
+		printf("%d objects of the device were not released.\n", device->GetLiveObjectCount());
+		passed = false;
+	}
+
+	device->Shutdown();
+	delete device;
+	device = 0;
+
+	if (!passed)
+	{
+		printf("The command lists didn't draw the same as Execute.\n");
+	}
+
+	ProfilerClass::Shutdown();
+
+	return passed ? 0 : 1;
+}
+
+/*RunJobBenchmark measures spawning jobs and balancing uneven work on the job system, see the jobs suite above.*/
+static int RunJobBenchmark(int argc, char** argv)
+{
+	const int balanceCount = 2048;
+	vector<float> reference, results;
+	JobSystemClass* jobSystem;
+	JobType* root;
+	JobType* job;
+	JobStatisticsType statistics;
+	TimerClass timer;
+	const char* outputFile;
+	int count, maxThreads, threads, repeats, repeat, i, threadIndex, totalJobs, totalSteals, mismatches;
+	double childrenBest, parallelForBest, balanceBest, oneThreadBalance, elapsed;
+	bool passed, firstResult, checked;
+	FILE* file;
+
+	outputFile = GetArgument(argc, argv, "-output", "jobs.json");
+	count = atoi(GetArgument(argc, argv, "-jobs", "100000"));
+	if (count < 1)
+	{
+		count = 1;
+	}
+	repeats = atoi(GetArgument(argc, argv, "-repeats", "10"));
+	if (repeats < 1)
+	{
+		repeats = 1;
+	}
+
+	// Every core, but at least four threads so stealing and the dependencies are checked on any machine.
+	maxThreads = atoi(GetArgument(argc, argv, "-threads", "0"));
+	if (maxThreads < 1)
+	{
+		maxThreads = (int)thread::hardware_concurrency();
+		if (maxThreads < 4)
+		{
+			maxThreads = 4;
+		}
+	}
+
+	file = fopen(outputFile, "w");
+	if (!file)
+	{
+		printf("Could not open %s\n", outputFile);
+		return 1;
+	}
+
+	// The cost of an item grows with the square of its index, one thread works out what every item must come to.
+	reference.assign(balanceCount, 0.0f);
+	BalanceRange(&reference[0], 0, balanceCount);
+
+	printf("%d cores, up to %d threads, %d jobs\n", (int)thread::hardware_concurrency(), maxThreads, count);
+	fprintf(file, "{\n  \"cores\": %d,\n  \"jobs\": %d,\n  \"results\": [\n", (int)thread::hardware_concurrency(), count);
+
+	passed = true;
+	firstResult = true;
+	oneThreadBalance = 0.0;
+	for (threads = 1; threads <= maxThreads; threads++)
+	{
+		jobSystem = new JobSystemClass;
+		if (!jobSystem)
+		{
+			passed = false;
+			break;
+		}
+		jobSystem->Initialize(threads - 1);
+
+		checked = RunJobChecks(jobSystem);
+		if (!checked)
+		{
+			passed = false;
+		}
+
+		// Spawn count empty jobs as children of one job.
+		childrenBest = 0.0;
+		for (repeat = 0; repeat < repeats; repeat++)
+		{
+			timer.Start();
+			root = jobSystem->CreateJob(EmptyJob, 0, 0);
+			for (i = 0; i < count; i++)
+			{
+				job = jobSystem->CreateJob(EmptyJob, 0, root);
+				jobSystem->Submit(job);
+			}
+			jobSystem->Submit(root);
+			jobSystem->Wait(root);
+			elapsed = timer.GetElapsedMilliseconds();
+
+			if (repeat == 0 || elapsed < childrenBest)
+			{
+				childrenBest = elapsed;
+			}
+		}
+
+		// An empty parallel for with a job for every item.
+		parallelForBest = 0.0;
+		for (repeat = 0; repeat < repeats; repeat++)
+		{
+			timer.Start();
+			jobSystem->ParallelFor(count, 1, EmptyRange, 0);
+			elapsed = timer.GetElapsedMilliseconds();
+			if (repeat == 0 || elapsed < parallelForBest)
+			{
+				parallelForBest = elapsed;
+			}
+		}
+
+		// The uneven items, split down to a few items a job, must each be done exactly once.
+		balanceBest = 0.0;
+		mismatches = 0;
+		for (repeat = 0; repeat < repeats; repeat++)
+		{
+			results.assign(balanceCount, 0.0f);
+			jobSystem->ResetStatistics();
+			timer.Start();
+			jobSystem->ParallelFor(balanceCount, 4, BalanceRange, &results[0]);
+			elapsed = timer.GetElapsedMilliseconds();
+			if (repeat == 0 || elapsed < balanceBest)
+			{
+				balanceBest = elapsed;
+			}
+
+			for (i = 0; i < balanceCount; i++)
+			{
+				if (results[i] != reference[i])
+				{
+					mismatches++;
+				}
+			}
+		}
+		if (mismatches > 0)
+		{
+			passed = false;
+		}
+		if (threads == 1)
+		{
+			oneThreadBalance = balanceBest;
+		}
+
+		printf("%2d thread%s  spawn %7.1f ns/job as children  %7.1f ns/job parallel for\n", threads, threads == 1 ? " " : "s",
+			childrenBest * 1000000.0 / count, parallelForBest * 1000000.0 / count);
+		printf("            balance %8.3f ms  %5.2fx  %s\n", balanceBest, oneThreadBalance / balanceBest, checked && mismatches == 0 ? "checks passed" : "CHECKS FAILED");
+
+		// How the last balance run was spread over the threads.
+		printf("            jobs/steals per thread:");
+		fprintf(file, "%s    { \"threads\": %d, \"spawn_children_ns\": %.2f, \"spawn_parallel_for_ns\": %.2f, \"balance_ms\": %.4f, \"balance_speedup\": %.3f, \"checks_passed\": %s, \"per_thread\": [",
+			firstResult ? "" : ",\n", threads, childrenBest * 1000000.0 / count, parallelForBest * 1000000.0 / count, balanceBest, oneThreadBalance / balanceBest,
+			checked && mismatches == 0 ? "true" : "false");
+		totalJobs = 0;
+		totalSteals = 0;
+		for (threadIndex = 0; threadIndex < threads; threadIndex++)
+		{
+			jobSystem->GetStatistics(threadIndex, statistics);
+			totalJobs += statistics.jobs;
+			totalSteals += statistics.steals;
+			printf(" %d/%d", statistics.jobs, statistics.steals);
+			fprintf(file, "%s{ \"jobs\": %d, \"steals\": %d }", threadIndex == 0 ? "" : ", ", statistics.jobs, statistics.steals);
+		}
+		printf("  (%d jobs, %d stolen)\n", totalJobs, totalSteals);
+		fprintf(file, "] }");
+		firstResult = false;
+
+		jobSystem->Shutdown();
+		delete jobSystem;
+		jobSystem = 0;
+	}
+
+	fprintf(file, "\n  ]\n}\n");
+	fclose(file);
+
+	if (!passed)
+	{
+		printf("The job system checks failed.\n");
+	}
+
+	ProfilerClass::Shutdown();
+
+	return passed ? 0 : 1;
+}
+
+/*RunSimulationBenchmark checks and times the fixed timestep simulation, see the simulation suite above.*/
+static int RunSimulationBenchmark(int argc, char** argv)
+{
+	const int frameTimes[] = { 1, 16, 50, 100 };
+	const int frameTimeCount = sizeof(frameTimes) / sizeof(frameTimes[0]);
+	const int stepCount = 120;
+	SimulationClass* simulation;
+	Graphics* graphics;
+	const SimulationSnapshotType* snapshot;
+	const SimulationSnapshotType* lastSnapshot;
+	SimulationStatisticsType statistics;
+	FrameTimingType frameTiming;
+	vector<float> baseAngles, interpolated;
+	TimerClass timer;
+	const char* outputFile;
+	long long baseStep;
+	int count, frameIndex, step, frames, newSnapshots, mismatches, torn, visibleStill, visibleSpinning, i;
+	double seconds, elapsed, stepBest, stepsPerSecond, transformStill, transformSpinning;
+	float blend;
+	bool passed, checked;
+	FILE* file;
+
+	outputFile = GetArgument(argc, argv, "-output", "simulation.json");
+	count = atoi(GetArgument(argc, argv, "-objects", "10000"));
+	if (count < 1)
+	{
+		count = 1;
+	}
+	seconds = atof(GetArgument(argc, argv, "-seconds", "1"));
+	if (seconds < 0.25)
+	{
+		seconds = 0.25;
+	}
+
+	file = fopen(outputFile, "w");
+	if (!file)
+	{
+		printf("Could not open %s\n", outputFile);
+		return 1;
+	}
+
+	passed = true;
+	printf("%d objects, %.0f steps a second\n", count, 1.0 / SIMULATION_TIMESTEP);
+	fprintf(file, "{\n  \"objects\": %d,\n  \"steps_per_second\": %.1f,\n", count, 1.0 / SIMULATION_TIMESTEP);
+
+	// Step by hand, every snapshot must be the step that was just run and nothing new may come without a step.
+	simulation = new SimulationClass;
+	if (!simulation)
+	{
+		fclose(file);
+		return 1;
+	}
+	simulation->Initialize(false);
+	simulation->SetObjectCount(count);
+
+	snapshot = simulation->AcquireSnapshot();
+	baseStep = snapshot->step;
+	baseAngles = snapshot->angles;
+	mismatches = 0;
+	stepBest = 0.0;
+	for (step = 1; step <= stepCount; step++)
+	{
+		timer.Start();
+		simulation->Step();
+		elapsed = timer.GetElapsedMilliseconds();
+		if (step == 1 || elapsed < stepBest)
+		{
+			stepBest = elapsed;
+		}
+
+		snapshot = simulation->AcquireSnapshot();
+		if (snapshot->step != baseStep + step || simulation->AcquireSnapshot() != snapshot)
+		{
+			mismatches++;
+		}
+		mismatches += CheckSnapshot(snapshot, baseStep, baseAngles);
+	}
+
+	// The blend runs from the state before the step, when it is due, to the state after it one timestep later.
+	checked = SimulationClass::GetBlend(snapshot, snapshot->time) == 0.0f && SimulationClass::GetBlend(snapshot, snapshot->time - 1.0) == 0.0f &&
+		fabsf(SimulationClass::GetBlend(snapshot, snapshot->time + SIMULATION_TIMESTEP * 0.5) - 0.5f) < 0.001f &&
+		SimulationClass::GetBlend(snapshot, snapshot->time + SIMULATION_TIMESTEP * 2.0) == 1.0f;
+
+	// Halfway between an angle just below 2 pi and one just past zero is 2 pi, the short way around.
+	checked = checked && fabsf(SimulationClass::InterpolateAngle(6.2f, 0.1f, 0.5f) - 6.2f - (0.1f + 6.28318531f - 6.2f) * 0.5f) < 0.001f &&
+		fabsf(SimulationClass::InterpolateAngle(0.1f, 6.2f, 0.5f) - 0.1f + (0.1f + 6.28318531f - 6.2f) * 0.5f) < 0.001f;
+	for (i = 0; i < count; i++)
+	{
+		blend = SimulationClass::InterpolateAngle(snapshot->previousAngles[i], snapshot->angles[i], 0.25f);
+		if (GetAngleDistance(blend, snapshot->previousAngles[i] + SimulationClass::GetSpin(i) * (float)SIMULATION_TIMESTEP * 0.25f) > 0.001f)
+		{
+			checked = false;
+		}
+	}
+	if (mismatches > 0 || !checked)
+	{
+		passed = false;
+	}
+
+	simulation->Shutdown();
+	delete simulation;
+	simulation = 0;
+
+	printf("step %8.4f ms  %6.2f ns/object  %s\n", stepBest, stepBest * 1000000.0 / count, mismatches == 0 && checked ? "checks passed" : "CHECKS FAILED");
+	fprintf(file, "  \"step_ms\": %.5f,\n  \"step_checks_passed\": %s,\n  \"threaded\": [\n", stepBest, mismatches == 0 && checked ? "true" : "false");
+
+	/*The simulation thread next to frames of every length. The frames do what Graphics does with a snapshot, check
+	that it is one whole step and interpolate it, and then pretend to take the rest of the frame time.*/
+	for (frameIndex = 0; frameIndex < frameTimeCount; frameIndex++)
+	{
+		simulation = new SimulationClass;
+		if (!simulation)
+		{
+			passed = false;
+			break;
+		}
+		simulation->Initialize(true);
+		simulation->SetObjectCount(count);
+
+		// The state the simulation has when the objects are there is where the checks start from.
+		do
+		{
+			snapshot = simulation->AcquireSnapshot();
+		} while ((int)snapshot->angles.size() != count);
+		baseStep = snapshot->step;
+		baseAngles = snapshot->angles;
+
+		interpolated.resize(count);
+		lastSnapshot = snapshot;
+		frames = 0;
+		newSnapshots = 0;
+		torn = 0;
+		timer.Start();
+		while (timer.GetElapsedMilliseconds() < seconds * 1000.0)
+		{
+			snapshot = simulation->AcquireSnapshot();
+			if (snapshot != lastSnapshot)
+			{
+				newSnapshots++;
+			}
+			lastSnapshot = snapshot;
+
+			if (CheckSnapshot(snapshot, baseStep, baseAngles) > 0)
+			{
+				torn++;
+			}
+
+			blend = SimulationClass::GetBlend(snapshot, TimerClass::GetTimeSeconds());
+			for (i = 0; i < count; i++)
+			{
+				interpolated[i] = SimulationClass::InterpolateAngle(snapshot->previousAngles[i], snapshot->angles[i], blend);
+			}
+			frames++;
+
+			this_thread::sleep_for(chrono::milliseconds(frameTimes[frameIndex]));
+		}
+		elapsed = timer.GetElapsedMilliseconds();
+
+		simulation->Shutdown();
+		statistics = simulation->GetStatistics();
+		delete simulation;
+		simulation = 0;
+
+		// The steps counted from Initialize, which was just before the timer started.
+		stepsPerSecond = (double)statistics.steps * 1000.0 / elapsed;
+		checked = torn == 0 && statistics.droppedSteps == 0 && fabs(stepsPerSecond * SIMULATION_TIMESTEP - 1.0) < 0.1;
+		if (!checked)
+		{
+			passed = false;
+		}
+
+		printf("frames of %3d ms  %5d frames  %6.1f steps/s  %lld dropped  %4d new snapshots  %d torn  %s\n", frameTimes[frameIndex], frames,
+			stepsPerSecond, statistics.droppedSteps, newSnapshots, torn, checked ? "checks passed" : "CHECKS FAILED");
+		fprintf(file, "%s    { \"frame_ms\": %d, \"frames\": %d, \"steps_per_second\": %.2f, \"dropped_steps\": %lld, \"new_snapshots\": %d, \"torn_snapshots\": %d, \"last_step_ms\": %.5f, \"checks_passed\": %s }",
+			frameIndex == 0 ? "" : ",\n", frameTimes[frameIndex], frames, stepsPerSecond, statistics.droppedSteps, newSnapshots, torn,
+			statistics.lastStepMilliseconds, checked ? "true" : "false");
+	}
+	fprintf(file, "\n  ],\n");
+
+	/*The frame of Graphics with the objects standing still and spinning. The spinning objects are culled with bounds
+	that hold them at any angle, those must have every object in them that was visible standing still.*/
+	transformStill = 0.0;
+	transformSpinning = 0.0;
+	visibleStill = 0;
+	visibleSpinning = 0;
+	checked = false;
+	graphics = new Graphics;
+	simulation = new SimulationClass;
+	if (graphics && simulation && graphics->Initialize(BENCHMARK_SCREEN_WIDTH, BENCHMARK_SCREEN_HEIGHT, NULL, NULL))
+	{
+		simulation->Initialize(false);
+		graphics->SetObjectCount(count);
+
+		checked = true;
+		for (frameIndex = 0; frameIndex < 2 * stepCount; frameIndex++)
+		{
+			if (frameIndex == stepCount)
+			{
+				graphics->SetSimulation(simulation);
+			}
+			if (frameIndex >= stepCount)
+			{
+				simulation->Step();
+			}
+
+			if (!graphics->Frame())
+			{
+				checked = false;
+				break;
+			}
+
+			graphics->GetFrameTiming(frameTiming);
+			if (frameIndex < stepCount)
+			{
+				transformStill += frameTiming.objectTransform / stepCount;
+				visibleStill = graphics->GetCullStatistics().visible;
+			}
+			else
+			{
+				transformSpinning += frameTiming.objectTransform / stepCount;
+				visibleSpinning = graphics->GetCullStatistics().visible;
+			}
+		}
+		graphics->SetSimulation(0);
+	}
+	if (!checked || visibleSpinning < visibleStill)
+	{
+		passed = false;
+	}
+
+	if (graphics)
+	{
+		graphics->Shutdown();
+		delete graphics;
+		graphics = 0;
+	}
+	if (simulation)
+	{
+		simulation->Shutdown();
+		delete simulation;
+		simulation = 0;
+	}
+
+	printf("graphics  object transforms %8.4f ms standing still  %8.4f ms spinning  %d/%d visible  %s\n", transformStill, transformSpinning,
+		visibleStill, visibleSpinning, checked && visibleSpinning >= visibleStill ? "checks passed" : "CHECKS FAILED");
+	fprintf(file, "  \"graphics\": { \"object_transform_still_ms\": %.5f, \"object_transform_spinning_ms\": %.5f, \"visible_still\": %d, \"visible_spinning\": %d, \"checks_passed\": %s }\n}\n",
+		transformStill, transformSpinning, visibleStill, visibleSpinning, checked && visibleSpinning >= visibleStill ? "true" : "false");
+	fclose(file);
+
+	if (!passed)
+	{
+		printf("The simulation checks failed.\n");
+	}
+
+	ProfilerClass::Shutdown();
+
+	return passed ? 0 : 1;
+}
+
+/*RunPacingBenchmark paces simulated frames and a few real ones, see the pacing suite above. The frames take the same
+CPU time every time and the input comes in on the same random schedule, so every run gives the same numbers.*/
+static int RunPacingBenchmark(int argc, char** argv)
+{
+	struct PacingSceneType
+	{
+		const char* name;
+		double cpuMilliseconds;
+		double gpuMilliseconds;
+		double refreshRate;
+		double frameRateCap;
+	};
+	const PacingSceneType scenes[] = {
+		{ "gpu bound", 4.0, 12.0, 0.0, 0.0 },
+		{ "vsync 60 Hz", 4.0, 8.0, 60.0, 0.0 },
+		{ "cap 100 fps", 2.0, 3.0, 0.0, 100.0 },
+	};
+	const int sceneCount = sizeof(scenes) / sizeof(scenes[0]);
+	const int maxFramesInFlight = 3;
+	const int realFrames = 100;
+	const double realCap = 200.0;
+	const double realGpuMilliseconds = 4.0;
+	SimulatedClockClass* clock;
+	DeviceClockClass* deviceClock;
+	HeadlessDeviceClass* device;
+	FramePacerClass* pacer;
+	FramePacingStatisticsType statistics;
+	const char* outputFile;
+	unsigned int random;
+	int frames, sceneIndex, framesInFlight, frame, displayCount;
+	double inputTime, frameInputTime, startTime, frameMilliseconds, displayLatency, maxDisplayLatency, oneFrameLatency, realFrameMilliseconds;
+	double gpuFrameMilliseconds;
+	bool passed, checked, gpuChecked, firstResult;
+	FILE* file;
+
+	outputFile = GetArgument(argc, argv, "-output", "pacing.json");
+	frames = atoi(GetArgument(argc, argv, "-frames", "600"));
+	if (frames < 10)
+	{
+		frames = 10;
+	}
+
+	file = fopen(outputFile, "w");
+	if (!file)
+	{
+		printf("Could not open %s\n", outputFile);
+		return 1;
+	}
+
+	printf("%d frames a run\n", frames);
+	fprintf(file, "{\n  \"frames\": %d,\n  \"results\": [\n", frames);
+
+	passed = true;
+	firstResult = true;
+	for (sceneIndex = 0; sceneIndex < sceneCount; sceneIndex++)
+	{
+		oneFrameLatency = 0.0;
+		for (framesInFlight = 1; framesInFlight <= maxFramesInFlight; framesInFlight++)
+		{
+			clock = new SimulatedClockClass;
+			pacer = new FramePacerClass;
+			if (!clock || !pacer)
+			{
+				passed = false;
+				break;
+			}
+			clock->Initialize(scenes[sceneIndex].gpuMilliseconds / 1000.0, scenes[sceneIndex].refreshRate > 0.0 ? 1.0 / scenes[sceneIndex].refreshRate : 0.0);
+			pacer->Initialize(clock, framesInFlight, scenes[sceneIndex].frameRateCap);
+
+			// An input event every 1 to 16 ms. The first tenth of the frames fills the queue and isn't measured.
+			random = 12345;
+			inputTime = 0.0;
+			startTime = 0.0;
+			displayLatency = 0.0;
+			maxDisplayLatency = 0.0;
+			displayCount = 0;
+			for (frame = 0; frame < frames; frame++)
+			{
+				if (frame == frames / 10)
+				{
+					pacer->ResetStatistics();
+					startTime = clock->GetTime();
+				}
+
+				pacer->BeginFrame();
+
+				// The frame handles every event that came in up to now, the way System::Run handles the messages.
+				frameInputTime = -1.0;
+				while (inputTime <= clock->GetTime())
+				{
+					pacer->AddInput(inputTime);
+					if (frameInputTime < 0.0)
+					{
+						frameInputTime = inputTime;
+					}
+					random = random * 1664525 + 1013904223;
+					inputTime += (1.0 + (double)(random >> 8) / 16777216.0 * 15.0) / 1000.0;
+				}
+
+				clock->Advance(scenes[sceneIndex].cpuMilliseconds / 1000.0);
+				pacer->EndFrame();
+
+				// The simulated clock knows exactly when the frame is shown.
+				if (frame >= frames / 10 && frameInputTime >= 0.0)
+				{
+					frameMilliseconds = (clock->GetDisplayTime((unsigned long long)frame) - frameInputTime) * 1000.0;
+					displayLatency += frameMilliseconds;
+					displayCount++;
+					if (frameMilliseconds > maxDisplayLatency)
+					{
+						maxDisplayLatency = frameMilliseconds;
+					}
+				}
+			}
+			statistics = pacer->GetStatistics();
+			frameMilliseconds = (clock->GetTime() - startTime) * 1000.0 / statistics.frames;
+			displayLatency = displayCount > 0 ? displayLatency / displayCount : 0.0;
+
+			checked = statistics.maxFramesInFlight <= framesInFlight;
+			if (scenes[sceneIndex].frameRateCap > 0.0 && fabs(frameMilliseconds * scenes[sceneIndex].frameRateCap / 1000.0 - 1.0) > 0.01)
+			{
+				checked = false;
+			}
+			if (framesInFlight == 1)
+			{
+				oneFrameLatency = displayLatency;
+			}
+			else if (framesInFlight == maxFramesInFlight && oneFrameLatency > displayLatency)
+			{
+				checked = false;
+			}
+			if (!checked)
+			{
+				passed = false;
+			}
+
+			printf("%-12s %d in flight  frame %6.2f ms  present latency %6.2f ms (max %6.2f)  display latency %6.2f ms (max %6.2f)  waits %6.1f ms gpu %6.1f ms cap  %s\n",
+				scenes[sceneIndex].name, framesInFlight, frameMilliseconds,
+				statistics.presentLatencyCount > 0 ? statistics.presentLatencyMilliseconds / statistics.presentLatencyCount : 0.0,
+				statistics.maxPresentLatencyMilliseconds, displayLatency, maxDisplayLatency, statistics.limitWaitMilliseconds / statistics.frames,
+				statistics.capWaitMilliseconds / statistics.frames, checked ? "checks passed" : "CHECKS FAILED");
+			fprintf(file, "%s    { \"scene\": \"%s\", \"frames_in_flight\": %d, \"frame_ms\": %.4f, \"present_latency_ms\": %.4f, \"max_present_latency_ms\": %.4f, \"display_latency_ms\": %.4f, \"max_display_latency_ms\": %.4f, \"max_frames_in_flight\": %d, \"gpu_wait_ms\": %.4f, \"cap_wait_ms\": %.4f, \"checks_passed\": %s }",
+				firstResult ? "" : ",\n", scenes[sceneIndex].name, framesInFlight, frameMilliseconds,
+				statistics.presentLatencyCount > 0 ? statistics.presentLatencyMilliseconds / statistics.presentLatencyCount : 0.0,
+				statistics.maxPresentLatencyMilliseconds, displayLatency, maxDisplayLatency, statistics.maxFramesInFlight,
+				statistics.limitWaitMilliseconds / statistics.frames, statistics.capWaitMilliseconds / statistics.frames, checked ? "true" : "false");
+			firstResult = false;
+
+			pacer->Shutdown();
+			delete pacer;
+			pacer = 0;
+			clock->Shutdown();
+			delete clock;
+			clock = 0;
+		}
+	}
+	fprintf(file, "\n  ],\n");
+
+	// The real clock, the headless device finishes every frame when it presents so only the cap holds the frames back.
+	realFrameMilliseconds = 0.0;
+	gpuFrameMilliseconds = 0.0;
+	checked = false;
+	device = new HeadlessDeviceClass;
+	deviceClock = new DeviceClockClass;
+	pacer = new FramePacerClass;
+	if (device && deviceClock && pacer && device->Initialize(BENCHMARK_SCREEN_WIDTH, BENCHMARK_SCREEN_HEIGHT, SCREEN_DEPTH, SCREEN_NEAR) &&
+		deviceClock->Initialize(device) && pacer->Initialize(deviceClock, 2, realCap))
+	{
+		for (frame = 0; frame < realFrames; frame++)
+		{
+			if (frame == 1)
+			{
+				pacer->ResetStatistics();
+				startTime = deviceClock->GetTime();
+			}
+
+			pacer->BeginFrame();
+			device->BeginScene(0.0f, 0.0f, 0.0f, 1.0f);
+			device->EndScene();
+			pacer->EndFrame();
+		}
+		statistics = pacer->GetStatistics();
+		realFrameMilliseconds = (deviceClock->GetTime() - startTime) * 1000.0 / statistics.frames;
+		checked = fabs(realFrameMilliseconds * realCap / 1000.0 - 1.0) < 0.1 && statistics.maxFramesInFlight <= 1;
+
+		// Now the GPU holds the frames back, one frame in flight has to wait in BeginFrame for the GPU to finish the
+		// frame before. A frame that is never seen as finished would wait there forever.
+		device->SetGpuFrameTime(realGpuMilliseconds / 1000.0);
+		pacer->SetFramesInFlight(1);
+		pacer->SetFrameRateCap(0.0);
+		for (frame = 0; frame < realFrames; frame++)
+		{
+			if (frame == 1)
+			{
+				pacer->ResetStatistics();
+				startTime = deviceClock->GetTime();
+			}
+
+			pacer->BeginFrame();
+			device->BeginScene(0.0f, 0.0f, 0.0f, 1.0f);
+			device->EndScene();
+			pacer->EndFrame();
+		}
+		statistics = pacer->GetStatistics();
+		gpuFrameMilliseconds = (deviceClock->GetTime() - startTime) * 1000.0 / statistics.frames;
+		gpuChecked = gpuFrameMilliseconds >= realGpuMilliseconds * 0.95 && gpuFrameMilliseconds < realGpuMilliseconds * 1.25 &&
+			statistics.maxFramesInFlight <= 1 && statistics.limitWaits >= statistics.frames - 1;
+		checked = checked && gpuChecked;
+	}
+	if (!checked)
+	{
+		passed = false;
+	}
+
+	if (pacer)
+	{
+		pacer->Shutdown();
+		delete pacer;
+		pacer = 0;
+	}
+	if (deviceClock)
+	{
+		deviceClock->Shutdown();
+		delete deviceClock;
+		deviceClock = 0;
+	}
+	if (device)
+	{
+		device->Shutdown();
+		delete device;
+		device = 0;
+	}
+
+	printf("real clock   cap %.0f fps  frame %6.3f ms  gpu %.1f ms  frame %6.3f ms  %s\n", realCap, realFrameMilliseconds, realGpuMilliseconds,
+		gpuFrameMilliseconds, checked ? "checks passed" : "CHECKS FAILED");
+	fprintf(file, "  \"real_clock\": { \"frame_rate_cap\": %.1f, \"frame_ms\": %.4f, \"gpu_frame_ms\": %.1f, \"gpu_bound_frame_ms\": %.4f, "
+		"\"checks_passed\": %s }\n}\n", realCap, realFrameMilliseconds, realGpuMilliseconds, gpuFrameMilliseconds, checked ? "true" : "false");
+	fclose(file);
+
+	if (!passed)
+	{
+		printf("The frame pacing checks failed.\n");
+	}
+
+	ProfilerClass::Shutdown();
+
+	return passed ? 0 : 1;
+}
+
+/*RunInputBenchmark checks the Input and measures the InputQueueClass, see the input suite above. The events are
+numbered, the key and the time of an event both come from its number so the popping side can tell if one is missing or
+out of order.*/
+static int RunInputBenchmark(int argc, char** argv)
+{
+	const int batchSize = INPUT_QUEUE_SIZE / 2;
+	const int keyCount = 16;
+	InputQueueClass* queue;
+	Input* input;
+	InputEventType event;
+	TimerClass timer;
+	thread producer;
+	atomic<bool> producerDone;
+	const char* outputFile;
+	long long events, i, j, popped, expected, updates;
+	double threadedMilliseconds, batchMilliseconds, inputMilliseconds;
+	unsigned int key;
+	bool passed, stateChecked, orderChecked, inputChecked;
+	FILE* file;
+
+	outputFile = GetArgument(argc, argv, "-output", "input.json");
+	events = atoll(GetArgument(argc, argv, "-events", "10000000"));
+	if (events < batchSize)
+	{
+		events = batchSize;
+	}
+	events = (events + batchSize - 1) / batchSize * batchSize;
+
+	queue = new InputQueueClass;
+	input = new Input;
+	if (!queue || !input)
+	{
+		printf("Could not create the input queue\n");
+		return 1;
+	}
+	input->Initialize();
+
+	// The key state, one update at a time.
+	stateChecked = true;
+	input->KeyDown('A');
+	input->KeyUp('A');
+	input->KeyDown('B');
+	input->Update();
+	stateChecked = stateChecked && input->IsKeyPressed('A') && input->IsKeyReleased('A') && !input->IsKeyDown('A');
+	stateChecked = stateChecked && input->IsKeyPressed('B') && !input->IsKeyReleased('B') && input->IsKeyDown('B') && !input->WasKeyDown('B');
+	stateChecked = stateChecked && input->GetFrameEvents().size() == 3 && input->GetFrameEvents()[0].key == 'A' && input->GetFrameEvents()[2].key == 'B';
+	input->Update();
+	stateChecked = stateChecked && !input->IsKeyPressed('A') && !input->IsKeyReleased('A') && !input->IsKeyPressed('B');
+	stateChecked = stateChecked && input->IsKeyDown('B') && input->WasKeyDown('B') && input->GetFrameEvents().empty();
+	input->KeyUp('B');
+	input->KeyDown(INPUT_KEY_COUNT);
+	input->Update();
+	stateChecked = stateChecked && input->IsKeyReleased('B') && !input->IsKeyDown('B') && input->WasKeyDown('B') && input->GetFrameEvents().size() == 1;
+	for (i = 0; i < INPUT_QUEUE_SIZE + 10; i++)
+	{
+		input->KeyDown('C');
+	}
+	input->Update();
+	stateChecked = stateChecked && input->GetDroppedEvents() == 10 && (int)input->GetFrameEvents().size() == INPUT_QUEUE_SIZE;
+	printf("key state    %s\n", stateChecked ? "checks passed" : "CHECKS FAILED");
+
+	// One thread pushes and another pops, one event at a time.
+	orderChecked = true;
+	producerDone = false;
+	popped = 0;
+	timer.Start();
+	producer = thread([queue, events]()
+	{
+		PROFILE_THREAD_NAME("Input producer");
+		InputEventType pushed;
+		long long k;
+
+		for (k = 0; k < events; k++)
+		{
+			pushed.time = (double)k;
+			pushed.key = (unsigned int)(k & (INPUT_KEY_COUNT - 1));
+			pushed.down = (k & 1) == 0;
+			while (!queue->Push(pushed))
+			{
+				this_thread::yield();
+			}
+		}
+	});
+	while (popped < events)
+	{
+		if (!queue->Pop(event))
+		{
+			this_thread::yield();
+			continue;
+		}
+		if (event.time != (double)popped || event.key != (unsigned int)(popped & (INPUT_KEY_COUNT - 1)) || event.down != ((popped & 1) == 0))
+		{
+			orderChecked = false;
+		}
+		popped++;
+	}
+	producer.join();
+	threadedMilliseconds = timer.GetElapsedMilliseconds();
+	orderChecked = orderChecked && !queue->Pop(event);
+
+	// One thread fills half the ring and empties it again.
+	popped = 0;
+	timer.Start();
+	for (i = 0; i < events; i += batchSize)
+	{
+		for (j = 0; j < batchSize; j++)
+		{
+			event.time = (double)(i + j);
+			event.key = (unsigned int)((i + j) & (INPUT_KEY_COUNT - 1));
+			event.down = true;
+			queue->Push(event);
+		}
+		for (j = 0; j < batchSize; j++)
+		{
+			if (!queue->Pop(event) || event.time != (double)popped)
+			{
+				orderChecked = false;
+			}
+			popped++;
+		}
+	}
+	batchMilliseconds = timer.GetElapsedMilliseconds();
+
+	printf("queue        threaded %7.1f M events/s  batched %7.1f M events/s  %s\n", events / threadedMilliseconds / 1000.0,
+		popped / batchMilliseconds / 1000.0, orderChecked ? "checks passed" : "CHECKS FAILED");
+
+	// A thread types on a few keys while another one updates the input. Event k toggles key k % keyCount, so every key
+	// ends up down when it was toggled an odd number of times.
+	delete input;
+	input = new Input;
+	if (!input)
+	{
+		printf("Could not create the input\n");
+		return 1;
+	}
+	input->Initialize();
+	inputChecked = true;
+	producerDone = false;
+	expected = events / 10;
+	popped = 0;
+	updates = 0;
+	timer.Start();
+	producer = thread([input, expected, &producerDone]()
+	{
+		PROFILE_THREAD_NAME("Input producer");
+		InputEventType pushed;
+		long long k;
+
+		for (k = 0; k < expected; k++)
+		{
+			pushed.time = (double)k;
+			pushed.key = (unsigned int)(k % keyCount);
+			pushed.down = ((k / keyCount) & 1) == 0;
+			while (!input->AddEvent(pushed))
+			{
+				this_thread::yield();
+			}
+		}
+		producerDone = true;
+	});
+	while (!producerDone || popped < expected)
+	{
+		input->Update();
+		updates++;
+		for (i = 0; i < (long long)input->GetFrameEvents().size(); i++)
+		{
+			if (input->GetFrameEvents()[(size_t)i].time != (double)(popped + i))
+			{
+				inputChecked = false;
+			}
+		}
+		popped += input->GetFrameEvents().size();
+		if (input->GetFrameEvents().empty())
+		{
+			this_thread::yield();
+		}
+	}
+	producer.join();
+	inputMilliseconds = timer.GetElapsedMilliseconds();
+	for (key = 0; key < (unsigned int)keyCount; key++)
+	{
+		if (input->IsKeyDown(key) != ((((expected - key + keyCount - 1) / keyCount) & 1) == 1))
+		{
+			inputChecked = false;
+		}
+	}
+	inputChecked = inputChecked && popped == expected;
+
+	printf("input        %lld events in %lld updates  %7.1f M events/s  %s\n", popped, updates, popped / inputMilliseconds / 1000.0,
+		inputChecked ? "checks passed" : "CHECKS FAILED");
+
+	delete input;
+	input = 0;
+	delete queue;
+	queue = 0;
+
+	passed = stateChecked && orderChecked && inputChecked;
+
+	file = fopen(outputFile, "w");
+	if (!file)
+	{
+		printf("Could not open %s\n", outputFile);
+		return 1;
+	}
+	fprintf(file, "{\n  \"events\": %lld,\n  \"threaded_events_per_second\": %.0f,\n  \"batched_events_per_second\": %.0f,\n", events,
+		events / threadedMilliseconds * 1000.0, events / batchMilliseconds * 1000.0);
+	fprintf(file, "  \"input_events\": %lld,\n  \"input_updates\": %lld,\n  \"input_events_per_second\": %.0f,\n", popped, updates,
+		popped / inputMilliseconds * 1000.0);
+	fprintf(file, "  \"checks_passed\": %s\n}\n", passed ? "true" : "false");
+	fclose(file);
+
+	if (!passed)
+	{
+		printf("The input checks failed.\n");
+	}
+
+	ProfilerClass::Shutdown();
+
+	return passed ? 0 : 1;
+}
+
+/*RunReplayBenchmark records an input log and replays it, see the replay suite above. The key presses and frame times
+come from a fixed pseudo random sequence, so every run writes the same log.*/
+static int RunReplayBenchmark(int argc, char** argv)
+{
+	const unsigned int keys[] = { 'W', 'A', 'S', 'D', 'Q', 'E', CAMERA_KEY_LEFT, CAMERA_KEY_RIGHT, CAMERA_KEY_UP, CAMERA_KEY_DOWN };
+	const int keyCount = sizeof(keys) / sizeof(keys[0]);
+	const int drawnFrames = 300;
+	const int drawnObjects = 400;
+	InputLogClass* log;
+	Input* input;
+	CameraClass* camera;
+	CameraControllerClass* controller;
+	BenchmarkClass* benchmark;
+	InputEventType event;
+	vector<InputEventType> events, recordedEvents;
+	vector<XMFLOAT3> positions, rotations;
+	vector<float> frameTimes;
+	vector<int> frameEventCounts;
+	XMFLOAT3 position, rotation;
+	TimerClass timer;
+	const char* outputFile;
+	const char* logFile;
+	unsigned int random;
+	bool keyDown[keyCount];
+	int frames, frame, i, eventIndex, keyIndex;
+	float frameTime;
+	double time, recordMilliseconds, replayMilliseconds, visibleObjects[2], triangles[2];
+	bool passed, logChecked, drawChecked, result;
+	FILE* file;
+
+	outputFile = GetArgument(argc, argv, "-output", "replay.json");
+	logFile = GetArgument(argc, argv, "-log", "replay.inputlog");
+	frames = atoi(GetArgument(argc, argv, "-frames", "2000"));
+	if (frames < 1)
+	{
+		frames = 1;
+	}
+
+	log = new InputLogClass;
+	input = new Input;
+	camera = new CameraClass;
+	controller = new CameraControllerClass;
+	if (!log || !input || !camera || !controller)
+	{
+		printf("Could not create the replay objects\n");
+		return 1;
+	}
+
+	// Record: every frame takes 5 to 30 ms and now and then up to two keys change, at times inside the frame.
+	input->Initialize();
+	camera->SetPosition(-2.9f, 0.0f, -5.0f);
+	controller->Initialize(camera);
+	for (keyIndex = 0; keyIndex < keyCount; keyIndex++)
+	{
+		keyDown[keyIndex] = false;
+	}
+	random = 2024;
+	time = 100.0;
+	timer.Start();
+	log->BeginRecording(time);
+	for (frame = 0; frame < frames; frame++)
+	{
+		random = random * 1664525 + 1013904223;
+		frameTime = 0.005f + (float)(random >> 8) / 16777216.0f * 0.025f;
+
+		random = random * 1664525 + 1013904223;
+		for (i = 0; i < (int)((random >> 28) & 3) - 1; i++)
+		{
+			random = random * 1664525 + 1013904223;
+			keyIndex = (int)((random >> 8) % keyCount);
+			keyDown[keyIndex] = !keyDown[keyIndex];
+			event.time = time + (double)frameTime * (double)(i + 1) / 4.0;
+			event.key = keys[keyIndex];
+			event.down = keyDown[keyIndex];
+			input->AddEvent(event);
+		}
+		time += frameTime;
+
+		input->Update();
+		log->RecordFrame(frameTime, input->GetFrameEvents());
+		controller->Frame(input, frameTime);
+
+		frameTimes.push_back(frameTime);
+		frameEventCounts.push_back((int)input->GetFrameEvents().size());
+		recordedEvents.insert(recordedEvents.end(), input->GetFrameEvents().begin(), input->GetFrameEvents().end());
+		positions.push_back(camera->GetPosition());
+		rotations.push_back(camera->GetRotation());
+	}
+	recordMilliseconds = timer.GetElapsedMilliseconds();
+
+	result = log->Save(logFile);
+	delete log;
+	log = new InputLogClass;
+	if (!log)
+	{
+		printf("Could not create the replay objects\n");
+		return 1;
+	}
+	logChecked = result && !log->Load("missing.inputlog") && log->Load(logFile) && log->GetFrameCount() == frames &&
+		log->GetEventCount() == (int)recordedEvents.size();
+
+	// Replay into a new input and camera, everything has to come out the same.
+	controller->Shutdown();
+	delete controller;
+	delete camera;
+	delete input;
+	input = new Input;
+	camera = new CameraClass;
+	controller = new CameraControllerClass;
+	if (!input || !camera || !controller)
+	{
+		printf("Could not create the replay objects\n");
+		return 1;
+	}
+	input->Initialize();
+	camera->SetPosition(-2.9f, 0.0f, -5.0f);
+	controller->Initialize(camera);
+	eventIndex = 0;
+	timer.Start();
+	for (frame = 0; logChecked && frame < frames; frame++)
+	{
+		if (!log->ReadFrame(frameTime, events) || frameTime != frameTimes[frame] || (int)events.size() != frameEventCounts[frame])
+		{
+			logChecked = false;
+			break;
+		}
+		for (i = 0; i < (int)events.size(); i++, eventIndex++)
+		{
+			if (events[i].key != recordedEvents[eventIndex].key || events[i].down != recordedEvents[eventIndex].down ||
+				fabs(events[i].time - recordedEvents[eventIndex].time) > 0.000001)
+			{
+				logChecked = false;
+			}
+			input->AddEvent(events[i]);
+		}
+		input->Update();
+		controller->Frame(input, frameTime);
+
+		// Bit for bit the same spot.
+		position = camera->GetPosition();
+		rotation = camera->GetRotation();
+		if (memcmp(&position, &positions[frame], sizeof(XMFLOAT3)) != 0 || memcmp(&rotation, &rotations[frame], sizeof(XMFLOAT3)) != 0)
+		{
+			logChecked = false;
+		}
+	}
+	replayMilliseconds = timer.GetElapsedMilliseconds();
+	logChecked = logChecked && !log->ReadFrame(frameTime, events);
+
+	printf("input log    %d frames  %d events  %llu bytes (%.2f bytes a frame)  record %.3f ms  replay %.3f ms  %s\n", frames,
+		(int)recordedEvents.size(), log->GetSize(), (double)log->GetSize() / frames, recordMilliseconds, replayMilliseconds,
+		logChecked ? "checks passed" : "CHECKS FAILED");
+
+	// Draw the scene along the log twice, the two runs have to draw the same.
+	drawChecked = true;
+	for (i = 0; i < 2; i++)
+	{
+		visibleObjects[i] = 0.0;
+		triangles[i] = 0.0;
+		benchmark = new BenchmarkClass;
+		if (!benchmark)
+		{
+			drawChecked = false;
+			break;
+		}
+		result = benchmark->Initialize(drawnFrames, 0, 1, drawnObjects, 0, true) && benchmark->SetReplay(logFile) && benchmark->Run();
+		if (result)
+		{
+			visibleObjects[i] = benchmark->GetMeanVisibleObjects();
+			triangles[i] = benchmark->GetMeanTriangles();
+		}
+		else
+		{
+			drawChecked = false;
+		}
+		benchmark->Shutdown();
+		delete benchmark;
+		benchmark = 0;
+	}
+	drawChecked = drawChecked && visibleObjects[0] == visibleObjects[1] && triangles[0] == triangles[1];
+
+	printf("replay draw  %d frames  %.2f of %d objects visible  %.0f triangles a frame  %s\n", drawnFrames, visibleObjects[0], drawnObjects,
+		triangles[0], drawChecked ? "checks passed" : "CHECKS FAILED");
+
+	passed = logChecked && drawChecked;
+
+	file = fopen(outputFile, "w");
+	if (file)
+	{
+		fprintf(file, "{\n  \"frames\": %d,\n  \"events\": %d,\n  \"log_bytes\": %llu,\n  \"bytes_per_frame\": %.3f,\n", frames,
+			(int)recordedEvents.size(), log->GetSize(), (double)log->GetSize() / frames);
+		fprintf(file, "  \"record_ms\": %.4f,\n  \"replay_ms\": %.4f,\n  \"mean_visible_objects\": %.3f,\n  \"mean_triangles\": %.1f,\n",
+			recordMilliseconds, replayMilliseconds, visibleObjects[0], triangles[0]);
+		fprintf(file, "  \"checks_passed\": %s\n}\n", passed ? "true" : "false");
+		fclose(file);
+	}
+	else
+	{
+		printf("Could not open %s\n", outputFile);
+		passed = false;
+	}
+
+	controller->Shutdown();
+	delete controller;
+	controller = 0;
+	delete camera;
+	camera = 0;
+	delete input;
+	input = 0;
+	delete log;
+	log = 0;
+
+	if (!passed)
+	{
+		printf("The replay checks failed.\n");
+	}
+
+	ProfilerClass::Shutdown();
+
+	return passed ? 0 : 1;
+}
+
+/*RunSceneBenchmark builds scene graphs and times their updates, see the scene suite above. Every update runs a few
+times and the fastest run counts, a run marks its nodes dirty again before the clock starts.*/
+static int RunSceneBenchmark(int argc, char** argv)
+{
+	const int childCount = 8;
+	const int repeats = 5;
+	const char* scenarioNames[] = { "root turned", "1% moved", "still" };
+	const int scenarioCount = sizeof(scenarioNames) / sizeof(scenarioNames[0]);
+	vector<int> counts, handles, parents, stack, moved;
+	vector<unsigned char> affected;
+	vector<XMFLOAT4X4> reference;
+	JobSystemClass* jobSystem;
+	SceneGraphClass* scene;
+	SceneStatisticsType statistics;
+	XMFLOAT4 rotation;
+	TimerClass timer;
+	const char* outputFile;
+	unsigned int random;
+	int threads, count, countIndex, scenario, parallel, repeat, i, child, node, expected, levels;
+	double buildMilliseconds, best, elapsed, milliseconds[2], error, maxError;
+	bool passed, checked, firstResult;
+	FILE* file;
+
+	outputFile = GetArgument(argc, argv, "-output", "scene.json");
+
+	count = atoi(GetArgument(argc, argv, "-nodes", "0"));
+	if (count > 0)
+	{
+		counts.push_back(count);
+	}
+	else
+	{
+		counts.push_back(100000);
+		counts.push_back(1000000);
+	}
+
+	// Every core, but at least two threads so the parallel update is checked on any machine.
+	threads = atoi(GetArgument(argc, argv, "-threads", "0"));
+	if (threads < 1)
+	{
+		threads = (int)thread::hardware_concurrency();
+		if (threads < 2)
+		{
+			threads = 2;
+		}
+	}
+
+	jobSystem = new JobSystemClass;
+	if (!jobSystem || !jobSystem->Initialize(threads - 1))
+	{
+		printf("Could not start the job system\n");
+		return 1;
+	}
+
+	file = fopen(outputFile, "w");
+	if (!file)
+	{
+		printf("Could not open %s\n", outputFile);
+		jobSystem->Shutdown();
+		delete jobSystem;
+		return 1;
+	}
+
+	printf("%d cores, %d threads\n", (int)thread::hardware_concurrency(), threads);
+	fprintf(file, "{\n  \"cores\": %d,\n  \"threads\": %d,\n  \"units\": \"ms\",\n  \"results\": [\n", (int)thread::hardware_concurrency(), threads);
+
+	passed = true;
+	firstResult = true;
+	for (countIndex = 0; countIndex < (int)counts.size(); countIndex++)
+	{
+		count = counts[countIndex];
+
+		scene = new SceneGraphClass;
+		if (!scene)
+		{
+			passed = false;
+			break;
+		}
+		scene->Initialize(count);
+
+		/*Node n of the tree has the children n * 8 + 1 up to n * 8 + 8. They are added depth first, every subtree whole
+		before the next one, so the levels are all mixed up until the scene sorts them.*/
+		handles.assign(count, -1);
+		parents.assign(count, -1);
+		stack.clear();
+		stack.push_back(0);
+		random = 777;
+		timer.Start();
+		while (!stack.empty())
+		{
+			node = stack.back();
+			stack.pop_back();
+
+			random = random * 1664525 + 1013904223;
+			XMStoreFloat4(&rotation, XMQuaternionRotationRollPitchYaw((float)(random >> 8) / 16777216.0f, (float)(random & 255) / 256.0f, 0.1f));
+			handles[node] = scene->AddNode(node == 0 ? -1 : handles[(node - 1) / childCount], XMFLOAT3((float)(node % 7) - 3.0f,
+				(float)(node % 5) * 0.5f, 1.0f), rotation, XMFLOAT3(1.0f, 1.0f, 1.0f));
+			if (node > 0)
+			{
+				parents[handles[node]] = handles[(node - 1) / childCount];
+			}
+
+			for (child = childCount; child >= 1; child--)
+			{
+				if ((long long)node * childCount + child < count)
+				{
+					stack.push_back(node * childCount + child);
+				}
+			}
+		}
+		scene->Update(jobSystem);
+		buildMilliseconds = timer.GetElapsedMilliseconds();
+		levels = scene->GetLevelCount();
+
+		maxError = GetSceneError(scene, reference);
+		checked = maxError < 1.0e-4 && scene->GetStatistics().updatedNodes == count;
+		if (!checked)
+		{
+			passed = false;
+		}
+		printf("%8d nodes  %d levels  built and sorted in %8.3f ms  max error %.2g  %s\n", count, levels, buildMilliseconds, maxError,
+			checked ? "checks passed" : "CHECKS FAILED");
+
+		for (scenario = 0; scenario < scenarioCount; scenario++)
+		{
+			// The nodes that move: the root, 1% picked at random or none.
+			moved.clear();
+			if (scenario == 0)
+			{
+				moved.push_back(handles[0]);
+			}
+			else if (scenario == 1)
+			{
+				for (i = 0; i < count / 100; i++)
+				{
+					random = random * 1664525 + 1013904223;
+					moved.push_back((int)((random >> 4) % (unsigned int)count));
+				}
+			}
+
+			// A node is rebuilt when it moved or something above it did, the handles have the parents first.
+			affected.assign(count, 0);
+			for (i = 0; i < (int)moved.size(); i++)
+			{
+				affected[moved[i]] = 1;
+			}
+			expected = 0;
+			for (i = 0; i < count; i++)
+			{
+				if (parents[i] >= 0 && affected[parents[i]])
+				{
+					affected[i] = 1;
+				}
+				expected += affected[i];
+			}
+
+			checked = true;
+			maxError = 0.0;
+			for (parallel = 0; parallel < 2; parallel++)
+			{
+				best = 0.0;
+				for (repeat = 0; repeat < repeats; repeat++)
+				{
+					XMStoreFloat4(&rotation, XMQuaternionRotationRollPitchYaw(0.1f, (float)(parallel * repeats + repeat) * 0.01f, 0.0f));
+					for (i = 0; i < (int)moved.size(); i++)
+					{
+						scene->SetRotation(moved[i], rotation);
+					}
+
+					timer.Start();
+					scene->Update(parallel ? jobSystem : 0);
+					elapsed = timer.GetElapsedMilliseconds();
+					if (repeat == 0 || elapsed < best)
+					{
+						best = elapsed;
+					}
+
+					statistics = scene->GetStatistics();
+					if (statistics.updatedNodes != expected || (scenario == 2 && statistics.skippedLevels != levels))
+					{
+						checked = false;
+					}
+				}
+				milliseconds[parallel] = best;
+
+				error = GetSceneError(scene, reference);
+				if (error > maxError)
+				{
+					maxError = error;
+				}
+			}
+			if (maxError > 1.0e-4)
+			{
+				checked = false;
+			}
+			if (!checked)
+			{
+				passed = false;
+			}
+
+			printf("%8d nodes  %-11s  %8d rebuilt  %d of %d levels skipped  1 thread %8.3f ms  %d threads %8.3f ms  %5.2fx  max error %.2g  %s\n",
+				count, scenarioNames[scenario], expected, statistics.skippedLevels, levels, milliseconds[0], threads, milliseconds[1],
+				milliseconds[1] > 0.0 ? milliseconds[0] / milliseconds[1] : 0.0, maxError, checked ? "checks passed" : "CHECKS FAILED");
+			fprintf(file, "%s    { \"nodes\": %d, \"levels\": %d, \"scenario\": \"%s\", \"rebuilt\": %d, \"skipped_levels\": %d, \"build_ms\": %.4f, \"serial_ms\": %.4f, \"parallel_ms\": %.4f, \"max_error\": %.3g, \"checks_passed\": %s }",
+				firstResult ? "" : ",\n", count, levels, scenarioNames[scenario], expected, statistics.skippedLevels, buildMilliseconds,
+				milliseconds[0], milliseconds[1], maxError, checked ? "true" : "false");
+			firstResult = false;
+		}
+
+		scene->Shutdown();
+		delete scene;
+		scene = 0;
+	}
+
+	fprintf(file, "\n  ]\n}\n");
+	fclose(file);
+
+	jobSystem->Shutdown();
+	delete jobSystem;
+	jobSystem = 0;
+
+	if (!passed)
+	{
+		printf("The scene checks failed.\n");
+	}
+
+	ProfilerClass::Shutdown();
+
+	return passed ? 0 : 1;
+}
+
+/*GetVertexFormatMask turns the shader defines of a vertex format into the variant mask of the shader archive.*/
+static unsigned int GetVertexFormatMask(ShaderArchiveClass* shaderArchive, const VertexFormatType& format)
+{
+	vector<RenderShaderDefine> defines;
+	unsigned int mask;
+	size_t i;
+
+	VertexFormatClass::GetShaderDefines(format, defines);
+
+	mask = 0;
+	for (i = 0; defines[i].Name; i++)
+	{
+		if (strcmp(defines[i].Definition, "1") == 0)
+		{
+			mask |= shaderArchive->GetOption(defines[i].Name);
+		}
+	}
+
+	return mask;
+}
+
+/*IsSameReflection compares two reflections field by field.*/
+static bool IsSameReflection(const RenderShaderReflection& first, const RenderShaderReflection& second)
+{
+	size_t i, j;
+
+	if (first.constantBuffers.size() != second.constantBuffers.size() || first.inputs.size() != second.inputs.size())
+	{
+		return false;
+	}
+
+	for (i = 0; i < first.constantBuffers.size(); i++)
+	{
+		if (first.constantBuffers[i].name != second.constantBuffers[i].name || first.constantBuffers[i].slot != second.constantBuffers[i].slot ||
+			first.constantBuffers[i].size != second.constantBuffers[i].size ||
+			first.constantBuffers[i].variables.size() != second.constantBuffers[i].variables.size())
+		{
+			return false;
+		}
+		for (j = 0; j < first.constantBuffers[i].variables.size(); j++)
+		{
+			if (first.constantBuffers[i].variables[j].name != second.constantBuffers[i].variables[j].name ||
+				first.constantBuffers[i].variables[j].offset != second.constantBuffers[i].variables[j].offset ||
+				first.constantBuffers[i].variables[j].size != second.constantBuffers[i].variables[j].size)
+			{
+				return false;
+			}
+		}
+	}
+
+	for (i = 0; i < first.inputs.size(); i++)
+	{
+		if (first.inputs[i].semanticName != second.inputs[i].semanticName || first.inputs[i].semanticIndex != second.inputs[i].semanticIndex ||
+			first.inputs[i].componentCount != second.inputs[i].componentCount || first.inputs[i].componentType != second.inputs[i].componentType)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/*GetMeshBounds finds the center and half size of the box around the vertices, the way the importer does.*/
+static void GetMeshBounds(const vector<MeshVertexType>& vertices, XMFLOAT3& center, XMFLOAT3& extents)
+{
+	XMFLOAT3 minimum, maximum;
+	size_t i;
+
+	minimum = XMFLOAT3(0.0f, 0.0f, 0.0f);
+	maximum = XMFLOAT3(0.0f, 0.0f, 0.0f);
+	for (i = 0; i < vertices.size(); i++)
+	{
+		if (i == 0)
+		{
+			minimum = vertices[i].position;
+			maximum = vertices[i].position;
+		}
+
+		minimum.x = min(minimum.x, vertices[i].position.x);
+		minimum.y = min(minimum.y, vertices[i].position.y);
+		minimum.z = min(minimum.z, vertices[i].position.z);
+		maximum.x = max(maximum.x, vertices[i].position.x);
+		maximum.y = max(maximum.y, vertices[i].position.y);
+		maximum.z = max(maximum.z, vertices[i].position.z);
+	}
+
+	center = XMFLOAT3((minimum.x + maximum.x) * 0.5f, (minimum.y + maximum.y) * 0.5f, (minimum.z + maximum.z) * 0.5f);
+	extents = XMFLOAT3((maximum.x - minimum.x) * 0.5f, (maximum.y - minimum.y) * 0.5f, (maximum.z - minimum.z) * 0.5f);
+
+	return;
+}
+
+/*GetSortedTriangles lists the corner positions of every triangle, each triangle starting at its smallest corner so
+the winding is kept, and sorts the triangles. Two meshes with the same list have the same triangles in any order.*/
+static void GetSortedTriangles(const vector<MeshVertexType>& vertices, const vector<unsigned int>& indices, vector<XMFLOAT3>& triangles)
+{
+	struct TriangleType
+	{
+		XMFLOAT3 corners[3];
+
+		bool operator<(const TriangleType& other) const
+		{
+			return memcmp(corners, other.corners, sizeof(corners)) < 0;
+		}
+	};
+	vector<TriangleType> sorted;
+	TriangleType triangle;
+	size_t i;
+	int first, corner;
+
+	sorted.resize(indices.size() / 3);
+	for (i = 0; i < sorted.size(); i++)
+	{
+		first = 0;
+		for (corner = 1; corner < 3; corner++)
+		{
+			if (memcmp(&vertices[indices[i * 3 + corner]].position, &vertices[indices[i * 3 + first]].position, sizeof(XMFLOAT3)) < 0)
+			{
+				first = corner;
+			}
+		}
+
+		for (corner = 0; corner < 3; corner++)
+		{
+			triangle.corners[corner] = vertices[indices[i * 3 + (first + corner) % 3]].position;
+		}
+		sorted[i] = triangle;
+	}
+
+	sort(sorted.begin(), sorted.end());
+
+	triangles.resize(sorted.size() * 3);
+	for (i = 0; i < sorted.size(); i++)
+	{
+		triangles[i * 3] = sorted[i].corners[0];
+		triangles[i * 3 + 1] = sorted[i].corners[1];
+		triangles[i * 3 + 2] = sorted[i].corners[2];
+	}
+
+	return;
+}
+
+/*MakeGridMesh makes a flat grid of colored squares, each split in two triangles, with at least the given number of
+triangles. The triangles go row by row, the order a simple exporter would write them in.*/
+static void MakeGridMesh(int triangleCount, vector<MeshVertexType>& vertices, vector<unsigned int>& indices)
+{
+	MeshVertexType vertex;
+	int size, x, z, corner;
+
+	size = (int)ceil(sqrt((double)triangleCount / 2.0));
+
+	vertices.clear();
+	for (z = 0; z <= size; z++)
+	{
+		for (x = 0; x <= size; x++)
+		{
+			vertex.position = XMFLOAT3((float)x * 0.1f, sinf((float)(x + z) * 0.05f), (float)z * 0.1f);
+			vertex.color = XMFLOAT4((float)x / (float)size, (float)z / (float)size, 0.5f, 1.0f);
+			vertices.push_back(vertex);
+		}
+	}
+
+	indices.clear();
+	for (z = 0; z < size; z++)
+	{
+		for (x = 0; x < size; x++)
+		{
+			corner = z * (size + 1) + x;
+			indices.push_back(corner);
+			indices.push_back(corner + size + 1);
+			indices.push_back(corner + 1);
+			indices.push_back(corner + 1);
+			indices.push_back(corner + size + 1);
+			indices.push_back(corner + size + 2);
+		}
+	}
+
+	MeshFileClass::GenerateNormals(vertices, indices);
+
+	return;
+}
+
+/*WriteGridObj writes a grid mesh as an OBJ file.*/
+static bool WriteGridObj(const char* filename, int triangleCount)
+{
+	vector<MeshVertexType> vertices;
+	vector<unsigned int> indices;
+
+	MakeGridMesh(triangleCount, vertices, indices);
+
+	return WriteObj(filename, vertices, indices);
+}
+
+/*WriteObj writes a mesh as an OBJ file with vertex colors. The importer flips z and the triangles, so they are flipped
+here too to get the same mesh back.*/
+static bool WriteObj(const char* filename, const vector<MeshVertexType>& vertices, const vector<unsigned int>& indices)
+{
+	size_t i;
+	FILE* file;
+
+	file = fopen(filename, "w");
+	if (!file)
+	{
+		return false;
+	}
+
+	fprintf(file, "# %d triangles\n", (int)indices.size() / 3);
+	for (i = 0; i < vertices.size(); i++)
+	{
+		fprintf(file, "v %.6f %.6f %.6f %.4f %.4f %.4f\n", vertices[i].position.x, vertices[i].position.y, -vertices[i].position.z,
+			vertices[i].color.x, vertices[i].color.y, vertices[i].color.z);
+	}
+
+	for (i = 0; i < indices.size(); i += 3)
+	{
+		fprintf(file, "f %u %u %u\n", indices[i] + 1, indices[i + 2] + 1, indices[i + 1] + 1);
+	}
+
+	return fclose(file) == 0;
+}
+
+/*WriteRleTga writes RGBA texels as a run length encoded 32 bit TGA file with the top row first. Two or more equal
+texels in a row become a run, everything else goes in raw packets, and no packet goes past the end of a row.*/
+static bool WriteRleTga(const char* filename, const vector<unsigned char>& texels, int width, int height)
+{
+	unsigned char header[18];
+	vector<unsigned char> data;
+	const unsigned int* row;
+	unsigned int texel;
+	int x, y, count, i;
+	FILE* file;
+	bool run, result;
+
+	memset(header, 0, sizeof(header));
+	header[2] = 10;
+	header[12] = (unsigned char)(width & 0xff);
+	header[13] = (unsigned char)(width >> 8);
+	header[14] = (unsigned char)(height & 0xff);
+	header[15] = (unsigned char)(height >> 8);
+	header[16] = 32;
+	header[17] = 0x28;
+
+	for (y = 0; y < height; y++)
+	{
+		row = (const unsigned int*)&texels[0] + (size_t)y * width;
+		x = 0;
+		while (x < width)
+		{
+			// Count the equal texels from here, a run of them is one packet.
+			count = 1;
+			while (x + count < width && count < 128 && row[x + count] == row[x])
+			{
+				count++;
+			}
+
+			run = count > 1;
+			if (!run)
+			{
+				// Otherwise collect texels until the next two equal ones.
+				while (x + count < width && count < 128 && (x + count + 1 >= width || row[x + count] != row[x + count + 1]))
+				{
+					count++;
+				}
+				data.push_back((unsigned char)(count - 1));
+			}
+			else
+			{
+				data.push_back((unsigned char)(0x80 | (count - 1)));
+			}
+
+			for (i = 0; i < (run ? 1 : count); i++)
+			{
+				texel = row[x + i];
+				data.push_back((unsigned char)(texel >> 16));
+				data.push_back((unsigned char)(texel >> 8));
+				data.push_back((unsigned char)texel);
+				data.push_back((unsigned char)(texel >> 24));
+			}
+			x += count;
+		}
+	}
+
+	file = fopen(filename, "wb");
+	if (!file)
+	{
+		return false;
+	}
+
+	result = fwrite(header, sizeof(header), 1, file) == 1 && fwrite(&data[0], data.size(), 1, file) == 1;
+
+	return fclose(file) == 0 && result;
+}
+
+/*DownsampleReference is the box filter of TextureFileClass::Downsample written out plainly, one texel and channel at a
+time.*/
+static void DownsampleReference(const unsigned char* source, int width, int height, unsigned char* destination)
+{
+	int outputWidth, outputHeight, x, y, x0, x1, y0, y1, channel;
+
+	outputWidth = width > 1 ? width / 2 : 1;
+	outputHeight = height > 1 ? height / 2 : 1;
+
+	for (y = 0; y < outputHeight; y++)
+	{
+		y0 = y * 2;
+		y1 = y0 + 1 < height ? y0 + 1 : y0;
+		for (x = 0; x < outputWidth; x++)
+		{
+			x0 = x * 2;
+			x1 = x0 + 1 < width ? x0 + 1 : x0;
+			for (channel = 0; channel < 4; channel++)
+			{
+				destination[((size_t)y * outputWidth + x) * 4 + channel] = (unsigned char)((source[((size_t)y0 * width + x0) * 4 + channel] +
+					source[((size_t)y0 * width + x1) * 4 + channel] + source[((size_t)y1 * width + x0) * 4 + channel] +
+					source[((size_t)y1 * width + x1) * 4 + channel] + 2) >> 2);
+			}
+		}
+	}
+
+	return;
+}
+
+/*WaitForReload makes the reloader look at the sources right away and runs empty frames until it has, swapping in a
+reloaded shader at the start of a frame the way Graphics::Frame does. It returns how many shaders were swapped in,
+the time from the call to the swap in latency, and keeps the longest time the start of a frame took in maxSwapTime.*/
+static int WaitForReload(ShaderReloaderClass* shaderReloader, ColorShaderClass*& colorShader, int& frames, double& maxSwapTime, double& latency)
+{
+	ColorShaderClass* reloadedShader;
+	TimerClass timer, frameTimer;
+	double elapsed;
+	int checks, swapped;
+	bool checked;
+
+	checks = shaderReloader->GetStatistics().checks;
+	swapped = 0;
+	latency = 0.0;
+
+	timer.Start();
+	shaderReloader->CheckNow();
+
+	// The reloader counts a check once its shader was handed over, so the frame after the count went up has it.
+	do
+	{
+		checked = shaderReloader->GetStatistics().checks > checks;
+
+		frameTimer.Start();
+		reloadedShader = shaderReloader->GetReloadedShader();
+		if (reloadedShader)
+		{
+			colorShader->Shutdown();
+			delete colorShader;
+			colorShader = reloadedShader;
+		}
+		elapsed = frameTimer.GetElapsedMilliseconds();
+
+		if (reloadedShader)
+		{
+			latency = timer.GetElapsedMilliseconds();
+			swapped++;
+		}
+		if (elapsed > maxSwapTime)
+		{
+			maxSwapTime = elapsed;
+		}
+		frames++;
+
+		this_thread::sleep_for(chrono::milliseconds(1));
+	} while (!checked && timer.GetElapsedMilliseconds() < 10000.0);
+
+	return swapped;
+}
+
+/*GetBoundDraws lists every draw of a headless command list with everything that is bound when it is drawn: the
+shaders, layout, topology, vertex and index buffers and constant ranges, followed by the draw call and its arguments.
+A command list that was executed starts with nothing bound and the state from before it comes back after it, the way
+Direct3D executes a command list, so a list that leaves out a bind ends up with a different draw.*/
+static void GetBoundDraws(const vector<HeadlessCommandType>& commands, vector<unsigned int>& draws)
+{
+	const int stateSize = 16;
+	unsigned int state[stateSize], savedState[stateSize];
+	const HeadlessCommandType* command;
+	size_t i, listEnd;
+	int j;
+
+	memset(state, 0, sizeof(state));
+	memset(savedState, 0, sizeof(savedState));
+	listEnd = 0;
+
+	for (i = 0; i < commands.size(); i++)
+	{
+		if (i == listEnd && listEnd != 0)
+		{
+			memcpy(state, savedState, sizeof(state));
+			listEnd = 0;
+		}
+
+		command = &commands[i];
+		switch (command->call)
+		{
+		case HEADLESS_EXECUTE_COMMAND_LIST:
+			memcpy(savedState, state, sizeof(state));
+			memset(state, 0, sizeof(state));
+			listEnd = i + 1 + command->arguments[0];
+			break;
+		case HEADLESS_SET_VERTEX_SHADER:
+			state[0] = command->objectId;
+			break;
+		case HEADLESS_SET_PIXEL_SHADER:
+			state[1] = command->objectId;
+			break;
+		case HEADLESS_SET_INPUT_LAYOUT:
+			state[2] = command->objectId;
+			break;
+		case HEADLESS_SET_TOPOLOGY:
+			state[3] = command->arguments[0] + 1;
+			break;
+		case HEADLESS_SET_VERTEX_BUFFER:
+			if (command->slot < 2)
+			{
+				state[4 + command->slot * 2] = command->objectId;
+				state[5 + command->slot * 2] = command->arguments[0];
+			}
+			break;
+		case HEADLESS_SET_INDEX_BUFFER:
+			state[8] = command->objectId;
+			state[9] = command->arguments[0];
+			break;
+		case HEADLESS_SET_CONSTANT_BUFFER:
+			if (command->slot < 2)
+			{
+				state[10 + command->slot * 3] = command->objectId;
+				state[11 + command->slot * 3] = command->arguments[0];
+				state[12 + command->slot * 3] = command->arguments[1];
+			}
+			break;
+		case HEADLESS_DRAW_INDEXED:
+		case HEADLESS_DRAW_INDEXED_INSTANCED:
+			for (j = 0; j < stateSize; j++)
+			{
+				draws.push_back(state[j]);
+			}
+			draws.push_back((unsigned int)command->call);
+			draws.push_back(command->arguments[0]);
+			draws.push_back(command->arguments[1]);
+			draws.push_back(command->arguments[2]);
+			break;
+		default:
+			break;
+		}
+	}
+
+	return;
+}
+
+/*RunJobChecks checks the ordering guarantees of the job system: a chain of jobs that each depend on the one before
+runs in order, the last job of a diamond runs after both jobs in the middle, which run after the first, and a main
+thread job that depends on another job runs on the main thread once that job is done.*/
+static bool RunJobChecks(JobSystemClass* jobSystem)
+{
+	const int chainLength = 100;
+	JobType* chain[chainLength];
+	JobType* diamond[4];
+	JobType* first;
+	JobType* mainThreadJob;
+	int chainOrder[chainLength], diamondOrder[4];
+	thread::id mainThreadId;
+	int i, repeat;
+	bool result;
+
+	result = true;
+
+	for (repeat = 0; repeat < 20; repeat++)
+	{
+		s_jobSequence = 0;
+
+		// The chain, submitted back to front so nothing but the dependencies keeps it in order.
+		for (i = 0; i < chainLength; i++)
+		{
+			chain[i] = jobSystem->CreateJob(SequenceJob, &chainOrder[i], 0);
+			if (i > 0)
+			{
+				jobSystem->AddDependency(chain[i], chain[i - 1]);
+			}
+		}
+		for (i = chainLength - 1; i >= 0; i--)
+		{
+			jobSystem->Submit(chain[i]);
+		}
+		jobSystem->Wait(chain[chainLength - 1]);
+
+		for (i = 0; i < chainLength; i++)
+		{
+			if (chainOrder[i] != i)
+			{
+				result = false;
+			}
+		}
+
+		// The diamond: 0 before 1 and 2, both before 3.
+		for (i = 0; i < 4; i++)
+		{
+			diamond[i] = jobSystem->CreateJob(SequenceJob, &diamondOrder[i], 0);
+		}
+		jobSystem->AddDependency(diamond[1], diamond[0]);
+		jobSystem->AddDependency(diamond[2], diamond[0]);
+		jobSystem->AddDependency(diamond[3], diamond[1]);
+		jobSystem->AddDependency(diamond[3], diamond[2]);
+		for (i = 3; i >= 0; i--)
+		{
+			jobSystem->Submit(diamond[i]);
+		}
+		jobSystem->Wait(diamond[3]);
+
+		if (diamondOrder[1] < diamondOrder[0] || diamondOrder[2] < diamondOrder[0] || diamondOrder[3] < diamondOrder[1] ||
+			diamondOrder[3] < diamondOrder[2])
+		{
+			result = false;
+		}
+
+		// A main thread job after a job that may run anywhere.
+		first = jobSystem->CreateJob(EmptyJob, 0, 0);
+		mainThreadJob = jobSystem->CreateMainThreadJob(ThreadIdJob, &mainThreadId);
+		jobSystem->AddDependency(mainThreadJob, first);
+		jobSystem->Submit(mainThreadJob);
+		jobSystem->Submit(first);
+		jobSystem->Wait(mainThreadJob);
+
+		if (mainThreadId != this_thread::get_id())
+		{
+			result = false;
+		}
+	}
+
+	if (!result)
+	{
+		printf("The job system ran jobs out of order or a main thread job on another thread.\n");
+	}
+
+	return result;
+}
+
+static void EmptyJob(void* data)
+{
+	return;
+}
+
+static void EmptyRange(void* data, int begin, int end)
+{
+	return;
+}
+
+/*SequenceJob writes the order the jobs ran in.*/
+static void SequenceJob(void* data)
+{
+	*(int*)data = s_jobSequence.fetch_add(1);
+
+	return;
+}
+
+static void ThreadIdJob(void* data)
+{
+	*(thread::id*)data = this_thread::get_id();
+
+	return;
+}
+
+/*BalanceRange does work that grows with the square of the item's index and adds the outcome to the item, so an item
+that is done twice or not at all comes out different.*/
+static void BalanceRange(void* data, int begin, int end)
+{
+	float* results;
+	float value;
+	int i, j, iterations;
+
+	results = (float*)data;
+
+	for (i = begin; i < end; i++)
+	{
+		iterations = 1 + (int)(((long long)i * i) >> 8);
+		value = 1.0f;
+		for (j = 0; j < iterations; j++)
+		{
+			value = value * 0.999999f + 0.5f;
+		}
+		results[i] += value;
+	}
+
+	return;
+}
+
+/*CheckSnapshot counts the objects of a snapshot that are not where they must be after its step, and before it, when
+every object started out at the angle of baseAngles at baseStep. The simulation adds up its angles in floats, so it is
+allowed to drift a little. A snapshot with objects from different steps in it would be off by a whole step.*/
+static int CheckSnapshot(const SimulationSnapshotType* snapshot, long long baseStep, const vector<float>& baseAngles)
+{
+	float spin, step;
+	size_t i;
+	int mismatches;
+
+	if (snapshot->angles.size() != baseAngles.size() || snapshot->previousAngles.size() != baseAngles.size())
+	{
+		return (int)baseAngles.size() + 1;
+	}
+
+	mismatches = 0;
+	for (i = 0; i < baseAngles.size(); i++)
+	{
+		spin = SimulationClass::GetSpin((int)i) * (float)SIMULATION_TIMESTEP;
+		step = (float)(snapshot->step - baseStep);
+		if (GetAngleDistance(snapshot->angles[i], baseAngles[i] + spin * step) > 0.001f)
+		{
+			mismatches++;
+		}
+		else if (snapshot->step > baseStep && GetAngleDistance(snapshot->previousAngles[i], baseAngles[i] + spin * (step - 1.0f)) > 0.001f)
+		{
+			mismatches++;
+		}
+	}
+
+	return mismatches;
+}
+
+/*GetAngleDistance returns how far apart two angles are the short way around, whatever turn each of them is in.*/
+static float GetAngleDistance(float first, float second)
+{
+	const float twoPi = 6.28318531f;
+	float distance;
+
+	distance = fmodf(fabsf(first - second), twoPi);
+
+	return min(distance, twoPi - distance);
+}
+
+/*GetSceneError works out the world matrix of every node of the scene from its parent's, in the order of the handles
+which have the parents first, and returns the largest difference to the world matrices of the scene.*/
+static double GetSceneError(SceneGraphClass* scene, vector<XMFLOAT4X4>& reference)
+{
+	XMMATRIX worldMatrix;
+	XMFLOAT3 position, scale;
+	XMFLOAT4 rotation;
+	const XMFLOAT4X4* sceneMatrix;
+	double error, maxError;
+	int count, node, parent, element;
+
+	count = scene->GetNodeCount();
+	reference.resize(count);
+	maxError = 0.0;
+	for (node = 0; node < count; node++)
+	{
+		position = scene->GetPosition(node);
+		rotation = scene->GetRotation(node);
+		scale = scene->GetScale(node);
+		worldMatrix = XMMatrixMultiply(XMMatrixMultiply(XMMatrixScaling(scale.x, scale.y, scale.z), XMMatrixRotationQuaternion(XMLoadFloat4(&rotation))),
+			XMMatrixTranslation(position.x, position.y, position.z));
+		parent = scene->GetParent(node);
+		if (parent >= 0)
+		{
+			worldMatrix = XMMatrixMultiply(worldMatrix, XMLoadFloat4x4(&reference[parent]));
+		}
+		XMStoreFloat4x4(&reference[node], worldMatrix);
+
+		sceneMatrix = &scene->GetWorldMatrix(node);
+		for (element = 0; element < 16; element++)
+		{
+			error = fabs((double)(&sceneMatrix->_11)[element] - (double)(&reference[node]._11)[element]);
+			error /= 1.0 + fabs((double)(&reference[node]._11)[element]);
+			if (error > maxError)
+			{
+				maxError = error;
+			}
+		}
+	}
+
+	return maxError;
+}
+
+/*ReadTextFile reads a whole file into a string.*/
+static bool ReadTextFile(const char* filename, string& text)
+{
+	FILE* file;
+	char buffer[4096];
+	size_t count;
+
+	file = fopen(filename, "rb");
+	if (!file)
+	{
+		return false;
+	}
+
+	text.clear();
+	while ((count = fread(buffer, 1, sizeof(buffer), file)) > 0)
+	{
+		text.append(buffer, count);
+	}
+	fclose(file);
+
+	return true;
+}
+
+/*WriteTextFile replaces a file with the string.*/
+static bool WriteTextFile(const char* filename, const string& text)
+{
+	FILE* file;
+	size_t count;
+
+	file = fopen(filename, "wb");
+	if (!file)
+	{
+		return false;
+	}
+
+	count = fwrite(text.data(), 1, text.size(), file);
+	fclose(file);
+
+	return count == text.size();
+}
+
+/*GetFileSize returns the size of a file in bytes, or 0 when it can't be opened.*/
+static long GetFileSize(const char* filename)
+{
+	long size;
+	FILE* file;
+
+	file = fopen(filename, "rb");
+	if (!file)
+	{
+		return 0;
+	}
+
+	fseek(file, 0, SEEK_END);
+	size = ftell(file);
+	fclose(file);
+
+	return size;
+}
+
+/*GetArgument returns the value after an option or the default when the option isn't there.*/
+static const char* GetArgument(int argc, char** argv, const char* name, const char* defaultValue)
+{
+	int i;
+
+	for (i = 1; i < argc - 1; i++)
+	{
+		if (strcmp(argv[i], name) == 0)
+		{
+			return argv[i + 1];
+		}
+	}
+
+	return defaultValue;
+}
+
+static bool HasArgument(int argc, char** argv, const char* name)
+{
+	int i;
+
+	for (i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], name) == 0)
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
@@ -0,0 +1,287 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: main.cpp
+////////////////////////////////////////////////////////////////////////////////
+/*The ShaderBuild project is a console program that compiles every variant of a set of shaders into a shader archive,
+see ShaderArchiveClass. The game project runs it before it is built:
+
+ShaderBuild description archive [-headless] [-force] [-reflection] [-threads N]
+
+It reads the permutation description, compiles every valid variant of every stage on -threads threads (all of the
+processor by default) and writes them into the archive. When the archive is already up to date with the description
+and its sources nothing is compiled, unless -force is given. The shaders are compiled with the D3DCompiler, or with
+the headless device when -headless is given or there is no Direct3D, for archives the benchmarks use. Compile errors
+are written the way the compiler writes them so Visual Studio lists them, and the program returns 1.
+
+The headless device can't compile, it takes the reflection of a shader from a fixture next to its source. With
+-reflection the archive is built with the D3DCompiler even when it is up to date, and the reflection of every variant
+is written into the fixtures, color_vs.reflection for color_vs.hlsl. Run it again when a shader changes.*/
+#ifdef _WIN32
+#include "D3d.h"
+#endif
+#include "headlessdeviceclass.h"
+#include "jobsystemclass.h"
+#include "profilerclass.h"
+#include "shaderarchiveclass.h"
+#include "timerclass.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <map>
+#include <string>
+using namespace std;
+
+
+///////////////////////
+// FUNCTION PROTOTYPES //
+///////////////////////
+static const char* GetArgument(int, char**, const char*, const char*);
+static bool HasArgument(int, char**, const char*);
+static bool WriteReflectionFixtures(RenderDeviceClass*, ShaderArchiveClass*, const char*, string&);
+
+
+int main(int argc, char** argv)
+{
+	RenderDeviceClass* device;
+	JobSystemClass* jobSystem;
+	ShaderArchiveClass* shaderArchive;
+	TimerClass timer;
+	string errors;
+	int threadCount;
+	bool result;
+
+	if (argc < 3 || argv[1][0] == '-' || argv[2][0] == '-')
+	{
+		printf("ShaderBuild description archive [-headless] [-force] [-threads N]\n");
+		return 1;
+	}
+
+	/*Compiling doesn't need a video card, so the device is never initialized. Only its compiler and reflection are used.*/
+#ifdef _WIN32
+	if (HasArgument(argc, argv, "-headless"))
+	{
+		device = new HeadlessDeviceClass;
+	}
+	else
+	{
+		device = new D3d;
+	}
+#else
+	device = new HeadlessDeviceClass;
+#endif
+	if (!device)
+	{
+		return 1;
+	}
+
+	// Fixtures written by the headless device would only repeat the fixtures it read.
+	if (HasArgument(argc, argv, "-reflection") && strncmp(device->GetShaderCompiler(), "headless", 8) == 0)
+	{
+		fprintf(stderr, "%s: error: -reflection needs the D3DCompiler\n", argv[1]);
+		delete device;
+		device = 0;
+		return 1;
+	}
+
+	if (!HasArgument(argc, argv, "-force") && !HasArgument(argc, argv, "-reflection") && ShaderArchiveClass::IsCurrent(device, argv[1], argv[2]))
+	{
+		printf("%s is up to date\n", argv[2]);
+		delete device;
+		device = 0;
+		return 0;
+	}
+
+	// The calling thread compiles as well, so the job system gets one thread less than asked for.
+	jobSystem = new JobSystemClass;
+	if (!jobSystem)
+	{
+		return 1;
+	}
+	threadCount = atoi(GetArgument(argc, argv, "-threads", "0"));
+	if (threadCount < 1)
+	{
+		threadCount = (int)thread::hardware_concurrency();
+	}
+	result = jobSystem->Initialize(threadCount > 1 ? threadCount - 1 : 0);
+	if (!result)
+	{
+		return 1;
+	}
+
+	timer.Start();
+	result = ShaderArchiveClass::Build(device, jobSystem, argv[1], argv[2], errors);
+	if (!result)
+	{
+		fprintf(stderr, "%s", errors.c_str());
+	}
+	else
+	{
+		// Open the archive again to tell how many shaders ended up in it.
+		shaderArchive = new ShaderArchiveClass;
+		if (!shaderArchive)
+		{
+			return 1;
+		}
+		result = shaderArchive->Initialize(device, NULL, argv[1], argv[2], errors) && shaderArchive->IsArchived();
+		if (result)
+		{
+			printf("%s: %d shaders compiled on %d threads in %.0f ms\n", argv[2], shaderArchive->GetBlobCount(), jobSystem->GetThreadCount() + 1,
+				timer.GetElapsedMilliseconds());
+		}
+		else
+		{
+			fprintf(stderr, "%s%s: error: the archive that was just built could not be opened\n", errors.c_str(), argv[2]);
+		}
+
+		if (result && HasArgument(argc, argv, "-reflection"))
+		{
+			result = WriteReflectionFixtures(device, shaderArchive, argv[1], errors);
+			if (!result)
+			{
+				fprintf(stderr, "%s", errors.c_str());
+			}
+		}
+
+		shaderArchive->Shutdown();
+		delete shaderArchive;
+		shaderArchive = 0;
+	}
+
+	jobSystem->Shutdown();
+	delete jobSystem;
+	jobSystem = 0;
+
+	delete device;
+	device = 0;
+
+	ProfilerClass::Shutdown();
+
+	return result ? 0 : 1;
+}
+
+/*GetArgument returns the value after an option or the default when the option isn't there.*/
+static const char* GetArgument(int argc, char** argv, const char* name, const char* defaultValue)
+{
+	int i;
+
+	for (i = 1; i < argc - 1; i++)
+	{
+		if (strcmp(argv[i], name) == 0)
+		{
+			return argv[i + 1];
+		}
+	}
+
+	return defaultValue;
+}
+
+/*HasArgument tells whether an option without a value was given.*/
+static bool HasArgument(int argc, char** argv, const char* name)
+{
+	int i;
+
+	for (i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], name) == 0)
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/*WriteReflectionFixtures writes the reflection of every variant in the archive into the fixture of its source, the
+file with the extension replaced by .reflection, in the format the headless device reads (see its CompileShader).
+Stages that share a source share the fixture.*/
+static bool WriteReflectionFixtures(RenderDeviceClass* device, ShaderArchiveClass* shaderArchive, const char* descriptionFile, string& errors)
+{
+	const char* componentTypes[4] = { "unknown", "uint", "sint", "float" };
+	ShaderDescriptionType description;
+	vector<RenderShaderDefine> defines;
+	vector<char> bytecode;
+	RenderShaderReflection reflection;
+	map<string, string> fixtures;
+	map<string, string>::iterator fixture;
+	string fixtureFile, text;
+	char line[512];
+	unsigned int mask;
+	size_t position, i, j;
+	int stage;
+	FILE* file;
+
+	if (!ShaderArchiveClass::ReadDescription(descriptionFile, description, errors))
+	{
+		return false;
+	}
+
+	for (stage = 0; stage < (int)description.stages.size(); stage++)
+	{
+		position = description.stages[stage].filename.find_last_of('.');
+		if (position == string::npos || description.stages[stage].filename.find_first_of("/\\", position) != string::npos)
+		{
+			position = description.stages[stage].filename.size();
+		}
+		fixtureFile = description.stages[stage].filename.substr(0, position) + ".reflection";
+		if (fixtures.find(fixtureFile) == fixtures.end())
+		{
+			fixtures[fixtureFile] = "# The reflection of every variant of " + description.stages[stage].filename + " by " + device->GetShaderCompiler() +
+				", written by ShaderBuild -reflection.\n# The headless device reads it instead of compiling, run ShaderBuild -reflection again when the source changes.\n";
+		}
+
+		for (mask = 0; mask < (1u << description.options.size()); mask++)
+		{
+			if ((mask & ~description.stages[stage].optionMask) != 0 || !ShaderArchiveClass::IsValidVariant(description, mask))
+			{
+				continue;
+			}
+
+			if (!shaderArchive->GetShader(stage, mask, bytecode, reflection, errors))
+			{
+				return false;
+			}
+			shaderArchive->GetShaderDefines(stage, mask, defines);
+
+			text = "\nshader " + description.stages[stage].entryPoint + " " + description.stages[stage].profile;
+			for (i = 0; defines[i].Name; i++)
+			{
+				text += string(" ") + defines[i].Name + "=" + defines[i].Definition;
+			}
+			text += "\n";
+			for (i = 0; i < reflection.constantBuffers.size(); i++)
+			{
+				snprintf(line, sizeof(line), "cbuffer %s %u %u\n", reflection.constantBuffers[i].name.c_str(), reflection.constantBuffers[i].slot,
+					reflection.constantBuffers[i].size);
+				text += line;
+				for (j = 0; j < reflection.constantBuffers[i].variables.size(); j++)
+				{
+					snprintf(line, sizeof(line), "variable %s %u %u\n", reflection.constantBuffers[i].variables[j].name.c_str(),
+						reflection.constantBuffers[i].variables[j].offset, reflection.constantBuffers[i].variables[j].size);
+					text += line;
+				}
+			}
+			for (i = 0; i < reflection.inputs.size(); i++)
+			{
+				snprintf(line, sizeof(line), "input %s %u %u %s\n", reflection.inputs[i].semanticName.c_str(), reflection.inputs[i].semanticIndex,
+					reflection.inputs[i].componentCount, componentTypes[reflection.inputs[i].componentType]);
+				text += line;
+			}
+			fixtures[fixtureFile] += text;
+		}
+	}
+
+	for (fixture = fixtures.begin(); fixture != fixtures.end(); fixture++)
+	{
+		file = fopen(fixture->first.c_str(), "w");
+		if (!file)
+		{
+			errors = fixture->first + ": error: could not be written\n";
+			return false;
+		}
+		fputs(fixture->second.c_str(), file);
+		fclose(file);
+
+		printf("%s written\n", fixture->first.c_str());
+	}
+
+	return true;
+}
@@ -0,0 +1,590 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: benchmarkclass.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "benchmarkclass.h"
+#include "profilerclass.h"
+#include <algorithm>
+#include <fstream>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+
+/////////////
+// GLOBALS //
+/////////////
+/*The stages of FrameTimingType that get reported, in the order they happen in a frame.*/
+struct BenchmarkStageType
+{
+	const char* name;
+	double FrameTimingType::* member;
+};
+
+static const BenchmarkStageType BENCHMARK_STAGES[] =
+{
+	{ "total", &FrameTimingType::total },
+	{ "begin_scene", &FrameTimingType::beginScene },
+	{ "camera", &FrameTimingType::camera },
+	{ "object_transform", &FrameTimingType::objectTransform },
+	{ "cull", &FrameTimingType::cull },
+	{ "instance_upload", &FrameTimingType::instanceUpload },
+	{ "queue_submit", &FrameTimingType::queueSubmit },
+	{ "constant_upload", &FrameTimingType::constantUpload },
+	{ "queue_sort", &FrameTimingType::queueSort },
+	{ "queue_execute", &FrameTimingType::queueExecute },
+	{ "end_scene", &FrameTimingType::endScene }
+};
+
+/*Stages whose baseline is below this many milliseconds are too close to the resolution of the clock to compare.*/
+static const double BENCHMARK_NOISE_FLOOR = 0.0005;
+
+/*The frame time histogram uses doubling buckets starting at one microsecond, the last bucket catches everything slower.*/
+static const int HISTOGRAM_BUCKETS = 20;
+
+
+BenchmarkClass::BenchmarkClass()
+{
+	m_JobSystem = 0;
+	m_Graphics = 0;
+	m_Input = 0;
+	m_InputLog = 0;
+	m_CameraController = 0;
+	m_frameCount = 0;
+	m_warmupFrames = 0;
+	m_instanceCount = 0;
+	m_objectCount = 0;
+	m_visibleObjects = 0.0;
+	m_triangles = 0.0;
+	m_fullTriangles = 0.0;
+}
+
+BenchmarkClass::BenchmarkClass(const BenchmarkClass& other)
+{
+}
+
+BenchmarkClass::~BenchmarkClass()
+{
+}
+
+/*Initialize creates the graphics object without a window, which makes it pick the headless device. The warm up frames
+are drawn before measuring starts so first touch allocations and cold caches don't end up in the results. The scene is
+a grid of instanceCount copies of the model drawn with one instanced draw, and objectCount copies that are drawn one
+by one. The model is the one of the engine unless a model file is given, drawn with or without levels of detail.*/
+bool BenchmarkClass::Initialize(int frameCount, int warmupFrames, int instanceCount, int objectCount, const char* modelFile, bool lodEnabled)
+{
+	int threadCount;
+	bool result;
+
+	m_frameCount = frameCount;
+	m_warmupFrames = warmupFrames;
+	m_instanceCount = instanceCount;
+	m_objectCount = objectCount;
+
+	// Create the job system object, with a thread for every core but this one like the game has.
+	m_JobSystem = new JobSystemClass;
+	if (!m_JobSystem)
+	{
+		return false;
+	}
+
+	threadCount = (int)thread::hardware_concurrency() - 1;
+	result = m_JobSystem->Initialize(threadCount > 0 ? threadCount : 0);
+	if (!result)
+	{
+		return false;
+	}
+
+	// Create the graphics object.
+	m_Graphics = new Graphics;
+	if (!m_Graphics)
+	{
+		return false;
+	}
+
+	// Initialize the graphics object on the headless device.
+	result = m_Graphics->Initialize(BENCHMARK_SCREEN_WIDTH, BENCHMARK_SCREEN_HEIGHT, NULL, m_JobSystem);
+	if (!result)
+	{
+		return false;
+	}
+
+	// Swap the model when another one was asked for.
+	if (modelFile)
+	{
+		result = m_Graphics->SetModel(modelFile);
+		if (!result)
+		{
+			return false;
+		}
+	}
+	m_Graphics->SetLodEnabled(lodEnabled);
+
+	// Fill the scene with the copies of the model.
+	m_Graphics->SetInstanceCount(m_instanceCount);
+	m_Graphics->SetObjectCount(m_objectCount);
+
+	// Reserve the timings up front so storing them doesn't allocate while measuring.
+	m_timings.reserve(m_frameCount);
+
+	return true;
+}
+
+void BenchmarkClass::Shutdown()
+{
+	// Release the replay objects.
+	if (m_CameraController)
+	{
+		m_CameraController->Shutdown();
+		delete m_CameraController;
+		m_CameraController = 0;
+	}
+
+	if (m_InputLog)
+	{
+		delete m_InputLog;
+		m_InputLog = 0;
+	}
+
+	if (m_Input)
+	{
+		delete m_Input;
+		m_Input = 0;
+	}
+
+	// Release the graphics object.
+	if (m_Graphics)
+	{
+		m_Graphics->Shutdown();
+		delete m_Graphics;
+		m_Graphics = 0;
+	}
+
+	// Release the job system object.
+	if (m_JobSystem)
+	{
+		m_JobSystem->Shutdown();
+		delete m_JobSystem;
+		m_JobSystem = 0;
+	}
+
+	return;
+}
+
+/*SetReplay loads an input log for the camera to follow, it is called after Initialize. It fails when the log can't be
+read or has no frames.*/
+bool BenchmarkClass::SetReplay(const char* filename)
+{
+	bool result;
+
+	m_InputLog = new InputLogClass;
+	if (!m_InputLog)
+	{
+		return false;
+	}
+
+	result = m_InputLog->Load(filename);
+	if (!result || m_InputLog->GetFrameCount() == 0)
+	{
+		return false;
+	}
+
+	m_Input = new Input;
+	if (!m_Input)
+	{
+		return false;
+	}
+	m_Input->Initialize();
+
+	m_CameraController = new CameraControllerClass;
+	if (!m_CameraController)
+	{
+		return false;
+	}
+
+	result = m_CameraController->Initialize(m_Graphics->GetCamera());
+	if (!result)
+	{
+		return false;
+	}
+
+	return true;
+}
+
+/*Run draws the warm up frames followed by the measured frames. Frame i always puts the camera at the same spot so two
+runs of the benchmark draw exactly the same thing.*/
+bool BenchmarkClass::Run()
+{
+	int i;
+	bool result;
+	FrameTimingType frameTiming;
+
+	m_timings.clear();
+	m_visibleObjects = 0.0;
+	m_triangles = 0.0;
+	m_fullTriangles = 0.0;
+
+	for (i = 0; i < m_warmupFrames + m_frameCount; i++)
+	{
+		// Only keep the profiler zones of the measured frames.
+		if (i == m_warmupFrames)
+		{
+			ProfilerClass::Reset();
+		}
+
+		// Put the camera where the script or the input log says it is for this frame.
+		if (m_InputLog)
+		{
+			result = ReplayFrame();
+			if (!result)
+			{
+				return false;
+			}
+		}
+		else
+		{
+			MoveCamera(i);
+		}
+
+		// Do the frame processing for the graphics object.
+		result = m_Graphics->Frame();
+		if (!result)
+		{
+			return false;
+		}
+
+		// Keep the timings once we are past the warm up.
+		if (i >= m_warmupFrames)
+		{
+			m_Graphics->GetFrameTiming(frameTiming);
+			m_timings.push_back(frameTiming);
+			m_visibleObjects += m_Graphics->GetCullStatistics().visible;
+			m_triangles += (double)m_Graphics->GetLodStatistics().triangles;
+			m_fullTriangles += (double)m_Graphics->GetLodStatistics().fullTriangles;
+		}
+	}
+
+	return true;
+}
+
+/*MoveCamera is the scripted camera path: a slow orbit around the model that also bobs up and down, always turned
+towards the middle of the scene.*/
+void BenchmarkClass::MoveCamera(int frame)
+{
+	float angle, positionX, positionY, positionZ, yaw;
+
+	angle = (float)frame * 0.01f;
+
+	positionX = sinf(angle) * 5.0f;
+	positionY = sinf(angle * 0.5f) * 1.5f;
+	positionZ = -cosf(angle) * 5.0f;
+
+	// Turn the camera so it looks back at the origin, in degrees like the rest of the camera class.
+	yaw = atan2f(-positionX, -positionZ) * 57.2957795f;
+
+	m_Graphics->GetCamera()->SetPosition(positionX, positionY, positionZ);
+	m_Graphics->GetCamera()->SetRotation(0.0f, yaw, 0.0f);
+
+	return;
+}
+
+/*ReplayFrame hands the next frame of the input log to the input and the camera controller. After the last frame the
+log, the input and the camera start over.*/
+bool BenchmarkClass::ReplayFrame()
+{
+	float frameTime;
+	size_t i;
+	bool result;
+
+	result = m_InputLog->ReadFrame(frameTime, m_replayEvents);
+	if (!result)
+	{
+		m_InputLog->Rewind();
+		m_Input->Initialize();
+		m_CameraController->Reset();
+
+		result = m_InputLog->ReadFrame(frameTime, m_replayEvents);
+		if (!result)
+		{
+			return false;
+		}
+	}
+
+	for (i = 0; i < m_replayEvents.size(); i++)
+	{
+		m_Input->AddEvent(m_replayEvents[i]);
+	}
+	m_Input->Update();
+	m_CameraController->Frame(m_Input, frameTime);
+
+	return true;
+}
+
+/*ComputeStatistics sorts the values and picks the percentiles with the nearest rank method.*/
+StageStatisticsType BenchmarkClass::ComputeStatistics(vector<double>& values)
+{
+	StageStatisticsType statistics;
+	double sum;
+	size_t i, count;
+
+	statistics.p50 = statistics.p95 = statistics.p99 = statistics.max = statistics.mean = 0.0;
+
+	count = values.size();
+	if (count == 0)
+	{
+		return statistics;
+	}
+
+	sort(values.begin(), values.end());
+
+	sum = 0.0;
+	for (i = 0; i < count; i++)
+	{
+		sum += values[i];
+	}
+
+	statistics.p50 = values[(size_t)ceil(0.50 * count) - 1];
+	statistics.p95 = values[(size_t)ceil(0.95 * count) - 1];
+	statistics.p99 = values[(size_t)ceil(0.99 * count) - 1];
+	statistics.max = values[count - 1];
+	statistics.mean = sum / (double)count;
+
+	return statistics;
+}
+
+/*GetStageStatistics summarizes one of the stages over all measured frames.*/
+StageStatisticsType BenchmarkClass::GetStageStatistics(int stage)
+{
+	vector<double> values;
+	size_t i;
+
+	values.reserve(m_timings.size());
+	for (i = 0; i < m_timings.size(); i++)
+	{
+		values.push_back(m_timings[i].*BENCHMARK_STAGES[stage].member);
+	}
+
+	return ComputeStatistics(values);
+}
+
+/*GetMeanVisibleObjects returns how many of the objects survived frustum culling per measured frame, on average.*/
+double BenchmarkClass::GetMeanVisibleObjects()
+{
+	if (m_timings.empty())
+	{
+		return 0.0;
+	}
+
+	return m_visibleObjects / (double)m_timings.size();
+}
+
+/*GetMeanTriangles returns how many triangles were drawn per measured frame on average, GetMeanFullTriangles how many
+it would have been without levels of detail.*/
+double BenchmarkClass::GetMeanTriangles()
+{
+	if (m_timings.empty())
+	{
+		return 0.0;
+	}
+
+	return m_triangles / (double)m_timings.size();
+}
+
+double BenchmarkClass::GetMeanFullTriangles()
+{
+	if (m_timings.empty())
+	{
+		return 0.0;
+	}
+
+	return m_fullTriangles / (double)m_timings.size();
+}
+
+/*GetRenderQueueStatistics returns the binds the render queue issued and left out in the last frame.*/
+RenderQueueStatisticsType BenchmarkClass::GetRenderQueueStatistics()
+{
+	return m_Graphics->GetRenderQueueStatistics();
+}
+
+int BenchmarkClass::GetStageCount()
+{
+	return sizeof(BENCHMARK_STAGES) / sizeof(BENCHMARK_STAGES[0]);
+}
+
+const char* BenchmarkClass::GetStageName(int stage)
+{
+	return BENCHMARK_STAGES[stage].name;
+}
+
+/*WriteResults writes the percentiles of every stage and a histogram of the total frame time to a JSON file.*/
+bool BenchmarkClass::WriteResults(const char* filename)
+{
+	ofstream fout;
+	StageStatisticsType statistics;
+	RenderQueueStatisticsType queueStatistics;
+	int i, bucket, counts[HISTOGRAM_BUCKETS];
+	size_t frame;
+	double upperBound;
+
+	fout.open(filename);
+	if (fout.fail())
+	{
+		return false;
+	}
+
+	fout.setf(ios::fixed);
+	fout.precision(6);
+
+	fout << "{\n";
+	fout << "  \"frames\": " << m_timings.size() << ",\n";
+	fout << "  \"warmup_frames\": " << m_warmupFrames << ",\n";
+	fout << "  \"instances\": " << m_instanceCount << ",\n";
+	fout << "  \"objects\": " << m_objectCount << ",\n";
+	fout << "  \"units\": \"ms\",\n";
+
+	// Write the percentiles of every stage.
+	fout << "  \"stages\": {\n";
+	for (i = 0; i < GetStageCount(); i++)
+	{
+		statistics = GetStageStatistics(i);
+
+		fout << "    \"" << GetStageName(i) << "\": { ";
+		fout << "\"p50\": " << statistics.p50 << ", ";
+		fout << "\"p95\": " << statistics.p95 << ", ";
+		fout << "\"p99\": " << statistics.p99 << ", ";
+		fout << "\"max\": " << statistics.max << ", ";
+		fout << "\"mean\": " << statistics.mean << " }";
+		fout << (i + 1 < GetStageCount() ? ",\n" : "\n");
+	}
+	fout << "  },\n";
+
+	// Count the total frame times into doubling buckets, starting at one microsecond.
+	for (i = 0; i < HISTOGRAM_BUCKETS; i++)
+	{
+		counts[i] = 0;
+	}
+
+	for (frame = 0; frame < m_timings.size(); frame++)
+	{
+		bucket = 0;
+		upperBound = 0.001;
+		while (m_timings[frame].total > upperBound && bucket < HISTOGRAM_BUCKETS - 1)
+		{
+			upperBound *= 2.0;
+			bucket++;
+		}
+		counts[bucket]++;
+	}
+
+	// Write the binds the render queue issued and left out in the last frame, they are the same every frame.
+	queueStatistics = m_Graphics->GetRenderQueueStatistics();
+	fout << "  \"render_queue\": { ";
+	fout << "\"commands\": " << queueStatistics.commands << ", ";
+	fout << "\"shader_binds\": " << queueStatistics.shaderBinds << ", \"shader_binds_elided\": " << queueStatistics.shaderBindsElided << ", ";
+	fout << "\"input_layout_binds\": " << queueStatistics.inputLayoutBinds << ", \"input_layout_binds_elided\": " << queueStatistics.inputLayoutBindsElided << ", ";
+	fout << "\"topology_binds\": " << queueStatistics.topologyBinds << ", \"topology_binds_elided\": " << queueStatistics.topologyBindsElided << ", ";
+	fout << "\"vertex_buffer_binds\": " << queueStatistics.vertexBufferBinds << ", \"vertex_buffer_binds_elided\": " << queueStatistics.vertexBufferBindsElided << ", ";
+	fout << "\"index_buffer_binds\": " << queueStatistics.indexBufferBinds << ", \"index_buffer_binds_elided\": " << queueStatistics.indexBufferBindsElided << ", ";
+	fout << "\"constant_buffer_binds\": " << queueStatistics.constantBufferBinds << ", \"constant_buffer_binds_elided\": " << queueStatistics.constantBufferBindsElided << ", ";
+	fout << "\"constant_bytes\": " << m_Graphics->GetConstantUsage() << " },\n";
+
+	// The camera moves, so the number of visible objects changes from frame to frame.
+	fout << "  \"culling\": { \"objects\": " << m_objectCount << ", \"visible_mean\": " << GetMeanVisibleObjects() << " },\n";
+
+	// And so does the level of detail of every draw.
+	fout << "  \"lod\": { \"triangles_mean\": " << GetMeanTriangles() << ", \"full_triangles_mean\": " << GetMeanFullTriangles() << " },\n";
+
+	fout << "  \"total_histogram\": [\n";
+	upperBound = 0.001;
+	for (i = 0; i < HISTOGRAM_BUCKETS; i++)
+	{
+		fout << "    { \"upper_ms\": " << (i + 1 < HISTOGRAM_BUCKETS ? upperBound : -1.0) << ", \"count\": " << counts[i] << " }";
+		fout << (i + 1 < HISTOGRAM_BUCKETS ? ",\n" : "\n");
+		upperBound *= 2.0;
+	}
+	fout << "  ]\n";
+	fout << "}\n";
+
+	fout.close();
+
+	return true;
+}
+
+/*ReadBaselineValue finds "stage": { ... "statistic": value ... } in a results file written by WriteResults. It is not a
+general JSON reader, it only has to understand the files we write ourselves.*/
+bool BenchmarkClass::ReadBaselineValue(const string& text, const char* stage, const char* statistic, double& value)
+{
+	size_t stagePosition, endPosition, valuePosition;
+
+	stagePosition = text.find(string("\"") + stage + "\"");
+	if (stagePosition == string::npos)
+	{
+		return false;
+	}
+
+	endPosition = text.find('}', stagePosition);
+	valuePosition = text.find(string("\"") + statistic + "\"", stagePosition);
+	if (valuePosition == string::npos || valuePosition > endPosition)
+	{
+		return false;
+	}
+
+	valuePosition = text.find(':', valuePosition);
+	value = atof(text.c_str() + valuePosition + 1);
+
+	return true;
+}
+
+/*CompareWithBaseline checks the p50 and p95 of every stage against the baseline file. A stage regresses when it got slower
+by more than the threshold (0.10 means 10 percent). Returns false when anything regressed, the report lists every comparison.*/
+bool BenchmarkClass::CompareWithBaseline(const char* filename, double threshold, string& report)
+{
+	ifstream fin;
+	string text;
+	StageStatisticsType statistics;
+	double baseline, current;
+	bool passed, regressed;
+	int i, j;
+	char line[256];
+	const char* statisticNames[2] = { "p50", "p95" };
+
+	fin.open(filename);
+	if (fin.fail())
+	{
+		report = string("Could not open baseline ") + filename + "\n";
+		return false;
+	}
+
+	text.assign(istreambuf_iterator<char>(fin), istreambuf_iterator<char>());
+	fin.close();
+
+	passed = true;
+	report.clear();
+
+	for (i = 0; i < GetStageCount(); i++)
+	{
+		statistics = GetStageStatistics(i);
+
+		for (j = 0; j < 2; j++)
+		{
+			if (!ReadBaselineValue(text, GetStageName(i), statisticNames[j], baseline))
+			{
+				continue;
+			}
+
+			current = (j == 0) ? statistics.p50 : statistics.p95;
+
+			// Stages that take next to no time are all noise, don't fail on them.
+			regressed = baseline >= BENCHMARK_NOISE_FLOOR && current > baseline * (1.0 + threshold);
+			if (regressed)
+			{
+				passed = false;
+			}
+
+			snprintf(line, sizeof(line), "%-18s %s baseline %10.6f ms current %10.6f ms %+7.1f%% %s\n", GetStageName(i), statisticNames[j],
+				baseline, current, baseline > 0.0 ? (current / baseline - 1.0) * 100.0 : 0.0, regressed ? "REGRESSED" : "ok");
+			report += line;
+		}
+	}
+
+	return passed;
+}
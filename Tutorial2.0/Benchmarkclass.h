@@ -0,0 +1,94 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: benchmarkclass.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _BENCHMARKCLASS_H_
+#define _BENCHMARKCLASS_H_
+
+
+//////////////
+// INCLUDES //
+//////////////
+#include <string>
+#include <vector>
+#include "graphics.h"
+#include "Input.h"
+#include "inputlogclass.h"
+#include "cameracontrollerclass.h"
+using namespace std;
+
+
+/////////////
+// GLOBALS //
+/////////////
+const int BENCHMARK_SCREEN_WIDTH = 800;
+const int BENCHMARK_SCREEN_HEIGHT = 600;
+
+
+/////////////
+// TYPEDEFS //
+/////////////
+/*The summary of one stage over all measured frames, in milliseconds.*/
+struct StageStatisticsType
+{
+	double p50;
+	double p95;
+	double p99;
+	double max;
+	double mean;
+};
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: BenchmarkClass
+////////////////////////////////////////////////////////////////////////////////
+/*The BenchmarkClass runs the graphics frame a fixed number of times on the headless device while moving the camera
+along a scripted path, so every run draws exactly the same frames. It keeps the stage timings of every frame, writes
+percentiles and a histogram of them to a JSON file and can compare a run against a stored baseline file.
+
+With SetReplay the camera follows a recorded input log instead of the script, see InputLogClass. Its events go through
+an Input and the CameraControllerClass with the recorded frame times, the way System::Frame moved the camera when it was
+recorded. A log with fewer frames than the benchmark starts over from the first frame with the camera back at the
+start.*/
+class BenchmarkClass
+{
+public:
+	BenchmarkClass();
+	BenchmarkClass(const BenchmarkClass&);
+	~BenchmarkClass();
+
+	bool Initialize(int, int, int, int, const char*, bool);
+	void Shutdown();
+	bool SetReplay(const char*);
+	bool Run();
+
+	bool WriteResults(const char*);
+	bool CompareWithBaseline(const char*, double, string&);
+
+	StageStatisticsType GetStageStatistics(int);
+	RenderQueueStatisticsType GetRenderQueueStatistics();
+	double GetMeanVisibleObjects();
+	double GetMeanTriangles();
+	double GetMeanFullTriangles();
+	static int GetStageCount();
+	static const char* GetStageName(int);
+
+private:
+	void MoveCamera(int);
+	bool ReplayFrame();
+	static StageStatisticsType ComputeStatistics(vector<double>&);
+	static bool ReadBaselineValue(const string&, const char*, const char*, double&);
+
+private:
+	JobSystemClass* m_JobSystem;
+	Graphics* m_Graphics;
+	Input* m_Input;
+	InputLogClass* m_InputLog;
+	CameraControllerClass* m_CameraController;
+	vector<InputEventType> m_replayEvents;
+	int m_frameCount, m_warmupFrames, m_instanceCount, m_objectCount;
+	vector<FrameTimingType> m_timings;
+	double m_visibleObjects;
+	double m_triangles, m_fullTriangles;
+};
+
+#endif
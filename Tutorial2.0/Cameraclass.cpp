@@ -2,6 +2,7 @@
 // Filename: cameraclass.cpp
 ////////////////////////////////////////////////////////////////////////////////
 #include "cameraclass.h"
+#include "profilerclass.h"
 
 /*The class constructor will initialize the position and rotation of the camera to be at the origin of the scene.*/
 CameraClass::CameraClass()
@@ -13,6 +14,11 @@ CameraClass::CameraClass()
 	m_rotationX = 0.0f;
 	m_rotationY = 0.0f;
 	m_rotationZ = 0.0f;
+
+	m_viewMatrix = XMMatrixIdentity();
+	m_projectionMatrix = XMMatrixIdentity();
+	m_viewProjectionMatrix = XMMatrixIdentity();
+	m_dirty = true;
 }
 
 
@@ -25,20 +31,40 @@ CameraClass::~CameraClass()
 {
 }
 
-/*The SetPosition and SetRotation functions are used for setting up the position and rotation of the camera.*/
+/*The SetPosition and SetRotation functions are used for setting up the position and rotation of the camera.
+Setting the same values again doesn't mark the matrices as changed.*/
 void CameraClass::SetPosition(float x, float y, float z)
 {
-	m_positionX = x;
-	m_positionY = y;
-	m_positionZ = z;
+	if (x != m_positionX || y != m_positionY || z != m_positionZ)
+	{
+		m_positionX = x;
+		m_positionY = y;
+		m_positionZ = z;
+		m_dirty = true;
+	}
+
 	return;
 }
 
 void CameraClass::SetRotation(float x, float y, float z)
 {
-	m_rotationX = x;
-	m_rotationY = y;
-	m_rotationZ = z;
+	if (x != m_rotationX || y != m_rotationY || z != m_rotationZ)
+	{
+		m_rotationX = x;
+		m_rotationY = y;
+		m_rotationZ = z;
+		m_dirty = true;
+	}
+
+	return;
+}
+
+/*SetProjectionMatrix gives the camera the projection of the device, the view-projection matrix is built from it.*/
+void CameraClass::SetProjectionMatrix(const XMMATRIX& projectionMatrix)
+{
+	m_projectionMatrix = projectionMatrix;
+	m_dirty = true;
+
 	return;
 }
 
@@ -57,14 +83,22 @@ XMFLOAT3 CameraClass::GetRotation()
 We first setup our variables for up, position, rotation, and so forth. Then at the origin of the scene we 
 first rotate the camera based on the x, y, and z rotation of the camera. Once it is properly rotated when then 
 translate the camera to the position in 3D space. With the correct values in the position, lookAt, and up we can 
-then use the D3DXMatrixLookAtLH function to create the view matrix to represent the current camera rotation and translation.*/
+then use the D3DXMatrixLookAtLH function to create the view matrix to represent the current camera rotation and translation.
+Nothing is rebuilt when the camera didn't change since the last call.*/
 void CameraClass::Render()
 {
+	PROFILE_FUNCTION();
+
 	XMFLOAT3 up, position, lookAt;
 	XMVECTOR upVector, positionVector, lookAtVector;
 	float yaw, pitch, roll;
 	XMMATRIX rotationMatrix;
 
+	if (!m_dirty)
+	{
+		return;
+	}
+
 	/*As the name says, it defines in which direction up is. Thats quite an important thing. 
 	You need to know the position of the camera, you need to know which direction its facing, but you also need to know how its turned  i.e.
 	what will be perceived as up and down, left and right.
@@ -112,6 +146,11 @@ void CameraClass::Render()
 	// Finally create the view matrix from the three updated vectors.
 	m_viewMatrix = XMMatrixLookAtLH(positionVector, lookAtVector, upVector);
 
+	// Combine it with the projection, most draws only need the two together.
+	m_viewProjectionMatrix = XMMatrixMultiply(m_viewMatrix, m_projectionMatrix);
+
+	m_dirty = false;
+
 	return;
 }
 
@@ -119,4 +158,16 @@ void CameraClass::GetViewMatrix(XMMATRIX& viewMatrix)
 {
 	viewMatrix = m_viewMatrix;
 	return;
+}
+
+void CameraClass::GetProjectionMatrix(XMMATRIX& projectionMatrix)
+{
+	projectionMatrix = m_projectionMatrix;
+	return;
+}
+
+void CameraClass::GetViewProjectionMatrix(XMMATRIX& viewProjectionMatrix)
+{
+	viewProjectionMatrix = m_viewProjectionMatrix;
+	return;
 }
\ No newline at end of file
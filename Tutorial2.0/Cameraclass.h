@@ -15,6 +15,8 @@ using namespace DirectX;
 ////////////////////////////////////////////////////////////////////////////////
 // Class name: CameraClass
 ////////////////////////////////////////////////////////////////////////////////
+/*The camera keeps the view, projection and view-projection matrices together. They are only rebuilt by Render when
+the position, rotation or projection changed since the last time, so a camera that stands still costs nothing.*/
 class CameraClass
 {
 public:
@@ -28,13 +30,20 @@ public:
 	XMFLOAT3 GetPosition();
 	XMFLOAT3 GetRotation();
 
+	void SetProjectionMatrix(const XMMATRIX&);
+
 	void Render();
 	void GetViewMatrix(XMMATRIX&);
+	void GetProjectionMatrix(XMMATRIX&);
+	void GetViewProjectionMatrix(XMMATRIX&);
 
 private:
 	float m_positionX, m_positionY, m_positionZ;
 	float m_rotationX, m_rotationY, m_rotationZ;
 	XMMATRIX m_viewMatrix;
+	XMMATRIX m_projectionMatrix;
+	XMMATRIX m_viewProjectionMatrix;
+	bool m_dirty;
 };
 
 #endif
@@ -0,0 +1,114 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: cameracontrollerclass.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "cameracontrollerclass.h"
+#include <math.h>
+
+CameraControllerClass::CameraControllerClass()
+{
+	m_Camera = 0;
+	m_startPosition = XMFLOAT3(0.0f, 0.0f, 0.0f);
+	m_startRotation = XMFLOAT3(0.0f, 0.0f, 0.0f);
+}
+
+CameraControllerClass::CameraControllerClass(const CameraControllerClass& other)
+{
+}
+
+CameraControllerClass::~CameraControllerClass()
+{
+}
+
+/*Initialize takes the camera and remembers where it is, Reset puts it back there.*/
+bool CameraControllerClass::Initialize(CameraClass* camera)
+{
+	if (!camera)
+	{
+		return false;
+	}
+
+	m_Camera = camera;
+	m_startPosition = m_Camera->GetPosition();
+	m_startRotation = m_Camera->GetRotation();
+
+	return true;
+}
+
+void CameraControllerClass::Shutdown()
+{
+	m_Camera = 0;
+
+	return;
+}
+
+void CameraControllerClass::Reset()
+{
+	m_Camera->SetPosition(m_startPosition.x, m_startPosition.y, m_startPosition.z);
+	m_Camera->SetRotation(m_startRotation.x, m_startRotation.y, m_startRotation.z);
+
+	return;
+}
+
+/*Frame turns and moves the camera for the keys that are down, by the frame time in seconds. Moving goes along the
+direction the camera is turned to, on the ground plane.*/
+void CameraControllerClass::Frame(Input* input, float frameTime)
+{
+	XMFLOAT3 position, rotation;
+	float forward, right, up, turn, yaw;
+
+	position = m_Camera->GetPosition();
+	rotation = m_Camera->GetRotation();
+
+	turn = 0.0f;
+	if (input->IsKeyDown(CAMERA_KEY_LEFT))
+	{
+		turn -= 1.0f;
+	}
+	if (input->IsKeyDown(CAMERA_KEY_RIGHT))
+	{
+		turn += 1.0f;
+	}
+
+	forward = 0.0f;
+	if (input->IsKeyDown('W') || input->IsKeyDown(CAMERA_KEY_UP))
+	{
+		forward += 1.0f;
+	}
+	if (input->IsKeyDown('S') || input->IsKeyDown(CAMERA_KEY_DOWN))
+	{
+		forward -= 1.0f;
+	}
+
+	right = 0.0f;
+	if (input->IsKeyDown('D'))
+	{
+		right += 1.0f;
+	}
+	if (input->IsKeyDown('A'))
+	{
+		right -= 1.0f;
+	}
+
+	up = 0.0f;
+	if (input->IsKeyDown('E'))
+	{
+		up += 1.0f;
+	}
+	if (input->IsKeyDown('Q'))
+	{
+		up -= 1.0f;
+	}
+
+	rotation.y += turn * CAMERA_TURN_SPEED * frameTime;
+
+	// The yaw in radians, like CameraClass::Render turns it.
+	yaw = rotation.y * 0.0174532925f;
+	position.x += (sinf(yaw) * forward + cosf(yaw) * right) * CAMERA_MOVE_SPEED * frameTime;
+	position.y += up * CAMERA_MOVE_SPEED * frameTime;
+	position.z += (cosf(yaw) * forward - sinf(yaw) * right) * CAMERA_MOVE_SPEED * frameTime;
+
+	m_Camera->SetPosition(position.x, position.y, position.z);
+	m_Camera->SetRotation(rotation.x, rotation.y, rotation.z);
+
+	return;
+}
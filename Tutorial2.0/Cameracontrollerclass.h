@@ -0,0 +1,53 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: cameracontrollerclass.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _CAMERACONTROLLERCLASS_H_
+#define _CAMERACONTROLLERCLASS_H_
+
+
+//////////////
+// INCLUDES //
+//////////////
+#include "cameraclass.h"
+#include "Input.h"
+
+
+/////////////
+// GLOBALS //
+/////////////
+/*How fast the camera moves in units a second and turns in degrees a second while its keys are held down.*/
+const float CAMERA_MOVE_SPEED = 4.0f;
+const float CAMERA_TURN_SPEED = 90.0f;
+/*The virtual key codes of the arrow keys, they turn the camera. W, A, S and D move it and Q and E move it down and up.*/
+const unsigned int CAMERA_KEY_LEFT = 0x25;
+const unsigned int CAMERA_KEY_UP = 0x26;
+const unsigned int CAMERA_KEY_RIGHT = 0x27;
+const unsigned int CAMERA_KEY_DOWN = 0x28;
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: CameraControllerClass
+////////////////////////////////////////////////////////////////////////////////
+/*The CameraControllerClass flies the camera around with the keyboard. Frame only looks at the key state of the Input
+and the frame time it is given, never at the clock, so the same input and frame times always move the camera the same
+way. That is what lets the InputLogClass replay a recorded run exactly.*/
+class CameraControllerClass
+{
+public:
+	CameraControllerClass();
+	CameraControllerClass(const CameraControllerClass&);
+	~CameraControllerClass();
+
+	bool Initialize(CameraClass*);
+	void Shutdown();
+	void Reset();
+
+	void Frame(Input*, float);
+
+private:
+	CameraClass* m_Camera;
+	XMFLOAT3 m_startPosition;
+	XMFLOAT3 m_startRotation;
+};
+
+#endif
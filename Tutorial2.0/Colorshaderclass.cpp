@@ -2,14 +2,27 @@
 // Filename: colorshaderclass.cpp
 ////////////////////////////////////////////////////////////////////////////////
 #include "colorshaderclass.h"
+#include "profilerclass.h"
+#include <string.h>
 
 /*As usual the class constructor initializes all the private pointers in the class to null.*/
 ColorShaderClass::ColorShaderClass()
 {
+	m_device = 0;
 	m_vertexShader = 0;
 	m_pixelShader = 0;
 	m_layout = 0;
-	m_matrixBuffer = 0;
+	m_instanceVertexShader = 0;
+	m_instanceLayout = 0;
+	m_frameBuffer = 0;
+	m_objectBuffer = 0;
+	m_frameOffset = 0;
+	m_frameSize = 0;
+	memset(&m_frameBinding, 0, sizeof(m_frameBinding));
+	memset(&m_objectBinding, 0, sizeof(m_objectBinding));
+	memset(&m_viewParameter, 0, sizeof(m_viewParameter));
+	memset(&m_projectionParameter, 0, sizeof(m_projectionParameter));
+	memset(&m_worldViewProjectionParameter, 0, sizeof(m_worldViewProjectionParameter));
 }
 
 ColorShaderClass::ColorShaderClass(const ColorShaderClass& other)
@@ -21,13 +34,20 @@ ColorShaderClass::~ColorShaderClass()
 
 }
 
-/*The Initialize function will call the initialization function for the shaders. We pass in the name of the HLSL shader files, in this tutorial they are named color.vs and color.ps.*/
-bool ColorShaderClass::Initialize(ID3D11Device* device, HWND hwnd)
+/*The Initialize function will call the initialization function for the shaders. The HLSL shader files are color_vs.hlsl and color_ps.hlsl, listed in color.permutations.
+The vertex format is the one of the models this shader draws, the layout and the decoding in the vertex shader are made for it.
+The compiled shaders come from the shader archive, which has every variant of them compiled ahead of time.*/
+bool ColorShaderClass::Initialize(RenderDeviceClass* device, ShaderArchiveClass* shaderArchive, HWND hwnd, const VertexFormatType& format)
 {
+	PROFILE_FUNCTION();
+
 	bool result;
 
+	// Keep the device around so the shader objects can be released again.
+	m_device = device;
+
 	// Initialize the vertex and pixel shaders.
-	result = InitializeShader(device, hwnd, L"../Tutorial2.0/color_vs.hlsl", L"../Tutorial2.0/color_ps.hlsl");
+	result = InitializeShader(device, shaderArchive, hwnd, format);
 	if (!result)
 	{
 		return false;
@@ -47,9 +67,11 @@ void ColorShaderClass::Shutdown()
 
 /*Render will first set the parameters inside the shader using the SetShaderParameters function. 
 Once the parameters are set it then calls RenderShader to draw the green triangle using the HLSL shader.*/
-bool ColorShaderClass::Render(ID3D11DeviceContext* deviceContext, int indexCount, XMMATRIX worldMatrix, XMMATRIX viewMatrix,
+bool ColorShaderClass::Render(RenderContextClass* deviceContext, int indexCount, XMMATRIX worldMatrix, XMMATRIX viewMatrix,
 	XMMATRIX projectionMatrix)
 {
+	PROFILE_FUNCTION();
+
 	bool result;
 
 	// Set the shader parameters that it will use for rendering.
@@ -65,185 +87,417 @@ bool ColorShaderClass::Render(ID3D11DeviceContext* deviceContext, int indexCount
 	return true;
 }
 
+/*RenderInstanced draws instanceCount copies of the prepared model with one draw call. The world matrix of every copy
+comes from the instance buffer in input slot 1 (see InstanceBatchClass), the worldMatrix passed in here is applied to all
+of them on top of that.*/
+bool ColorShaderClass::RenderInstanced(RenderContextClass* deviceContext, int indexCount, int instanceCount, XMMATRIX worldMatrix,
+	XMMATRIX viewMatrix, XMMATRIX projectionMatrix)
+{
+	PROFILE_FUNCTION();
+
+	bool result;
+
+	// Set the shader parameters that it will use for rendering, they are the same for every instance.
+	result = SetShaderParameters(deviceContext, worldMatrix, viewMatrix, projectionMatrix);
+	if (!result)
+	{
+		return false;
+	}
+
+	// Now render all the instances with the instanced shader.
+	RenderInstancedShader(deviceContext, indexCount, instanceCount);
+
+	return true;
+}
+
+/*WriteFrameParameters writes the transposed view and projection matrices of this frame into a slice of the constant
+allocator, once per frame. Every command filled in after this binds that slice to the FrameBuffer. When the compiler
+stripped the FrameBuffer nothing is written and the commands leave its slot alone.
+The matrices are stored as XMFLOAT4X4 since the constant allocator doesn't promise the 16 byte alignment XMMATRIX needs.*/
+void ColorShaderClass::WriteFrameParameters(ConstantAllocatorClass* constantAllocator, XMMATRIX viewMatrix, XMMATRIX projectionMatrix)
+{
+	char* dataPtr;
+
+	if (m_frameBinding.size == 0)
+	{
+		m_frameOffset = 0;
+		m_frameSize = 0;
+		return;
+	}
+
+	dataPtr = (char*)constantAllocator->Allocate(m_frameBinding.size, m_frameOffset, m_frameSize);
+
+	if (m_viewParameter.size > 0)
+	{
+		XMStoreFloat4x4((XMFLOAT4X4*)(dataPtr + m_viewParameter.offset), XMMatrixTranspose(viewMatrix));
+	}
+	if (m_projectionParameter.size > 0)
+	{
+		XMStoreFloat4x4((XMFLOAT4X4*)(dataPtr + m_projectionParameter.offset), XMMatrixTranspose(projectionMatrix));
+	}
+
+	return;
+}
+
+/*FillCommand is Render for the render queue. It puts the shaders and the layout in the command, the instanced ones
+when the command draws an instance batch, together with the frame slice written by WriteFrameParameters.*/
+void ColorShaderClass::FillCommand(RenderCommandType& command, bool instanced)
+{
+	command.vertexShader = instanced ? m_instanceVertexShader : m_vertexShader;
+	command.pixelShader = m_pixelShader;
+	command.inputLayout = instanced ? m_instanceLayout : m_layout;
+	if (m_frameSize > 0)
+	{
+		command.constantOffsets[m_frameBinding.slot] = m_frameOffset;
+		command.constantSizes[m_frameBinding.slot] = m_frameSize;
+	}
+
+	return;
+}
+
+/*WriteObjectParameters copies the world-view-projection matrix of one draw into a slice of the constant allocator and puts
+that slice in the slot of the ObjectBuffer in the command. The matrix must be transposed already, the way
+TransformBatchClass makes them.*/
+void ColorShaderClass::WriteObjectParameters(ConstantAllocatorClass* constantAllocator, RenderCommandType& command, const XMFLOAT4X4& worldViewProjection)
+{
+	char* dataPtr;
+
+	if (m_objectBinding.size == 0)
+	{
+		return;
+	}
+
+	dataPtr = (char*)constantAllocator->Allocate(m_objectBinding.size, command.constantOffsets[m_objectBinding.slot],
+		command.constantSizes[m_objectBinding.slot]);
+
+	if (m_worldViewProjectionParameter.size > 0)
+	{
+		*(XMFLOAT4X4*)(dataPtr + m_worldViewProjectionParameter.offset) = worldViewProjection;
+	}
+
+	return;
+}
+
 /*Now we will start with one of the more important functions to this tutorial which is called InitializeShader. 
 This function is what actually loads the shader files and makes it usable to DirectX and the GPU. You will also 
 see the setup of the layout and how the vertex buffer data is going to look on the graphics pipeline in the GPU. 
-The layout will need the match the VertexType in the modelclass.h file as well as the one defined in the color.vs file.*/
-bool ColorShaderClass::InitializeShader(ID3D11Device* device, HWND hwnd, WCHAR* vsFilename, WCHAR* psFilename)
+The layout and the vertex input of the shader are both generated from the vertex format (see VertexFormatClass), so they always match the vertices of the model.*/
+bool ColorShaderClass::InitializeShader(RenderDeviceClass* device, ShaderArchiveClass* shaderArchive, HWND hwnd, const VertexFormatType& format)
 {
-	HRESULT result;
-	ID3D10Blob* errorMessage; /*Blobs can be used as a data buffer, storing vertex, adjacency, and material information during mesh optimization and loading operations. Also, these objects are used to return object code and error messages in APIs that compile vertex, geometry and pixel shaders.*/
-	ID3D10Blob* vertexShaderBuffer;
-	ID3D10Blob* pixelShaderBuffer;
-	D3D11_INPUT_ELEMENT_DESC polygonLayout[2];
-	unsigned int numElements;
-	D3D11_BUFFER_DESC matrixBufferDesc;
-
-	// Initialize the pointers this function will use to null.
-	errorMessage = 0;
-	vertexShaderBuffer = 0;
-	pixelShaderBuffer = 0;
-
-	/*Here is where we compile the shader programs into buffers. We give it the name of the shader file, the name of the shader, 
-	the shader version (5.0 in DirectX 11), and the buffer to compile the shader into. If it fails compiling the shader it will put 
-	an error message inside the errorMessage string which we send to another function to write out the error. If it still fails and 
-	there is no errorMessage string then it means it could not find the shader file in which case we pop up a dialog box saying so.*/
-	// Compile the vertex shader code. D3DCompileFromFile Compiles Microsoft High Level Shader Language (HLSL) code into bytecode for a given target.
-	result = D3DCompileFromFile(vsFilename, NULL, NULL, "ColorVertexShader", "vs_5_0", D3D10_SHADER_ENABLE_STRICTNESS, 0,
-		&vertexShaderBuffer, &errorMessage);
-	if (FAILED(result))
-	{
-		// If the shader failed to compile it should have writen something to the error message.
-		if (errorMessage)
-		{
-			OutputShaderErrorMessage(errorMessage, hwnd, vsFilename);
-		}
-		// If there was  nothing in the error message then it simply could not find the shader file itself.
-		else
-		{
-			MessageBox(hwnd, vsFilename, L"Missing Shader File", MB_OK);
-		}
+	PROFILE_FUNCTION();
+
+	bool result;
+	vector<char> vertexShaderBuffer;
+	vector<char> pixelShaderBuffer;
+	vector<char> instanceShaderBuffer;
+	RenderShaderReflection vertexReflection, instanceReflection, pixelReflection;
+	vector<RenderShaderDefine> defines; /*The defines that pick the vertex input and decoding for the vertex format in color.vs.*/
+	vector<RenderInputElement> polygonLayout;
+	vector<RenderInputElement> instanceLayout;
+	RenderInputElement worldElement;
+	string errorMessage;
+	wstring filename;
+	int vertexStage, pixelStage;
+	unsigned int mask, option, instanced;
+	unsigned int i;
+
+	// The vertex format has to be one the shader can decode.
+	if (!VertexFormatClass::IsValid(format))
+	{
+		return false;
+	}
+
+	/*Every combination of the options in color.permutations is a variant of the shaders, picked with a mask that has a bit
+	for every option that is on. The vertex format turns on the options of its vertex input, the instanced vertex shader
+	is the same variant with INSTANCED on as well. Texturing and fog stay off, the vertex formats have no texture
+	coordinates yet.*/
+	vertexStage = shaderArchive->GetStage("vertex");
+	pixelStage = shaderArchive->GetStage("pixel");
+	instanced = shaderArchive->GetOption("INSTANCED");
+	if (vertexStage < 0 || pixelStage < 0 || !instanced)
+	{
 		return false;
 	}
 
-	// Compile the pixel shader code.
-	result = D3DCompileFromFile(psFilename, NULL, NULL, "ColorPixelShader", "ps_5_0", D3D10_SHADER_ENABLE_STRICTNESS, 0,
-		&pixelShaderBuffer, &errorMessage);
-	if (FAILED(result))
+	VertexFormatClass::GetShaderDefines(format, defines);
+
+	mask = 0;
+	for (i = 0; defines[i].Name; i++)
 	{
-		// If the shader failed to compile it should have writen something to the error message.
-		if (errorMessage)
+		option = shaderArchive->GetOption(defines[i].Name);
+		if (!option)
 		{
-			OutputShaderErrorMessage(errorMessage, hwnd, psFilename);
+			return false;
 		}
-		// If there was nothing in the error message then it simply could not find the file itself.
-		else
+		if (strcmp(defines[i].Definition, "1") == 0)
 		{
-			MessageBox(hwnd, psFilename, L"Missing Shader File", MB_OK);
+			mask |= option;
 		}
+	}
+
+	/*Here is where we get the compiled shader programs. The shader archive has them compiled ahead of time with the shader version (5.0 in DirectX 11) and
+	the defines of the mask, so getting one is a lookup. When the archive is missing or out of date it compiles them through the shader cache instead, and
+	if that fails GetShader writes out the error.*/
+	// Get the vertex shader code.
+	result = GetShader(shaderArchive, hwnd, vertexStage, mask, vertexShaderBuffer, vertexReflection);
+	if (!result)
+	{
+		return false;
+	}
+
+	// Get the instanced vertex shader code, it is the same shader with INSTANCED on.
+	result = GetShader(shaderArchive, hwnd, vertexStage, mask | instanced, instanceShaderBuffer, instanceReflection);
+	if (!result)
+	{
+		return false;
+	}
 
+	// Get the pixel shader code.
+	result = GetShader(shaderArchive, hwnd, pixelStage, mask, pixelShaderBuffer, pixelReflection);
+	if (!result)
+	{
 		return false;
 	}
 
 	/*Once the vertex shader and pixel shader code has successfully compiled into buffers we then use those 
 	buffers to create the shader objects themselves. We will use these pointers to interface with the vertex and pixel shader from this point forward.*/
+	/*Before anything is created the compiled shaders are checked against what this class writes: the constant buffers
+	and matrices it fills in and, further down, the input layouts. The offsets found here are kept for the rest of the
+	life of the shader. A mismatch is written out like a compile error.*/
+	result = GetShaderParameters(vertexReflection, instanceReflection, pixelReflection, errorMessage);
+	if (!result)
+	{
+		shaderArchive->GetShaderFilename(vertexStage, filename);
+		OutputShaderErrorMessage(errorMessage, hwnd, filename.c_str());
+		return false;
+	}
+
 	// Create the vertex shader from the buffer.
-	result = device->CreateVertexShader(vertexShaderBuffer->GetBufferPointer(), vertexShaderBuffer->GetBufferSize(), NULL, &m_vertexShader);
-	if (FAILED(result))
+	result = device->CreateVertexShader(&vertexShaderBuffer[0], vertexShaderBuffer.size(), m_vertexShader);
+	if (!result)
+	{
+		return false;
+	}
+
+	// Create the instanced vertex shader from its buffer.
+	result = device->CreateVertexShader(&instanceShaderBuffer[0], instanceShaderBuffer.size(), m_instanceVertexShader);
+	if (!result)
 	{
 		return false;
 	}
 
 	// Create the pixel shader from the buffer.
-	result = device->CreatePixelShader(pixelShaderBuffer->GetBufferPointer(), pixelShaderBuffer->GetBufferSize(), NULL, &m_pixelShader);
-	if (FAILED(result))
+	result = device->CreatePixelShader(&pixelShaderBuffer[0], pixelShaderBuffer.size(), m_pixelShader);
+	if (!result)
 	{
 		return false;
 	}
 
 	/*The next step is to create the layout of the vertex data that will be processed by the shader. 
-	As this shader uses a position and color vector we need to create both in the layout specifying the size of both. 
 	The semantic name is the first thing to fill out in the layout, this allows the shader to determine the usage of this 
-	element of the layout. As we have two different elements we use POSITION for the first one and COLOR for the second. 
-	The next important part of the layout is the Format. For the position vector we use DXGI_FORMAT_R32G32B32_FLOAT and 
-	for the color we use DXGI_FORMAT_R32G32B32A32_FLOAT. The final thing you need to pay attention to is the AlignedByteOffset 
-	which indicates how the data is spaced in the buffer. For this layout we are telling it the first 12 bytes are position and 
-	the next 16 bytes will be color, AlignedByteOffset shows where each element begins. You can use D3D11_APPEND_ALIGNED_ELEMENT 
-	instead of placing your own values in AlignedByteOffset and it will figure out the spacing for you. The other settings I've 
-	made default for now as they are not needed in this tutorial.*/
+	element of the layout: POSITION, COLOR and, when the format has one, NORMAL. The next important part of the layout is the Format,
+	a position can be three floats or four 16 bit unsigned normalized values that the world matrix scales back into the bounds of the model,
+	a color four floats or four bytes. The final thing you need to pay attention to is the AlignedByteOffset which indicates how the data is
+	spaced in the buffer. All of this comes from the vertex format, the same description the mesh file encoded the vertices with.*/
 	// Create the vertex input layout description.
-	// This setup needs to match the VertexType stucture in the ModelClass and in the shader.
-	polygonLayout[0].SemanticName = "POSITION"; /*A semantic is a string which tells the GPU what the value is used for. There are numerous semantics possible, but we'll learn them as we come to them. "POSITION" represents a 3-dimensional position using float values.*/
-	polygonLayout[0].SemanticIndex = 0;
-	polygonLayout[0].Format = DXGI_FORMAT_R32G32B32_FLOAT; /*This value is represents format of the data. On many semantics, the number of values is arbitrary (so long as its less than four). All that matters is that the format matches what you use in your vertices. The format here shows three float values: one for red, green, and blue. Yes, we aren't talking about color, but position is stored the same exact way, and there isn't a special value for X, Y, and Z.*/
-	polygonLayout[0].InputSlot = 0;
-	polygonLayout[0].AlignedByteOffset = 0;
-	polygonLayout[0].InputSlotClass = D3D11_INPUT_PER_VERTEX_DATA;
-	polygonLayout[0].InstanceDataStepRate = 0;
-
-	polygonLayout[1].SemanticName = "COLOR";
-	polygonLayout[1].SemanticIndex = 0;
-	polygonLayout[1].Format = DXGI_FORMAT_R32G32B32A32_FLOAT;
-	polygonLayout[1].InputSlot = 0;
-	polygonLayout[1].AlignedByteOffset = D3D11_APPEND_ALIGNED_ELEMENT;
-	polygonLayout[1].InputSlotClass = D3D11_INPUT_PER_VERTEX_DATA;
-	polygonLayout[1].InstanceDataStepRate = 0;
-
-
-	/*Once the layout description has been setup we can get the size of it and then create the input layout using the D3D device. 
-	Also release the vertex and pixel shader buffers since they are no longer needed once the layout has been created.*/
-
-	// Get a count of the elements in the layout.
-	numElements = sizeof(polygonLayout) / sizeof(polygonLayout[0]);
-
-	// Create the vertex input layout.
-	result = device->CreateInputLayout(polygonLayout, numElements, vertexShaderBuffer->GetBufferPointer(),
-		vertexShaderBuffer->GetBufferSize(), &m_layout);
-	if (FAILED(result))
+	VertexFormatClass::GetInputLayout(format, polygonLayout);
+
+	/*Once the layout description has been setup we can create the input layout using the device.*/
+	// Check the layout against the vertex inputs of the shader, then create the vertex input layout.
+	result = ShaderReflectionClass::ValidateInputLayout(vertexReflection, &polygonLayout[0], (unsigned int)polygonLayout.size(), errorMessage);
+	if (!result)
 	{
+		shaderArchive->GetShaderFilename(vertexStage, filename);
+		OutputShaderErrorMessage(errorMessage, hwnd, filename.c_str());
 		return false;
 	}
 
-	// Release the vertex shader buffer and pixel shader buffer since they are no longer needed.
-	vertexShaderBuffer->Release();
-	vertexShaderBuffer = 0;
+	result = device->CreateInputLayout(&polygonLayout[0], (unsigned int)polygonLayout.size(), &vertexShaderBuffer[0],
+		vertexShaderBuffer.size(), m_layout);
+	if (!result)
+	{
+		return false;
+	}
 
-	pixelShaderBuffer->Release();
-	pixelShaderBuffer = 0;
+	/*The instanced layout reads the same vertices from slot 0 and adds a second slot with one world matrix per instance.
+	The matrix goes in as four float4 rows, WORLD0 to WORLD3, and the step rate of 1 moves to the next matrix after
+	every instance instead of every vertex. This has to match the InstanceType in the InstanceBatchClass.*/
+	instanceLayout = polygonLayout;
 
-	/*The final thing that needs to be setup to utilize the shader is the constant buffer. 
-	As you saw in the vertex shader we currently have just one constant buffer so we only need 
-	to setup one here so we can interface with the shader. The buffer usage needs to be set to 
+	for (i = 0; i < 4; i++)
+	{
+		worldElement.SemanticName = "WORLD";
+		worldElement.SemanticIndex = i;
+		worldElement.Format = RENDER_FORMAT_R32G32B32A32_FLOAT;
+		worldElement.InputSlot = 1;
+		worldElement.AlignedByteOffset = (i == 0) ? 0 : RENDER_APPEND_ALIGNED_ELEMENT;
+		worldElement.InputSlotClass = RENDER_INPUT_PER_INSTANCE_DATA;
+		worldElement.InstanceDataStepRate = 1;
+		instanceLayout.push_back(worldElement);
+	}
+
+	// Check and create the instanced vertex input layout.
+	result = ShaderReflectionClass::ValidateInputLayout(instanceReflection, &instanceLayout[0], (unsigned int)instanceLayout.size(), errorMessage);
+	if (!result)
+	{
+		shaderArchive->GetShaderFilename(vertexStage, filename);
+		OutputShaderErrorMessage(errorMessage, hwnd, filename.c_str());
+		return false;
+	}
+
+	result = device->CreateInputLayout(&instanceLayout[0], (unsigned int)instanceLayout.size(), &instanceShaderBuffer[0], instanceShaderBuffer.size(), m_instanceLayout);
+	if (!result)
+	{
+		return false;
+	}
+
+	// The vertex shader buffer and pixel shader buffer are vectors, they release themselves when we leave this function.
+
+	/*The final thing that needs to be setup to utilize the shader is the constant buffers. 
+	As you saw in the vertex shader we have a buffer for the frame and one for the object, these two are
+	only used when drawing directly with Render, the render queue takes its constants from the constant allocator. They get the size the
+	reflection gave them and a buffer the compiler stripped isn't created at all. The buffer usage needs to be set to 
 	dynamic since we will be updating it each frame. The bind flags indicate that this buffer will
 	be a constant buffer. The cpu access flags need to match up with the usage so it is set to D3D11_CPU_ACCESS_WRITE. 
 	Once we fill out the description we can then create the constant buffer interface and then use that to access the 
 	internal variables in the shader using the function SetShaderParameters.*/
-	// Setup the description of the dynamic matrix constant buffer that is in the vertex shader.
-	matrixBufferDesc.Usage = D3D11_USAGE_DYNAMIC;
-	matrixBufferDesc.ByteWidth = sizeof(MatrixBufferType);
-	matrixBufferDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
-	matrixBufferDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
-	matrixBufferDesc.MiscFlags = 0;
-	matrixBufferDesc.StructureByteStride = 0;
-
-	// Create the constant buffer pointer so we can access the vertex shader constant buffer from within this class.
-	result = device->CreateBuffer(&matrixBufferDesc, NULL, &m_matrixBuffer);
-	if (FAILED(result))
+	// Create the dynamic matrix constant buffers that are in the vertex shader so we can access them from within this class.
+	if (m_frameBinding.size > 0)
+	{
+		result = device->CreateBuffer(RENDER_CONSTANT_BUFFER, RENDER_USAGE_DYNAMIC, m_frameBinding.size, NULL, m_frameBuffer);
+		if (!result)
+		{
+			return false;
+		}
+	}
+
+	if (m_objectBinding.size > 0)
+	{
+		result = device->CreateBuffer(RENDER_CONSTANT_BUFFER, RENDER_USAGE_DYNAMIC, m_objectBinding.size, NULL, m_objectBuffer);
+		if (!result)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/*GetShader gets one variant of a stage out of the shader archive. If the shader failed to compile the compiler output is
+written out with OutputShaderErrorMessage, if there was nothing in the error message then it simply could not find the shader file itself.*/
+bool ColorShaderClass::GetShader(ShaderArchiveClass* shaderArchive, HWND hwnd, int stage, unsigned int mask, vector<char>& bytecode,
+	RenderShaderReflection& reflection)
+{
+	bool result;
+	string errorMessage; /*The compiler output when a shader fails to compile. It stays empty when the file could not be found at all.*/
+	wstring filename;
+
+	result = shaderArchive->GetShader(stage, mask, bytecode, reflection, errorMessage);
+	if (!result)
 	{
+		// Name the file in the message when the archive knows it.
+		if (!shaderArchive->GetShaderFilename(stage, filename))
+		{
+			filename = L"shader archive";
+		}
+
+		if (!errorMessage.empty())
+		{
+			OutputShaderErrorMessage(errorMessage, hwnd, filename.c_str());
+		}
+		else
+		{
+			ShowError(hwnd, filename.c_str(), L"Missing Shader File");
+		}
 		return false;
 	}
 
 	return true;
 }
 
-/*ShutdownShader releases the four interfaces that were setup in the InitializeShader function.*/
+/*GetShaderParameters looks up the constant buffers and matrices in the reflection of the vertex shader. The instanced
+vertex shader only adds vertex inputs and the pixel shader may share buffers with them, so both have to agree with the
+vertex shader on every buffer they have in common. The buffers have to be in slots the render commands have room for.*/
+bool ColorShaderClass::GetShaderParameters(const RenderShaderReflection& vertexReflection, const RenderShaderReflection& instanceReflection,
+	const RenderShaderReflection& pixelReflection, string& errors)
+{
+	bool result;
+
+	result = ShaderReflectionClass::ValidateConstantBuffers(vertexReflection, instanceReflection, errors);
+	result = ShaderReflectionClass::ValidateConstantBuffers(vertexReflection, pixelReflection, errors) && result;
+	if (!result)
+	{
+		return false;
+	}
+
+	ShaderReflectionClass::GetConstantBuffer(vertexReflection, "FrameBuffer", m_frameBinding);
+	ShaderReflectionClass::GetConstantBuffer(vertexReflection, "ObjectBuffer", m_objectBinding);
+	if ((m_frameBinding.size > 0 && m_frameBinding.slot >= RENDER_COMMAND_CONSTANT_BUFFERS) ||
+		(m_objectBinding.size > 0 && m_objectBinding.slot >= RENDER_COMMAND_CONSTANT_BUFFERS))
+	{
+		errors += "the constant buffers must be in the first slots, render commands have no room for more\n";
+		return false;
+	}
+
+	result = ShaderReflectionClass::GetParameter(vertexReflection, "FrameBuffer", "viewMatrix", sizeof(XMFLOAT4X4), m_viewParameter, errors);
+	result = ShaderReflectionClass::GetParameter(vertexReflection, "FrameBuffer", "projectionMatrix", sizeof(XMFLOAT4X4), m_projectionParameter,
+		errors) && result;
+	result = ShaderReflectionClass::GetParameter(vertexReflection, "ObjectBuffer", "worldViewProjectionMatrix", sizeof(XMFLOAT4X4),
+		m_worldViewProjectionParameter, errors) && result;
+	if (!result)
+	{
+		return false;
+	}
+
+	return true;
+}
+
+/*ShutdownShader releases the shaders, layouts and buffer that were setup in the InitializeShader function.*/
 void ColorShaderClass::ShutdownShader()
 {
-	// Release the matrix constant buffer.
-	if (m_matrixBuffer)
+	// Release the matrix constant buffers.
+	if (m_objectBuffer)
+	{
+		m_device->ReleaseBuffer(m_objectBuffer);
+		m_objectBuffer = 0;
+	}
+
+	if (m_frameBuffer)
+	{
+		m_device->ReleaseBuffer(m_frameBuffer);
+		m_frameBuffer = 0;
+	}
+
+	// Release the layouts.
+	if (m_instanceLayout)
 	{
-		m_matrixBuffer->Release();
-		m_matrixBuffer = 0;
+		m_device->ReleaseInputLayout(m_instanceLayout);
+		m_instanceLayout = 0;
 	}
 
-	// Release the layout.
 	if (m_layout)
 	{
-		m_layout->Release();
+		m_device->ReleaseInputLayout(m_layout);
 		m_layout = 0;
 	}
 
 	// Release the pixel shader.
 	if (m_pixelShader)
 	{
-		m_pixelShader->Release();
+		m_device->ReleasePixelShader(m_pixelShader);
 		m_pixelShader = 0;
 	}
 
-	// Release the vertex shader.
+	// Release the vertex shaders.
+	if (m_instanceVertexShader)
+	{
+		m_device->ReleaseVertexShader(m_instanceVertexShader);
+		m_instanceVertexShader = 0;
+	}
+
 	if (m_vertexShader)
 	{
-		m_vertexShader->Release();
+		m_device->ReleaseVertexShader(m_vertexShader);
 		m_vertexShader = 0;
 	}
 
@@ -251,18 +505,18 @@ void ColorShaderClass::ShutdownShader()
 }
 
 /*The OutputShaderErrorMessage writes out error messages that are generating when compiling either vertex shaders or pixel shaders.*/
-void ColorShaderClass::OutputShaderErrorMessage(ID3D10Blob* errorMessage, HWND hwnd, WCHAR* shaderFilename)
+void ColorShaderClass::OutputShaderErrorMessage(const string& errorMessage, HWND hwnd, const WCHAR* shaderFilename)
 {
-	char* compileErrors;
+	const char* compileErrors;
 	unsigned long long bufferSize, i;
 	ofstream fout;
 
 
 	// Get a pointer to the error message text buffer.
-	compileErrors = (char*)(errorMessage->GetBufferPointer());
+	compileErrors = errorMessage.c_str();
 
 	// Get the length of the message.
-	bufferSize = errorMessage->GetBufferSize();
+	bufferSize = errorMessage.size();
 
 	// Open a file to write the error message to.
 	fout.open("shader-error.txt");
@@ -276,57 +530,78 @@ void ColorShaderClass::OutputShaderErrorMessage(ID3D10Blob* errorMessage, HWND h
 	// Close the file.
 	fout.close();
 
-	// Release the error message.
-	errorMessage->Release();
-	errorMessage = 0;
-
 	// Pop a message up on the screen to notify the user to check the text file for compile errors.
-	MessageBox(hwnd, L"Error compiling shader.  Check shader-error.txt for message.", shaderFilename, MB_OK);
+	ShowError(hwnd, L"Error compiling shader.  Check shader-error.txt for message.", shaderFilename);
 
 	return;
 }
 
 /*The SetShaderVariables function exists to make setting the global variables in the shader easier. 
 The matrices used in this function are created inside the GraphicsClass, after which this function is called to send them from there into the vertex shader during the Render function call.*/
-bool ColorShaderClass::SetShaderParameters(ID3D11DeviceContext* deviceContext, XMMATRIX worldMatrix, XMMATRIX viewMatrix,
+bool ColorShaderClass::SetShaderParameters(RenderContextClass* deviceContext, XMMATRIX worldMatrix, XMMATRIX viewMatrix,
 	XMMATRIX projectionMatrix)
 {
-	HRESULT result;
-	D3D11_MAPPED_SUBRESOURCE mappedResource;
-	MatrixBufferType* dataPtr;
-	unsigned int bufferNumber;
+	PROFILE_FUNCTION();
+
+	bool result;
+	void* mappedResource;
+	char* dataPtr;
+	XMMATRIX worldViewProjectionMatrix;
+
+	// Premultiply the matrices for the object buffer, before they are transposed.
+	worldViewProjectionMatrix = XMMatrixMultiply(XMMatrixMultiply(worldMatrix, viewMatrix), projectionMatrix);
 
 	/*Make sure to transpose matrices before sending them into the shader, this is a requirement for DirectX 11.*/
 	// Transpose/omzetten the matrices to prepare them for the shader.
-	worldMatrix = XMMatrixTranspose(worldMatrix);
+	worldViewProjectionMatrix = XMMatrixTranspose(worldViewProjectionMatrix);
 	viewMatrix = XMMatrixTranspose(viewMatrix);
 	projectionMatrix = XMMatrixTranspose(projectionMatrix);
 
-	/*Lock the m_matrixBuffer, set the new matrices inside it, and then unlock it.*/
-	// Lock the constant buffer so it can be written to.
-	result = deviceContext->Map(m_matrixBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedResource);
-	if (FAILED(result))
+	/*Lock the m_frameBuffer and m_objectBuffer, set the new matrices inside them at the offsets the reflection gave, and
+	then unlock them. A buffer the shader doesn't have was never created and is skipped.*/
+	if (m_frameBuffer)
 	{
-		return false;
-	}
+		// Lock the frame constant buffer so it can be written to.
+		result = deviceContext->Map(m_frameBuffer, &mappedResource);
+		if (!result)
+		{
+			return false;
+		}
 
-	// Get a pointer to the data in the constant buffer.
-	dataPtr = (MatrixBufferType*)mappedResource.pData;
+		// Copy the matrices into the constant buffer.
+		dataPtr = (char*)mappedResource;
+		if (m_viewParameter.size > 0)
+		{
+			XMStoreFloat4x4((XMFLOAT4X4*)(dataPtr + m_viewParameter.offset), viewMatrix);
+		}
+		if (m_projectionParameter.size > 0)
+		{
+			XMStoreFloat4x4((XMFLOAT4X4*)(dataPtr + m_projectionParameter.offset), projectionMatrix);
+		}
 
-	// Copy the matrices into the constant buffer.
-	dataPtr->world = worldMatrix;
-	dataPtr->view = viewMatrix;
-	dataPtr->projection = projectionMatrix;
+		// Unlock the constant buffer and set it in the slot of the FrameBuffer in the HLSL vertex shader.
+		deviceContext->Unmap(m_frameBuffer);
+		deviceContext->VSSetConstantBuffers(m_frameBinding.slot, 1, &m_frameBuffer);
+	}
 
-	// Unlock the constant buffer.
-	deviceContext->Unmap(m_matrixBuffer, 0);
+	// Do the same for the world matrix in the object constant buffer.
+	if (m_objectBuffer)
+	{
+		result = deviceContext->Map(m_objectBuffer, &mappedResource);
+		if (!result)
+		{
+			return false;
+		}
 
-	/*Now set the updated matrix buffer in the HLSL vertex shader.*/
-	// Set the position of the constant buffer in the vertex shader.
-	bufferNumber = 0;
+		dataPtr = (char*)mappedResource;
+		if (m_worldViewProjectionParameter.size > 0)
+		{
+			XMStoreFloat4x4((XMFLOAT4X4*)(dataPtr + m_worldViewProjectionParameter.offset), worldViewProjectionMatrix);
+		}
 
-	// Finanly set the constant buffer in the vertex shader with the updated values.
-	deviceContext->VSSetConstantBuffers(bufferNumber, 1, &m_matrixBuffer);
+		deviceContext->Unmap(m_objectBuffer);
+		deviceContext->VSSetConstantBuffers(m_objectBinding.slot, 1, &m_objectBuffer);
+	}
 
 	return true;
 }
@@ -338,17 +613,38 @@ This lets the GPU know the format of the data in the vertex buffer. The second s
 the vertex shader and pixel shader we will be using to render this vertex buffer. Once the shaders 
 are set we render the triangle by calling the DrawIndexed DirectX 11 function using the D3D device 
 context. Once this function is called it will render the green triangle.*/
-void ColorShaderClass::RenderShader(ID3D11DeviceContext* deviceContext, int indexCount)
+void ColorShaderClass::RenderShader(RenderContextClass* deviceContext, int indexCount)
 {
+	PROFILE_FUNCTION();
+
 	// Set the vertex input layout.
 	deviceContext->IASetInputLayout(m_layout);
 
 	// Set the vertex and pixel shaders that will be used to render this triangle.
-	deviceContext->VSSetShader(m_vertexShader, NULL, 0);
-	deviceContext->PSSetShader(m_pixelShader, NULL, 0);
+	deviceContext->VSSetShader(m_vertexShader);
+	deviceContext->PSSetShader(m_pixelShader);
 
 	// Render the triangle.
 	deviceContext->DrawIndexed(indexCount, 0, 0);
 
+	return;
+}
+
+/*RenderInstancedShader is RenderShader for the instanced path. The model buffers have to be in slot 0 and the instance
+buffer in slot 1 before this is called.*/
+void ColorShaderClass::RenderInstancedShader(RenderContextClass* deviceContext, int indexCount, int instanceCount)
+{
+	PROFILE_FUNCTION();
+
+	// Set the instanced vertex input layout.
+	deviceContext->IASetInputLayout(m_instanceLayout);
+
+	// Set the instanced vertex shader and the pixel shader.
+	deviceContext->VSSetShader(m_instanceVertexShader);
+	deviceContext->PSSetShader(m_pixelShader);
+
+	// Render every instance with a single draw call.
+	deviceContext->DrawIndexedInstanced(indexCount, instanceCount, 0, 0, 0);
+
 	return;
 }
\ No newline at end of file
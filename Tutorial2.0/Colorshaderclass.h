@@ -10,10 +10,12 @@
 //////////////
 // INCLUDES // https://www.3dgep.com/introduction-to-directx-11/
 //////////////
-#include <d3d11.h>
-#include <d3dcompiler.h> // The d3dcompiler header file is required for loading and compiling HLSL shaders. 
 #include <directxmath.h> // The DirectXMath header file includes math primitives like vectors, matrices and quaternions as well as the functions to operate on those primitives.
 #include <fstream>
+#include "renderqueueclass.h" // Compiling the HLSL shaders and creating the shader objects is done through the render device.
+#include "vertexformatclass.h"
+#include "shaderarchiveclass.h"
+#include "shaderreflectionclass.h"
 using namespace DirectX;
 using namespace std;
 
@@ -21,24 +23,18 @@ using namespace std;
 ////////////////////////////////////////////////////////////////////////////////
 // Class name: ColorShaderClass
 ////////////////////////////////////////////////////////////////////////////////
+/*The shaders have two constant buffers in the vertex shader, see color_vs.hlsl. The FrameBuffer has the view matrix,
+which translates the vertices from world space to camera space, and the projection matrix, which translates them from
+camera space to where they are displayed on the monitor. Those are the same for every draw of a frame. The ObjectBuffer
+has the world matrix, which puts the vertices of the model in the world, premultiplied with the view and projection
+matrices (see TransformBatchClass), and is written per draw.
+
+There is no struct here that has to be kept the same as the cbuffers by hand. Where the buffers are bound and where every
+matrix is in them comes from the reflection of the compiled shaders, looked up once in InitializeShader, and a buffer
+the compiler stripped because nothing reads it is never written. The input layouts are checked against the vertex inputs
+the same way, so a shader that doesn't match the engine fails to load instead of drawing garbage.*/
 class ColorShaderClass
 {
-private:
-	/*Here is the definition of the cBuffer type that will be used with the vertex shader.
-	This typedef must be exactly the same as the one in the vertex shader as the model data 
-	needs to match the typedefs in the shader for proper rendering.*/
-	struct MatrixBufferType
-	{
-		/*The World Matrix translates the position of your vertices from model space to World space. That means it applies its position in the world and its rotation.
-
-		The View Matrix translates those vertices from world space to camera space. This means the new vertices are in relation to you camera.
-
-		The Projection Matrix finally translates those vertices from world space to projection Space. That means it finally calculates where you vertices are actually displayed on you Display/Monitor.*/
-		XMMATRIX world;
-		XMMATRIX view;
-		XMMATRIX projection;
-	};
-
 public:
 	ColorShaderClass();
 	ColorShaderClass(const ColorShaderClass&);
@@ -46,23 +42,37 @@ public:
 
 	/*The functions here handle initializing and shutdown of the shader. 
 	The render function sets the shader parameters and then draws the prepared model vertices using the shader.*/
-	bool Initialize(ID3D11Device*, HWND);
+	bool Initialize(RenderDeviceClass*, ShaderArchiveClass*, HWND, const VertexFormatType&);
 	void Shutdown();
-	bool Render(ID3D11DeviceContext*, int, XMMATRIX, XMMATRIX, XMMATRIX);
+	bool Render(RenderContextClass*, int, XMMATRIX, XMMATRIX, XMMATRIX);
+	bool RenderInstanced(RenderContextClass*, int, int, XMMATRIX, XMMATRIX, XMMATRIX);
+
+	void WriteFrameParameters(ConstantAllocatorClass*, XMMATRIX, XMMATRIX);
+	void FillCommand(RenderCommandType&, bool);
+	void WriteObjectParameters(ConstantAllocatorClass*, RenderCommandType&, const XMFLOAT4X4&);
 
 private:
-	bool InitializeShader(ID3D11Device*, HWND, WCHAR*, WCHAR*);
+	bool InitializeShader(RenderDeviceClass*, ShaderArchiveClass*, HWND, const VertexFormatType&);
+	bool GetShader(ShaderArchiveClass*, HWND, int, unsigned int, vector<char>&, RenderShaderReflection&);
+	bool GetShaderParameters(const RenderShaderReflection&, const RenderShaderReflection&, const RenderShaderReflection&, string&);
 	void ShutdownShader();
-	void OutputShaderErrorMessage(ID3D10Blob*, HWND, WCHAR*);
+	void OutputShaderErrorMessage(const string&, HWND, const WCHAR*);
 
-	bool SetShaderParameters(ID3D11DeviceContext*, XMMATRIX, XMMATRIX, XMMATRIX);
-	void RenderShader(ID3D11DeviceContext*, int);
+	bool SetShaderParameters(RenderContextClass*, XMMATRIX, XMMATRIX, XMMATRIX);
+	void RenderShader(RenderContextClass*, int);
+	void RenderInstancedShader(RenderContextClass*, int, int);
 
 private:
-	ID3D11VertexShader * m_vertexShader;
-	ID3D11PixelShader* m_pixelShader;
-	ID3D11InputLayout* m_layout;
-	ID3D11Buffer* m_matrixBuffer;
+	RenderDeviceClass* m_device;
+	RenderVertexShader m_vertexShader;
+	RenderPixelShader m_pixelShader;
+	RenderInputLayout m_layout;
+	RenderVertexShader m_instanceVertexShader;
+	RenderInputLayout m_instanceLayout;
+	RenderBuffer m_frameBuffer, m_objectBuffer;
+	unsigned int m_frameOffset, m_frameSize;
+	ShaderBufferBindingType m_frameBinding, m_objectBinding;
+	ShaderParameterType m_viewParameter, m_projectionParameter, m_worldViewProjectionParameter;
 };
 
 #endif
\ No newline at end of file
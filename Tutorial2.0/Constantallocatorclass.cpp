@@ -0,0 +1,286 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: constantallocatorclass.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "constantallocatorclass.h"
+#include "profilerclass.h"
+#include <string.h>
+
+ConstantAllocatorClass::ConstantAllocatorClass()
+{
+	int slot;
+
+	m_device = 0;
+	m_frameBuffer = 0;
+	m_capacity = 0;
+	m_used = 0;
+	m_bindRanges = true;
+
+	for (slot = 0; slot < CONSTANT_ALLOCATOR_SLOTS; slot++)
+	{
+		m_slotBuffers[slot] = 0;
+		m_slotSizes[slot] = 0;
+	}
+}
+
+ConstantAllocatorClass::ConstantAllocatorClass(const ConstantAllocatorClass& other)
+{
+}
+
+ConstantAllocatorClass::~ConstantAllocatorClass()
+{
+}
+
+/*Initialize creates the frame buffer with room for capacity bytes, rounded up to whole slices. Without support for
+binding at an offset it creates a buffer of one slice for every slot instead, they grow when a bigger slice is bound.*/
+bool ConstantAllocatorClass::Initialize(RenderDeviceClass* device, unsigned int capacity)
+{
+	PROFILE_FUNCTION();
+
+	int slot;
+	bool result;
+
+	// Keep the device around to grow and release the buffers.
+	m_device = device;
+	m_bindRanges = m_device->SupportsConstantBufferOffsets();
+
+	if (!m_bindRanges)
+	{
+		for (slot = 0; slot < CONSTANT_ALLOCATOR_SLOTS; slot++)
+		{
+			result = CreateSlotBuffer(slot, CONSTANT_SLICE_SIZE);
+			if (!result)
+			{
+				return false;
+			}
+		}
+
+		// The CPU copy is all there is in this case.
+		m_slices.resize((capacity + CONSTANT_SLICE_SIZE - 1) & ~(CONSTANT_SLICE_SIZE - 1));
+		m_capacity = (unsigned int)m_slices.size();
+
+		return true;
+	}
+
+	result = CreateFrameBuffer(capacity);
+	if (!result)
+	{
+		return false;
+	}
+
+	return true;
+}
+
+void ConstantAllocatorClass::Shutdown()
+{
+	int slot;
+
+	// Release the buffers of the slots.
+	for (slot = 0; slot < CONSTANT_ALLOCATOR_SLOTS; slot++)
+	{
+		if (m_slotBuffers[slot])
+		{
+			m_device->ReleaseBuffer(m_slotBuffers[slot]);
+			m_slotBuffers[slot] = 0;
+		}
+		m_slotSizes[slot] = 0;
+	}
+
+	// Release the frame buffer.
+	if (m_frameBuffer)
+	{
+		m_device->ReleaseBuffer(m_frameBuffer);
+		m_frameBuffer = 0;
+	}
+
+	m_capacity = 0;
+	m_used = 0;
+	m_slices.clear();
+
+	return;
+}
+
+/*BeginFrame throws away the slices of the last frame. The memory is kept.*/
+void ConstantAllocatorClass::BeginFrame()
+{
+	m_used = 0;
+	return;
+}
+
+/*Allocate reserves size bytes, rounded up to whole slices, and returns where to write them. offset and rangeSize are
+set to the byte offset and the rounded size to bind the slice with. The pointer is only good until the next Allocate,
+the offset until the next BeginFrame.*/
+void* ConstantAllocatorClass::Allocate(unsigned int size, unsigned int& offset, unsigned int& rangeSize)
+{
+	rangeSize = (size + CONSTANT_SLICE_SIZE - 1) & ~(CONSTANT_SLICE_SIZE - 1);
+	if (rangeSize == 0)
+	{
+		rangeSize = CONSTANT_SLICE_SIZE;
+	}
+
+	offset = m_used;
+	m_used += rangeSize;
+
+	// The CPU copy grows on its own, the buffer catches up in Upload.
+	if (m_used > (unsigned int)m_slices.size())
+	{
+		m_slices.resize(m_used * 2);
+	}
+
+	return &m_slices[offset];
+}
+
+/*Upload copies all the slices of this frame into the frame buffer with one Map/Unmap. Without binding at an offset
+there is nothing to do, BindSlice copies each slice when it is bound.*/
+bool ConstantAllocatorClass::Upload(RenderContextClass* deviceContext)
+{
+	PROFILE_FUNCTION();
+
+	void* mappedResource;
+	bool result;
+
+	if (m_used == 0 || !m_bindRanges)
+	{
+		return true;
+	}
+
+	// Grow the buffer when the frame handed out more than it can hold.
+	if (m_used > m_capacity)
+	{
+		result = CreateFrameBuffer(m_used * 2);
+		if (!result)
+		{
+			return false;
+		}
+	}
+
+	result = deviceContext->Map(m_frameBuffer, &mappedResource);
+	if (!result)
+	{
+		return false;
+	}
+
+	memcpy(mappedResource, &m_slices[0], m_used);
+
+	deviceContext->Unmap(m_frameBuffer);
+
+	return true;
+}
+
+/*BindSlice binds the slice at offset with the given size to a vertex shader slot. With binding at an offset that is
+a range of the frame buffer and the context can be a deferred one. Without it the slice is copied into the buffer of
+the slot first, which has to happen on the immediate context right before the draw that uses it.*/
+bool ConstantAllocatorClass::BindSlice(RenderContextClass* deviceContext, int slot, unsigned int offset, unsigned int size)
+{
+	void* mappedResource;
+	bool result;
+
+	if (m_bindRanges)
+	{
+		// The range is in 16 byte constants, the offset and size are in bytes.
+		deviceContext->VSSetConstantBufferRange(slot, m_frameBuffer, offset / 16, size / 16);
+		return true;
+	}
+
+	if (slot < 0 || slot >= CONSTANT_ALLOCATOR_SLOTS)
+	{
+		return false;
+	}
+
+	if (size > m_slotSizes[slot])
+	{
+		result = CreateSlotBuffer(slot, size);
+		if (!result)
+		{
+			return false;
+		}
+	}
+
+	result = deviceContext->Map(m_slotBuffers[slot], &mappedResource);
+	if (!result)
+	{
+		return false;
+	}
+
+	memcpy(mappedResource, &m_slices[offset], size);
+
+	deviceContext->Unmap(m_slotBuffers[slot]);
+
+	deviceContext->VSSetConstantBuffers(slot, 1, &m_slotBuffers[slot]);
+
+	return true;
+}
+
+/*BindsRanges tells if slices are bound as ranges of one buffer, which works on deferred contexts as well.*/
+bool ConstantAllocatorClass::BindsRanges()
+{
+	return m_bindRanges;
+}
+
+/*GetUsedSize returns how many bytes this frame allocated so far.*/
+unsigned int ConstantAllocatorClass::GetUsedSize()
+{
+	return m_used;
+}
+
+unsigned int ConstantAllocatorClass::GetCapacity()
+{
+	return m_capacity;
+}
+
+/*CreateFrameBuffer (re)creates the dynamic constant buffer of the frame with room for at least capacity bytes.*/
+bool ConstantAllocatorClass::CreateFrameBuffer(unsigned int capacity)
+{
+	bool result;
+
+	capacity = (capacity + CONSTANT_SLICE_SIZE - 1) & ~(CONSTANT_SLICE_SIZE - 1);
+	if (capacity == 0)
+	{
+		capacity = CONSTANT_SLICE_SIZE;
+	}
+
+	// Release the old buffer first.
+	if (m_frameBuffer)
+	{
+		m_device->ReleaseBuffer(m_frameBuffer);
+		m_frameBuffer = 0;
+	}
+
+	result = m_device->CreateBuffer(RENDER_CONSTANT_BUFFER, RENDER_USAGE_DYNAMIC, capacity, NULL, m_frameBuffer);
+	if (!result)
+	{
+		m_capacity = 0;
+		return false;
+	}
+
+	m_capacity = capacity;
+
+	if ((unsigned int)m_slices.size() < capacity)
+	{
+		m_slices.resize(capacity);
+	}
+
+	return true;
+}
+
+/*CreateSlotBuffer (re)creates the dynamic constant buffer of a slot with room for size bytes.*/
+bool ConstantAllocatorClass::CreateSlotBuffer(int slot, unsigned int size)
+{
+	bool result;
+
+	if (m_slotBuffers[slot])
+	{
+		m_device->ReleaseBuffer(m_slotBuffers[slot]);
+		m_slotBuffers[slot] = 0;
+	}
+
+	result = m_device->CreateBuffer(RENDER_CONSTANT_BUFFER, RENDER_USAGE_DYNAMIC, size, NULL, m_slotBuffers[slot]);
+	if (!result)
+	{
+		m_slotSizes[slot] = 0;
+		return false;
+	}
+
+	m_slotSizes[slot] = size;
+
+	return true;
+}
@@ -0,0 +1,76 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: constantallocatorclass.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _CONSTANTALLOCATORCLASS_H_
+#define _CONSTANTALLOCATORCLASS_H_
+
+
+//////////////
+// INCLUDES //
+//////////////
+#include <vector>
+#include "renderdeviceclass.h"
+using namespace std;
+
+
+/////////////
+// GLOBALS //
+/////////////
+/*Constant buffer ranges have to start on a multiple of 16 constants (256 bytes) and be a multiple of 16 constants
+long, so everything is handed out in slices of this size.*/
+const unsigned int CONSTANT_SLICE_SIZE = 256;
+/*The number of vertex shader slots BindSlice binds to, the same as RENDER_COMMAND_CONSTANT_BUFFERS.*/
+const int CONSTANT_ALLOCATOR_SLOTS = 2;
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: ConstantAllocatorClass
+////////////////////////////////////////////////////////////////////////////////
+/*The ConstantAllocatorClass is a linear allocator for the shader constants of one frame. Allocate hands out 256 byte
+slices one after the other from a CPU copy, BeginFrame starts over at the front, and Upload copies everything that was
+handed out into one big dynamic constant buffer with a single Map/Unmap, so a frame with thousands of objects maps once
+instead of once per draw. Each draw then binds its slice with BindSlice.
+
+The pointer Allocate returns points into the CPU copy, which grows when a frame needs more, so it is only good until
+the next Allocate; fill a slice right away. The offset stays good until the next BeginFrame. When the frame needs more
+than the buffer holds, Upload makes the buffer bigger before copying, so the buffer handle can change too.
+
+Binding at an offset needs the Direct3D 11.1 runtime. When the device doesn't support it, Upload leaves the big buffer
+alone and BindSlice copies each slice into a plain constant buffer of the slot with Map(WRITE_DISCARD) right before the
+draw, the way constants were updated before there was one buffer for the frame. That also means every bind has to go
+to the immediate context, see RenderQueueClass::ExecuteParallel.*/
+class ConstantAllocatorClass
+{
+public:
+	ConstantAllocatorClass();
+	ConstantAllocatorClass(const ConstantAllocatorClass&);
+	~ConstantAllocatorClass();
+
+	bool Initialize(RenderDeviceClass*, unsigned int);
+	void Shutdown();
+
+	void BeginFrame();
+	void* Allocate(unsigned int, unsigned int&, unsigned int&);
+	bool Upload(RenderContextClass*);
+	bool BindSlice(RenderContextClass*, int, unsigned int, unsigned int);
+
+	bool BindsRanges();
+	unsigned int GetUsedSize();
+	unsigned int GetCapacity();
+
+private:
+	bool CreateFrameBuffer(unsigned int);
+	bool CreateSlotBuffer(int, unsigned int);
+
+private:
+	RenderDeviceClass* m_device;
+	RenderBuffer m_frameBuffer;
+	unsigned int m_capacity;
+	unsigned int m_used;
+	vector<char> m_slices;
+	bool m_bindRanges;
+	RenderBuffer m_slotBuffers[CONSTANT_ALLOCATOR_SLOTS];
+	unsigned int m_slotSizes[CONSTANT_ALLOCATOR_SLOTS];
+};
+
+#endif
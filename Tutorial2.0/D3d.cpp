@@ -2,6 +2,9 @@
 // Filename: d3dclass.cpp
 //////////////////////////////
 #include "D3d.h"
+#include "profilerclass.h"
+#include <d3dcompiler.h>
+#include <d3d11shader.h>
 
 /*So like most classes we begin with initializing all the member pointers to null
 in the class constructor. All pointers from the header file have all been accounted
@@ -17,6 +20,12 @@ D3d::D3d()
 	m_depthStencilState = 0;
 	m_depthStencilView = 0;
 	m_rasterState = 0;
+	ZeroMemory(&m_viewport, sizeof(m_viewport));
+	m_context = 0;
+	ZeroMemory(m_frameQueries, sizeof(m_frameQueries));
+	m_presentedFrames = 0;
+	m_completedFrames = 0;
+	m_constantBufferOffsets = false;
 }
 
 D3d::D3d(const D3d& other)
@@ -46,6 +55,8 @@ render according to the users monitor refresh rate or to just go as fast as poss
 // https://msdn.microsoft.com/en-us/library/windows/desktop/bb205075(v=vs.85).aspx
 bool D3d::Initialize(int screenWidth, int screenHeight, bool vsync, HWND hwnd, bool fullscreen, float screenDepth, float screenNear)
 {
+	PROFILE_FUNCTION();
+
 	HRESULT result; // A 32-bit value that is used to describe an error or warning.
 	IDXGIFactory* factory; // CreateSoftwareAdapter, CreateSwapChain, EnumAdapters, GetWindowAssociation, MakeWindowAssociation
 	IDXGIAdapter* adapter; /*This could simply be described as the virtutal representation of the video card (assuming the video card is separate, and not built into the motherboard).*/
@@ -63,7 +74,10 @@ bool D3d::Initialize(int screenWidth, int screenHeight, bool vsync, HWND hwnd, b
 	D3D11_DEPTH_STENCIL_VIEW_DESC depthStencilViewDesc;
 	D3D11_RASTERIZER_DESC rasterDesc;
 	D3D11_VIEWPORT viewport;
+	D3D11_FEATURE_DATA_D3D11_OPTIONS options;
+	D3D11_QUERY_DESC queryDesc;
 	float fieldOfView, screenAspect;
+	bool contextResult;
 
 	// Storr the csync settings.
 	m_vsync_enabled = vsync;
@@ -203,8 +217,10 @@ bool D3d::Initialize(int screenWidth, int screenHeight, bool vsync, HWND hwnd, b
 	// Initialize the swap chain description.
 	ZeroMemory(&swapChainDesc, sizeof(swapChainDesc));
 
-	// Set to a single back buffer. The number of back buffers to use in the swap chain; we usually only use one back buffer for double buffering, although you could use two for triple buffering. 
-	swapChainDesc.BufferCount = 1;
+	// The number of back buffers to use in the swap chain; one back buffer is double buffering and two is triple buffering.
+	// With two the GPU can draw the next frame while the last one waits for the vsync, how far the CPU may run ahead
+	// of the screen is up to the FramePacerClass.
+	swapChainDesc.BufferCount = 2;
 
 	// Set the width and height of the back buffer, resolutie of de backbuffer, in pixels, het zelde afmeting als de window
 	// als je allebei op 0 doet pakt die de window size maar beter is om het toch te setten
@@ -482,6 +498,29 @@ bool D3d::Initialize(int screenWidth, int screenHeight, bool vsync, HWND hwnd, b
 	// Bind the render target view and depth stencil buffer to the output render pipeline.
 	m_deviceContext->OMSetRenderTargets(1, &m_renderTargetView, m_depthStencilView);
 
+	/*The shader constants of a whole frame live in one big constant buffer and every draw binds its own part of it
+	(see ConstantAllocatorClass), as long as the driver supports binding a constant buffer at an offset. That comes with
+	the Direct3D 11.1 runtime; without it the constants are copied into a buffer of their own for every draw instead. */
+	// Check if constant buffers can be bound at an offset.
+	ZeroMemory(&options, sizeof(options));
+	result = m_device->CheckFeatureSupport(D3D11_FEATURE_D3D11_OPTIONS, &options, sizeof(options));
+	m_constantBufferOffsets = SUCCEEDED(result) && options.ConstantBufferOffsetting;
+
+	/*Everything else in the engine draws through the RenderContextClass interface, so wrap the immediate
+	context together with the views it clears into a D3dContextClass. */
+	// Create the render context wrapper.
+	m_context = new D3dContextClass;
+	if (!m_context)
+	{
+		return false;
+	}
+
+	contextResult = m_context->Initialize(m_deviceContext, m_renderTargetView, m_depthStencilView);
+	if (!contextResult)
+	{
+		return false;
+	}
+
 	/*Now that the render targets are setup we can continue on to some extra functions
 	that will give us more control over our scenes for future tutorials. First thing
 	is we'll create is a rasterizer state. This will give us control over how polygons
@@ -525,6 +564,24 @@ bool D3d::Initialize(int screenWidth, int screenHeight, bool vsync, HWND hwnd, b
 	// Create the viewport.
 	m_deviceContext->RSSetViewports(1, &viewport);
 
+	// Deferred contexts start without any state, they set this viewport up again themselves.
+	m_viewport = viewport;
+
+	// EndScene ends every frame with an event query, GetCompletedFrames sees the GPU finished the frame once it is done.
+	queryDesc.Query = D3D11_QUERY_EVENT;
+	queryDesc.MiscFlags = 0;
+	for (i = 0; i < FRAME_QUERY_COUNT; i++)
+	{
+		result = m_device->CreateQuery(&queryDesc, &m_frameQueries[i]);
+		if (FAILED(result))
+		{
+			return false;
+		}
+	}
+	m_presentedFrames = 0;
+	m_completedFrames = 0;
+	m_constantBufferOffsets = false;
+
 	/*Now we will create the projection matrix. The projection matrix is used to
 	translate the 3D scene into the 2D viewport space that we previously created.
 	We will need to keep a copy of this matrix so that we can pass it to our shaders
@@ -575,12 +632,30 @@ down Direct3D. */
 
 void D3d::Shutdown()
 {
+	int i;
+
 	// Before shutting down set to windowed mode or when you release the swap chain it will throw an exception.
 	if (m_swapChain)
 	{
 		m_swapChain->SetFullscreenState(false, NULL);
 	}
 
+	for (i = 0; i < FRAME_QUERY_COUNT; i++)
+	{
+		if (m_frameQueries[i])
+		{
+			m_frameQueries[i]->Release();
+			m_frameQueries[i] = 0;
+		}
+	}
+
+	if (m_context)
+	{
+		m_context->Shutdown();
+		delete m_context;
+		m_context = 0;
+	}
+
 	if (m_rasterState)
 	{
 		m_rasterState->Release();
@@ -641,6 +716,8 @@ completed at the end of each frame. */
 
 void D3d::BeginScene(float red, float green, float blue, float alpha)
 {
+	PROFILE_FUNCTION();
+
 	float color[4];
 
 	// Setup the color to clear the buffer to.
@@ -650,16 +727,37 @@ void D3d::BeginScene(float red, float green, float blue, float alpha)
 	color[3] = alpha;
 
 	// Clear the back buffer.
-	m_deviceContext->ClearRenderTargetView(m_renderTargetView, color);
+	m_context->ClearRenderTarget(color);
 
 	// Clear the depth buffer.
-	m_deviceContext->ClearDepthStencilView(m_depthStencilView, D3D11_CLEAR_DEPTH, 1.0f, 0);
+	m_context->ClearDepthStencil(1.0f);
 
 	return;
 }
 
 void D3d::EndScene()
 {
+	PROFILE_FUNCTION();
+
+	ID3D11Query* query;
+
+	// Mark the end of the frame. The query of the frame that many frames ago has to be done before it is used again.
+	// The frame pacer keeps fewer frames than that in flight, so this only waits when nothing paces the frames. It sleeps
+	// instead of spinning, the GPU is many frames behind then anyway. The query is ended before Present so the present
+	// flushes it to the GPU with the rest of the frame, GetCompletedFrames never flushes and would otherwise wait on a
+	// query that is still sitting in the command buffer.
+	query = m_frameQueries[m_presentedFrames % FRAME_QUERY_COUNT];
+	if (m_presentedFrames - GetCompletedFrames() >= FRAME_QUERY_COUNT)
+	{
+		while (m_deviceContext->GetData(query, NULL, 0, 0) == S_FALSE)
+		{
+			Sleep(1);
+		}
+		m_completedFrames++;
+	}
+	m_deviceContext->End(query);
+	m_presentedFrames++;
+
 	// Present the back buffer to the screen since rendering is complete.
 	if (m_vsync_enabled)
 	{
@@ -675,6 +773,28 @@ void D3d::EndScene()
 	return;
 }
 
+/*GetCompletedFrames looks at the queries of the frames in flight, oldest first, without flushing anything to the GPU.
+The GPU finishes the frames in order so it stops at the first one that isn't done.*/
+unsigned long long D3d::GetCompletedFrames()
+{
+	while (m_completedFrames < m_presentedFrames)
+	{
+		if (m_deviceContext->GetData(m_frameQueries[m_completedFrames % FRAME_QUERY_COUNT], NULL, 0, D3D11_ASYNC_GETDATA_DONOTFLUSH) != S_OK)
+		{
+			break;
+		}
+		m_completedFrames++;
+	}
+
+	return m_completedFrames;
+}
+
+/*SupportsConstantBufferOffsets returns what Initialize found out about binding constant buffers at an offset.*/
+bool D3d::SupportsConstantBufferOffsets()
+{
+	return m_constantBufferOffsets;
+}
+
 /*These next functions simply get pointers to the Direct3D device and the Direct3D
 device context. These helper functions will be called by the framework often. */
 
@@ -689,6 +809,12 @@ ID3D11DeviceContext* D3d::GetDeviceContext()
 	return m_deviceContext;
 }
 
+
+RenderContextClass* D3d::GetContext()
+{
+	return m_context;
+}
+
 /*The next three helper functions give copies of the projection, world, and
 orthographic matrices to calling functions. Most shaders will need these matrices
 for rendering so there needed to be an easy way for outside objects to get a copy
@@ -726,6 +852,470 @@ void D3d::GetVideoCardInfo(char* cardName, int& memory)
 	return;
 }
 
+/*The remaining functions are the resource side of the RenderDeviceClass interface. They do exactly what
+ModelClass and ColorShaderClass used to do with the ID3D11Device themselves, the handles we return are the
+D3D interfaces cast to the opaque render handle types. */
+
+bool D3d::CreateBuffer(RenderBufferKind kind, RenderUsage usage, unsigned int byteWidth, const void* initialData, RenderBuffer& buffer)
+{
+	D3D11_BUFFER_DESC bufferDesc;
+	D3D11_SUBRESOURCE_DATA bufferData;
+	ID3D11Buffer* d3dBuffer;
+	HRESULT result;
+
+	// Set up the description of the buffer.
+	bufferDesc.ByteWidth = byteWidth;
+	bufferDesc.MiscFlags = 0;
+	bufferDesc.StructureByteStride = 0;
+
+	switch (kind)
+	{
+	case RENDER_VERTEX_BUFFER:
+		bufferDesc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+		break;
+	case RENDER_INDEX_BUFFER:
+		bufferDesc.BindFlags = D3D11_BIND_INDEX_BUFFER;
+		break;
+	default:
+		bufferDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+		break;
+	}
+
+	// Dynamic buffers are written by the CPU every frame, default ones only once at creation.
+	if (usage == RENDER_USAGE_DYNAMIC)
+	{
+		bufferDesc.Usage = D3D11_USAGE_DYNAMIC;
+		bufferDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+	}
+	else
+	{
+		bufferDesc.Usage = D3D11_USAGE_DEFAULT;
+		bufferDesc.CPUAccessFlags = 0;
+	}
+
+	// Give the subresource structure a pointer to the initial data, if there is any.
+	bufferData.pSysMem = initialData;
+	bufferData.SysMemPitch = 0;
+	bufferData.SysMemSlicePitch = 0;
+
+	result = m_device->CreateBuffer(&bufferDesc, initialData ? &bufferData : NULL, &d3dBuffer);
+	if (FAILED(result))
+	{
+		return false;
+	}
+
+	buffer = (RenderBuffer)d3dBuffer;
+
+	return true;
+}
+
+
+void D3d::ReleaseBuffer(RenderBuffer buffer)
+{
+	if (buffer)
+	{
+		((ID3D11Buffer*)buffer)->Release();
+	}
+
+	return;
+}
+
+/*CreateTexture creates an immutable texture with all its mip levels and a shader resource view of it. The handle we
+hand out is the view, it holds on to the texture so we can let go of our own reference to it right away. */
+bool D3d::CreateTexture(unsigned int width, unsigned int height, unsigned int mipCount, RenderFormat format,
+	const RenderTextureData* levels, RenderTexture& texture)
+{
+	D3D11_TEXTURE2D_DESC textureDesc;
+	D3D11_SHADER_RESOURCE_VIEW_DESC viewDesc;
+	std::vector<D3D11_SUBRESOURCE_DATA> levelData;
+	ID3D11Texture2D* d3dTexture;
+	ID3D11ShaderResourceView* view;
+	unsigned int i;
+	HRESULT result;
+
+	// Set up the description of the texture, it never changes after it is created.
+	textureDesc.Width = width;
+	textureDesc.Height = height;
+	textureDesc.MipLevels = mipCount;
+	textureDesc.ArraySize = 1;
+	textureDesc.Format = D3dContextClass::ToDxgiFormat(format);
+	textureDesc.SampleDesc.Count = 1;
+	textureDesc.SampleDesc.Quality = 0;
+	textureDesc.Usage = D3D11_USAGE_IMMUTABLE;
+	textureDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+	textureDesc.CPUAccessFlags = 0;
+	textureDesc.MiscFlags = 0;
+
+	levelData.resize(mipCount);
+	for (i = 0; i < mipCount; i++)
+	{
+		levelData[i].pSysMem = levels[i].data;
+		levelData[i].SysMemPitch = levels[i].rowPitch;
+		levelData[i].SysMemSlicePitch = 0;
+	}
+
+	result = m_device->CreateTexture2D(&textureDesc, &levelData[0], &d3dTexture);
+	if (FAILED(result))
+	{
+		return false;
+	}
+
+	// The view sees every mip level of the texture.
+	viewDesc.Format = textureDesc.Format;
+	viewDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
+	viewDesc.Texture2D.MostDetailedMip = 0;
+	viewDesc.Texture2D.MipLevels = mipCount;
+
+	result = m_device->CreateShaderResourceView(d3dTexture, &viewDesc, &view);
+	d3dTexture->Release();
+	d3dTexture = 0;
+	if (FAILED(result))
+	{
+		return false;
+	}
+
+	texture = (RenderTexture)view;
+
+	return true;
+}
+
+
+void D3d::ReleaseTexture(RenderTexture texture)
+{
+	if (texture)
+	{
+		((ID3D11ShaderResourceView*)texture)->Release();
+	}
+
+	return;
+}
+
+/*CompileShader wraps D3DCompileFromFile. When compilation fails the compiler output is copied into the error
+string, when there is no output at all the file could not be found and the error string is left empty. The defines
+are copied into the D3D_SHADER_MACRO list the compiler wants, with the same null entry at the end. Includes are looked
+up next to the file that includes them. */
+bool D3d::CompileShader(const WCHAR* filename, const char* entryPoint, const char* profile, const RenderShaderDefine* defines,
+	std::vector<char>& bytecode, std::string& errors)
+{
+	HRESULT result;
+	ID3D10Blob* shaderBuffer;
+	ID3D10Blob* errorMessage;
+	std::vector<D3D_SHADER_MACRO> macros;
+	D3D_SHADER_MACRO macro;
+	unsigned int i;
+
+	shaderBuffer = 0;
+	errorMessage = 0;
+	errors.clear();
+
+	for (i = 0; defines && defines[i].Name; i++)
+	{
+		macro.Name = defines[i].Name;
+		macro.Definition = defines[i].Definition;
+		macros.push_back(macro);
+	}
+	macro.Name = NULL;
+	macro.Definition = NULL;
+	macros.push_back(macro);
+
+	result = D3DCompileFromFile(filename, &macros[0], D3D_COMPILE_STANDARD_FILE_INCLUDE, entryPoint, profile, D3D10_SHADER_ENABLE_STRICTNESS, 0, &shaderBuffer, &errorMessage);
+	if (FAILED(result))
+	{
+		if (errorMessage)
+		{
+			errors.assign((char*)errorMessage->GetBufferPointer(), errorMessage->GetBufferSize());
+			errorMessage->Release();
+			errorMessage = 0;
+		}
+		return false;
+	}
+
+	// Copy the bytecode out of the blob so the caller doesn't have to deal with COM objects.
+	bytecode.assign((char*)shaderBuffer->GetBufferPointer(), (char*)shaderBuffer->GetBufferPointer() + shaderBuffer->GetBufferSize());
+
+	shaderBuffer->Release();
+	shaderBuffer = 0;
+
+	if (errorMessage)
+	{
+		errorMessage->Release();
+		errorMessage = 0;
+	}
+
+	return true;
+}
+
+/*ReflectShader copies what ID3D11ShaderReflection knows about the constant buffers and vertex inputs out of the
+bytecode. Texture buffers show up as constant buffers too and are skipped. The mask of an input has a bit for every
+component it uses, x first, so the highest bit set is the number of components.*/
+bool D3d::ReflectShader(const void* bytecode, size_t bytecodeLength, RenderShaderReflection& reflection)
+{
+	HRESULT result;
+	ID3D11ShaderReflection* reflector;
+	ID3D11ShaderReflectionConstantBuffer* constantBuffer;
+	ID3D11ShaderReflectionVariable* variable;
+	D3D11_SHADER_DESC shaderDesc;
+	D3D11_SHADER_BUFFER_DESC bufferDesc;
+	D3D11_SHADER_VARIABLE_DESC variableDesc;
+	D3D11_SHADER_INPUT_BIND_DESC bindDesc;
+	D3D11_SIGNATURE_PARAMETER_DESC parameterDesc;
+	RenderShaderConstantBuffer buffer;
+	RenderShaderVariable bufferVariable;
+	RenderShaderInput input;
+	unsigned int i, j;
+
+	reflection.constantBuffers.clear();
+	reflection.inputs.clear();
+
+	result = D3DReflect(bytecode, bytecodeLength, IID_ID3D11ShaderReflection, (void**)&reflector);
+	if (FAILED(result))
+	{
+		return false;
+	}
+
+	reflector->GetDesc(&shaderDesc);
+
+	for (i = 0; i < shaderDesc.ConstantBuffers; i++)
+	{
+		constantBuffer = reflector->GetConstantBufferByIndex(i);
+		constantBuffer->GetDesc(&bufferDesc);
+		if (bufferDesc.Type != D3D_CT_CBUFFER)
+		{
+			continue;
+		}
+
+		result = reflector->GetResourceBindingDescByName(bufferDesc.Name, &bindDesc);
+		if (FAILED(result))
+		{
+			reflector->Release();
+			return false;
+		}
+
+		buffer.name = bufferDesc.Name;
+		buffer.slot = bindDesc.BindPoint;
+		buffer.size = bufferDesc.Size;
+		buffer.variables.clear();
+		for (j = 0; j < bufferDesc.Variables; j++)
+		{
+			variable = constantBuffer->GetVariableByIndex(j);
+			variable->GetDesc(&variableDesc);
+
+			bufferVariable.name = variableDesc.Name;
+			bufferVariable.offset = variableDesc.StartOffset;
+			bufferVariable.size = variableDesc.Size;
+			buffer.variables.push_back(bufferVariable);
+		}
+		reflection.constantBuffers.push_back(buffer);
+	}
+
+	for (i = 0; i < shaderDesc.InputParameters; i++)
+	{
+		reflector->GetInputParameterDesc(i, &parameterDesc);
+		if (parameterDesc.SystemValueType != D3D_NAME_UNDEFINED)
+		{
+			continue;
+		}
+
+		input.semanticName = parameterDesc.SemanticName;
+		input.semanticIndex = parameterDesc.SemanticIndex;
+		input.componentCount = (parameterDesc.Mask & 8) ? 4 : (parameterDesc.Mask & 4) ? 3 : (parameterDesc.Mask & 2) ? 2 : 1;
+		switch (parameterDesc.ComponentType)
+		{
+		case D3D_REGISTER_COMPONENT_UINT32:
+			input.componentType = RENDER_COMPONENT_UINT32;
+			break;
+		case D3D_REGISTER_COMPONENT_SINT32:
+			input.componentType = RENDER_COMPONENT_SINT32;
+			break;
+		case D3D_REGISTER_COMPONENT_FLOAT32:
+			input.componentType = RENDER_COMPONENT_FLOAT32;
+			break;
+		default:
+			input.componentType = RENDER_COMPONENT_UNKNOWN;
+			break;
+		}
+		reflection.inputs.push_back(input);
+	}
+
+	reflector->Release();
+	reflector = 0;
+
+	return true;
+}
+
+/*The compiler is the d3dcompiler DLL we link against, with the flags CompileShader passes it.*/
+const char* D3d::GetShaderCompiler()
+{
+	return D3DCOMPILER_DLL_A " D3D10_SHADER_ENABLE_STRICTNESS";
+}
+
+
+bool D3d::CreateVertexShader(const void* bytecode, size_t bytecodeLength, RenderVertexShader& shader)
+{
+	ID3D11VertexShader* vertexShader;
+	HRESULT result;
+
+	result = m_device->CreateVertexShader(bytecode, bytecodeLength, NULL, &vertexShader);
+	if (FAILED(result))
+	{
+		return false;
+	}
+
+	shader = (RenderVertexShader)vertexShader;
+
+	return true;
+}
+
+
+bool D3d::CreatePixelShader(const void* bytecode, size_t bytecodeLength, RenderPixelShader& shader)
+{
+	ID3D11PixelShader* pixelShader;
+	HRESULT result;
+
+	result = m_device->CreatePixelShader(bytecode, bytecodeLength, NULL, &pixelShader);
+	if (FAILED(result))
+	{
+		return false;
+	}
+
+	shader = (RenderPixelShader)pixelShader;
+
+	return true;
+}
+
+/*CreateInputLayout copies our element descriptions into D3D11_INPUT_ELEMENT_DESC structures. The two are field
+for field the same, only the enumerations need translating. */
+bool D3d::CreateInputLayout(const RenderInputElement* elements, unsigned int numElements, const void* bytecode, size_t bytecodeLength, RenderInputLayout& layout)
+{
+	D3D11_INPUT_ELEMENT_DESC* polygonLayout;
+	ID3D11InputLayout* inputLayout;
+	unsigned int i;
+	HRESULT result;
+
+	polygonLayout = new D3D11_INPUT_ELEMENT_DESC[numElements];
+	if (!polygonLayout)
+	{
+		return false;
+	}
+
+	for (i = 0; i < numElements; i++)
+	{
+		polygonLayout[i].SemanticName = elements[i].SemanticName;
+		polygonLayout[i].SemanticIndex = elements[i].SemanticIndex;
+		polygonLayout[i].Format = D3dContextClass::ToDxgiFormat(elements[i].Format);
+		polygonLayout[i].InputSlot = elements[i].InputSlot;
+		polygonLayout[i].AlignedByteOffset = elements[i].AlignedByteOffset == RENDER_APPEND_ALIGNED_ELEMENT ? D3D11_APPEND_ALIGNED_ELEMENT : elements[i].AlignedByteOffset;
+		polygonLayout[i].InputSlotClass = elements[i].InputSlotClass == RENDER_INPUT_PER_INSTANCE_DATA ? D3D11_INPUT_PER_INSTANCE_DATA : D3D11_INPUT_PER_VERTEX_DATA;
+		polygonLayout[i].InstanceDataStepRate = elements[i].InstanceDataStepRate;
+	}
+
+	result = m_device->CreateInputLayout(polygonLayout, numElements, bytecode, bytecodeLength, &inputLayout);
+
+	delete[] polygonLayout;
+	polygonLayout = 0;
+
+	if (FAILED(result))
+	{
+		return false;
+	}
+
+	layout = (RenderInputLayout)inputLayout;
+
+	return true;
+}
+
+
+void D3d::ReleaseVertexShader(RenderVertexShader shader)
+{
+	if (shader)
+	{
+		((ID3D11VertexShader*)shader)->Release();
+	}
+
+	return;
+}
+
+
+void D3d::ReleasePixelShader(RenderPixelShader shader)
+{
+	if (shader)
+	{
+		((ID3D11PixelShader*)shader)->Release();
+	}
+
+	return;
+}
+
+
+void D3d::ReleaseInputLayout(RenderInputLayout layout)
+{
+	if (layout)
+	{
+		((ID3D11InputLayout*)layout)->Release();
+	}
+
+	return;
+}
+
+/*A deferred context is an ID3D11DeviceContext of its own that only records. The D3dContextClass wrapping it owns it
+and sets the render target, depth stencil state, rasterizer state and viewport of the frame on it for every command list.*/
+bool D3d::CreateDeferredContext(RenderContextClass*& context)
+{
+	ID3D11DeviceContext* deviceContext;
+	D3dContextClass* d3dContext;
+	HRESULT result;
+	bool contextResult;
+
+	result = m_device->CreateDeferredContext(0, &deviceContext);
+	if (FAILED(result))
+	{
+		return false;
+	}
+
+	d3dContext = new D3dContextClass;
+	if (!d3dContext)
+	{
+		deviceContext->Release();
+		return false;
+	}
+
+	contextResult = d3dContext->InitializeDeferred(deviceContext, m_renderTargetView, m_depthStencilView, m_depthStencilState, m_rasterState, m_viewport);
+	if (!contextResult)
+	{
+		d3dContext->Shutdown();
+		delete d3dContext;
+		return false;
+	}
+
+	context = d3dContext;
+
+	return true;
+}
+
+void D3d::ReleaseDeferredContext(RenderContextClass* context)
+{
+	D3dContextClass* d3dContext;
+
+	if (context)
+	{
+		d3dContext = (D3dContextClass*)context;
+		d3dContext->Shutdown();
+		delete d3dContext;
+	}
+
+	return;
+}
+
+void D3d::ReleaseCommandList(RenderCommandList commandList)
+{
+	if (commandList)
+	{
+		((ID3D11CommandList*)commandList)->Release();
+	}
+
+	return;
+}
+
 /*So now we are finally able to initialize and shut down Direct3D.
 Compiling and running the code will produce the same window as the
 last tutorial but Direct3D is initialized now and it clears the window to a grey color.
@@ -18,6 +18,7 @@ compiling shaders which we will cover in the next tutorial. */
 #pragma comment(lib, "d3d11.lib")
 #pragma comment(lib, "dxgi.lib")
 #pragma comment(lib, "d3dcompiler.lib")
+#pragma comment(lib, "dxguid.lib")
 
 /*The next thing we do is include the headers for those libraries that we are linking to
 this object module as well as headers for DirectX type definitions and math functionality. */
@@ -27,8 +28,17 @@ this object module as well as headers for DirectX type definitions and math func
 ///////////
 #include <d3d11.h>
 #include <DirectXMath.h>
+#include "renderdeviceclass.h"
+#include "d3dcontextclass.h"
 using namespace DirectX;
 
+//////////
+// GLOBALS //
+//////////
+/*How many presented frames the D3d class can follow until the GPU finished them. When the GPU is this far behind
+EndScene waits for the oldest one before it presents another.*/
+const int FRAME_QUERY_COUNT = 16;
+
 /*The class definition for the D3DClass is kept as simple as possible here.
 It has the regular constructor, copy constructor, and destructor.
 Then more importantly it has the Initialize and Shutdown function.
@@ -36,12 +46,14 @@ This will be what we are mainly focused on in this tutorial.
 Other than that I have a couple helper functions which aren't
 important to this tutorial and a number of private member variables that will
 be looked at when we examine the d3dclass.cpp file. For now just realize the
-Initialize and Shutdown functions are what concerns us. */
+Initialize and Shutdown functions are what concerns us.
+D3d is the Direct3D implementation of the RenderDeviceClass, so the rest of the engine
+only ever sees it through that interface (see renderdeviceclass.h). */
 
 ////////////////////
 // Class name: D3DClass
 ///////////////////
-class D3d
+class D3d : public RenderDeviceClass
 {
 public:
 	D3d();
@@ -54,9 +66,12 @@ public:
 
 	void BeginScene(float, float, float, float);
 	void EndScene();
+	unsigned long long GetCompletedFrames();
+	bool SupportsConstantBufferOffsets();
 
 	ID3D11Device* GetDevice();
 	ID3D11DeviceContext* GetDeviceContext();
+	RenderContextClass* GetContext();
 
 	void GetProjectionMatrix(XMMATRIX&);
 	void GetWorldMatrix(XMMATRIX&);
@@ -64,6 +79,26 @@ public:
 
 	void GetVideoCardInfo(char*, int&);
 
+	bool CreateBuffer(RenderBufferKind, RenderUsage, unsigned int, const void*, RenderBuffer&);
+	void ReleaseBuffer(RenderBuffer);
+
+	bool CreateTexture(unsigned int, unsigned int, unsigned int, RenderFormat, const RenderTextureData*, RenderTexture&);
+	void ReleaseTexture(RenderTexture);
+
+	bool CompileShader(const WCHAR*, const char*, const char*, const RenderShaderDefine*, std::vector<char>&, std::string&);
+	bool ReflectShader(const void*, size_t, RenderShaderReflection&);
+	const char* GetShaderCompiler();
+	bool CreateVertexShader(const void*, size_t, RenderVertexShader&);
+	bool CreatePixelShader(const void*, size_t, RenderPixelShader&);
+	bool CreateInputLayout(const RenderInputElement*, unsigned int, const void*, size_t, RenderInputLayout&);
+	void ReleaseVertexShader(RenderVertexShader);
+	void ReleasePixelShader(RenderPixelShader);
+	void ReleaseInputLayout(RenderInputLayout);
+
+	bool CreateDeferredContext(RenderContextClass*&);
+	void ReleaseDeferredContext(RenderContextClass*);
+	void ReleaseCommandList(RenderCommandList);
+
 private:
 	bool m_vsync_enabled;
 	int m_videoCardMemory;
@@ -76,6 +111,12 @@ private:
 	ID3D11DepthStencilState* m_depthStencilState;
 	ID3D11DepthStencilView* m_depthStencilView;
 	ID3D11RasterizerState* m_rasterState;
+	D3D11_VIEWPORT m_viewport;
+	D3dContextClass* m_context;
+	ID3D11Query* m_frameQueries[FRAME_QUERY_COUNT];
+	unsigned long long m_presentedFrames;
+	unsigned long long m_completedFrames;
+	bool m_constantBufferOffsets;
 	XMMATRIX m_projectionMatrix;
 	XMMATRIX m_worldMatrix;
 	XMMATRIX m_orthoMatrix;
@@ -0,0 +1,274 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: d3dcontextclass.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "d3dcontextclass.h"
+
+D3dContextClass::D3dContextClass()
+{
+	m_deviceContext = 0;
+	m_deviceContext1 = 0;
+	m_renderTargetView = 0;
+	m_depthStencilView = 0;
+	m_deferred = false;
+	m_depthStencilState = 0;
+	m_rasterState = 0;
+	ZeroMemory(&m_viewport, sizeof(m_viewport));
+}
+
+D3dContextClass::D3dContextClass(const D3dContextClass& other)
+{
+}
+
+D3dContextClass::~D3dContextClass()
+{
+}
+
+/*The context does not own any of these interfaces, the D3d class creates and releases them. We only keep copies of the pointers.
+The ID3D11DeviceContext1 interface is the exception, QueryInterface adds a reference that Shutdown releases again. It is
+missing on systems without the Direct3D 11.1 runtime, and then the context can't be used.*/
+bool D3dContextClass::Initialize(ID3D11DeviceContext* deviceContext, ID3D11RenderTargetView* renderTargetView, ID3D11DepthStencilView* depthStencilView)
+{
+	HRESULT result;
+
+	m_deviceContext = deviceContext;
+	m_renderTargetView = renderTargetView;
+	m_depthStencilView = depthStencilView;
+
+	result = m_deviceContext->QueryInterface(__uuidof(ID3D11DeviceContext1), (void**)&m_deviceContext1);
+	if (FAILED(result))
+	{
+		m_deviceContext1 = 0;
+		return false;
+	}
+
+	return true;
+}
+
+/*InitializeDeferred takes over the reference of a deferred context the D3d class just created, Shutdown releases it.
+The states and views still belong to the D3d class.*/
+bool D3dContextClass::InitializeDeferred(ID3D11DeviceContext* deviceContext, ID3D11RenderTargetView* renderTargetView, ID3D11DepthStencilView* depthStencilView,
+	ID3D11DepthStencilState* depthStencilState, ID3D11RasterizerState* rasterState, const D3D11_VIEWPORT& viewport)
+{
+	bool result;
+
+	m_deferred = true;
+	m_depthStencilState = depthStencilState;
+	m_rasterState = rasterState;
+	m_viewport = viewport;
+
+	result = Initialize(deviceContext, renderTargetView, depthStencilView);
+	if (!result)
+	{
+		return false;
+	}
+
+	SetFrameState();
+
+	return true;
+}
+
+void D3dContextClass::Shutdown()
+{
+	if (m_deviceContext1)
+	{
+		m_deviceContext1->Release();
+		m_deviceContext1 = 0;
+	}
+
+	if (m_deferred && m_deviceContext)
+	{
+		m_deviceContext->Release();
+	}
+
+	m_deviceContext = 0;
+	m_renderTargetView = 0;
+	m_depthStencilView = 0;
+	m_deferred = false;
+	m_depthStencilState = 0;
+	m_rasterState = 0;
+
+	return;
+}
+
+void D3dContextClass::ClearRenderTarget(const float color[4])
+{
+	// Clear the back buffer.
+	m_deviceContext->ClearRenderTargetView(m_renderTargetView, color);
+
+	return;
+}
+
+void D3dContextClass::ClearDepthStencil(float depth)
+{
+	// Clear the depth buffer.
+	m_deviceContext->ClearDepthStencilView(m_depthStencilView, D3D11_CLEAR_DEPTH, depth, 0);
+
+	return;
+}
+
+/*Map always locks with D3D11_MAP_WRITE_DISCARD, that is the only way the engine writes to dynamic buffers.*/
+bool D3dContextClass::Map(RenderBuffer buffer, void** data)
+{
+	HRESULT result;
+	D3D11_MAPPED_SUBRESOURCE mappedResource;
+
+	result = m_deviceContext->Map((ID3D11Buffer*)buffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedResource);
+	if (FAILED(result))
+	{
+		return false;
+	}
+
+	*data = mappedResource.pData;
+
+	return true;
+}
+
+void D3dContextClass::Unmap(RenderBuffer buffer)
+{
+	m_deviceContext->Unmap((ID3D11Buffer*)buffer, 0);
+
+	return;
+}
+
+/*The render handles are the D3D interfaces themselves, so an array of handles can be handed to Direct3D as an array of buffers.*/
+void D3dContextClass::IASetVertexBuffers(unsigned int startSlot, unsigned int numBuffers, RenderBuffer* buffers, unsigned int* strides, unsigned int* offsets)
+{
+	m_deviceContext->IASetVertexBuffers(startSlot, numBuffers, (ID3D11Buffer* const*)buffers, strides, offsets);
+
+	return;
+}
+
+void D3dContextClass::IASetIndexBuffer(RenderBuffer buffer, RenderFormat format, unsigned int offset)
+{
+	m_deviceContext->IASetIndexBuffer((ID3D11Buffer*)buffer, ToDxgiFormat(format), offset);
+
+	return;
+}
+
+void D3dContextClass::IASetPrimitiveTopology(RenderTopology topology)
+{
+	// Triangle lists are the only topology the engine draws with so far.
+	m_deviceContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+
+	return;
+}
+
+void D3dContextClass::IASetInputLayout(RenderInputLayout layout)
+{
+	m_deviceContext->IASetInputLayout((ID3D11InputLayout*)layout);
+
+	return;
+}
+
+void D3dContextClass::VSSetShader(RenderVertexShader shader)
+{
+	m_deviceContext->VSSetShader((ID3D11VertexShader*)shader, NULL, 0);
+
+	return;
+}
+
+void D3dContextClass::PSSetShader(RenderPixelShader shader)
+{
+	m_deviceContext->PSSetShader((ID3D11PixelShader*)shader, NULL, 0);
+
+	return;
+}
+
+void D3dContextClass::VSSetConstantBuffers(unsigned int startSlot, unsigned int numBuffers, RenderBuffer* buffers)
+{
+	m_deviceContext->VSSetConstantBuffers(startSlot, numBuffers, (ID3D11Buffer* const*)buffers);
+
+	return;
+}
+
+void D3dContextClass::VSSetConstantBufferRange(unsigned int slot, RenderBuffer buffer, unsigned int firstConstant, unsigned int numConstants)
+{
+	m_deviceContext1->VSSetConstantBuffers1(slot, 1, (ID3D11Buffer* const*)&buffer, &firstConstant, &numConstants);
+
+	return;
+}
+
+void D3dContextClass::DrawIndexed(unsigned int indexCount, unsigned int startIndexLocation, int baseVertexLocation)
+{
+	m_deviceContext->DrawIndexed(indexCount, startIndexLocation, baseVertexLocation);
+
+	return;
+}
+
+void D3dContextClass::DrawIndexedInstanced(unsigned int indexCountPerInstance, unsigned int instanceCount, unsigned int startIndexLocation, int baseVertexLocation, unsigned int startInstanceLocation)
+{
+	m_deviceContext->DrawIndexedInstanced(indexCountPerInstance, instanceCount, startIndexLocation, baseVertexLocation, startInstanceLocation);
+
+	return;
+}
+
+/*FinishCommandList is only valid on a deferred context. The state the list recorded isn't carried over to the next one,
+so the state of the frame is set again right away.*/
+bool D3dContextClass::FinishCommandList(RenderCommandList& commandList)
+{
+	ID3D11CommandList* d3dCommandList;
+	HRESULT result;
+
+	result = m_deviceContext->FinishCommandList(FALSE, &d3dCommandList);
+	if (FAILED(result))
+	{
+		return false;
+	}
+
+	commandList = (RenderCommandList)d3dCommandList;
+
+	SetFrameState();
+
+	return true;
+}
+
+/*ExecuteCommandList restores the state the immediate context had before the list, so what the list bound doesn't leak
+into whatever the immediate context draws next.*/
+void D3dContextClass::ExecuteCommandList(RenderCommandList commandList)
+{
+	m_deviceContext->ExecuteCommandList((ID3D11CommandList*)commandList, TRUE);
+
+	return;
+}
+
+/*ToDxgiFormat translates our own format enumeration into the DXGI one. It is static so the D3d class can use it as well when it builds input layouts.*/
+DXGI_FORMAT D3dContextClass::ToDxgiFormat(RenderFormat format)
+{
+	switch (format)
+	{
+	case RENDER_FORMAT_R32G32B32_FLOAT:
+		return DXGI_FORMAT_R32G32B32_FLOAT;
+	case RENDER_FORMAT_R32G32B32A32_FLOAT:
+		return DXGI_FORMAT_R32G32B32A32_FLOAT;
+	case RENDER_FORMAT_R32_UINT:
+		return DXGI_FORMAT_R32_UINT;
+	case RENDER_FORMAT_R16_UINT:
+		return DXGI_FORMAT_R16_UINT;
+	case RENDER_FORMAT_R16G16B16A16_UNORM:
+		return DXGI_FORMAT_R16G16B16A16_UNORM;
+	case RENDER_FORMAT_R8G8B8A8_UNORM:
+		return DXGI_FORMAT_R8G8B8A8_UNORM;
+	case RENDER_FORMAT_R16G16_SNORM:
+		return DXGI_FORMAT_R16G16_SNORM;
+	case RENDER_FORMAT_BC1_UNORM:
+		return DXGI_FORMAT_BC1_UNORM;
+	case RENDER_FORMAT_BC3_UNORM:
+		return DXGI_FORMAT_BC3_UNORM;
+	case RENDER_FORMAT_BC7_UNORM:
+		return DXGI_FORMAT_BC7_UNORM;
+	default:
+		return DXGI_FORMAT_UNKNOWN;
+	}
+}
+
+/*SetFrameState binds what the D3d class binds once at startup on the immediate context: the back buffer, the depth
+stencil and rasterizer states and the viewport.*/
+void D3dContextClass::SetFrameState()
+{
+	m_deviceContext->OMSetRenderTargets(1, &m_renderTargetView, m_depthStencilView);
+	m_deviceContext->OMSetDepthStencilState(m_depthStencilState, 1);
+	m_deviceContext->RSSetState(m_rasterState);
+	m_deviceContext->RSSetViewports(1, &m_viewport);
+
+	return;
+}
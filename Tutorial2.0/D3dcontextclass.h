@@ -0,0 +1,76 @@
+#pragma once
+////////////////////////////////////////////////////////////////////////////////
+// Filename: d3dcontextclass.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _D3DCONTEXTCLASS_H_
+#define _D3DCONTEXTCLASS_H_
+
+
+//////////////
+// INCLUDES //
+//////////////
+#include <d3d11_1.h>
+#include "renderdeviceclass.h"
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: D3dContextClass
+////////////////////////////////////////////////////////////////////////////////
+/*The D3dContextClass is the Direct3D side of the RenderContextClass. It is a very thin wrapper, every call is
+forwarded to the ID3D11DeviceContext it was given. The render target and depth stencil views are kept here as
+well so the clear calls know what to clear. Binding part of a constant buffer needs the Direct3D 11.1 version of the
+context, so Initialize asks the context for that interface as well.
+
+A deferred context is set up with InitializeDeferred instead. It owns its ID3D11DeviceContext and also keeps the
+states and viewport of the frame, because Direct3D starts every command list of a deferred context with nothing bound.*/
+class D3dContextClass : public RenderContextClass
+{
+public:
+	D3dContextClass();
+	D3dContextClass(const D3dContextClass&);
+	~D3dContextClass();
+
+	bool Initialize(ID3D11DeviceContext*, ID3D11RenderTargetView*, ID3D11DepthStencilView*);
+	bool InitializeDeferred(ID3D11DeviceContext*, ID3D11RenderTargetView*, ID3D11DepthStencilView*, ID3D11DepthStencilState*,
+		ID3D11RasterizerState*, const D3D11_VIEWPORT&);
+	void Shutdown();
+
+	void ClearRenderTarget(const float[4]);
+	void ClearDepthStencil(float);
+
+	bool Map(RenderBuffer, void**);
+	void Unmap(RenderBuffer);
+
+	void IASetVertexBuffers(unsigned int, unsigned int, RenderBuffer*, unsigned int*, unsigned int*);
+	void IASetIndexBuffer(RenderBuffer, RenderFormat, unsigned int);
+	void IASetPrimitiveTopology(RenderTopology);
+	void IASetInputLayout(RenderInputLayout);
+
+	void VSSetShader(RenderVertexShader);
+	void PSSetShader(RenderPixelShader);
+	void VSSetConstantBuffers(unsigned int, unsigned int, RenderBuffer*);
+	void VSSetConstantBufferRange(unsigned int, RenderBuffer, unsigned int, unsigned int);
+
+	void DrawIndexed(unsigned int, unsigned int, int);
+	void DrawIndexedInstanced(unsigned int, unsigned int, unsigned int, int, unsigned int);
+
+	bool FinishCommandList(RenderCommandList&);
+	void ExecuteCommandList(RenderCommandList);
+
+	static DXGI_FORMAT ToDxgiFormat(RenderFormat);
+
+private:
+	void SetFrameState();
+
+private:
+	ID3D11DeviceContext* m_deviceContext;
+	ID3D11DeviceContext1* m_deviceContext1;
+	ID3D11RenderTargetView* m_renderTargetView;
+	ID3D11DepthStencilView* m_depthStencilView;
+	bool m_deferred;
+	ID3D11DepthStencilState* m_depthStencilState;
+	ID3D11RasterizerState* m_rasterState;
+	D3D11_VIEWPORT m_viewport;
+};
+
+#endif
@@ -0,0 +1,125 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: deviceclockclass.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "deviceclockclass.h"
+#include "timerclass.h"
+#include <chrono>
+#include <thread>
+using namespace std;
+
+#ifdef _WIN32
+#ifndef CREATE_WAITABLE_TIMER_HIGH_RESOLUTION
+#define CREATE_WAITABLE_TIMER_HIGH_RESOLUTION 0x00000002
+#endif
+#endif
+
+DeviceClockClass::DeviceClockClass()
+{
+	m_device = 0;
+#ifdef _WIN32
+	m_timer = 0;
+	m_highResolution = false;
+#endif
+}
+
+DeviceClockClass::DeviceClockClass(const DeviceClockClass& other)
+{
+}
+
+DeviceClockClass::~DeviceClockClass()
+{
+}
+
+/*Initialize creates the waitable timer. The high resolution one only exists since Windows 10 version 1803, before
+that the plain one is used.*/
+bool DeviceClockClass::Initialize(RenderDeviceClass* device)
+{
+	m_device = device;
+
+#ifdef _WIN32
+	m_timer = CreateWaitableTimerExW(NULL, NULL, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+	m_highResolution = m_timer != NULL;
+	if (!m_timer)
+	{
+		m_timer = CreateWaitableTimerExW(NULL, NULL, 0, TIMER_ALL_ACCESS);
+		if (!m_timer)
+		{
+			return false;
+		}
+	}
+#endif
+
+	return true;
+}
+
+void DeviceClockClass::Shutdown()
+{
+#ifdef _WIN32
+	if (m_timer)
+	{
+		CloseHandle(m_timer);
+		m_timer = 0;
+	}
+#endif
+
+	m_device = 0;
+
+	return;
+}
+
+double DeviceClockClass::GetTime()
+{
+	return TimerClass::GetTimeSeconds();
+}
+
+/*WaitUntil sleeps on the timer for the time that is left. Only the last bit of a wait on the plain timer, which could
+oversleep by a whole system tick, is spent handing the time slice to other threads.*/
+void DeviceClockClass::WaitUntil(double time)
+{
+#ifdef _WIN32
+	LARGE_INTEGER dueTime;
+#endif
+	double remaining;
+
+	remaining = time - GetTime();
+	if (remaining <= 0.0)
+	{
+		return;
+	}
+
+#ifdef _WIN32
+	if (!m_highResolution)
+	{
+		remaining -= DEVICE_CLOCK_TIMER_MARGIN;
+	}
+
+	// A negative due time is relative, in units of 100 nanoseconds.
+	if (remaining > 0.0)
+	{
+		dueTime.QuadPart = -(LONGLONG)(remaining * 10000000.0);
+		if (SetWaitableTimer(m_timer, &dueTime, 0, NULL, NULL, FALSE))
+		{
+			WaitForSingleObject(m_timer, INFINITE);
+		}
+	}
+#else
+	this_thread::sleep_for(chrono::duration<double>(remaining));
+#endif
+
+	while (GetTime() < time)
+	{
+		this_thread::yield();
+	}
+
+	return;
+}
+
+void DeviceClockClass::OnPresent()
+{
+	return;
+}
+
+unsigned long long DeviceClockClass::GetCompletedFrames()
+{
+	return m_device->GetCompletedFrames();
+}
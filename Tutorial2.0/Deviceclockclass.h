@@ -0,0 +1,52 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: deviceclockclass.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _DEVICECLOCKCLASS_H_
+#define _DEVICECLOCKCLASS_H_
+
+
+//////////////
+// INCLUDES //
+//////////////
+#include "presentclockclass.h"
+#include "renderdeviceclass.h"
+
+
+/////////////
+// GLOBALS //
+/////////////
+/*Without the high resolution waitable timer of Windows 10 a timer only fires on the system tick. WaitUntil then leaves
+this many seconds before the deadline to the end and gives its time slice away until then.*/
+const double DEVICE_CLOCK_TIMER_MARGIN = 0.002;
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: DeviceClockClass
+////////////////////////////////////////////////////////////////////////////////
+/*The DeviceClockClass is the present clock of the real frame. The time is TimerClass::GetTimeSeconds, the finished
+frames come from the render device. WaitUntil sleeps on a high resolution waitable timer where there is one, so a
+frame rate cap costs no CPU time, anywhere else it sleeps on the steady clock.*/
+class DeviceClockClass : public PresentClockClass
+{
+public:
+	DeviceClockClass();
+	DeviceClockClass(const DeviceClockClass&);
+	~DeviceClockClass();
+
+	bool Initialize(RenderDeviceClass*);
+	void Shutdown();
+
+	double GetTime();
+	void WaitUntil(double);
+	void OnPresent();
+	unsigned long long GetCompletedFrames();
+
+private:
+	RenderDeviceClass* m_device;
+#ifdef _WIN32
+	HANDLE m_timer;
+	bool m_highResolution;
+#endif
+};
+
+#endif
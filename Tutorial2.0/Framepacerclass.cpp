@@ -0,0 +1,238 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: framepacerclass.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "framepacerclass.h"
+#include "profilerclass.h"
+#include <string.h>
+
+FramePacerClass::FramePacerClass()
+{
+	int i;
+
+	m_clock = 0;
+	m_framesInFlight = 1;
+	m_frameInterval = 0.0;
+	m_nextFrameTime = 0.0;
+	m_pendingInputTime = -1.0;
+	for (i = 0; i < FRAME_PACER_MAX_FRAMES_IN_FLIGHT; i++)
+	{
+		m_inputTimes[i] = -1.0;
+	}
+	m_firstFrame = 0;
+	m_presentedFrames = 0;
+	m_completedFrames = 0;
+	memset(&m_statistics, 0, sizeof(m_statistics));
+}
+
+FramePacerClass::FramePacerClass(const FramePacerClass& other)
+{
+}
+
+FramePacerClass::~FramePacerClass()
+{
+}
+
+/*Initialize takes the clock, how many frames may be in flight and the most frames a second, 0 for no cap. The frames
+the clock counts as completed already were presented before the pacer started and are left out.*/
+bool FramePacerClass::Initialize(PresentClockClass* clock, int framesInFlight, double maxFramesPerSecond)
+{
+	int i;
+
+	if (!clock)
+	{
+		return false;
+	}
+
+	m_clock = clock;
+	SetFramesInFlight(framesInFlight);
+	SetFrameRateCap(maxFramesPerSecond);
+	m_nextFrameTime = 0.0;
+	m_pendingInputTime = -1.0;
+	for (i = 0; i < FRAME_PACER_MAX_FRAMES_IN_FLIGHT; i++)
+	{
+		m_inputTimes[i] = -1.0;
+	}
+	m_firstFrame = m_clock->GetCompletedFrames();
+	m_presentedFrames = 0;
+	m_completedFrames = 0;
+	memset(&m_statistics, 0, sizeof(m_statistics));
+
+	return true;
+}
+
+void FramePacerClass::Shutdown()
+{
+	m_clock = 0;
+
+	return;
+}
+
+/*SetFramesInFlight sets how many frames may be presented and not finished yet, from 1 up to
+FRAME_PACER_MAX_FRAMES_IN_FLIGHT. One is the lowest latency but the CPU and the GPU take turns then instead of working
+at the same time.*/
+void FramePacerClass::SetFramesInFlight(int framesInFlight)
+{
+	if (framesInFlight < 1)
+	{
+		framesInFlight = 1;
+	}
+	if (framesInFlight > FRAME_PACER_MAX_FRAMES_IN_FLIGHT)
+	{
+		framesInFlight = FRAME_PACER_MAX_FRAMES_IN_FLIGHT;
+	}
+	m_framesInFlight = framesInFlight;
+
+	return;
+}
+
+/*SetFrameRateCap sets the most frames a second, 0 or less turns the cap off.*/
+void FramePacerClass::SetFrameRateCap(double maxFramesPerSecond)
+{
+	m_frameInterval = maxFramesPerSecond > 0.0 ? 1.0 / maxFramesPerSecond : 0.0;
+
+	return;
+}
+
+/*BeginFrame waits until the next frame may start, see the class. It sleeps in short steps while it waits for the GPU
+since there is nothing to wait on that says when a frame is finished, and once until the cap lets the frame start.*/
+void FramePacerClass::BeginFrame()
+{
+	PROFILE_FUNCTION();
+
+	double startTime, now;
+
+	// Wait for the GPU to finish frames until there is room for another one.
+	UpdateCompletedFrames();
+	if (m_presentedFrames - m_completedFrames >= (unsigned long long)m_framesInFlight)
+	{
+		startTime = m_clock->GetTime();
+		while (m_presentedFrames - m_completedFrames >= (unsigned long long)m_framesInFlight)
+		{
+			m_clock->WaitUntil(m_clock->GetTime() + FRAME_PACER_POLL_INTERVAL);
+			UpdateCompletedFrames();
+		}
+		m_statistics.limitWaits++;
+		m_statistics.limitWaitMilliseconds += (m_clock->GetTime() - startTime) * 1000.0;
+	}
+
+	if (m_frameInterval <= 0.0)
+	{
+		return;
+	}
+
+	// Wait for the cap.
+	now = m_clock->GetTime();
+	if (m_nextFrameTime > now)
+	{
+		m_clock->WaitUntil(m_nextFrameTime);
+		m_statistics.capWaitMilliseconds += (m_clock->GetTime() - now) * 1000.0;
+		now = m_clock->GetTime();
+	}
+
+	// The frames stay an interval apart from when they were due, unless this one is more than an interval late.
+	if (now - m_nextFrameTime > m_frameInterval)
+	{
+		m_nextFrameTime = now;
+	}
+	m_nextFrameTime += m_frameInterval;
+
+	return;
+}
+
+/*AddInput tells the pacer an input event came in at the given time of the clock. The next EndFrame measures the
+latency of the oldest event since the last one.*/
+void FramePacerClass::AddInput(double time)
+{
+	if (m_pendingInputTime < 0.0 || time < m_pendingInputTime)
+	{
+		m_pendingInputTime = time;
+	}
+
+	return;
+}
+
+/*EndFrame is called right after the frame was presented. It counts the frame as in flight and measures the present
+latency of its input.*/
+void FramePacerClass::EndFrame()
+{
+	double now, latency;
+	int framesInFlight;
+
+	m_clock->OnPresent();
+	now = m_clock->GetTime();
+
+	if (m_pendingInputTime >= 0.0)
+	{
+		latency = (now - m_pendingInputTime) * 1000.0;
+		m_statistics.presentLatencyCount++;
+		m_statistics.presentLatencyMilliseconds += latency;
+		if (latency > m_statistics.maxPresentLatencyMilliseconds)
+		{
+			m_statistics.maxPresentLatencyMilliseconds = latency;
+		}
+	}
+
+	// There are fewer frames in flight than the limit, so this slot belongs to a frame that was completed already.
+	m_inputTimes[m_presentedFrames % FRAME_PACER_MAX_FRAMES_IN_FLIGHT] = m_pendingInputTime;
+	m_pendingInputTime = -1.0;
+	m_presentedFrames++;
+	m_statistics.frames++;
+
+	UpdateCompletedFrames();
+	framesInFlight = (int)(m_presentedFrames - m_completedFrames);
+	if (framesInFlight > m_statistics.maxFramesInFlight)
+	{
+		m_statistics.maxFramesInFlight = framesInFlight;
+	}
+
+	return;
+}
+
+FramePacingStatisticsType FramePacerClass::GetStatistics()
+{
+	return m_statistics;
+}
+
+void FramePacerClass::ResetStatistics()
+{
+	memset(&m_statistics, 0, sizeof(m_statistics));
+
+	return;
+}
+
+/*UpdateCompletedFrames asks the clock how many frames are finished and measures the display latency of those that
+finished since the last time.*/
+void FramePacerClass::UpdateCompletedFrames()
+{
+	unsigned long long completedFrames;
+	double now, inputTime, latency;
+
+	completedFrames = m_clock->GetCompletedFrames() - m_firstFrame;
+	if (completedFrames > m_presentedFrames)
+	{
+		completedFrames = m_presentedFrames;
+	}
+	if (completedFrames == m_completedFrames)
+	{
+		return;
+	}
+
+	now = m_clock->GetTime();
+	while (m_completedFrames < completedFrames)
+	{
+		inputTime = m_inputTimes[m_completedFrames % FRAME_PACER_MAX_FRAMES_IN_FLIGHT];
+		if (inputTime >= 0.0)
+		{
+			latency = (now - inputTime) * 1000.0;
+			m_statistics.displayLatencyCount++;
+			m_statistics.displayLatencyMilliseconds += latency;
+			if (latency > m_statistics.maxDisplayLatencyMilliseconds)
+			{
+				m_statistics.maxDisplayLatencyMilliseconds = latency;
+			}
+		}
+		m_completedFrames++;
+	}
+
+	return;
+}
@@ -0,0 +1,95 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: framepacerclass.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _FRAMEPACERCLASS_H_
+#define _FRAMEPACERCLASS_H_
+
+
+//////////////
+// INCLUDES //
+//////////////
+#include "presentclockclass.h"
+
+
+/////////////
+// GLOBALS //
+/////////////
+/*The most frames the frame pacer lets be in flight, presented but not finished by the GPU.*/
+const int FRAME_PACER_MAX_FRAMES_IN_FLIGHT = 8;
+/*How many seconds the frame pacer sleeps between two looks at the GPU while it waits for a frame to finish.*/
+const double FRAME_PACER_POLL_INTERVAL = 0.0005;
+
+
+/////////////
+// TYPEDEFS //
+/////////////
+/*What the frame pacer did since the statistics were reset, times are in milliseconds. The present latency of a frame
+is from the oldest input event it handled to its present, the display latency from that event to when the clock
+reported the frame completed. That is when the GPU finished it, or on the simulated clock when it was shown, as
+noticed at the next BeginFrame or EndFrame.*/
+struct FramePacingStatisticsType
+{
+	int frames;
+	int maxFramesInFlight;
+	int limitWaits;
+	double limitWaitMilliseconds;
+	double capWaitMilliseconds;
+	int presentLatencyCount;
+	double presentLatencyMilliseconds;
+	double maxPresentLatencyMilliseconds;
+	int displayLatencyCount;
+	double displayLatencyMilliseconds;
+	double maxDisplayLatencyMilliseconds;
+};
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: FramePacerClass
+////////////////////////////////////////////////////////////////////////////////
+/*The FramePacerClass decides when the next frame may start. BeginFrame waits until fewer frames than the limit are in
+flight, so the CPU can't queue up frames the GPU is still busy with and every frame reads the input as late as it can,
+and then for the frame rate cap, with the present clock's wait so the core sleeps. A frame that starts late doesn't
+make the next ones come early to catch up.
+
+The input events are handed to AddInput with the time they came in, the frame after them handles them. EndFrame,
+right after the present, measures how long the oldest of them waited for it.
+
+All of it goes through a PresentClockClass, the same code paces the real frame on the DeviceClockClass and the
+benchmark's frames on the SimulatedClockClass.*/
+class FramePacerClass
+{
+public:
+	FramePacerClass();
+	FramePacerClass(const FramePacerClass&);
+	~FramePacerClass();
+
+	bool Initialize(PresentClockClass*, int, double);
+	void Shutdown();
+
+	void SetFramesInFlight(int);
+	void SetFrameRateCap(double);
+
+	void BeginFrame();
+	void AddInput(double);
+	void EndFrame();
+
+	FramePacingStatisticsType GetStatistics();
+	void ResetStatistics();
+
+private:
+	void UpdateCompletedFrames();
+
+private:
+	PresentClockClass* m_clock;
+	int m_framesInFlight;
+	double m_frameInterval;
+	double m_nextFrameTime;
+	double m_pendingInputTime;
+	double m_inputTimes[FRAME_PACER_MAX_FRAMES_IN_FLIGHT];
+	unsigned long long m_firstFrame;
+	unsigned long long m_presentedFrames;
+	unsigned long long m_completedFrames;
+	FramePacingStatisticsType m_statistics;
+};
+
+#endif
@@ -0,0 +1,477 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: frustumcullerclass.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "frustumcullerclass.h"
+#include "transformbatchclass.h"
+#include "profilerclass.h"
+#include <immintrin.h>
+#include <math.h>
+#include <string.h>
+
+#if defined(_MSC_VER)
+#define CULL_AVX2_FUNCTION
+#else
+#define CULL_AVX2_FUNCTION __attribute__((target("avx2,fma,popcnt")))
+#endif
+
+
+FrustumCullerClass::FrustumCullerClass()
+{
+	int i;
+
+	m_jobSystem = 0;
+	for (i = 0; i < 6; i++)
+	{
+		m_planes[i] = XMFLOAT4(0.0f, 0.0f, 0.0f, 0.0f);
+	}
+	m_volume = CULL_VOLUME_SPHERE;
+	m_path = CULL_PATH_SCALAR;
+	m_visibleCount = 0;
+	memset(&m_statistics, 0, sizeof(m_statistics));
+}
+
+FrustumCullerClass::FrustumCullerClass(const FrustumCullerClass& other)
+{
+}
+
+FrustumCullerClass::~FrustumCullerClass()
+{
+}
+
+/*Initialize takes the job system to split large object counts over, it can be null to always cull on the calling
+thread.*/
+bool FrustumCullerClass::Initialize(JobSystemClass* jobSystem)
+{
+	PROFILE_FUNCTION();
+
+	m_jobSystem = jobSystem;
+
+	return true;
+}
+
+void FrustumCullerClass::Shutdown()
+{
+	Clear();
+	m_jobSystem = 0;
+
+	return;
+}
+
+/*Clear removes all the objects.*/
+void FrustumCullerClass::Clear()
+{
+	m_centerX.clear();
+	m_centerY.clear();
+	m_centerZ.clear();
+	m_extentX.clear();
+	m_extentY.clear();
+	m_extentZ.clear();
+	m_radius.clear();
+	m_visible.clear();
+
+	return;
+}
+
+/*AddObject adds an object with the given local bounds (the center and half size of its box and the radius of the
+sphere around the same center, see ModelClass::GetBounds) placed in the world with worldMatrix, see SetObject. Returns
+the index of the object.*/
+int FrustumCullerClass::AddObject(const XMMATRIX& worldMatrix, const XMFLOAT3& center, const XMFLOAT3& extents, float radius)
+{
+	m_centerX.push_back(0.0f);
+	m_centerY.push_back(0.0f);
+	m_centerZ.push_back(0.0f);
+	m_extentX.push_back(0.0f);
+	m_extentY.push_back(0.0f);
+	m_extentZ.push_back(0.0f);
+	m_radius.push_back(0.0f);
+	m_visible.push_back(1);
+
+	SetObject((int)m_centerX.size() - 1, worldMatrix, center, extents, radius);
+
+	return (int)m_centerX.size() - 1;
+}
+
+/*SetObject places the object at the index again, for an object that moved. The bounds are moved into world space
+here: the center is transformed, the sphere grows with the largest scale of the matrix and the box becomes the axis
+aligned box around the transformed box.*/
+void FrustumCullerClass::SetObject(int index, const XMMATRIX& worldMatrix, const XMFLOAT3& center, const XMFLOAT3& extents, float radius)
+{
+	XMFLOAT4X4 world;
+	XMFLOAT3 worldCenter;
+	float scaleX, scaleY, scaleZ, scale;
+
+	XMStoreFloat4x4(&world, worldMatrix);
+	XMStoreFloat3(&worldCenter, XMVector3TransformCoord(XMLoadFloat3(&center), worldMatrix));
+
+	m_centerX[index] = worldCenter.x;
+	m_centerY[index] = worldCenter.y;
+	m_centerZ[index] = worldCenter.z;
+
+	// Every world axis of the box gets the part of each local axis that points along it.
+	m_extentX[index] = fabsf(world._11) * extents.x + fabsf(world._21) * extents.y + fabsf(world._31) * extents.z;
+	m_extentY[index] = fabsf(world._12) * extents.x + fabsf(world._22) * extents.y + fabsf(world._32) * extents.z;
+	m_extentZ[index] = fabsf(world._13) * extents.x + fabsf(world._23) * extents.y + fabsf(world._33) * extents.z;
+
+	scaleX = world._11 * world._11 + world._12 * world._12 + world._13 * world._13;
+	scaleY = world._21 * world._21 + world._22 * world._22 + world._23 * world._23;
+	scaleZ = world._31 * world._31 + world._32 * world._32 + world._33 * world._33;
+	scale = scaleX > scaleY ? scaleX : scaleY;
+	scale = scale > scaleZ ? scale : scaleZ;
+	m_radius[index] = radius * sqrtf(scale);
+
+	return;
+}
+
+int FrustumCullerClass::GetObjectCount()
+{
+	return (int)m_centerX.size();
+}
+
+/*SetFrustum takes the planes out of the view-projection matrix. A point is inside when its clip coordinates satisfy
+-w <= x <= w, -w <= y <= w and 0 <= z <= w, and each of those six comparisons is a plane made from the columns of the
+matrix. The planes are normalized so the distance to them can be compared with a radius.*/
+void FrustumCullerClass::SetFrustum(const XMMATRIX& viewProjectionMatrix)
+{
+	XMFLOAT4X4 matrix;
+	int i, row;
+	float length;
+
+	XMStoreFloat4x4(&matrix, viewProjectionMatrix);
+
+	for (row = 0; row < 4; row++)
+	{
+		(&m_planes[0].x)[row] = matrix.m[row][3] + matrix.m[row][0];  // Left.
+		(&m_planes[1].x)[row] = matrix.m[row][3] - matrix.m[row][0];  // Right.
+		(&m_planes[2].x)[row] = matrix.m[row][3] + matrix.m[row][1];  // Bottom.
+		(&m_planes[3].x)[row] = matrix.m[row][3] - matrix.m[row][1];  // Top.
+		(&m_planes[4].x)[row] = matrix.m[row][2];                     // Near.
+		(&m_planes[5].x)[row] = matrix.m[row][3] - matrix.m[row][2];  // Far.
+	}
+
+	for (i = 0; i < 6; i++)
+	{
+		length = sqrtf(m_planes[i].x * m_planes[i].x + m_planes[i].y * m_planes[i].y + m_planes[i].z * m_planes[i].z);
+		if (length > 0.0f)
+		{
+			m_planes[i].x /= length;
+			m_planes[i].y /= length;
+			m_planes[i].z /= length;
+			m_planes[i].w /= length;
+		}
+	}
+
+	return;
+}
+
+/*Cull tests all objects with the fastest path, on the job system when there are enough of them.*/
+void FrustumCullerClass::Cull(CullVolume volume)
+{
+	static CullPath bestPath = GetBestPath();
+
+	Cull(volume, bestPath, GetObjectCount() >= CULL_PARALLEL_THRESHOLD);
+
+	return;
+}
+
+/*This Cull uses the given path and only uses the job system when parallel is set. The benchmark uses it to compare
+them. The path must be supported.*/
+void FrustumCullerClass::Cull(CullVolume volume, CullPath path, bool parallel)
+{
+	PROFILE_FUNCTION();
+
+	int count;
+
+	count = GetObjectCount();
+
+	m_volume = volume;
+	m_path = path;
+	m_visibleCount = 0;
+
+	if (parallel && m_jobSystem)
+	{
+		m_jobSystem->ParallelFor((count + CULL_BATCH_SIZE - 1) / CULL_BATCH_SIZE, 1, CullBatches, this);
+	}
+	else
+	{
+		CullBatch(this, 0, count);
+	}
+
+	m_statistics.tested = count;
+	m_statistics.visible = m_visibleCount;
+	m_statistics.culled = count - m_statistics.visible;
+
+	return;
+}
+
+bool FrustumCullerClass::IsVisible(int index)
+{
+	return m_visible[index] != 0;
+}
+
+CullStatisticsType FrustumCullerClass::GetStatistics()
+{
+	return m_statistics;
+}
+
+/*The culler needs the same processor support as the TransformBatchClass, so it asks that.*/
+CullPath FrustumCullerClass::GetBestPath()
+{
+	switch (TransformBatchClass::GetBestPath())
+	{
+		case TRANSFORM_PATH_AVX2:
+			return CULL_PATH_AVX2;
+		case TRANSFORM_PATH_SSE:
+			return CULL_PATH_SSE;
+		default:
+			return CULL_PATH_SCALAR;
+	}
+}
+
+bool FrustumCullerClass::IsPathSupported(CullPath path)
+{
+	return path <= GetBestPath();
+}
+
+const char* FrustumCullerClass::GetPathName(CullPath path)
+{
+	switch (path)
+	{
+		case CULL_PATH_AVX2:
+			return "avx2";
+		case CULL_PATH_SSE:
+			return "sse";
+		default:
+			return "scalar";
+	}
+}
+
+/*CullBatch tests the objects in [begin, end) with the chosen path. The SIMD paths do whole groups and leave the tail
+to the scalar code.*/
+void FrustumCullerClass::CullBatch(void* data, int begin, int end)
+{
+	FrustumCullerClass* culler;
+	int visible, groupEnd;
+
+	culler = (FrustumCullerClass*)data;
+
+	switch (culler->m_path)
+	{
+		case CULL_PATH_AVX2:
+			groupEnd = begin + ((end - begin) & ~7);
+			visible = culler->CullAVX2(begin, groupEnd);
+			break;
+		case CULL_PATH_SSE:
+			groupEnd = begin + ((end - begin) & ~3);
+			visible = culler->CullSSE(begin, groupEnd);
+			break;
+		default:
+			groupEnd = begin;
+			visible = 0;
+			break;
+	}
+
+	visible += culler->CullScalar(groupEnd, end);
+
+	culler->m_visibleCount += visible;
+
+	return;
+}
+
+/*CullBatches is the range function of the parallel cull. Its range counts batches of CULL_BATCH_SIZE objects rather
+than objects, so however the job system splits it every batch but the last is a whole number of SIMD groups.*/
+void FrustumCullerClass::CullBatches(void* data, int begin, int end)
+{
+	FrustumCullerClass* culler;
+	int last;
+
+	culler = (FrustumCullerClass*)data;
+
+	last = end * CULL_BATCH_SIZE;
+	if (last > culler->GetObjectCount())
+	{
+		last = culler->GetObjectCount();
+	}
+
+	CullBatch(data, begin * CULL_BATCH_SIZE, last);
+
+	return;
+}
+
+/*CullScalar tests one object at a time. The signed distance of the center to each plane decides: a sphere is outside
+when it is further than its radius behind a plane, a box when even its corner furthest along the plane normal is
+behind it. That corner is as far along the normal as the extents projected on the normal.*/
+int FrustumCullerClass::CullScalar(int begin, int end)
+{
+	int i, plane, visible;
+	float distance, reach;
+	bool inside;
+
+	visible = 0;
+
+	for (i = begin; i < end; i++)
+	{
+		inside = true;
+		for (plane = 0; plane < 6 && inside; plane++)
+		{
+			distance = m_planes[plane].x * m_centerX[i] + m_planes[plane].y * m_centerY[i] + m_planes[plane].z * m_centerZ[i] + m_planes[plane].w;
+
+			if (m_volume == CULL_VOLUME_SPHERE)
+			{
+				reach = m_radius[i];
+			}
+			else
+			{
+				reach = fabsf(m_planes[plane].x) * m_extentX[i] + fabsf(m_planes[plane].y) * m_extentY[i] + fabsf(m_planes[plane].z) * m_extentZ[i];
+			}
+
+			inside = distance + reach >= 0.0f;
+		}
+
+		m_visible[i] = inside ? 1 : 0;
+		if (inside)
+		{
+			visible++;
+		}
+	}
+
+	return visible;
+}
+
+/*CullSSE is CullScalar for four objects at once. Each plane is tested against all four, the results are and-ed
+together and the sign bits say which of the four are inside. end - begin must be a multiple of four.*/
+int FrustumCullerClass::CullSSE(int begin, int end)
+{
+	__m128 planeX[6], planeY[6], planeZ[6], planeW[6], absPlaneX[6], absPlaneY[6], absPlaneZ[6];
+	__m128 centerX, centerY, centerZ, extentX, extentY, extentZ, reach, distance, inside, zero, signMask;
+	int i, plane, mask, visible;
+
+	zero = _mm_setzero_ps();
+	signMask = _mm_set1_ps(-0.0f);
+	extentX = zero;
+	extentY = zero;
+	extentZ = zero;
+	reach = zero;
+
+	for (plane = 0; plane < 6; plane++)
+	{
+		planeX[plane] = _mm_set1_ps(m_planes[plane].x);
+		planeY[plane] = _mm_set1_ps(m_planes[plane].y);
+		planeZ[plane] = _mm_set1_ps(m_planes[plane].z);
+		planeW[plane] = _mm_set1_ps(m_planes[plane].w);
+		absPlaneX[plane] = _mm_andnot_ps(signMask, planeX[plane]);
+		absPlaneY[plane] = _mm_andnot_ps(signMask, planeY[plane]);
+		absPlaneZ[plane] = _mm_andnot_ps(signMask, planeZ[plane]);
+	}
+
+	visible = 0;
+
+	for (i = begin; i < end; i += 4)
+	{
+		centerX = _mm_loadu_ps(&m_centerX[i]);
+		centerY = _mm_loadu_ps(&m_centerY[i]);
+		centerZ = _mm_loadu_ps(&m_centerZ[i]);
+
+		if (m_volume == CULL_VOLUME_SPHERE)
+		{
+			reach = _mm_loadu_ps(&m_radius[i]);
+		}
+		else
+		{
+			extentX = _mm_loadu_ps(&m_extentX[i]);
+			extentY = _mm_loadu_ps(&m_extentY[i]);
+			extentZ = _mm_loadu_ps(&m_extentZ[i]);
+		}
+
+		inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+		for (plane = 0; plane < 6; plane++)
+		{
+			distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(planeX[plane], centerX), _mm_mul_ps(planeY[plane], centerY)),
+				_mm_add_ps(_mm_mul_ps(planeZ[plane], centerZ), planeW[plane]));
+
+			if (m_volume == CULL_VOLUME_BOX)
+			{
+				reach = _mm_add_ps(_mm_add_ps(_mm_mul_ps(absPlaneX[plane], extentX), _mm_mul_ps(absPlaneY[plane], extentY)),
+					_mm_mul_ps(absPlaneZ[plane], extentZ));
+			}
+
+			inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(distance, reach), zero));
+		}
+
+		mask = _mm_movemask_ps(inside);
+		m_visible[i] = (unsigned char)(mask & 1);
+		m_visible[i + 1] = (unsigned char)((mask >> 1) & 1);
+		m_visible[i + 2] = (unsigned char)((mask >> 2) & 1);
+		m_visible[i + 3] = (unsigned char)((mask >> 3) & 1);
+		visible += m_visible[i] + m_visible[i + 1] + m_visible[i + 2] + m_visible[i + 3];
+	}
+
+	return visible;
+}
+
+/*CullAVX2 is CullSSE for eight objects at once, with fused multiply-adds. end - begin must be a multiple of eight.*/
+CULL_AVX2_FUNCTION int FrustumCullerClass::CullAVX2(int begin, int end)
+{
+	__m256 planeX[6], planeY[6], planeZ[6], planeW[6], absPlaneX[6], absPlaneY[6], absPlaneZ[6];
+	__m256 centerX, centerY, centerZ, extentX, extentY, extentZ, reach, distance, inside, zero, signMask;
+	int i, plane, bit, mask, visible;
+
+	zero = _mm256_setzero_ps();
+	signMask = _mm256_set1_ps(-0.0f);
+	extentX = zero;
+	extentY = zero;
+	extentZ = zero;
+	reach = zero;
+
+	for (plane = 0; plane < 6; plane++)
+	{
+		planeX[plane] = _mm256_set1_ps(m_planes[plane].x);
+		planeY[plane] = _mm256_set1_ps(m_planes[plane].y);
+		planeZ[plane] = _mm256_set1_ps(m_planes[plane].z);
+		planeW[plane] = _mm256_set1_ps(m_planes[plane].w);
+		absPlaneX[plane] = _mm256_andnot_ps(signMask, planeX[plane]);
+		absPlaneY[plane] = _mm256_andnot_ps(signMask, planeY[plane]);
+		absPlaneZ[plane] = _mm256_andnot_ps(signMask, planeZ[plane]);
+	}
+
+	visible = 0;
+
+	for (i = begin; i < end; i += 8)
+	{
+		centerX = _mm256_loadu_ps(&m_centerX[i]);
+		centerY = _mm256_loadu_ps(&m_centerY[i]);
+		centerZ = _mm256_loadu_ps(&m_centerZ[i]);
+
+		if (m_volume == CULL_VOLUME_SPHERE)
+		{
+			reach = _mm256_loadu_ps(&m_radius[i]);
+		}
+		else
+		{
+			extentX = _mm256_loadu_ps(&m_extentX[i]);
+			extentY = _mm256_loadu_ps(&m_extentY[i]);
+			extentZ = _mm256_loadu_ps(&m_extentZ[i]);
+		}
+
+		inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+		for (plane = 0; plane < 6; plane++)
+		{
+			distance = _mm256_fmadd_ps(planeX[plane], centerX, _mm256_fmadd_ps(planeY[plane], centerY, _mm256_fmadd_ps(planeZ[plane], centerZ, planeW[plane])));
+
+			if (m_volume == CULL_VOLUME_BOX)
+			{
+				reach = _mm256_fmadd_ps(absPlaneX[plane], extentX, _mm256_fmadd_ps(absPlaneY[plane], extentY, _mm256_mul_ps(absPlaneZ[plane], extentZ)));
+			}
+
+			inside = _mm256_and_ps(inside, _mm256_cmp_ps(_mm256_add_ps(distance, reach), zero, _CMP_GE_OQ));
+		}
+
+		mask = _mm256_movemask_ps(inside);
+		for (bit = 0; bit < 8; bit++)
+		{
+			m_visible[i + bit] = (unsigned char)((mask >> bit) & 1);
+		}
+		visible += _mm_popcnt_u32((unsigned int)mask);
+	}
+
+	return visible;
+}
@@ -0,0 +1,110 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: frustumcullerclass.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _FRUSTUMCULLERCLASS_H_
+#define _FRUSTUMCULLERCLASS_H_
+
+
+//////////////
+// INCLUDES //
+//////////////
+#include <directxmath.h>
+#include <atomic>
+#include <vector>
+#include "jobsystemclass.h"
+using namespace DirectX;
+using namespace std;
+
+
+/////////////
+// GLOBALS //
+/////////////
+/*Below this many objects culling on one thread is faster than waking the job threads up. Each job takes this many
+objects at a time, always a multiple of eight so only the last batch has a tail for the scalar code.*/
+const int CULL_PARALLEL_THRESHOLD = 16384;
+const int CULL_BATCH_SIZE = 4096;
+
+
+/////////////
+// TYPEDEFS //
+/////////////
+/*Which bounding volume of the objects is tested. Boxes are tighter for flat or long models, spheres are cheaper.*/
+enum CullVolume
+{
+	CULL_VOLUME_SPHERE,
+	CULL_VOLUME_BOX
+};
+
+/*The ways the culler can do the tests: one object at a time, four with SSE or eight with AVX2.*/
+enum CullPath
+{
+	CULL_PATH_SCALAR,
+	CULL_PATH_SSE,
+	CULL_PATH_AVX2
+};
+
+/*The counts of the last Cull.*/
+struct CullStatisticsType
+{
+	int tested;
+	int visible;
+	int culled;
+};
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: FrustumCullerClass
+////////////////////////////////////////////////////////////////////////////////
+/*The FrustumCullerClass decides which objects are inside the view frustum. The world space bounds of the objects are
+kept in structure of arrays form, one array per coordinate, so the SIMD paths can load the same coordinate of four or
+eight objects with one instruction and test them against a frustum plane together.
+
+SetFrustum takes the six planes from the view-projection matrix of the camera, Cull tests every object against them
+and afterwards IsVisible tells the result per object. Large object counts are split over the job system.*/
+class FrustumCullerClass
+{
+public:
+	FrustumCullerClass();
+	FrustumCullerClass(const FrustumCullerClass&);
+	~FrustumCullerClass();
+
+	bool Initialize(JobSystemClass*);
+	void Shutdown();
+
+	void Clear();
+	int AddObject(const XMMATRIX&, const XMFLOAT3&, const XMFLOAT3&, float);
+	void SetObject(int, const XMMATRIX&, const XMFLOAT3&, const XMFLOAT3&, float);
+	int GetObjectCount();
+
+	void SetFrustum(const XMMATRIX&);
+	void Cull(CullVolume);
+	void Cull(CullVolume, CullPath, bool);
+
+	bool IsVisible(int);
+	CullStatisticsType GetStatistics();
+
+	static CullPath GetBestPath();
+	static bool IsPathSupported(CullPath);
+	static const char* GetPathName(CullPath);
+
+private:
+	static void CullBatch(void*, int, int);
+	static void CullBatches(void*, int, int);
+	int CullScalar(int, int);
+	int CullSSE(int, int);
+	int CullAVX2(int, int);
+
+private:
+	JobSystemClass* m_jobSystem;
+	vector<float> m_centerX, m_centerY, m_centerZ;
+	vector<float> m_extentX, m_extentY, m_extentZ;
+	vector<float> m_radius;
+	vector<unsigned char> m_visible;
+	XMFLOAT4 m_planes[6];
+	CullVolume m_volume;
+	CullPath m_path;
+	atomic<int> m_visibleCount;
+	CullStatisticsType m_statistics;
+};
+
+#endif
@@ -2,6 +2,14 @@
 // Filename: graphicsclass.cpp
 /////////////////////////////////////
 #include "Graphics.h"
+#include "headlessdeviceclass.h"
+#include "timerclass.h"
+#include "profilerclass.h"
+#include <math.h>
+#include <string.h>
+#ifdef _WIN32
+#include "D3d.h"
+#endif
 
 Graphics::Graphics()
 {
@@ -9,8 +17,29 @@ Graphics::Graphics()
 
 	m_Direct3D = 0;
 	m_Camera = 0;
+	m_hwnd = 0;
 	m_Model = 0;
 	m_ColorShader = 0;
+	m_ShaderCache = 0;
+	m_ShaderArchive = 0;
+	m_ShaderReloader = 0;
+	m_Batch = 0;
+	m_RenderQueue = 0;
+	m_ConstantAllocator = 0;
+	m_JobSystem = 0;
+	m_Culler = 0;
+	m_Simulation = 0;
+	m_Scene = 0;
+	m_sceneRoot = -1;
+	XMStoreFloat4x4(&m_objectDecode, XMMatrixIdentity());
+	m_objectBoundsCenter = XMFLOAT3(0.0f, 0.0f, 0.0f);
+	m_objectBoundsExtents = XMFLOAT3(0.0f, 0.0f, 0.0f);
+	m_objectBoundsRadius = 0.0f;
+	memset(&m_frameTiming, 0, sizeof(m_frameTiming));
+	m_screenHeight = 0;
+	m_lodEnabled = true;
+	m_batchRadius = 0.0f;
+	memset(&m_lodStatistics, 0, sizeof(m_lodStatistics));
 }
 
 Graphics::Graphics(const Graphics& other)
@@ -23,8 +52,10 @@ Graphics::~Graphics()
 
 }
 
-bool Graphics::Initialize(int screenWidth, int screenHeight, HWND hwnd)
+bool Graphics::Initialize(int screenWidth, int screenHeight, HWND hwnd, JobSystemClass* jobSystem)
 {
+	PROFILE_FUNCTION();
+
 	/* The second change is in the Initialize function inside the GraphicsClass.
 	Here we create the D3DClass object and then call the D3DClass Initialize function.
 	We send this function the screen width, screen height,
@@ -32,21 +63,59 @@ bool Graphics::Initialize(int screenWidth, int screenHeight, HWND hwnd)
 	The D3DClass will use all these variables to setup the Direct3D system.
 	We'll go into more detail about that once we look at the d3dclass.cpp file. */
 
+	XMMATRIX projectionMatrix;
+	string errors;
 	bool result;
 
-	// Create the direct3d objec 
-	m_Direct3D = new D3d;
-	if (!m_Direct3D)
+	// Keep the window to show the errors of a model loaded later on.
+	m_hwnd = hwnd;
+
+	/*Without a window there is nothing for Direct3D to present to, so a null hwnd selects the headless device instead.
+	It records every call the frame makes without touching a video card, which is what the benchmarks on the build machines use.*/
+	if (!hwnd)
 	{
-		return false;
+		HeadlessDeviceClass* headlessDevice;
+
+		// Create the headless device object.
+		headlessDevice = new HeadlessDeviceClass;
+		if (!headlessDevice)
+		{
+			return false;
+		}
+		m_Direct3D = headlessDevice;
+
+		// Initialize the headless device object.
+		result = headlessDevice->Initialize(screenWidth, screenHeight, SCREEN_DEPTH, SCREEN_NEAR);
+		if (!result)
+		{
+			ShowError(hwnd, L"Could not initialize the headless device", L"Error");
+			return false;
+		}
 	}
-
-	// Initialize the Direct3D object. 
-	result = m_Direct3D->Initialize(screenWidth, screenHeight, VSYNC_ENABLED, hwnd, FULL_SCREEN, SCREEN_DEPTH, SCREEN_NEAR); // - added
-	if (!result)
+	else
 	{
-		MessageBox(hwnd, L"Could not initialize Direct3D", L"Error", MB_OK);
+#ifdef _WIN32
+		D3d* direct3D;
+
+		// Create the direct3d objec 
+		direct3D = new D3d;
+		if (!direct3D)
+		{
+			return false;
+		}
+		m_Direct3D = direct3D;
+
+		// Initialize the Direct3D object. 
+		result = direct3D->Initialize(screenWidth, screenHeight, VSYNC_ENABLED, hwnd, FULL_SCREEN, SCREEN_DEPTH, SCREEN_NEAR); // - added
+		if (!result)
+		{
+			ShowError(hwnd, L"Could not initialize Direct3D", L"Error");
+			return false;
+		}
+#else
+		// Direct3D only exists on Windows.
 		return false;
+#endif
 	}
 
 	// Create the camera object.
@@ -56,8 +125,13 @@ bool Graphics::Initialize(int screenWidth, int screenHeight, HWND hwnd)
 		return false;
 	}
 
-	// Set the initial position of the camera.
+	// The levels of detail are picked by their size in pixels.
+	m_screenHeight = screenHeight;
+
+	// Set the initial position of the camera and give it the projection of the device.
 	m_Camera->SetPosition(-2.9f, 0.0f, -5.0f);
+	m_Direct3D->GetProjectionMatrix(projectionMatrix);
+	m_Camera->SetProjectionMatrix(projectionMatrix);
 
 	// Create the model object.
 	m_Model = new ModelClass;
@@ -67,10 +141,43 @@ bool Graphics::Initialize(int screenWidth, int screenHeight, HWND hwnd)
 	}
 
 	// Initialize the model object.
-	result = m_Model->Initialize(m_Direct3D->GetDevice());
+	result = m_Model->Initialize(m_Direct3D, MODEL_FILE, MODEL_VERTEX_FORMAT, errors);
+	if (!result)
+	{
+		ShowError(hwnd, errors + "Could not initialize the model object.", L"Error");
+		return false;
+	}
+
+	/*The shaders come out of the shader archive the ShaderBuild project makes. When it is missing or out of date they
+	come out of the shader cache instead, then they are only compiled the first time the game starts and whenever their
+	source changes.*/
+	// Create the shader cache object.
+	m_ShaderCache = new ShaderCacheClass;
+	if (!m_ShaderCache)
+	{
+		return false;
+	}
+
+	// Initialize the shader cache object.
+	result = m_ShaderCache->Initialize(m_Direct3D, SHADER_CACHE_DIRECTORY);
 	if (!result)
 	{
-		MessageBox(hwnd, L"Could not initialize the model object.", L"Error", MB_OK);
+		ShowError(hwnd, L"Could not initialize the shader cache object.", L"Error");
+		return false;
+	}
+
+	// Create the shader archive object.
+	m_ShaderArchive = new ShaderArchiveClass;
+	if (!m_ShaderArchive)
+	{
+		return false;
+	}
+
+	// Initialize the shader archive object.
+	result = m_ShaderArchive->Initialize(m_Direct3D, m_ShaderCache, SHADER_DESCRIPTION_FILE, SHADER_ARCHIVE_FILE, errors);
+	if (!result)
+	{
+		ShowError(hwnd, errors + "Could not initialize the shader archive object.", L"Error");
 		return false;
 	}
 
@@ -82,18 +189,189 @@ bool Graphics::Initialize(int screenWidth, int screenHeight, HWND hwnd)
 	}
 
 	// Initialize the color shader object.
-	result = m_ColorShader->Initialize(m_Direct3D->GetDevice(), hwnd);
+	result = m_ColorShader->Initialize(m_Direct3D, m_ShaderArchive, hwnd, MODEL_VERTEX_FORMAT);
+	if (!result)
+	{
+		ShowError(hwnd, L"Could not initialize the color shader object.", L"Error");
+		return false;
+	}
+
+#if SHADER_RELOAD_ENABLED
+	/*The shader reloader watches the sources of the color shader from its own thread, so the shaders can be edited while
+	the game runs. A new color shader is compiled on that thread and swapped in by Frame. Release builds leave it out.*/
+	// Create the shader reloader object.
+	m_ShaderReloader = new ShaderReloaderClass;
+	if (!m_ShaderReloader)
+	{
+		return false;
+	}
+
+	// Initialize the shader reloader object.
+	result = m_ShaderReloader->Initialize(m_Direct3D, m_ShaderCache, SHADER_DESCRIPTION_FILE, SHADER_ARCHIVE_FILE, MODEL_VERTEX_FORMAT,
+		SHADER_RELOAD_INTERVAL);
+	if (!result)
+	{
+		ShowError(hwnd, L"Could not initialize the shader reloader object.", L"Error");
+		return false;
+	}
+#endif
+
+	/*All copies of the model are drawn through the instance batch with a single draw call. The scene starts out with one
+	copy at the origin, which looks exactly like drawing the model on its own.*/
+	// Create the instance batch object.
+	m_Batch = new InstanceBatchClass;
+	if (!m_Batch)
+	{
+		return false;
+	}
+
+	// Initialize the instance batch object.
+	result = m_Batch->Initialize(m_Direct3D, INSTANCE_CAPACITY);
+	if (!result)
+	{
+		ShowError(hwnd, L"Could not initialize the instance batch object.", L"Error");
+		return false;
+	}
+
+	SetInstanceCount(1);
+
+	/*Nothing is drawn right away anymore, every draw goes into the render queue first. The queue sorts the draws
+	by their state and leaves out the binds that wouldn't change anything.*/
+	// Create the render queue object.
+	m_RenderQueue = new RenderQueueClass;
+	if (!m_RenderQueue)
+	{
+		return false;
+	}
+
+	// Initialize the render queue object.
+	result = m_RenderQueue->Initialize(RENDER_QUEUE_CAPACITY, SCREEN_DEPTH);
+	if (!result)
+	{
+		ShowError(hwnd, L"Could not initialize the render queue object.", L"Error");
+		return false;
+	}
+
+	/*The shader constants of all the draws in the queue are written into one constant allocator and uploaded with a
+	single map per frame, instead of mapping the constant buffer again for every draw. On a driver without Direct3D 11.1
+	the allocator still maps once per draw, the frame is the same.*/
+	// Create the constant allocator object.
+	m_ConstantAllocator = new ConstantAllocatorClass;
+	if (!m_ConstantAllocator)
+	{
+		return false;
+	}
+
+	// Initialize the constant allocator object.
+	result = m_ConstantAllocator->Initialize(m_Direct3D, CONSTANT_ALLOCATOR_SIZE);
+	if (!result)
+	{
+		ShowError(hwnd, L"Could not initialize the constant allocator object.", L"Error");
+		return false;
+	}
+
+	/*The frame splits its work over the job system of the caller, whose threads run on every core but the one the frame
+	runs on. Without one everything runs on the calling thread.*/
+	m_JobSystem = jobSystem;
+
+	/*The render queue records its draws on the job system too, with a deferred context for every thread that records.*/
+	result = m_RenderQueue->InitializeDeferredContexts(m_Direct3D, m_JobSystem ? m_JobSystem->GetThreadCount() + 1 : 1);
+	if (!result)
+	{
+		ShowError(hwnd, L"Could not create the deferred contexts of the render queue.", L"Error");
+		return false;
+	}
+
+	/*Objects outside the view frustum are left out of the render queue. The culler tests them against the camera
+	each frame, on the job system when there are many.*/
+	// Create the frustum culler object.
+	m_Culler = new FrustumCullerClass;
+	if (!m_Culler)
+	{
+		return false;
+	}
+
+	// Initialize the frustum culler object.
+	result = m_Culler->Initialize(m_JobSystem);
 	if (!result)
 	{
-		MessageBox(hwnd, L"Could not initialize the color shader object.", L"Error", MB_OK);
+		ShowError(hwnd, L"Could not initialize the frustum culler object.", L"Error");
+		return false;
+	}
+
+	/*The scene graph holds the transforms of the scene. Its root takes the place of the one world matrix of the device,
+	the separate objects hang under it.*/
+	// Create the scene graph object.
+	m_Scene = new SceneGraphClass;
+	if (!m_Scene)
+	{
 		return false;
 	}
 
+	// Initialize the scene graph object and add the root.
+	result = m_Scene->Initialize(1);
+	if (!result)
+	{
+		return false;
+	}
+	m_sceneRoot = m_Scene->AddNode(-1, XMFLOAT3(0.0f, 0.0f, 0.0f), XMFLOAT4(0.0f, 0.0f, 0.0f, 1.0f), XMFLOAT3(1.0f, 1.0f, 1.0f));
+	m_Scene->Update(m_JobSystem);
+
 	return true;
 }
 
 void Graphics::Shutdown()
 {
+	// Release the scene graph object.
+	if (m_Scene)
+	{
+		m_Scene->Shutdown();
+		delete m_Scene;
+		m_Scene = 0;
+	}
+
+	// Release the frustum culler object.
+	if (m_Culler)
+	{
+		m_Culler->Shutdown();
+		delete m_Culler;
+		m_Culler = 0;
+	}
+
+	// The job system belongs to the caller.
+	m_JobSystem = 0;
+
+	// Release the constant allocator object.
+	if (m_ConstantAllocator)
+	{
+		m_ConstantAllocator->Shutdown();
+		delete m_ConstantAllocator;
+		m_ConstantAllocator = 0;
+	}
+
+	// Release the render queue object.
+	if (m_RenderQueue)
+	{
+		m_RenderQueue->Shutdown();
+		delete m_RenderQueue;
+		m_RenderQueue = 0;
+	}
+
+	// Release the instance batch object.
+	if (m_Batch)
+	{
+		m_Batch->Shutdown();
+		delete m_Batch;
+		m_Batch = 0;
+	}
+
+	// Release the shader reloader object first, it may still be compiling with the shader cache.
+	if (m_ShaderReloader)
+	{
+		m_ShaderReloader->Shutdown();
+		delete m_ShaderReloader;
+		m_ShaderReloader = 0;
+	}
 
 	// Release the color shader object.
 	if (m_ColorShader)
@@ -103,6 +381,22 @@ void Graphics::Shutdown()
 		m_ColorShader = 0;
 	}
 
+	// Release the shader archive object.
+	if (m_ShaderArchive)
+	{
+		m_ShaderArchive->Shutdown();
+		delete m_ShaderArchive;
+		m_ShaderArchive = 0;
+	}
+
+	// Release the shader cache object.
+	if (m_ShaderCache)
+	{
+		m_ShaderCache->Shutdown();
+		delete m_ShaderCache;
+		m_ShaderCache = 0;
+	}
+
 	// Release the model object.
 	if (m_Model)
 	{
@@ -139,11 +433,27 @@ void Graphics::Shutdown()
 
 bool Graphics::Frame()
 {
+	PROFILE_FUNCTION();
+
 	/*The Frame function has been updated so that it now calls the Render
 	function each frame. */
 
+	ColorShaderClass* reloadedShader;
 	bool result;
 
+	/*Between two frames is the one place where nothing uses the color shader, the render queue of the last frame has
+	been executed already. A shader the reloader finished is swapped in here, so every frame uses one shader.*/
+	if (m_ShaderReloader)
+	{
+		reloadedShader = m_ShaderReloader->GetReloadedShader();
+		if (reloadedShader)
+		{
+			m_ColorShader->Shutdown();
+			delete m_ColorShader;
+			m_ColorShader = reloadedShader;
+		}
+	}
+
 	// Render the graphics scene.
 	result = Render();
 	if (!result)
@@ -155,33 +465,431 @@ bool Graphics::Frame()
 
 bool Graphics::Render()
 {
-
-	XMMATRIX worldMatrix, viewMatrix, projectionMatrix;
+	PROFILE_FUNCTION();
+
+	XMMATRIX worldMatrix, viewMatrix, projectionMatrix, viewProjectionMatrix, worldViewProjectionMatrix, decodeMatrix, nodeMatrix;
+	XMFLOAT4X4 batchWorld, batchTransform, projection;
+	XMFLOAT4 rotation;
+	RenderCommandType command;
+	const SimulationSnapshotType* snapshot;
+	size_t i;
+	float depth, lodScale, blend, angle;
+	int lod;
 	bool result;
+	TimerClass frameTimer, stageTimer;
+
+	// Each stage of the frame is timed separately so the benchmark can tell which one got slower.
+	frameTimer.Start();
 
 	// Clear the buffers to begin the scene.
+	stageTimer.Start();
 	m_Direct3D->BeginScene(0.0f, 0.0f, 0.0f, 1.0f);
+	m_frameTiming.beginScene = stageTimer.GetElapsedMilliseconds();
 
 	// Generate the view matrix based on the camera's position.
+	stageTimer.Start();
 	m_Camera->Render();
+	m_frameTiming.camera = stageTimer.GetElapsedMilliseconds();
 
-	// Get the world, view, and projection matrices from the camera and d3d objects.
-	m_Direct3D->GetWorldMatrix(worldMatrix);
+	// Get the view and projection matrices from the camera, the world matrix is the one of the root of the scene.
 	m_Camera->GetViewMatrix(viewMatrix);
-	m_Direct3D->GetProjectionMatrix(projectionMatrix);
+	m_Camera->GetProjectionMatrix(projectionMatrix);
+	m_Camera->GetViewProjectionMatrix(viewProjectionMatrix);
 
-	// Put the model vertex and index buffers on the graphics pipeline to prepare them for drawing.
-	m_Model->Render(m_Direct3D->GetDeviceContext());
+	/*The shaders get one premultiplied and transposed world-view-projection matrix per draw. They are all made here
+	in one batch. The instances start with the world matrix of the root so it is folded into the view-projection matrix
+	first, the world matrices of the objects already have it.*/
+	stageTimer.Start();
+
+	/*The simulation runs on its own thread at its own rate, the objects are put between the two states of its newest
+	step as they were one timestep before now. A snapshot from before the objects changed is left alone.*/
+	if (m_Simulation)
+	{
+		snapshot = m_Simulation->AcquireSnapshot();
+		if (snapshot->angles.size() == m_objects.size())
+		{
+			blend = SimulationClass::GetBlend(snapshot, TimerClass::GetTimeSeconds());
+			for (i = 0; i < m_objects.size(); i++)
+			{
+				angle = SimulationClass::InterpolateAngle(snapshot->previousAngles[i], snapshot->angles[i], blend);
+				XMStoreFloat4(&rotation, XMQuaternionRotationRollPitchYaw(0.0f, 0.0f, angle));
+				m_Scene->SetRotation(m_objectNodes[i], rotation);
+			}
+		}
+	}
 
-	// Render the model using the color shader.
-	result = m_ColorShader->Render(m_Direct3D->GetDeviceContext(), m_Model->GetIndexCount(), worldMatrix, viewMatrix, projectionMatrix);
+	/*Only the objects the scene moved get their world matrix again, with the decode matrix of the model in front, and
+	their bounds in the culler. The big levels of the scene are updated on the job system.*/
+	m_Scene->Update(m_JobSystem);
+	worldMatrix = XMLoadFloat4x4(&m_Scene->GetWorldMatrix(m_sceneRoot));
+	worldViewProjectionMatrix = XMMatrixMultiply(worldMatrix, viewProjectionMatrix);
+	decodeMatrix = XMLoadFloat4x4(&m_objectDecode);
+	for (i = 0; i < m_objects.size(); i++)
+	{
+		if (m_Scene->IsWorldChanged(m_objectNodes[i]))
+		{
+			nodeMatrix = XMLoadFloat4x4(&m_Scene->GetWorldMatrix(m_objectNodes[i]));
+			XMStoreFloat4x4(&m_objects[i], XMMatrixMultiply(decodeMatrix, nodeMatrix));
+			m_Culler->SetObject((int)i, nodeMatrix, m_objectBoundsCenter, m_objectBoundsExtents, m_objectBoundsRadius);
+		}
+	}
+
+	XMStoreFloat4x4(&batchWorld, XMMatrixIdentity());
+	TransformBatchClass::Multiply(&batchWorld, 1, worldViewProjectionMatrix, &batchTransform);
+
+	m_objectTransforms.resize(m_objects.size());
+	if (!m_objects.empty())
+	{
+		TransformBatchClass::Multiply(&m_objects[0], (int)m_objects.size(), viewProjectionMatrix, &m_objectTransforms[0]);
+	}
+	m_frameTiming.objectTransform = stageTimer.GetElapsedMilliseconds();
+
+	// Find the objects the camera can see, now that the culler has where the scene put them this frame.
+	stageTimer.Start();
+	m_Culler->SetFrustum(viewProjectionMatrix);
+	m_Culler->Cull(CULL_VOLUME_BOX);
+	m_frameTiming.cull = stageTimer.GetElapsedMilliseconds();
+
+	// Upload the world matrices of all the copies of the model.
+	stageTimer.Start();
+	result = m_Batch->Upload(m_Direct3D->GetContext());
+	if (!result)
+	{
+		return false;
+	}
+	m_frameTiming.instanceUpload = stageTimer.GetElapsedMilliseconds();
+
+	// Put the draws of the frame in the render queue.
+	stageTimer.Start();
+	m_RenderQueue->Clear();
+	m_ConstantAllocator->BeginFrame();
+
+	// The view and projection matrices are written once and shared by every draw.
+	m_ColorShader->WriteFrameParameters(m_ConstantAllocator, viewMatrix, projectionMatrix);
+
+	/*An error of one unit at a depth of one unit covers the vertical projection scale times half the screen height in
+	pixels. Dividing by the pixels it may cover gives the scale SelectLod compares the errors of the levels with.*/
+	XMStoreFloat4x4(&projection, projectionMatrix);
+	lodScale = projection._22 * (float)m_screenHeight * 0.5f / LOD_PIXEL_ERROR;
+	memset(&m_lodStatistics, 0, sizeof(m_lodStatistics));
+
+	// All copies of the model in the instance batch are a single instanced draw. They share one level of detail, the
+	// one of the nearest point the batch can reach.
+	lod = 0;
+	if (m_lodEnabled)
+	{
+		lod = m_Model->SelectLod(batchTransform._44 - m_batchRadius, lodScale);
+	}
+
+	memset(&command, 0, sizeof(command));
+	m_Model->FillCommand(command, lod);
+	m_Batch->FillCommand(command);
+	m_ColorShader->FillCommand(command, true);
+	m_ColorShader->WriteObjectParameters(m_ConstantAllocator, command, batchTransform);
+
+	m_RenderQueue->Submit(command, 0.0f);
+
+	if (command.instanceCount > 0)
+	{
+		m_lodStatistics.draws++;
+		m_lodStatistics.lodDraws[lod]++;
+		m_lodStatistics.triangles += (unsigned long long)m_Model->GetLodTriangleCount(lod) * command.instanceCount;
+		m_lodStatistics.fullTriangles += (unsigned long long)m_Model->GetLodTriangleCount(0) * command.instanceCount;
+	}
+
+	// Every separate object is a draw of its own with its own world matrix and level of detail, sorted front to back.
+	memset(&command, 0, sizeof(command));
+	m_ColorShader->FillCommand(command, false);
+
+	for (i = 0; i < m_objects.size(); i++)
+	{
+		// Leave out the objects outside the view frustum.
+		if (!m_Culler->IsVisible((int)i))
+		{
+			continue;
+		}
+
+		// The w of the object's origin after the perspective projection is its distance from the camera, and that
+		// is the last element of the transposed matrix.
+		depth = m_objectTransforms[i]._44;
+
+		lod = 0;
+		if (m_lodEnabled)
+		{
+			lod = m_Model->SelectLod(m_Model->GetLodDepth(m_objectTransforms[i]), lodScale);
+		}
+		m_Model->FillCommand(command, lod);
+
+		m_ColorShader->WriteObjectParameters(m_ConstantAllocator, command, m_objectTransforms[i]);
+		m_RenderQueue->Submit(command, depth);
+
+		m_lodStatistics.draws++;
+		m_lodStatistics.lodDraws[lod]++;
+		m_lodStatistics.triangles += m_Model->GetLodTriangleCount(lod);
+		m_lodStatistics.fullTriangles += m_Model->GetLodTriangleCount(0);
+	}
+	m_frameTiming.queueSubmit = stageTimer.GetElapsedMilliseconds();
+
+	// Copy the constants of all the draws into the constant buffer with one map.
+	stageTimer.Start();
+	result = m_ConstantAllocator->Upload(m_Direct3D->GetContext());
 	if (!result)
 	{
 		return false;
 	}
+	m_frameTiming.constantUpload = stageTimer.GetElapsedMilliseconds();
+
+	// Sort the draws by their state.
+	stageTimer.Start();
+	m_RenderQueue->Sort();
+	m_frameTiming.queueSort = stageTimer.GetElapsedMilliseconds();
+
+	// Issue the draws, skipping the binds that are already in place. Big queues are recorded on all threads at once,
+	// when that fails the queue issues the draws on the immediate context by itself.
+	stageTimer.Start();
+	m_RenderQueue->ExecuteParallel(m_Direct3D->GetContext(), m_ConstantAllocator, m_JobSystem, m_RenderQueue->GetDeferredContextCount());
+	m_frameTiming.queueExecute = stageTimer.GetElapsedMilliseconds();
 
 	// Present the rendered scene to the screen.
+	stageTimer.Start();
 	m_Direct3D->EndScene();
+	m_frameTiming.endScene = stageTimer.GetElapsedMilliseconds();
+
+	m_frameTiming.total = frameTimer.GetElapsedMilliseconds();
+
+	return true;
+}
+
+/*GetRenderDevice gives access to the device the frame is drawn with. The benchmarks use it to look at what the
+headless device recorded.*/
+RenderDeviceClass* Graphics::GetRenderDevice()
+{
+	return m_Direct3D;
+}
+
+/*GetCamera lets the benchmark drive the camera along its scripted path.*/
+CameraClass* Graphics::GetCamera()
+{
+	return m_Camera;
+}
+
+/*SetModel swaps the model for the one in the given file, imported the same way as the one the graphics object starts
+with. The copies of the model are put in place again since the bounds and the vertex decoding came with the model.
+When the new model can't be loaded the old one stays and the error is shown on the window.*/
+bool Graphics::SetModel(const char* filename)
+{
+	ModelClass* model;
+	string errors;
+	int instanceCount, objectCount;
+	bool result;
+
+	model = new ModelClass;
+	if (!model)
+	{
+		return false;
+	}
+
+	result = model->Initialize(m_Direct3D, filename, MODEL_VERTEX_FORMAT, errors);
+	if (!result)
+	{
+		ShowError(m_hwnd, errors + "Could not load the model.", L"Error");
+		delete model;
+		return false;
+	}
+
+	m_Model->Shutdown();
+	delete m_Model;
+	m_Model = model;
+
+	instanceCount = m_Batch->GetInstanceCount();
+	objectCount = (int)m_objects.size();
+	SetInstanceCount(instanceCount);
+	SetObjectCount(objectCount);
 
 	return true;
-}
\ No newline at end of file
+}
+
+/*SetInstanceCount replaces the copies of the model with a grid of count copies, centered on the origin and facing the
+camera. A count of one puts a single copy at the origin. The decode matrix of the model's vertex format goes in front
+of every instance matrix, so quantized positions come out in model space without costing the shader anything.*/
+void Graphics::SetInstanceCount(int count)
+{
+	int columns, rows, i;
+	float x, y, boundsRadius;
+	XMMATRIX decodeMatrix;
+	XMFLOAT3 boundsCenter, boundsExtents;
+
+	// Find the smallest square grid the copies fit in.
+	columns = 1;
+	while (columns * columns < count)
+	{
+		columns++;
+	}
+	rows = (count + columns - 1) / columns;
+
+	m_Model->GetDecodeMatrix(decodeMatrix);
+	m_Model->GetBounds(boundsCenter, boundsExtents, boundsRadius);
+
+	// The sphere around all the copies, the batch picks its level of detail by the nearest point of it.
+	m_batchRadius = sqrtf(boundsCenter.x * boundsCenter.x + boundsCenter.y * boundsCenter.y + boundsCenter.z * boundsCenter.z) + boundsRadius;
+
+	m_Batch->Clear();
+	for (i = 0; i < count; i++)
+	{
+		x = ((float)(i % columns) - (float)(columns - 1) * 0.5f) * INSTANCE_SPACING;
+		y = ((float)(i / columns) - (float)(rows - 1) * 0.5f) * INSTANCE_SPACING;
+
+		m_Batch->AddInstance(XMMatrixMultiply(decodeMatrix, XMMatrixTranslation(x, y, 0.0f)));
+	}
+
+	x = (float)(columns - 1) * 0.5f * INSTANCE_SPACING;
+	y = (float)(rows - 1) * 0.5f * INSTANCE_SPACING;
+	m_batchRadius += sqrtf(x * x + y * y);
+
+	return;
+}
+
+/*SetObjectCount replaces the separate objects with a grid of count copies of the model behind the instances. Unlike the
+instances every object is drawn on its own, with its own slice of the constant allocator, the way a scene of different models
+would be drawn. The objects are culled against the view frustum, so they are handed to the culler with the bounds of
+the model. The culler gets the object matrix without the decode matrix of the vertex format, since the bounds are
+in model space.
+
+Every object is a node under the root of the scene, the scene is built again with the root where it was. Render
+hands the culler the world matrix of every object the scene moved again, so moving the root or an object through
+GetScene moves its bounds along.
+
+With a simulation the objects spin around their z axis, see SetSimulation. They get bounds that hold the model at any
+angle, so a spinning object is never culled where it would be visible standing still.*/
+void Graphics::SetObjectCount(int count)
+{
+	int columns, rows, i, node;
+	XMFLOAT4X4 objectMatrix;
+	XMFLOAT3 position, rootPosition, rootScale;
+	XMFLOAT4 rootRotation;
+	XMMATRIX decodeMatrix, nodeMatrix;
+	XMFLOAT3 boundsCenter, boundsExtents;
+	float boundsRadius, offset;
+
+	// Find the smallest square grid the objects fit in.
+	columns = 1;
+	while (columns * columns < count)
+	{
+		columns++;
+	}
+	rows = (count + columns - 1) / columns;
+
+	m_Model->GetBounds(boundsCenter, boundsExtents, boundsRadius);
+	m_Model->GetDecodeMatrix(decodeMatrix);
+	XMStoreFloat4x4(&m_objectDecode, decodeMatrix);
+
+	// Turning around the z axis moves the center of the bounds on a circle and the corners of the box on a larger one.
+	if (m_Simulation)
+	{
+		offset = sqrtf(boundsCenter.x * boundsCenter.x + boundsCenter.y * boundsCenter.y);
+		boundsRadius += offset;
+		offset += sqrtf(boundsExtents.x * boundsExtents.x + boundsExtents.y * boundsExtents.y);
+		boundsCenter = XMFLOAT3(0.0f, 0.0f, boundsCenter.z);
+		boundsExtents = XMFLOAT3(offset, offset, boundsExtents.z);
+	}
+	m_objectBoundsCenter = boundsCenter;
+	m_objectBoundsExtents = boundsExtents;
+	m_objectBoundsRadius = boundsRadius;
+
+	// Build the scene again, the root first.
+	rootPosition = m_Scene->GetPosition(m_sceneRoot);
+	rootRotation = m_Scene->GetRotation(m_sceneRoot);
+	rootScale = m_Scene->GetScale(m_sceneRoot);
+	m_Scene->Clear();
+	m_sceneRoot = m_Scene->AddNode(-1, rootPosition, rootRotation, rootScale);
+
+	m_objectNodes.clear();
+	for (i = 0; i < count; i++)
+	{
+		position = XMFLOAT3(((float)(i % columns) - (float)(columns - 1) * 0.5f) * INSTANCE_SPACING,
+			((float)(i / columns) - (float)(rows - 1) * 0.5f) * INSTANCE_SPACING, INSTANCE_SPACING);
+		node = m_Scene->AddNode(m_sceneRoot, position, XMFLOAT4(0.0f, 0.0f, 0.0f, 1.0f), XMFLOAT3(1.0f, 1.0f, 1.0f));
+		m_objectNodes.push_back(node);
+	}
+	m_Scene->Update(m_JobSystem);
+
+	m_objects.clear();
+	m_Culler->Clear();
+	for (i = 0; i < count; i++)
+	{
+		nodeMatrix = XMLoadFloat4x4(&m_Scene->GetWorldMatrix(m_objectNodes[i]));
+		XMStoreFloat4x4(&objectMatrix, XMMatrixMultiply(decodeMatrix, nodeMatrix));
+		m_objects.push_back(objectMatrix);
+
+		m_Culler->AddObject(nodeMatrix, boundsCenter, boundsExtents, boundsRadius);
+	}
+
+	if (m_Simulation)
+	{
+		m_Simulation->SetObjectCount(count);
+	}
+
+	return;
+}
+
+/*SetSimulation lets a simulation move the separate objects, or stops that with 0. Every frame then takes the newest
+snapshot of it and draws the objects between the state before and after its step, see SimulationClass. The graphics
+object only reads the snapshots, the caller keeps the simulation running and shuts it down after the graphics object.*/
+void Graphics::SetSimulation(SimulationClass* simulation)
+{
+	m_Simulation = simulation;
+
+	// Put the objects back in place with the bounds that fit and tell the simulation how many there are.
+	SetObjectCount((int)m_objects.size());
+
+	return;
+}
+
+/*GetScene gives access to the scene graph, the root of the scene is the node GetSceneRoot returns.*/
+SceneGraphClass* Graphics::GetScene()
+{
+	return m_Scene;
+}
+
+int Graphics::GetSceneRoot()
+{
+	return m_sceneRoot;
+}
+
+/*GetRenderQueueStatistics returns how many binds the render queue issued and left out in the last frame.*/
+RenderQueueStatisticsType Graphics::GetRenderQueueStatistics()
+{
+	return m_RenderQueue->GetStatistics();
+}
+
+/*GetConstantUsage returns how many bytes of shader constants the last frame uploaded.*/
+unsigned int Graphics::GetConstantUsage()
+{
+	return m_ConstantAllocator->GetUsedSize();
+}
+
+/*GetCullStatistics returns how many objects the culler tested, kept and left out in the last frame.*/
+CullStatisticsType Graphics::GetCullStatistics()
+{
+	return m_Culler->GetStatistics();
+}
+
+/*SetLodEnabled turns the levels of detail on or off, off draws every model in full. The benchmark compares both.*/
+void Graphics::SetLodEnabled(bool enabled)
+{
+	m_lodEnabled = enabled;
+	return;
+}
+
+/*GetLodStatistics returns how many draws used which level of detail in the last frame and how many triangles that saved.*/
+LodStatisticsType Graphics::GetLodStatistics()
+{
+	return m_lodStatistics;
+}
+
+/*GetFrameTiming returns the stage timings of the last frame.*/
+void Graphics::GetFrameTiming(FrameTimingType& frameTiming)
+{
+	frameTiming = m_frameTiming;
+	return;
+}
@@ -18,18 +18,72 @@ will be empty but in future tutorials will contain all the graphics objects. */
 //////////
 // Here is the first change. We have taken out the include for windows.h and instead included the new d3dclass.h. 
 // #include <windows.h>
-#include "D3d.h"
+// The graphics class only talks to the render device interface, which one it gets (D3d or headless) is decided in Initialize.
+#include "renderdeviceclass.h"
 #include "cameraclass.h"
 #include "Modelclass.h"
 #include "colorshaderclass.h"
+#include "shadercacheclass.h"
+#include "shaderarchiveclass.h"
+#include "shaderreloaderclass.h"
+#include "instancebatchclass.h"
+#include "renderqueueclass.h"
+#include "constantallocatorclass.h"
+#include "transformbatchclass.h"
+#include "jobsystemclass.h"
+#include "frustumcullerclass.h"
+#include "simulationclass.h"
+#include "scenegraphclass.h"
+#include <vector>
 
 //////////
 // GLOBALS //
 //////////
 const bool FULL_SCREEN = false;
 const bool VSYNC_ENABLED = true;
+const int MAX_FRAMES_IN_FLIGHT = 2; // How many frames the CPU may run ahead of the GPU, see FramePacerClass.
+const double FRAME_RATE_CAP = 0.0; // The most frames a second, 0 leaves it to the vsync.
 const float SCREEN_DEPTH = 1000.0f;
 const float SCREEN_NEAR = 0.1f;
+const char MODEL_FILE[] = "../resources/quad.obj";
+const char SHADER_CACHE_DIRECTORY[] = "../shadercache";
+const char SHADER_DESCRIPTION_FILE[] = "../Tutorial2.0/color.permutations";
+const char SHADER_ARCHIVE_FILE[] = "../resources/color.shaderarchive";
+const VertexFormatType MODEL_VERTEX_FORMAT = VERTEX_FORMAT_COMPACT;
+const int INSTANCE_CAPACITY = 1024;
+const float INSTANCE_SPACING = 2.5f;
+const int RENDER_QUEUE_CAPACITY = 4096;
+const unsigned int CONSTANT_ALLOCATOR_SIZE = RENDER_QUEUE_CAPACITY * CONSTANT_SLICE_SIZE;
+const float LOD_PIXEL_ERROR = 1.0f; // How many pixels the surface of a level of detail may be off on screen.
+
+//////////
+// TYPEDEFS //
+//////////
+/*How long each stage of the last frame took, in milliseconds. The benchmark collects one of these per frame.*/
+struct FrameTimingType
+{
+	double beginScene;
+	double camera;
+	double objectTransform;
+	double cull;
+	double instanceUpload;
+	double queueSubmit;
+	double constantUpload;
+	double queueSort;
+	double queueExecute;
+	double endScene;
+	double total;
+};
+
+/*How many triangles the levels of detail left out in the last frame. A draw of the instance batch counts once for
+every instance.*/
+struct LodStatisticsType
+{
+	int draws;
+	int lodDraws[MESH_MAX_LODS];
+	unsigned long long triangles;
+	unsigned long long fullTriangles;
+};
 
 //////////////////////////////////
 // Class name: GrapchisClass
@@ -42,19 +96,58 @@ public:
 	Graphics(const Graphics&);
 	~Graphics();
 
-	bool Initialize(int, int, HWND);
+	bool Initialize(int, int, HWND, JobSystemClass*);
 	void Shutdown();
 	bool Frame();
 
+	RenderDeviceClass* GetRenderDevice();
+	CameraClass* GetCamera();
+	bool SetModel(const char*);
+	void SetInstanceCount(int);
+	void SetObjectCount(int);
+	void SetSimulation(SimulationClass*);
+	SceneGraphClass* GetScene();
+	int GetSceneRoot();
+	void SetLodEnabled(bool);
+	RenderQueueStatisticsType GetRenderQueueStatistics();
+	unsigned int GetConstantUsage();
+	CullStatisticsType GetCullStatistics();
+	LodStatisticsType GetLodStatistics();
+	void GetFrameTiming(FrameTimingType&);
+
 private:
 	bool Render();
 
 private:
 	// And the second change is the new private pointer to the D3DClass which we have called m_Direct3D. In case you were wondering I use the prefix m_ on all class variables. That way when I'm coding I can remember quickly which variables are members of the class and which are not. 
-	D3d * m_Direct3D; // - added
+	// It is a RenderDeviceClass now so that it can be either the D3d class or the HeadlessDeviceClass.
+	RenderDeviceClass* m_Direct3D; // - added
+	HWND m_hwnd;
 	CameraClass* m_Camera;
 	ModelClass* m_Model;
 	ColorShaderClass* m_ColorShader;
+	ShaderCacheClass* m_ShaderCache;
+	ShaderArchiveClass* m_ShaderArchive;
+	ShaderReloaderClass* m_ShaderReloader;
+	InstanceBatchClass* m_Batch;
+	RenderQueueClass* m_RenderQueue;
+	ConstantAllocatorClass* m_ConstantAllocator;
+	JobSystemClass* m_JobSystem;
+	FrustumCullerClass* m_Culler;
+	SimulationClass* m_Simulation;
+	std::vector<XMFLOAT4X4> m_objects;
+	SceneGraphClass* m_Scene;
+	int m_sceneRoot;
+	std::vector<int> m_objectNodes;
+	XMFLOAT4X4 m_objectDecode;
+	XMFLOAT3 m_objectBoundsCenter, m_objectBoundsExtents;
+	float m_objectBoundsRadius;
+	std::vector<XMFLOAT4X4> m_objectTransforms;
+	FrameTimingType m_frameTiming;
+	int m_screenHeight;
+	bool m_lodEnabled;
+	float m_batchRadius;
+	LodStatisticsType m_lodStatistics;
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,275 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: headlesscontextclass.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "headlesscontextclass.h"
+#include <string.h>
+
+HeadlessContextClass::HeadlessContextClass()
+{
+	memset(&m_statistics, 0, sizeof(m_statistics));
+}
+
+HeadlessContextClass::HeadlessContextClass(const HeadlessContextClass& other)
+{
+}
+
+HeadlessContextClass::~HeadlessContextClass()
+{
+}
+
+/*BeginFrame is called by the headless device at the start of every scene. It throws away the commands of the previous
+frame but keeps the memory of the command list around so recording doesn't allocate once it has warmed up.*/
+void HeadlessContextClass::BeginFrame()
+{
+	m_commands.clear();
+	memset(&m_statistics, 0, sizeof(m_statistics));
+
+	return;
+}
+
+void HeadlessContextClass::Present()
+{
+	Record(HEADLESS_PRESENT, 0, 0, 0, 0, 0);
+	m_statistics.presents++;
+
+	return;
+}
+
+void HeadlessContextClass::ClearRenderTarget(const float color[4])
+{
+	Record(HEADLESS_CLEAR_RENDER_TARGET, 0, 0, 0, 0, 0);
+	m_statistics.clears++;
+
+	return;
+}
+
+void HeadlessContextClass::ClearDepthStencil(float depth)
+{
+	Record(HEADLESS_CLEAR_DEPTH_STENCIL, 0, 0, 0, 0, 0);
+	m_statistics.clears++;
+
+	return;
+}
+
+/*Map hands out the CPU copy of the buffer so the caller writes real memory just like it would with Direct3D.*/
+bool HeadlessContextClass::Map(RenderBuffer buffer, void** data)
+{
+	HeadlessBufferType* headlessBuffer;
+
+	headlessBuffer = (HeadlessBufferType*)buffer;
+	if (!headlessBuffer || headlessBuffer->usage != RENDER_USAGE_DYNAMIC)
+	{
+		return false;
+	}
+
+	*data = headlessBuffer->data;
+
+	return true;
+}
+
+/*The update is recorded when the buffer is unlocked again since that is when Direct3D would hand the data to the GPU.*/
+void HeadlessContextClass::Unmap(RenderBuffer buffer)
+{
+	HeadlessBufferType* headlessBuffer;
+
+	headlessBuffer = (HeadlessBufferType*)buffer;
+
+	Record(HEADLESS_UPDATE_BUFFER, headlessBuffer->id, 0, headlessBuffer->byteWidth, 0, 0);
+	m_statistics.bufferUpdates++;
+
+	return;
+}
+
+void HeadlessContextClass::IASetVertexBuffers(unsigned int startSlot, unsigned int numBuffers, RenderBuffer* buffers, unsigned int* strides, unsigned int* offsets)
+{
+	unsigned int i;
+	HeadlessBufferType* headlessBuffer;
+
+	for (i = 0; i < numBuffers; i++)
+	{
+		headlessBuffer = (HeadlessBufferType*)buffers[i];
+		Record(HEADLESS_SET_VERTEX_BUFFER, headlessBuffer ? headlessBuffer->id : 0, startSlot + i, strides[i], offsets[i], 0);
+		m_statistics.vertexBufferBinds++;
+	}
+
+	return;
+}
+
+void HeadlessContextClass::IASetIndexBuffer(RenderBuffer buffer, RenderFormat format, unsigned int offset)
+{
+	HeadlessBufferType* headlessBuffer;
+
+	headlessBuffer = (HeadlessBufferType*)buffer;
+
+	Record(HEADLESS_SET_INDEX_BUFFER, headlessBuffer ? headlessBuffer->id : 0, 0, (unsigned int)format, offset, 0);
+	m_statistics.indexBufferBinds++;
+
+	return;
+}
+
+void HeadlessContextClass::IASetPrimitiveTopology(RenderTopology topology)
+{
+	Record(HEADLESS_SET_TOPOLOGY, 0, 0, (unsigned int)topology, 0, 0);
+
+	return;
+}
+
+void HeadlessContextClass::IASetInputLayout(RenderInputLayout layout)
+{
+	HeadlessInputLayoutType* headlessLayout;
+
+	headlessLayout = (HeadlessInputLayoutType*)layout;
+
+	Record(HEADLESS_SET_INPUT_LAYOUT, headlessLayout ? headlessLayout->id : 0, 0, 0, 0, 0);
+	m_statistics.inputLayoutBinds++;
+
+	return;
+}
+
+void HeadlessContextClass::VSSetShader(RenderVertexShader shader)
+{
+	HeadlessShaderType* headlessShader;
+
+	headlessShader = (HeadlessShaderType*)shader;
+
+	Record(HEADLESS_SET_VERTEX_SHADER, headlessShader ? headlessShader->id : 0, 0, 0, 0, 0);
+	m_statistics.shaderBinds++;
+
+	return;
+}
+
+void HeadlessContextClass::PSSetShader(RenderPixelShader shader)
+{
+	HeadlessShaderType* headlessShader;
+
+	headlessShader = (HeadlessShaderType*)shader;
+
+	Record(HEADLESS_SET_PIXEL_SHADER, headlessShader ? headlessShader->id : 0, 0, 0, 0, 0);
+	m_statistics.shaderBinds++;
+
+	return;
+}
+
+void HeadlessContextClass::VSSetConstantBuffers(unsigned int startSlot, unsigned int numBuffers, RenderBuffer* buffers)
+{
+	unsigned int i;
+	HeadlessBufferType* headlessBuffer;
+
+	for (i = 0; i < numBuffers; i++)
+	{
+		headlessBuffer = (HeadlessBufferType*)buffers[i];
+		Record(HEADLESS_SET_CONSTANT_BUFFER, headlessBuffer ? headlessBuffer->id : 0, startSlot + i, 0, 0, 0);
+		m_statistics.constantBufferBinds++;
+	}
+
+	return;
+}
+
+/*A range bind is recorded like a normal constant buffer bind, with the first constant and the number of constants as
+its arguments.*/
+void HeadlessContextClass::VSSetConstantBufferRange(unsigned int slot, RenderBuffer buffer, unsigned int firstConstant, unsigned int numConstants)
+{
+	HeadlessBufferType* headlessBuffer;
+
+	headlessBuffer = (HeadlessBufferType*)buffer;
+	Record(HEADLESS_SET_CONSTANT_BUFFER, headlessBuffer ? headlessBuffer->id : 0, slot, firstConstant, numConstants, 0);
+	m_statistics.constantBufferBinds++;
+
+	return;
+}
+
+void HeadlessContextClass::DrawIndexed(unsigned int indexCount, unsigned int startIndexLocation, int baseVertexLocation)
+{
+	Record(HEADLESS_DRAW_INDEXED, 0, 0, indexCount, startIndexLocation, (unsigned int)baseVertexLocation);
+	m_statistics.drawCalls++;
+	m_statistics.indexCount += indexCount;
+	m_statistics.instanceCount++;
+
+	return;
+}
+
+/*An instanced draw is still one draw call, but it draws the indices once for every instance.*/
+void HeadlessContextClass::DrawIndexedInstanced(unsigned int indexCountPerInstance, unsigned int instanceCount, unsigned int startIndexLocation, int baseVertexLocation, unsigned int startInstanceLocation)
+{
+	Record(HEADLESS_DRAW_INDEXED_INSTANCED, 0, 0, indexCountPerInstance, instanceCount, startInstanceLocation);
+	m_statistics.drawCalls++;
+	m_statistics.indexCount += (unsigned long long)indexCountPerInstance * instanceCount;
+	m_statistics.instanceCount += instanceCount;
+
+	return;
+}
+
+/*FinishCommandList hands the commands over without copying them, the context starts the next list empty but with room
+for as many commands as this one, since the next frame usually records about as many. A list that is never executed
+still has to be released by the device.*/
+bool HeadlessContextClass::FinishCommandList(RenderCommandList& commandList)
+{
+	HeadlessCommandListType* headlessCommandList;
+
+	headlessCommandList = new HeadlessCommandListType;
+	if (!headlessCommandList)
+	{
+		return false;
+	}
+
+	headlessCommandList->commands.swap(m_commands);
+	m_commands.reserve(headlessCommandList->commands.size());
+	headlessCommandList->statistics = m_statistics;
+	memset(&m_statistics, 0, sizeof(m_statistics));
+
+	commandList = (RenderCommandList)headlessCommandList;
+
+	return true;
+}
+
+void HeadlessContextClass::ExecuteCommandList(RenderCommandList commandList)
+{
+	HeadlessCommandListType* headlessCommandList;
+	const HeadlessStatisticsType* statistics;
+
+	headlessCommandList = (HeadlessCommandListType*)commandList;
+
+	Record(HEADLESS_EXECUTE_COMMAND_LIST, 0, 0, (unsigned int)headlessCommandList->commands.size(), 0, 0);
+	m_commands.insert(m_commands.end(), headlessCommandList->commands.begin(), headlessCommandList->commands.end());
+
+	statistics = &headlessCommandList->statistics;
+	m_statistics.clears += statistics->clears;
+	m_statistics.bufferUpdates += statistics->bufferUpdates;
+	m_statistics.vertexBufferBinds += statistics->vertexBufferBinds;
+	m_statistics.indexBufferBinds += statistics->indexBufferBinds;
+	m_statistics.inputLayoutBinds += statistics->inputLayoutBinds;
+	m_statistics.shaderBinds += statistics->shaderBinds;
+	m_statistics.constantBufferBinds += statistics->constantBufferBinds;
+	m_statistics.drawCalls += statistics->drawCalls;
+	m_statistics.indexCount += statistics->indexCount;
+	m_statistics.instanceCount += statistics->instanceCount;
+	m_statistics.presents += statistics->presents;
+
+	return;
+}
+
+const std::vector<HeadlessCommandType>& HeadlessContextClass::GetCommands()
+{
+	return m_commands;
+}
+
+HeadlessStatisticsType HeadlessContextClass::GetStatistics()
+{
+	return m_statistics;
+}
+
+void HeadlessContextClass::Record(HeadlessCallType call, unsigned int objectId, unsigned int slot, unsigned int argument0, unsigned int argument1, unsigned int argument2)
+{
+	HeadlessCommandType command;
+
+	command.call = call;
+	command.objectId = objectId;
+	command.slot = slot;
+	command.arguments[0] = argument0;
+	command.arguments[1] = argument1;
+	command.arguments[2] = argument2;
+
+	m_commands.push_back(command);
+
+	return;
+}
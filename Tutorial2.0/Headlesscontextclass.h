@@ -0,0 +1,163 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: headlesscontextclass.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _HEADLESSCONTEXTCLASS_H_
+#define _HEADLESSCONTEXTCLASS_H_
+
+
+//////////////
+// INCLUDES //
+//////////////
+#include <vector>
+#include "renderdeviceclass.h"
+
+
+/////////////
+// TYPEDEFS //
+/////////////
+/*These are the records the headless device hands out instead of D3D interfaces. A RenderBuffer handle coming
+from the HeadlessDeviceClass points to a HeadlessBufferType and so on. Every object gets a small id so the
+recorded commands can say which object was bound without holding on to pointers.*/
+struct HeadlessBufferType
+{
+	unsigned int id;
+	RenderBufferKind kind;
+	RenderUsage usage;
+	unsigned int byteWidth;
+	char* data;
+};
+
+/*A texture keeps a copy of its mip levels one after the other, the way the driver would copy them on creation.*/
+struct HeadlessTextureType
+{
+	unsigned int id;
+	unsigned int width;
+	unsigned int height;
+	unsigned int mipCount;
+	RenderFormat format;
+	size_t byteWidth;
+	char* data;
+};
+
+struct HeadlessShaderType
+{
+	unsigned int id;
+};
+
+struct HeadlessInputLayoutType
+{
+	unsigned int id;
+	unsigned int numElements;
+};
+
+/*Every call on the context is recorded as one of these.*/
+enum HeadlessCallType
+{
+	HEADLESS_CLEAR_RENDER_TARGET,
+	HEADLESS_CLEAR_DEPTH_STENCIL,
+	HEADLESS_UPDATE_BUFFER,
+	HEADLESS_SET_VERTEX_BUFFER,
+	HEADLESS_SET_INDEX_BUFFER,
+	HEADLESS_SET_TOPOLOGY,
+	HEADLESS_SET_INPUT_LAYOUT,
+	HEADLESS_SET_VERTEX_SHADER,
+	HEADLESS_SET_PIXEL_SHADER,
+	HEADLESS_SET_CONSTANT_BUFFER,
+	HEADLESS_DRAW_INDEXED,
+	HEADLESS_DRAW_INDEXED_INSTANCED,
+	HEADLESS_EXECUTE_COMMAND_LIST,
+	HEADLESS_PRESENT
+};
+
+/*objectId is the id of the bound object (0 when nothing was bound), slot is the pipeline slot it was bound to
+and the arguments hold whatever else the call had: the byte count of a buffer update, the index count, start index
+and base vertex of a draw, the index count, instance count and start instance of an instanced draw and so on. Executing a
+command list is recorded in front of its commands with their number as the first argument, from there on nothing is
+bound until the list binds it itself.*/
+struct HeadlessCommandType
+{
+	HeadlessCallType call;
+	unsigned int objectId;
+	unsigned int slot;
+	unsigned int arguments[3];
+};
+
+/*Running totals of the recorded calls for the current frame.*/
+struct HeadlessStatisticsType
+{
+	int clears;
+	int bufferUpdates;
+	int vertexBufferBinds;
+	int indexBufferBinds;
+	int inputLayoutBinds;
+	int shaderBinds;
+	int constantBufferBinds;
+	int drawCalls;
+	unsigned long long indexCount;
+	unsigned long long instanceCount;
+	int presents;
+};
+
+/*A RenderCommandList handle coming from a headless context points to one of these. It holds the commands and totals
+the deferred context recorded since the list before it.*/
+struct HeadlessCommandListType
+{
+	std::vector<HeadlessCommandType> commands;
+	HeadlessStatisticsType statistics;
+};
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: HeadlessContextClass
+////////////////////////////////////////////////////////////////////////////////
+/*The HeadlessContextClass is the CPU implementation of the RenderContextClass. Nothing is drawn, instead each call
+is appended to a command list that can be inspected after the frame. Mapping a buffer really hands out the memory
+of the buffer record so the CPU work of filling constant buffers is the same as with Direct3D.
+
+The same class is the deferred context of the headless device. FinishCommandList moves what was recorded into a
+HeadlessCommandListType and ExecuteCommandList appends it to the commands of the immediate context, so after a frame
+recorded on several threads the immediate context holds one command list in the order the lists were executed.*/
+class HeadlessContextClass : public RenderContextClass
+{
+public:
+	HeadlessContextClass();
+	HeadlessContextClass(const HeadlessContextClass&);
+	~HeadlessContextClass();
+
+	void BeginFrame();
+	void Present();
+
+	void ClearRenderTarget(const float[4]);
+	void ClearDepthStencil(float);
+
+	bool Map(RenderBuffer, void**);
+	void Unmap(RenderBuffer);
+
+	void IASetVertexBuffers(unsigned int, unsigned int, RenderBuffer*, unsigned int*, unsigned int*);
+	void IASetIndexBuffer(RenderBuffer, RenderFormat, unsigned int);
+	void IASetPrimitiveTopology(RenderTopology);
+	void IASetInputLayout(RenderInputLayout);
+
+	void VSSetShader(RenderVertexShader);
+	void PSSetShader(RenderPixelShader);
+	void VSSetConstantBuffers(unsigned int, unsigned int, RenderBuffer*);
+	void VSSetConstantBufferRange(unsigned int, RenderBuffer, unsigned int, unsigned int);
+
+	void DrawIndexed(unsigned int, unsigned int, int);
+	void DrawIndexedInstanced(unsigned int, unsigned int, unsigned int, int, unsigned int);
+
+	bool FinishCommandList(RenderCommandList&);
+	void ExecuteCommandList(RenderCommandList);
+
+	const std::vector<HeadlessCommandType>& GetCommands();
+	HeadlessStatisticsType GetStatistics();
+
+private:
+	void Record(HeadlessCallType, unsigned int, unsigned int, unsigned int, unsigned int, unsigned int);
+
+private:
+	std::vector<HeadlessCommandType> m_commands;
+	HeadlessStatisticsType m_statistics;
+};
+
+#endif
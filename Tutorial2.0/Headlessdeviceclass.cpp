@@ -0,0 +1,740 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: headlessdeviceclass.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "headlessdeviceclass.h"
+#include "profilerclass.h"
+#include "timerclass.h"
+#include <stdlib.h>
+#include <string.h>
+#include <fstream>
+#include <sstream>
+using namespace std;
+
+
+///////////////////////
+// FUNCTION PROTOTYPES //
+///////////////////////
+static unsigned int GetRowCount(RenderFormat, unsigned int);
+static bool ReadShaderFile(const string&, string&);
+static bool FindReflectionFixture(const string&, const char*, const char*, const RenderShaderDefine*, string&, string&);
+static bool ParseReflection(const string&, RenderShaderReflection&);
+
+
+HeadlessDeviceClass::HeadlessDeviceClass()
+{
+	m_context = 0;
+	m_nextObjectId = 1;
+	m_liveObjects = 0;
+	m_frameCount = 0;
+	m_constantBufferOffsets = true;
+	m_gpuFrameTime = 0.0;
+	m_completedFrames = 0;
+}
+
+HeadlessDeviceClass::HeadlessDeviceClass(const HeadlessDeviceClass& other)
+{
+}
+
+HeadlessDeviceClass::~HeadlessDeviceClass()
+{
+}
+
+/*Initialize only has to create the recording context and the matrices, there is no window, swap chain or video card to set up.*/
+bool HeadlessDeviceClass::Initialize(int screenWidth, int screenHeight, float screenDepth, float screenNear)
+{
+	PROFILE_FUNCTION();
+
+	// Create the recording context.
+	m_context = new HeadlessContextClass;
+	if (!m_context)
+	{
+		return false;
+	}
+
+	// Create the projection matrix for 3D rendering, the same one the D3d class builds.
+	m_projectionMatrix = XMMatrixPerspectiveFovLH(XMConvertToRadians(45.0f), 800.0f / 600.0f, 0.1f, 10.0f);
+
+	// Initialize the world matrix to the identity matrix.
+	m_worldMatrix = XMMatrixIdentity();
+
+	// Create an orthographic projection matrix for 2D rendering.
+	m_orthoMatrix = XMMatrixOrthographicLH((float)screenWidth, (float)screenHeight, screenNear, screenDepth);
+
+	return true;
+}
+
+void HeadlessDeviceClass::Shutdown()
+{
+	if (m_context)
+	{
+		delete m_context;
+		m_context = 0;
+	}
+
+	return;
+}
+
+void HeadlessDeviceClass::BeginScene(float red, float green, float blue, float alpha)
+{
+	PROFILE_FUNCTION();
+
+	float color[4];
+
+	// Start a new list of recorded commands.
+	m_context->BeginFrame();
+
+	// Setup the color to clear the buffer to.
+	color[0] = red;
+	color[1] = green;
+	color[2] = blue;
+	color[3] = alpha;
+
+	// Clear the back buffer and the depth buffer.
+	m_context->ClearRenderTarget(color);
+	m_context->ClearDepthStencil(1.0f);
+
+	return;
+}
+
+/*There is nothing to present to, we just record that the frame would have been presented here.*/
+void HeadlessDeviceClass::EndScene()
+{
+	PROFILE_FUNCTION();
+
+	double startTime;
+
+	m_context->Present();
+	m_frameCount++;
+
+	// The pretend GPU starts on a frame when it is presented and the one before it is done.
+	if (m_gpuFrameTime > 0.0)
+	{
+		startTime = TimerClass::GetTimeSeconds();
+		if (!m_frameFinishTimes.empty() && m_frameFinishTimes.back() > startTime)
+		{
+			startTime = m_frameFinishTimes.back();
+		}
+		m_frameFinishTimes.push_back(startTime + m_gpuFrameTime);
+	}
+	else
+	{
+		m_completedFrames = (unsigned long long)m_frameCount;
+	}
+
+	return;
+}
+
+RenderContextClass* HeadlessDeviceClass::GetContext()
+{
+	return m_context;
+}
+
+/*GetHeadlessContext gives benchmarks and checks access to the recorded commands of the last frame.*/
+HeadlessContextClass* HeadlessDeviceClass::GetHeadlessContext()
+{
+	return m_context;
+}
+
+void HeadlessDeviceClass::GetProjectionMatrix(XMMATRIX& projectionMatrix)
+{
+	projectionMatrix = m_projectionMatrix;
+	return;
+}
+
+void HeadlessDeviceClass::GetWorldMatrix(XMMATRIX& worldMatrix)
+{
+	worldMatrix = m_worldMatrix;
+	return;
+}
+
+void HeadlessDeviceClass::GetOrthoMatrix(XMMATRIX& orthoMatrix)
+{
+	orthoMatrix = m_orthoMatrix;
+	return;
+}
+
+/*CreateBuffer keeps a CPU copy of the buffer contents. Default buffers keep their initial data, dynamic ones are
+filled through Map/Unmap like their Direct3D counterparts.*/
+bool HeadlessDeviceClass::CreateBuffer(RenderBufferKind kind, RenderUsage usage, unsigned int byteWidth, const void* initialData, RenderBuffer& buffer)
+{
+	HeadlessBufferType* headlessBuffer;
+
+	headlessBuffer = new HeadlessBufferType;
+	if (!headlessBuffer)
+	{
+		return false;
+	}
+
+	headlessBuffer->id = m_nextObjectId++;
+	headlessBuffer->kind = kind;
+	headlessBuffer->usage = usage;
+	headlessBuffer->byteWidth = byteWidth;
+
+	headlessBuffer->data = new char[byteWidth];
+	if (!headlessBuffer->data)
+	{
+		delete headlessBuffer;
+		return false;
+	}
+
+	if (initialData)
+	{
+		memcpy(headlessBuffer->data, initialData, byteWidth);
+	}
+	else
+	{
+		memset(headlessBuffer->data, 0, byteWidth);
+	}
+
+	m_liveObjects++;
+	buffer = (RenderBuffer)headlessBuffer;
+
+	return true;
+}
+
+void HeadlessDeviceClass::ReleaseBuffer(RenderBuffer buffer)
+{
+	HeadlessBufferType* headlessBuffer;
+
+	headlessBuffer = (HeadlessBufferType*)buffer;
+	if (headlessBuffer)
+	{
+		delete[] headlessBuffer->data;
+		delete headlessBuffer;
+		m_liveObjects--;
+	}
+
+	return;
+}
+
+/*CreateTexture copies all mip levels into one block. The rows of a level are copied as they are, with the row pitch
+they were handed over with, a row of a block compressed format is a row of 4x4 blocks.*/
+bool HeadlessDeviceClass::CreateTexture(unsigned int width, unsigned int height, unsigned int mipCount, RenderFormat format,
+	const RenderTextureData* levels, RenderTexture& texture)
+{
+	HeadlessTextureType* headlessTexture;
+	size_t offset, levelSize;
+	unsigned int level, levelHeight;
+
+	if (width == 0 || height == 0 || mipCount == 0 || !levels)
+	{
+		return false;
+	}
+
+	headlessTexture = new HeadlessTextureType;
+	if (!headlessTexture)
+	{
+		return false;
+	}
+
+	headlessTexture->id = m_nextObjectId++;
+	headlessTexture->width = width;
+	headlessTexture->height = height;
+	headlessTexture->mipCount = mipCount;
+	headlessTexture->format = format;
+
+	// Every level is its row pitch times its number of rows.
+	headlessTexture->byteWidth = 0;
+	levelHeight = height;
+	for (level = 0; level < mipCount; level++)
+	{
+		headlessTexture->byteWidth += (size_t)levels[level].rowPitch * GetRowCount(format, levelHeight);
+		levelHeight = levelHeight > 1 ? levelHeight / 2 : 1;
+	}
+
+	headlessTexture->data = new char[headlessTexture->byteWidth];
+	if (!headlessTexture->data)
+	{
+		delete headlessTexture;
+		return false;
+	}
+
+	offset = 0;
+	levelHeight = height;
+	for (level = 0; level < mipCount; level++)
+	{
+		levelSize = (size_t)levels[level].rowPitch * GetRowCount(format, levelHeight);
+		memcpy(headlessTexture->data + offset, levels[level].data, levelSize);
+		offset += levelSize;
+		levelHeight = levelHeight > 1 ? levelHeight / 2 : 1;
+	}
+
+	m_liveObjects++;
+	texture = (RenderTexture)headlessTexture;
+
+	return true;
+}
+
+void HeadlessDeviceClass::ReleaseTexture(RenderTexture texture)
+{
+	HeadlessTextureType* headlessTexture;
+
+	headlessTexture = (HeadlessTextureType*)texture;
+	if (headlessTexture)
+	{
+		delete[] headlessTexture->data;
+		delete headlessTexture;
+		m_liveObjects--;
+	}
+
+	return;
+}
+
+/*There is no shader compiler without Direct3D, so the headless device doesn't compile anything. It reads the source
+and fails where the real compiler surely would, on an #error line (there is no preprocessor to leave it out) or a
+missing entry point. The reflection comes from a fixture next to the source, color_vs.reflection for color_vs.hlsl,
+that ShaderBuild -reflection writes with what the Direct3D compiler reported, see FindReflectionFixture. A variant the
+fixture doesn't have fails to compile. The "bytecode" it hands back is a line with the profile and the entry point,
+the reflection, and the defines and the source, so other defines or another source give other bytecode.*/
+bool HeadlessDeviceClass::CompileShader(const WCHAR* filename, const char* entryPoint, const char* profile, const RenderShaderDefine* defines,
+	std::vector<char>& bytecode, std::string& errors)
+{
+	char narrowFilename[1024];
+	string source, reflection, output, line;
+	istringstream lines;
+	size_t length, i;
+	int lineNumber;
+
+	errors.clear();
+
+	// Convert the file name, the standard streams only take narrow names everywhere.
+	length = wcstombs(narrowFilename, filename, sizeof(narrowFilename) - 1);
+	if (length == (size_t)-1)
+	{
+		return false;
+	}
+	narrowFilename[length] = 0;
+
+	if (!ReadShaderFile(narrowFilename, source))
+	{
+		return false;
+	}
+
+	lines.str(source);
+	for (lineNumber = 1; getline(lines, line); lineNumber++)
+	{
+		if (line.compare(0, 6, "#error") == 0)
+		{
+			errors = string(narrowFilename) + "(" + to_string(lineNumber) + "): error X1503: " + line + "\n";
+			return false;
+		}
+	}
+
+	// The entry point has to be a function or the real compiler would fail as well.
+	if (source.find(string(entryPoint) + "(") == string::npos)
+	{
+		errors = string(narrowFilename) + ": error X3501: '" + entryPoint + "': entrypoint not found\n";
+		return false;
+	}
+
+	if (!FindReflectionFixture(narrowFilename, entryPoint, profile, defines, reflection, errors))
+	{
+		return false;
+	}
+
+	output = string("headless_shader ") + profile + " " + entryPoint + "\n" + reflection + "source\n";
+	for (i = 0; defines && defines[i].Name; i++)
+	{
+		output += string("#define ") + defines[i].Name + " " + (defines[i].Definition ? defines[i].Definition : "") + "\n";
+	}
+	output += source;
+	bytecode.assign(output.begin(), output.end());
+
+	return true;
+}
+
+/*ReflectShader reads back the reflection CompileShader put in front of the source.*/
+bool HeadlessDeviceClass::ReflectShader(const void* bytecode, size_t bytecodeLength, RenderShaderReflection& reflection)
+{
+	string text;
+	size_t begin, end;
+
+	reflection.constantBuffers.clear();
+	reflection.inputs.clear();
+
+	text.assign((const char*)bytecode, bytecodeLength);
+	if (text.compare(0, 16, "headless_shader ") != 0)
+	{
+		return false;
+	}
+
+	begin = text.find('\n');
+	end = text.find("\nsource\n");
+	if (begin == string::npos || end == string::npos || end < begin)
+	{
+		return false;
+	}
+
+	return ParseReflection(text.substr(begin + 1, end - begin), reflection);
+}
+
+/*The headless compiler only ever makes its own kind of bytecode. The name changed when the reflection moved to the
+fixtures, so caches and archives of the old bytecode are not used.*/
+const char* HeadlessDeviceClass::GetShaderCompiler()
+{
+	return "headless fixtures";
+}
+
+bool HeadlessDeviceClass::CreateVertexShader(const void* bytecode, size_t bytecodeLength, RenderVertexShader& shader)
+{
+	HeadlessShaderType* headlessShader;
+
+	headlessShader = new HeadlessShaderType;
+	if (!headlessShader)
+	{
+		return false;
+	}
+
+	headlessShader->id = m_nextObjectId++;
+
+	m_liveObjects++;
+	shader = (RenderVertexShader)headlessShader;
+
+	return true;
+}
+
+bool HeadlessDeviceClass::CreatePixelShader(const void* bytecode, size_t bytecodeLength, RenderPixelShader& shader)
+{
+	HeadlessShaderType* headlessShader;
+
+	headlessShader = new HeadlessShaderType;
+	if (!headlessShader)
+	{
+		return false;
+	}
+
+	headlessShader->id = m_nextObjectId++;
+
+	m_liveObjects++;
+	shader = (RenderPixelShader)headlessShader;
+
+	return true;
+}
+
+bool HeadlessDeviceClass::CreateInputLayout(const RenderInputElement* elements, unsigned int numElements, const void* bytecode, size_t bytecodeLength, RenderInputLayout& layout)
+{
+	HeadlessInputLayoutType* headlessLayout;
+
+	headlessLayout = new HeadlessInputLayoutType;
+	if (!headlessLayout)
+	{
+		return false;
+	}
+
+	headlessLayout->id = m_nextObjectId++;
+	headlessLayout->numElements = numElements;
+
+	m_liveObjects++;
+	layout = (RenderInputLayout)headlessLayout;
+
+	return true;
+}
+
+void HeadlessDeviceClass::ReleaseVertexShader(RenderVertexShader shader)
+{
+	if (shader)
+	{
+		delete (HeadlessShaderType*)shader;
+		m_liveObjects--;
+	}
+
+	return;
+}
+
+void HeadlessDeviceClass::ReleasePixelShader(RenderPixelShader shader)
+{
+	if (shader)
+	{
+		delete (HeadlessShaderType*)shader;
+		m_liveObjects--;
+	}
+
+	return;
+}
+
+void HeadlessDeviceClass::ReleaseInputLayout(RenderInputLayout layout)
+{
+	if (layout)
+	{
+		delete (HeadlessInputLayoutType*)layout;
+		m_liveObjects--;
+	}
+
+	return;
+}
+
+/*A deferred context is just another headless context, it counts as a live object until it is released. The command
+lists it finishes are owned by whoever executes them.*/
+bool HeadlessDeviceClass::CreateDeferredContext(RenderContextClass*& context)
+{
+	HeadlessContextClass* headlessContext;
+
+	headlessContext = new HeadlessContextClass;
+	if (!headlessContext)
+	{
+		return false;
+	}
+
+	context = headlessContext;
+	m_liveObjects++;
+
+	return true;
+}
+
+void HeadlessDeviceClass::ReleaseDeferredContext(RenderContextClass* context)
+{
+	if (context)
+	{
+		delete (HeadlessContextClass*)context;
+		m_liveObjects--;
+	}
+
+	return;
+}
+
+void HeadlessDeviceClass::ReleaseCommandList(RenderCommandList commandList)
+{
+	if (commandList)
+	{
+		delete (HeadlessCommandListType*)commandList;
+	}
+
+	return;
+}
+
+/*GetCompletedFrames returns every frame that was presented, the headless device is done with a frame when EndScene
+returns. With a GPU frame time set it only returns the frames that pretend GPU got done with by now.*/
+unsigned long long HeadlessDeviceClass::GetCompletedFrames()
+{
+	double now;
+
+	now = TimerClass::GetTimeSeconds();
+	while (!m_frameFinishTimes.empty() && m_frameFinishTimes.front() <= now)
+	{
+		m_frameFinishTimes.pop_front();
+		m_completedFrames++;
+	}
+
+	return m_completedFrames;
+}
+
+/*The headless device supports binding at an offset unless SetConstantBufferOffsets turned it off, that is how the
+benchmark checks the path for drivers without Direct3D 11.1.*/
+bool HeadlessDeviceClass::SupportsConstantBufferOffsets()
+{
+	return m_constantBufferOffsets;
+}
+
+void HeadlessDeviceClass::SetConstantBufferOffsets(bool enabled)
+{
+	m_constantBufferOffsets = enabled;
+	return;
+}
+
+/*SetGpuFrameTime makes every frame take the given seconds on the GPU after it was presented, so a frame pacer on the
+real clock has frames in flight to wait for. Zero, the default, finishes every frame in EndScene.*/
+void HeadlessDeviceClass::SetGpuFrameTime(double seconds)
+{
+	m_gpuFrameTime = seconds;
+	return;
+}
+
+int HeadlessDeviceClass::GetFrameCount()
+{
+	return m_frameCount;
+}
+
+/*GetLiveObjectCount is handy to check that everything created was also released again on shutdown.*/
+int HeadlessDeviceClass::GetLiveObjectCount()
+{
+	return m_liveObjects;
+}
+
+/*GetRowCount returns the number of rows of a texture level of the given height, block compressed formats have rows
+of 4 texels high.*/
+static unsigned int GetRowCount(RenderFormat format, unsigned int height)
+{
+	if (format == RENDER_FORMAT_BC1_UNORM || format == RENDER_FORMAT_BC3_UNORM || format == RENDER_FORMAT_BC7_UNORM)
+	{
+		return (height + 3) / 4;
+	}
+
+	return height;
+}
+
+/*ReadShaderFile reads a whole source file into a string.*/
+static bool ReadShaderFile(const string& filename, string& source)
+{
+	ifstream fin;
+
+	fin.open(filename.c_str(), ios::in | ios::binary);
+	if (fin.fail())
+	{
+		return false;
+	}
+
+	source.assign(istreambuf_iterator<char>(fin), istreambuf_iterator<char>());
+	fin.close();
+
+	return true;
+}
+
+/*FindReflectionFixture reads the reflection of a variant from the fixture of its source, the file with the extension
+replaced by .reflection. The fixture is text, every line a keyword and its arguments and # starting a comment:
+
+shader <entry point> <profile> <NAME=VALUE>...
+cbuffer <name> <slot> <size>
+variable <name> <offset> <size>
+input <semantic name> <semantic index> <components> <float|uint|sint|unknown>
+
+A shader line starts the reflection of a variant, the variables belong to the cbuffer before them. A variant matches
+when it has the entry point and profile and every define of the shader line, the first one that matches is used.
+ShaderBuild writes every define of every variant, a fixture written by hand can leave out the ones that don't matter.
+reflection is set to the lines after the shader line.*/
+static bool FindReflectionFixture(const string& filename, const char* entryPoint, const char* profile, const RenderShaderDefine* defines,
+	string& reflection, string& errors)
+{
+	string fixtureFile, line, word, name, value;
+	istringstream words;
+	RenderShaderReflection parsed;
+	ifstream fin;
+	size_t position, i;
+	bool found, matches;
+
+	position = filename.find_last_of('.');
+	if (position == string::npos || filename.find_first_of("/\\", position) != string::npos)
+	{
+		position = filename.size();
+	}
+	fixtureFile = filename.substr(0, position) + ".reflection";
+
+	fin.open(fixtureFile.c_str());
+	if (fin.fail())
+	{
+		errors = filename + ": error: the headless device has no reflection for it, " + fixtureFile + " is missing\n";
+		return false;
+	}
+
+	reflection.clear();
+	found = false;
+	while (getline(fin, line))
+	{
+		position = line.find('#');
+		if (position != string::npos)
+		{
+			line.erase(position);
+		}
+
+		words.clear();
+		words.str(line);
+		if (!(words >> word))
+		{
+			continue;
+		}
+
+		if (word != "shader")
+		{
+			if (found)
+			{
+				reflection += line + "\n";
+			}
+			continue;
+		}
+
+		// The next shader line ends the one that was found.
+		if (found)
+		{
+			break;
+		}
+
+		matches = (words >> word) && word == entryPoint && (words >> word) && word == profile;
+		while (matches && words >> word)
+		{
+			position = word.find('=');
+			name = word.substr(0, position);
+			value = position == string::npos ? "" : word.substr(position + 1);
+			matches = false;
+			for (i = 0; defines && defines[i].Name; i++)
+			{
+				if (name == defines[i].Name)
+				{
+					matches = value == (defines[i].Definition ? defines[i].Definition : "");
+					break;
+				}
+			}
+		}
+		found = matches;
+	}
+	fin.close();
+
+	if (!found)
+	{
+		errors = filename + ": error: " + fixtureFile + " has no reflection of " + entryPoint + " " + profile + " with these defines\n";
+		return false;
+	}
+	if (!ParseReflection(reflection, parsed))
+	{
+		errors = fixtureFile + ": error: the reflection of " + entryPoint + " can't be read\n";
+		return false;
+	}
+
+	return true;
+}
+
+/*ParseReflection reads the cbuffer, variable and input lines of a fixture.*/
+static bool ParseReflection(const string& text, RenderShaderReflection& reflection)
+{
+	RenderShaderConstantBuffer buffer;
+	RenderShaderVariable variable;
+	RenderShaderInput input;
+	istringstream lines, words;
+	string line, word, type;
+
+	reflection.constantBuffers.clear();
+	reflection.inputs.clear();
+
+	lines.str(text);
+	while (getline(lines, line))
+	{
+		words.clear();
+		words.str(line);
+		if (!(words >> word))
+		{
+			continue;
+		}
+
+		if (word == "cbuffer")
+		{
+			buffer.variables.clear();
+			if (!(words >> buffer.name >> buffer.slot >> buffer.size))
+			{
+				return false;
+			}
+			reflection.constantBuffers.push_back(buffer);
+		}
+		else if (word == "variable")
+		{
+			if (reflection.constantBuffers.empty() || !(words >> variable.name >> variable.offset >> variable.size))
+			{
+				return false;
+			}
+			reflection.constantBuffers.back().variables.push_back(variable);
+		}
+		else if (word == "input")
+		{
+			if (!(words >> input.semanticName >> input.semanticIndex >> input.componentCount >> type))
+			{
+				return false;
+			}
+			input.componentType = type == "float" ? RENDER_COMPONENT_FLOAT32 : type == "uint" ? RENDER_COMPONENT_UINT32 :
+				type == "sint" ? RENDER_COMPONENT_SINT32 : RENDER_COMPONENT_UNKNOWN;
+			reflection.inputs.push_back(input);
+		}
+		else
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
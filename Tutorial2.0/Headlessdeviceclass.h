@@ -0,0 +1,86 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: headlessdeviceclass.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _HEADLESSDEVICECLASS_H_
+#define _HEADLESSDEVICECLASS_H_
+
+
+//////////////
+// INCLUDES //
+//////////////
+#include <atomic>
+#include <deque>
+#include "renderdeviceclass.h"
+#include "headlesscontextclass.h"
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: HeadlessDeviceClass
+////////////////////////////////////////////////////////////////////////////////
+/*The HeadlessDeviceClass is the stand-in for the D3d class on machines without a window or a video card. It creates
+CPU records instead of Direct3D resources and hands all drawing to a HeadlessContextClass that records every call.
+The projection, world and ortho matrices are set up exactly like the D3d class does so the frame does the same math.
+Like ID3D11Device, creating and releasing resources and shaders may happen on any thread, the shader reloader does it on
+its own thread, and so may creating deferred contexts. Everything else belongs to the thread that renders.*/
+class HeadlessDeviceClass : public RenderDeviceClass
+{
+public:
+	HeadlessDeviceClass();
+	HeadlessDeviceClass(const HeadlessDeviceClass&);
+	~HeadlessDeviceClass();
+
+	bool Initialize(int, int, float, float);
+	void Shutdown();
+
+	void BeginScene(float, float, float, float);
+	void EndScene();
+	unsigned long long GetCompletedFrames();
+	bool SupportsConstantBufferOffsets();
+	void SetConstantBufferOffsets(bool);
+	void SetGpuFrameTime(double);
+
+	RenderContextClass* GetContext();
+	HeadlessContextClass* GetHeadlessContext();
+
+	void GetProjectionMatrix(XMMATRIX&);
+	void GetWorldMatrix(XMMATRIX&);
+	void GetOrthoMatrix(XMMATRIX&);
+
+	bool CreateBuffer(RenderBufferKind, RenderUsage, unsigned int, const void*, RenderBuffer&);
+	void ReleaseBuffer(RenderBuffer);
+
+	bool CreateTexture(unsigned int, unsigned int, unsigned int, RenderFormat, const RenderTextureData*, RenderTexture&);
+	void ReleaseTexture(RenderTexture);
+
+	bool CompileShader(const WCHAR*, const char*, const char*, const RenderShaderDefine*, std::vector<char>&, std::string&);
+	bool ReflectShader(const void*, size_t, RenderShaderReflection&);
+	const char* GetShaderCompiler();
+	bool CreateVertexShader(const void*, size_t, RenderVertexShader&);
+	bool CreatePixelShader(const void*, size_t, RenderPixelShader&);
+	bool CreateInputLayout(const RenderInputElement*, unsigned int, const void*, size_t, RenderInputLayout&);
+	void ReleaseVertexShader(RenderVertexShader);
+	void ReleasePixelShader(RenderPixelShader);
+	void ReleaseInputLayout(RenderInputLayout);
+
+	bool CreateDeferredContext(RenderContextClass*&);
+	void ReleaseDeferredContext(RenderContextClass*);
+	void ReleaseCommandList(RenderCommandList);
+
+	int GetFrameCount();
+	int GetLiveObjectCount();
+
+private:
+	HeadlessContextClass* m_context;
+	std::atomic<unsigned int> m_nextObjectId;
+	std::atomic<int> m_liveObjects;
+	int m_frameCount;
+	bool m_constantBufferOffsets;
+	double m_gpuFrameTime;
+	std::deque<double> m_frameFinishTimes;
+	unsigned long long m_completedFrames;
+	XMMATRIX m_projectionMatrix;
+	XMMATRIX m_worldMatrix;
+	XMMATRIX m_orthoMatrix;
+};
+
+#endif
@@ -2,12 +2,23 @@
 // Filename: inputclass.cpp
 //////////////////////////////
 #include "Input.h"
+#include "profilerclass.h"
+#include "timerclass.h"
 #include <iostream>
 using namespace std;
 
 Input::Input()
 {
+	int i;
 
+	for (i = 0; i < INPUT_KEY_WORDS; i++)
+	{
+		m_keys[i] = 0;
+		m_previousKeys[i] = 0;
+		m_pressedKeys[i] = 0;
+		m_releasedKeys[i] = 0;
+	}
+	m_droppedEvents = 0;
 }
 
 Input::Input(const Input& other)
@@ -22,34 +33,165 @@ Input::~Input()
 
 void Input::Initialize()
 {
+	PROFILE_FUNCTION();
+
 	int i;
 
 	// initialize all the keys to being released and not pressed.
-	for (i = 0; i < 256; i++)
+	for (i = 0; i < INPUT_KEY_WORDS; i++)
 	{
-		m_keys[i] = false;
+		m_keys[i].store(0, memory_order_relaxed);
+		m_previousKeys[i] = 0;
+		m_pressedKeys[i] = 0;
+		m_releasedKeys[i] = 0;
 	}
+	m_frameEvents.clear();
+	m_frameEvents.reserve(INPUT_QUEUE_SIZE);
+	m_droppedEvents = 0;
 
 	return;
 };
 
 void Input::KeyDown(unsigned int input)
 {
-	// if a key is pressed then save that state in the key array.
-	m_keys[input] = true;
+	InputEventType event;
+
+	// if a key is pressed then queue it with the time it happened, Update saves it in the key state.
+	event.time = TimerClass::GetTimeSeconds();
+	event.key = input;
+	event.down = true;
+	AddEvent(event);
 
 	return;
 }
 
 void Input::KeyUp(unsigned int input)
 {
-	// if a key is released then clar that state in the key array.
-	m_keys[input] = false;
+	InputEventType event;
+
+	// if a key is released then queue it the same way.
+	event.time = TimerClass::GetTimeSeconds();
+	event.key = input;
+	event.down = false;
+	AddEvent(event);
+
+	return;
+}
+
+/*AddEvent queues an event that already has its time, KeyDown and KeyUp end up here. Only the window thread may call
+it. When the queue is full the event is dropped and counted.*/
+bool Input::AddEvent(const InputEventType& event)
+{
+	if (event.key >= (unsigned int)INPUT_KEY_COUNT)
+	{
+		return false;
+	}
+
+	if (!m_queue.Push(event))
+	{
+		m_droppedEvents.fetch_add(1, memory_order_relaxed);
+		return false;
+	}
+
+	return true;
+}
+
+/*Update is called once a frame. The key state becomes the previous one, then every queued event is applied in order.
+A key gets its pressed or released bit as soon as one of its events changes it, so a tap between two frames sets both.*/
+void Input::Update()
+{
+	PROFILE_FUNCTION();
+
+	unsigned int keys[INPUT_KEY_WORDS];
+	InputEventType event;
+	unsigned int word, bit;
+	int i;
+
+	for (i = 0; i < INPUT_KEY_WORDS; i++)
+	{
+		keys[i] = m_keys[i].load(memory_order_relaxed);
+		m_previousKeys[i] = keys[i];
+		m_pressedKeys[i] = 0;
+		m_releasedKeys[i] = 0;
+	}
+
+	m_frameEvents.clear();
+	while (m_queue.Pop(event))
+	{
+		word = event.key >> 5;
+		bit = 1u << (event.key & 31);
+		if (event.down)
+		{
+			m_pressedKeys[word] |= ~keys[word] & bit;
+			keys[word] |= bit;
+		}
+		else
+		{
+			m_releasedKeys[word] |= keys[word] & bit;
+			keys[word] &= ~bit;
+		}
+		m_frameEvents.push_back(event);
+	}
+
+	for (i = 0; i < INPUT_KEY_WORDS; i++)
+	{
+		m_keys[i].store(keys[i], memory_order_release);
+	}
+
 	return;
 }
 
 bool Input::IsKeyDown(unsigned int key)
 {
 	// Return what state they key is in (pressed/not pressed)
-	return m_keys[key];
+	if (key >= (unsigned int)INPUT_KEY_COUNT)
+	{
+		return false;
+	}
+
+	return (m_keys[key >> 5].load(memory_order_acquire) & (1u << (key & 31))) != 0;
+}
+
+/*WasKeyDown returns the state of the key at the Update before.*/
+bool Input::WasKeyDown(unsigned int key)
+{
+	if (key >= (unsigned int)INPUT_KEY_COUNT)
+	{
+		return false;
+	}
+
+	return (m_previousKeys[key >> 5] & (1u << (key & 31))) != 0;
+}
+
+/*IsKeyPressed is true when the key went down since the Update before.*/
+bool Input::IsKeyPressed(unsigned int key)
+{
+	if (key >= (unsigned int)INPUT_KEY_COUNT)
+	{
+		return false;
+	}
+
+	return (m_pressedKeys[key >> 5] & (1u << (key & 31))) != 0;
+}
+
+/*IsKeyReleased is true when the key went up since the Update before.*/
+bool Input::IsKeyReleased(unsigned int key)
+{
+	if (key >= (unsigned int)INPUT_KEY_COUNT)
+	{
+		return false;
+	}
+
+	return (m_releasedKeys[key >> 5] & (1u << (key & 31))) != 0;
+}
+
+/*GetFrameEvents returns the events the last Update applied, oldest first.*/
+const vector<InputEventType>& Input::GetFrameEvents()
+{
+	return m_frameEvents;
+}
+
+int Input::GetDroppedEvents()
+{
+	return m_droppedEvents.load(memory_order_relaxed);
 }
\ No newline at end of file
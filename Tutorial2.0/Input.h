@@ -5,6 +5,20 @@
 #ifndef _INPUTCLASS_H_
 #define _INPUTCLASS_H_
 
+//////////////
+// INCLUDES //
+//////////////
+#include <atomic>
+#include <vector>
+#include "inputqueueclass.h"
+using namespace std;
+
+/////////////
+// GLOBALS //
+/////////////
+const int INPUT_KEY_COUNT = 256; // The virtual key codes go up to 255.
+const int INPUT_KEY_WORDS = INPUT_KEY_COUNT / 32; // The key states are packed 32 keys to a word.
+
 ////////////////////////////////
 // Class name: InputClass
 ////////////////////////////////
@@ -16,6 +30,13 @@ the user input from the keyboard. This class is given input from the
 SystemClass::MessageHandler function. The input object will store the state
 of each key in a keyboard array. When queried it will tell the calling functions if
 a certain key is pressed. Here is the header: */
+/*KeyDown and KeyUp don't change the key state, they push a timestamped event into the InputQueueClass. Update takes
+all of them out once a frame, in order, and keeps the state of every key as one bit, now and at the Update before. A
+key that went down and up again between two updates still counts as pressed and released for that frame, and
+GetFrameEvents has every event of the frame with its time.
+
+Only one thread calls Update and the edge queries, which can be the simulation thread instead of the window thread.
+IsKeyDown can be called from any thread, the key state is published with atomic stores of its words.*/
 class Input
 {
 public:
@@ -27,10 +48,25 @@ public:
 
 	void KeyDown(unsigned int);
 	void KeyUp(unsigned int);
+	bool AddEvent(const InputEventType&);
+
+	void Update();
 
 	bool IsKeyDown(unsigned int);
+	bool WasKeyDown(unsigned int);
+	bool IsKeyPressed(unsigned int);
+	bool IsKeyReleased(unsigned int);
+	const vector<InputEventType>& GetFrameEvents();
+	int GetDroppedEvents();
 
-private: bool m_keys[256];
+private:
+	InputQueueClass m_queue;
+	atomic<unsigned int> m_keys[INPUT_KEY_WORDS];
+	unsigned int m_previousKeys[INPUT_KEY_WORDS];
+	unsigned int m_pressedKeys[INPUT_KEY_WORDS];
+	unsigned int m_releasedKeys[INPUT_KEY_WORDS];
+	vector<InputEventType> m_frameEvents;
+	atomic<int> m_droppedEvents;
 };
 
 #endif
\ No newline at end of file
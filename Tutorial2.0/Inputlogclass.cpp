@@ -0,0 +1,261 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: inputlogclass.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "inputlogclass.h"
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+
+/////////////
+// GLOBALS //
+/////////////
+static const char INPUT_LOG_MAGIC[4] = { 'I', 'N', 'P', 'L' };
+
+
+InputLogClass::InputLogClass()
+{
+	m_readOffset = 0;
+	m_startTime = 0.0;
+	m_lastMicroseconds = 0;
+	m_frameCount = 0;
+	m_eventCount = 0;
+}
+
+InputLogClass::InputLogClass(const InputLogClass& other)
+{
+}
+
+InputLogClass::~InputLogClass()
+{
+}
+
+/*BeginRecording throws away what the log held and starts a new recording at the given time.*/
+void InputLogClass::BeginRecording(double startTime)
+{
+	m_data.clear();
+	m_readOffset = 0;
+	m_startTime = startTime;
+	m_lastMicroseconds = 0;
+	m_frameCount = 0;
+	m_eventCount = 0;
+
+	return;
+}
+
+/*RecordFrame adds a frame with the frame time it used and the events the Input applied in it, oldest first.*/
+void InputLogClass::RecordFrame(float frameTime, const vector<InputEventType>& events)
+{
+	unsigned char frameTimeBytes[sizeof(float)];
+	long long microseconds, delta;
+	size_t i;
+
+	memcpy(frameTimeBytes, &frameTime, sizeof(float));
+	m_data.insert(m_data.end(), frameTimeBytes, frameTimeBytes + sizeof(float));
+	WriteVarint(events.size());
+
+	for (i = 0; i < events.size(); i++)
+	{
+		// The events are in order, one that seems earlier because of rounding is stored at the same time.
+		microseconds = (long long)floor((events[i].time - m_startTime) * 1000000.0 + 0.5);
+		delta = microseconds - m_lastMicroseconds;
+		if (delta < 0)
+		{
+			delta = 0;
+		}
+		m_lastMicroseconds += delta;
+
+		m_data.push_back((unsigned char)events[i].key);
+		WriteVarint(((unsigned long long)delta << 1) | (events[i].down ? 1 : 0));
+	}
+
+	m_frameCount++;
+	m_eventCount += (int)events.size();
+
+	return;
+}
+
+/*Save writes the header and the frames to a file.*/
+bool InputLogClass::Save(const char* filename)
+{
+	InputLogHeaderType header;
+	FILE* file;
+	bool result;
+
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, INPUT_LOG_MAGIC, sizeof(header.magic));
+	header.version = INPUT_LOG_VERSION;
+	header.frameCount = (unsigned int)m_frameCount;
+	header.eventCount = (unsigned int)m_eventCount;
+	header.dataSize = m_data.size();
+	header.startTime = m_startTime;
+
+	file = fopen(filename, "wb");
+	if (!file)
+	{
+		return false;
+	}
+
+	result = fwrite(&header, sizeof(header), 1, file) == 1;
+	if (result && !m_data.empty())
+	{
+		result = fwrite(&m_data[0], 1, m_data.size(), file) == m_data.size();
+	}
+	result = fclose(file) == 0 && result;
+
+	return result;
+}
+
+/*Load reads a log written by Save and rewinds it to the first frame. It fails on a file of another version or one that
+was cut off or holds less than its header says.*/
+bool InputLogClass::Load(const char* filename)
+{
+	InputLogHeaderType header;
+	FILE* file;
+	long dataStart, fileEnd;
+	bool result;
+
+	file = fopen(filename, "rb");
+	if (!file)
+	{
+		return false;
+	}
+
+	result = fread(&header, sizeof(header), 1, file) == 1 && memcmp(header.magic, INPUT_LOG_MAGIC, sizeof(header.magic)) == 0 &&
+		header.version == INPUT_LOG_VERSION;
+
+	// The size in the header has to fit in what is left of the file, a broken one must not make us allocate a fortune.
+	if (result)
+	{
+		dataStart = ftell(file);
+		result = dataStart >= 0 && fseek(file, 0, SEEK_END) == 0;
+		fileEnd = result ? ftell(file) : -1;
+		result = result && fileEnd >= dataStart && header.dataSize <= (unsigned long long)(fileEnd - dataStart) &&
+			fseek(file, dataStart, SEEK_SET) == 0;
+	}
+
+	if (result)
+	{
+		m_data.resize((size_t)header.dataSize);
+		if (!m_data.empty())
+		{
+			result = fread(&m_data[0], 1, m_data.size(), file) == m_data.size();
+		}
+	}
+	fclose(file);
+
+	if (!result)
+	{
+		m_data.clear();
+		m_frameCount = 0;
+		m_eventCount = 0;
+		return false;
+	}
+
+	m_startTime = header.startTime;
+	m_frameCount = (int)header.frameCount;
+	m_eventCount = (int)header.eventCount;
+	Rewind();
+
+	return true;
+}
+
+void InputLogClass::Rewind()
+{
+	m_readOffset = 0;
+	m_lastMicroseconds = 0;
+
+	return;
+}
+
+/*ReadFrame reads the next frame. It returns false after the last frame, or when the data is broken.*/
+bool InputLogClass::ReadFrame(float& frameTime, vector<InputEventType>& events)
+{
+	InputEventType event;
+	unsigned long long count, value, i;
+
+	events.clear();
+	if (m_readOffset + sizeof(float) > m_data.size())
+	{
+		return false;
+	}
+
+	memcpy(&frameTime, &m_data[m_readOffset], sizeof(float));
+	m_readOffset += sizeof(float);
+	if (!ReadVarint(count))
+	{
+		return false;
+	}
+
+	for (i = 0; i < count; i++)
+	{
+		if (m_readOffset >= m_data.size())
+		{
+			return false;
+		}
+		event.key = m_data[m_readOffset];
+		m_readOffset++;
+
+		if (!ReadVarint(value))
+		{
+			return false;
+		}
+		m_lastMicroseconds += (long long)(value >> 1);
+		event.down = (value & 1) != 0;
+		event.time = m_startTime + (double)m_lastMicroseconds / 1000000.0;
+		events.push_back(event);
+	}
+
+	return true;
+}
+
+int InputLogClass::GetFrameCount()
+{
+	return m_frameCount;
+}
+
+int InputLogClass::GetEventCount()
+{
+	return m_eventCount;
+}
+
+/*GetSize returns how many bytes the log takes in a file.*/
+unsigned long long InputLogClass::GetSize()
+{
+	return sizeof(InputLogHeaderType) + m_data.size();
+}
+
+/*WriteVarint writes 7 bits a byte, the lowest first, with the top bit set on every byte but the last.*/
+void InputLogClass::WriteVarint(unsigned long long value)
+{
+	while (value >= 0x80)
+	{
+		m_data.push_back((unsigned char)(value | 0x80));
+		value >>= 7;
+	}
+	m_data.push_back((unsigned char)value);
+
+	return;
+}
+
+bool InputLogClass::ReadVarint(unsigned long long& value)
+{
+	unsigned int shift;
+	unsigned char byte;
+
+	value = 0;
+	shift = 0;
+	do
+	{
+		if (m_readOffset >= m_data.size() || shift > 63)
+		{
+			return false;
+		}
+		byte = m_data[m_readOffset];
+		m_readOffset++;
+		value |= (unsigned long long)(byte & 0x7f) << shift;
+		shift += 7;
+	} while (byte & 0x80);
+
+	return true;
+}
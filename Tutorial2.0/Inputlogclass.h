@@ -0,0 +1,83 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: inputlogclass.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _INPUTLOGCLASS_H_
+#define _INPUTLOGCLASS_H_
+
+
+//////////////
+// INCLUDES //
+//////////////
+#include <vector>
+#include "inputqueueclass.h"
+using namespace std;
+
+
+/////////////
+// GLOBALS //
+/////////////
+/*Bump the version whenever the layout of the log changes, old logs don't load anymore.*/
+const unsigned int INPUT_LOG_VERSION = 1;
+
+
+/////////////
+// TYPEDEFS //
+/////////////
+/*The header at the start of every input log, followed by the frames. startTime is when the recording started on the
+clock of TimerClass::GetTimeSeconds, the times of the events count from there.*/
+struct InputLogHeaderType
+{
+	char magic[4];
+	unsigned int version;
+	unsigned int frameCount;
+	unsigned int eventCount;
+	unsigned long long dataSize;
+	double startTime;
+};
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: InputLogClass
+////////////////////////////////////////////////////////////////////////////////
+/*The InputLogClass records the frame time and the input events of every frame so the run can be replayed later without
+a window or a message pump. A frame is the 4 bytes of its frame time as the frame used it, so the replay gets the very
+same float, and the number of events as a variable length integer. An event is a byte with its key and a variable
+length integer with whether it went down in the lowest bit and the microseconds since the event before in the rest.
+A frame without input takes 5 bytes and a key event usually 3.
+
+Replaying feeds the events of a frame into an Input with AddEvent, updates it and hands the frame time to whatever
+reacts to the input, like the CameraControllerClass. The events come back with their times rounded to the microsecond,
+the keys and the order are exact.*/
+class InputLogClass
+{
+public:
+	InputLogClass();
+	InputLogClass(const InputLogClass&);
+	~InputLogClass();
+
+	void BeginRecording(double);
+	void RecordFrame(float, const vector<InputEventType>&);
+	bool Save(const char*);
+
+	bool Load(const char*);
+	void Rewind();
+	bool ReadFrame(float&, vector<InputEventType>&);
+
+	int GetFrameCount();
+	int GetEventCount();
+	unsigned long long GetSize();
+
+private:
+	void WriteVarint(unsigned long long);
+	bool ReadVarint(unsigned long long&);
+
+private:
+	vector<unsigned char> m_data;
+	size_t m_readOffset;
+	double m_startTime;
+	long long m_lastMicroseconds;
+	int m_frameCount;
+	int m_eventCount;
+};
+
+#endif
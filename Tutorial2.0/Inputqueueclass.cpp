@@ -0,0 +1,64 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: inputqueueclass.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "inputqueueclass.h"
+
+InputQueueClass::InputQueueClass()
+{
+	m_head = 0;
+	m_cachedTail = 0;
+	m_tail = 0;
+	m_cachedHead = 0;
+}
+
+InputQueueClass::InputQueueClass(const InputQueueClass& other)
+{
+}
+
+InputQueueClass::~InputQueueClass()
+{
+}
+
+/*Push adds an event at the tail, only the pushing thread calls it. It fails when the ring is full. The release store of
+the tail publishes the event to the popping thread.*/
+bool InputQueueClass::Push(const InputEventType& event)
+{
+	unsigned long long tail;
+
+	tail = m_tail.load(memory_order_relaxed);
+	if (tail - m_cachedHead >= INPUT_QUEUE_SIZE)
+	{
+		m_cachedHead = m_head.load(memory_order_acquire);
+		if (tail - m_cachedHead >= INPUT_QUEUE_SIZE)
+		{
+			return false;
+		}
+	}
+
+	m_events[tail & (INPUT_QUEUE_SIZE - 1)] = event;
+	m_tail.store(tail + 1, memory_order_release);
+
+	return true;
+}
+
+/*Pop takes the event at the head, the oldest one, only the popping thread calls it. It fails when the ring is empty.
+The release store of the head hands the slot back to the pushing thread.*/
+bool InputQueueClass::Pop(InputEventType& event)
+{
+	unsigned long long head;
+
+	head = m_head.load(memory_order_relaxed);
+	if (head == m_cachedTail)
+	{
+		m_cachedTail = m_tail.load(memory_order_acquire);
+		if (head == m_cachedTail)
+		{
+			return false;
+		}
+	}
+
+	event = m_events[head & (INPUT_QUEUE_SIZE - 1)];
+	m_head.store(head + 1, memory_order_release);
+
+	return true;
+}
@@ -0,0 +1,66 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: inputqueueclass.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _INPUTQUEUECLASS_H_
+#define _INPUTQUEUECLASS_H_
+
+
+//////////////
+// INCLUDES //
+//////////////
+#include <atomic>
+using namespace std;
+
+
+/////////////
+// GLOBALS //
+/////////////
+/*How many input events the queue holds, it has to be a power of two. That is many seconds of typing, the window thread
+only fills it up when nobody takes the events out.*/
+const int INPUT_QUEUE_SIZE = 1024;
+/*The size of a cache line. The index each side writes is on a line of its own so the two threads don't keep taking
+the line away from each other.*/
+const int INPUT_QUEUE_CACHE_LINE = 64;
+
+
+/////////////
+// TYPEDEFS //
+/////////////
+/*A key that went down or up, with the time it happened on the clock of TimerClass::GetTimeSeconds.*/
+struct InputEventType
+{
+	double time;
+	unsigned int key;
+	bool down;
+};
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: InputQueueClass
+////////////////////////////////////////////////////////////////////////////////
+/*The InputQueueClass is a ring of input events with one thread that pushes, the window thread, and one thread that
+pops, whichever thread updates the Input. Neither takes a lock: the pushing thread only writes the tail and the popping
+thread only writes the head, each publishes its side with a release store. Both keep a copy of the other side's index
+and only read the shared one again when the copy says the ring is full or empty, so a push or a pop usually touches no
+cache line the other thread wrote.*/
+class InputQueueClass
+{
+public:
+	InputQueueClass();
+	InputQueueClass(const InputQueueClass&);
+	~InputQueueClass();
+
+	bool Push(const InputEventType&);
+	bool Pop(InputEventType&);
+
+private:
+	atomic<unsigned long long> m_head;
+	unsigned long long m_cachedTail;
+	char m_headPadding[INPUT_QUEUE_CACHE_LINE - sizeof(atomic<unsigned long long>) - sizeof(unsigned long long)];
+	atomic<unsigned long long> m_tail;
+	unsigned long long m_cachedHead;
+	char m_tailPadding[INPUT_QUEUE_CACHE_LINE - sizeof(atomic<unsigned long long>) - sizeof(unsigned long long)];
+	InputEventType m_events[INPUT_QUEUE_SIZE];
+};
+
+#endif
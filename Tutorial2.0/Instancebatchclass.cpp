@@ -0,0 +1,162 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: instancebatchclass.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "instancebatchclass.h"
+#include "profilerclass.h"
+#include <string.h>
+
+InstanceBatchClass::InstanceBatchClass()
+{
+	m_device = 0;
+	m_instanceBuffer = 0;
+	m_instanceCapacity = 0;
+}
+
+InstanceBatchClass::InstanceBatchClass(const InstanceBatchClass& other)
+{
+}
+
+InstanceBatchClass::~InstanceBatchClass()
+{
+}
+
+/*Initialize creates the instance buffer with room for maxInstances instances.*/
+bool InstanceBatchClass::Initialize(RenderDeviceClass* device, int maxInstances)
+{
+	PROFILE_FUNCTION();
+
+	bool result;
+
+	// Keep the device around to grow and release the buffer.
+	m_device = device;
+
+	// Reserve the CPU side list as well so adding instances doesn't reallocate every frame.
+	m_instances.reserve(maxInstances);
+
+	result = CreateInstanceBuffer(maxInstances);
+	if (!result)
+	{
+		return false;
+	}
+
+	return true;
+}
+
+void InstanceBatchClass::Shutdown()
+{
+	// Release the instance buffer.
+	if (m_instanceBuffer)
+	{
+		m_device->ReleaseBuffer(m_instanceBuffer);
+		m_instanceBuffer = 0;
+	}
+
+	m_instanceCapacity = 0;
+	m_instances.clear();
+
+	return;
+}
+
+/*Upload copies all the instances into the instance buffer.*/
+bool InstanceBatchClass::Upload(RenderContextClass* deviceContext)
+{
+	PROFILE_FUNCTION();
+
+	void* mappedResource;
+	bool result;
+
+	// Grow the buffer when more instances were added than it can hold.
+	if ((int)m_instances.size() > m_instanceCapacity)
+	{
+		result = CreateInstanceBuffer((int)m_instances.size() * 2);
+		if (!result)
+		{
+			return false;
+		}
+	}
+
+	// Copy all the instances into the buffer with a single map.
+	if (!m_instances.empty())
+	{
+		result = deviceContext->Map(m_instanceBuffer, &mappedResource);
+		if (!result)
+		{
+			return false;
+		}
+
+		memcpy(mappedResource, &m_instances[0], sizeof(InstanceType) * m_instances.size());
+
+		deviceContext->Unmap(m_instanceBuffer);
+	}
+
+	return true;
+}
+
+/*FillCommand puts the instance buffer in input slot 1 of the command, next to the model vertices in slot 0, and makes
+it an instanced draw of all the instances.*/
+void InstanceBatchClass::FillCommand(RenderCommandType& command)
+{
+	command.vertexBuffers[1] = m_instanceBuffer;
+	command.strides[1] = sizeof(InstanceType);
+	command.instanceCount = (unsigned int)m_instances.size();
+
+	return;
+}
+
+/*Clear empties the list of instances but keeps its memory.*/
+void InstanceBatchClass::Clear()
+{
+	m_instances.clear();
+	return;
+}
+
+void InstanceBatchClass::AddInstance(const XMMATRIX& worldMatrix)
+{
+	InstanceType instance;
+
+	XMStoreFloat4x4(&instance.world, worldMatrix);
+	m_instances.push_back(instance);
+
+	return;
+}
+
+/*SetInstance replaces the world matrix of an instance that was added before, for instances that move.*/
+void InstanceBatchClass::SetInstance(int index, const XMMATRIX& worldMatrix)
+{
+	XMStoreFloat4x4(&m_instances[index].world, worldMatrix);
+	return;
+}
+
+int InstanceBatchClass::GetInstanceCount()
+{
+	return (int)m_instances.size();
+}
+
+/*CreateInstanceBuffer (re)creates the dynamic instance buffer with room for the given number of instances.*/
+bool InstanceBatchClass::CreateInstanceBuffer(int capacity)
+{
+	bool result;
+
+	if (capacity < 1)
+	{
+		capacity = 1;
+	}
+
+	// Release the old buffer first.
+	if (m_instanceBuffer)
+	{
+		m_device->ReleaseBuffer(m_instanceBuffer);
+		m_instanceBuffer = 0;
+	}
+
+	result = m_device->CreateBuffer(RENDER_VERTEX_BUFFER, RENDER_USAGE_DYNAMIC, sizeof(InstanceType) * capacity, NULL, m_instanceBuffer);
+	if (!result)
+	{
+		m_instanceCapacity = 0;
+		return false;
+	}
+
+	m_instanceCapacity = capacity;
+
+	return true;
+}
@@ -0,0 +1,61 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: instancebatchclass.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _INSTANCEBATCHCLASS_H_
+#define _INSTANCEBATCHCLASS_H_
+
+
+//////////////
+// INCLUDES //
+//////////////
+#include <directxmath.h>
+#include <vector>
+#include "renderdeviceclass.h"
+#include "renderqueueclass.h"
+using namespace DirectX;
+using namespace std;
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: InstanceBatchClass
+////////////////////////////////////////////////////////////////////////////////
+/*The InstanceBatchClass collects the world matrices of all copies of one model and puts them in a dynamic vertex
+buffer, so the color shader can draw all copies with a single instanced draw call. Upload copies the whole list with
+one Map/Unmap per frame no matter how many instances there are and FillCommand adds the buffer to a render command.
+The buffer grows when more instances are added than it was created for.*/
+class InstanceBatchClass
+{
+private:
+	/*This must match the WORLD0 to WORLD3 elements of the instanced layout in the ColorShaderClass. The matrix is
+	stored the way DirectXMath keeps it, one row per element.*/
+	struct InstanceType
+	{
+		XMFLOAT4X4 world;
+	};
+
+public:
+	InstanceBatchClass();
+	InstanceBatchClass(const InstanceBatchClass&);
+	~InstanceBatchClass();
+
+	bool Initialize(RenderDeviceClass*, int);
+	void Shutdown();
+	bool Upload(RenderContextClass*);
+	void FillCommand(RenderCommandType&);
+
+	void Clear();
+	void AddInstance(const XMMATRIX&);
+	void SetInstance(int, const XMMATRIX&);
+	int GetInstanceCount();
+
+private:
+	bool CreateInstanceBuffer(int);
+
+private:
+	RenderDeviceClass* m_device;
+	RenderBuffer m_instanceBuffer;
+	int m_instanceCapacity;
+	vector<InstanceType> m_instances;
+};
+
+#endif
@@ -0,0 +1,101 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: jobdequeclass.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "jobdequeclass.h"
+
+JobDequeClass::JobDequeClass()
+{
+	int i;
+
+	m_top = 0;
+	m_bottom = 0;
+	for (i = 0; i < JOB_DEQUE_SIZE; i++)
+	{
+		m_jobs[i] = 0;
+	}
+}
+
+JobDequeClass::JobDequeClass(const JobDequeClass& other)
+{
+}
+
+JobDequeClass::~JobDequeClass()
+{
+}
+
+/*Push adds a job at the bottom. It fails when the deque is full. The release store of the bottom publishes the job,
+and everything written to it before, to the thread that steals it.*/
+bool JobDequeClass::Push(JobType* job)
+{
+	long long bottom, top;
+
+	bottom = m_bottom.load(memory_order_relaxed);
+	top = m_top.load(memory_order_acquire);
+	if (bottom - top >= JOB_DEQUE_SIZE)
+	{
+		return false;
+	}
+
+	m_jobs[bottom & (JOB_DEQUE_SIZE - 1)].store(job, memory_order_relaxed);
+	m_bottom.store(bottom + 1, memory_order_release);
+
+	return true;
+}
+
+/*Pop takes the job at the bottom, the newest one. The bottom is moved up first so a thief sees the job is taken,
+when only one job is left the thief and Pop race for it on the top with a compare and swap.*/
+JobType* JobDequeClass::Pop()
+{
+	JobType* job;
+	long long bottom, top;
+
+	bottom = m_bottom.load(memory_order_relaxed) - 1;
+	m_bottom.store(bottom, memory_order_relaxed);
+	atomic_thread_fence(memory_order_seq_cst);
+	top = m_top.load(memory_order_relaxed);
+
+	if (top > bottom)
+	{
+		// It was empty.
+		m_bottom.store(bottom + 1, memory_order_relaxed);
+		return 0;
+	}
+
+	job = m_jobs[bottom & (JOB_DEQUE_SIZE - 1)].load(memory_order_relaxed);
+	if (top == bottom)
+	{
+		// The last job, a thief may be taking it right now.
+		if (!m_top.compare_exchange_strong(top, top + 1, memory_order_seq_cst, memory_order_relaxed))
+		{
+			job = 0;
+		}
+		m_bottom.store(bottom + 1, memory_order_relaxed);
+	}
+
+	return job;
+}
+
+/*Steal takes the job at the top, the oldest one. It returns 0 when the deque is empty or another thread took the job
+first, the caller just tries somewhere else then.*/
+JobType* JobDequeClass::Steal()
+{
+	JobType* job;
+	long long bottom, top;
+
+	top = m_top.load(memory_order_acquire);
+	atomic_thread_fence(memory_order_seq_cst);
+	bottom = m_bottom.load(memory_order_acquire);
+
+	if (top >= bottom)
+	{
+		return 0;
+	}
+
+	job = m_jobs[top & (JOB_DEQUE_SIZE - 1)].load(memory_order_relaxed);
+	if (!m_top.compare_exchange_strong(top, top + 1, memory_order_seq_cst, memory_order_relaxed))
+	{
+		return 0;
+	}
+
+	return job;
+}
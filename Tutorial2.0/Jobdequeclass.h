@@ -0,0 +1,55 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: jobdequeclass.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _JOBDEQUECLASS_H_
+#define _JOBDEQUECLASS_H_
+
+
+//////////////
+// INCLUDES //
+//////////////
+#include <atomic>
+using namespace std;
+
+
+/////////////
+// GLOBALS //
+/////////////
+/*How many jobs one deque holds, it has to be a power of two. A thread that pushes more than this runs the job itself.*/
+const int JOB_DEQUE_SIZE = 4096;
+
+
+/////////////
+// TYPEDEFS //
+/////////////
+struct JobType;
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: JobDequeClass
+////////////////////////////////////////////////////////////////////////////////
+/*The JobDequeClass is the Chase-Lev work stealing deque every thread of the JobSystemClass has. Only the thread it
+belongs to pushes and pops, at the bottom, so it works on the job it spawned last while that is still in its cache.
+The other threads steal from the top, the oldest job, which is usually the biggest piece of a split up range. Push and
+Pop don't take a lock and only compete with a thief for the very last job, Steal is a single compare and swap.
+
+This is the version with a fixed size array from "Correct and Efficient Work-Stealing for Weak Memory Models" (Le,
+Pop, Cohen and Zappa Nardelli, 2013), with the indices 64 bits wide so they never wrap.*/
+class JobDequeClass
+{
+public:
+	JobDequeClass();
+	JobDequeClass(const JobDequeClass&);
+	~JobDequeClass();
+
+	bool Push(JobType*);
+	JobType* Pop();
+	JobType* Steal();
+
+private:
+	atomic<long long> m_top;
+	atomic<long long> m_bottom;
+	atomic<JobType*> m_jobs[JOB_DEQUE_SIZE];
+};
+
+#endif
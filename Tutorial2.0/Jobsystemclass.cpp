@@ -0,0 +1,589 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: jobsystemclass.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "jobsystemclass.h"
+#include "profilerclass.h"
+#include <stdio.h>
+
+
+/////////////
+// GLOBALS //
+/////////////
+/*Which job system the current thread belongs to and its index in it, 0 for the main thread. Other threads have -1.*/
+static thread_local JobSystemClass* t_jobSystem = 0;
+static thread_local int t_jobThread = -1;
+
+
+JobSystemClass::JobSystemClass()
+{
+	m_quit = false;
+	m_queuedJobs = 0;
+	m_sleepingThreads = 0;
+}
+
+JobSystemClass::JobSystemClass(const JobSystemClass& other)
+{
+}
+
+JobSystemClass::~JobSystemClass()
+{
+}
+
+/*Initialize makes the calling thread the main thread and starts threadCount threads next to it. With zero threads every
+job runs on the main thread while it waits.*/
+bool JobSystemClass::Initialize(int threadCount)
+{
+	PROFILE_FUNCTION();
+
+	JobThreadType* threadData;
+	int i;
+
+	m_quit = false;
+	m_queuedJobs = 0;
+	m_sleepingThreads = 0;
+
+	for (i = 0; i < threadCount + 1; i++)
+	{
+		threadData = new JobThreadType;
+		if (!threadData)
+		{
+			return false;
+		}
+		m_threadData.push_back(threadData);
+
+		threadData->jobs = new JobType[JOB_POOL_SIZE]();
+		if (!threadData->jobs)
+		{
+			return false;
+		}
+		threadData->nextJob = 0;
+		threadData->random = 2891336453u * (i + 1);
+		threadData->jobCount = 0;
+		threadData->stealCount = 0;
+	}
+
+	t_jobSystem = this;
+	t_jobThread = 0;
+
+	for (i = 1; i < threadCount + 1; i++)
+	{
+		m_threads.push_back(thread(&JobSystemClass::WorkerLoop, this, i));
+	}
+
+	return true;
+}
+
+/*Shutdown wakes the threads up to tell them to quit and waits for them. The jobs that are still queued are not run, so
+wait for them first.*/
+void JobSystemClass::Shutdown()
+{
+	size_t i;
+
+	{
+		lock_guard<mutex> lock(m_mutex);
+		m_quit = true;
+	}
+	m_wake.notify_all();
+
+	for (i = 0; i < m_threads.size(); i++)
+	{
+		m_threads[i].join();
+	}
+	m_threads.clear();
+
+	for (i = 0; i < m_threadData.size(); i++)
+	{
+		delete[] m_threadData[i]->jobs;
+		delete m_threadData[i];
+	}
+	m_threadData.clear();
+
+	m_mainThreadJobs.clear();
+
+	if (t_jobSystem == this)
+	{
+		t_jobSystem = 0;
+		t_jobThread = -1;
+	}
+
+	return;
+}
+
+/*CreateJob makes a job that calls function with data once it is submitted. When parent isn't 0 the job is one of its
+children and the parent isn't finished before this job is, the parent must not be finished yet, so create children
+while the parent runs or before it is submitted. It returns 0 on a thread that isn't part of the job system.*/
+JobType* JobSystemClass::CreateJob(JobFunctionType function, void* data, JobType* parent)
+{
+	JobType* job;
+	int index;
+
+	index = GetThreadIndex();
+	if (index < 0)
+	{
+		return 0;
+	}
+
+	job = AllocateJob(index);
+	job->function = function;
+	job->data = data;
+	job->parent = parent;
+	if (parent)
+	{
+		parent->unfinished.fetch_add(1, memory_order_relaxed);
+	}
+
+	return job;
+}
+
+/*CreateMainThreadJob makes a job that only ever runs on the main thread.*/
+JobType* JobSystemClass::CreateMainThreadJob(JobFunctionType function, void* data)
+{
+	JobType* job;
+
+	job = CreateJob(function, data, 0);
+	if (job)
+	{
+		job->mainThread = true;
+	}
+
+	return job;
+}
+
+/*CreateParallelFor makes a job that calls function on ranges of at most batchSize of the count items, spread over all
+threads. It is finished when every range is.*/
+JobType* JobSystemClass::CreateParallelFor(int count, int batchSize, JobRangeFunctionType function, void* data, JobType* parent)
+{
+	JobType* job;
+
+	job = CreateJob(0, data, parent);
+	if (job)
+	{
+		job->rangeFunction = function;
+		job->begin = 0;
+		job->end = count > 0 ? count : 0;
+		job->batchSize = batchSize > 0 ? batchSize : 1;
+	}
+
+	return job;
+}
+
+/*AddDependency makes job wait for prerequisite. Neither of them may be submitted yet. It fails when prerequisite
+already has JOB_MAX_CONTINUATIONS jobs waiting for it.*/
+bool JobSystemClass::AddDependency(JobType* job, JobType* prerequisite)
+{
+	if (prerequisite->continuationCount == JOB_MAX_CONTINUATIONS)
+	{
+		return false;
+	}
+
+	prerequisite->continuations[prerequisite->continuationCount] = job;
+	prerequisite->continuationCount++;
+	job->dependencies.fetch_add(1, memory_order_relaxed);
+
+	return true;
+}
+
+/*Submit hands the job over. It is scheduled right away, or once the last job it depends on finishes.*/
+void JobSystemClass::Submit(JobType* job)
+{
+	if (job->dependencies.fetch_sub(1, memory_order_acq_rel) == 1)
+	{
+		Schedule(job, GetThreadIndex());
+	}
+
+	return;
+}
+
+/*Wait returns once the job and all its children are finished. The thread doesn't sit idle meanwhile, it runs other
+jobs, and on the main thread the main thread jobs too.*/
+void JobSystemClass::Wait(JobType* job)
+{
+	JobType* next;
+	int index;
+
+	index = GetThreadIndex();
+
+	while (job->unfinished.load(memory_order_acquire) > 0)
+	{
+		if (index == 0 && RunMainThreadJobs() > 0)
+		{
+			continue;
+		}
+
+		next = index >= 0 ? FindJob(index) : 0;
+		if (next)
+		{
+			Execute(next, index);
+		}
+		else
+		{
+			this_thread::yield();
+		}
+	}
+
+	return;
+}
+
+bool JobSystemClass::IsFinished(JobType* job)
+{
+	return job->unfinished.load(memory_order_acquire) == 0;
+}
+
+/*ParallelFor runs function on ranges of the count items on all threads and returns when they are done. Call it from
+the main thread or from a job.*/
+void JobSystemClass::ParallelFor(int count, int batchSize, JobRangeFunctionType function, void* data)
+{
+	JobType* job;
+
+	if (count <= 0)
+	{
+		return;
+	}
+
+	job = CreateParallelFor(count, batchSize, function, data, 0);
+	if (!job)
+	{
+		function(data, 0, count);
+		return;
+	}
+
+	Submit(job);
+	Wait(job);
+
+	return;
+}
+
+/*RunMainThreadJobs runs the main thread jobs that are ready and returns how many there were. Call it from the main
+thread once a frame, Wait calls it as well. Jobs the ones it runs make ready are left for the next call. The jobs are
+taken out of the queue first since one of them may wait, and so come back in here.*/
+int JobSystemClass::RunMainThreadJobs()
+{
+	vector<JobType*> jobs;
+	size_t i;
+
+	if (GetThreadIndex() != 0)
+	{
+		return 0;
+	}
+
+	{
+		lock_guard<mutex> lock(m_mainThreadMutex);
+		if (m_mainThreadJobs.empty())
+		{
+			return 0;
+		}
+		jobs.swap(m_mainThreadJobs);
+	}
+
+	for (i = 0; i < jobs.size(); i++)
+	{
+		Execute(jobs[i], 0);
+	}
+
+	return (int)jobs.size();
+}
+
+/*GetThreadCount is the number of threads that run jobs besides the main thread.*/
+int JobSystemClass::GetThreadCount()
+{
+	return (int)m_threads.size();
+}
+
+/*GetStatistics returns what thread index did since the last ResetStatistics, index 0 is the main thread.*/
+void JobSystemClass::GetStatistics(int index, JobStatisticsType& statistics)
+{
+	statistics.jobs = m_threadData[index]->jobCount.load(memory_order_relaxed);
+	statistics.steals = m_threadData[index]->stealCount.load(memory_order_relaxed);
+
+	return;
+}
+
+void JobSystemClass::ResetStatistics()
+{
+	size_t i;
+
+	for (i = 0; i < m_threadData.size(); i++)
+	{
+		m_threadData[i]->jobCount = 0;
+		m_threadData[i]->stealCount = 0;
+	}
+
+	return;
+}
+
+/*WorkerLoop runs jobs until there are none to find, then sleeps until one is scheduled.*/
+void JobSystemClass::WorkerLoop(int index)
+{
+	JobType* job;
+	char name[32];
+	int idle;
+
+	snprintf(name, sizeof(name), "Job %d", index);
+	PROFILE_THREAD_NAME(name);
+
+	t_jobSystem = this;
+	t_jobThread = index;
+
+	idle = 0;
+
+	while (!m_quit.load(memory_order_relaxed))
+	{
+		job = FindJob(index);
+		if (job)
+		{
+			Execute(job, index);
+			idle = 0;
+			continue;
+		}
+
+		idle++;
+		if (idle < JOB_SPIN_COUNT)
+		{
+			this_thread::yield();
+			continue;
+		}
+
+		// Schedule counts the job before it looks for sleepers and we count ourselves before we look at the jobs,
+		// so one of the two always sees the other.
+		{
+			unique_lock<mutex> lock(m_mutex);
+			m_sleepingThreads++;
+			while (!m_quit && m_queuedJobs.load() <= 0)
+			{
+				m_wake.wait(lock);
+			}
+			m_sleepingThreads--;
+		}
+		idle = 0;
+	}
+
+	return;
+}
+
+int JobSystemClass::GetThreadIndex()
+{
+	return t_jobSystem == this ? t_jobThread : -1;
+}
+
+/*AllocateJob hands out the next finished job of the thread's ring, skipping a few that are still running or waiting to
+be submitted. When those aren't finished either the ring is full of queued jobs, and the thread runs the oldest job of
+its own deque, which is usually the one the ring comes around to next, or else any job it can find.*/
+JobType* JobSystemClass::AllocateJob(int index)
+{
+	JobThreadType* threadData;
+	JobType* job;
+	JobType* next;
+	int i;
+
+	threadData = m_threadData[index];
+
+	job = 0;
+	while (!job)
+	{
+		for (i = 0; i < JOB_ALLOCATE_TRIES; i++)
+		{
+			job = &threadData->jobs[threadData->nextJob & (JOB_POOL_SIZE - 1)];
+			threadData->nextJob++;
+
+			if (job->unfinished.load(memory_order_acquire) == 0)
+			{
+				break;
+			}
+			job = 0;
+		}
+
+		if (!job)
+		{
+			next = threadData->deque.Steal();
+			if (next)
+			{
+				m_queuedJobs.fetch_sub(1);
+			}
+			else
+			{
+				next = FindJob(index);
+			}
+
+			if (next)
+			{
+				Execute(next, index);
+			}
+			else
+			{
+				this_thread::yield();
+			}
+		}
+	}
+
+	job->function = 0;
+	job->rangeFunction = 0;
+	job->data = 0;
+	job->begin = 0;
+	job->end = 0;
+	job->batchSize = 0;
+	job->mainThread = false;
+	job->parent = 0;
+	job->unfinished.store(1, memory_order_relaxed);
+	job->dependencies.store(1, memory_order_relaxed);
+	job->continuationCount = 0;
+
+	return job;
+}
+
+/*Schedule puts a job that is ready in the deque of the thread, or in the main thread queue, and wakes a sleeping thread
+up. When the deque is full the thread runs the job itself.*/
+void JobSystemClass::Schedule(JobType* job, int index)
+{
+	if (job->mainThread)
+	{
+		lock_guard<mutex> lock(m_mainThreadMutex);
+		m_mainThreadJobs.push_back(job);
+		return;
+	}
+
+	if (index < 0 || !m_threadData[index]->deque.Push(job))
+	{
+		Execute(job, index);
+		return;
+	}
+
+	m_queuedJobs.fetch_add(1);
+	if (m_sleepingThreads.load() > 0)
+	{
+		lock_guard<mutex> lock(m_mutex);
+		m_wake.notify_one();
+	}
+
+	return;
+}
+
+/*FindJob pops the newest job of the thread's own deque, or else steals the oldest job of another thread, starting at
+a random one so the thieves spread out.*/
+JobType* JobSystemClass::FindJob(int index)
+{
+	JobThreadType* threadData;
+	JobType* job;
+	int count, start, i, victim;
+
+	threadData = m_threadData[index];
+
+	job = threadData->deque.Pop();
+	if (job)
+	{
+		m_queuedJobs.fetch_sub(1);
+		return job;
+	}
+
+	count = (int)m_threadData.size();
+	if (count < 2)
+	{
+		return 0;
+	}
+
+	threadData->random = threadData->random * 1664525 + 1013904223;
+	start = (int)((threadData->random >> 8) % (unsigned int)count);
+
+	for (i = 0; i < count; i++)
+	{
+		victim = (start + i) % count;
+		if (victim == index)
+		{
+			continue;
+		}
+
+		job = m_threadData[victim]->deque.Steal();
+		if (job)
+		{
+			m_queuedJobs.fetch_sub(1);
+			threadData->stealCount.fetch_add(1, memory_order_relaxed);
+			return job;
+		}
+	}
+
+	return 0;
+}
+
+/*Execute runs a job. A parallel for job first splits off the second half of its range as a child job, again and again,
+until what is left is no bigger than a batch, and runs that part itself.*/
+void JobSystemClass::Execute(JobType* job, int index)
+{
+	JobType* child;
+	int begin, end, middle;
+
+	if (job->rangeFunction)
+	{
+		begin = job->begin;
+		end = job->end;
+
+		while (end - begin > job->batchSize)
+		{
+			middle = begin + (end - begin) / 2;
+
+			child = CreateParallelFor(0, job->batchSize, job->rangeFunction, job->data, job);
+			if (!child)
+			{
+				break;
+			}
+			child->begin = middle;
+			child->end = end;
+			Submit(child);
+
+			end = middle;
+		}
+
+		if (end > begin)
+		{
+			job->rangeFunction(job->data, begin, end);
+		}
+	}
+	else if (job->function)
+	{
+		job->function(job->data);
+	}
+
+	if (index >= 0)
+	{
+		m_threadData[index]->jobCount.fetch_add(1, memory_order_relaxed);
+	}
+
+	Finish(job, index);
+
+	return;
+}
+
+/*Finish counts a job, or one of its children, as done. The job that brings the count to zero schedules the jobs waiting
+for it and finishes its parent. Everything needed is read before the count goes down, once it is zero the job may be
+handed out again.*/
+void JobSystemClass::Finish(JobType* job, int index)
+{
+	JobType* continuations[JOB_MAX_CONTINUATIONS];
+	JobType* parent;
+	int count, i;
+
+	parent = job->parent;
+	count = job->continuationCount;
+	for (i = 0; i < count; i++)
+	{
+		continuations[i] = job->continuations[i];
+	}
+
+	if (job->unfinished.fetch_sub(1, memory_order_acq_rel) != 1)
+	{
+		return;
+	}
+
+	for (i = 0; i < count; i++)
+	{
+		if (continuations[i]->dependencies.fetch_sub(1, memory_order_acq_rel) == 1)
+		{
+			Schedule(continuations[i], index);
+		}
+	}
+
+	if (parent)
+	{
+		Finish(parent, index);
+	}
+
+	return;
+}
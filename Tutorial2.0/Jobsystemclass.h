@@ -0,0 +1,145 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: jobsystemclass.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _JOBSYSTEMCLASS_H_
+#define _JOBSYSTEMCLASS_H_
+
+
+//////////////
+// INCLUDES //
+//////////////
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "jobdequeclass.h"
+using namespace std;
+
+
+/////////////
+// GLOBALS //
+/////////////
+/*How many jobs every thread can have handed out at once, a job is used again once it has finished. A job pointer stays
+good until the thread that created it created this many jobs after it. It has to be a power of two.*/
+const int JOB_POOL_SIZE = 4096;
+/*How many jobs of the ring AllocateJob looks at before it runs a job to free one.*/
+const int JOB_ALLOCATE_TRIES = 64;
+/*How many jobs can wait for the same job with AddDependency.*/
+const int JOB_MAX_CONTINUATIONS = 8;
+/*How many times an idle thread looks for work before it goes to sleep.*/
+const int JOB_SPIN_COUNT = 64;
+
+
+/////////////
+// TYPEDEFS //
+/////////////
+/*A job calls its function with its data pointer. The jobs of a parallel for call their range function with the data
+pointer and the range [begin, end) to do.*/
+typedef void (*JobFunctionType)(void*);
+typedef void (*JobRangeFunctionType)(void*, int, int);
+
+/*unfinished counts the job itself and its children that are still running, the job is finished when it reaches zero.
+dependencies counts the jobs it waits for that haven't finished yet, plus one until it is submitted; the job is
+scheduled when it reaches zero. The continuations are the jobs that wait for this one.*/
+struct JobType
+{
+	JobFunctionType function;
+	JobRangeFunctionType rangeFunction;
+	void* data;
+	int begin, end, batchSize;
+	bool mainThread;
+	JobType* parent;
+	atomic<int> unfinished;
+	atomic<int> dependencies;
+	JobType* continuations[JOB_MAX_CONTINUATIONS];
+	int continuationCount;
+};
+
+/*How many jobs a thread ran and how many of those it stole from another thread.*/
+struct JobStatisticsType
+{
+	int jobs;
+	int steals;
+};
+
+/*Everything one thread of the job system owns: its deque, its ring of jobs and its statistics. Only the statistics
+are read by other threads.*/
+struct JobThreadType
+{
+	JobDequeClass deque;
+	JobType* jobs;
+	unsigned int nextJob;
+	unsigned int random;
+	atomic<int> jobCount;
+	atomic<int> stealCount;
+};
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: JobSystemClass
+////////////////////////////////////////////////////////////////////////////////
+/*The JobSystemClass runs jobs on a few threads plus the main thread, the one that called Initialize. Jobs can spawn
+jobs, wait for other jobs and be waited for, so a frame can be written as a graph of tasks that keeps every core busy.
+ParallelFor covers the simple case of splitting independent work in ranges, like compressing a texture.
+
+Every thread has a JobDequeClass. A new job goes into the deque of the thread that created it, which takes its own jobs
+back newest first; a thread that runs out steals the oldest job of another thread, picked at random. A parallel for is
+one job that splits its range in halves, pushing the second half as a child and going on with the first until it is
+down to the batch size, so a thief takes a big half and splits that further on its own thread. The work spreads by
+itself even when some items take far longer than others.
+
+A job can have children, created with it as their parent while it runs, and is only finished when they are. A job can
+also wait for up to JOB_MAX_CONTINUATIONS other jobs with AddDependency, before either of them is submitted, and is
+only scheduled once they are all finished. Jobs created with CreateMainThreadJob only run on the main thread, from
+RunMainThreadJobs or while it waits, for whatever has to happen on the window thread.
+
+Jobs are created, submitted and waited for on the main thread and inside other jobs, not on threads of their own. Every
+job that is created must be submitted, and the jobs don't allocate: each thread hands them out from a ring of
+JOB_POOL_SIZE, see the global. Idle threads spin a little and then sleep until a job is scheduled.*/
+class JobSystemClass
+{
+public:
+	JobSystemClass();
+	JobSystemClass(const JobSystemClass&);
+	~JobSystemClass();
+
+	bool Initialize(int);
+	void Shutdown();
+
+	JobType* CreateJob(JobFunctionType, void*, JobType*);
+	JobType* CreateMainThreadJob(JobFunctionType, void*);
+	JobType* CreateParallelFor(int, int, JobRangeFunctionType, void*, JobType*);
+	bool AddDependency(JobType*, JobType*);
+	void Submit(JobType*);
+	void Wait(JobType*);
+	bool IsFinished(JobType*);
+	void ParallelFor(int, int, JobRangeFunctionType, void*);
+
+	int RunMainThreadJobs();
+	int GetThreadCount();
+	void GetStatistics(int, JobStatisticsType&);
+	void ResetStatistics();
+
+private:
+	void WorkerLoop(int);
+	int GetThreadIndex();
+	JobType* AllocateJob(int);
+	void Schedule(JobType*, int);
+	JobType* FindJob(int);
+	void Execute(JobType*, int);
+	void Finish(JobType*, int);
+
+private:
+	vector<JobThreadType*> m_threadData;
+	vector<thread> m_threads;
+	mutex m_mutex;
+	condition_variable m_wake;
+	atomic<bool> m_quit;
+	atomic<int> m_queuedJobs;
+	atomic<int> m_sleepingThreads;
+	mutex m_mainThreadMutex;
+	vector<JobType*> m_mainThreadJobs;
+};
+
+#endif
@@ -0,0 +1,161 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: mappedfileclass.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "mappedfileclass.h"
+#include "profilerclass.h"
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFileClass::MappedFileClass()
+{
+	m_data = 0;
+	m_size = 0;
+#ifdef _WIN32
+	m_file = INVALID_HANDLE_VALUE;
+	m_mapping = 0;
+#else
+	m_file = -1;
+#endif
+}
+
+MappedFileClass::MappedFileClass(const MappedFileClass& other)
+{
+}
+
+/*The destructor closes the file as well, so a loader can simply return early on an error.*/
+MappedFileClass::~MappedFileClass()
+{
+	Close();
+}
+
+/*Open maps the file. An empty file can't be mapped, it fails like a missing one.*/
+bool MappedFileClass::Open(const char* filename)
+{
+	PROFILE_FUNCTION();
+
+#ifdef _WIN32
+	LARGE_INTEGER fileSize;
+#else
+	struct stat fileStatus;
+	void* data;
+#endif
+
+	// Close whatever file was open before.
+	Close();
+
+#ifdef _WIN32
+	m_file = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if (m_file == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+
+	if (!GetFileSizeEx(m_file, &fileSize) || fileSize.QuadPart == 0)
+	{
+		Close();
+		return false;
+	}
+
+	m_mapping = CreateFileMappingA(m_file, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (!m_mapping)
+	{
+		Close();
+		return false;
+	}
+
+	m_data = MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0);
+	if (!m_data)
+	{
+		Close();
+		return false;
+	}
+
+	m_size = (size_t)fileSize.QuadPart;
+#else
+	m_file = open(filename, O_RDONLY);
+	if (m_file < 0)
+	{
+		return false;
+	}
+
+	if (fstat(m_file, &fileStatus) != 0 || fileStatus.st_size == 0)
+	{
+		Close();
+		return false;
+	}
+
+	data = mmap(NULL, (size_t)fileStatus.st_size, PROT_READ, MAP_PRIVATE, m_file, 0);
+	if (data == MAP_FAILED)
+	{
+		Close();
+		return false;
+	}
+
+	// The loaders read the file front to back, let the kernel read ahead.
+	madvise(data, (size_t)fileStatus.st_size, MADV_SEQUENTIAL);
+
+	m_data = data;
+	m_size = (size_t)fileStatus.st_size;
+#endif
+
+	return true;
+}
+
+void MappedFileClass::Close()
+{
+#ifdef _WIN32
+	// Unmap the view.
+	if (m_data)
+	{
+		UnmapViewOfFile(m_data);
+		m_data = 0;
+	}
+
+	// Release the mapping and the file.
+	if (m_mapping)
+	{
+		CloseHandle(m_mapping);
+		m_mapping = 0;
+	}
+
+	if (m_file != INVALID_HANDLE_VALUE)
+	{
+		CloseHandle(m_file);
+		m_file = INVALID_HANDLE_VALUE;
+	}
+#else
+	// Unmap the file.
+	if (m_data)
+	{
+		munmap((void*)m_data, m_size);
+		m_data = 0;
+	}
+
+	// Close the file.
+	if (m_file >= 0)
+	{
+		close(m_file);
+		m_file = -1;
+	}
+#endif
+
+	m_size = 0;
+
+	return;
+}
+
+const void* MappedFileClass::GetData()
+{
+	return m_data;
+}
+
+size_t MappedFileClass::GetSize()
+{
+	return m_size;
+}
@@ -0,0 +1,44 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: mappedfileclass.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _MAPPEDFILECLASS_H_
+#define _MAPPEDFILECLASS_H_
+
+
+//////////////
+// INCLUDES //
+//////////////
+#include <stddef.h>
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: MappedFileClass
+////////////////////////////////////////////////////////////////////////////////
+/*The MappedFileClass maps a whole file read only into memory. Nothing is read when the file is opened, the operating
+system pages the contents in the first time they are touched, so a loader can hand the mapped bytes straight to
+whoever needs them without copying them into its own arrays first. The data stays valid until Close.*/
+class MappedFileClass
+{
+public:
+	MappedFileClass();
+	MappedFileClass(const MappedFileClass&);
+	~MappedFileClass();
+
+	bool Open(const char*);
+	void Close();
+
+	const void* GetData();
+	size_t GetSize();
+
+private:
+	const void* m_data;
+	size_t m_size;
+#ifdef _WIN32
+	void* m_file;
+	void* m_mapping;
+#else
+	int m_file;
+#endif
+};
+
+#endif
@@ -0,0 +1,839 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: meshfileclass.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "meshfileclass.h"
+#include "meshoptimizerclass.h"
+#include "meshsimplifierclass.h"
+#include "profilerclass.h"
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+
+/////////////
+// GLOBALS //
+/////////////
+static const char MESH_FILE_MAGIC[4] = { 'M', 'E', 'S', 'H' };
+static const unsigned long long MESH_STREAM_ALIGNMENT = 16;
+static const double POWERS_OF_TEN[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17,
+	1e18, 1e19, 1e20, 1e21, 1e22 };
+
+
+///////////////////////
+// FUNCTION PROTOTYPES //
+///////////////////////
+static const char* SkipSpaces(const char*, const char*);
+static const char* SkipLine(const char*, const char*);
+static bool ParseFloat(const char*&, const char*, float&);
+static bool ParseInteger(const char*&, const char*, int&);
+static unsigned long long AlignOffset(unsigned long long);
+
+
+MeshFileClass::MeshFileClass()
+{
+	m_header = 0;
+}
+
+MeshFileClass::MeshFileClass(const MeshFileClass& other)
+{
+}
+
+MeshFileClass::~MeshFileClass()
+{
+}
+
+/*Open opens a .mesh file, or an .obj file through its .mesh cache which is imported first when it is missing or
+older than the .obj. A mesh file in another vertex format fails to open, unless it is a cache that can be imported again.
+When the import fails errors tells why.*/
+bool MeshFileClass::Open(const char* filename, const VertexFormatType& format, string& errors)
+{
+	PROFILE_FUNCTION();
+
+	string cacheFile;
+	size_t length;
+	bool result;
+
+	Close();
+
+	// Anything that isn't an .obj file must be a mesh file already.
+	length = strlen(filename);
+	if (length < 4 || (strcmp(filename + length - 4, ".obj") != 0 && strcmp(filename + length - 4, ".OBJ") != 0))
+	{
+		return OpenMesh(filename, format);
+	}
+
+	// Use the cache when it is up to date, a cache from an older version or format fails to open and gets imported again.
+	cacheFile = GetCacheFileName(filename);
+	if (IsCacheCurrent(filename, cacheFile.c_str()))
+	{
+		result = OpenMesh(cacheFile.c_str(), format);
+		if (result)
+		{
+			return true;
+		}
+	}
+
+	result = ImportObj(filename, cacheFile.c_str(), format, errors);
+	if (!result)
+	{
+		return false;
+	}
+
+	return OpenMesh(cacheFile.c_str(), format);
+}
+
+void MeshFileClass::Close()
+{
+	m_file.Close();
+	m_header = 0;
+
+	return;
+}
+
+int MeshFileClass::GetVertexCount()
+{
+	return m_header ? (int)m_header->vertexCount : 0;
+}
+
+int MeshFileClass::GetIndexCount()
+{
+	return m_header ? (int)m_header->indexCount : 0;
+}
+
+int MeshFileClass::GetVertexStride()
+{
+	return m_header ? (int)m_header->vertexStride : 0;
+}
+
+/*GetVertices and GetIndices point into the mapped file, they are only valid until Close.*/
+const void* MeshFileClass::GetVertices()
+{
+	return (const char*)m_file.GetData() + m_header->vertexOffset;
+}
+
+const void* MeshFileClass::GetIndices()
+{
+	return (const char*)m_file.GetData() + m_header->indexOffset;
+}
+
+/*GetIndexCount counts the indices of all levels of detail, the size of the index stream. GetLod returns where the
+indices of one level are in it.*/
+int MeshFileClass::GetLodCount()
+{
+	return m_header ? (int)m_header->lodCount : 0;
+}
+
+MeshLodType MeshFileClass::GetLod(int lod)
+{
+	return m_header->lods[lod];
+}
+
+/*GetIndexSize returns 2 for 16 bit and 4 for 32 bit indices.*/
+int MeshFileClass::GetIndexSize()
+{
+	return m_header ? (int)m_header->indexSize : 0;
+}
+
+void MeshFileClass::GetBounds(XMFLOAT3& center, XMFLOAT3& extents, float& radius)
+{
+	center = m_header->boundsCenter;
+	extents = m_header->boundsExtents;
+	radius = m_header->boundsRadius;
+
+	return;
+}
+
+/*ImportObj turns an OBJ file into an optimized mesh file with its levels of detail. When it fails errors tells which
+file could not be read or written.*/
+bool MeshFileClass::ImportObj(const char* objFile, const char* meshFile, const VertexFormatType& format, string& errors)
+{
+	PROFILE_FUNCTION();
+
+	vector<MeshVertexType> vertices;
+	vector<unsigned int> indices, lodIndices;
+	vector<MeshLodType> lods;
+	bool result;
+
+	result = ParseObj(objFile, vertices, indices);
+	if (!result)
+	{
+		errors = string("Could not import ") + objFile + "\n";
+		return false;
+	}
+
+	// Reorder the triangles for the vertex cache first, the levels of detail are simplified from that order and
+	// reordered on their own. The vertex order follows from the triangle order of the full mesh, which uses all of them.
+	MeshOptimizerClass::OptimizeVertexCache(indices, (int)vertices.size());
+	MeshSimplifierClass::GenerateLods(vertices, indices, lodIndices, lods);
+	MeshOptimizerClass::OptimizeVertexFetch(vertices, lodIndices);
+
+	result = WriteMesh(meshFile, format, vertices, lodIndices, lods);
+	if (!result)
+	{
+		errors = string("Could not write ") + meshFile + "\n";
+		return false;
+	}
+
+	return true;
+}
+
+/*ParseObj reads the vertices and triangles of an OBJ file. The file is mapped and parsed in place, the numbers are
+read with our own little parsers since strtod needs a terminated string and is slow on files with millions of them.
+
+OBJ faces pick a position and a normal for every corner separately, our vertices are one position with one normal.
+Files without normals map every position to one vertex, otherwise every pair of position and normal the faces use
+becomes a vertex. When some corner has no normal the normals of the whole mesh are worked out from its triangles
+instead. Texture coordinates are skipped, the vertex has no room for them yet.*/
+bool MeshFileClass::ParseObj(const char* filename, vector<MeshVertexType>& vertices, vector<unsigned int>& indices)
+{
+	PROFILE_FUNCTION();
+
+	MappedFileClass file;
+	MeshVertexType vertex;
+	vector<MeshVertexType> points;
+	vector<XMFLOAT3> normals;
+	vector<int> face, faceNormals, cornerNormals;
+	unordered_map<unsigned long long, unsigned int> cornerVertices;
+	unordered_map<unsigned long long, unsigned int>::iterator found;
+	XMFLOAT3 normal;
+	const char* position;
+	const char* end;
+	const char* next;
+	float extras[4];
+	unsigned long long key;
+	int index, normalIndex, i, pointCount, normalCount, extraCount;
+	bool result, missingNormals;
+
+	vertices.clear();
+	indices.clear();
+
+	result = file.Open(filename);
+	if (!result)
+	{
+		return false;
+	}
+
+	position = (const char*)file.GetData();
+	end = position + file.GetSize();
+
+	// A rough guess of the sizes, the vertex lines of a typical file are about 30 bytes long and faces twice as many.
+	points.reserve(file.GetSize() / 90);
+	indices.reserve(file.GetSize() / 15);
+
+	missingNormals = false;
+	while (position < end)
+	{
+		position = SkipSpaces(position, end);
+		if (position + 2 >= end)
+		{
+			break;
+		}
+
+		if (position[0] == 'v' && (position[1] == ' ' || position[1] == '\t'))
+		{
+			// A position, optionally followed by a color.
+			position += 2;
+			if (!ParseFloat(position, end, vertex.position.x) || !ParseFloat(position, end, vertex.position.y) ||
+				!ParseFloat(position, end, vertex.position.z))
+			{
+				return false;
+			}
+			vertex.position.z = -vertex.position.z;
+
+			// Three more numbers are a color, a single one is the rarely used w which we don't need.
+			extraCount = 0;
+			while (extraCount < 4)
+			{
+				next = SkipSpaces(position, end);
+				if (next >= end || *next == '\n' || *next == '\r' || *next == '#')
+				{
+					break;
+				}
+
+				if (!ParseFloat(position, end, extras[extraCount]))
+				{
+					return false;
+				}
+				extraCount++;
+			}
+
+			vertex.color = XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f);
+			if (extraCount == 3)
+			{
+				vertex.color = XMFLOAT4(extras[0], extras[1], extras[2], 1.0f);
+			}
+			vertex.normal = XMFLOAT3(0.0f, 0.0f, 0.0f);
+
+			points.push_back(vertex);
+		}
+		else if (position[0] == 'v' && position[1] == 'n' && (position[2] == ' ' || position[2] == '\t'))
+		{
+			// A normal, flipped along z like the positions.
+			position += 3;
+			if (!ParseFloat(position, end, normal.x) || !ParseFloat(position, end, normal.y) || !ParseFloat(position, end, normal.z))
+			{
+				return false;
+			}
+			normal.z = -normal.z;
+
+			normals.push_back(normal);
+		}
+		else if (position[0] == 'f' && (position[1] == ' ' || position[1] == '\t'))
+		{
+			// A polygon of position/texture/normal indices per corner, the last two may be left out.
+			position += 2;
+			face.clear();
+			faceNormals.clear();
+			pointCount = (int)points.size();
+			normalCount = (int)normals.size();
+			while (true)
+			{
+				position = SkipSpaces(position, end);
+				if (position >= end || *position == '\n' || *position == '\r' || *position == '#')
+				{
+					break;
+				}
+
+				if (!ParseInteger(position, end, index) || index == 0)
+				{
+					return false;
+				}
+
+				// Skip the texture index and read the normal index if there is one.
+				normalIndex = 0;
+				if (position < end && *position == '/')
+				{
+					position++;
+					while (position < end && *position != '/' && *position != ' ' && *position != '\t' && *position != '\n' && *position != '\r')
+					{
+						position++;
+					}
+
+					if (position < end && *position == '/')
+					{
+						position++;
+						if (!ParseInteger(position, end, normalIndex) || normalIndex == 0)
+						{
+							return false;
+						}
+					}
+				}
+
+				// Negative indices count back from the last position or normal read so far.
+				index = index > 0 ? index - 1 : pointCount + index;
+				normalIndex = normalIndex > 0 ? normalIndex - 1 : (normalIndex < 0 ? normalCount + normalIndex : -1);
+				if (index < 0 || normalIndex < -1)
+				{
+					return false;
+				}
+				face.push_back(index);
+				faceNormals.push_back(normalIndex);
+
+				if (normalIndex < 0)
+				{
+					missingNormals = true;
+				}
+
+				while (position < end && *position != ' ' && *position != '\t' && *position != '\n' && *position != '\r')
+				{
+					position++;
+				}
+			}
+
+			if (face.size() < 3)
+			{
+				return false;
+			}
+
+			// Split the polygon in a fan and flip every triangle to clockwise.
+			for (i = 1; i + 1 < (int)face.size(); i++)
+			{
+				indices.push_back((unsigned int)face[0]);
+				indices.push_back((unsigned int)face[i + 1]);
+				indices.push_back((unsigned int)face[i]);
+				cornerNormals.push_back(faceNormals[0]);
+				cornerNormals.push_back(faceNormals[i + 1]);
+				cornerNormals.push_back(faceNormals[i]);
+			}
+		}
+
+		position = SkipLine(position, end);
+	}
+
+	// Faces may name positions and normals that come later in the file, so the indices are only checked at the end.
+	for (i = 0; i < (int)indices.size(); i++)
+	{
+		if (indices[i] >= points.size() || cornerNormals[i] >= (int)normals.size())
+		{
+			return false;
+		}
+	}
+
+	if (points.empty() || indices.empty())
+	{
+		return false;
+	}
+
+	// Without normals in the file every position is a vertex and the normals come from the triangles.
+	if (normals.empty() || missingNormals)
+	{
+		vertices.swap(points);
+		GenerateNormals(vertices, indices);
+		return true;
+	}
+
+	// Otherwise every pair of position and normal is a vertex of its own.
+	vertices.reserve(points.size());
+	cornerVertices.reserve(points.size() * 2);
+	for (i = 0; i < (int)indices.size(); i++)
+	{
+		key = ((unsigned long long)indices[i] << 32) | (unsigned long long)(unsigned int)cornerNormals[i];
+		found = cornerVertices.find(key);
+		if (found == cornerVertices.end())
+		{
+			vertex = points[indices[i]];
+			vertex.normal = normals[cornerNormals[i]];
+			found = cornerVertices.insert(make_pair(key, (unsigned int)vertices.size())).first;
+			vertices.push_back(vertex);
+		}
+		indices[i] = found->second;
+	}
+
+	return true;
+}
+
+/*GenerateNormals gives every vertex the normalized sum of the normals of its triangles. The cross products are not
+normalized first, so large triangles count for more than small ones. Vertices without triangles face the camera.*/
+void MeshFileClass::GenerateNormals(vector<MeshVertexType>& vertices, const vector<unsigned int>& indices)
+{
+	const XMFLOAT3* a;
+	const XMFLOAT3* b;
+	const XMFLOAT3* c;
+	XMFLOAT3 ab, ac, normal;
+	XMFLOAT3* sum;
+	size_t i;
+	int corner;
+	float length;
+
+	for (i = 0; i < vertices.size(); i++)
+	{
+		vertices[i].normal = XMFLOAT3(0.0f, 0.0f, 0.0f);
+	}
+
+	for (i = 0; i + 2 < indices.size(); i += 3)
+	{
+		// Clockwise triangles in a left handed space face the side (b - a) x (c - a) points to.
+		a = &vertices[indices[i]].position;
+		b = &vertices[indices[i + 1]].position;
+		c = &vertices[indices[i + 2]].position;
+		ab = XMFLOAT3(b->x - a->x, b->y - a->y, b->z - a->z);
+		ac = XMFLOAT3(c->x - a->x, c->y - a->y, c->z - a->z);
+		normal = XMFLOAT3(ab.y * ac.z - ab.z * ac.y, ab.z * ac.x - ab.x * ac.z, ab.x * ac.y - ab.y * ac.x);
+
+		for (corner = 0; corner < 3; corner++)
+		{
+			sum = &vertices[indices[i + corner]].normal;
+			sum->x += normal.x;
+			sum->y += normal.y;
+			sum->z += normal.z;
+		}
+	}
+
+	for (i = 0; i < vertices.size(); i++)
+	{
+		sum = &vertices[i].normal;
+		length = sqrtf(sum->x * sum->x + sum->y * sum->y + sum->z * sum->z);
+		if (length > 0.0f)
+		{
+			*sum = XMFLOAT3(sum->x / length, sum->y / length, sum->z / length);
+		}
+		else
+		{
+			*sum = XMFLOAT3(0.0f, 0.0f, -1.0f);
+		}
+	}
+
+	return;
+}
+
+/*WriteMesh writes the vertices in the given format and the indices with their bounds as a mesh file, with 16 bit
+indices when they fit. The levels of detail say which ranges of the indices belong to which level, when there are none
+all indices are the one level.*/
+bool MeshFileClass::WriteMesh(const char* filename, const VertexFormatType& format, const vector<MeshVertexType>& vertices,
+	const vector<unsigned int>& indices, const vector<MeshLodType>& lods)
+{
+	PROFILE_FUNCTION();
+
+	MeshFileHeaderType header;
+	const char padding[MESH_STREAM_ALIGNMENT] = { 0 };
+	vector<unsigned char> packedVertices;
+	vector<unsigned short> shortIndices;
+	const void* indexData;
+	unsigned long long vertexBytes, indexBytes;
+	size_t written, i;
+	FILE* file;
+
+	if (vertices.empty() || indices.empty() || !VertexFormatClass::IsValid(format) || (int)lods.size() > MESH_MAX_LODS)
+	{
+		return false;
+	}
+
+	vertexBytes = (unsigned long long)VertexFormatClass::GetStride(format) * vertices.size();
+
+	// Narrow the indices when every vertex can be reached with 16 bits.
+	if ((int)vertices.size() < MESH_SHORT_INDEX_LIMIT)
+	{
+		shortIndices.resize(indices.size());
+		for (i = 0; i < indices.size(); i++)
+		{
+			shortIndices[i] = (unsigned short)indices[i];
+		}
+		indexData = &shortIndices[0];
+		indexBytes = (unsigned long long)sizeof(unsigned short) * indices.size();
+	}
+	else
+	{
+		indexData = &indices[0];
+		indexBytes = (unsigned long long)sizeof(unsigned int) * indices.size();
+	}
+
+	memcpy(header.magic, MESH_FILE_MAGIC, sizeof(header.magic));
+	header.version = MESH_FILE_VERSION;
+	header.vertexStride = (unsigned int)VertexFormatClass::GetStride(format);
+	header.indexSize = (unsigned int)(indexBytes / indices.size());
+	header.vertexCount = (unsigned int)vertices.size();
+	header.indexCount = (unsigned int)indices.size();
+	header.vertexFormat = VertexFormatClass::GetHash(format);
+	header.vertexOffset = AlignOffset(sizeof(header));
+	header.indexOffset = AlignOffset(header.vertexOffset + vertexBytes);
+	header.reserved = 0;
+
+	// Without levels of detail the whole index stream is the one level.
+	header.lodCount = lods.empty() ? 1 : (unsigned int)lods.size();
+	for (i = 0; i < (size_t)MESH_MAX_LODS; i++)
+	{
+		if (i < lods.size())
+		{
+			header.lods[i] = lods[i];
+		}
+		else
+		{
+			header.lods[i].firstIndex = 0;
+			header.lods[i].indexCount = (unsigned int)(i == 0 ? indices.size() : 0);
+			header.lods[i].error = 0.0f;
+			header.lods[i].reserved = 0;
+		}
+
+		if (header.lods[i].firstIndex + (unsigned long long)header.lods[i].indexCount > indices.size() || header.lods[i].indexCount % 3 != 0)
+		{
+			return false;
+		}
+	}
+	CalculateBounds(vertices, header);
+
+	// Pack the vertices, quantized positions need the bounds.
+	packedVertices.resize((size_t)vertexBytes);
+	VertexFormatClass::Encode(format, &vertices[0], (int)vertices.size(), header.boundsCenter, header.boundsExtents, &packedVertices[0]);
+
+	file = fopen(filename, "wb");
+	if (!file)
+	{
+		return false;
+	}
+
+	// Write the header and both streams with the padding in front of them.
+	written = fwrite(&header, sizeof(header), 1, file);
+	written += fwrite(padding, 1, (size_t)(header.vertexOffset - sizeof(header)), file) == (size_t)(header.vertexOffset - sizeof(header)) ? 1 : 0;
+	written += fwrite(&packedVertices[0], (size_t)vertexBytes, 1, file);
+	written += fwrite(padding, 1, (size_t)(header.indexOffset - header.vertexOffset - vertexBytes), file) ==
+		(size_t)(header.indexOffset - header.vertexOffset - vertexBytes) ? 1 : 0;
+	written += fwrite(indexData, (size_t)indexBytes, 1, file);
+
+	if (fclose(file) != 0 || written != 5)
+	{
+		// Don't leave half a file behind for the next run to trip over.
+		remove(filename);
+		return false;
+	}
+
+	return true;
+}
+
+/*GetCacheFileName swaps the extension of a file for .mesh.*/
+string MeshFileClass::GetCacheFileName(const char* filename)
+{
+	string name;
+	size_t dot, slash;
+
+	name = filename;
+	dot = name.find_last_of('.');
+	slash = name.find_last_of("/\\");
+	if (dot != string::npos && (slash == string::npos || dot > slash))
+	{
+		name.erase(dot);
+	}
+
+	return name + ".mesh";
+}
+
+/*OpenMesh maps a mesh file and checks that it is one of ours, of this version and vertex format, and that both streams
+and all levels of detail are inside it.*/
+bool MeshFileClass::OpenMesh(const char* filename, const VertexFormatType& format)
+{
+	const MeshFileHeaderType* header;
+	unsigned long long size;
+	unsigned int i;
+	bool result;
+
+	result = m_file.Open(filename);
+	if (!result)
+	{
+		return false;
+	}
+
+	size = m_file.GetSize();
+	header = (const MeshFileHeaderType*)m_file.GetData();
+	if (size < sizeof(MeshFileHeaderType) || memcmp(header->magic, MESH_FILE_MAGIC, sizeof(header->magic)) != 0 ||
+		header->version != MESH_FILE_VERSION || header->vertexFormat != VertexFormatClass::GetHash(format) ||
+		header->vertexStride != (unsigned int)VertexFormatClass::GetStride(format) || (header->indexSize != sizeof(unsigned short) && header->indexSize != sizeof(unsigned int)) ||
+		header->vertexCount == 0 || header->indexCount == 0 || header->vertexOffset % MESH_STREAM_ALIGNMENT != 0 ||
+		header->indexOffset % MESH_STREAM_ALIGNMENT != 0 ||
+		header->vertexOffset + (unsigned long long)header->vertexStride * header->vertexCount > size ||
+		header->indexOffset + (unsigned long long)header->indexSize * header->indexCount > size ||
+		header->lodCount == 0 || header->lodCount > (unsigned int)MESH_MAX_LODS)
+	{
+		m_file.Close();
+		return false;
+	}
+
+	for (i = 0; i < header->lodCount; i++)
+	{
+		if (header->lods[i].indexCount == 0 || header->lods[i].firstIndex + (unsigned long long)header->lods[i].indexCount > header->indexCount)
+		{
+			m_file.Close();
+			return false;
+		}
+	}
+
+	m_header = header;
+
+	return true;
+}
+
+/*IsCacheCurrent checks if the cache file is at least as new as the source file. A cache without its source is used
+as it is, so a game can ship with only the mesh files.*/
+bool MeshFileClass::IsCacheCurrent(const char* sourceFile, const char* cacheFile)
+{
+	struct stat sourceStatus, cacheStatus;
+
+	if (stat(cacheFile, &cacheStatus) != 0)
+	{
+		return false;
+	}
+
+	if (stat(sourceFile, &sourceStatus) != 0)
+	{
+		return true;
+	}
+
+	return cacheStatus.st_mtime >= sourceStatus.st_mtime;
+}
+
+/*CalculateBounds finds the box around the vertices and then the sphere around the center of that box that holds all of
+them. That sphere isn't always the smallest one possible but it is close and cheap to find.*/
+void MeshFileClass::CalculateBounds(const vector<MeshVertexType>& vertices, MeshFileHeaderType& header)
+{
+	XMFLOAT3 minimum, maximum;
+	float dx, dy, dz, distance, radius;
+	size_t i;
+
+	minimum = vertices[0].position;
+	maximum = vertices[0].position;
+
+	for (i = 1; i < vertices.size(); i++)
+	{
+		minimum.x = vertices[i].position.x < minimum.x ? vertices[i].position.x : minimum.x;
+		minimum.y = vertices[i].position.y < minimum.y ? vertices[i].position.y : minimum.y;
+		minimum.z = vertices[i].position.z < minimum.z ? vertices[i].position.z : minimum.z;
+		maximum.x = vertices[i].position.x > maximum.x ? vertices[i].position.x : maximum.x;
+		maximum.y = vertices[i].position.y > maximum.y ? vertices[i].position.y : maximum.y;
+		maximum.z = vertices[i].position.z > maximum.z ? vertices[i].position.z : maximum.z;
+	}
+
+	header.boundsCenter = XMFLOAT3((minimum.x + maximum.x) * 0.5f, (minimum.y + maximum.y) * 0.5f, (minimum.z + maximum.z) * 0.5f);
+	header.boundsExtents = XMFLOAT3((maximum.x - minimum.x) * 0.5f, (maximum.y - minimum.y) * 0.5f, (maximum.z - minimum.z) * 0.5f);
+
+	radius = 0.0f;
+	for (i = 0; i < vertices.size(); i++)
+	{
+		dx = vertices[i].position.x - header.boundsCenter.x;
+		dy = vertices[i].position.y - header.boundsCenter.y;
+		dz = vertices[i].position.z - header.boundsCenter.z;
+		distance = dx * dx + dy * dy + dz * dz;
+		if (distance > radius)
+		{
+			radius = distance;
+		}
+	}
+	header.boundsRadius = sqrtf(radius);
+
+	return;
+}
+
+/*SkipSpaces skips spaces and tabs, but not the end of the line.*/
+static const char* SkipSpaces(const char* position, const char* end)
+{
+	while (position < end && (*position == ' ' || *position == '\t'))
+	{
+		position++;
+	}
+
+	return position;
+}
+
+/*SkipLine moves to the start of the next line.*/
+static const char* SkipLine(const char* position, const char* end)
+{
+	while (position < end && *position != '\n')
+	{
+		position++;
+	}
+
+	return position + (position < end ? 1 : 0);
+}
+
+/*ParseFloat reads a number like 1, -0.25, .5 or 1.5e-3. The digits are collected in an integer and scaled by a power
+of ten once at the end. Powers up to 22 are exact doubles, so the usual six or seven digits OBJ exporters write come out
+as the nearest float without calling pow.*/
+static bool ParseFloat(const char*& position, const char* end, float& value)
+{
+	unsigned long long mantissa;
+	int exponent, exponentValue, digits;
+	bool negative, negativeExponent;
+
+	position = SkipSpaces(position, end);
+
+	negative = false;
+	if (position < end && (*position == '-' || *position == '+'))
+	{
+		negative = *position == '-';
+		position++;
+	}
+
+	mantissa = 0;
+	exponent = 0;
+	digits = 0;
+	while (position < end && *position >= '0' && *position <= '9')
+	{
+		// Past 18 digits the rest can't change a float, only count them.
+		if (mantissa < 100000000000000000ULL)
+		{
+			mantissa = mantissa * 10 + (unsigned long long)(*position - '0');
+		}
+		else
+		{
+			exponent++;
+		}
+		position++;
+		digits++;
+	}
+
+	if (position < end && *position == '.')
+	{
+		position++;
+		while (position < end && *position >= '0' && *position <= '9')
+		{
+			if (mantissa < 100000000000000000ULL)
+			{
+				mantissa = mantissa * 10 + (unsigned long long)(*position - '0');
+				exponent--;
+			}
+			position++;
+			digits++;
+		}
+	}
+
+	if (digits == 0)
+	{
+		return false;
+	}
+
+	if (position < end && (*position == 'e' || *position == 'E'))
+	{
+		position++;
+		negativeExponent = false;
+		if (position < end && (*position == '-' || *position == '+'))
+		{
+			negativeExponent = *position == '-';
+			position++;
+		}
+
+		exponentValue = 0;
+		while (position < end && *position >= '0' && *position <= '9')
+		{
+			if (exponentValue < 1000)
+			{
+				exponentValue = exponentValue * 10 + (*position - '0');
+			}
+			position++;
+		}
+		exponent += negativeExponent ? -exponentValue : exponentValue;
+	}
+
+	if (exponent >= 0 && exponent <= 22)
+	{
+		value = (float)((double)mantissa * POWERS_OF_TEN[exponent]);
+	}
+	else if (exponent < 0 && exponent >= -22)
+	{
+		value = (float)((double)mantissa / POWERS_OF_TEN[-exponent]);
+	}
+	else
+	{
+		value = (float)((double)mantissa * pow(10.0, (double)exponent));
+	}
+	if (negative)
+	{
+		value = -value;
+	}
+
+	return true;
+}
+
+/*ParseInteger reads a whole number with an optional sign.*/
+static bool ParseInteger(const char*& position, const char* end, int& value)
+{
+	bool negative;
+	int digits;
+
+	negative = false;
+	if (position < end && (*position == '-' || *position == '+'))
+	{
+		negative = *position == '-';
+		position++;
+	}
+
+	value = 0;
+	digits = 0;
+	while (position < end && *position >= '0' && *position <= '9')
+	{
+		value = value * 10 + (*position - '0');
+		position++;
+		digits++;
+	}
+
+	if (negative)
+	{
+		value = -value;
+	}
+
+	return digits > 0 && digits < 10;
+}
+
+/*AlignOffset rounds a file offset up to the alignment of the streams.*/
+static unsigned long long AlignOffset(unsigned long long offset)
+{
+	return (offset + MESH_STREAM_ALIGNMENT - 1) & ~(MESH_STREAM_ALIGNMENT - 1);
+}
@@ -0,0 +1,123 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: meshfileclass.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _MESHFILECLASS_H_
+#define _MESHFILECLASS_H_
+
+
+//////////////
+// INCLUDES //
+//////////////
+#include <directxmath.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "mappedfileclass.h"
+#include "vertexformatclass.h"
+using namespace DirectX;
+using namespace std;
+
+
+/////////////
+// GLOBALS //
+/////////////
+/*Bump the version whenever the layout of the file or of the vertices changes, old cache files are imported again.*/
+const unsigned int MESH_FILE_VERSION = 4;
+
+/*Meshes with fewer vertices than this store their indices in 16 bits, which halves the index bandwidth. The last
+16 bit index is left out since 0xffff cuts strips apart.*/
+const int MESH_SHORT_INDEX_LIMIT = 65535;
+
+/*The most levels of detail a mesh file holds, the full mesh included.*/
+const int MESH_MAX_LODS = 8;
+
+
+/////////////
+// TYPEDEFS //
+/////////////
+/*One level of detail of a mesh: the range of the index stream with its triangles and how far, on average, its surface
+is from the one of the full mesh, in the units of the mesh.*/
+struct MeshLodType
+{
+	unsigned int firstIndex;
+	unsigned int indexCount;
+	float error;
+	unsigned int reserved;
+};
+
+/*The header at the start of every mesh file. It is followed by the vertex stream and the index stream, both starting
+at a 16 byte aligned offset so they can be used right where they are mapped. The vertices are packed in the vertex
+format whose hash is in the header, quantized positions against the bounds in the header. The indices are 2 or 4 bytes
+each, the index stream holds the triangles of all levels of detail one after the other and all of them use the same
+vertices. The first level is the full mesh.*/
+struct MeshFileHeaderType
+{
+	char magic[4];
+	unsigned int version;
+	unsigned int vertexStride;
+	unsigned int indexSize;
+	unsigned int vertexCount;
+	unsigned int indexCount;
+	XMFLOAT3 boundsCenter;
+	XMFLOAT3 boundsExtents;
+	float boundsRadius;
+	unsigned int vertexFormat;
+	unsigned long long vertexOffset;
+	unsigned long long indexOffset;
+	unsigned int lodCount;
+	unsigned int reserved;
+	MeshLodType lods[MESH_MAX_LODS];
+};
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: MeshFileClass
+////////////////////////////////////////////////////////////////////////////////
+/*The MeshFileClass loads meshes from our own binary mesh format: a header, the vertices and the indices exactly the
+way the buffers want them, and the bounds of the mesh. The vertices are in the vertex format asked for when opening. The file is memory mapped and its streams are handed to the
+buffers as they are, there is nothing left to parse at load time.
+
+Artists give us Wavefront OBJ files. Opening an .obj imports it once into a .mesh file next to it (quad.obj becomes
+quad.mesh) and maps that, the next time the .mesh file is used as long as it is newer than the .obj and has the
+current version and vertex format. The importer takes the positions, the optional vertex colors that many tools write after them
+(v x y z r g b), the normals and the faces, which are split into triangle fans. OBJ files are right handed with counter clockwise
+front faces, so z is flipped and the triangles are turned around for our left handed clockwise setup. Before the mesh
+is written the MeshSimplifierClass builds its levels of detail and the MeshOptimizerClass reorders the triangles of
+every level for the vertex cache and the vertices for the vertex fetch.*/
+class MeshFileClass
+{
+public:
+	MeshFileClass();
+	MeshFileClass(const MeshFileClass&);
+	~MeshFileClass();
+
+	bool Open(const char*, const VertexFormatType&, string&);
+	void Close();
+
+	int GetVertexCount();
+	int GetIndexCount();
+	int GetVertexStride();
+	const void* GetVertices();
+	const void* GetIndices();
+	int GetIndexSize();
+	void GetBounds(XMFLOAT3&, XMFLOAT3&, float&);
+	int GetLodCount();
+	MeshLodType GetLod(int);
+
+	static bool ImportObj(const char*, const char*, const VertexFormatType&, string&);
+	static bool ParseObj(const char*, vector<MeshVertexType>&, vector<unsigned int>&);
+	static void GenerateNormals(vector<MeshVertexType>&, const vector<unsigned int>&);
+	static bool WriteMesh(const char*, const VertexFormatType&, const vector<MeshVertexType>&, const vector<unsigned int>&, const vector<MeshLodType>&);
+	static string GetCacheFileName(const char*);
+
+private:
+	bool OpenMesh(const char*, const VertexFormatType&);
+	static bool IsCacheCurrent(const char*, const char*);
+	static void CalculateBounds(const vector<MeshVertexType>&, MeshFileHeaderType&);
+
+private:
+	MappedFileClass m_file;
+	const MeshFileHeaderType* m_header;
+};
+
+#endif
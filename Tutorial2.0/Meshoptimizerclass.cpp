@@ -0,0 +1,306 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: meshoptimizerclass.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "meshoptimizerclass.h"
+#include "profilerclass.h"
+#include <math.h>
+
+
+/////////////
+// GLOBALS //
+/////////////
+/*The scoring constants from Forsyth's article. The three vertices of the last triangle get a fixed score a little
+lower than the next ones so the order doesn't keep reusing the same edge, the rest of the cache falls off with the
+decay power and vertices with few triangles left get a boost so they are finished off instead of left dangling.*/
+static const float LAST_TRIANGLE_SCORE = 0.75f;
+static const float CACHE_DECAY_POWER = 1.5f;
+static const float VALENCE_BOOST_SCALE = 2.0f;
+static const float VALENCE_BOOST_POWER = 0.5f;
+static const int VALENCE_TABLE_SIZE = 64;
+
+
+///////////////////////
+// FUNCTION PROTOTYPES //
+///////////////////////
+static float GetVertexScore(const float*, const float*, int, int);
+
+
+/*OptimizeVertexCache reorders the triangles of an indexed triangle list for the post transform vertex cache. It runs
+in time linear in the number of triangles: only the triangles of the vertices in the simulated cache are scored again
+after each triangle, and when none of them is left the next triangle is taken in the original order.*/
+void MeshOptimizerClass::OptimizeVertexCache(vector<unsigned int>& indices, int vertexCount)
+{
+	PROFILE_FUNCTION();
+
+	float cacheScores[MESH_OPTIMIZER_CACHE_SIZE];
+	float valenceScores[VALENCE_TABLE_SIZE];
+	int cache[MESH_OPTIMIZER_CACHE_SIZE + 3], newCache[MESH_OPTIMIZER_CACHE_SIZE + 3];
+	vector<int> triangleOffsets, activeTriangles, vertexTriangles, cachePositions;
+	vector<float> vertexScores, triangleScores;
+	vector<unsigned char> triangleAdded;
+	vector<unsigned int> output;
+	int triangleCount, cacheCount, newCacheCount, bestTriangle, nextTriangle, triangle, vertex, corner, i, j, k;
+	float bestScore, score;
+
+	triangleCount = (int)indices.size() / 3;
+	if (triangleCount == 0 || vertexCount == 0)
+	{
+		return;
+	}
+
+	// Work out the score tables once.
+	for (i = 0; i < MESH_OPTIMIZER_CACHE_SIZE; i++)
+	{
+		if (i < 3)
+		{
+			cacheScores[i] = LAST_TRIANGLE_SCORE;
+		}
+		else
+		{
+			cacheScores[i] = powf(1.0f - (float)(i - 3) / (float)(MESH_OPTIMIZER_CACHE_SIZE - 3), CACHE_DECAY_POWER);
+		}
+	}
+
+	valenceScores[0] = 0.0f;
+	for (i = 1; i < VALENCE_TABLE_SIZE; i++)
+	{
+		valenceScores[i] = VALENCE_BOOST_SCALE * powf((float)i, -VALENCE_BOOST_POWER);
+	}
+
+	// Count the triangles of every vertex and list them, the offsets point at the start of each vertex's list.
+	activeTriangles.assign(vertexCount, 0);
+	for (i = 0; i < triangleCount * 3; i++)
+	{
+		activeTriangles[indices[i]]++;
+	}
+
+	triangleOffsets.resize(vertexCount + 1);
+	triangleOffsets[0] = 0;
+	for (i = 0; i < vertexCount; i++)
+	{
+		triangleOffsets[i + 1] = triangleOffsets[i] + activeTriangles[i];
+		activeTriangles[i] = 0;
+	}
+
+	vertexTriangles.resize(triangleCount * 3);
+	for (i = 0; i < triangleCount * 3; i++)
+	{
+		vertex = indices[i];
+		vertexTriangles[triangleOffsets[vertex] + activeTriangles[vertex]] = i / 3;
+		activeTriangles[vertex]++;
+	}
+
+	// Score the vertices and triangles before anything is drawn.
+	cachePositions.assign(vertexCount, -1);
+	vertexScores.resize(vertexCount);
+	for (i = 0; i < vertexCount; i++)
+	{
+		vertexScores[i] = GetVertexScore(cacheScores, valenceScores, -1, activeTriangles[i]);
+	}
+
+	triangleScores.resize(triangleCount);
+	bestTriangle = 0;
+	bestScore = -1.0f;
+	for (i = 0; i < triangleCount; i++)
+	{
+		triangleScores[i] = vertexScores[indices[i * 3]] + vertexScores[indices[i * 3 + 1]] + vertexScores[indices[i * 3 + 2]];
+		if (triangleScores[i] > bestScore)
+		{
+			bestScore = triangleScores[i];
+			bestTriangle = i;
+		}
+	}
+
+	triangleAdded.assign(triangleCount, 0);
+	output.reserve(indices.size());
+	cacheCount = 0;
+	nextTriangle = 0;
+
+	for (triangle = 0; triangle < triangleCount; triangle++)
+	{
+		// When no triangle of the cached vertices is left take the next one that wasn't drawn yet.
+		if (bestTriangle < 0)
+		{
+			while (triangleAdded[nextTriangle])
+			{
+				nextTriangle++;
+			}
+			bestTriangle = nextTriangle;
+		}
+
+		// Draw the triangle and take it off the lists of its vertices.
+		triangleAdded[bestTriangle] = 1;
+		for (corner = 0; corner < 3; corner++)
+		{
+			vertex = indices[bestTriangle * 3 + corner];
+			output.push_back((unsigned int)vertex);
+
+			for (j = triangleOffsets[vertex]; j < triangleOffsets[vertex] + activeTriangles[vertex]; j++)
+			{
+				if (vertexTriangles[j] == bestTriangle)
+				{
+					vertexTriangles[j] = vertexTriangles[triangleOffsets[vertex] + activeTriangles[vertex] - 1];
+					activeTriangles[vertex]--;
+					break;
+				}
+			}
+		}
+
+		// Its vertices move to the front of the cache, the rest shifts back.
+		newCacheCount = 0;
+		for (corner = 0; corner < 3; corner++)
+		{
+			vertex = indices[bestTriangle * 3 + corner];
+			for (k = 0; k < newCacheCount && newCache[k] != vertex; k++)
+			{
+			}
+			if (k == newCacheCount)
+			{
+				newCache[newCacheCount++] = vertex;
+			}
+		}
+
+		for (i = 0; i < cacheCount; i++)
+		{
+			vertex = cache[i];
+			if (vertex != newCache[0] && (newCacheCount < 2 || vertex != newCache[1]) && (newCacheCount < 3 || vertex != newCache[2]))
+			{
+				newCache[newCacheCount++] = vertex;
+			}
+		}
+
+		// Score the vertices again, the ones that fell out of the cache too, and pass the change on to their triangles.
+		for (i = 0; i < newCacheCount; i++)
+		{
+			vertex = newCache[i];
+			cachePositions[vertex] = i < MESH_OPTIMIZER_CACHE_SIZE ? i : -1;
+
+			score = GetVertexScore(cacheScores, valenceScores, cachePositions[vertex], activeTriangles[vertex]);
+			for (j = triangleOffsets[vertex]; j < triangleOffsets[vertex] + activeTriangles[vertex]; j++)
+			{
+				triangleScores[vertexTriangles[j]] += score - vertexScores[vertex];
+			}
+			vertexScores[vertex] = score;
+		}
+
+		cacheCount = newCacheCount < MESH_OPTIMIZER_CACHE_SIZE ? newCacheCount : MESH_OPTIMIZER_CACHE_SIZE;
+		for (i = 0; i < cacheCount; i++)
+		{
+			cache[i] = newCache[i];
+		}
+
+		// The next triangle is the best one among the triangles of the cached vertices.
+		bestTriangle = -1;
+		bestScore = -1.0f;
+		for (i = 0; i < cacheCount; i++)
+		{
+			vertex = cache[i];
+			for (j = triangleOffsets[vertex]; j < triangleOffsets[vertex] + activeTriangles[vertex]; j++)
+			{
+				if (triangleScores[vertexTriangles[j]] > bestScore)
+				{
+					bestScore = triangleScores[vertexTriangles[j]];
+					bestTriangle = vertexTriangles[j];
+				}
+			}
+		}
+	}
+
+	indices.swap(output);
+
+	return;
+}
+
+/*OptimizeVertexFetch numbers the vertices in the order the index list first uses them and moves them to match.*/
+void MeshOptimizerClass::OptimizeVertexFetch(vector<MeshVertexType>& vertices, vector<unsigned int>& indices)
+{
+	PROFILE_FUNCTION();
+
+	vector<unsigned int> remap;
+	vector<MeshVertexType> output;
+	unsigned int unused;
+	size_t i;
+
+	unused = 0xffffffff;
+	remap.assign(vertices.size(), unused);
+	output.reserve(vertices.size());
+
+	for (i = 0; i < indices.size(); i++)
+	{
+		if (remap[indices[i]] == unused)
+		{
+			remap[indices[i]] = (unsigned int)output.size();
+			output.push_back(vertices[indices[i]]);
+		}
+		indices[i] = remap[indices[i]];
+	}
+
+	vertices.swap(output);
+
+	return;
+}
+
+/*AnalyzeVertexCache draws the index list through a simulated first in first out cache of the given size and counts
+the vertices that have to be transformed. A vertex is in the cache when fewer than cacheSize misses happened since it
+was put in, so the simulation needs no cache array at all.*/
+VertexCacheStatisticsType MeshOptimizerClass::AnalyzeVertexCache(const vector<unsigned int>& indices, int vertexCount, int cacheSize)
+{
+	VertexCacheStatisticsType statistics;
+	vector<int> insertedAt;
+	vector<unsigned char> used;
+	int misses, usedVertices;
+	size_t i;
+
+	insertedAt.assign(vertexCount, -cacheSize - 1);
+	used.assign(vertexCount, 0);
+	misses = 0;
+	usedVertices = 0;
+
+	for (i = 0; i < indices.size(); i++)
+	{
+		if (misses - insertedAt[indices[i]] >= cacheSize)
+		{
+			insertedAt[indices[i]] = misses;
+			misses++;
+		}
+
+		if (!used[indices[i]])
+		{
+			used[indices[i]] = 1;
+			usedVertices++;
+		}
+	}
+
+	statistics.triangles = (int)indices.size() / 3;
+	statistics.vertices = usedVertices;
+	statistics.transformedVertices = misses;
+	statistics.acmr = statistics.triangles > 0 ? (float)misses / (float)statistics.triangles : 0.0f;
+	statistics.atvr = usedVertices > 0 ? (float)misses / (float)usedVertices : 0.0f;
+
+	return statistics;
+}
+
+/*GetVertexScore scores a vertex from its place in the cache (-1 when it isn't in it) and the number of triangles it
+still has to be drawn with. A vertex with no triangles left is never wanted again.*/
+static float GetVertexScore(const float* cacheScores, const float* valenceScores, int cachePosition, int activeTriangles)
+{
+	float score;
+
+	if (activeTriangles == 0)
+	{
+		return -1.0f;
+	}
+
+	score = cachePosition >= 0 ? cacheScores[cachePosition] : 0.0f;
+
+	if (activeTriangles < VALENCE_TABLE_SIZE)
+	{
+		score += valenceScores[activeTriangles];
+	}
+	else
+	{
+		score += VALENCE_BOOST_SCALE * powf((float)activeTriangles, -VALENCE_BOOST_POWER);
+	}
+
+	return score;
+}
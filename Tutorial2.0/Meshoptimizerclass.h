@@ -0,0 +1,62 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: meshoptimizerclass.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _MESHOPTIMIZERCLASS_H_
+#define _MESHOPTIMIZERCLASS_H_
+
+
+//////////////
+// INCLUDES //
+//////////////
+#include <vector>
+#include "meshfileclass.h"
+using namespace std;
+
+
+/////////////
+// GLOBALS //
+/////////////
+/*The size of the least recently used cache the triangle order is optimized for, and of the first in first out cache
+the statistics simulate. The real post transform cache of a video card is neither, but optimizing for a large LRU cache
+does well on all of them and 16 FIFO entries is the common yardstick for comparing orders.*/
+const int MESH_OPTIMIZER_CACHE_SIZE = 32;
+const int MESH_ANALYZER_CACHE_SIZE = 16;
+
+
+/////////////
+// TYPEDEFS //
+/////////////
+/*How well an index order uses the vertex cache. ACMR is the average number of vertices transformed per triangle
+(0.5 is the best a regular grid can do, 3 is no reuse at all), ATVR the number of vertices transformed per vertex in
+the mesh (1 is ideal).*/
+struct VertexCacheStatisticsType
+{
+	int triangles;
+	int vertices;
+	int transformedVertices;
+	float acmr;
+	float atvr;
+};
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: MeshOptimizerClass
+////////////////////////////////////////////////////////////////////////////////
+/*The MeshOptimizerClass reorders meshes when they are imported so the video card does less work drawing them.
+
+OptimizeVertexCache sorts the triangles so triangles that share vertices are drawn close together and the shared
+vertices are still in the post transform cache, using Tom Forsyth's linear speed vertex cache optimisation: every
+vertex gets a score from its position in a simulated cache and from how many of its triangles are still to be drawn,
+and the triangle with the best score of its vertices is drawn next.
+
+OptimizeVertexFetch then renumbers the vertices in the order the triangles first use them, so the vertex fetch reads
+the vertex buffer front to back. Vertices no triangle uses are dropped.*/
+class MeshOptimizerClass
+{
+public:
+	static void OptimizeVertexCache(vector<unsigned int>&, int);
+	static void OptimizeVertexFetch(vector<MeshVertexType>&, vector<unsigned int>&);
+	static VertexCacheStatisticsType AnalyzeVertexCache(const vector<unsigned int>&, int, int);
+};
+
+#endif
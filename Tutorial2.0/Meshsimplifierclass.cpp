@@ -0,0 +1,650 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: meshsimplifierclass.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "meshsimplifierclass.h"
+#include "meshoptimizerclass.h"
+#include "profilerclass.h"
+#include <algorithm>
+#include <math.h>
+#include <string.h>
+
+
+///////////////////////
+// FUNCTION PROTOTYPES //
+///////////////////////
+static XMFLOAT3 Subtract(const XMFLOAT3&, const XMFLOAT3&);
+static XMFLOAT3 Cross(const XMFLOAT3&, const XMFLOAT3&);
+static float Dot(const XMFLOAT3&, const XMFLOAT3&);
+static bool IsPositionLess(const XMFLOAT3&, const XMFLOAT3&);
+
+
+MeshSimplifierClass::MeshSimplifierClass()
+{
+	m_error = 0.0;
+}
+
+MeshSimplifierClass::MeshSimplifierClass(const MeshSimplifierClass& other)
+{
+}
+
+MeshSimplifierClass::~MeshSimplifierClass()
+{
+}
+
+/*Initialize takes a copy of the positions and triangles of the mesh and works out which vertices may move and the
+quadrics of all of them.*/
+bool MeshSimplifierClass::Initialize(const vector<MeshVertexType>& vertices, const vector<unsigned int>& indices)
+{
+	PROFILE_FUNCTION();
+
+	size_t i;
+
+	if (vertices.empty() || indices.empty() || indices.size() % 3 != 0)
+	{
+		return false;
+	}
+
+	m_positions.resize(vertices.size());
+	for (i = 0; i < vertices.size(); i++)
+	{
+		m_positions[i] = vertices[i].position;
+	}
+
+	m_indices = indices;
+	m_error = 0.0;
+
+	ClassifyVertices();
+	ComputeQuadrics();
+
+	return true;
+}
+
+void MeshSimplifierClass::Shutdown()
+{
+	m_positions.clear();
+	m_indices.clear();
+	m_quadrics.clear();
+	m_kinds.clear();
+	m_remap.clear();
+	m_error = 0.0;
+
+	return;
+}
+
+/*Simplify collapses edges until the mesh has no more than targetTriangles triangles, or until the next collapse would
+move the surface further than maxError on average from where the full mesh was. It returns true when the target was
+reached.*/
+bool MeshSimplifierClass::Simplify(int targetTriangles, float maxError)
+{
+	PROFILE_FUNCTION();
+
+	vector<unsigned long long> edges;
+	vector<CollapseType> collapses;
+	vector<unsigned int> adjacencyOffsets, adjacencyTriangles;
+	vector<unsigned char> moved;
+	CollapseType collapse;
+	double maxCost;
+	unsigned int a, b, corner[3];
+	int triangleCount, removed, collapseCount;
+	size_t i, j, k, end;
+	bool border, forward, backward;
+	float forwardCost, backwardCost;
+
+	// The costs are mean squared distances.
+	maxCost = (double)maxError * (double)maxError;
+	triangleCount = GetTriangleCount();
+
+	while (triangleCount > targetTriangles)
+	{
+		// List the triangles around every vertex.
+		adjacencyOffsets.assign(m_positions.size() + 1, 0);
+		for (i = 0; i < m_indices.size(); i++)
+		{
+			adjacencyOffsets[m_indices[i] + 1]++;
+		}
+		for (i = 0; i < m_positions.size(); i++)
+		{
+			adjacencyOffsets[i + 1] += adjacencyOffsets[i];
+		}
+		adjacencyTriangles.resize(m_indices.size());
+		for (i = 0; i < m_indices.size(); i++)
+		{
+			adjacencyTriangles[adjacencyOffsets[m_indices[i]]++] = (unsigned int)(i / 3);
+		}
+		for (i = m_positions.size(); i > 0; i--)
+		{
+			adjacencyOffsets[i] = adjacencyOffsets[i - 1];
+		}
+		adjacencyOffsets[0] = 0;
+
+		// Every edge once with the smaller vertex first, an edge that only one triangle has is on the border.
+		edges.resize(m_indices.size());
+		for (i = 0; i < m_indices.size(); i += 3)
+		{
+			for (j = 0; j < 3; j++)
+			{
+				a = m_indices[i + j];
+				b = m_indices[i + (j + 1) % 3];
+				edges[i + j] = a < b ? ((unsigned long long)a << 32) | b : ((unsigned long long)b << 32) | a;
+			}
+		}
+		sort(edges.begin(), edges.end());
+
+		// Find the cheapest way to collapse every edge.
+		collapses.clear();
+		for (i = 0; i < edges.size(); i = end)
+		{
+			for (end = i + 1; end < edges.size() && edges[end] == edges[i]; end++)
+			{
+			}
+
+			a = (unsigned int)(edges[i] >> 32);
+			b = (unsigned int)(edges[i] & 0xffffffff);
+			border = end - i == 1;
+
+			forward = IsCollapseAllowed(a, b, border);
+			backward = IsCollapseAllowed(b, a, border);
+			forwardCost = forward ? GetCollapseCost(a, b) : 0.0f;
+			backwardCost = backward ? GetCollapseCost(b, a) : 0.0f;
+
+			if (forward && (!backward || forwardCost <= backwardCost))
+			{
+				collapse.from = a;
+				collapse.to = b;
+				collapse.cost = forwardCost;
+			}
+			else if (backward)
+			{
+				collapse.from = b;
+				collapse.to = a;
+				collapse.cost = backwardCost;
+			}
+			else
+			{
+				continue;
+			}
+
+			if ((double)collapse.cost <= maxCost)
+			{
+				collapses.push_back(collapse);
+			}
+		}
+
+		if (collapses.empty())
+		{
+			break;
+		}
+
+		sort(collapses.begin(), collapses.end());
+
+		// Collapse the cheapest edges first, each vertex moves or is moved onto at most once per pass.
+		m_remap.resize(m_positions.size());
+		for (i = 0; i < m_remap.size(); i++)
+		{
+			m_remap[i] = (unsigned int)i;
+		}
+		moved.assign(m_positions.size(), 0);
+
+		collapseCount = 0;
+		for (i = 0; i < collapses.size() && triangleCount > targetTriangles; i++)
+		{
+			if (moved[collapses[i].from] || moved[collapses[i].to])
+			{
+				continue;
+			}
+
+			if (!IsCollapseValid(collapses[i].from, collapses[i].to, adjacencyOffsets, adjacencyTriangles, removed))
+			{
+				continue;
+			}
+
+			m_remap[collapses[i].from] = collapses[i].to;
+			moved[collapses[i].from] = 1;
+			moved[collapses[i].to] = 1;
+			AddQuadric(m_quadrics[collapses[i].to], m_quadrics[collapses[i].from]);
+
+			m_error = max(m_error, (double)collapses[i].cost);
+			triangleCount -= removed;
+			collapseCount++;
+		}
+
+		if (collapseCount == 0)
+		{
+			break;
+		}
+
+		// Move the corners and drop the triangles that lost their area.
+		k = 0;
+		for (i = 0; i < m_indices.size(); i += 3)
+		{
+			corner[0] = m_remap[m_indices[i]];
+			corner[1] = m_remap[m_indices[i + 1]];
+			corner[2] = m_remap[m_indices[i + 2]];
+
+			if (corner[0] != corner[1] && corner[1] != corner[2] && corner[0] != corner[2])
+			{
+				m_indices[k++] = corner[0];
+				m_indices[k++] = corner[1];
+				m_indices[k++] = corner[2];
+			}
+		}
+		m_indices.resize(k);
+
+		triangleCount = GetTriangleCount();
+	}
+
+	return triangleCount <= targetTriangles;
+}
+
+void MeshSimplifierClass::GetIndices(vector<unsigned int>& indices)
+{
+	indices = m_indices;
+	return;
+}
+
+int MeshSimplifierClass::GetTriangleCount()
+{
+	return (int)(m_indices.size() / 3);
+}
+
+/*GetError returns the largest error of the collapses so far, as a distance: the root of the mean squared distance of
+the moved vertex to the planes of the triangles it stands for.*/
+float MeshSimplifierClass::GetError()
+{
+	return (float)sqrt(m_error);
+}
+
+/*GenerateLods builds the chain of levels of detail of a mesh. The indices of all levels are put one after the other,
+the full mesh first, and every level is ordered for the vertex cache on its own. The vertices aren't changed, the
+levels use them as they are.*/
+void MeshSimplifierClass::GenerateLods(const vector<MeshVertexType>& vertices, const vector<unsigned int>& indices, vector<unsigned int>& lodIndices,
+	vector<MeshLodType>& lods)
+{
+	PROFILE_FUNCTION();
+
+	MeshSimplifierClass simplifier;
+	vector<unsigned int> levelIndices;
+	MeshLodType lod;
+	XMFLOAT3 minimum, maximum, extents;
+	float maxError;
+	int previousTriangles, targetTriangles;
+	size_t i;
+	bool result, reached;
+
+	lodIndices = indices;
+	lods.clear();
+
+	// The full mesh is always the first level.
+	lod.firstIndex = 0;
+	lod.indexCount = (unsigned int)indices.size();
+	lod.error = 0.0f;
+	lod.reserved = 0;
+	lods.push_back(lod);
+
+	if ((int)indices.size() / 3 < MESH_LOD_MIN_TRIANGLES * 2)
+	{
+		return;
+	}
+
+	// The error limit goes with the size of the mesh.
+	minimum = vertices[0].position;
+	maximum = vertices[0].position;
+	for (i = 1; i < vertices.size(); i++)
+	{
+		minimum.x = min(minimum.x, vertices[i].position.x);
+		minimum.y = min(minimum.y, vertices[i].position.y);
+		minimum.z = min(minimum.z, vertices[i].position.z);
+		maximum.x = max(maximum.x, vertices[i].position.x);
+		maximum.y = max(maximum.y, vertices[i].position.y);
+		maximum.z = max(maximum.z, vertices[i].position.z);
+	}
+	extents = XMFLOAT3((maximum.x - minimum.x) * 0.5f, (maximum.y - minimum.y) * 0.5f, (maximum.z - minimum.z) * 0.5f);
+	maxError = sqrtf(Dot(extents, extents)) * MESH_LOD_MAX_ERROR;
+
+	result = simplifier.Initialize(vertices, indices);
+	if (!result)
+	{
+		return;
+	}
+
+	// Every level goes on from the one before it, with the quadrics of the full mesh.
+	while ((int)lods.size() < MESH_MAX_LODS)
+	{
+		previousTriangles = simplifier.GetTriangleCount();
+		targetTriangles = (int)((float)previousTriangles * MESH_LOD_REDUCTION);
+		if (targetTriangles < MESH_LOD_MIN_TRIANGLES)
+		{
+			break;
+		}
+
+		reached = simplifier.Simplify(targetTriangles, maxError);
+		if (simplifier.GetTriangleCount() > (int)((float)previousTriangles * MESH_LOD_MIN_STEP))
+		{
+			break;
+		}
+
+		simplifier.GetIndices(levelIndices);
+		MeshOptimizerClass::OptimizeVertexCache(levelIndices, (int)vertices.size());
+
+		lod.firstIndex = (unsigned int)lodIndices.size();
+		lod.indexCount = (unsigned int)levelIndices.size();
+		lod.error = simplifier.GetError();
+		lods.push_back(lod);
+		lodIndices.insert(lodIndices.end(), levelIndices.begin(), levelIndices.end());
+
+		// When the error limit stopped it the next level can't get any further.
+		if (!reached)
+		{
+			break;
+		}
+	}
+
+	simplifier.Shutdown();
+
+	return;
+}
+
+/*ClassifyVertices finds the vertices that may not move freely. Vertices with the same position are found by sorting,
+the border and non manifold edges by sorting the edges of all triangles and looking for each one turned around.*/
+void MeshSimplifierClass::ClassifyVertices()
+{
+	vector<unsigned int> order;
+	vector<unsigned long long> edges;
+	unsigned long long reverse;
+	unsigned int a, b;
+	size_t i, j, end;
+
+	m_kinds.assign(m_positions.size(), VERTEX_KIND_MANIFOLD);
+
+	// Vertices that share a position are the two sides of a seam, moving one would tear the mesh open.
+	order.resize(m_positions.size());
+	for (i = 0; i < order.size(); i++)
+	{
+		order[i] = (unsigned int)i;
+	}
+	sort(order.begin(), order.end(), [this](unsigned int left, unsigned int right) { return IsPositionLess(m_positions[left], m_positions[right]); });
+
+	for (i = 0; i < order.size(); i = end)
+	{
+		for (end = i + 1; end < order.size() && memcmp(&m_positions[order[end]], &m_positions[order[i]], sizeof(XMFLOAT3)) == 0; end++)
+		{
+		}
+
+		if (end - i > 1)
+		{
+			for (j = i; j < end; j++)
+			{
+				m_kinds[order[j]] = VERTEX_KIND_LOCKED;
+			}
+		}
+	}
+
+	// The directed edges of all triangles. An edge without its reverse is on the border, one that is there more than once
+	// belongs to more than two triangles or to triangles facing different ways.
+	edges.resize(m_indices.size());
+	for (i = 0; i < m_indices.size(); i += 3)
+	{
+		for (j = 0; j < 3; j++)
+		{
+			edges[i + j] = ((unsigned long long)m_indices[i + j] << 32) | m_indices[i + (j + 1) % 3];
+		}
+	}
+	sort(edges.begin(), edges.end());
+
+	for (i = 0; i < edges.size(); i++)
+	{
+		a = (unsigned int)(edges[i] >> 32);
+		b = (unsigned int)(edges[i] & 0xffffffff);
+		reverse = ((unsigned long long)b << 32) | a;
+
+		if ((i + 1 < edges.size() && edges[i + 1] == edges[i]) || (i > 0 && edges[i - 1] == edges[i]))
+		{
+			m_kinds[a] = VERTEX_KIND_LOCKED;
+			m_kinds[b] = VERTEX_KIND_LOCKED;
+		}
+		else if (!binary_search(edges.begin(), edges.end(), reverse))
+		{
+			if (m_kinds[a] == VERTEX_KIND_MANIFOLD)
+			{
+				m_kinds[a] = VERTEX_KIND_BORDER;
+			}
+			if (m_kinds[b] == VERTEX_KIND_MANIFOLD)
+			{
+				m_kinds[b] = VERTEX_KIND_BORDER;
+			}
+		}
+	}
+
+	return;
+}
+
+/*ComputeQuadrics adds the plane of every triangle to its three vertices, weighted by its area so small triangles
+don't count as much as large ones. Every border edge also adds the plane through the edge standing straight up on
+its triangle, which keeps the border vertices on the line of the border.*/
+void MeshSimplifierClass::ComputeQuadrics()
+{
+	vector<unsigned long long> edges;
+	XMFLOAT3 normal, edge, borderNormal;
+	QuadricType zero;
+	unsigned int corners[3], a, b;
+	float length, edgeLength;
+	size_t i, j;
+
+	memset(&zero, 0, sizeof(zero));
+	m_quadrics.assign(m_positions.size(), zero);
+
+	edges.resize(m_indices.size());
+	for (i = 0; i < m_indices.size(); i += 3)
+	{
+		for (j = 0; j < 3; j++)
+		{
+			edges[i + j] = ((unsigned long long)m_indices[i + j] << 32) | m_indices[i + (j + 1) % 3];
+		}
+	}
+	sort(edges.begin(), edges.end());
+
+	for (i = 0; i < m_indices.size(); i += 3)
+	{
+		corners[0] = m_indices[i];
+		corners[1] = m_indices[i + 1];
+		corners[2] = m_indices[i + 2];
+
+		normal = Cross(Subtract(m_positions[corners[1]], m_positions[corners[0]]), Subtract(m_positions[corners[2]], m_positions[corners[0]]));
+		length = sqrtf(Dot(normal, normal));
+		if (length == 0.0f)
+		{
+			continue;
+		}
+		normal = XMFLOAT3(normal.x / length, normal.y / length, normal.z / length);
+
+		// The length of the cross product is twice the area.
+		for (j = 0; j < 3; j++)
+		{
+			AddPlane(m_quadrics[corners[j]], normal, -Dot(normal, m_positions[corners[0]]), (double)length * 0.5);
+		}
+
+		for (j = 0; j < 3; j++)
+		{
+			a = corners[j];
+			b = corners[(j + 1) % 3];
+			if (binary_search(edges.begin(), edges.end(), ((unsigned long long)b << 32) | a))
+			{
+				continue;
+			}
+
+			edge = Subtract(m_positions[b], m_positions[a]);
+			edgeLength = sqrtf(Dot(edge, edge));
+			borderNormal = Cross(edge, normal);
+			length = sqrtf(Dot(borderNormal, borderNormal));
+			if (length == 0.0f)
+			{
+				continue;
+			}
+			borderNormal = XMFLOAT3(borderNormal.x / length, borderNormal.y / length, borderNormal.z / length);
+
+			AddPlane(m_quadrics[a], borderNormal, -Dot(borderNormal, m_positions[a]), (double)edgeLength * edgeLength * MESH_SIMPLIFIER_BORDER_WEIGHT);
+			AddPlane(m_quadrics[b], borderNormal, -Dot(borderNormal, m_positions[a]), (double)edgeLength * edgeLength * MESH_SIMPLIFIER_BORDER_WEIGHT);
+		}
+	}
+
+	return;
+}
+
+/*IsCollapseAllowed checks the kinds of the two vertices. Locked vertices stay where they are and border vertices only
+move along a border edge onto another vertex of the border.*/
+bool MeshSimplifierClass::IsCollapseAllowed(unsigned int from, unsigned int to, bool borderEdge)
+{
+	switch (m_kinds[from])
+	{
+	case VERTEX_KIND_MANIFOLD:
+		return true;
+	case VERTEX_KIND_BORDER:
+		return borderEdge && m_kinds[to] != VERTEX_KIND_MANIFOLD;
+	}
+
+	return false;
+}
+
+/*GetCollapseCost returns the mean squared distance of the position of the to vertex to the planes of both vertices.*/
+float MeshSimplifierClass::GetCollapseCost(unsigned int from, unsigned int to)
+{
+	QuadricType quadric;
+	double cost;
+
+	quadric = m_quadrics[from];
+	AddQuadric(quadric, m_quadrics[to]);
+
+	cost = EvaluateQuadric(quadric, m_positions[to]);
+	if (quadric.weight > 0.0)
+	{
+		cost /= quadric.weight;
+	}
+
+	return (float)max(cost, 0.0);
+}
+
+/*IsCollapseValid checks that none of the triangles around the from vertex turns around or loses its area when the
+vertex moves, other than the ones that also have the to vertex and disappear. It counts those in removed. The corners
+are looked up through the remap, they may have moved earlier in the pass.*/
+bool MeshSimplifierClass::IsCollapseValid(unsigned int from, unsigned int to, const vector<unsigned int>& adjacencyOffsets,
+	const vector<unsigned int>& adjacencyTriangles, int& removed)
+{
+	XMFLOAT3 before, after;
+	unsigned int corners[3], triangle, j;
+	const XMFLOAT3* positions[3];
+	int fromCorner;
+
+	removed = 0;
+	for (j = adjacencyOffsets[from]; j < adjacencyOffsets[from + 1]; j++)
+	{
+		triangle = adjacencyTriangles[j];
+		corners[0] = m_remap[m_indices[triangle * 3]];
+		corners[1] = m_remap[m_indices[triangle * 3 + 1]];
+		corners[2] = m_remap[m_indices[triangle * 3 + 2]];
+
+		// Triangles that already lost their area this pass don't matter any more.
+		if (corners[0] == corners[1] || corners[1] == corners[2] || corners[0] == corners[2])
+		{
+			continue;
+		}
+
+		if (corners[0] == to || corners[1] == to || corners[2] == to)
+		{
+			removed++;
+			continue;
+		}
+
+		fromCorner = corners[0] == from ? 0 : (corners[1] == from ? 1 : 2);
+
+		positions[0] = &m_positions[corners[0]];
+		positions[1] = &m_positions[corners[1]];
+		positions[2] = &m_positions[corners[2]];
+		before = Cross(Subtract(*positions[1], *positions[0]), Subtract(*positions[2], *positions[0]));
+
+		positions[fromCorner] = &m_positions[to];
+		after = Cross(Subtract(*positions[1], *positions[0]), Subtract(*positions[2], *positions[0]));
+
+		// The normal may turn a little but not flip, and the triangle may not collapse into a line.
+		if (Dot(before, after) <= 1e-3f * sqrtf(Dot(before, before) * Dot(after, after)))
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/*AddPlane adds the quadric of the plane normal.x * x + normal.y * y + normal.z * z + distance = 0 with a weight.*/
+void MeshSimplifierClass::AddPlane(QuadricType& quadric, const XMFLOAT3& normal, float distance, double weight)
+{
+	double a, b, c, d;
+
+	a = normal.x;
+	b = normal.y;
+	c = normal.z;
+	d = distance;
+
+	quadric.a2 += a * a * weight;
+	quadric.ab += a * b * weight;
+	quadric.ac += a * c * weight;
+	quadric.ad += a * d * weight;
+	quadric.b2 += b * b * weight;
+	quadric.bc += b * c * weight;
+	quadric.bd += b * d * weight;
+	quadric.c2 += c * c * weight;
+	quadric.cd += c * d * weight;
+	quadric.d2 += d * d * weight;
+	quadric.weight += weight;
+
+	return;
+}
+
+void MeshSimplifierClass::AddQuadric(QuadricType& quadric, const QuadricType& other)
+{
+	quadric.a2 += other.a2;
+	quadric.ab += other.ab;
+	quadric.ac += other.ac;
+	quadric.ad += other.ad;
+	quadric.b2 += other.b2;
+	quadric.bc += other.bc;
+	quadric.bd += other.bd;
+	quadric.c2 += other.c2;
+	quadric.cd += other.cd;
+	quadric.d2 += other.d2;
+	quadric.weight += other.weight;
+
+	return;
+}
+
+/*EvaluateQuadric returns the weighted sum of the squared distances of a point to the planes of the quadric.*/
+double MeshSimplifierClass::EvaluateQuadric(const QuadricType& quadric, const XMFLOAT3& position)
+{
+	double x, y, z;
+
+	x = position.x;
+	y = position.y;
+	z = position.z;
+
+	return x * x * quadric.a2 + y * y * quadric.b2 + z * z * quadric.c2 + 2.0 * (x * y * quadric.ab + x * z * quadric.ac + y * z * quadric.bc) +
+		2.0 * (x * quadric.ad + y * quadric.bd + z * quadric.cd) + quadric.d2;
+}
+
+static XMFLOAT3 Subtract(const XMFLOAT3& left, const XMFLOAT3& right)
+{
+	return XMFLOAT3(left.x - right.x, left.y - right.y, left.z - right.z);
+}
+
+static XMFLOAT3 Cross(const XMFLOAT3& left, const XMFLOAT3& right)
+{
+	return XMFLOAT3(left.y * right.z - left.z * right.y, left.z * right.x - left.x * right.z, left.x * right.y - left.y * right.x);
+}
+
+static float Dot(const XMFLOAT3& left, const XMFLOAT3& right)
+{
+	return left.x * right.x + left.y * right.y + left.z * right.z;
+}
+
+static bool IsPositionLess(const XMFLOAT3& left, const XMFLOAT3& right)
+{
+	return memcmp(&left, &right, sizeof(XMFLOAT3)) < 0;
+}
@@ -0,0 +1,120 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: meshsimplifierclass.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _MESHSIMPLIFIERCLASS_H_
+#define _MESHSIMPLIFIERCLASS_H_
+
+
+//////////////
+// INCLUDES //
+//////////////
+#include <directxmath.h>
+#include <vector>
+#include "meshfileclass.h"
+using namespace DirectX;
+using namespace std;
+
+
+/////////////
+// GLOBALS //
+/////////////
+/*How the importer builds the chain of levels of detail. Every level aims for MESH_LOD_REDUCTION of the triangles of
+the level before it, and is only kept when it has at most MESH_LOD_MIN_STEP of them, a level that barely differs from
+the one before it costs memory for nothing. The chain stops at MESH_LOD_MIN_TRIANGLES triangles or when the error
+would grow past MESH_LOD_MAX_ERROR times the radius of the mesh.*/
+const float MESH_LOD_REDUCTION = 0.5f;
+const float MESH_LOD_MIN_STEP = 0.8f;
+const int MESH_LOD_MIN_TRIANGLES = 64;
+const float MESH_LOD_MAX_ERROR = 0.05f;
+
+/*The quadrics of the planes along the open borders of a mesh count this many times more than the ones of its
+triangles, so borders keep their shape.*/
+const float MESH_SIMPLIFIER_BORDER_WEIGHT = 10.0f;
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: MeshSimplifierClass
+////////////////////////////////////////////////////////////////////////////////
+/*The MeshSimplifierClass takes triangles away from a mesh with the quadric error metric of Garland and Heckbert. Every
+vertex gets a quadric, the sum of the squared distances to the planes of its triangles, and collapsing an edge moves
+one vertex onto the other and adds their quadrics. The cost of a collapse is that quadric at the position the vertex
+ends up at, the cheapest edges go first. Vertices only move onto vertices that are already there, so every level of
+detail uses the vertices of the full mesh and only needs an index list of its own.
+
+The simplifier works in passes: a pass finds the cost of every edge, sorts them and collapses the cheapest ones that
+don't touch a vertex that already moved in the same pass and don't turn a triangle around. Vertices on an open border
+only move along the border, and vertices that share their position with another vertex (the seams where the normal
+or color jumps) or sit on an edge of more than two triangles don't move at all, so the mesh doesn't tear.
+
+Simplify can be called again with a lower target to go on from where it stopped, GenerateLods does that to build the
+chain of levels of detail of the mesh file.*/
+class MeshSimplifierClass
+{
+private:
+	/*A quadric is a symmetric 4x4 matrix, the ten different elements are kept. The weight is the sum of the areas
+	the planes were weighted with, dividing by it makes the error the mean squared distance.*/
+	struct QuadricType
+	{
+		double a2, ab, ac, ad;
+		double b2, bc, bd;
+		double c2, cd;
+		double d2;
+		double weight;
+	};
+
+	/*One possible collapse of a pass, the from vertex moves onto the to vertex.*/
+	struct CollapseType
+	{
+		unsigned int from;
+		unsigned int to;
+		float cost;
+
+		bool operator<(const CollapseType& other) const
+		{
+			return cost < other.cost;
+		}
+	};
+
+	enum VertexKind
+	{
+		VERTEX_KIND_MANIFOLD,
+		VERTEX_KIND_BORDER,
+		VERTEX_KIND_LOCKED
+	};
+
+public:
+	MeshSimplifierClass();
+	MeshSimplifierClass(const MeshSimplifierClass&);
+	~MeshSimplifierClass();
+
+	bool Initialize(const vector<MeshVertexType>&, const vector<unsigned int>&);
+	void Shutdown();
+
+	bool Simplify(int, float);
+	void GetIndices(vector<unsigned int>&);
+	int GetTriangleCount();
+	float GetError();
+
+	static void GenerateLods(const vector<MeshVertexType>&, const vector<unsigned int>&, vector<unsigned int>&, vector<MeshLodType>&);
+
+private:
+	void ClassifyVertices();
+	void ComputeQuadrics();
+	bool IsCollapseAllowed(unsigned int, unsigned int, bool);
+	float GetCollapseCost(unsigned int, unsigned int);
+	bool IsCollapseValid(unsigned int, unsigned int, const vector<unsigned int>&, const vector<unsigned int>&, int&);
+
+	static void AddPlane(QuadricType&, const XMFLOAT3&, float, double);
+	static void AddQuadric(QuadricType&, const QuadricType&);
+	static double EvaluateQuadric(const QuadricType&, const XMFLOAT3&);
+
+private:
+	vector<XMFLOAT3> m_positions;
+	vector<unsigned int> m_indices;
+	vector<QuadricType> m_quadrics;
+	vector<unsigned char> m_kinds;
+	vector<unsigned int> m_remap;
+	double m_error;
+};
+
+#endif
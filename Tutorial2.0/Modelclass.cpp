@@ -3,14 +3,26 @@
 ////////////////////////////////////////////////////////////////////////////////
 
 /*As stated previously the ModelClass is responsible for encapsulating the geometry for 3D models. 
-In this tutorial we will manually setup the data for a single green triangle. We will also create a vertex and index buffer for the triangle so that it can be rendered.*/
+The geometry is loaded from a mesh file (see the MeshFileClass) and put in a vertex and index buffer so that it can be rendered.*/
 #include "modelclass.h"
+#include "profilerclass.h"
 
 /*The class constructor initializes the vertex and index buffer pointers to null.*/
 ModelClass::ModelClass()
 {
+	m_device = 0;
 	m_vertexBuffer = 0;
 	m_indexBuffer = 0;
+	m_vertexCount = 0;
+	m_indexCount = 0;
+	m_vertexStride = 0;
+	m_indexSize = 0;
+	m_indexFormat = RENDER_FORMAT_R32_UINT;
+	XMStoreFloat4x4(&m_decodeMatrix, XMMatrixIdentity());
+	m_boundsCenter = XMFLOAT3(0.0f, 0.0f, 0.0f);
+	m_boundsExtents = XMFLOAT3(0.0f, 0.0f, 0.0f);
+	m_boundsRadius = 0.0f;
+	m_lodCenter = XMFLOAT3(0.0f, 0.0f, 0.0f);
 }
 
 ModelClass::ModelClass(const ModelClass& other)
@@ -21,13 +33,19 @@ ModelClass::~ModelClass()
 {
 }
 
-/*The Initialize function will call the initialization functions for the vertex and index buffers.*/
-bool ModelClass::Initialize(ID3D11Device* device)
+/*The Initialize function will call the initialization functions for the vertex and index buffers with the mesh in the given file,
+in the given vertex format. When the mesh can't be imported errors tells why.*/
+bool ModelClass::Initialize(RenderDeviceClass* device, const char* filename, const VertexFormatType& format, string& errors)
 {
+	PROFILE_FUNCTION();
+
 	bool result;
 
+	// Keep the device around so the buffers can be released again.
+	m_device = device;
+
 	// Initialize the vertex and index buffers.
-	result = InitializeBuffers(device);
+	result = InitializeBuffers(device, filename, format, errors);
 	if (!result)
 	{
 		return false;
@@ -47,132 +65,168 @@ void ModelClass::Shutdown()
 
 /*Render is called from the GraphicsClass::Render function. 
 This function calls RenderBuffers to put the vertex and index buffers on the graphics pipeline so the color shader will be able to render them.*/
-void ModelClass::Render(ID3D11DeviceContext* deviceContext)
+void ModelClass::Render(RenderContextClass* deviceContext)
 {
+	PROFILE_FUNCTION();
+
 	// Put the vertex and index buffers on the graphics pipeline to prepare them for drawing.
 	RenderBuffers(deviceContext);
 
 	return;
 }
 
-/*GetIndexCount returns the number of indexes in the model. The color shader will need this information to draw this model.*/
+/*FillCommand is Render for the render queue: instead of binding the buffers it puts them in the command, with the
+indices of the given level of detail.*/
+void ModelClass::FillCommand(RenderCommandType& command, int lod)
+{
+	command.vertexBuffers[0] = m_vertexBuffer;
+	command.strides[0] = m_vertexStride;
+	command.indexBuffer = m_indexBuffer;
+	command.indexFormat = m_indexFormat;
+	command.topology = RENDER_TOPOLOGY_TRIANGLELIST;
+	command.startIndex = m_lods[lod].firstIndex;
+	command.indexCount = m_lods[lod].indexCount;
+
+	return;
+}
+
+/*GetIndexCount returns the number of indexes in the model. The color shader will need this information to draw this model.
+The full mesh is the first level of detail in the index buffer, so drawing this many indices from the start draws it.*/
 int ModelClass::GetIndexCount()
 {
-	return m_indexCount;
+	return m_lods.empty() ? 0 : (int)m_lods[0].indexCount;
 }
 
-/*The InitializeBuffers function is where we handle creating the vertex and index buffers. 
-Usually you would read in a model and create the buffers from that data file. 
-For this tutorial we will just set the points in the vertex and index buffer manually since it is only a single triangle.*/
-bool ModelClass::InitializeBuffers(ID3D11Device* device)
+int ModelClass::GetLodCount()
 {
-	VertexType* vertices;
-	unsigned long* indices;
-	D3D11_BUFFER_DESC vertexBufferDesc, indexBufferDesc;
-	D3D11_SUBRESOURCE_DATA vertexData, indexData;
-	HRESULT result;
+	return (int)m_lods.size();
+}
 
-	/*First create two temporary arrays to hold the vertex and index data that we will use later to populate the final buffers with.*/
+int ModelClass::GetLodTriangleCount(int lod)
+{
+	return (int)(m_lods[lod].indexCount / 3);
+}
 
-	// Set the number of vertices in the vertex array.
-	m_vertexCount = 4;
+/*GetLodDepth returns the distance in front of the camera of the center of the model, given the transposed
+world-view-projection matrix of a draw. That is the w of the center after the projection, the dot product of the
+center with the last row of the transposed matrix.*/
+float ModelClass::GetLodDepth(const XMFLOAT4X4& transform)
+{
+	return transform._41 * m_lodCenter.x + transform._42 * m_lodCenter.y + transform._43 * m_lodCenter.z + transform._44;
+}
 
-	// Set the number of indices in the index array.
-	m_indexCount = 6;
+/*SelectLod picks the coarsest level of detail whose error still looks smaller than a pixel at the given depth. An
+error e at depth d covers e * lodScale / d pixels, lodScale being the projection scale in pixels divided by the error
+in pixels that is allowed (see Graphics::Render), so a level may be used as long as e * lodScale <= d. Models that are
+too close to tell get the full mesh.*/
+int ModelClass::SelectLod(float depth, float lodScale)
+{
+	int lod;
 
-	// Create the vertex array.
-	vertices = new VertexType[m_vertexCount];
-	if (!vertices)
+	for (lod = (int)m_lods.size() - 1; lod > 0; lod--)
 	{
-		return false;
+		if (m_lods[lod].error * lodScale <= depth)
+		{
+			break;
+		}
 	}
 
-	// Create the index array.
-	indices = new unsigned long[m_indexCount];
-	if (!indices)
+	return lod;
+}
+
+/*GetBounds returns the center and half size of the box around the model and the radius of the sphere around it.*/
+void ModelClass::GetBounds(XMFLOAT3& center, XMFLOAT3& extents, float& radius)
+{
+	center = m_boundsCenter;
+	extents = m_boundsExtents;
+	radius = m_boundsRadius;
+
+	return;
+}
+
+/*GetDecodeMatrix returns the matrix that has to go in front of the world matrix for the vertex format of the model,
+the identity unless the positions are quantized.*/
+void ModelClass::GetDecodeMatrix(XMMATRIX& decodeMatrix)
+{
+	decodeMatrix = XMLoadFloat4x4(&m_decodeMatrix);
+	return;
+}
+
+/*GetVertexBufferSize and GetIndexBufferSize return the size of the buffers in bytes.*/
+int ModelClass::GetVertexBufferSize()
+{
+	return m_vertexCount * m_vertexStride;
+}
+
+int ModelClass::GetIndexBufferSize()
+{
+	return m_indexCount * m_indexSize;
+}
+
+/*The InitializeBuffers function is where we handle creating the vertex and index buffers. 
+The mesh file is memory mapped and its vertex and index streams are already laid out the way the buffers want them,
+so they are handed to CreateBuffer right from the mapped pages without copying them into temporary arrays first.*/
+bool ModelClass::InitializeBuffers(RenderDeviceClass* device, const char* filename, const VertexFormatType& format, string& errors)
+{
+	PROFILE_FUNCTION();
+
+	MeshFileClass mesh;
+	int i;
+	bool result;
+
+	// Open the mesh file, importing it first if it is an OBJ file that wasn't imported yet.
+	result = mesh.Open(filename, format, errors);
+	if (!result)
 	{
 		return false;
 	}
 
-	/*Now fill both the vertex and index array with the three points of the triangle as well as the index to each of the points. 
-	Please note that I create the points in the clockwise order of drawing them. If you do this counter clockwise it will think the triangle 
-	is facing the opposite direction and not draw it due to back face culling. Always remember that the order in which you send your vertices 
-	to the GPU is very important. The color is set here as well since it is part of the vertex description. I set the color to green.*/
+	// Set the number of vertices and indices.
+	m_vertexCount = mesh.GetVertexCount();
+	m_indexCount = mesh.GetIndexCount();
 
-	// Load the vertex array with data.
-	vertices[0].position = XMFLOAT3(-1.0f, -1.0f, 0.0f);  // Bottom left.
-	vertices[0].color = XMFLOAT4(0.0f, 1.0f, 0.0f, 1.0f);
+	m_vertexStride = mesh.GetVertexStride();
+	m_indexSize = mesh.GetIndexSize();
 
-	vertices[1].position = XMFLOAT3(-1.0f, 1.0f, 0.0f);  // Top left.
-	vertices[1].color = XMFLOAT4(0.0f, 1.0f, 0.0f, 1.0f);
+	// Small meshes come with 16 bit indices.
+	m_indexFormat = m_indexSize == sizeof(unsigned short) ? RENDER_FORMAT_R16_UINT : RENDER_FORMAT_R32_UINT;
 
-	vertices[2].position = XMFLOAT3(1.0f, 1.0f, 0.0f);  // Top right.
-	vertices[2].color = XMFLOAT4(0.0f, 1.0f, 0.0f, 1.0f);
+	// The importer already worked out the bounding box and sphere, the positions may be quantized against the box.
+	mesh.GetBounds(m_boundsCenter, m_boundsExtents, m_boundsRadius);
+	XMStoreFloat4x4(&m_decodeMatrix, VertexFormatClass::GetDecodeMatrix(format, m_boundsCenter, m_boundsExtents));
 
-	vertices[3].position = XMFLOAT3(1.0f, -1.0f, 0.0f);  // Bottom right.
-	vertices[3].color = XMFLOAT4(0.0f, 1.0f, 0.0f, 1.0f);
+	// The draws transform the vertices as they are stored, so the center is taken back through the decode matrix.
+	XMStoreFloat3(&m_lodCenter, XMVector3TransformCoord(XMLoadFloat3(&m_boundsCenter), XMMatrixInverse(NULL, XMLoadFloat4x4(&m_decodeMatrix))));
 
-	// Load the index array with data.
-	indices[0] = 0;  // Bottom left.
-	indices[1] = 1;  // Top left.
-	indices[2] = 2;  // top right.
-
-	indices[3] = 0;  // Bottom left.
-	indices[4] = 2;  // Top right.
-	indices[5] = 3;  // Bottom right.
+	// Keep the ranges of the levels of detail in the index buffer.
+	m_lods.resize(mesh.GetLodCount());
+	for (i = 0; i < (int)m_lods.size(); i++)
+	{
+		m_lods[i] = mesh.GetLod(i);
+	}
 
-	/*With the vertex array and index array filled out we can now use those to create the vertex buffer and index buffer. 
+	/*With the vertex and index streams mapped we can now use those to create the vertex buffer and index buffer. 
 	Creating both buffers is done in the same fashion. First fill out a description of the buffer. In the description the ByteWidth 
 	(size of the buffer) and the BindFlags (type of buffer) are what you need to ensure are filled out correctly. After the description 
-	is filled out you need to also fill out a subresource pointer which will point to either your vertex or index array you previously 
-	created. With the description and subresource pointer you can call CreateBuffer using the D3D device and it will return a pointer to your new buffer.*/
-
-	// Set up the description of the static vertex buffer.
-	vertexBufferDesc.Usage = D3D11_USAGE_DEFAULT;
-	vertexBufferDesc.ByteWidth = sizeof(VertexType) * m_vertexCount;
-	vertexBufferDesc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
-	vertexBufferDesc.CPUAccessFlags = 0;
-	vertexBufferDesc.MiscFlags = 0;
-	vertexBufferDesc.StructureByteStride = 0;
-
-	// Give the subresource structure a pointer to the vertex data.
-	vertexData.pSysMem = vertices;
-	vertexData.SysMemPitch = 0;
-	vertexData.SysMemSlicePitch = 0;
-
-	// Now create the vertex buffer.
-	result = device->CreateBuffer(&vertexBufferDesc, &vertexData, &m_vertexBuffer);
-	if (FAILED(result))
+	is filled out you need to also fill out a subresource pointer which will point to your vertex or index data. 
+	With the description and subresource pointer you can call CreateBuffer using the D3D device and it will return a pointer to your new buffer.*/
+
+	// Now create the static vertex buffer.
+	result = device->CreateBuffer(RENDER_VERTEX_BUFFER, RENDER_USAGE_DEFAULT, m_vertexStride * m_vertexCount, mesh.GetVertices(), m_vertexBuffer);
+	if (!result)
 	{
 		return false;
 	}
 
-	// Set up the description of the static index buffer.
-	indexBufferDesc.Usage = D3D11_USAGE_DEFAULT;
-	indexBufferDesc.ByteWidth = sizeof(unsigned long) * m_indexCount;
-	indexBufferDesc.BindFlags = D3D11_BIND_INDEX_BUFFER;
-	indexBufferDesc.CPUAccessFlags = 0;
-	indexBufferDesc.MiscFlags = 0;
-	indexBufferDesc.StructureByteStride = 0;
-
-	// Give the subresource structure a pointer to the index data.
-	indexData.pSysMem = indices;
-	indexData.SysMemPitch = 0;
-	indexData.SysMemSlicePitch = 0;
-
-	// Create the index buffer.
-	result = device->CreateBuffer(&indexBufferDesc, &indexData, &m_indexBuffer);
-	if (FAILED(result))
+	// Create the static index buffer.
+	result = device->CreateBuffer(RENDER_INDEX_BUFFER, RENDER_USAGE_DEFAULT, m_indexSize * m_indexCount, mesh.GetIndices(), m_indexBuffer);
+	if (!result)
 	{
 		return false;
 	}
 
-	// Release the arrays now that the vertex and index buffers have been created and loaded.
-	delete[] vertices;
-	vertices = 0;
-
-	delete[] indices;
-	indices = 0;
+	// Unmap the file now that the vertex and index buffers have been created and loaded.
+	mesh.Close();
 
 	return true;
 }
@@ -183,17 +237,19 @@ void ModelClass::ShutdownBuffers()
 	// Release the index buffer.
 	if (m_indexBuffer)
 	{
-		m_indexBuffer->Release();
+		m_device->ReleaseBuffer(m_indexBuffer);
 		m_indexBuffer = 0;
 	}
 
 	// Release the vertex buffer.
 	if (m_vertexBuffer)
 	{
-		m_vertexBuffer->Release();
+		m_device->ReleaseBuffer(m_vertexBuffer);
 		m_vertexBuffer = 0;
 	}
 
+	m_lods.clear();
+
 	return;
 }
 
@@ -201,23 +257,25 @@ void ModelClass::ShutdownBuffers()
 Once the GPU has an active vertex buffer it can then use the shader to render that buffer. This function also defines how those buffers should be drawn such as triangles, 
 lines, fans, and so forth. In this tutorial we set the vertex buffer and index buffer as active on the input assembler and tell the GPU that the buffers should be drawn
 as triangles using the IASetPrimitiveTopology DirectX function.*/
-void ModelClass::RenderBuffers(ID3D11DeviceContext* deviceContext)
+void ModelClass::RenderBuffers(RenderContextClass* deviceContext)
 {
+	PROFILE_FUNCTION();
+
 	unsigned int stride;
 	unsigned int offset;
 
 	// Set vertex buffer stride and offset.
-	stride = sizeof(VertexType);
+	stride = m_vertexStride;
 	offset = 0;
 
 	// Set the vertex buffer to active in the input assembler so it can be rendered.
 	deviceContext->IASetVertexBuffers(0, 1, &m_vertexBuffer, &stride, &offset);
 
 	// Set the index buffer to active in the input assembler so it can be rendered.
-	deviceContext->IASetIndexBuffer(m_indexBuffer, DXGI_FORMAT_R32_UINT, 0);
+	deviceContext->IASetIndexBuffer(m_indexBuffer, m_indexFormat, 0);
 
 	// Set the type of primitive that should be rendered from this vertex buffer, in this case triangles.
-	deviceContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+	deviceContext->IASetPrimitiveTopology(RENDER_TOPOLOGY_TRIANGLELIST);
 
 	return;
 }
\ No newline at end of file
@@ -8,25 +8,25 @@
 //////////////
 // INCLUDES //
 //////////////
-#include <d3d11.h>
 #include <directxmath.h>
+#include <vector>
+#include "renderdeviceclass.h"
+#include "renderqueueclass.h"
+#include "meshfileclass.h"
 using namespace DirectX;
+using namespace std;
 
 
 ////////////////////////////////////////////////////////////////////////////////
 // Class name: ModelClass
 ////////////////////////////////////////////////////////////////////////////////
+/*The vertices come straight out of the mesh file in the vertex format the model was initialized with (see
+VertexFormatClass). That format must be the one the ColorShaderClass was initialized with, so the layout matches.
+
+The index buffer holds every level of detail of the mesh file after each other, the full mesh first. A draw picks one
+with SelectLod and FillCommand puts its range of indices in the command, all levels use the same vertex buffer.*/
 class ModelClass
 {
-private:
-	/*Here is the definition of our vertex type that will be used with the vertex buffer in this ModelClass. 
-	Also take note that this typedef must match the layout in the ColorShaderClass that will be looked at later in the tutorial.*/
-	struct VertexType
-	{
-		XMFLOAT3 position;
-		XMFLOAT4 color;
-	};
-
 public:
 	ModelClass();
 	ModelClass(const ModelClass&);
@@ -34,22 +34,48 @@ public:
 
 	/*The functions here handle initializing and shutdown of the model's vertex and index buffers. 
 	The Render function puts the model geometry on the video card to prepare it for drawing by the color shader.*/
-	bool Initialize(ID3D11Device*);
+	bool Initialize(RenderDeviceClass*, const char*, const VertexFormatType&, string&);
 	void Shutdown();
-	void Render(ID3D11DeviceContext*);
+	void Render(RenderContextClass*);
+	void FillCommand(RenderCommandType&, int);
 
 	int GetIndexCount();
+	int GetLodCount();
+	int GetLodTriangleCount(int);
+	float GetLodDepth(const XMFLOAT4X4&);
+	int SelectLod(float, float);
+	void GetBounds(XMFLOAT3&, XMFLOAT3&, float&);
+	void GetDecodeMatrix(XMMATRIX&);
+	int GetVertexBufferSize();
+	int GetIndexBufferSize();
 
 private:
-	bool InitializeBuffers(ID3D11Device*);
+	bool InitializeBuffers(RenderDeviceClass*, const char*, const VertexFormatType&, string&);
 	void ShutdownBuffers();
-	void RenderBuffers(ID3D11DeviceContext*);
+	void RenderBuffers(RenderContextClass*);
 
 	/*The private variables in the ModelClass are the vertex and index buffer as well as two integers to keep track of the size of each buffer. 
-	Note that all DirectX 11 buffers generally use the generic ID3D11Buffer type and are more clearly identified by a buffer description when they are first created.*/
+	Note that all DirectX 11 buffers generally use the generic ID3D11Buffer type and are more clearly identified by a buffer description when they are first created.
+	The buffers are created through the render device, so we keep a pointer to it to release them again on shutdown.*/
 private:
-	ID3D11Buffer * m_vertexBuffer, *m_indexBuffer;
+	RenderDeviceClass* m_device;
+	RenderBuffer m_vertexBuffer, m_indexBuffer;
 	int m_vertexCount, m_indexCount;
+	int m_vertexStride, m_indexSize;
+	RenderFormat m_indexFormat;
+
+	/*The matrix that takes quantized positions back to model space, it goes in front of the world matrix of every draw.*/
+	XMFLOAT4X4 m_decodeMatrix;
+
+	/*The levels of detail from the mesh file, and the center of the bounds in the space of the vertices before they
+	are decoded, whose depth picks the level.*/
+	vector<MeshLodType> m_lods;
+	XMFLOAT3 m_lodCenter;
+
+	/*The bounds of the model in its own space: the center and half size of the box around all the vertices and the
+	radius of the sphere around that same center. The frustum culler tests objects with these.*/
+	XMFLOAT3 m_boundsCenter, m_boundsExtents;
+	float m_boundsRadius;
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,74 @@
+#pragma once
+////////////////////////////////////////////////////////////////////////////////
+// Filename: platform.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _PLATFORM_H_
+#define _PLATFORM_H_
+
+/*The render classes used to pull in windows.h through d3d11.h and simply assumed a window was there to show
+message boxes on. Now that the frame path can also run headless (on a build machine with no window and no video card)
+the few Windows types and calls that those classes still need are collected here. On Windows we just include windows.h,
+anywhere else we declare the handful of types ourselves so the same code compiles unchanged.*/
+
+//////////////
+// INCLUDES //
+//////////////
+#ifdef _WIN32
+#include <windows.h>
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <wchar.h>
+#include <string>
+
+
+/////////////
+// TYPEDEFS //
+/////////////
+#ifndef _WIN32
+typedef void* HWND;
+typedef wchar_t WCHAR;
+#endif
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Function name: ShowError
+////////////////////////////////////////////////////////////////////////////////
+/*ShowError is used instead of calling MessageBox directly. When there is a window we pop up a message box as before,
+when there isn't one (headless runs) a message box would block the build machine forever so we write the message to
+stderr instead.*/
+inline void ShowError(HWND hwnd, const WCHAR* text, const WCHAR* caption)
+{
+#ifdef _WIN32
+	if (hwnd)
+	{
+		MessageBox(hwnd, text, caption, MB_OK);
+		return;
+	}
+#endif
+	fwprintf(stderr, L"%ls: %ls\n", caption, text);
+
+	return;
+}
+
+/*The importers and the shader description hand back their errors as narrow strings, one line per error. This shows
+them the same way.*/
+inline void ShowError(HWND hwnd, const std::string& text, const WCHAR* caption)
+{
+	std::wstring wideText;
+	size_t length;
+
+	wideText.assign(text.size() + 1, 0);
+	length = mbstowcs(&wideText[0], text.c_str(), text.size() + 1);
+	if (length == (size_t)-1)
+	{
+		length = 0;
+	}
+	wideText.resize(length);
+
+	ShowError(hwnd, wideText.c_str(), caption);
+
+	return;
+}
+
+#endif
@@ -0,0 +1,29 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: presentclockclass.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _PRESENTCLOCKCLASS_H_
+#define _PRESENTCLOCKCLASS_H_
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: PresentClockClass
+////////////////////////////////////////////////////////////////////////////////
+/*The present clock is everything the FramePacerClass needs to know about time and the GPU: what time it is, how to
+wait until a later time and how many presented frames the GPU has finished. The DeviceClockClass is the real one, on
+the steady clock with a waitable timer and the render device. The SimulatedClockClass only pretends, with time that
+moves when it is told to and a GPU that takes a fixed time per frame, so the pacing can be checked without a window
+and in far less time than it would take for real. Times are in seconds.*/
+class PresentClockClass
+{
+public:
+	virtual ~PresentClockClass() {}
+
+	virtual double GetTime() = 0;
+	/*WaitUntil returns at the given time, or right away when it is past already. It must not keep the core busy.*/
+	virtual void WaitUntil(double) = 0;
+	/*OnPresent is called after every present, the simulated clock starts drawing the frame on its GPU then.*/
+	virtual void OnPresent() = 0;
+	virtual unsigned long long GetCompletedFrames() = 0;
+};
+
+#endif
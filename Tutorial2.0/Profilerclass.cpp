@@ -0,0 +1,414 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: profilerclass.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "profilerclass.h"
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <stdio.h>
+#include <string.h>
+using namespace std;
+
+
+#if PROFILER_ENABLED
+
+/////////////
+// TYPEDEFS //
+/////////////
+struct ProfileEventType
+{
+	const char* name;
+	unsigned long long begin;
+	unsigned long long end;
+	int depth;
+};
+
+/*Only the thread that owns a ring writes into it. The write index is atomic so the trace writer sees whole events.
+A ring is in use while its thread runs, once the thread ends the ring keeps its zones for the trace until another new
+thread takes it over.*/
+struct ProfilerThreadBufferType
+{
+	ProfileEventType events[PROFILER_RING_SIZE];
+	atomic<unsigned int> writeIndex;
+	int threadId;
+	int depth;
+	bool inUse;
+	char threadName[64];
+};
+
+/*ProfilerThreadReleaseType hands the ring of its thread back when the thread ends. It is a thread local of its own so
+only the creation of a ring pays for the destructor, the zones use the plain pointer.*/
+struct ProfilerThreadReleaseType
+{
+	~ProfilerThreadReleaseType();
+};
+
+
+/////////////
+// GLOBALS //
+/////////////
+static mutex g_profilerLock;
+static vector<ProfilerThreadBufferType*> g_profilerBuffers;
+static int g_profilerThreadCount = 0;
+
+/*Shutdown counts up the generation. A thread whose ring is from an older generation stops writing into it, frees it
+itself and gets a new ring the next time it measures something.*/
+static atomic<unsigned int> g_profilerGeneration(1);
+static thread_local ProfilerThreadBufferType* t_profilerBuffer = 0;
+static thread_local unsigned int t_profilerGeneration = 0;
+static thread_local ProfilerThreadReleaseType t_profilerRelease;
+
+/*The timestamp and steady clock time of the moment the first ring was created. Together with the same pair taken when
+writing the trace they give the rate of the time stamp counter.*/
+static unsigned long long g_profilerStartTimestamp;
+static chrono::steady_clock::time_point g_profilerStartTime;
+
+
+/*GetCurrentBuffer returns the ring of the calling thread, or null when it has none or Shutdown freed it.*/
+static inline ProfilerThreadBufferType* GetCurrentBuffer()
+{
+	if (t_profilerGeneration != g_profilerGeneration.load(memory_order_relaxed))
+	{
+		return 0;
+	}
+
+	return t_profilerBuffer;
+}
+
+/*GetThreadBuffer returns the ring of the calling thread. The first time the thread records something it takes over the
+ring of a thread that ended, or creates a new one when every ring is in use, so there are never more rings than threads
+that measured at the same time.*/
+static ProfilerThreadBufferType* GetThreadBuffer()
+{
+	ProfilerThreadBufferType* buffer;
+	size_t i;
+
+	buffer = GetCurrentBuffer();
+	if (buffer)
+	{
+		return buffer;
+	}
+
+	lock_guard<mutex> lock(g_profilerLock);
+
+	// A ring from before the last Shutdown is no longer in the list, only this thread still knows it.
+	if (t_profilerBuffer)
+	{
+		delete t_profilerBuffer;
+		t_profilerBuffer = 0;
+	}
+
+	buffer = 0;
+	for (i = 0; i < g_profilerBuffers.size(); i++)
+	{
+		if (!g_profilerBuffers[i]->inUse)
+		{
+			buffer = g_profilerBuffers[i];
+			break;
+		}
+	}
+
+	if (!buffer)
+	{
+		buffer = new ProfilerThreadBufferType;
+		if (!buffer)
+		{
+			return 0;
+		}
+
+		if (g_profilerBuffers.empty())
+		{
+			g_profilerStartTime = chrono::steady_clock::now();
+			g_profilerStartTimestamp = ProfilerClass::GetTimestamp();
+		}
+		g_profilerBuffers.push_back(buffer);
+	}
+
+	g_profilerThreadCount++;
+	buffer->writeIndex = 0;
+	buffer->depth = 0;
+	buffer->inUse = true;
+	buffer->threadId = g_profilerThreadCount;
+	buffer->threadName[0] = 0;
+
+	t_profilerBuffer = buffer;
+	t_profilerGeneration = g_profilerGeneration.load(memory_order_relaxed);
+
+	// Touch the release object so the thread hands the ring back when it ends.
+	(void)&t_profilerRelease;
+
+	return buffer;
+}
+
+ProfilerThreadReleaseType::~ProfilerThreadReleaseType()
+{
+	lock_guard<mutex> lock(g_profilerLock);
+
+	if (t_profilerBuffer && t_profilerGeneration == g_profilerGeneration.load(memory_order_relaxed))
+	{
+		t_profilerBuffer->inUse = false;
+	}
+	else if (t_profilerBuffer)
+	{
+		delete t_profilerBuffer;
+	}
+	t_profilerBuffer = 0;
+
+	return;
+}
+
+/*GetTicksPerMicrosecond measures how fast the timestamps run by comparing them with the steady clock over everything
+since the first ring was created. The longer the program ran the more accurate it gets, only a very short run has to
+wait a moment to get a usable measurement.*/
+static double GetTicksPerMicrosecond()
+{
+#if PROFILER_USE_RDTSC
+	chrono::duration<double, micro> elapsed;
+	unsigned long long ticks;
+
+	elapsed = chrono::steady_clock::now() - g_profilerStartTime;
+	if (elapsed.count() < 10000.0)
+	{
+		this_thread::sleep_for(chrono::milliseconds(10));
+	}
+
+	ticks = ProfilerClass::GetTimestamp() - g_profilerStartTimestamp;
+	elapsed = chrono::steady_clock::now() - g_profilerStartTime;
+
+	return (double)ticks / elapsed.count();
+#else
+	// Without a time stamp counter the timestamps are nanoseconds.
+	return 1000.0;
+#endif
+}
+
+/*WriteEscaped writes a string into the JSON file. Zone names are function names, so only quotes and backslashes
+need escaping.*/
+static void WriteEscaped(FILE* file, const char* text)
+{
+	while (*text)
+	{
+		if (*text == '"' || *text == '\\')
+		{
+			fputc('\\', file);
+		}
+		fputc(*text, file);
+		text++;
+	}
+
+	return;
+}
+
+
+int ProfilerClass::EnterZone()
+{
+	ProfilerThreadBufferType* buffer;
+
+	buffer = GetThreadBuffer();
+	if (!buffer)
+	{
+		return 0;
+	}
+
+	return buffer->depth++;
+}
+
+void ProfilerClass::LeaveZone()
+{
+	ProfilerThreadBufferType* buffer;
+
+	buffer = GetCurrentBuffer();
+	if (buffer)
+	{
+		buffer->depth--;
+	}
+
+	return;
+}
+
+/*RecordZone writes a finished zone into the ring of the calling thread, overwriting the oldest zone when it is full.*/
+void ProfilerClass::RecordZone(const char* name, unsigned long long begin, unsigned long long end, int depth)
+{
+	ProfilerThreadBufferType* buffer;
+	ProfileEventType* event;
+	unsigned int index;
+
+	buffer = GetCurrentBuffer();
+	if (!buffer)
+	{
+		return;
+	}
+
+	index = buffer->writeIndex.load(memory_order_relaxed);
+
+	event = &buffer->events[index & (PROFILER_RING_SIZE - 1)];
+	event->name = name;
+	event->begin = begin;
+	event->end = end;
+	event->depth = depth;
+
+	buffer->writeIndex.store(index + 1, memory_order_release);
+
+	return;
+}
+
+/*SetThreadName gives the calling thread a name in the trace, otherwise it shows up as "thread N".*/
+void ProfilerClass::SetThreadName(const char* name)
+{
+	ProfilerThreadBufferType* buffer;
+
+	buffer = GetThreadBuffer();
+	if (buffer)
+	{
+		strncpy(buffer->threadName, name, sizeof(buffer->threadName) - 1);
+		buffer->threadName[sizeof(buffer->threadName) - 1] = 0;
+	}
+
+	return;
+}
+
+/*WriteChromeTrace writes every zone still in the rings as a complete ("X") event. The viewer nests the zones by their
+times, the depth is written as an argument as well so it can be checked.*/
+bool ProfilerClass::WriteChromeTrace(const char* filename)
+{
+	FILE* file;
+	ProfilerThreadBufferType* buffer;
+	ProfileEventType* event;
+	double ticksPerMicrosecond;
+	unsigned int writeIndex, first, i;
+	size_t bufferIndex;
+	bool firstEvent;
+
+	lock_guard<mutex> lock(g_profilerLock);
+
+	file = fopen(filename, "w");
+	if (!file)
+	{
+		return false;
+	}
+
+	ticksPerMicrosecond = g_profilerBuffers.empty() ? 1.0 : GetTicksPerMicrosecond();
+
+	fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+	firstEvent = true;
+
+	for (bufferIndex = 0; bufferIndex < g_profilerBuffers.size(); bufferIndex++)
+	{
+		buffer = g_profilerBuffers[bufferIndex];
+
+		// Name the thread.
+		fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"", firstEvent ? "" : ",\n", buffer->threadId);
+		if (buffer->threadName[0])
+		{
+			WriteEscaped(file, buffer->threadName);
+		}
+		else
+		{
+			fprintf(file, "thread %d", buffer->threadId);
+		}
+		fprintf(file, "\"}}");
+		firstEvent = false;
+
+		// Write the zones from the oldest one still in the ring to the newest.
+		writeIndex = buffer->writeIndex.load(memory_order_acquire);
+		first = writeIndex > PROFILER_RING_SIZE ? writeIndex - PROFILER_RING_SIZE : 0;
+
+		for (i = first; i != writeIndex; i++)
+		{
+			event = &buffer->events[i & (PROFILER_RING_SIZE - 1)];
+
+			fprintf(file, ",\n{\"name\":\"");
+			WriteEscaped(file, event->name);
+			fprintf(file, "\",\"cat\":\"cpu\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"depth\":%d}}",
+				buffer->threadId, (double)(event->begin - g_profilerStartTimestamp) / ticksPerMicrosecond,
+				(double)(event->end - event->begin) / ticksPerMicrosecond, event->depth);
+		}
+	}
+
+	fprintf(file, "\n]}\n");
+	fclose(file);
+
+	return true;
+}
+
+/*Reset throws away everything measured so far, for example the zones of the start up before a benchmark begins.*/
+void ProfilerClass::Reset()
+{
+	size_t i;
+
+	lock_guard<mutex> lock(g_profilerLock);
+
+	for (i = 0; i < g_profilerBuffers.size(); i++)
+	{
+		g_profilerBuffers[i]->writeIndex = 0;
+	}
+
+	return;
+}
+
+/*Shutdown releases the rings of the threads that ended and of the calling thread. The rings of the threads that still
+run are only taken out of the list, since they may be writing into them; they notice by the generation and free their
+ring themselves, the next time they measure something or when they end.*/
+void ProfilerClass::Shutdown()
+{
+	size_t i;
+
+	lock_guard<mutex> lock(g_profilerLock);
+
+	for (i = 0; i < g_profilerBuffers.size(); i++)
+	{
+		if (!g_profilerBuffers[i]->inUse || g_profilerBuffers[i] == t_profilerBuffer)
+		{
+			delete g_profilerBuffers[i];
+		}
+	}
+	g_profilerBuffers.clear();
+	g_profilerThreadCount = 0;
+
+	g_profilerGeneration.fetch_add(1, memory_order_relaxed);
+	t_profilerBuffer = 0;
+
+	return;
+}
+
+#else
+
+/*With the profiler compiled out there is nothing to record, so the functions that can still be called do nothing.*/
+int ProfilerClass::EnterZone()
+{
+	return 0;
+}
+
+void ProfilerClass::LeaveZone()
+{
+	return;
+}
+
+void ProfilerClass::RecordZone(const char* name, unsigned long long begin, unsigned long long end, int depth)
+{
+	return;
+}
+
+void ProfilerClass::SetThreadName(const char* name)
+{
+	return;
+}
+
+bool ProfilerClass::WriteChromeTrace(const char* filename)
+{
+	return false;
+}
+
+void ProfilerClass::Reset()
+{
+	return;
+}
+
+void ProfilerClass::Shutdown()
+{
+	return;
+}
+
+#endif
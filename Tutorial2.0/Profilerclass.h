@@ -0,0 +1,126 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: profilerclass.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _PROFILERCLASS_H_
+#define _PROFILERCLASS_H_
+
+
+/*The profiler is on in debug builds and gone in release builds. A release build that should still be profiled can
+define PROFILER_ENABLED=1 in its preprocessor definitions.*/
+#ifndef PROFILER_ENABLED
+#ifdef NDEBUG
+#define PROFILER_ENABLED 0
+#else
+#define PROFILER_ENABLED 1
+#endif
+#endif
+
+
+//////////////
+// INCLUDES //
+//////////////
+#if defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))
+#include <intrin.h>
+#define PROFILER_USE_RDTSC 1
+#elif defined(__i386__) || defined(__x86_64__)
+#include <x86intrin.h>
+#define PROFILER_USE_RDTSC 1
+#else
+#include <chrono>
+#define PROFILER_USE_RDTSC 0
+#endif
+
+
+/////////////
+// MACROS //
+/////////////
+/*PROFILE_ZONE measures the rest of the scope it is written in. The name has to be a string literal, only the pointer
+is stored. Zones that are opened inside other zones become their children in the trace.*/
+#define PROFILER_CONCAT_INNER(a, b) a##b
+#define PROFILER_CONCAT(a, b) PROFILER_CONCAT_INNER(a, b)
+
+#if PROFILER_ENABLED
+#define PROFILE_ZONE(name) ProfileZoneClass PROFILER_CONCAT(profileZone, __LINE__)(name)
+#define PROFILE_FUNCTION() PROFILE_ZONE(__FUNCTION__)
+#define PROFILE_THREAD_NAME(name) ProfilerClass::SetThreadName(name)
+#else
+#define PROFILE_ZONE(name)
+#define PROFILE_FUNCTION()
+#define PROFILE_THREAD_NAME(name)
+#endif
+
+
+/////////////
+// GLOBALS //
+/////////////
+/*Every thread keeps this many zones, once the ring is full the oldest ones get overwritten. It has to be a power of two.*/
+const unsigned int PROFILER_RING_SIZE = 65536;
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: ProfilerClass
+////////////////////////////////////////////////////////////////////////////////
+/*The ProfilerClass collects the zones measured by PROFILE_ZONE. Every thread writes into its own ring buffer so the
+threads never wait on each other while measuring, the only lock is taken when a thread starts measuring and when it
+ends. The ring of a thread that ended is given to the next thread that starts measuring.
+Timestamps come from the time stamp counter of the processor where there is one, which is far cheaper to read than
+the steady clock, and are converted to microseconds when the trace is written.
+
+WriteChromeTrace writes the zones in the Chrome trace event format, open the file in chrome://tracing or Perfetto.
+It reads the rings of all threads, so call it while the other threads aren't measuring anything.*/
+class ProfilerClass
+{
+public:
+	/*GetTimestamp returns the time stamp counter, or steady clock nanoseconds where there is none. The counter runs
+	at a fixed rate on every processor since the Core 2 and Phenom, so it is only converted to time when writing.*/
+	static inline unsigned long long GetTimestamp()
+	{
+#if PROFILER_USE_RDTSC
+		return __rdtsc();
+#else
+		return (unsigned long long)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+	}
+
+	static void RecordZone(const char*, unsigned long long, unsigned long long, int);
+	static int EnterZone();
+	static void LeaveZone();
+
+	static void SetThreadName(const char*);
+	static bool WriteChromeTrace(const char*);
+	static void Reset();
+	static void Shutdown();
+};
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: ProfileZoneClass
+////////////////////////////////////////////////////////////////////////////////
+/*The ProfileZoneClass takes the start time when it is created and records the zone when it goes out of scope. It is
+all inline so a zone costs two timestamp reads and one write into the ring.*/
+class ProfileZoneClass
+{
+public:
+	ProfileZoneClass(const char* name)
+	{
+		m_name = name;
+		m_depth = ProfilerClass::EnterZone();
+		m_begin = ProfilerClass::GetTimestamp();
+	}
+
+	~ProfileZoneClass()
+	{
+		ProfilerClass::RecordZone(m_name, m_begin, ProfilerClass::GetTimestamp(), m_depth);
+		ProfilerClass::LeaveZone();
+	}
+
+private:
+	ProfileZoneClass(const ProfileZoneClass&);
+
+private:
+	const char* m_name;
+	unsigned long long m_begin;
+	int m_depth;
+};
+
+#endif
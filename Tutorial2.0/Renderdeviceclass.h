@@ -0,0 +1,258 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: renderdeviceclass.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _RENDERDEVICECLASS_H_
+#define _RENDERDEVICECLASS_H_
+
+/*The render device is the layer between our own classes and whatever it is that actually draws the frame.
+Direct3D splits this work over two objects, the device that creates resources and the device context that binds
+them and draws, and we keep exactly the same split here: RenderDeviceClass is used where ID3D11Device used to be
+and RenderContextClass where ID3D11DeviceContext used to be. The D3d class implements both on top of Direct3D 11
+and the HeadlessDeviceClass implements both on the CPU by recording every call it receives, so GraphicsClass,
+ModelClass and ColorShaderClass can run (and be timed) on a machine without a window or a video card.*/
+
+//////////////
+// INCLUDES //
+//////////////
+#include <directxmath.h>
+#include <string>
+#include <vector>
+#include "platform.h"
+using namespace DirectX;
+
+
+/////////////
+// HANDLES //
+/////////////
+/*Resources are handed out as opaque pointers. The Direct3D backend hands out the COM interface itself and the headless
+backend hands out its own bookkeeping record, nothing above the device needs to know which one it got.*/
+typedef struct RenderBufferObject* RenderBuffer;
+typedef struct RenderVertexShaderObject* RenderVertexShader;
+typedef struct RenderPixelShaderObject* RenderPixelShader;
+typedef struct RenderInputLayoutObject* RenderInputLayout;
+typedef struct RenderTextureObject* RenderTexture;
+typedef struct RenderCommandListObject* RenderCommandList;
+
+
+///////////
+// ENUMS //
+///////////
+/*These mirror the handful of D3D11 enumerations the engine actually uses. The names are kept close to the
+Direct3D ones so the code reads the same as before.*/
+enum RenderBufferKind
+{
+	RENDER_VERTEX_BUFFER,
+	RENDER_INDEX_BUFFER,
+	RENDER_CONSTANT_BUFFER
+};
+
+enum RenderUsage
+{
+	RENDER_USAGE_DEFAULT, // Filled once at creation, only the GPU touches it after that.
+	RENDER_USAGE_DYNAMIC  // Written by the CPU through Map/Unmap.
+};
+
+enum RenderFormat
+{
+	RENDER_FORMAT_UNKNOWN,
+	RENDER_FORMAT_R32G32B32_FLOAT,
+	RENDER_FORMAT_R32G32B32A32_FLOAT,
+	RENDER_FORMAT_R32_UINT,
+	RENDER_FORMAT_R16_UINT,
+	RENDER_FORMAT_R16G16B16A16_UNORM,
+	RENDER_FORMAT_R8G8B8A8_UNORM,
+	RENDER_FORMAT_R16G16_SNORM,
+	RENDER_FORMAT_BC1_UNORM, // 4x4 texel blocks of 8 bytes, opaque color.
+	RENDER_FORMAT_BC3_UNORM, // 4x4 texel blocks of 16 bytes, color and a separate alpha block.
+	RENDER_FORMAT_BC7_UNORM  // 4x4 texel blocks of 16 bytes, color and alpha together in higher quality.
+};
+
+enum RenderTopology
+{
+	RENDER_TOPOLOGY_TRIANGLELIST
+};
+
+enum RenderInputClassification
+{
+	RENDER_INPUT_PER_VERTEX_DATA,
+	RENDER_INPUT_PER_INSTANCE_DATA
+};
+
+/*The type of the components of a shader input, the same as D3D_REGISTER_COMPONENT_TYPE.*/
+enum RenderComponentType
+{
+	RENDER_COMPONENT_UNKNOWN,
+	RENDER_COMPONENT_UINT32,
+	RENDER_COMPONENT_SINT32,
+	RENDER_COMPONENT_FLOAT32
+};
+
+// Same meaning as D3D11_APPEND_ALIGNED_ELEMENT.
+const unsigned int RENDER_APPEND_ALIGNED_ELEMENT = 0xffffffff;
+
+
+/////////////
+// TYPEDEFS //
+/////////////
+/*The description of one element of a vertex input layout, the same fields as D3D11_INPUT_ELEMENT_DESC.*/
+struct RenderInputElement
+{
+	const char* SemanticName;
+	unsigned int SemanticIndex;
+	RenderFormat Format;
+	unsigned int InputSlot;
+	unsigned int AlignedByteOffset;
+	RenderInputClassification InputSlotClass;
+	unsigned int InstanceDataStepRate;
+};
+
+/*The contents of one mip level of a texture, the same fields as D3D11_SUBRESOURCE_DATA for a 2D texture: the texels
+and the number of bytes from one row to the next.*/
+struct RenderTextureData
+{
+	const void* data;
+	unsigned int rowPitch;
+};
+
+/*A preprocessor define handed to the shader compiler, the same fields as D3D_SHADER_MACRO. Lists of defines end with
+an entry whose name is null.*/
+struct RenderShaderDefine
+{
+	const char* Name;
+	const char* Definition;
+};
+
+/*What the compiler tells about a compiled shader, the parts of ID3D11ShaderReflection the engine uses. Every constant
+buffer with the slot it is bound to, its size and where each of its variables is, and every vertex input the shader
+reads with the number and type of its components. Inputs with a system value semantic (SV_VertexID and the like) are
+left out, the input layout doesn't feed those.*/
+struct RenderShaderVariable
+{
+	std::string name;
+	unsigned int offset;
+	unsigned int size;
+};
+
+struct RenderShaderConstantBuffer
+{
+	std::string name;
+	unsigned int slot;
+	unsigned int size;
+	std::vector<RenderShaderVariable> variables;
+};
+
+struct RenderShaderInput
+{
+	std::string semanticName;
+	unsigned int semanticIndex;
+	unsigned int componentCount;
+	RenderComponentType componentType;
+};
+
+struct RenderShaderReflection
+{
+	std::vector<RenderShaderConstantBuffer> constantBuffers;
+	std::vector<RenderShaderInput> inputs;
+};
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: RenderContextClass
+////////////////////////////////////////////////////////////////////////////////
+/*The context binds resources to the pipeline and issues the draw calls. Everything that happens per frame goes
+through here.*/
+class RenderContextClass
+{
+public:
+	virtual ~RenderContextClass() {}
+
+	virtual void ClearRenderTarget(const float[4]) = 0;
+	virtual void ClearDepthStencil(float) = 0;
+
+	virtual bool Map(RenderBuffer, void**) = 0;
+	virtual void Unmap(RenderBuffer) = 0;
+
+	virtual void IASetVertexBuffers(unsigned int, unsigned int, RenderBuffer*, unsigned int*, unsigned int*) = 0;
+	virtual void IASetIndexBuffer(RenderBuffer, RenderFormat, unsigned int) = 0;
+	virtual void IASetPrimitiveTopology(RenderTopology) = 0;
+	virtual void IASetInputLayout(RenderInputLayout) = 0;
+
+	virtual void VSSetShader(RenderVertexShader) = 0;
+	virtual void PSSetShader(RenderPixelShader) = 0;
+	virtual void VSSetConstantBuffers(unsigned int, unsigned int, RenderBuffer*) = 0;
+	/*VSSetConstantBufferRange binds part of a constant buffer to one slot. The first constant and the number of constants
+	are in 16 byte constants and have to be multiples of 16.*/
+	virtual void VSSetConstantBufferRange(unsigned int, RenderBuffer, unsigned int, unsigned int) = 0;
+
+	virtual void DrawIndexed(unsigned int, unsigned int, int) = 0;
+	virtual void DrawIndexedInstanced(unsigned int, unsigned int, unsigned int, int, unsigned int) = 0;
+
+	/*A deferred context (see RenderDeviceClass::CreateDeferredContext) records the calls instead of issuing them.
+	FinishCommandList hands everything recorded so far over as a command list and starts an empty one, the immediate
+	context plays a command list back with ExecuteCommandList. A command list is played back once and then released.*/
+	virtual bool FinishCommandList(RenderCommandList&) = 0;
+	virtual void ExecuteCommandList(RenderCommandList) = 0;
+};
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: RenderDeviceClass
+////////////////////////////////////////////////////////////////////////////////
+/*The device creates and releases resources and owns the frame (BeginScene/EndScene) and the matrices that used to
+be fetched straight from the D3d class. Initialize is not part of the interface since each backend needs different
+things to start up (the Direct3D one needs a window, the headless one doesn't).*/
+class RenderDeviceClass
+{
+public:
+	virtual ~RenderDeviceClass() {}
+
+	virtual void Shutdown() = 0;
+
+	virtual void BeginScene(float, float, float, float) = 0;
+	virtual void EndScene() = 0;
+	/*GetCompletedFrames returns how many of the frames EndScene presented the GPU has finished. The ones after those are
+	still in flight, the FramePacerClass waits for them so the CPU doesn't run too far ahead.*/
+	virtual unsigned long long GetCompletedFrames() = 0;
+	/*SupportsConstantBufferOffsets tells if VSSetConstantBufferRange can be used, which needs the Direct3D 11.1 runtime.
+	Without it every constant buffer is bound whole, see ConstantAllocatorClass.*/
+	virtual bool SupportsConstantBufferOffsets() = 0;
+
+	virtual RenderContextClass* GetContext() = 0;
+
+	virtual void GetProjectionMatrix(XMMATRIX&) = 0;
+	virtual void GetWorldMatrix(XMMATRIX&) = 0;
+	virtual void GetOrthoMatrix(XMMATRIX&) = 0;
+
+	virtual bool CreateBuffer(RenderBufferKind, RenderUsage, unsigned int, const void*, RenderBuffer&) = 0;
+	virtual void ReleaseBuffer(RenderBuffer) = 0;
+
+	/*CreateTexture creates an immutable 2D texture the pixel shaders can sample, from the width, height, number of mip
+	levels and format of the top level and the contents of every level.*/
+	virtual bool CreateTexture(unsigned int, unsigned int, unsigned int, RenderFormat, const RenderTextureData*, RenderTexture&) = 0;
+	virtual void ReleaseTexture(RenderTexture) = 0;
+
+	/*CompileShader returns false with an empty error string when the file could not be found at all, and false with
+	the compiler output in the error string when the shader did not compile. The defines may be null.*/
+	virtual bool CompileShader(const WCHAR*, const char*, const char*, const RenderShaderDefine*, std::vector<char>&, std::string&) = 0;
+	/*ReflectShader reads the constant buffers and vertex inputs out of bytecode from CompileShader. GetShaderCompiler
+	names the compiler and its settings, bytecode from one compiler means nothing to another so shader caches keep them
+	apart by it.*/
+	virtual bool ReflectShader(const void*, size_t, RenderShaderReflection&) = 0;
+	virtual const char* GetShaderCompiler() = 0;
+	virtual bool CreateVertexShader(const void*, size_t, RenderVertexShader&) = 0;
+	virtual bool CreatePixelShader(const void*, size_t, RenderPixelShader&) = 0;
+	virtual bool CreateInputLayout(const RenderInputElement*, unsigned int, const void*, size_t, RenderInputLayout&) = 0;
+	virtual void ReleaseVertexShader(RenderVertexShader) = 0;
+	virtual void ReleasePixelShader(RenderPixelShader) = 0;
+	virtual void ReleaseInputLayout(RenderInputLayout) = 0;
+
+	/*CreateDeferredContext creates a context another thread can record a command list on while the immediate context
+	(GetContext) is busy, the same as ID3D11DeviceContext deferred contexts. A context is only ever used by one thread at
+	a time. Every command list starts with the render target, viewport and states of the frame and nothing else bound,
+	so the calls recorded on it must bind everything they use.*/
+	virtual bool CreateDeferredContext(RenderContextClass*&) = 0;
+	virtual void ReleaseDeferredContext(RenderContextClass*) = 0;
+	virtual void ReleaseCommandList(RenderCommandList) = 0;
+};
+
+#endif
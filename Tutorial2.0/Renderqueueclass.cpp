@@ -0,0 +1,585 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: renderqueueclass.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "renderqueueclass.h"
+#include "profilerclass.h"
+#include <string.h>
+
+
+/////////////
+// GLOBALS //
+/////////////
+/*The width of each field of the sort key, the shifts follow from them.*/
+static const int SORT_SHADER_BITS = 12;
+static const int SORT_PIXEL_SHADER_BITS = 6;
+static const int SORT_LAYOUT_BITS = 8;
+static const int SORT_VERTEX_BUFFER_BITS = 12;
+static const int SORT_INDEX_BUFFER_BITS = 12;
+static const int SORT_DEPTH_BITS = 20;
+
+static const int SORT_INDEX_BUFFER_SHIFT = SORT_DEPTH_BITS;
+static const int SORT_VERTEX_BUFFER_SHIFT = SORT_INDEX_BUFFER_SHIFT + SORT_INDEX_BUFFER_BITS;
+static const int SORT_LAYOUT_SHIFT = SORT_VERTEX_BUFFER_SHIFT + SORT_VERTEX_BUFFER_BITS;
+static const int SORT_SHADER_SHIFT = SORT_LAYOUT_SHIFT + SORT_LAYOUT_BITS;
+
+
+RenderQueueClass::RenderQueueClass()
+{
+	m_maxDepth = 1.0f;
+	memset(&m_statistics, 0, sizeof(m_statistics));
+	m_device = 0;
+	m_constantAllocator = 0;
+	m_bucketCount = 0;
+}
+
+RenderQueueClass::RenderQueueClass(const RenderQueueClass& other)
+{
+}
+
+RenderQueueClass::~RenderQueueClass()
+{
+}
+
+/*Initialize reserves room for maxCommands commands so a normal frame doesn't allocate. Depths are stored relative to
+maxDepth, anything further away sorts as if it were at maxDepth.*/
+bool RenderQueueClass::Initialize(int maxCommands, float maxDepth)
+{
+	m_maxDepth = maxDepth;
+
+	m_commands.reserve(maxCommands);
+	m_keys.reserve(maxCommands);
+	m_keysTemp.reserve(maxCommands);
+	m_order.reserve(maxCommands);
+	m_orderTemp.reserve(maxCommands);
+
+	return true;
+}
+
+void RenderQueueClass::Shutdown()
+{
+	size_t i;
+
+	for (i = 0; i < m_deferredContexts.size(); i++)
+	{
+		m_device->ReleaseDeferredContext(m_deferredContexts[i]);
+	}
+	m_deferredContexts.clear();
+	m_device = 0;
+
+	m_commands.clear();
+	m_keys.clear();
+	m_keysTemp.clear();
+	m_order.clear();
+	m_orderTemp.clear();
+	m_vertexShaderIds.clear();
+	m_pixelShaderIds.clear();
+	m_layoutIds.clear();
+	m_bufferIds.clear();
+
+	return;
+}
+
+/*Clear starts a new frame. The memory of the lists is kept, the ids of the objects are handed out anew.*/
+void RenderQueueClass::Clear()
+{
+	m_commands.clear();
+	m_keys.clear();
+	m_order.clear();
+	m_vertexShaderIds.clear();
+	m_pixelShaderIds.clear();
+	m_layoutIds.clear();
+	m_bufferIds.clear();
+
+	return;
+}
+
+/*Submit adds a draw to the queue. depth is the distance from the camera.*/
+void RenderQueueClass::Submit(const RenderCommandType& command, float depth)
+{
+	m_commands.push_back(command);
+	m_keys.push_back(MakeSortKey(command, depth));
+
+	return;
+}
+
+/*Sort orders the commands by their keys with a least significant digit radix sort, eight bits at a time. The
+histograms of all eight digits are counted in one pass, and a digit that is the same in every key is skipped since
+it wouldn't change the order. With one shader and one model most of the key is the same, so usually only the depth
+digits get sorted. The sort is stable, draws with the same key stay in the order they were submitted.*/
+void RenderQueueClass::Sort()
+{
+	PROFILE_FUNCTION();
+
+	unsigned int counts[8][256];
+	unsigned int offsets[256];
+	unsigned int i, count, digit, total, bucket;
+	int pass, shift;
+
+	count = (unsigned int)m_keys.size();
+
+	m_order.resize(count);
+	for (i = 0; i < count; i++)
+	{
+		m_order[i] = i;
+	}
+
+	if (count < 2)
+	{
+		return;
+	}
+
+	m_keysTemp.resize(count);
+	m_orderTemp.resize(count);
+
+	// Count all eight digits at once.
+	memset(counts, 0, sizeof(counts));
+	for (i = 0; i < count; i++)
+	{
+		for (pass = 0; pass < 8; pass++)
+		{
+			counts[pass][(m_keys[i] >> (pass * 8)) & 0xff]++;
+		}
+	}
+
+	for (pass = 0; pass < 8; pass++)
+	{
+		shift = pass * 8;
+
+		// Skip the digit when every key has the same value in it.
+		if (counts[pass][(m_keys[0] >> shift) & 0xff] == count)
+		{
+			continue;
+		}
+
+		// Turn the counts into the first position of each bucket.
+		total = 0;
+		for (bucket = 0; bucket < 256; bucket++)
+		{
+			offsets[bucket] = total;
+			total += counts[pass][bucket];
+		}
+
+		// Move the keys and their command numbers into place.
+		for (i = 0; i < count; i++)
+		{
+			digit = (unsigned int)((m_keys[i] >> shift) & 0xff);
+			m_keysTemp[offsets[digit]] = m_keys[i];
+			m_orderTemp[offsets[digit]] = m_order[i];
+			offsets[digit]++;
+		}
+
+		m_keys.swap(m_keysTemp);
+		m_order.swap(m_orderTemp);
+	}
+
+	return;
+}
+
+/*Execute issues the sorted commands. It remembers everything it bound during the frame and skips a bind when the same
+object is bound already. Nothing is assumed about what was bound before the queue started. The constants must be
+uploaded already, each command's slices are bound through the allocator.*/
+void RenderQueueClass::Execute(RenderContextClass* deviceContext, ConstantAllocatorClass* constantAllocator)
+{
+	PROFILE_FUNCTION();
+
+	memset(&m_statistics, 0, sizeof(m_statistics));
+
+	ExecuteRange(deviceContext, constantAllocator, 0, (unsigned int)m_order.size(), m_statistics);
+
+	return;
+}
+
+/*InitializeDeferredContexts creates the deferred contexts ExecuteParallel records on, one for every thread that will
+record, so usually the job threads plus the calling thread.*/
+bool RenderQueueClass::InitializeDeferredContexts(RenderDeviceClass* device, int contextCount)
+{
+	RenderContextClass* context;
+	int i;
+	bool result;
+
+	m_device = device;
+
+	for (i = 0; i < contextCount; i++)
+	{
+		result = m_device->CreateDeferredContext(context);
+		if (!result)
+		{
+			return false;
+		}
+
+		m_deferredContexts.push_back(context);
+	}
+
+	m_commandLists.reserve(contextCount);
+	m_bucketStatistics.reserve(contextCount);
+
+	return true;
+}
+
+/*ExecuteParallel issues the sorted commands like Execute, but records them on up to bucketCount deferred contexts at
+once. Without a job system, with too few commands for two buckets or when the allocator can't bind its slices on a
+deferred context it just calls Execute. When one of the command lists can't be finished,
+none of them is executed and the commands are issued with Execute after all, so the frame is always complete; it
+returns false then.*/
+bool RenderQueueClass::ExecuteParallel(RenderContextClass* deviceContext, ConstantAllocatorClass* constantAllocator, JobSystemClass* jobSystem, int bucketCount)
+{
+	PROFILE_FUNCTION();
+
+	int i, count;
+
+	count = (int)m_order.size();
+	if (bucketCount > (int)m_deferredContexts.size())
+	{
+		bucketCount = (int)m_deferredContexts.size();
+	}
+	if (bucketCount > count / RENDER_QUEUE_MIN_BUCKET_SIZE)
+	{
+		bucketCount = count / RENDER_QUEUE_MIN_BUCKET_SIZE;
+	}
+
+	if (bucketCount < 2 || !jobSystem || !constantAllocator->BindsRanges())
+	{
+		Execute(deviceContext, constantAllocator);
+		return true;
+	}
+
+	m_constantAllocator = constantAllocator;
+	m_bucketCount = bucketCount;
+	m_commandLists.assign(bucketCount, 0);
+	m_bucketStatistics.resize(bucketCount);
+
+	// Every bucket is a batch of its own, whichever thread is free records the next one.
+	jobSystem->ParallelFor(bucketCount, 1, RecordBuckets, this);
+
+	for (i = 0; i < bucketCount; i++)
+	{
+		if (!m_commandLists[i])
+		{
+			ReleaseCommandLists();
+			Execute(deviceContext, constantAllocator);
+			return false;
+		}
+	}
+
+	// Play the lists back in bucket order, which is the sorted order.
+	memset(&m_statistics, 0, sizeof(m_statistics));
+	for (i = 0; i < bucketCount; i++)
+	{
+		deviceContext->ExecuteCommandList(m_commandLists[i]);
+		AddStatistics(m_statistics, m_bucketStatistics[i]);
+	}
+
+	ReleaseCommandLists();
+
+	return true;
+}
+
+int RenderQueueClass::GetDeferredContextCount()
+{
+	return (int)m_deferredContexts.size();
+}
+
+/*ExecuteRange issues the sorted commands from begin up to end on one context, starting with nothing bound.*/
+void RenderQueueClass::ExecuteRange(RenderContextClass* deviceContext, ConstantAllocatorClass* constantAllocator, unsigned int begin, unsigned int end,
+	RenderQueueStatisticsType& statistics)
+{
+	RenderVertexShader currentVertexShader;
+	RenderPixelShader currentPixelShader;
+	RenderInputLayout currentLayout;
+	RenderTopology currentTopology;
+	RenderBuffer currentVertexBuffers[RENDER_COMMAND_VERTEX_BUFFERS];
+	unsigned int currentStrides[RENDER_COMMAND_VERTEX_BUFFERS];
+	RenderBuffer currentIndexBuffer;
+	RenderFormat currentIndexFormat;
+	unsigned int currentConstantOffsets[RENDER_COMMAND_CONSTANT_BUFFERS];
+	unsigned int currentConstantSizes[RENDER_COMMAND_CONSTANT_BUFFERS];
+	bool topologySet;
+	unsigned int i, offset;
+	int slot;
+	RenderCommandType* command;
+
+	currentVertexShader = 0;
+	currentPixelShader = 0;
+	currentLayout = 0;
+	currentTopology = RENDER_TOPOLOGY_TRIANGLELIST;
+	topologySet = false;
+	for (slot = 0; slot < RENDER_COMMAND_VERTEX_BUFFERS; slot++)
+	{
+		currentVertexBuffers[slot] = 0;
+		currentStrides[slot] = 0;
+	}
+	currentIndexBuffer = 0;
+	currentIndexFormat = RENDER_FORMAT_UNKNOWN;
+	for (slot = 0; slot < RENDER_COMMAND_CONSTANT_BUFFERS; slot++)
+	{
+		currentConstantOffsets[slot] = 0;
+		currentConstantSizes[slot] = 0;
+	}
+
+	offset = 0;
+
+	for (i = begin; i < end; i++)
+	{
+		command = &m_commands[m_order[i]];
+
+		// Bind the shaders.
+		if (command->vertexShader != currentVertexShader)
+		{
+			deviceContext->VSSetShader(command->vertexShader);
+			currentVertexShader = command->vertexShader;
+			statistics.shaderBinds++;
+		}
+		else
+		{
+			statistics.shaderBindsElided++;
+		}
+
+		if (command->pixelShader != currentPixelShader)
+		{
+			deviceContext->PSSetShader(command->pixelShader);
+			currentPixelShader = command->pixelShader;
+			statistics.shaderBinds++;
+		}
+		else
+		{
+			statistics.shaderBindsElided++;
+		}
+
+		// Bind the input layout and topology.
+		if (command->inputLayout != currentLayout)
+		{
+			deviceContext->IASetInputLayout(command->inputLayout);
+			currentLayout = command->inputLayout;
+			statistics.inputLayoutBinds++;
+		}
+		else
+		{
+			statistics.inputLayoutBindsElided++;
+		}
+
+		if (!topologySet || command->topology != currentTopology)
+		{
+			deviceContext->IASetPrimitiveTopology(command->topology);
+			currentTopology = command->topology;
+			topologySet = true;
+			statistics.topologyBinds++;
+		}
+		else
+		{
+			statistics.topologyBindsElided++;
+		}
+
+		// Bind the vertex buffers, slot by slot. An empty slot is left alone.
+		for (slot = 0; slot < RENDER_COMMAND_VERTEX_BUFFERS; slot++)
+		{
+			if (!command->vertexBuffers[slot])
+			{
+				continue;
+			}
+
+			if (command->vertexBuffers[slot] != currentVertexBuffers[slot] || command->strides[slot] != currentStrides[slot])
+			{
+				deviceContext->IASetVertexBuffers(slot, 1, &command->vertexBuffers[slot], &command->strides[slot], &offset);
+				currentVertexBuffers[slot] = command->vertexBuffers[slot];
+				currentStrides[slot] = command->strides[slot];
+				statistics.vertexBufferBinds++;
+			}
+			else
+			{
+				statistics.vertexBufferBindsElided++;
+			}
+		}
+
+		// Bind the index buffer.
+		if (command->indexBuffer != currentIndexBuffer || command->indexFormat != currentIndexFormat)
+		{
+			deviceContext->IASetIndexBuffer(command->indexBuffer, command->indexFormat, 0);
+			currentIndexBuffer = command->indexBuffer;
+			currentIndexFormat = command->indexFormat;
+			statistics.indexBufferBinds++;
+		}
+		else
+		{
+			statistics.indexBufferBindsElided++;
+		}
+
+		// Bind the constant slices of the command, slot by slot.
+		for (slot = 0; slot < RENDER_COMMAND_CONSTANT_BUFFERS; slot++)
+		{
+			if (command->constantSizes[slot] == 0)
+			{
+				continue;
+			}
+
+			if (command->constantOffsets[slot] != currentConstantOffsets[slot] || command->constantSizes[slot] != currentConstantSizes[slot])
+			{
+				constantAllocator->BindSlice(deviceContext, slot, command->constantOffsets[slot], command->constantSizes[slot]);
+				currentConstantOffsets[slot] = command->constantOffsets[slot];
+				currentConstantSizes[slot] = command->constantSizes[slot];
+				statistics.constantBufferBinds++;
+			}
+			else
+			{
+				statistics.constantBufferBindsElided++;
+			}
+		}
+
+		// Draw.
+		if (command->instanceCount > 0)
+		{
+			deviceContext->DrawIndexedInstanced(command->indexCount, command->instanceCount, command->startIndex, 0, 0);
+		}
+		else
+		{
+			deviceContext->DrawIndexed(command->indexCount, command->startIndex, 0);
+		}
+
+		statistics.commands++;
+	}
+
+	return;
+}
+
+int RenderQueueClass::GetCommandCount()
+{
+	return (int)m_commands.size();
+}
+
+/*GetSortKey returns the key at the given position, after Sort that is in sorted order.*/
+unsigned long long RenderQueueClass::GetSortKey(int index)
+{
+	return m_keys[index];
+}
+
+RenderQueueStatisticsType RenderQueueClass::GetStatistics()
+{
+	return m_statistics;
+}
+
+void RenderQueueClass::ReleaseCommandLists()
+{
+	size_t i;
+
+	for (i = 0; i < m_commandLists.size(); i++)
+	{
+		m_device->ReleaseCommandList(m_commandLists[i]);
+		m_commandLists[i] = 0;
+	}
+
+	return;
+}
+
+/*RecordBuckets is run by the job system, it records the buckets from begin up to end, each on its own deferred
+context. The buckets split the sorted commands evenly.*/
+void RenderQueueClass::RecordBuckets(void* data, int begin, int end)
+{
+	PROFILE_FUNCTION();
+
+	RenderQueueClass* queue;
+	RenderContextClass* context;
+	unsigned long long count;
+	unsigned int first, last;
+	int bucket;
+
+	queue = (RenderQueueClass*)data;
+	count = queue->m_order.size();
+
+	for (bucket = begin; bucket < end; bucket++)
+	{
+		first = (unsigned int)(count * bucket / queue->m_bucketCount);
+		last = (unsigned int)(count * (bucket + 1) / queue->m_bucketCount);
+		context = queue->m_deferredContexts[bucket];
+
+		memset(&queue->m_bucketStatistics[bucket], 0, sizeof(RenderQueueStatisticsType));
+		queue->ExecuteRange(context, queue->m_constantAllocator, first, last, queue->m_bucketStatistics[bucket]);
+
+		if (!context->FinishCommandList(queue->m_commandLists[bucket]))
+		{
+			queue->m_commandLists[bucket] = 0;
+		}
+	}
+
+	return;
+}
+
+void RenderQueueClass::AddStatistics(RenderQueueStatisticsType& total, const RenderQueueStatisticsType& statistics)
+{
+	total.commands += statistics.commands;
+	total.shaderBinds += statistics.shaderBinds;
+	total.shaderBindsElided += statistics.shaderBindsElided;
+	total.inputLayoutBinds += statistics.inputLayoutBinds;
+	total.inputLayoutBindsElided += statistics.inputLayoutBindsElided;
+	total.topologyBinds += statistics.topologyBinds;
+	total.topologyBindsElided += statistics.topologyBindsElided;
+	total.vertexBufferBinds += statistics.vertexBufferBinds;
+	total.vertexBufferBindsElided += statistics.vertexBufferBindsElided;
+	total.indexBufferBinds += statistics.indexBufferBinds;
+	total.indexBufferBindsElided += statistics.indexBufferBindsElided;
+	total.constantBufferBinds += statistics.constantBufferBinds;
+	total.constantBufferBindsElided += statistics.constantBufferBindsElided;
+
+	return;
+}
+
+/*MakeSortKey packs the ids of the state of a command and its quantized depth into one number.*/
+unsigned long long RenderQueueClass::MakeSortKey(const RenderCommandType& command, float depth)
+{
+	unsigned long long key, shader, layout, vertexBuffer, indexBuffer, quantizedDepth;
+	float depthFraction;
+
+	// The shader field holds both shaders, six bits each.
+	shader = GetObjectId(m_vertexShaderIds, command.vertexShader, SORT_SHADER_BITS - SORT_PIXEL_SHADER_BITS) << SORT_PIXEL_SHADER_BITS;
+	shader |= GetObjectId(m_pixelShaderIds, command.pixelShader, SORT_PIXEL_SHADER_BITS);
+	layout = GetObjectId(m_layoutIds, command.inputLayout, SORT_LAYOUT_BITS);
+	vertexBuffer = GetObjectId(m_bufferIds, command.vertexBuffers[0], SORT_VERTEX_BUFFER_BITS);
+	indexBuffer = GetObjectId(m_bufferIds, command.indexBuffer, SORT_INDEX_BUFFER_BITS);
+
+	// Quantize the depth between the camera and the maximum depth.
+	depthFraction = depth / m_maxDepth;
+	if (depthFraction < 0.0f)
+	{
+		depthFraction = 0.0f;
+	}
+	if (depthFraction > 1.0f)
+	{
+		depthFraction = 1.0f;
+	}
+	quantizedDepth = (unsigned long long)(depthFraction * (float)((1 << SORT_DEPTH_BITS) - 1));
+
+	key = (shader & ((1ull << SORT_SHADER_BITS) - 1)) << SORT_SHADER_SHIFT;
+	key |= (layout & ((1ull << SORT_LAYOUT_BITS) - 1)) << SORT_LAYOUT_SHIFT;
+	key |= (vertexBuffer & ((1ull << SORT_VERTEX_BUFFER_BITS) - 1)) << SORT_VERTEX_BUFFER_SHIFT;
+	key |= (indexBuffer & ((1ull << SORT_INDEX_BUFFER_BITS) - 1)) << SORT_INDEX_BUFFER_SHIFT;
+	key |= quantizedDepth;
+
+	return key;
+}
+
+/*GetObjectId returns the small id of a render object, handing out the next free one the first time it is seen. Id 0
+is kept for "nothing bound". The id fits in the given number of bits, the objects that don't get one of their own all
+get the highest id.*/
+unsigned int RenderQueueClass::GetObjectId(unordered_map<const void*, unsigned int>& ids, const void* object, int bits)
+{
+	unordered_map<const void*, unsigned int>::iterator found;
+	unsigned int id;
+
+	if (!object)
+	{
+		return 0;
+	}
+
+	found = ids.find(object);
+	if (found != ids.end())
+	{
+		return found->second;
+	}
+
+	id = (unsigned int)ids.size() + 1;
+	if (id > (1u << bits) - 1)
+	{
+		id = (1u << bits) - 1;
+	}
+	ids[object] = id;
+
+	return id;
+}
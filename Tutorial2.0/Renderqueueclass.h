@@ -0,0 +1,144 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: renderqueueclass.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _RENDERQUEUECLASS_H_
+#define _RENDERQUEUECLASS_H_
+
+
+//////////////
+// INCLUDES //
+//////////////
+#include <unordered_map>
+#include <vector>
+#include "renderdeviceclass.h"
+#include "constantallocatorclass.h"
+#include "jobsystemclass.h"
+using namespace std;
+
+
+/////////////
+// GLOBALS //
+/////////////
+const int RENDER_COMMAND_VERTEX_BUFFERS = 2;
+const int RENDER_COMMAND_CONSTANT_BUFFERS = 2;
+/*ExecuteParallel gives every deferred context at least this many commands, fewer aren't worth a command list.*/
+const int RENDER_QUEUE_MIN_BUCKET_SIZE = 256;
+
+
+/////////////
+// TYPEDEFS //
+/////////////
+/*Everything one draw needs bound. The model, the instance batch and the shader each fill in their part with their
+FillCommand function. A command with an instanceCount of zero is drawn with DrawIndexed, otherwise it is instanced.
+The constants of a command live in the constant allocator of the frame, the command only holds the byte offset and size of
+the slice to bind to each vertex shader slot. A size of zero leaves the slot alone. The indices start at startIndex, a
+model puts the range of the level of detail it is drawn with there.*/
+struct RenderCommandType
+{
+	RenderVertexShader vertexShader;
+	RenderPixelShader pixelShader;
+	RenderInputLayout inputLayout;
+	RenderTopology topology;
+	RenderBuffer vertexBuffers[RENDER_COMMAND_VERTEX_BUFFERS];
+	unsigned int strides[RENDER_COMMAND_VERTEX_BUFFERS];
+	RenderBuffer indexBuffer;
+	RenderFormat indexFormat;
+	unsigned int constantOffsets[RENDER_COMMAND_CONSTANT_BUFFERS];
+	unsigned int constantSizes[RENDER_COMMAND_CONSTANT_BUFFERS];
+	unsigned int startIndex;
+	unsigned int indexCount;
+	unsigned int instanceCount;
+};
+
+/*How many binds the last Execute issued and how many it skipped because the same thing was bound already. After
+ExecuteParallel these are the totals of all buckets.*/
+struct RenderQueueStatisticsType
+{
+	int commands;
+	int shaderBinds;
+	int shaderBindsElided;
+	int inputLayoutBinds;
+	int inputLayoutBindsElided;
+	int topologyBinds;
+	int topologyBindsElided;
+	int vertexBufferBinds;
+	int vertexBufferBindsElided;
+	int indexBufferBinds;
+	int indexBufferBindsElided;
+	int constantBufferBinds;
+	int constantBufferBindsElided;
+};
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: RenderQueueClass
+////////////////////////////////////////////////////////////////////////////////
+/*The RenderQueueClass collects the draws of a frame instead of issuing them right away. Every command gets a 64 bit
+sort key, from the most to the least significant bits:
+
+	shader (12 bits) | input layout (8) | vertex buffer (12) | index buffer (12) | depth (20)
+
+so sorting the keys puts draws with the same shader next to each other, then the same layout and buffers, and those
+front to back. The queue is radix sorted once per frame and then walked while remembering what is bound, so a shader,
+layout or buffer that is already bound is not bound again. The ids in the key are small numbers the queue hands out
+to every object it sees in a frame, the vertex and the pixel shader six bits each from ids of their own. They start
+over with every Clear, so an object that is released can't leave its id to a new one at the same address. When a
+frame has more objects than a field has bits for, the rest share the last id, which only makes the sort less perfect.
+
+The constants of the commands (the shader parameters) are written into a ConstantAllocatorClass while submitting and
+uploaded once before Execute, which binds each command's slices. Commands that share a slice, like the per frame
+matrices, only bind it once.
+
+ExecuteParallel records the same thing on several threads. The sorted commands are cut into as many contiguous buckets
+as there are deferred contexts, each bucket is recorded into a command list of its own by a job of the job system and the
+calling thread then only executes the lists in bucket order, so the draws reach the GPU in exactly the sorted order. A
+deferred context starts without anything bound, so every bucket binds what its first command needs again; that costs
+a few binds per bucket and nothing else changes.*/
+class RenderQueueClass
+{
+public:
+	RenderQueueClass();
+	RenderQueueClass(const RenderQueueClass&);
+	~RenderQueueClass();
+
+	bool Initialize(int, float);
+	void Shutdown();
+
+	void Clear();
+	void Submit(const RenderCommandType&, float);
+	void Sort();
+	void Execute(RenderContextClass*, ConstantAllocatorClass*);
+
+	bool InitializeDeferredContexts(RenderDeviceClass*, int);
+	bool ExecuteParallel(RenderContextClass*, ConstantAllocatorClass*, JobSystemClass*, int);
+	int GetDeferredContextCount();
+
+	int GetCommandCount();
+	unsigned long long GetSortKey(int);
+	RenderQueueStatisticsType GetStatistics();
+
+private:
+	void ExecuteRange(RenderContextClass*, ConstantAllocatorClass*, unsigned int, unsigned int, RenderQueueStatisticsType&);
+	void ReleaseCommandLists();
+	static void RecordBuckets(void*, int, int);
+	static void AddStatistics(RenderQueueStatisticsType&, const RenderQueueStatisticsType&);
+	unsigned long long MakeSortKey(const RenderCommandType&, float);
+	static unsigned int GetObjectId(unordered_map<const void*, unsigned int>&, const void*, int);
+
+private:
+	vector<RenderCommandType> m_commands;
+	vector<unsigned long long> m_keys, m_keysTemp;
+	vector<unsigned int> m_order, m_orderTemp;
+	unordered_map<const void*, unsigned int> m_vertexShaderIds, m_pixelShaderIds, m_layoutIds, m_bufferIds;
+	float m_maxDepth;
+	RenderQueueStatisticsType m_statistics;
+
+	RenderDeviceClass* m_device;
+	vector<RenderContextClass*> m_deferredContexts;
+	vector<RenderCommandList> m_commandLists;
+	vector<RenderQueueStatisticsType> m_bucketStatistics;
+	ConstantAllocatorClass* m_constantAllocator;
+	int m_bucketCount;
+};
+
+#endif
@@ -0,0 +1,420 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: scenegraphclass.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "scenegraphclass.h"
+#include "profilerclass.h"
+#include <string.h>
+
+SceneGraphClass::SceneGraphClass()
+{
+	m_levelStarts.push_back(0);
+	m_updateCount = 0;
+	m_sorted = true;
+	memset(&m_statistics, 0, sizeof(m_statistics));
+}
+
+SceneGraphClass::SceneGraphClass(const SceneGraphClass& other)
+{
+}
+
+SceneGraphClass::~SceneGraphClass()
+{
+}
+
+/*Initialize reserves room for the given number of nodes, so building the scene doesn't move the arrays around.*/
+bool SceneGraphClass::Initialize(int capacity)
+{
+	Clear();
+
+	if (capacity > 0)
+	{
+		m_positions.reserve(capacity);
+		m_rotations.reserve(capacity);
+		m_scales.reserve(capacity);
+		m_parents.reserve(capacity);
+		m_worldMatrices.reserve(capacity);
+		m_dirty.reserve(capacity);
+		m_changedUpdates.reserve(capacity);
+		m_depths.reserve(capacity);
+		m_indices.reserve(capacity);
+		m_handles.reserve(capacity);
+	}
+
+	return true;
+}
+
+void SceneGraphClass::Shutdown()
+{
+	Clear();
+
+	return;
+}
+
+/*Clear removes every node, the handles handed out so far are no longer good.*/
+void SceneGraphClass::Clear()
+{
+	m_positions.clear();
+	m_rotations.clear();
+	m_scales.clear();
+	m_parents.clear();
+	m_worldMatrices.clear();
+	m_dirty.clear();
+	m_changedUpdates.clear();
+	m_depths.clear();
+	m_indices.clear();
+	m_handles.clear();
+	m_levelStarts.clear();
+	m_levelStarts.push_back(0);
+	m_levelDirty.clear();
+	m_sorted = true;
+	memset(&m_statistics, 0, sizeof(m_statistics));
+
+	return;
+}
+
+/*AddNode adds a node under the parent, or in the world when the parent is -1, and returns its handle. It returns -1
+when the parent doesn't exist. A node that goes in the deepest level or one below it is simply put at the end, so a
+scene built parents first level by level never has to be sorted.*/
+int SceneGraphClass::AddNode(int parent, const XMFLOAT3& position, const XMFLOAT4& rotation, const XMFLOAT3& scale)
+{
+	XMFLOAT4X4 identity;
+	int parentIndex, depth, levelCount, handle;
+
+	if (parent >= (int)m_indices.size() || parent < -1)
+	{
+		return -1;
+	}
+
+	parentIndex = parent < 0 ? -1 : m_indices[parent];
+	depth = parentIndex < 0 ? 0 : m_depths[parentIndex] + 1;
+	XMStoreFloat4x4(&identity, XMMatrixIdentity());
+
+	handle = (int)m_indices.size();
+	m_indices.push_back((int)m_positions.size());
+	m_handles.push_back(handle);
+	m_positions.push_back(position);
+	m_rotations.push_back(rotation);
+	m_scales.push_back(scale);
+	m_parents.push_back(parentIndex);
+	m_worldMatrices.push_back(identity);
+	m_dirty.push_back(1);
+	m_changedUpdates.push_back(0);
+	m_depths.push_back(depth);
+
+	if (m_sorted)
+	{
+		levelCount = (int)m_levelStarts.size() - 1;
+		if (depth == levelCount - 1)
+		{
+			m_levelStarts.back() = (int)m_positions.size();
+			m_levelDirty[depth]++;
+		}
+		else if (depth == levelCount)
+		{
+			m_levelStarts.push_back((int)m_positions.size());
+			m_levelDirty.push_back(1);
+		}
+		else
+		{
+			m_sorted = false;
+		}
+	}
+
+	return handle;
+}
+
+void SceneGraphClass::SetPosition(int node, const XMFLOAT3& position)
+{
+	m_positions[m_indices[node]] = position;
+	MarkDirty(m_indices[node]);
+
+	return;
+}
+
+/*SetRotation takes a normalized quaternion.*/
+void SceneGraphClass::SetRotation(int node, const XMFLOAT4& rotation)
+{
+	m_rotations[m_indices[node]] = rotation;
+	MarkDirty(m_indices[node]);
+
+	return;
+}
+
+void SceneGraphClass::SetScale(int node, const XMFLOAT3& scale)
+{
+	m_scales[m_indices[node]] = scale;
+	MarkDirty(m_indices[node]);
+
+	return;
+}
+
+XMFLOAT3 SceneGraphClass::GetPosition(int node)
+{
+	return m_positions[m_indices[node]];
+}
+
+XMFLOAT4 SceneGraphClass::GetRotation(int node)
+{
+	return m_rotations[m_indices[node]];
+}
+
+XMFLOAT3 SceneGraphClass::GetScale(int node)
+{
+	return m_scales[m_indices[node]];
+}
+
+/*GetParent returns the handle of the parent of the node, -1 for a node in the world.*/
+int SceneGraphClass::GetParent(int node)
+{
+	int parentIndex;
+
+	parentIndex = m_parents[m_indices[node]];
+
+	return parentIndex < 0 ? -1 : m_handles[parentIndex];
+}
+
+/*Update rebuilds the world matrices that changed, level by level, see the class. The levels that are big enough are
+split over the job system when there is one.*/
+void SceneGraphClass::Update(JobSystemClass* jobSystem)
+{
+	PROFILE_FUNCTION();
+
+	LevelUpdateType levelUpdate;
+	int level, levelCount, begin, end, updated;
+	bool previousChanged;
+
+	if (!m_sorted)
+	{
+		Sort();
+	}
+
+	m_updateCount++;
+	memset(&m_statistics, 0, sizeof(m_statistics));
+
+	levelCount = (int)m_levelStarts.size() - 1;
+	previousChanged = false;
+	for (level = 0; level < levelCount; level++)
+	{
+		m_statistics.levels++;
+
+		// Nothing in this level is dirty and no parent moved, so none of it can have changed.
+		if (m_levelDirty[level] == 0 && !previousChanged)
+		{
+			m_statistics.skippedLevels++;
+			continue;
+		}
+
+		begin = m_levelStarts[level];
+		end = m_levelStarts[level + 1];
+		if (jobSystem && end - begin >= SCENE_PARALLEL_MIN_NODES)
+		{
+			levelUpdate.scene = this;
+			levelUpdate.begin = begin;
+			levelUpdate.updated = 0;
+			jobSystem->ParallelFor(end - begin, SCENE_BATCH_SIZE, UpdateLevelRange, &levelUpdate);
+			updated = levelUpdate.updated.load(memory_order_relaxed);
+			m_statistics.parallelLevels++;
+		}
+		else
+		{
+			updated = UpdateNodes(begin, end);
+		}
+
+		m_levelDirty[level] = 0;
+		m_statistics.updatedNodes += updated;
+		previousChanged = updated > 0;
+	}
+
+	return;
+}
+
+/*GetWorldMatrix returns the world matrix of the node as of the last Update.*/
+const XMFLOAT4X4& SceneGraphClass::GetWorldMatrix(int node)
+{
+	return m_worldMatrices[m_indices[node]];
+}
+
+/*IsWorldChanged is true when the last Update rebuilt the world matrix of the node.*/
+bool SceneGraphClass::IsWorldChanged(int node)
+{
+	return m_updateCount > 0 && m_changedUpdates[m_indices[node]] == m_updateCount;
+}
+
+int SceneGraphClass::GetNodeCount()
+{
+	return (int)m_positions.size();
+}
+
+int SceneGraphClass::GetLevelCount()
+{
+	if (!m_sorted)
+	{
+		Sort();
+	}
+
+	return (int)m_levelStarts.size() - 1;
+}
+
+SceneStatisticsType SceneGraphClass::GetStatistics()
+{
+	return m_statistics;
+}
+
+/*MarkDirty flags the node at the index for the next Update and counts it for its level.*/
+void SceneGraphClass::MarkDirty(int index)
+{
+	if (m_dirty[index])
+	{
+		return;
+	}
+
+	m_dirty[index] = 1;
+	if (m_sorted)
+	{
+		m_levelDirty[m_depths[index]]++;
+	}
+
+	return;
+}
+
+/*Sort puts the nodes in order of their depth with a counting sort. It keeps the order of the nodes within a level, so
+siblings stay next to each other the way they were added.*/
+void SceneGraphClass::Sort()
+{
+	PROFILE_FUNCTION();
+
+	vector<int> newIndices, starts, newParents, newDepths, newHandles;
+	vector<XMFLOAT3> newPositions, newScales;
+	vector<XMFLOAT4> newRotations;
+	vector<XMFLOAT4X4> newWorldMatrices;
+	vector<unsigned char> newDirty;
+	vector<unsigned int> newChangedUpdates;
+	int count, levelCount, i, index;
+
+	count = (int)m_positions.size();
+
+	// Count the nodes of every level, the levels start one after the other.
+	levelCount = 0;
+	for (i = 0; i < count; i++)
+	{
+		if (m_depths[i] + 1 > levelCount)
+		{
+			levelCount = m_depths[i] + 1;
+		}
+	}
+	starts.assign(levelCount + 1, 0);
+	for (i = 0; i < count; i++)
+	{
+		starts[m_depths[i] + 1]++;
+	}
+	for (i = 0; i < levelCount; i++)
+	{
+		starts[i + 1] += starts[i];
+	}
+	m_levelStarts = starts;
+
+	newIndices.resize(count);
+	for (i = 0; i < count; i++)
+	{
+		newIndices[i] = starts[m_depths[i]];
+		starts[m_depths[i]]++;
+	}
+
+	// Move every array over to the new order.
+	newPositions.resize(count);
+	newRotations.resize(count);
+	newScales.resize(count);
+	newParents.resize(count);
+	newWorldMatrices.resize(count);
+	newDirty.resize(count);
+	newChangedUpdates.resize(count);
+	newDepths.resize(count);
+	newHandles.resize(count);
+	for (i = 0; i < count; i++)
+	{
+		index = newIndices[i];
+		newPositions[index] = m_positions[i];
+		newRotations[index] = m_rotations[i];
+		newScales[index] = m_scales[i];
+		newParents[index] = m_parents[i] < 0 ? -1 : newIndices[m_parents[i]];
+		newWorldMatrices[index] = m_worldMatrices[i];
+		newDirty[index] = m_dirty[i];
+		newChangedUpdates[index] = m_changedUpdates[i];
+		newDepths[index] = m_depths[i];
+		newHandles[index] = m_handles[i];
+		m_indices[m_handles[i]] = index;
+	}
+	m_positions.swap(newPositions);
+	m_rotations.swap(newRotations);
+	m_scales.swap(newScales);
+	m_parents.swap(newParents);
+	m_worldMatrices.swap(newWorldMatrices);
+	m_dirty.swap(newDirty);
+	m_changedUpdates.swap(newChangedUpdates);
+	m_depths.swap(newDepths);
+	m_handles.swap(newHandles);
+
+	m_levelDirty.assign(levelCount, 0);
+	for (i = 0; i < count; i++)
+	{
+		if (m_dirty[i])
+		{
+			m_levelDirty[m_depths[i]]++;
+		}
+	}
+
+	m_sorted = true;
+
+	return;
+}
+
+/*UpdateNodes rebuilds the world matrices of the dirty nodes in [begin, end) and of those whose parent was rebuilt in
+this update, and returns how many it rebuilt. The nodes of one level only write their own slots, so the ranges of a
+level can run on different threads.*/
+int SceneGraphClass::UpdateNodes(int begin, int end)
+{
+	XMMATRIX worldMatrix;
+	unsigned int update;
+	int i, parent, updated;
+
+	update = m_updateCount;
+	updated = 0;
+	for (i = begin; i < end; i++)
+	{
+		parent = m_parents[i];
+		if (!m_dirty[i] && (parent < 0 || m_changedUpdates[parent] != update))
+		{
+			continue;
+		}
+
+		worldMatrix = XMMatrixAffineTransformation(XMLoadFloat3(&m_scales[i]), XMVectorZero(), XMLoadFloat4(&m_rotations[i]),
+			XMLoadFloat3(&m_positions[i]));
+		if (parent >= 0)
+		{
+			worldMatrix = XMMatrixMultiply(worldMatrix, XMLoadFloat4x4(&m_worldMatrices[parent]));
+		}
+		XMStoreFloat4x4(&m_worldMatrices[i], worldMatrix);
+
+		m_dirty[i] = 0;
+		m_changedUpdates[i] = update;
+		updated++;
+	}
+
+	return updated;
+}
+
+/*UpdateLevelRange is the range function of the parallel update, the range counts from the start of the level.*/
+void SceneGraphClass::UpdateLevelRange(void* data, int begin, int end)
+{
+	LevelUpdateType* levelUpdate;
+	int updated;
+
+	levelUpdate = (LevelUpdateType*)data;
+	updated = levelUpdate->scene->UpdateNodes(levelUpdate->begin + begin, levelUpdate->begin + end);
+	if (updated > 0)
+	{
+		levelUpdate->updated.fetch_add(updated, memory_order_relaxed);
+	}
+
+	return;
+}
@@ -0,0 +1,119 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: scenegraphclass.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _SCENEGRAPHCLASS_H_
+#define _SCENEGRAPHCLASS_H_
+
+
+//////////////
+// INCLUDES //
+//////////////
+#include <directxmath.h>
+#include <vector>
+#include "jobsystemclass.h"
+using namespace DirectX;
+using namespace std;
+
+
+/////////////
+// GLOBALS //
+/////////////
+/*Levels with fewer nodes than this are updated on the calling thread, splitting them up costs more than it saves.*/
+const int SCENE_PARALLEL_MIN_NODES = 4096;
+/*How many nodes one job of the parallel update does at most.*/
+const int SCENE_BATCH_SIZE = 1024;
+
+
+/////////////
+// TYPEDEFS //
+/////////////
+/*What the last Update did: how many levels it went through and how many of those it skipped because nothing in them
+could have moved, how many levels were split over the job system and how many world matrices it rebuilt.*/
+struct SceneStatisticsType
+{
+	int levels;
+	int skippedLevels;
+	int parallelLevels;
+	int updatedNodes;
+};
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: SceneGraphClass
+////////////////////////////////////////////////////////////////////////////////
+/*The SceneGraphClass is a hierarchy of transforms. Every node has a position, a rotation quaternion and a scale
+relative to its parent and a world matrix, which is its local matrix times the world matrix of its parent. Nodes
+without a parent are placed in the world.
+
+The nodes are kept as a structure of arrays, one array per field, sorted by their depth in the tree: first all nodes
+without a parent, then all their children, then the children of those. A parent always comes before its children and
+every level is one range of the arrays, so Update is a single pass from front to back over one level at a time. The
+nodes of a level only read the world matrices of the level before, so a big level is split over the job system.
+
+Setting a transform only marks the node dirty. Update rebuilds the world matrix of a dirty node and of every node whose
+parent was rebuilt in the same update, which it tells from the number of the update stored with every node. A level
+with no dirty nodes under a level where nothing changed is skipped without looking at it, so a still scene costs next
+to nothing and a moving branch only costs its own subtree and a look at the levels below it.
+
+A node is known by the handle AddNode returns, which stays the same when the nodes are sorted again. Adding nodes
+sorts them at the next Update.*/
+class SceneGraphClass
+{
+public:
+	SceneGraphClass();
+	SceneGraphClass(const SceneGraphClass&);
+	~SceneGraphClass();
+
+	bool Initialize(int);
+	void Shutdown();
+	void Clear();
+
+	int AddNode(int, const XMFLOAT3&, const XMFLOAT4&, const XMFLOAT3&);
+	void SetPosition(int, const XMFLOAT3&);
+	void SetRotation(int, const XMFLOAT4&);
+	void SetScale(int, const XMFLOAT3&);
+	XMFLOAT3 GetPosition(int);
+	XMFLOAT4 GetRotation(int);
+	XMFLOAT3 GetScale(int);
+	int GetParent(int);
+
+	void Update(JobSystemClass*);
+	const XMFLOAT4X4& GetWorldMatrix(int);
+	bool IsWorldChanged(int);
+
+	int GetNodeCount();
+	int GetLevelCount();
+	SceneStatisticsType GetStatistics();
+
+private:
+	struct LevelUpdateType
+	{
+		SceneGraphClass* scene;
+		int begin;
+		atomic<int> updated;
+	};
+
+	void MarkDirty(int);
+	void Sort();
+	int UpdateNodes(int, int);
+	static void UpdateLevelRange(void*, int, int);
+
+private:
+	vector<XMFLOAT3> m_positions;
+	vector<XMFLOAT4> m_rotations;
+	vector<XMFLOAT3> m_scales;
+	vector<int> m_parents;
+	vector<XMFLOAT4X4> m_worldMatrices;
+	vector<unsigned char> m_dirty;
+	vector<unsigned int> m_changedUpdates;
+	vector<int> m_depths;
+	vector<int> m_indices;
+	vector<int> m_handles;
+	vector<int> m_levelStarts;
+	vector<int> m_levelDirty;
+	unsigned int m_updateCount;
+	bool m_sorted;
+	SceneStatisticsType m_statistics;
+};
+
+#endif
@@ -0,0 +1,934 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: shaderarchiveclass.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "shaderarchiveclass.h"
+#include "profilerclass.h"
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+/////////////
+// GLOBALS //
+/////////////
+static const char SHADER_ARCHIVE_MAGIC[4] = { 'S', 'H', 'P', 'K' };
+
+// Every blob starts on a 16 byte boundary of the file.
+static const unsigned long long SHADER_ARCHIVE_ALIGNMENT = 16;
+
+
+/////////////
+// TYPEDEFS //
+/////////////
+/*A variant Build compiles, and what came out of the compiler for it.*/
+struct ShaderArchiveVariantType
+{
+	int stage;
+	unsigned int mask;
+	vector<char> bytecode;
+	RenderShaderReflection reflection;
+	string errors;
+	bool result;
+};
+
+/*What the workers of Build share: the device to compile with, the description and the variants to compile.*/
+struct ShaderArchiveBuildType
+{
+	RenderDeviceClass* device;
+	const ShaderDescriptionType* description;
+	vector<ShaderArchiveVariantType> variants;
+};
+
+
+///////////////////////
+// FUNCTION PROTOTYPES //
+///////////////////////
+static void GetDefines(const ShaderDescriptionType&, int, unsigned int, vector<RenderShaderDefine>&);
+static bool GetWideFilename(const string&, wstring&);
+static unsigned long long GetCompilerKey(RenderDeviceClass*);
+static int FindName(const vector<string>&, const string&);
+
+
+ShaderArchiveClass::ShaderArchiveClass()
+{
+	m_device = 0;
+	m_shaderCache = 0;
+	m_hasDescription = false;
+	m_header = 0;
+	m_options = 0;
+	m_stages = 0;
+	m_variants = 0;
+	m_blobs = 0;
+}
+
+ShaderArchiveClass::ShaderArchiveClass(const ShaderArchiveClass& other)
+{
+}
+
+ShaderArchiveClass::~ShaderArchiveClass()
+{
+}
+
+/*Initialize reads the permutation description and maps the archive. The archive is only used when it was built with
+the compiler of the device and, when the description is there, from the sources as they are now. Without a usable
+archive every variant is compiled through the shader cache the first time it is asked for. It fails when the
+description has an error, or when neither the description nor the archive is there, errors then tells why. An archive
+that is there but not used is not an error, errors still says why it was passed over.*/
+bool ShaderArchiveClass::Initialize(RenderDeviceClass* device, ShaderCacheClass* shaderCache, const char* descriptionFile, const char* archiveFile,
+	string& errors)
+{
+	PROFILE_FUNCTION();
+
+	unsigned long long sourceKey;
+	bool result;
+
+	errors.clear();
+
+	m_device = device;
+	m_shaderCache = shaderCache;
+
+	// A game that ships without the shader sources only has the archive, so a missing description is fine.
+	m_hasDescription = ReadDescription(descriptionFile, m_description, errors);
+	if (!errors.empty())
+	{
+		return false;
+	}
+
+	result = OpenArchive(archiveFile);
+	if (result && m_header->compilerKey != GetCompilerKey(device))
+	{
+		errors = string(archiveFile) + " was built with another shader compiler, the shaders are compiled instead\n";
+		CloseArchive();
+	}
+	else if (result && m_hasDescription && (!GetSourceKey(descriptionFile, m_description, sourceKey) || sourceKey != m_header->sourceKey))
+	{
+		errors = string(archiveFile) + " is out of date, the shaders are compiled instead\n";
+		CloseArchive();
+	}
+
+	if (!m_header && !m_hasDescription)
+	{
+		errors += string("Neither ") + descriptionFile + " nor " + archiveFile + " could be read\n";
+		return false;
+	}
+
+	return true;
+}
+
+void ShaderArchiveClass::Shutdown()
+{
+	CloseArchive();
+
+	m_description.options.clear();
+	m_description.stages.clear();
+	m_description.requirements.clear();
+	m_hasDescription = false;
+	m_shaderCache = 0;
+	m_device = 0;
+
+	return;
+}
+
+/*GetStage returns the number of the stage with the name, or -1 when there is no such stage.*/
+int ShaderArchiveClass::GetStage(const char* name)
+{
+	unsigned int i;
+
+	if (m_header)
+	{
+		for (i = 0; i < m_header->stageCount; i++)
+		{
+			if (strncmp(m_stages[i].name, name, SHADER_CACHE_NAME_LENGTH) == 0)
+			{
+				return (int)i;
+			}
+		}
+		return -1;
+	}
+
+	for (i = 0; i < m_description.stages.size(); i++)
+	{
+		if (m_description.stages[i].name == name)
+		{
+			return (int)i;
+		}
+	}
+
+	return -1;
+}
+
+/*GetOption returns the bit of the option with the name, or 0 when there is no such option. Look the bits up once and
+keep them, picking a variant only takes the mask.*/
+unsigned int ShaderArchiveClass::GetOption(const char* name)
+{
+	unsigned int i;
+	int option;
+
+	if (m_header)
+	{
+		for (i = 0; i < m_header->optionCount; i++)
+		{
+			if (strncmp(m_options[i].name, name, SHADER_CACHE_NAME_LENGTH) == 0)
+			{
+				return 1u << i;
+			}
+		}
+		return 0;
+	}
+
+	option = FindName(m_description.options, name);
+
+	return option < 0 ? 0 : 1u << option;
+}
+
+/*IsArchived tells whether the variants come out of the archive, instead of from the compiler and the shader cache.*/
+bool ShaderArchiveClass::IsArchived()
+{
+	return m_header != 0;
+}
+
+int ShaderArchiveClass::GetBlobCount()
+{
+	return m_header ? (int)m_header->blobCount : 0;
+}
+
+/*GetShader gives the bytecode and reflection of a variant of a stage. Only the bits of the options the stage uses are
+looked at, so one mask can pick the variants of all stages of a material. Like CompileShader it fails with an empty
+error string when the source file can't be found.*/
+bool ShaderArchiveClass::GetShader(int stage, unsigned int mask, vector<char>& bytecode, RenderShaderReflection& reflection, string& errors)
+{
+	vector<RenderShaderDefine> defines;
+	const ShaderArchiveBlobType* blob;
+	const ShaderStageType* shaderStage;
+	wstring filename;
+	unsigned int index;
+	bool result;
+
+	errors.clear();
+
+	// With the archive a variant is one lookup in the table of its stage.
+	if (m_header)
+	{
+		if (stage < 0 || stage >= (int)m_header->stageCount)
+		{
+			return false;
+		}
+
+		index = m_variants[((unsigned int)stage << m_header->optionCount) | (mask & m_stages[stage].optionMask)];
+		if (index == SHADER_ARCHIVE_NO_BLOB)
+		{
+			errors = string(m_stages[stage].name) + ": error: the variant is ruled out by a requirement of the description\n";
+			return false;
+		}
+
+		blob = &m_blobs[index];
+		result = ShaderCacheClass::UnpackEntry((const char*)m_file.GetData() + blob->offset, blob->size, blob->key, bytecode, reflection);
+		if (!result)
+		{
+			errors = string(m_stages[stage].name) + ": error: the shader archive is damaged\n";
+			return false;
+		}
+
+		return true;
+	}
+
+	// Without it the variant is compiled, or read from the shader cache when it was compiled before.
+	if (!m_hasDescription || stage < 0 || stage >= (int)m_description.stages.size())
+	{
+		return false;
+	}
+
+	shaderStage = &m_description.stages[stage];
+	if (!IsValidVariant(m_description, mask & shaderStage->optionMask))
+	{
+		errors = shaderStage->name + ": error: the variant is ruled out by a requirement of the description\n";
+		return false;
+	}
+
+	GetShaderDefines(stage, mask, defines);
+	result = GetWideFilename(shaderStage->filename, filename);
+	if (!result)
+	{
+		return false;
+	}
+
+	return m_shaderCache->GetShader(filename.c_str(), shaderStage->entryPoint.c_str(), shaderStage->profile.c_str(), &defines[0], bytecode,
+		reflection, errors);
+}
+
+/*GetShaderFilename returns the source file of a stage, as the wide name CompileShader takes. It needs the description.*/
+bool ShaderArchiveClass::GetShaderFilename(int stage, wstring& filename)
+{
+	if (!m_hasDescription || stage < 0 || stage >= (int)m_description.stages.size())
+	{
+		return false;
+	}
+
+	return GetWideFilename(m_description.stages[stage].filename, filename);
+}
+
+/*GetShaderDefines returns the defines a variant of a stage is compiled with, every option of the stage as 0 or 1 and
+the null entry at the end. The names point into the description, they live as long as the archive is initialized.*/
+void ShaderArchiveClass::GetShaderDefines(int stage, unsigned int mask, vector<RenderShaderDefine>& defines)
+{
+	GetDefines(m_description, stage, mask, defines);
+
+	return;
+}
+
+/*ReadDescription reads a permutation description. Every line is a keyword and its arguments, separated by spaces, and
+everything after a # is a comment:
+
+stage <name> <file> <entry point> <profile>
+option <NAME> <stage>...
+require <NAME> <NAME>
+
+The files of the stages are made relative to the directory of the description. Errors are reported like the compiler
+does, file(line): error: message. It returns false with an empty error string when the file can't be opened.*/
+bool ShaderArchiveClass::ReadDescription(const char* filename, ShaderDescriptionType& description, string& errors)
+{
+	ifstream fin;
+	istringstream words;
+	vector<string> tokens;
+	ShaderStageType stage;
+	ShaderRequirementType requirement;
+	string line, word, directory, location;
+	char number[16];
+	size_t position, i;
+	int lineNumber, index, option;
+
+	errors.clear();
+	description.options.clear();
+	description.stages.clear();
+	description.requirements.clear();
+
+	fin.open(filename);
+	if (fin.fail())
+	{
+		return false;
+	}
+
+	position = string(filename).find_last_of("/\\");
+	directory = position == string::npos ? "" : string(filename).substr(0, position + 1);
+
+	lineNumber = 0;
+	while (getline(fin, line) && errors.empty())
+	{
+		lineNumber++;
+		sprintf(number, "(%d)", lineNumber);
+		location = string(filename) + number + ": error: ";
+
+		// Leave out the comment and split the rest into words.
+		position = line.find('#');
+		if (position != string::npos)
+		{
+			line.erase(position);
+		}
+		words.clear();
+		words.str(line);
+		tokens.clear();
+		while (words >> word)
+		{
+			tokens.push_back(word);
+		}
+
+		if (tokens.empty())
+		{
+			continue;
+		}
+
+		for (i = 0; i < tokens.size(); i++)
+		{
+			if (tokens[i].size() >= (size_t)SHADER_CACHE_NAME_LENGTH)
+			{
+				errors = location + "'" + tokens[i] + "' is too long\n";
+			}
+		}
+		if (!errors.empty())
+		{
+			break;
+		}
+
+		if (tokens[0] == "stage")
+		{
+			if (tokens.size() != 5)
+			{
+				errors = location + "expected stage <name> <file> <entry point> <profile>\n";
+			}
+			else if (description.stages.size() >= (size_t)SHADER_ARCHIVE_MAX_STAGES)
+			{
+				errors = location + "too many stages\n";
+			}
+			else if (!description.options.empty())
+			{
+				errors = location + "the stages come before the options\n";
+			}
+			else
+			{
+				for (i = 0; i < description.stages.size(); i++)
+				{
+					if (description.stages[i].name == tokens[1])
+					{
+						errors = location + "stage '" + tokens[1] + "' is already defined\n";
+					}
+				}
+
+				stage.name = tokens[1];
+				stage.filename = directory + tokens[2];
+				stage.entryPoint = tokens[3];
+				stage.profile = tokens[4];
+				stage.optionMask = 0;
+				description.stages.push_back(stage);
+			}
+		}
+		else if (tokens[0] == "option")
+		{
+			if (tokens.size() < 3)
+			{
+				errors = location + "expected option <NAME> <stage>...\n";
+			}
+			else if (description.options.size() >= (size_t)SHADER_ARCHIVE_MAX_OPTIONS)
+			{
+				errors = location + "too many options\n";
+			}
+			else if (FindName(description.options, tokens[1]) >= 0)
+			{
+				errors = location + "option '" + tokens[1] + "' is already defined\n";
+			}
+			else
+			{
+				// The option changes the stages listed after it.
+				for (i = 2; i < tokens.size() && errors.empty(); i++)
+				{
+					for (index = 0; index < (int)description.stages.size(); index++)
+					{
+						if (description.stages[index].name == tokens[i])
+						{
+							break;
+						}
+					}
+					if (index == (int)description.stages.size())
+					{
+						errors = location + "unknown stage '" + tokens[i] + "'\n";
+						break;
+					}
+					description.stages[index].optionMask |= 1u << description.options.size();
+				}
+				description.options.push_back(tokens[1]);
+			}
+		}
+		else if (tokens[0] == "require")
+		{
+			if (tokens.size() != 3)
+			{
+				errors = location + "expected require <NAME> <NAME>\n";
+			}
+			else
+			{
+				option = FindName(description.options, tokens[1]);
+				index = FindName(description.options, tokens[2]);
+				if (option < 0 || index < 0)
+				{
+					errors = location + "unknown option '" + tokens[option < 0 ? 1 : 2] + "'\n";
+				}
+				else
+				{
+					requirement.optionMask = 1u << option;
+					requirement.requiredMask = 1u << index;
+					description.requirements.push_back(requirement);
+				}
+			}
+		}
+		else
+		{
+			errors = location + "unknown keyword '" + tokens[0] + "'\n";
+		}
+	}
+
+	if (errors.empty() && description.stages.empty())
+	{
+		errors = string(filename) + ": error: there are no stages\n";
+	}
+
+	return errors.empty();
+}
+
+/*IsValidVariant checks a mask against the requirements of the description.*/
+bool ShaderArchiveClass::IsValidVariant(const ShaderDescriptionType& description, unsigned int mask)
+{
+	size_t i;
+
+	for (i = 0; i < description.requirements.size(); i++)
+	{
+		if ((mask & description.requirements[i].optionMask) != 0 &&
+			(mask & description.requirements[i].requiredMask) != description.requirements[i].requiredMask)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/*GetSourceKey hashes the description and the sources of all its stages with everything they include, the same way
+the shader cache hashes a source. It fails when one of them can't be read.*/
+bool ShaderArchiveClass::GetSourceKey(const char* descriptionFile, const ShaderDescriptionType& description, unsigned long long& key)
+{
+	unsigned int version;
+	size_t i;
+	bool result;
+
+	key = SHADER_HASH_OFFSET_BASIS;
+	version = SHADER_ARCHIVE_VERSION;
+	ShaderCacheClass::HashBytes(&version, sizeof(version), key);
+
+	result = ShaderCacheClass::HashSource(descriptionFile, 0, key);
+	for (i = 0; i < description.stages.size() && result; i++)
+	{
+		result = ShaderCacheClass::HashSource(description.stages[i].filename, 0, key);
+	}
+
+	return result;
+}
+
+/*IsCurrent tells whether the archive was built from the description and sources as they are now, with the compiler of
+the device, so building it again would give the same archive.*/
+bool ShaderArchiveClass::IsCurrent(RenderDeviceClass* device, const char* descriptionFile, const char* archiveFile)
+{
+	ShaderDescriptionType description;
+	MappedFileClass file;
+	const ShaderArchiveHeaderType* header;
+	unsigned long long sourceKey;
+	string errors;
+	bool result;
+
+	result = ReadDescription(descriptionFile, description, errors);
+	if (!result || !GetSourceKey(descriptionFile, description, sourceKey))
+	{
+		return false;
+	}
+
+	result = file.Open(archiveFile);
+	if (!result || !ReadHeader(file, header))
+	{
+		return false;
+	}
+
+	return header->sourceKey == sourceKey && header->compilerKey == GetCompilerKey(device);
+}
+
+/*Build compiles every valid variant of every stage of the description and writes them into the archive. The variants
+are compiled on the job system, one per batch since a single variant takes a while. Compiling doesn't stop at the
+first variant that fails, the errors of all of them are returned. The archive is written under a temporary name first
+and only renamed when it is complete.*/
+bool ShaderArchiveClass::Build(RenderDeviceClass* device, JobSystemClass* jobSystem, const char* descriptionFile, const char* archiveFile, string& errors)
+{
+	PROFILE_FUNCTION();
+
+	ShaderDescriptionType description;
+	ShaderArchiveBuildType build;
+	ShaderArchiveVariantType variant;
+	ShaderArchiveHeaderType header;
+	ShaderArchiveOptionType option;
+	ShaderArchiveStageType stage;
+	ShaderArchiveBlobType blob;
+	vector<unsigned int> table;
+	vector<ShaderArchiveBlobType> blobs;
+	vector<vector<char> > entries;
+	vector<char> entry;
+	map<unsigned long long, unsigned int> blobKeys;
+	map<unsigned long long, unsigned int>::iterator found;
+	static const char padding[SHADER_ARCHIVE_ALIGNMENT] = { 0 };
+	unsigned long long sourceKey, key, offset;
+	unsigned int mask, optionCount;
+	char name[64];
+	string temporaryFile;
+	size_t i;
+	FILE* file;
+	bool result;
+
+	errors.clear();
+
+	result = ReadDescription(descriptionFile, description, errors);
+	if (!result)
+	{
+		if (errors.empty())
+		{
+			errors = string(descriptionFile) + ": error: the file could not be opened\n";
+		}
+		return false;
+	}
+
+	// Hash the sources before they are compiled, a change while compiling then makes the archive out of date.
+	result = GetSourceKey(descriptionFile, description, sourceKey);
+	if (!result)
+	{
+		errors = string(descriptionFile) + ": error: a source file of the description could not be read\n";
+		return false;
+	}
+
+	// List every valid variant, a stage only has variants for the options it uses.
+	optionCount = (unsigned int)description.options.size();
+	build.device = device;
+	build.description = &description;
+	for (i = 0; i < description.stages.size(); i++)
+	{
+		for (mask = 0; mask < (1u << optionCount); mask++)
+		{
+			if ((mask & ~description.stages[i].optionMask) != 0 || !IsValidVariant(description, mask))
+			{
+				continue;
+			}
+
+			variant.stage = (int)i;
+			variant.mask = mask;
+			variant.result = false;
+			build.variants.push_back(variant);
+		}
+	}
+
+	// The variants are independent of each other, so they are compiled all at once.
+	if (jobSystem)
+	{
+		jobSystem->ParallelFor((int)build.variants.size(), 1, CompileVariants, &build);
+	}
+	else
+	{
+		CompileVariants(&build, 0, (int)build.variants.size());
+	}
+
+	for (i = 0; i < build.variants.size(); i++)
+	{
+		if (!build.variants[i].result)
+		{
+			sprintf(name, "variant 0x%03x", build.variants[i].mask);
+			errors += description.stages[build.variants[i].stage].name + " " + name + ":\n" + build.variants[i].errors;
+		}
+	}
+	if (!errors.empty())
+	{
+		return false;
+	}
+
+	// Pack the variants, the ones that compiled to the same bytecode share a blob.
+	table.assign(description.stages.size() << optionCount, SHADER_ARCHIVE_NO_BLOB);
+	for (i = 0; i < build.variants.size(); i++)
+	{
+		key = SHADER_HASH_OFFSET_BASIS;
+		ShaderCacheClass::HashBytes(&build.variants[i].bytecode[0], build.variants[i].bytecode.size(), key);
+
+		result = ShaderCacheClass::PackEntry(key, build.variants[i].bytecode, build.variants[i].reflection, entry);
+		if (!result)
+		{
+			errors = description.stages[build.variants[i].stage].name + ": error: a name of the reflection is too long for the archive\n";
+			return false;
+		}
+
+		found = blobKeys.find(key);
+		if (found != blobKeys.end() && entries[found->second] == entry)
+		{
+			table[((size_t)build.variants[i].stage << optionCount) | build.variants[i].mask] = found->second;
+			continue;
+		}
+
+		blobKeys[key] = (unsigned int)entries.size();
+		table[((size_t)build.variants[i].stage << optionCount) | build.variants[i].mask] = (unsigned int)entries.size();
+		entries.push_back(entry);
+	}
+
+	// Lay the blobs out after the tables, each on an aligned offset.
+	offset = sizeof(ShaderArchiveHeaderType) + optionCount * sizeof(ShaderArchiveOptionType) +
+		description.stages.size() * sizeof(ShaderArchiveStageType) + table.size() * sizeof(unsigned int) + entries.size() * sizeof(ShaderArchiveBlobType);
+	for (i = 0; i < entries.size(); i++)
+	{
+		offset = (offset + SHADER_ARCHIVE_ALIGNMENT - 1) & ~(SHADER_ARCHIVE_ALIGNMENT - 1);
+
+		memset(&blob, 0, sizeof(blob));
+		blob.offset = offset;
+		blob.size = (unsigned int)entries[i].size();
+		blob.key = ((const ShaderCacheHeaderType*)&entries[i][0])->key;
+		blobs.push_back(blob);
+
+		offset += entries[i].size();
+	}
+
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, SHADER_ARCHIVE_MAGIC, sizeof(header.magic));
+	header.version = SHADER_ARCHIVE_VERSION;
+	header.sourceKey = sourceKey;
+	header.compilerKey = GetCompilerKey(device);
+	header.optionCount = optionCount;
+	header.stageCount = (unsigned int)description.stages.size();
+	header.blobCount = (unsigned int)entries.size();
+
+	temporaryFile = string(archiveFile) + ".tmp";
+	file = fopen(temporaryFile.c_str(), "wb");
+	if (!file)
+	{
+		errors = string(archiveFile) + ": error: the file could not be created\n";
+		return false;
+	}
+
+	result = fwrite(&header, sizeof(header), 1, file) == 1;
+	for (i = 0; i < description.options.size() && result; i++)
+	{
+		memset(&option, 0, sizeof(option));
+		strcpy(option.name, description.options[i].c_str());
+		result = fwrite(&option, sizeof(option), 1, file) == 1;
+	}
+	for (i = 0; i < description.stages.size() && result; i++)
+	{
+		memset(&stage, 0, sizeof(stage));
+		strcpy(stage.name, description.stages[i].name.c_str());
+		stage.optionMask = description.stages[i].optionMask;
+		result = fwrite(&stage, sizeof(stage), 1, file) == 1;
+	}
+	result = result && fwrite(&table[0], sizeof(unsigned int), table.size(), file) == table.size();
+	result = result && (blobs.empty() || fwrite(&blobs[0], sizeof(ShaderArchiveBlobType), blobs.size(), file) == blobs.size());
+	for (i = 0; i < entries.size() && result; i++)
+	{
+		offset = (unsigned long long)ftell(file);
+		result = offset <= blobs[i].offset && fwrite(padding, 1, (size_t)(blobs[i].offset - offset), file) == blobs[i].offset - offset;
+		result = result && fwrite(&entries[i][0], entries[i].size(), 1, file) == 1;
+	}
+
+	if (fclose(file) != 0 || !result)
+	{
+		// Don't leave half an archive behind.
+		remove(temporaryFile.c_str());
+		errors = string(archiveFile) + ": error: the file could not be written\n";
+		return false;
+	}
+
+	// Renaming onto a file that exists fails on Windows.
+	remove(archiveFile);
+	if (rename(temporaryFile.c_str(), archiveFile) != 0)
+	{
+		remove(temporaryFile.c_str());
+		errors = string(archiveFile) + ": error: the file could not be written\n";
+		return false;
+	}
+
+	return true;
+}
+
+/*OpenArchive maps an archive and points the tables into it.*/
+bool ShaderArchiveClass::OpenArchive(const char* filename)
+{
+	const char* data;
+	bool result;
+
+	result = m_file.Open(filename);
+	if (!result)
+	{
+		return false;
+	}
+
+	result = ReadHeader(m_file, m_header);
+	if (!result)
+	{
+		CloseArchive();
+		return false;
+	}
+
+	data = (const char*)m_file.GetData() + sizeof(ShaderArchiveHeaderType);
+	m_options = (const ShaderArchiveOptionType*)data;
+	data += m_header->optionCount * sizeof(ShaderArchiveOptionType);
+	m_stages = (const ShaderArchiveStageType*)data;
+	data += m_header->stageCount * sizeof(ShaderArchiveStageType);
+	m_variants = (const unsigned int*)data;
+	data += ((size_t)m_header->stageCount << m_header->optionCount) * sizeof(unsigned int);
+	m_blobs = (const ShaderArchiveBlobType*)data;
+
+	return true;
+}
+
+void ShaderArchiveClass::CloseArchive()
+{
+	m_file.Close();
+	m_header = 0;
+	m_options = 0;
+	m_stages = 0;
+	m_variants = 0;
+	m_blobs = 0;
+
+	return;
+}
+
+/*ReadHeader checks that a mapped file is an archive of this version and that its tables and blobs all fit in it, so
+a lookup never has to check anything.*/
+bool ShaderArchiveClass::ReadHeader(MappedFileClass& file, const ShaderArchiveHeaderType*& header)
+{
+	const ShaderArchiveStageType* stages;
+	const ShaderArchiveBlobType* blobs;
+	const unsigned int* variants;
+	unsigned long long tableSize;
+	size_t i;
+
+	header = (const ShaderArchiveHeaderType*)file.GetData();
+	if (file.GetSize() < sizeof(ShaderArchiveHeaderType) || memcmp(header->magic, SHADER_ARCHIVE_MAGIC, sizeof(header->magic)) != 0 ||
+		header->version != SHADER_ARCHIVE_VERSION || header->optionCount > (unsigned int)SHADER_ARCHIVE_MAX_OPTIONS ||
+		header->stageCount > (unsigned int)SHADER_ARCHIVE_MAX_STAGES)
+	{
+		return false;
+	}
+
+	tableSize = sizeof(ShaderArchiveHeaderType) + header->optionCount * sizeof(ShaderArchiveOptionType) +
+		header->stageCount * sizeof(ShaderArchiveStageType) + ((unsigned long long)header->stageCount << header->optionCount) * sizeof(unsigned int) +
+		(unsigned long long)header->blobCount * sizeof(ShaderArchiveBlobType);
+	if (tableSize > file.GetSize())
+	{
+		return false;
+	}
+
+	stages = (const ShaderArchiveStageType*)((const char*)file.GetData() + sizeof(ShaderArchiveHeaderType) +
+		header->optionCount * sizeof(ShaderArchiveOptionType));
+	variants = (const unsigned int*)(stages + header->stageCount);
+	blobs = (const ShaderArchiveBlobType*)(variants + ((size_t)header->stageCount << header->optionCount));
+
+	for (i = 0; i < header->stageCount; i++)
+	{
+		if ((stages[i].optionMask >> header->optionCount) != 0)
+		{
+			return false;
+		}
+	}
+
+	for (i = 0; i < ((size_t)header->stageCount << header->optionCount); i++)
+	{
+		if (variants[i] != SHADER_ARCHIVE_NO_BLOB && variants[i] >= header->blobCount)
+		{
+			return false;
+		}
+	}
+
+	for (i = 0; i < header->blobCount; i++)
+	{
+		if (blobs[i].offset < tableSize || blobs[i].offset > file.GetSize() || blobs[i].size > file.GetSize() - blobs[i].offset)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/*CompileVariants is the work of Build for the job system, it compiles and reflects the variants [begin, end). Every
+variant has its own results so the workers never write to the same place.*/
+void ShaderArchiveClass::CompileVariants(void* data, int begin, int end)
+{
+	ShaderArchiveBuildType* build;
+	ShaderArchiveVariantType* variant;
+	const ShaderStageType* stage;
+	vector<RenderShaderDefine> defines;
+	wstring filename;
+	int i;
+
+	build = (ShaderArchiveBuildType*)data;
+
+	for (i = begin; i < end; i++)
+	{
+		variant = &build->variants[i];
+		stage = &build->description->stages[variant->stage];
+
+		GetDefines(*build->description, variant->stage, variant->mask, defines);
+		variant->result = GetWideFilename(stage->filename, filename);
+		if (!variant->result)
+		{
+			variant->errors = stage->filename + ": error: the file name could not be converted\n";
+			continue;
+		}
+
+		variant->result = build->device->CompileShader(filename.c_str(), stage->entryPoint.c_str(), stage->profile.c_str(), &defines[0],
+			variant->bytecode, variant->errors);
+		if (!variant->result)
+		{
+			if (variant->errors.empty())
+			{
+				variant->errors = stage->filename + ": error: the file could not be opened\n";
+			}
+			continue;
+		}
+
+		variant->result = build->device->ReflectShader(&variant->bytecode[0], variant->bytecode.size(), variant->reflection);
+		if (!variant->result)
+		{
+			variant->errors = stage->entryPoint + ": error: the compiled shader could not be reflected\n";
+		}
+	}
+
+	return;
+}
+
+/*GetDefines builds the defines of a variant: every option of the stage, as 0 or 1, and the null entry.*/
+static void GetDefines(const ShaderDescriptionType& description, int stage, unsigned int mask, vector<RenderShaderDefine>& defines)
+{
+	RenderShaderDefine define;
+	size_t i;
+
+	defines.clear();
+
+	for (i = 0; i < description.options.size(); i++)
+	{
+		if ((description.stages[stage].optionMask & (1u << i)) == 0)
+		{
+			continue;
+		}
+
+		define.Name = description.options[i].c_str();
+		define.Definition = (mask & (1u << i)) != 0 ? "1" : "0";
+		defines.push_back(define);
+	}
+
+	define.Name = NULL;
+	define.Definition = NULL;
+	defines.push_back(define);
+
+	return;
+}
+
+/*GetWideFilename turns a file name of the description into the wide name CompileShader takes.*/
+static bool GetWideFilename(const string& filename, wstring& wideFilename)
+{
+	size_t length;
+
+	wideFilename.assign(filename.size() + 1, 0);
+	length = mbstowcs(&wideFilename[0], filename.c_str(), filename.size() + 1);
+	if (length == (size_t)-1)
+	{
+		return false;
+	}
+	wideFilename.resize(length);
+
+	return true;
+}
+
+/*GetCompilerKey hashes the name of the compiler of a device, an archive only works with the compiler it was built with.*/
+static unsigned long long GetCompilerKey(RenderDeviceClass* device)
+{
+	unsigned long long key;
+
+	key = SHADER_HASH_OFFSET_BASIS;
+	ShaderCacheClass::HashBytes(device->GetShaderCompiler(), strlen(device->GetShaderCompiler()) + 1, key);
+
+	return key;
+}
+
+/*FindName returns the place of a name in a list of names, or -1 when it isn't there.*/
+static int FindName(const vector<string>& names, const string& name)
+{
+	size_t i;
+
+	for (i = 0; i < names.size(); i++)
+	{
+		if (names[i] == name)
+		{
+			return (int)i;
+		}
+	}
+
+	return -1;
+}
@@ -0,0 +1,160 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: shaderarchiveclass.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _SHADERARCHIVECLASS_H_
+#define _SHADERARCHIVECLASS_H_
+
+
+//////////////
+// INCLUDES //
+//////////////
+#include <string>
+#include <vector>
+#include "jobsystemclass.h"
+#include "mappedfileclass.h"
+#include "renderdeviceclass.h"
+#include "shadercacheclass.h"
+using namespace std;
+
+
+/////////////
+// GLOBALS //
+/////////////
+/*Bump the version whenever the layout of an archive changes, an archive of another version is built again.*/
+const unsigned int SHADER_ARCHIVE_VERSION = 1;
+
+/*Every stage has a table with an entry for every combination of options, so the number of options is kept to what
+keeps those tables small: 4096 entries of 4 bytes per stage.*/
+const int SHADER_ARCHIVE_MAX_OPTIONS = 12;
+const int SHADER_ARCHIVE_MAX_STAGES = 8;
+
+/*The entry of a variant that isn't in the archive, because a requirement rules it out.*/
+const unsigned int SHADER_ARCHIVE_NO_BLOB = 0xffffffff;
+
+
+/////////////
+// TYPEDEFS //
+/////////////
+/*A shader of a permutation description. The file name is the one next to the description, and the option mask has
+the bits of the options that change this shader, the other bits of a variant mask are ignored for it.*/
+struct ShaderStageType
+{
+	string name;
+	string filename;
+	string entryPoint;
+	string profile;
+	unsigned int optionMask;
+};
+
+/*A variant with any of the bits of optionMask set is only valid when it also has all of requiredMask set.*/
+struct ShaderRequirementType
+{
+	unsigned int optionMask;
+	unsigned int requiredMask;
+};
+
+/*A permutation description as it is read from its text file, see ReadDescription. Option i is bit i of a mask.*/
+struct ShaderDescriptionType
+{
+	vector<string> options;
+	vector<ShaderStageType> stages;
+	vector<ShaderRequirementType> requirements;
+};
+
+/*The header at the start of an archive. It is followed by the option names, the stages, a table of 1 << optionCount
+blob numbers per stage, the blob table and last the blobs themselves. The source key is a hash of the description and
+every source file it compiles, the compiler key one of the compiler of the device the archive was built with.*/
+struct ShaderArchiveHeaderType
+{
+	char magic[4];
+	unsigned int version;
+	unsigned long long sourceKey;
+	unsigned long long compilerKey;
+	unsigned int optionCount;
+	unsigned int stageCount;
+	unsigned int blobCount;
+	unsigned int reserved;
+};
+
+struct ShaderArchiveOptionType
+{
+	char name[SHADER_CACHE_NAME_LENGTH];
+};
+
+struct ShaderArchiveStageType
+{
+	char name[SHADER_CACHE_NAME_LENGTH];
+	unsigned int optionMask;
+	unsigned int reserved;
+};
+
+/*Where a blob is in the archive. A blob is a compiled shader packed the way a shader cache file holds it (see
+ShaderCacheClass::PackEntry), under a key that is the hash of its bytecode.*/
+struct ShaderArchiveBlobType
+{
+	unsigned long long offset;
+	unsigned long long key;
+	unsigned int size;
+	unsigned int reserved;
+};
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: ShaderArchiveClass
+////////////////////////////////////////////////////////////////////////////////
+/*The ShaderArchiveClass holds every variant of a set of shaders, compiled ahead of time. The set is described in a
+small text file (see color.permutations): the stages with their file, entry point and profile, the options, which are
+defines that are either 0 or 1, and requirements that rule out combinations that make no sense. A variant is picked
+with a mask with a bit per option, the bit of an option is its place in the description.
+
+Build compiles every valid variant of every stage on the job system and writes them into one archive file, variants
+that compile to the same bytecode share one blob. The ShaderBuild project runs it before the game is built, so the
+game itself never has to compile a shader.
+
+At run time the archive is memory mapped and a variant is a lookup in the table of its stage: the mask, without the
+bits of options the stage doesn't use, is the index. When the archive is missing, out of date with the sources or
+built with another compiler, the variants are compiled through the shader cache from the description instead.*/
+class ShaderArchiveClass
+{
+public:
+	ShaderArchiveClass();
+	ShaderArchiveClass(const ShaderArchiveClass&);
+	~ShaderArchiveClass();
+
+	bool Initialize(RenderDeviceClass*, ShaderCacheClass*, const char*, const char*, string&);
+	void Shutdown();
+
+	int GetStage(const char*);
+	unsigned int GetOption(const char*);
+	bool IsArchived();
+	int GetBlobCount();
+	bool GetShader(int, unsigned int, vector<char>&, RenderShaderReflection&, string&);
+	bool GetShaderFilename(int, wstring&);
+	void GetShaderDefines(int, unsigned int, vector<RenderShaderDefine>&);
+
+	static bool ReadDescription(const char*, ShaderDescriptionType&, string&);
+	static bool IsValidVariant(const ShaderDescriptionType&, unsigned int);
+	static bool GetSourceKey(const char*, const ShaderDescriptionType&, unsigned long long&);
+	static bool IsCurrent(RenderDeviceClass*, const char*, const char*);
+	static bool Build(RenderDeviceClass*, JobSystemClass*, const char*, const char*, string&);
+
+private:
+	bool OpenArchive(const char*);
+	void CloseArchive();
+	static bool ReadHeader(MappedFileClass&, const ShaderArchiveHeaderType*&);
+	static void CompileVariants(void*, int, int);
+
+private:
+	RenderDeviceClass* m_device;
+	ShaderCacheClass* m_shaderCache;
+	ShaderDescriptionType m_description;
+	bool m_hasDescription;
+	MappedFileClass m_file;
+	const ShaderArchiveHeaderType* m_header;
+	const ShaderArchiveOptionType* m_options;
+	const ShaderArchiveStageType* m_stages;
+	const unsigned int* m_variants;
+	const ShaderArchiveBlobType* m_blobs;
+};
+
+#endif
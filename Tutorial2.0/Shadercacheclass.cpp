@@ -0,0 +1,468 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: shadercacheclass.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "shadercacheclass.h"
+#include "mappedfileclass.h"
+#include "profilerclass.h"
+#include "timerclass.h"
+#include <fstream>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifndef _WIN32
+#include <sys/stat.h>
+#include <sys/types.h>
+#endif
+
+
+/////////////
+// GLOBALS //
+/////////////
+static const char SHADER_CACHE_MAGIC[4] = { 'S', 'H', 'D', 'R' };
+static const unsigned long long FNV_PRIME = 1099511628211ull;
+
+// How deep includes may nest before the hash gives up, the compiler would give up as well.
+static const int SHADER_MAX_INCLUDE_DEPTH = 32;
+
+
+///////////////////////
+// FUNCTION PROTOTYPES //
+///////////////////////
+static bool CopyName(char*, const string&);
+
+
+ShaderCacheClass::ShaderCacheClass()
+{
+	m_device = 0;
+	memset(&m_statistics, 0, sizeof(m_statistics));
+}
+
+ShaderCacheClass::ShaderCacheClass(const ShaderCacheClass& other)
+{
+}
+
+ShaderCacheClass::~ShaderCacheClass()
+{
+}
+
+/*Initialize creates the cache directory when it isn't there yet. When it can't be created the shaders are still
+compiled, they just can't be written to the cache.*/
+bool ShaderCacheClass::Initialize(RenderDeviceClass* device, const char* directory)
+{
+	m_device = device;
+	m_directory = directory;
+	memset(&m_statistics, 0, sizeof(m_statistics));
+
+#ifdef _WIN32
+	CreateDirectoryA(directory, NULL);
+#else
+	mkdir(directory, 0755);
+#endif
+
+	return true;
+}
+
+void ShaderCacheClass::Shutdown()
+{
+	m_device = 0;
+
+	return;
+}
+
+/*GetShader takes the same arguments as CompileShader and gives the bytecode of the shader together with its
+reflection, from the cache file when there is one and from the compiler when there isn't. It returns false with an
+empty error string when the file could not be found and with the compiler output when the shader did not compile.
+A shader that compiled but could not be written to the cache is still returned, errors then says which file it was.*/
+bool ShaderCacheClass::GetShader(const WCHAR* filename, const char* entryPoint, const char* profile, const RenderShaderDefine* defines,
+	vector<char>& bytecode, RenderShaderReflection& reflection, string& errors)
+{
+	PROFILE_FUNCTION();
+
+	TimerClass timer;
+	unsigned long long key;
+	string cacheFile;
+	bool result;
+
+	errors.clear();
+
+	// Hash the sources and look for the cache file of that key.
+	timer.Start();
+	result = GetKey(filename, entryPoint, profile, defines, key);
+	if (!result)
+	{
+		return false;
+	}
+
+	cacheFile = GetCacheFileName(key);
+	result = ReadEntry(cacheFile, key, bytecode, reflection);
+	if (result)
+	{
+		m_statistics.hits++;
+		m_statistics.loadMilliseconds += timer.GetElapsedMilliseconds();
+		return true;
+	}
+
+	// Not cached yet, compile and reflect the shader and keep it for the next time.
+	result = m_device->CompileShader(filename, entryPoint, profile, defines, bytecode, errors);
+	if (!result)
+	{
+		return false;
+	}
+
+	result = m_device->ReflectShader(&bytecode[0], bytecode.size(), reflection);
+	if (!result)
+	{
+		errors = string(entryPoint) + ": error: the compiled shader could not be reflected\n";
+		return false;
+	}
+
+	result = WriteEntry(cacheFile, key, bytecode, reflection);
+	if (!result)
+	{
+		errors = "Could not write " + cacheFile + "\n";
+	}
+
+	m_statistics.misses++;
+	m_statistics.compileMilliseconds += timer.GetElapsedMilliseconds();
+
+	return true;
+}
+
+/*GetKey hashes everything that goes into the bytecode of a shader. Every string is hashed with its ending zero so
+"AB" + "C" and "A" + "BC" don't give the same key. It fails only when the source file can't be read.*/
+bool ShaderCacheClass::GetKey(const WCHAR* filename, const char* entryPoint, const char* profile, const RenderShaderDefine* defines,
+	unsigned long long& key)
+{
+	char narrowFilename[1024];
+	unsigned int version;
+	size_t length;
+	int i;
+
+	// Convert the file name, the standard streams only take narrow names everywhere.
+	length = wcstombs(narrowFilename, filename, sizeof(narrowFilename) - 1);
+	if (length == (size_t)-1)
+	{
+		return false;
+	}
+	narrowFilename[length] = 0;
+
+	key = SHADER_HASH_OFFSET_BASIS;
+	version = SHADER_CACHE_VERSION;
+	HashBytes(&version, sizeof(version), key);
+	HashBytes(m_device->GetShaderCompiler(), strlen(m_device->GetShaderCompiler()) + 1, key);
+	HashBytes(entryPoint, strlen(entryPoint) + 1, key);
+	HashBytes(profile, strlen(profile) + 1, key);
+
+	for (i = 0; defines && defines[i].Name; i++)
+	{
+		HashBytes(defines[i].Name, strlen(defines[i].Name) + 1, key);
+		HashBytes(defines[i].Definition ? defines[i].Definition : "", defines[i].Definition ? strlen(defines[i].Definition) + 1 : 1, key);
+	}
+
+	return HashSource(narrowFilename, 0, key);
+}
+
+/*GetCacheFileName returns the file a key is cached in, the key as 16 hex digits in the cache directory.*/
+string ShaderCacheClass::GetCacheFileName(unsigned long long key)
+{
+	char name[32];
+
+	sprintf(name, "/%016llx.shader", key);
+
+	return m_directory + name;
+}
+
+ShaderCacheStatisticsType ShaderCacheClass::GetStatistics()
+{
+	return m_statistics;
+}
+
+/*ReadEntry maps a cache file and unpacks it. Anything that doesn't add up (a file of another version or key, or one cut
+short by a crash while it was written) counts as not cached.*/
+bool ShaderCacheClass::ReadEntry(const string& filename, unsigned long long key, vector<char>& bytecode, RenderShaderReflection& reflection)
+{
+	MappedFileClass file;
+	bool result;
+
+	result = file.Open(filename.c_str());
+	if (!result)
+	{
+		return false;
+	}
+
+	return UnpackEntry(file.GetData(), file.GetSize(), key, bytecode, reflection);
+}
+
+/*WriteEntry writes a cache file under a temporary name first and renames it when it is complete, so another run of
+the game reading the cache at the same time never sees half a file.*/
+bool ShaderCacheClass::WriteEntry(const string& filename, unsigned long long key, const vector<char>& bytecode, const RenderShaderReflection& reflection)
+{
+	vector<char> entry;
+	string temporaryFile;
+	FILE* file;
+	bool result;
+
+	result = PackEntry(key, bytecode, reflection, entry);
+	if (!result)
+	{
+		return false;
+	}
+
+	temporaryFile = filename + ".tmp";
+	file = fopen(temporaryFile.c_str(), "wb");
+	if (!file)
+	{
+		return false;
+	}
+
+	result = fwrite(&entry[0], entry.size(), 1, file) == 1;
+
+	if (fclose(file) != 0 || !result)
+	{
+		// Don't leave half a file behind for the next run to trip over.
+		remove(temporaryFile.c_str());
+		return false;
+	}
+
+	// Renaming onto a file that exists fails on Windows, another run may have cached the same shader in the meantime.
+	remove(filename.c_str());
+	if (rename(temporaryFile.c_str(), filename.c_str()) != 0)
+	{
+		remove(temporaryFile.c_str());
+		return false;
+	}
+
+	return true;
+}
+
+/*PackEntry lays out the bytecode and reflection of a shader the way a cache file holds them: the header, the constant
+buffers each followed by its variables, the inputs and the bytecode. The shader archive packs its shaders the same
+way. It fails when a name doesn't fit in its field.*/
+bool ShaderCacheClass::PackEntry(unsigned long long key, const vector<char>& bytecode, const RenderShaderReflection& reflection, vector<char>& entry)
+{
+	ShaderCacheHeaderType* header;
+	ShaderCacheBufferType* buffer;
+	ShaderCacheVariableType* variable;
+	ShaderCacheInputType* input;
+	size_t size, position, i, j;
+	bool result;
+
+	size = sizeof(ShaderCacheHeaderType) + reflection.inputs.size() * sizeof(ShaderCacheInputType) + bytecode.size();
+	for (i = 0; i < reflection.constantBuffers.size(); i++)
+	{
+		size += sizeof(ShaderCacheBufferType) + reflection.constantBuffers[i].variables.size() * sizeof(ShaderCacheVariableType);
+	}
+
+	// Every field starts out zero so the unused end of a name is the same in every file.
+	entry.assign(size, 0);
+
+	header = (ShaderCacheHeaderType*)&entry[0];
+	memcpy(header->magic, SHADER_CACHE_MAGIC, sizeof(header->magic));
+	header->version = SHADER_CACHE_VERSION;
+	header->key = key;
+	header->constantBufferCount = (unsigned int)reflection.constantBuffers.size();
+	header->inputCount = (unsigned int)reflection.inputs.size();
+	header->bytecodeSize = (unsigned int)bytecode.size();
+	position = sizeof(ShaderCacheHeaderType);
+
+	result = true;
+	for (i = 0; i < reflection.constantBuffers.size() && result; i++)
+	{
+		buffer = (ShaderCacheBufferType*)&entry[position];
+		result = CopyName(buffer->name, reflection.constantBuffers[i].name);
+		buffer->slot = reflection.constantBuffers[i].slot;
+		buffer->size = reflection.constantBuffers[i].size;
+		buffer->variableCount = (unsigned int)reflection.constantBuffers[i].variables.size();
+		position += sizeof(ShaderCacheBufferType);
+
+		for (j = 0; j < reflection.constantBuffers[i].variables.size() && result; j++)
+		{
+			variable = (ShaderCacheVariableType*)&entry[position];
+			result = CopyName(variable->name, reflection.constantBuffers[i].variables[j].name);
+			variable->offset = reflection.constantBuffers[i].variables[j].offset;
+			variable->size = reflection.constantBuffers[i].variables[j].size;
+			position += sizeof(ShaderCacheVariableType);
+		}
+	}
+
+	for (i = 0; i < reflection.inputs.size() && result; i++)
+	{
+		input = (ShaderCacheInputType*)&entry[position];
+		result = CopyName(input->semanticName, reflection.inputs[i].semanticName);
+		input->semanticIndex = reflection.inputs[i].semanticIndex;
+		input->componentCount = reflection.inputs[i].componentCount;
+		input->componentType = (unsigned int)reflection.inputs[i].componentType;
+		position += sizeof(ShaderCacheInputType);
+	}
+	if (!result)
+	{
+		return false;
+	}
+
+	if (!bytecode.empty())
+	{
+		memcpy(&entry[position], &bytecode[0], bytecode.size());
+	}
+
+	return true;
+}
+
+/*UnpackEntry copies the bytecode and the reflection out of a packed entry, checking every count against the size so
+a damaged entry fails instead of reading past its end.*/
+bool ShaderCacheClass::UnpackEntry(const void* entry, size_t size, unsigned long long key, vector<char>& bytecode, RenderShaderReflection& reflection)
+{
+	const ShaderCacheHeaderType* header;
+	const ShaderCacheBufferType* buffer;
+	const ShaderCacheVariableType* variable;
+	const ShaderCacheInputType* input;
+	const char* data;
+	const char* end;
+	RenderShaderConstantBuffer constantBuffer;
+	RenderShaderVariable bufferVariable;
+	RenderShaderInput shaderInput;
+	unsigned int i, j;
+
+	data = (const char*)entry;
+	end = data + size;
+	header = (const ShaderCacheHeaderType*)data;
+	if (size < sizeof(ShaderCacheHeaderType) || memcmp(header->magic, SHADER_CACHE_MAGIC, sizeof(header->magic)) != 0 ||
+		header->version != SHADER_CACHE_VERSION || header->key != key || header->bytecodeSize == 0)
+	{
+		return false;
+	}
+	data += sizeof(ShaderCacheHeaderType);
+
+	reflection.constantBuffers.clear();
+	reflection.inputs.clear();
+	for (i = 0; i < header->constantBufferCount; i++)
+	{
+		if ((size_t)(end - data) < sizeof(ShaderCacheBufferType))
+		{
+			return false;
+		}
+		buffer = (const ShaderCacheBufferType*)data;
+		data += sizeof(ShaderCacheBufferType);
+
+		constantBuffer.name.assign(buffer->name, strnlen(buffer->name, SHADER_CACHE_NAME_LENGTH));
+		constantBuffer.slot = buffer->slot;
+		constantBuffer.size = buffer->size;
+		constantBuffer.variables.clear();
+		if ((size_t)(end - data) / sizeof(ShaderCacheVariableType) < buffer->variableCount)
+		{
+			return false;
+		}
+		for (j = 0; j < buffer->variableCount; j++)
+		{
+			variable = (const ShaderCacheVariableType*)data;
+			data += sizeof(ShaderCacheVariableType);
+
+			bufferVariable.name.assign(variable->name, strnlen(variable->name, SHADER_CACHE_NAME_LENGTH));
+			bufferVariable.offset = variable->offset;
+			bufferVariable.size = variable->size;
+			constantBuffer.variables.push_back(bufferVariable);
+		}
+		reflection.constantBuffers.push_back(constantBuffer);
+	}
+
+	if ((size_t)(end - data) / sizeof(ShaderCacheInputType) < header->inputCount)
+	{
+		return false;
+	}
+	for (i = 0; i < header->inputCount; i++)
+	{
+		input = (const ShaderCacheInputType*)data;
+		data += sizeof(ShaderCacheInputType);
+
+		shaderInput.semanticName.assign(input->semanticName, strnlen(input->semanticName, SHADER_CACHE_NAME_LENGTH));
+		shaderInput.semanticIndex = input->semanticIndex;
+		shaderInput.componentCount = input->componentCount;
+		shaderInput.componentType = (RenderComponentType)input->componentType;
+		reflection.inputs.push_back(shaderInput);
+	}
+
+	if ((size_t)(end - data) != header->bytecodeSize)
+	{
+		return false;
+	}
+	bytecode.assign(data, end);
+
+	return true;
+}
+
+/*HashSource hashes the contents of a source file and then every file it includes, looked up next to it the way the
+compiler does. The #include lines are found without running the preprocessor, so a file that is only included in some
+permutations is always hashed, which at worst compiles a shader again that didn't have to be. An include that doesn't
+exist is hashed by its name only, the compiler will complain about it.*/
+bool ShaderCacheClass::HashSource(const string& filename, int depth, unsigned long long& key)
+{
+	string source, includeName, directory;
+	size_t position, start, end;
+	ifstream fin;
+
+	fin.open(filename.c_str(), ios::in | ios::binary);
+	if (fin.fail())
+	{
+		return false;
+	}
+	source.assign(istreambuf_iterator<char>(fin), istreambuf_iterator<char>());
+	fin.close();
+
+	HashBytes(source.data(), source.size(), key);
+
+	if (depth >= SHADER_MAX_INCLUDE_DEPTH)
+	{
+		return true;
+	}
+
+	position = filename.find_last_of("/\\");
+	directory = position == string::npos ? "" : filename.substr(0, position + 1);
+
+	for (position = source.find("#include"); position != string::npos; position = source.find("#include", position + 8))
+	{
+		start = source.find_first_of("\"\n", position + 8);
+		if (start == string::npos || source[start] != '"')
+		{
+			continue;
+		}
+		end = source.find_first_of("\"\n", start + 1);
+		if (end == string::npos || source[end] != '"')
+		{
+			continue;
+		}
+
+		// The name is hashed the way it is written, the directory depends on where the game was started from.
+		includeName = source.substr(start + 1, end - start - 1);
+		HashBytes(includeName.c_str(), includeName.size() + 1, key);
+		HashSource(directory + includeName, depth + 1, key);
+	}
+
+	return true;
+}
+
+/*HashBytes feeds bytes into a 64 bit FNV-1a hash.*/
+void ShaderCacheClass::HashBytes(const void* data, size_t size, unsigned long long& hash)
+{
+	const unsigned char* bytes;
+	size_t i;
+
+	bytes = (const unsigned char*)data;
+	for (i = 0; i < size; i++)
+	{
+		hash = (hash ^ bytes[i]) * FNV_PRIME;
+	}
+
+	return;
+}
+
+/*CopyName copies a name into a fixed size field of a cache file, it fails when the name doesn't fit.*/
+static bool CopyName(char* destination, const string& name)
+{
+	if (name.size() >= (size_t)SHADER_CACHE_NAME_LENGTH)
+	{
+		return false;
+	}
+
+	memcpy(destination, name.c_str(), name.size() + 1);
+
+	return true;
+}
@@ -0,0 +1,124 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: shadercacheclass.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _SHADERCACHECLASS_H_
+#define _SHADERCACHECLASS_H_
+
+
+//////////////
+// INCLUDES //
+//////////////
+#include <string>
+#include <vector>
+#include "renderdeviceclass.h"
+using namespace std;
+
+
+/////////////
+// GLOBALS //
+/////////////
+/*Bump the version whenever the layout of a cache file changes, files of another version are compiled again.*/
+const unsigned int SHADER_CACHE_VERSION = 1;
+
+/*Room for the names of constant buffers, variables and semantics in a cache file, ending zero included. Shaders with
+longer names are still compiled, they just aren't cached.*/
+const int SHADER_CACHE_NAME_LENGTH = 64;
+
+/*Where every FNV-1a hash of HashBytes starts.*/
+const unsigned long long SHADER_HASH_OFFSET_BASIS = 14695981039346656037ull;
+
+
+/////////////
+// TYPEDEFS //
+/////////////
+/*The header at the start of every cache file. It is followed by the constant buffers, each right followed by its
+variables, then the inputs and last the bytecode. The key is in there too so a file is only ever used for the shader
+it was written for.*/
+struct ShaderCacheHeaderType
+{
+	char magic[4];
+	unsigned int version;
+	unsigned long long key;
+	unsigned int constantBufferCount;
+	unsigned int inputCount;
+	unsigned int bytecodeSize;
+	unsigned int reserved;
+};
+
+struct ShaderCacheBufferType
+{
+	char name[SHADER_CACHE_NAME_LENGTH];
+	unsigned int slot;
+	unsigned int size;
+	unsigned int variableCount;
+};
+
+struct ShaderCacheVariableType
+{
+	char name[SHADER_CACHE_NAME_LENGTH];
+	unsigned int offset;
+	unsigned int size;
+};
+
+struct ShaderCacheInputType
+{
+	char semanticName[SHADER_CACHE_NAME_LENGTH];
+	unsigned int semanticIndex;
+	unsigned int componentCount;
+	unsigned int componentType;
+};
+
+/*What the cache did since it was initialized: how many shaders came out of a cache file and how many were compiled,
+and the milliseconds spent on each. Loading includes hashing the sources.*/
+struct ShaderCacheStatisticsType
+{
+	int hits;
+	int misses;
+	double loadMilliseconds;
+	double compileMilliseconds;
+};
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: ShaderCacheClass
+////////////////////////////////////////////////////////////////////////////////
+/*The ShaderCacheClass keeps compiled shaders on disk so starting the game doesn't have to compile them again. Every
+shader is stored in a file of its own in the cache directory, named after a 64 bit FNV-1a hash of everything that
+changes its bytecode: the source, every file it includes (and those include, found by their #include lines), the
+defines, the entry point, the profile and the compiler of the device (see GetShaderCompiler). A change to any of them
+gives another key, so a cache file never has to be checked for being out of date, there simply isn't one yet.
+
+The file holds the bytecode and what ReflectShader tells about it, so a shader that was compiled before costs reading
+its sources and one small file, with no compiling and no reflecting. A shader that is not in the cache is compiled by
+the device and written to it, a failed compile is never cached and reports its errors like CompileShader does.*/
+class ShaderCacheClass
+{
+public:
+	ShaderCacheClass();
+	ShaderCacheClass(const ShaderCacheClass&);
+	~ShaderCacheClass();
+
+	bool Initialize(RenderDeviceClass*, const char*);
+	void Shutdown();
+
+	bool GetShader(const WCHAR*, const char*, const char*, const RenderShaderDefine*, vector<char>&, RenderShaderReflection&, string&);
+	bool GetKey(const WCHAR*, const char*, const char*, const RenderShaderDefine*, unsigned long long&);
+	string GetCacheFileName(unsigned long long);
+	ShaderCacheStatisticsType GetStatistics();
+
+	static bool PackEntry(unsigned long long, const vector<char>&, const RenderShaderReflection&, vector<char>&);
+	static bool UnpackEntry(const void*, size_t, unsigned long long, vector<char>&, RenderShaderReflection&);
+	static bool HashSource(const string&, int, unsigned long long&);
+	static void HashBytes(const void*, size_t, unsigned long long&);
+
+private:
+	bool ReadEntry(const string&, unsigned long long, vector<char>&, RenderShaderReflection&);
+	bool WriteEntry(const string&, unsigned long long, const vector<char>&, const RenderShaderReflection&);
+
+private:
+	RenderDeviceClass* m_device;
+	string m_directory;
+	ShaderCacheStatisticsType m_statistics;
+};
+
+#endif
@@ -0,0 +1,207 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: shaderreflectionclass.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "shaderreflectionclass.h"
+#include <stdio.h>
+#include <string.h>
+
+
+/*GetConstantBuffer finds the slot and size of a constant buffer. A buffer the shader doesn't have, because the
+compiler stripped it, gets a size of 0.*/
+void ShaderReflectionClass::GetConstantBuffer(const RenderShaderReflection& reflection, const char* bufferName, ShaderBufferBindingType& binding)
+{
+	const RenderShaderConstantBuffer* buffer;
+
+	buffer = FindConstantBuffer(reflection, bufferName);
+	if (!buffer)
+	{
+		binding.slot = 0;
+		binding.size = 0;
+		return;
+	}
+
+	binding.slot = buffer->slot;
+	binding.size = buffer->size;
+
+	return;
+}
+
+/*GetParameter finds where a variable the engine writes with size bytes is in its constant buffer. When the buffer was
+stripped the parameter gets a size of 0 and that is fine, nothing reads it. When the buffer is there the compiler keeps
+every variable of it, so a variable that is missing has been renamed in the shader and is an error, as is a variable
+of another size.*/
+bool ShaderReflectionClass::GetParameter(const RenderShaderReflection& reflection, const char* bufferName, const char* variableName,
+	unsigned int size, ShaderParameterType& parameter, string& errors)
+{
+	const RenderShaderConstantBuffer* buffer;
+	char number[64];
+	size_t i;
+
+	parameter.offset = 0;
+	parameter.size = 0;
+
+	buffer = FindConstantBuffer(reflection, bufferName);
+	if (!buffer)
+	{
+		return true;
+	}
+
+	for (i = 0; i < buffer->variables.size(); i++)
+	{
+		if (buffer->variables[i].name == variableName)
+		{
+			break;
+		}
+	}
+
+	if (i == buffer->variables.size())
+	{
+		errors += string("constant buffer ") + bufferName + " has no variable " + variableName + "\n";
+		return false;
+	}
+
+	if (buffer->variables[i].size != size || buffer->variables[i].offset + size > buffer->size)
+	{
+		sprintf(number, " is %u bytes at offset %u, %u bytes are written\n", buffer->variables[i].size, buffer->variables[i].offset, size);
+		errors += string("constant buffer ") + bufferName + ": " + variableName + number;
+		return false;
+	}
+
+	parameter.offset = buffer->variables[i].offset;
+	parameter.size = size;
+
+	return true;
+}
+
+/*ValidateInputLayout checks that every vertex input of a vertex shader is fed by an element of the input layout with
+the same semantic and the same type of components. A float input can come from a float, UNORM or SNORM format and an
+uint input from an UINT format. Fewer components than the shader reads is fine, the input assembler fills in the rest
+the same way it turns a float3 position into a float4 with a w of 1. Elements the shader doesn't read are fine too.
+System values are made by the input assembler itself and don't need an element.*/
+bool ShaderReflectionClass::ValidateInputLayout(const RenderShaderReflection& reflection, const RenderInputElement* elements,
+	unsigned int elementCount, string& errors)
+{
+	const RenderShaderInput* input;
+	char semantic[128];
+	unsigned int j;
+	size_t i;
+	bool result;
+
+	result = true;
+
+	for (i = 0; i < reflection.inputs.size(); i++)
+	{
+		input = &reflection.inputs[i];
+		if (input->semanticName.compare(0, 3, "SV_") == 0)
+		{
+			continue;
+		}
+
+		for (j = 0; j < elementCount; j++)
+		{
+			if (input->semanticName == elements[j].SemanticName && input->semanticIndex == elements[j].SemanticIndex)
+			{
+				break;
+			}
+		}
+
+		sprintf(semantic, "%.100s%u", input->semanticName.c_str(), input->semanticIndex);
+
+		if (j == elementCount)
+		{
+			errors += string("vertex input ") + semantic + " is not in the input layout\n";
+			result = false;
+		}
+		else if (GetFormatComponentType(elements[j].Format) != input->componentType)
+		{
+			errors += string("vertex input ") + semantic + " has another component type than its input layout element\n";
+			result = false;
+		}
+	}
+
+	return result;
+}
+
+/*ValidateConstantBuffers checks that two shaders that are used together, like a vertex and a pixel shader, agree on
+the constant buffers they both have: the same buffer in the same slot with the same size and variables, and no two
+different buffers in one slot. Buffers only one of them has are left alone.*/
+bool ShaderReflectionClass::ValidateConstantBuffers(const RenderShaderReflection& first, const RenderShaderReflection& second, string& errors)
+{
+	const RenderShaderConstantBuffer* firstBuffer;
+	const RenderShaderConstantBuffer* secondBuffer;
+	size_t i, j, k;
+	bool result, same;
+
+	result = true;
+
+	for (i = 0; i < first.constantBuffers.size(); i++)
+	{
+		firstBuffer = &first.constantBuffers[i];
+
+		for (j = 0; j < second.constantBuffers.size(); j++)
+		{
+			secondBuffer = &second.constantBuffers[j];
+
+			if (firstBuffer->name != secondBuffer->name)
+			{
+				if (firstBuffer->slot == secondBuffer->slot)
+				{
+					errors += "constant buffers " + firstBuffer->name + " and " + secondBuffer->name + " are in the same slot\n";
+					result = false;
+				}
+				continue;
+			}
+
+			same = firstBuffer->slot == secondBuffer->slot && firstBuffer->size == secondBuffer->size &&
+				firstBuffer->variables.size() == secondBuffer->variables.size();
+			for (k = 0; same && k < firstBuffer->variables.size(); k++)
+			{
+				same = firstBuffer->variables[k].name == secondBuffer->variables[k].name &&
+					firstBuffer->variables[k].offset == secondBuffer->variables[k].offset &&
+					firstBuffer->variables[k].size == secondBuffer->variables[k].size;
+			}
+
+			if (!same)
+			{
+				errors += "constant buffer " + firstBuffer->name + " has another layout in each shader\n";
+				result = false;
+			}
+		}
+	}
+
+	return result;
+}
+
+const RenderShaderConstantBuffer* ShaderReflectionClass::FindConstantBuffer(const RenderShaderReflection& reflection, const char* bufferName)
+{
+	size_t i;
+
+	for (i = 0; i < reflection.constantBuffers.size(); i++)
+	{
+		if (reflection.constantBuffers[i].name == bufferName)
+		{
+			return &reflection.constantBuffers[i];
+		}
+	}
+
+	return 0;
+}
+
+/*GetFormatComponentType is the type of the components a vertex shader sees for a format of the input layout.*/
+RenderComponentType ShaderReflectionClass::GetFormatComponentType(RenderFormat format)
+{
+	switch (format)
+	{
+	case RENDER_FORMAT_R32G32B32_FLOAT:
+	case RENDER_FORMAT_R32G32B32A32_FLOAT:
+	case RENDER_FORMAT_R16G16B16A16_UNORM:
+	case RENDER_FORMAT_R8G8B8A8_UNORM:
+	case RENDER_FORMAT_R16G16_SNORM:
+		return RENDER_COMPONENT_FLOAT32;
+	case RENDER_FORMAT_R32_UINT:
+	case RENDER_FORMAT_R16_UINT:
+		return RENDER_COMPONENT_UINT32;
+	default:
+		return RENDER_COMPONENT_UNKNOWN;
+	}
+}
@@ -0,0 +1,61 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: shaderreflectionclass.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _SHADERREFLECTIONCLASS_H_
+#define _SHADERREFLECTIONCLASS_H_
+
+
+//////////////
+// INCLUDES //
+//////////////
+#include <string>
+#include <vector>
+#include "renderdeviceclass.h"
+using namespace std;
+
+
+/////////////
+// TYPEDEFS //
+/////////////
+/*Where a constant buffer of a shader is bound and how many bytes it has. The compiler strips a constant buffer nothing
+in the shader reads, such a buffer has a size of 0 and doesn't have to be written or bound at all.*/
+struct ShaderBufferBindingType
+{
+	unsigned int slot;
+	unsigned int size;
+};
+
+/*Where one variable is in its constant buffer, in bytes from the start of the buffer. The size is 0 when the buffer
+was stripped, writing the variable is skipped then.*/
+struct ShaderParameterType
+{
+	unsigned int offset;
+	unsigned int size;
+};
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: ShaderReflectionClass
+////////////////////////////////////////////////////////////////////////////////
+/*The ShaderReflectionClass checks the layouts the engine writes against the ones a compiled shader reads, using the
+reflection the shader cache and the shader archive keep next to the bytecode. A shader class looks its constant
+buffers and variables up once when it is loaded and afterwards writes the parameters straight into mapped memory at
+the offsets it got, so nothing is looked up per draw and there is no hand written struct that has to match the cbuffer.
+
+Everything that can go wrong is caught at load time with a message that says what doesn't match: a variable with
+another size than the engine writes, a variable the shader renamed, a vertex input the input layout doesn't have or
+has with another type, and two stages that disagree about a constant buffer in the same slot.*/
+class ShaderReflectionClass
+{
+public:
+	static void GetConstantBuffer(const RenderShaderReflection&, const char*, ShaderBufferBindingType&);
+	static bool GetParameter(const RenderShaderReflection&, const char*, const char*, unsigned int, ShaderParameterType&, string&);
+	static bool ValidateInputLayout(const RenderShaderReflection&, const RenderInputElement*, unsigned int, string&);
+	static bool ValidateConstantBuffers(const RenderShaderReflection&, const RenderShaderReflection&, string&);
+
+private:
+	static const RenderShaderConstantBuffer* FindConstantBuffer(const RenderShaderReflection&, const char*);
+	static RenderComponentType GetFormatComponentType(RenderFormat);
+};
+
+#endif
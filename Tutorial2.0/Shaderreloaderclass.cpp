@@ -0,0 +1,257 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: shaderreloaderclass.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "shaderreloaderclass.h"
+#include "profilerclass.h"
+#include "timerclass.h"
+#include <chrono>
+#include <string.h>
+
+ShaderReloaderClass::ShaderReloaderClass()
+{
+	m_device = 0;
+	m_shaderCache = 0;
+	memset(&m_format, 0, sizeof(m_format));
+	m_interval = SHADER_RELOAD_INTERVAL;
+	m_sourceKey = 0;
+	m_quit = false;
+	m_checkNow = false;
+	memset(&m_statistics, 0, sizeof(m_statistics));
+	m_reloadedShader = 0;
+}
+
+ShaderReloaderClass::ShaderReloaderClass(const ShaderReloaderClass& other)
+{
+}
+
+ShaderReloaderClass::~ShaderReloaderClass()
+{
+}
+
+/*Initialize remembers how the color shader was made, the same device, cache, description, archive and vertex format,
+hashes the sources as they are now and starts the thread that looks at them every interval milliseconds. When the
+description or its sources can't be read there is nothing to watch, the shaders only come from the archive. The
+reloader then stays off, which is not an error, see IsWatching.*/
+bool ShaderReloaderClass::Initialize(RenderDeviceClass* device, ShaderCacheClass* shaderCache, const char* descriptionFile,
+	const char* archiveFile, const VertexFormatType& format, int interval)
+{
+	PROFILE_FUNCTION();
+
+	m_device = device;
+	m_shaderCache = shaderCache;
+	m_descriptionFile = descriptionFile;
+	m_archiveFile = archiveFile;
+	m_format = format;
+	m_interval = interval > 0 ? interval : SHADER_RELOAD_INTERVAL;
+	m_quit = false;
+	m_checkNow = false;
+	memset(&m_statistics, 0, sizeof(m_statistics));
+
+	// The shader that is running now was made from these sources, only a change after this is reloaded.
+	if (!GetSourceKey(m_sourceKey))
+	{
+		return true;
+	}
+
+	m_thread = thread(&ShaderReloaderClass::WatchLoop, this);
+
+	return true;
+}
+
+/*Shutdown stops the thread, waiting for a compile that is still going on, and releases a shader the render thread
+never picked up.*/
+void ShaderReloaderClass::Shutdown()
+{
+	{
+		lock_guard<mutex> lock(m_mutex);
+		m_quit = true;
+	}
+	m_wake.notify_all();
+
+	if (m_thread.joinable())
+	{
+		m_thread.join();
+	}
+
+	ReleaseShader(m_reloadedShader.exchange(0));
+
+	m_shaderCache = 0;
+	m_device = 0;
+
+	return;
+}
+
+/*CheckNow wakes the thread up to look at the sources right away instead of at the end of the interval.*/
+void ShaderReloaderClass::CheckNow()
+{
+	{
+		lock_guard<mutex> lock(m_mutex);
+		m_checkNow = true;
+	}
+	m_wake.notify_all();
+
+	return;
+}
+
+/*IsWatching tells if the thread is looking at the sources, it isn't when Initialize found nothing to watch.*/
+bool ShaderReloaderClass::IsWatching()
+{
+	return m_thread.joinable();
+}
+
+/*GetReloadedShader hands the newest shader the thread finished over to the caller, who shuts the old one down and uses
+this one from now on. It returns 0 when nothing was reloaded since the last call. It never waits, the handover is a
+single atomic exchange.*/
+ColorShaderClass* ShaderReloaderClass::GetReloadedShader()
+{
+	return m_reloadedShader.exchange(0);
+}
+
+ShaderReloadStatisticsType ShaderReloaderClass::GetStatistics()
+{
+	lock_guard<mutex> lock(m_mutex);
+
+	return m_statistics;
+}
+
+/*WatchLoop sleeps for the interval, or until CheckNow, and compiles a new color shader when the sources changed. A
+change that doesn't compile isn't tried again until the sources change once more.*/
+void ShaderReloaderClass::WatchLoop()
+{
+	ColorShaderClass* shader;
+	TimerClass timer;
+	chrono::steady_clock::time_point deadline;
+	unsigned long long sourceKey;
+	double elapsed;
+	bool changed;
+
+	PROFILE_THREAD_NAME("Shader reloader");
+
+	while (true)
+	{
+		{
+			unique_lock<mutex> lock(m_mutex);
+			deadline = chrono::steady_clock::now() + chrono::milliseconds(m_interval);
+			while (!m_quit && !m_checkNow && m_wake.wait_until(lock, deadline) == cv_status::no_timeout)
+			{
+			}
+			if (m_quit)
+			{
+				break;
+			}
+			m_checkNow = false;
+		}
+
+		// A source that can't be read right now is probably being saved, it is looked at again next time.
+		changed = GetSourceKey(sourceKey) && sourceKey != m_sourceKey;
+		shader = 0;
+		elapsed = 0.0;
+		if (changed)
+		{
+			m_sourceKey = sourceKey;
+
+			timer.Start();
+			shader = CompileShader();
+			elapsed = timer.GetElapsedMilliseconds();
+		}
+
+		// Hand the shader over. One from an earlier change the render thread never picked up is out of date now.
+		if (shader)
+		{
+			ReleaseShader(m_reloadedShader.exchange(shader));
+		}
+
+		// The check is only counted once its shader has been handed over.
+		{
+			lock_guard<mutex> lock(m_mutex);
+			m_statistics.checks++;
+			if (changed)
+			{
+				if (shader)
+				{
+					m_statistics.reloads++;
+				}
+				else
+				{
+					m_statistics.failures++;
+				}
+				m_statistics.lastCompileMilliseconds = elapsed;
+			}
+		}
+	}
+
+	return;
+}
+
+/*GetSourceKey hashes the description and the sources it compiles, it fails when one of them can't be read.*/
+bool ShaderReloaderClass::GetSourceKey(unsigned long long& key)
+{
+	ShaderDescriptionType description;
+	string errors;
+	bool result;
+
+	result = ShaderArchiveClass::ReadDescription(m_descriptionFile.c_str(), description, errors);
+	if (!result)
+	{
+		return false;
+	}
+
+	return ShaderArchiveClass::GetSourceKey(m_descriptionFile.c_str(), description, key);
+}
+
+/*CompileShader makes a complete color shader from the sources as they are now. The archive is opened again so an
+archive that was built in the meantime is used, otherwise the changed shaders are compiled through the cache. There is
+no window to show errors on from this thread, ColorShaderClass writes them to shader-error.txt and stderr and the errors
+of the description go to ShowError without a window, which writes them to stderr as well.*/
+ColorShaderClass* ShaderReloaderClass::CompileShader()
+{
+	PROFILE_FUNCTION();
+
+	ShaderArchiveClass* shaderArchive;
+	ColorShaderClass* shader;
+	string errors;
+	bool result;
+
+	shaderArchive = new ShaderArchiveClass;
+	if (!shaderArchive)
+	{
+		return 0;
+	}
+
+	result = shaderArchive->Initialize(m_device, m_shaderCache, m_descriptionFile.c_str(), m_archiveFile.c_str(), errors);
+	if (!result)
+	{
+		ShowError(NULL, errors, L"Shader reloader");
+		shaderArchive->Shutdown();
+		delete shaderArchive;
+		return 0;
+	}
+
+	shader = new ColorShaderClass;
+	if (shader)
+	{
+		result = shader->Initialize(m_device, shaderArchive, NULL, m_format);
+		if (!result)
+		{
+			ReleaseShader(shader);
+			shader = 0;
+		}
+	}
+
+	shaderArchive->Shutdown();
+	delete shaderArchive;
+	shaderArchive = 0;
+
+	return shader;
+}
+
+void ShaderReloaderClass::ReleaseShader(ColorShaderClass* shader)
+{
+	if (shader)
+	{
+		shader->Shutdown();
+		delete shader;
+	}
+
+	return;
+}
@@ -0,0 +1,109 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: shaderreloaderclass.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _SHADERRELOADERCLASS_H_
+#define _SHADERRELOADERCLASS_H_
+
+
+/*Editing shaders while the game runs is for development, so the reloader is on in debug builds and Graphics doesn't
+create it in release builds, which then don't hash the sources over and over. A release build that should still
+reload shaders can define SHADER_RELOAD_ENABLED=1 in its preprocessor definitions.*/
+#ifndef SHADER_RELOAD_ENABLED
+#ifdef NDEBUG
+#define SHADER_RELOAD_ENABLED 0
+#else
+#define SHADER_RELOAD_ENABLED 1
+#endif
+#endif
+
+
+//////////////
+// INCLUDES //
+//////////////
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include "colorshaderclass.h"
+#include "shaderarchiveclass.h"
+#include "shadercacheclass.h"
+using namespace std;
+
+
+/////////////
+// GLOBALS //
+/////////////
+/*How many milliseconds the reloader waits between two looks at the shader sources.*/
+const int SHADER_RELOAD_INTERVAL = 250;
+
+
+/////////////
+// TYPEDEFS //
+/////////////
+/*What the reloader did since it started. A reload is a color shader that was compiled and handed to the render
+thread, a failure a change that didn't compile, after which the old shader stayed.*/
+struct ShaderReloadStatisticsType
+{
+	int checks;
+	int reloads;
+	int failures;
+	double lastCompileMilliseconds;
+};
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: ShaderReloaderClass
+////////////////////////////////////////////////////////////////////////////////
+/*The ShaderReloaderClass lets the shaders be edited while the game runs. Its thread hashes the permutation description
+and every source it compiles, with everything those include, the way ShaderArchiveClass::GetSourceKey does. When the
+hash changes it builds a complete new ColorShaderClass on that thread, through a shader archive that sees the archive
+file is out of date and compiles the changed shaders through the shader cache.
+
+The new shader is only handed over, the render thread picks it up with GetReloadedShader at the start of a frame and
+swaps it in, so a frame never uses two different shaders and never waits for the compiler. When the change doesn't
+compile the error goes to shader-error.txt like any other compile error, nothing is handed over and the old shader stays
+until the sources change again. Hashing the contents instead of looking at file times also catches an editor that saves
+a file in two steps: the half written file fails and the complete one is compiled a moment later.
+
+A game that ships with only the shader archive has no description or sources to watch, then the reloader stays off and
+never starts its thread. Once the reloader runs, the shader cache belongs to its thread.*/
+class ShaderReloaderClass
+{
+public:
+	ShaderReloaderClass();
+	ShaderReloaderClass(const ShaderReloaderClass&);
+	~ShaderReloaderClass();
+
+	bool Initialize(RenderDeviceClass*, ShaderCacheClass*, const char*, const char*, const VertexFormatType&, int);
+	void Shutdown();
+
+	void CheckNow();
+	bool IsWatching();
+	ColorShaderClass* GetReloadedShader();
+	ShaderReloadStatisticsType GetStatistics();
+
+private:
+	void WatchLoop();
+	bool GetSourceKey(unsigned long long&);
+	ColorShaderClass* CompileShader();
+	void ReleaseShader(ColorShaderClass*);
+
+private:
+	RenderDeviceClass* m_device;
+	ShaderCacheClass* m_shaderCache;
+	string m_descriptionFile;
+	string m_archiveFile;
+	VertexFormatType m_format;
+	int m_interval;
+	unsigned long long m_sourceKey;
+
+	thread m_thread;
+	mutex m_mutex;
+	condition_variable m_wake;
+	bool m_quit, m_checkNow;
+	ShaderReloadStatisticsType m_statistics;
+	atomic<ColorShaderClass*> m_reloadedShader;
+};
+
+#endif
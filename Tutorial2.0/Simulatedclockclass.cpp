@@ -0,0 +1,122 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: simulatedclockclass.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "simulatedclockclass.h"
+#include <math.h>
+
+SimulatedClockClass::SimulatedClockClass()
+{
+	m_time = 0.0;
+	m_gpuTime = 0.0;
+	m_refreshInterval = 0.0;
+	m_gpuFreeTime = 0.0;
+	m_lastDisplayTime = 0.0;
+	m_completedFrames = 0;
+}
+
+SimulatedClockClass::SimulatedClockClass(const SimulatedClockClass& other)
+{
+}
+
+SimulatedClockClass::~SimulatedClockClass()
+{
+}
+
+/*Initialize takes how many seconds the GPU draws a frame and the refresh interval of the screen in seconds, 0 shows
+every frame as soon as it is drawn like a present without vsync.*/
+bool SimulatedClockClass::Initialize(double gpuTime, double refreshInterval)
+{
+	if (gpuTime < 0.0 || refreshInterval < 0.0)
+	{
+		return false;
+	}
+
+	m_time = 0.0;
+	m_gpuTime = gpuTime;
+	m_refreshInterval = refreshInterval;
+	m_gpuFreeTime = 0.0;
+	m_lastDisplayTime = -refreshInterval;
+	m_displayTimes.clear();
+	m_completedFrames = 0;
+
+	return true;
+}
+
+void SimulatedClockClass::Shutdown()
+{
+	m_displayTimes.clear();
+
+	return;
+}
+
+double SimulatedClockClass::GetTime()
+{
+	return m_time;
+}
+
+/*WaitUntil jumps to the time, waiting doesn't take any real time here.*/
+void SimulatedClockClass::WaitUntil(double time)
+{
+	if (time > m_time)
+	{
+		m_time = time;
+	}
+
+	return;
+}
+
+/*OnPresent works out when the GPU finishes the frame and when the screen shows it.*/
+void SimulatedClockClass::OnPresent()
+{
+	double finishTime, displayTime;
+
+	finishTime = (m_time > m_gpuFreeTime ? m_time : m_gpuFreeTime) + m_gpuTime;
+	m_gpuFreeTime = finishTime;
+
+	displayTime = finishTime;
+	if (m_refreshInterval > 0.0)
+	{
+		displayTime = ceil(finishTime / m_refreshInterval) * m_refreshInterval;
+		if (displayTime < m_lastDisplayTime + m_refreshInterval)
+		{
+			displayTime = m_lastDisplayTime + m_refreshInterval;
+		}
+	}
+	m_lastDisplayTime = displayTime;
+
+	m_displayTimes.push_back(displayTime);
+
+	return;
+}
+
+unsigned long long SimulatedClockClass::GetCompletedFrames()
+{
+	while (m_completedFrames < m_displayTimes.size() && m_displayTimes[(size_t)m_completedFrames] <= m_time)
+	{
+		m_completedFrames++;
+	}
+
+	return m_completedFrames;
+}
+
+/*Advance moves the time on, for the work the CPU does in a frame.*/
+void SimulatedClockClass::Advance(double seconds)
+{
+	if (seconds > 0.0)
+	{
+		m_time += seconds;
+	}
+
+	return;
+}
+
+/*GetDisplayTime returns when a presented frame is shown, counting from the first present as frame 0.*/
+double SimulatedClockClass::GetDisplayTime(unsigned long long frame)
+{
+	if (frame >= m_displayTimes.size())
+	{
+		return 0.0;
+	}
+
+	return m_displayTimes[(size_t)frame];
+}
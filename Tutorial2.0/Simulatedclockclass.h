@@ -0,0 +1,55 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: simulatedclockclass.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _SIMULATEDCLOCKCLASS_H_
+#define _SIMULATEDCLOCKCLASS_H_
+
+
+//////////////
+// INCLUDES //
+//////////////
+#include <vector>
+#include "presentclockclass.h"
+using namespace std;
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: SimulatedClockClass
+////////////////////////////////////////////////////////////////////////////////
+/*The SimulatedClockClass is a present clock for the benchmark. Its time starts at zero and only moves when the frame
+waits or when Advance says the CPU worked for a while, so a run of hundreds of frames takes no time at all and comes
+out the same every time.
+
+The GPU draws the presented frames one after the other, each in the GPU time, starting when the frame is presented
+or when it finished the one before. With a refresh interval a finished frame is shown on the next vsync that hasn't
+shown a frame yet, without one it is shown right away. A frame is completed once it is shown. There are as many back
+buffers as the frames in flight need.*/
+class SimulatedClockClass : public PresentClockClass
+{
+public:
+	SimulatedClockClass();
+	SimulatedClockClass(const SimulatedClockClass&);
+	~SimulatedClockClass();
+
+	bool Initialize(double, double);
+	void Shutdown();
+
+	double GetTime();
+	void WaitUntil(double);
+	void OnPresent();
+	unsigned long long GetCompletedFrames();
+
+	void Advance(double);
+	double GetDisplayTime(unsigned long long);
+
+private:
+	double m_time;
+	double m_gpuTime;
+	double m_refreshInterval;
+	double m_gpuFreeTime;
+	double m_lastDisplayTime;
+	vector<double> m_displayTimes;
+	unsigned long long m_completedFrames;
+};
+
+#endif
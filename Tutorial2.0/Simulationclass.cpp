@@ -0,0 +1,286 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: simulationclass.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "simulationclass.h"
+#include "profilerclass.h"
+#include "timerclass.h"
+#include <chrono>
+#include <string.h>
+
+SimulationClass::SimulationClass()
+{
+	m_writeSnapshot = 0;
+	m_readSnapshot = 1;
+	m_newestSnapshot = 2;
+	m_step = 0;
+	m_startTime = 0.0;
+	memset(&m_statistics, 0, sizeof(m_statistics));
+	m_quit = false;
+}
+
+SimulationClass::SimulationClass(const SimulationClass& other)
+{
+}
+
+SimulationClass::~SimulationClass()
+{
+}
+
+/*Initialize starts the simulation at step zero with no objects. With startThread the steps run on a thread of their
+own from now on, without it the caller runs them with Step.*/
+bool SimulationClass::Initialize(bool startThread)
+{
+	PROFILE_FUNCTION();
+
+	int i;
+
+	for (i = 0; i < SIMULATION_SNAPSHOT_COUNT; i++)
+	{
+		m_snapshots[i].step = 0;
+		m_snapshots[i].time = 0.0;
+		m_snapshots[i].previousAngles.clear();
+		m_snapshots[i].angles.clear();
+	}
+	m_writeSnapshot = 0;
+	m_readSnapshot = 1;
+	m_newestSnapshot = 2;
+
+	m_angles.clear();
+	m_step = 0;
+	m_startTime = TimerClass::GetTimeSeconds();
+	memset(&m_statistics, 0, sizeof(m_statistics));
+	m_quit = false;
+
+	// The render thread gets a snapshot of step zero until the first step is done.
+	SetObjectCount(0);
+
+	if (startThread)
+	{
+		m_thread = thread(&SimulationClass::SimulateLoop, this);
+	}
+
+	return true;
+}
+
+/*Shutdown stops the simulation thread, the step it is running is finished first.*/
+void SimulationClass::Shutdown()
+{
+	{
+		lock_guard<mutex> lock(m_mutex);
+		m_quit = true;
+	}
+	m_wake.notify_all();
+
+	if (m_thread.joinable())
+	{
+		m_thread.join();
+	}
+
+	m_angles.clear();
+
+	return;
+}
+
+/*SetObjectCount changes how many objects the scene has. The objects that were there already keep their state, new
+ones start out at angle zero. It publishes a snapshot right away, with no motion in it, so the render thread never
+gets a snapshot with the old number of objects after this.*/
+void SimulationClass::SetObjectCount(int count)
+{
+	SimulationSnapshotType* snapshot;
+
+	lock_guard<mutex> lock(m_stateMutex);
+
+	m_angles.resize(count > 0 ? count : 0, 0.0f);
+
+	snapshot = &m_snapshots[m_writeSnapshot];
+	snapshot->step = m_step;
+	snapshot->time = m_startTime + (double)m_step * SIMULATION_TIMESTEP;
+	snapshot->previousAngles = m_angles;
+	snapshot->angles = m_angles;
+	Publish();
+
+	return;
+}
+
+/*Step runs one step of the simulation on the calling thread. It is only for a simulation without a thread.*/
+void SimulationClass::Step()
+{
+	lock_guard<mutex> lock(m_stateMutex);
+
+	RunStep();
+
+	return;
+}
+
+/*AcquireSnapshot gives the render thread the newest snapshot. It stays the same, and is not written, until the next
+call; it is the same one as last time when no step was published in between. Only one thread may call it.*/
+const SimulationSnapshotType* SimulationClass::AcquireSnapshot()
+{
+	// Only swap when there is something new, otherwise the written snapshot could come back as the newest one.
+	if (m_newestSnapshot.load(memory_order_relaxed) & SIMULATION_SNAPSHOT_NEW)
+	{
+		m_readSnapshot = m_newestSnapshot.exchange(m_readSnapshot, memory_order_acq_rel) & ~SIMULATION_SNAPSHOT_NEW;
+	}
+
+	return &m_snapshots[m_readSnapshot];
+}
+
+SimulationStatisticsType SimulationClass::GetStatistics()
+{
+	lock_guard<mutex> lock(m_stateMutex);
+
+	return m_statistics;
+}
+
+/*GetSpin returns how fast an object spins in radians per second. The speed cycles through four multiples of
+SIMULATION_SPIN_SPEED and every other object spins the other way.*/
+float SimulationClass::GetSpin(int index)
+{
+	return SIMULATION_SPIN_SPEED * (float)(1 + index % 4) * (index % 2 == 0 ? 1.0f : -1.0f);
+}
+
+/*GetBlend returns how far a frame drawn at time, on the clock of TimerClass::GetTimeSeconds, is between the state
+before and after the step of the snapshot. The frame draws the scene one timestep in the past, so the blend is 0 when
+the step is due and 1 one timestep later. It is clamped, a frame that is further ahead than that draws the newest state.*/
+float SimulationClass::GetBlend(const SimulationSnapshotType* snapshot, double time)
+{
+	float blend;
+
+	blend = (float)((time - snapshot->time) / SIMULATION_TIMESTEP);
+	if (blend < 0.0f)
+	{
+		blend = 0.0f;
+	}
+	if (blend > 1.0f)
+	{
+		blend = 1.0f;
+	}
+
+	return blend;
+}
+
+/*InterpolateAngle blends two angles in [0, 2 pi) the short way around, so an object that crosses zero keeps spinning
+the same way.*/
+float SimulationClass::InterpolateAngle(float previous, float current, float blend)
+{
+	const float pi = 3.14159265f;
+	float difference;
+
+	difference = current - previous;
+	if (difference > pi)
+	{
+		difference -= 2.0f * pi;
+	}
+	else if (difference < -pi)
+	{
+		difference += 2.0f * pi;
+	}
+
+	return previous + difference * blend;
+}
+
+/*SimulateLoop sleeps until the next step is due and runs it. When it woke up late it runs all the steps that are due,
+up to SIMULATION_MAX_STEPS, and drops the rest so the game skips ahead instead of racing to catch up.*/
+void SimulationClass::SimulateLoop()
+{
+	chrono::steady_clock::time_point deadline;
+	double due, now;
+	long long behind;
+	int steps;
+
+	PROFILE_THREAD_NAME("Simulation");
+
+	while (true)
+	{
+		// Only this thread changes the step and the start time while it runs, it can read them without the lock.
+		due = m_startTime + (double)(m_step + 1) * SIMULATION_TIMESTEP;
+		deadline = chrono::steady_clock::time_point(chrono::duration_cast<chrono::steady_clock::duration>(chrono::duration<double>(due))) +
+			chrono::steady_clock::duration(1);
+
+		{
+			unique_lock<mutex> lock(m_mutex);
+			while (!m_quit && m_wake.wait_until(lock, deadline) == cv_status::no_timeout)
+			{
+			}
+			if (m_quit)
+			{
+				break;
+			}
+		}
+
+		now = TimerClass::GetTimeSeconds();
+
+		lock_guard<mutex> lock(m_stateMutex);
+
+		steps = 0;
+		while (m_startTime + (double)(m_step + 1) * SIMULATION_TIMESTEP <= now && steps < SIMULATION_MAX_STEPS)
+		{
+			RunStep();
+			steps++;
+		}
+
+		if (steps == SIMULATION_MAX_STEPS)
+		{
+			behind = (long long)((now - m_startTime) / SIMULATION_TIMESTEP) - m_step;
+			if (behind > 0)
+			{
+				m_startTime += (double)behind * SIMULATION_TIMESTEP;
+				m_statistics.droppedSteps += behind;
+			}
+		}
+	}
+
+	return;
+}
+
+/*RunStep advances every object by one timestep and publishes the result. The state mutex must be held.*/
+void SimulationClass::RunStep()
+{
+	PROFILE_FUNCTION();
+
+	const float twoPi = 6.28318531f;
+	SimulationSnapshotType* snapshot;
+	TimerClass timer;
+	size_t i;
+	float angle;
+
+	timer.Start();
+
+	snapshot = &m_snapshots[m_writeSnapshot];
+	snapshot->previousAngles = m_angles;
+
+	for (i = 0; i < m_angles.size(); i++)
+	{
+		angle = m_angles[i] + GetSpin((int)i) * (float)SIMULATION_TIMESTEP;
+		if (angle >= twoPi)
+		{
+			angle -= twoPi;
+		}
+		else if (angle < 0.0f)
+		{
+			angle += twoPi;
+		}
+		m_angles[i] = angle;
+	}
+	m_step++;
+
+	snapshot->step = m_step;
+	snapshot->time = m_startTime + (double)m_step * SIMULATION_TIMESTEP;
+	snapshot->angles = m_angles;
+	Publish();
+
+	m_statistics.steps++;
+	m_statistics.lastStepMilliseconds = timer.GetElapsedMilliseconds();
+
+	return;
+}
+
+/*Publish makes the written snapshot the newest one and takes the one that was the newest to write the next step into.
+The release half of the exchange hands everything written to the snapshot over to the render thread, the acquire half
+makes sure the render thread is done with a snapshot it gave back. The state mutex must be held.*/
+void SimulationClass::Publish()
+{
+	m_writeSnapshot = m_newestSnapshot.exchange(m_writeSnapshot | SIMULATION_SNAPSHOT_NEW, memory_order_acq_rel) & ~SIMULATION_SNAPSHOT_NEW;
+
+	return;
+}
@@ -0,0 +1,113 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: simulationclass.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _SIMULATIONCLASS_H_
+#define _SIMULATIONCLASS_H_
+
+
+//////////////
+// INCLUDES //
+//////////////
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+using namespace std;
+
+
+/////////////
+// GLOBALS //
+/////////////
+/*How many seconds of game time one step of the simulation takes, whatever the frame rate is.*/
+const double SIMULATION_TIMESTEP = 1.0 / 60.0;
+/*How many steps the simulation thread catches up on at once. When it falls further behind, because the machine was
+suspended or a debugger stopped it, the rest is dropped instead of running the game at full speed until it caught up.*/
+const int SIMULATION_MAX_STEPS = 8;
+/*How fast the objects spin around their z axis, in radians per second. Every object gets a multiple of this.*/
+const float SIMULATION_SPIN_SPEED = 0.5f;
+/*The snapshots the simulation thread, the render thread and the one in between use, see SimulationClass.*/
+const int SIMULATION_SNAPSHOT_COUNT = 3;
+/*Set on the index of the newest snapshot from when it is published until the render thread takes it.*/
+const int SIMULATION_SNAPSHOT_NEW = 4;
+
+
+/////////////
+// TYPEDEFS //
+/////////////
+/*The state of the scene after a step, and before it so the render thread can interpolate between the two. time is
+when the step is due on the clock of TimerClass::GetTimeSeconds, the state before it was due one timestep earlier.*/
+struct SimulationSnapshotType
+{
+	long long step;
+	double time;
+	vector<float> previousAngles;
+	vector<float> angles;
+};
+
+/*How many steps the simulation ran and dropped and how long the last step took.*/
+struct SimulationStatisticsType
+{
+	long long steps;
+	long long droppedSteps;
+	double lastStepMilliseconds;
+};
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: SimulationClass
+////////////////////////////////////////////////////////////////////////////////
+/*The SimulationClass updates the scene with a fixed timestep on a thread of its own, so the game runs at the same speed
+however long a frame takes and the frames wait for the vsync without holding up the game. For now the scene is the
+spin of the separate objects of Graphics, one angle per object.
+
+Every step is written into a snapshot and published to the render thread. There are three snapshots: the one the
+simulation thread is writing, the one the render thread is reading and the newest finished one. Publishing swaps the
+written snapshot with the newest one and AcquireSnapshot swaps the read one with the newest one, each a single atomic
+exchange, so neither thread ever waits for the other and the render thread always gets a whole step. A snapshot holds
+the state before and after its step. The frame draws the scene one timestep in the past, between the two at GetBlend,
+so the motion is smooth even when the frame rate isn't a multiple of the step rate.
+
+Without the thread, see Initialize, the caller runs the steps itself with Step, which is how the benchmark checks the
+snapshots step by step.*/
+class SimulationClass
+{
+public:
+	SimulationClass();
+	SimulationClass(const SimulationClass&);
+	~SimulationClass();
+
+	bool Initialize(bool);
+	void Shutdown();
+
+	void SetObjectCount(int);
+	void Step();
+	const SimulationSnapshotType* AcquireSnapshot();
+	SimulationStatisticsType GetStatistics();
+
+	static float GetSpin(int);
+	static float GetBlend(const SimulationSnapshotType*, double);
+	static float InterpolateAngle(float, float, float);
+
+private:
+	void SimulateLoop();
+	void RunStep();
+	void Publish();
+
+private:
+	SimulationSnapshotType m_snapshots[SIMULATION_SNAPSHOT_COUNT];
+	int m_writeSnapshot;
+	int m_readSnapshot;
+	atomic<int> m_newestSnapshot;
+	mutex m_stateMutex;
+	vector<float> m_angles;
+	long long m_step;
+	double m_startTime;
+	SimulationStatisticsType m_statistics;
+	thread m_thread;
+	mutex m_mutex;
+	condition_variable m_wake;
+	bool m_quit;
+};
+
+#endif
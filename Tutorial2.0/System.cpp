@@ -2,6 +2,7 @@
 // Filename: systemclass.cpp
 ////////////////////////////////////
 #include "System.h"
+#include "profilerclass.h"
 
 // In the class constructor I initialize the object pointers to null.
 // This is important because if the initialization of these objects 
@@ -14,6 +15,14 @@ System::System()
 {
 	m_Input = 0;
 	m_Graphics = 0;
+	m_JobSystem = 0;
+	m_Simulation = 0;
+	m_FrameClock = 0;
+	m_FramePacer = 0;
+	m_CameraController = 0;
+	m_InputLog = 0;
+	m_recordFile = "";
+	m_firstFrame = true;
 }
 
 /*Here I create an empty copy constructor and empty class destructor. 
@@ -49,7 +58,9 @@ System::~System()
 // the application will use for handling user input and rendering graphics to the screen.
 bool System::Initialize()
 {
-	int screenWidth, screenHeight;
+	PROFILE_FUNCTION();
+
+	int screenWidth, screenHeight, threadCount;
 	bool result;
 
 	// Initialize the with and height of the screen to zero before sending the 
@@ -71,6 +82,23 @@ bool System::Initialize()
 	// Initialize the input object.
 	m_Input->Initialize();
 
+	/*The job system runs on every core but this one, the window thread, which runs jobs too while it waits for them
+	and runs the jobs that have to be on the window thread once a frame.*/
+	// Create the job system object.
+	m_JobSystem = new JobSystemClass;
+	if (!m_JobSystem)
+	{
+		return false;
+	}
+
+	// Initialize the job system object.
+	threadCount = (int)thread::hardware_concurrency() - 1;
+	result = m_JobSystem->Initialize(threadCount > 0 ? threadCount : 0);
+	if (!result)
+	{
+		return false;
+	}
+
 	// Create the grapchis obkect.
 	// This object will handle rendering all the grahpics for this application
 	m_Graphics = new Graphics;
@@ -80,8 +108,71 @@ bool System::Initialize()
 	}
 
 	// Initialize the grapchis object.
-	result = m_Graphics->Initialize(screenWidth, screenHeight, m_hwnd);
+	result = m_Graphics->Initialize(screenWidth, screenHeight, m_hwnd, m_JobSystem);
+
+	if (!result)
+	{
+		return false;
+	}
+
+	/*The game is updated with a fixed timestep on a thread of its own, so it runs at the same speed whatever the frame
+	rate is and a slow frame or the wait for the vsync doesn't hold it up. The graphics object draws its snapshots.*/
+	// Create the simulation object.
+	m_Simulation = new SimulationClass;
+	if (!m_Simulation)
+	{
+		return false;
+	}
+
+	// Initialize the simulation object and start its thread.
+	result = m_Simulation->Initialize(true);
+	if (!result)
+	{
+		return false;
+	}
+
+	m_Graphics->SetSimulation(m_Simulation);
 
+	/*The frame pacer keeps the CPU from running more than MAX_FRAMES_IN_FLIGHT frames ahead of the GPU, caps the frame
+	rate and measures how long the input waits for the frame that shows it. It gets the time and the finished frames
+	from the frame clock.*/
+	// Create the frame clock object.
+	m_FrameClock = new DeviceClockClass;
+	if (!m_FrameClock)
+	{
+		return false;
+	}
+
+	// Initialize the frame clock object.
+	result = m_FrameClock->Initialize(m_Graphics->GetRenderDevice());
+	if (!result)
+	{
+		return false;
+	}
+
+	// Create the frame pacer object.
+	m_FramePacer = new FramePacerClass;
+	if (!m_FramePacer)
+	{
+		return false;
+	}
+
+	// Initialize the frame pacer object.
+	result = m_FramePacer->Initialize(m_FrameClock, MAX_FRAMES_IN_FLIGHT, FRAME_RATE_CAP);
+	if (!result)
+	{
+		return false;
+	}
+
+	// Create the camera controller object, it flies the camera of the graphics object with the keyboard.
+	m_CameraController = new CameraControllerClass;
+	if (!m_CameraController)
+	{
+		return false;
+	}
+
+	// Initialize the camera controller object.
+	result = m_CameraController->Initialize(m_Graphics->GetCamera());
 	if (!result)
 	{
 		return false;
@@ -90,6 +181,22 @@ bool System::Initialize()
 	return true;
 }
 
+/*StartRecording records the frame time and the input events of every frame from now on, Shutdown writes them to the
+file. The Benchmark project replays the file to draw the same frames without a window, see InputLogClass.*/
+bool System::StartRecording(const char* filename)
+{
+	m_InputLog = new InputLogClass;
+	if (!m_InputLog)
+	{
+		return false;
+	}
+
+	m_InputLog->BeginRecording(TimerClass::GetTimeSeconds());
+	m_recordFile = filename;
+
+	return true;
+}
+
 /*The Run function is where our application will loop and do all the application processing
 until we decide to quit. The application processing is done in the Frame function which
 is called each loop. This is an important concept to understand as now the rest
@@ -119,6 +226,9 @@ void System::Run()
 	done = false;
 	while (!done)
 	{
+		// Wait until the next frame may start, before the messages are handled so it gets the newest input.
+		m_FramePacer->BeginFrame();
+
 		// Handle the windows messages
 		// http://www.directxtutorial.com/Lesson.aspx?lessonid=9-1-4
 		/* PeekMessage() just looks into the message queue and checks to see if 
@@ -129,18 +239,21 @@ void System::Run()
 		or PM_NOREMOVE. The first one takes the messages off the queue when they are read, 
 		while the second one leaves the messages there for later retrieval. We will use 
 		the PM_REMOVE value here, and keep things simple.*/
-		if (PeekMessage(&msg, NULL, 0, 0, PM_REMOVE))
+		// All the messages that came in are handled before the frame, one a frame would leave input waiting for
+		// frames that don't need it.
+		while (PeekMessage(&msg, NULL, 0, 0, PM_REMOVE))
 		{
 			TranslateMessage(&msg);
 			DispatchMessage(&msg);
-		}
 
-		// if windows signals to end the application then exit out
-		if (msg.message == WM_QUIT)
-		{
-			done = true;
+			// if windows signals to end the application then exit out
+			if (msg.message == WM_QUIT)
+			{
+				done = true;
+			}
 		}
-		else
+
+		if (!done)
 		{
 			// Otherwise do the grame processing.
 			result = Frame();
@@ -161,20 +274,53 @@ to do its frame processing which will render the graphics for that frame.
 As the application grows we'll place more code inside here. */
 bool System::Frame()
 {
+	PROFILE_FUNCTION();
+
 	bool result;
+	float frameTime;
+
+	// The time since the last frame, everything that moves with the input uses this one.
+	frameTime = m_firstFrame ? 0.0f : (float)(m_frameTimer.GetElapsedMilliseconds() / 1000.0);
+	m_frameTimer.Start();
+	m_firstFrame = false;
+
+	// Take the input events of this frame out of the queue.
+	m_Input->Update();
+
+	// Record them with the frame time when a recording runs.
+	if (m_InputLog)
+	{
+		m_InputLog->RecordFrame(frameTime, m_Input->GetFrameEvents());
+	}
 
-	// Check if the user pressed escape and wants to exit the application.
-	if (m_Input->IsKeyDown(VK_ESCAPE))
+	// Tell the frame pacer when the oldest of them came in, it measures how long it takes to show up on the screen.
+	if (!m_Input->GetFrameEvents().empty())
+	{
+		m_FramePacer->AddInput(m_Input->GetFrameEvents().front().time);
+	}
+
+	// Check if the user pressed escape and wants to exit the application, a tap between two frames counts too.
+	if (m_Input->IsKeyPressed(VK_ESCAPE) || m_Input->IsKeyDown(VK_ESCAPE))
 	{
 		return false;
 	}
 
+	// Move the camera for the keys that are down.
+	m_CameraController->Frame(m_Input, frameTime);
+
+	// Run the jobs that were waiting for the window thread.
+	m_JobSystem->RunMainThreadJobs();
+
 	// Do the frame processing for the graphics object.
 	result = m_Graphics->Frame();
 	if (!result)
 	{
 		return false;
 	}
+
+	// The frame was presented.
+	m_FramePacer->EndFrame();
+
 	return true;
 }
 
@@ -192,6 +338,8 @@ It will make sense later why I placed the global in that file instead of the hea
 for this file. */
 void System::InitializeWindows(int& screenWidth, int& screenHeight) // 
 {
+	PROFILE_FUNCTION();
+
 	WNDCLASSEX wc; //Contains window class information. It is used with the RegisterClassEx and GetClassInfoEx  functions.
 	DEVMODE dmScreenSettings; // The DEVMODE data structure contains information about the initialization and environment of a display device.
 	int posX, posY;
@@ -292,6 +440,41 @@ void System::InitializeWindows(int& screenWidth, int& screenHeight) //
 // as well it also shuts down the window and cleans up  the handles assiciated with it.
 void System::Shutdown()
 {
+	// Write the recording and release the input log object.
+	if (m_InputLog)
+	{
+		if (!m_InputLog->Save(m_recordFile.c_str()))
+		{
+			ShowError(m_hwnd, L"Could not write the input recording.", L"Error");
+		}
+		delete m_InputLog;
+		m_InputLog = 0;
+	}
+
+	// Release the camera controller object.
+	if (m_CameraController)
+	{
+		m_CameraController->Shutdown();
+		delete m_CameraController;
+		m_CameraController = 0;
+	}
+
+	// Release the frame pacer object.
+	if (m_FramePacer)
+	{
+		m_FramePacer->Shutdown();
+		delete m_FramePacer;
+		m_FramePacer = 0;
+	}
+
+	// Release the frame clock object, before the graphics object with the device it looks at.
+	if (m_FrameClock)
+	{
+		m_FrameClock->Shutdown();
+		delete m_FrameClock;
+		m_FrameClock = 0;
+	}
+
 	//Release the grapchis object.
 	if (m_Graphics)
 	{
@@ -300,6 +483,22 @@ void System::Shutdown()
 		m_Graphics = 0;
 	}
 
+	// Release the simulation object, after the graphics object that draws its snapshots.
+	if (m_Simulation)
+	{
+		m_Simulation->Shutdown();
+		delete m_Simulation;
+		m_Simulation = 0;
+	}
+
+	// Release the job system object.
+	if (m_JobSystem)
+	{
+		m_JobSystem->Shutdown();
+		delete m_JobSystem;
+		m_JobSystem = 0;
+	}
+
 	// Release the input object.
 	if (m_Input)
 	{
@@ -357,6 +556,7 @@ LRESULT CALLBACK System::MessageHandler(HWND hwnd, UINT umsg, WPARAM wparam, LPA
 	{
 		//if a key is pressed send it to the input object so it can record that state.
 		m_Input->KeyDown((unsigned int)wparam);
+
 		return 0;
 	}
 
@@ -365,6 +565,7 @@ LRESULT CALLBACK System::MessageHandler(HWND hwnd, UINT umsg, WPARAM wparam, LPA
 	{
 		// if a key is released then send it to the input object so it can unset the tate for that key
 		m_Input->KeyUp((unsigned int)wparam);
+
 		return 0;
 	}
 
@@ -31,6 +31,14 @@ delete this line if you need all of them*/
 // My own class includes
 #include "Input.h" /* For handeling user input */
 #include "Graphics.h" /* for handeling the directX graphics code*/
+#include "jobsystemclass.h" /* for spreading engine work over the cores */
+#include "simulationclass.h" /* for updating the game at a fixed rate on its own thread */
+#include "framepacerclass.h" /* for deciding when the next frame starts */
+#include "deviceclockclass.h"
+#include "cameracontrollerclass.h" /* for flying the camera with the keyboard */
+#include "inputlogclass.h" /* for recording the input so the benchmark can replay it */
+#include "timerclass.h"
+#include <string>
 
 ///////////////////////////////
 // Class name: SystemClass
@@ -49,6 +57,7 @@ public:
 
 	bool Initialize();
 	void Shutdown();
+	bool StartRecording(const char*);
 	void Run();
 
 	LRESULT CALLBACK MessageHandler(HWND, UINT, WPARAM, LPARAM);
@@ -73,6 +82,15 @@ private:
 
 	Input* m_Input;
 	Graphics* m_Graphics;
+	JobSystemClass* m_JobSystem;
+	SimulationClass* m_Simulation;
+	DeviceClockClass* m_FrameClock;
+	FramePacerClass* m_FramePacer;
+	CameraControllerClass* m_CameraController;
+	InputLogClass* m_InputLog;
+	std::string m_recordFile;
+	TimerClass m_frameTimer;
+	bool m_firstFrame;
 };
 
 ///////////////////////////////
@@ -0,0 +1,102 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: textureclass.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "textureclass.h"
+#include "profilerclass.h"
+
+TextureClass::TextureClass()
+{
+	m_device = 0;
+	m_texture = 0;
+	m_width = 0;
+	m_height = 0;
+	m_mipCount = 0;
+	m_format = RENDER_FORMAT_UNKNOWN;
+}
+
+TextureClass::TextureClass(const TextureClass& other)
+{
+}
+
+TextureClass::~TextureClass()
+{
+}
+
+/*Initialize opens the texture file and hands every mip level to the device where it is mapped, the file is closed
+again once the texture holds its own copy. When the TGA file can't be imported errors tells why.*/
+bool TextureClass::Initialize(RenderDeviceClass* device, const char* filename, const TexturePresetType& preset, JobSystemClass* jobSystem,
+	string& errors)
+{
+	PROFILE_FUNCTION();
+
+	TextureFileClass file;
+	RenderTextureData levels[TEXTURE_MAX_MIPS];
+	int i;
+	bool result;
+
+	// Keep the device around so the texture can be released again.
+	m_device = device;
+
+	result = file.Open(filename, preset, jobSystem, errors);
+	if (!result)
+	{
+		return false;
+	}
+
+	m_width = file.GetWidth();
+	m_height = file.GetHeight();
+	m_mipCount = file.GetMipCount();
+	m_format = file.GetFormat();
+
+	for (i = 0; i < m_mipCount; i++)
+	{
+		levels[i].data = file.GetMipData(i);
+		levels[i].rowPitch = file.GetMip(i).rowPitch;
+	}
+
+	result = device->CreateTexture((unsigned int)m_width, (unsigned int)m_height, (unsigned int)m_mipCount, m_format, levels, m_texture);
+	file.Close();
+	if (!result)
+	{
+		return false;
+	}
+
+	return true;
+}
+
+void TextureClass::Shutdown()
+{
+	// Release the texture.
+	if (m_texture)
+	{
+		m_device->ReleaseTexture(m_texture);
+		m_texture = 0;
+	}
+
+	return;
+}
+
+RenderTexture TextureClass::GetTexture()
+{
+	return m_texture;
+}
+
+int TextureClass::GetWidth()
+{
+	return m_width;
+}
+
+int TextureClass::GetHeight()
+{
+	return m_height;
+}
+
+int TextureClass::GetMipCount()
+{
+	return m_mipCount;
+}
+
+RenderFormat TextureClass::GetFormat()
+{
+	return m_format;
+}
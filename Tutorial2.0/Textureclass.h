@@ -0,0 +1,44 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: textureclass.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _TEXTURECLASS_H_
+#define _TEXTURECLASS_H_
+
+
+//////////////
+// INCLUDES //
+//////////////
+#include "renderdeviceclass.h"
+#include "texturefileclass.h"
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: TextureClass
+////////////////////////////////////////////////////////////////////////////////
+/*The TextureClass is the ModelClass of textures: it opens a texture file (see the TextureFileClass), importing a TGA
+file the first time with the given preset, and creates the texture with all its mip levels straight from the mapped
+file.*/
+class TextureClass
+{
+public:
+	TextureClass();
+	TextureClass(const TextureClass&);
+	~TextureClass();
+
+	bool Initialize(RenderDeviceClass*, const char*, const TexturePresetType&, JobSystemClass*, string&);
+	void Shutdown();
+
+	RenderTexture GetTexture();
+	int GetWidth();
+	int GetHeight();
+	int GetMipCount();
+	RenderFormat GetFormat();
+
+private:
+	RenderDeviceClass* m_device;
+	RenderTexture m_texture;
+	int m_width, m_height, m_mipCount;
+	RenderFormat m_format;
+};
+
+#endif
@@ -0,0 +1,1038 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: texturecompressorclass.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "texturecompressorclass.h"
+#include "profilerclass.h"
+#include <emmintrin.h>
+#include <float.h>
+#include <math.h>
+#include <string.h>
+
+
+/////////////
+// GLOBALS //
+/////////////
+// The weights of the 16 values between the two endpoints of a BC7 mode 6 block, in 64ths.
+static const int BC7_WEIGHTS[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+// The weights of the palette entries of BC1 and BC3 blocks, index 0 and 1 are the endpoints.
+static const float COLOR_WEIGHTS[4] = { 0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f };
+static const float ALPHA_WEIGHTS[8] = { 0.0f, 1.0f, 1.0f / 7.0f, 2.0f / 7.0f, 3.0f / 7.0f, 4.0f / 7.0f, 5.0f / 7.0f, 6.0f / 7.0f };
+
+static const int POWER_ITERATIONS = 8;
+
+
+/////////////
+// TYPEDEFS //
+/////////////
+/*A 4x4 block of texels as a structure of arrays: the red, green, blue and alpha of the 16 texels, row by row.*/
+struct TextureBlockType
+{
+	float channels[4][16];
+};
+
+/*What the workers need to compress their rows of blocks.*/
+struct CompressJobType
+{
+	const unsigned char* texels;
+	int width;
+	int height;
+	int blocksWide;
+	RenderFormat format;
+	TextureQuality quality;
+	unsigned char* blocks;
+};
+
+
+///////////////////////
+// FUNCTION PROTOTYPES //
+///////////////////////
+static void LoadBlock(const unsigned char*, int, int, int, int, TextureBlockType&);
+static float FindIndices(const TextureBlockType&, const float[][4], int, int, int, int*);
+static void FitEndpoints(const TextureBlockType&, int, int, float*, float*);
+static bool RefineEndpoints(const TextureBlockType&, int, int, const int*, const float*, float*, float*);
+static void EncodeColorBlock(const TextureBlockType&, TextureQuality, unsigned char*);
+static void EncodeAlphaBlock(const TextureBlockType&, TextureQuality, unsigned char*);
+static void EncodeBc7Block(const TextureBlockType&, TextureQuality, unsigned char*);
+static void DecodeColorBlock(const unsigned char*, bool, unsigned char*);
+static void DecodeAlphaBlock(const unsigned char*, unsigned char*);
+static void DecodeBc7Block(const unsigned char*, unsigned char*);
+static void BuildColorPalette(unsigned short, unsigned short, float[][4]);
+static void BuildAlphaPalette(int, int, float[][4]);
+static void BuildBc7Palette(const float*, const float*, int, int, int*, int*, float[][4]);
+static unsigned short PackColor(const float*);
+static void UnpackColor(unsigned short, int*);
+static void WriteBits(unsigned char*, int&, unsigned int, int);
+static unsigned int ReadBits(const unsigned char*, int&, int);
+static int GetRefinements(TextureQuality);
+
+
+/*ChooseFormat returns the format a texture is stored in with the given preset. Without a format in the preset opaque
+textures become BC1 and textures with alpha BC3, or BC7 with the high quality preset. Block compressed textures have
+to be a multiple of 4 texels wide and high, others stay RGBA.*/
+RenderFormat TextureCompressorClass::ChooseFormat(const unsigned char* texels, int width, int height, const TexturePresetType& preset)
+{
+	size_t i, count;
+
+	if (width % 4 != 0 || height % 4 != 0)
+	{
+		return RENDER_FORMAT_R8G8B8A8_UNORM;
+	}
+
+	if (preset.format != RENDER_FORMAT_UNKNOWN)
+	{
+		return preset.format;
+	}
+
+	count = (size_t)width * height;
+	for (i = 0; i < count; i++)
+	{
+		if (texels[i * 4 + 3] != 255)
+		{
+			return preset.quality == TEXTURE_QUALITY_HIGH ? RENDER_FORMAT_BC7_UNORM : RENDER_FORMAT_BC3_UNORM;
+		}
+	}
+
+	return RENDER_FORMAT_BC1_UNORM;
+}
+
+bool TextureCompressorClass::IsBlockCompressed(RenderFormat format)
+{
+	return GetBlockBytes(format) > 0;
+}
+
+/*GetBlockBytes returns the size of one 4x4 block, or 0 for formats that aren't block compressed.*/
+int TextureCompressorClass::GetBlockBytes(RenderFormat format)
+{
+	switch (format)
+	{
+	case RENDER_FORMAT_BC1_UNORM:
+		return 8;
+	case RENDER_FORMAT_BC3_UNORM:
+	case RENDER_FORMAT_BC7_UNORM:
+		return 16;
+	default:
+		return 0;
+	}
+}
+
+/*GetRowPitch and GetRowCount return the bytes of one row of a texture level and its number of rows. A row of a block
+compressed level is a row of blocks, textures that aren't compressed are RGBA.*/
+int TextureCompressorClass::GetRowPitch(RenderFormat format, int width)
+{
+	return IsBlockCompressed(format) ? (width + 3) / 4 * GetBlockBytes(format) : width * 4;
+}
+
+int TextureCompressorClass::GetRowCount(RenderFormat format, int height)
+{
+	return IsBlockCompressed(format) ? (height + 3) / 4 : height;
+}
+
+/*Compress compresses RGBA texels into blocks of the given format, the rows of blocks one after the other. Blocks that
+stick out of the texture repeat its last column and row. The rows are spread over the job system when there is one.*/
+bool TextureCompressorClass::Compress(const unsigned char* texels, int width, int height, RenderFormat format, TextureQuality quality,
+	JobSystemClass* jobSystem, unsigned char* blocks)
+{
+	PROFILE_FUNCTION();
+
+	CompressJobType job;
+	int blocksHigh;
+
+	if (!IsBlockCompressed(format) || width <= 0 || height <= 0)
+	{
+		return false;
+	}
+
+	job.texels = texels;
+	job.width = width;
+	job.height = height;
+	job.blocksWide = (width + 3) / 4;
+	job.format = format;
+	job.quality = quality;
+	job.blocks = blocks;
+
+	blocksHigh = (height + 3) / 4;
+	if (jobSystem)
+	{
+		jobSystem->ParallelFor(blocksHigh, TEXTURE_COMPRESSOR_BATCH_SIZE, CompressRows, &job);
+	}
+	else
+	{
+		CompressRows(&job, 0, blocksHigh);
+	}
+
+	return true;
+}
+
+/*Decompress turns blocks written by Compress back into RGBA texels.*/
+bool TextureCompressorClass::Decompress(const unsigned char* blocks, int width, int height, RenderFormat format, unsigned char* texels)
+{
+	unsigned char decoded[64];
+	const unsigned char* block;
+	int blockBytes, blocksWide, blockX, blockY, x, y, texelX, texelY;
+
+	blockBytes = GetBlockBytes(format);
+	if (blockBytes == 0)
+	{
+		return false;
+	}
+
+	blocksWide = (width + 3) / 4;
+	for (blockY = 0; blockY < (height + 3) / 4; blockY++)
+	{
+		for (blockX = 0; blockX < blocksWide; blockX++)
+		{
+			block = blocks + ((size_t)blockY * blocksWide + blockX) * blockBytes;
+			switch (format)
+			{
+			case RENDER_FORMAT_BC1_UNORM:
+				DecodeColorBlock(block, true, decoded);
+				break;
+			case RENDER_FORMAT_BC3_UNORM:
+				DecodeColorBlock(block + 8, false, decoded);
+				DecodeAlphaBlock(block, decoded);
+				break;
+			default:
+				DecodeBc7Block(block, decoded);
+				break;
+			}
+
+			// Only the texels inside the texture are copied out.
+			for (y = 0; y < 4; y++)
+			{
+				texelY = blockY * 4 + y;
+				for (x = 0; x < 4 && texelY < height; x++)
+				{
+					texelX = blockX * 4 + x;
+					if (texelX < width)
+					{
+						memcpy(texels + ((size_t)texelY * width + texelX) * 4, decoded + (y * 4 + x) * 4, 4);
+					}
+				}
+			}
+		}
+	}
+
+	return true;
+}
+
+/*GetPsnr returns the peak signal to noise ratio in decibels between two RGBA images, over red, green and blue or over
+all four channels. Identical images return 100 instead of infinity.*/
+double TextureCompressorClass::GetPsnr(const unsigned char* original, const unsigned char* compressed, int width, int height, bool alpha)
+{
+	double sum, difference, meanSquaredError;
+	size_t i, count;
+	int channel, channels;
+
+	channels = alpha ? 4 : 3;
+	count = (size_t)width * height;
+
+	sum = 0.0;
+	for (i = 0; i < count; i++)
+	{
+		for (channel = 0; channel < channels; channel++)
+		{
+			difference = (double)original[i * 4 + channel] - (double)compressed[i * 4 + channel];
+			sum += difference * difference;
+		}
+	}
+
+	meanSquaredError = sum / ((double)count * channels);
+	if (meanSquaredError == 0.0)
+	{
+		return 100.0;
+	}
+
+	return 10.0 * log10(255.0 * 255.0 / meanSquaredError);
+}
+
+/*CompressRows is the work of one batch of the parallel for: compressing the rows of blocks [begin, end).*/
+void TextureCompressorClass::CompressRows(void* data, int begin, int end)
+{
+	CompressJobType* job;
+	TextureBlockType block;
+	unsigned char* output;
+	int blockBytes, blockX, blockY;
+
+	job = (CompressJobType*)data;
+	blockBytes = GetBlockBytes(job->format);
+
+	for (blockY = begin; blockY < end; blockY++)
+	{
+		for (blockX = 0; blockX < job->blocksWide; blockX++)
+		{
+			LoadBlock(job->texels, job->width, job->height, blockX, blockY, block);
+			output = job->blocks + ((size_t)blockY * job->blocksWide + blockX) * blockBytes;
+
+			switch (job->format)
+			{
+			case RENDER_FORMAT_BC1_UNORM:
+				EncodeColorBlock(block, job->quality, output);
+				break;
+			case RENDER_FORMAT_BC3_UNORM:
+				EncodeAlphaBlock(block, job->quality, output);
+				EncodeColorBlock(block, job->quality, output + 8);
+				break;
+			default:
+				EncodeBc7Block(block, job->quality, output);
+				break;
+			}
+		}
+	}
+
+	return;
+}
+
+/*LoadBlock reads one 4x4 block of texels into floats. A row that is inside the texture is 16 bytes that SSE2 widens
+to four texels of four floats, transposing those gives the four channels of the row. Rows and columns past the edge
+repeat the last one.*/
+static void LoadBlock(const unsigned char* texels, int width, int height, int blockX, int blockY, TextureBlockType& block)
+{
+	const unsigned char* row;
+	__m128i texelRow, zero, low, high;
+	__m128 red, green, blue, alpha;
+	int x, y, sourceX, sourceY, channel;
+
+	zero = _mm_setzero_si128();
+
+	for (y = 0; y < 4; y++)
+	{
+		sourceY = blockY * 4 + y < height ? blockY * 4 + y : height - 1;
+		row = texels + (size_t)sourceY * width * 4;
+
+		if (blockX * 4 + 4 <= width)
+		{
+			texelRow = _mm_loadu_si128((const __m128i*)(row + blockX * 16));
+			low = _mm_unpacklo_epi8(texelRow, zero);
+			high = _mm_unpackhi_epi8(texelRow, zero);
+
+			// Each of these holds one texel until the transpose turns them into one channel each.
+			red = _mm_cvtepi32_ps(_mm_unpacklo_epi16(low, zero));
+			green = _mm_cvtepi32_ps(_mm_unpackhi_epi16(low, zero));
+			blue = _mm_cvtepi32_ps(_mm_unpacklo_epi16(high, zero));
+			alpha = _mm_cvtepi32_ps(_mm_unpackhi_epi16(high, zero));
+			_MM_TRANSPOSE4_PS(red, green, blue, alpha);
+
+			_mm_storeu_ps(&block.channels[0][y * 4], red);
+			_mm_storeu_ps(&block.channels[1][y * 4], green);
+			_mm_storeu_ps(&block.channels[2][y * 4], blue);
+			_mm_storeu_ps(&block.channels[3][y * 4], alpha);
+		}
+		else
+		{
+			for (x = 0; x < 4; x++)
+			{
+				sourceX = blockX * 4 + x < width ? blockX * 4 + x : width - 1;
+				for (channel = 0; channel < 4; channel++)
+				{
+					block.channels[channel][y * 4 + x] = (float)row[sourceX * 4 + channel];
+				}
+			}
+		}
+	}
+
+	return;
+}
+
+/*FindIndices picks the nearest palette entry for every texel of the block over the given channels and returns the
+sum of the squared distances. Four texels are done at a time, every palette entry is compared with all four and the
+closer ones take its index.*/
+static float FindIndices(const TextureBlockType& block, const float palette[][4], int paletteSize, int firstChannel, int channelCount,
+	int* indices)
+{
+	__m128 best, distance, difference, closer, total;
+	__m128i bestIndex, index;
+	float errors[4];
+	int group, entry, channel;
+
+	total = _mm_setzero_ps();
+
+	for (group = 0; group < 4; group++)
+	{
+		best = _mm_set1_ps(FLT_MAX);
+		bestIndex = _mm_setzero_si128();
+
+		for (entry = 0; entry < paletteSize; entry++)
+		{
+			distance = _mm_setzero_ps();
+			for (channel = firstChannel; channel < firstChannel + channelCount; channel++)
+			{
+				difference = _mm_sub_ps(_mm_loadu_ps(&block.channels[channel][group * 4]), _mm_set1_ps(palette[entry][channel]));
+				distance = _mm_add_ps(distance, _mm_mul_ps(difference, difference));
+			}
+
+			// Ties keep the earlier entry.
+			closer = _mm_cmplt_ps(distance, best);
+			best = _mm_min_ps(distance, best);
+			index = _mm_set1_epi32(entry);
+			bestIndex = _mm_or_si128(_mm_and_si128(_mm_castps_si128(closer), index), _mm_andnot_si128(_mm_castps_si128(closer), bestIndex));
+		}
+
+		_mm_storeu_si128((__m128i*)(indices + group * 4), bestIndex);
+		total = _mm_add_ps(total, best);
+	}
+
+	_mm_storeu_ps(errors, total);
+
+	return errors[0] + errors[1] + errors[2] + errors[3];
+}
+
+/*FitEndpoints finds the line through the texels of the block that their colors spread along the most, the principal
+axis of their covariance, and returns the two ends of the texels on it. The axis is found by power iteration starting
+from the channel that varies the most.*/
+static void FitEndpoints(const TextureBlockType& block, int firstChannel, int channelCount, float* low, float* high)
+{
+	float mean[4], covariance[4][4], axis[4], next[4], projection, minimum, maximum, largest, length;
+	int i, j, texel, iteration, lastChannel;
+
+	lastChannel = firstChannel + channelCount;
+
+	for (i = firstChannel; i < lastChannel; i++)
+	{
+		mean[i] = 0.0f;
+		for (texel = 0; texel < 16; texel++)
+		{
+			mean[i] += block.channels[i][texel];
+		}
+		mean[i] /= 16.0f;
+	}
+
+	for (i = firstChannel; i < lastChannel; i++)
+	{
+		for (j = i; j < lastChannel; j++)
+		{
+			covariance[i][j] = 0.0f;
+			for (texel = 0; texel < 16; texel++)
+			{
+				covariance[i][j] += (block.channels[i][texel] - mean[i]) * (block.channels[j][texel] - mean[j]);
+			}
+			covariance[j][i] = covariance[i][j];
+		}
+	}
+
+	// Start from the row of the channel that varies the most, a block of one color has no axis at all.
+	largest = 0.0f;
+	j = firstChannel;
+	for (i = firstChannel; i < lastChannel; i++)
+	{
+		if (covariance[i][i] > largest)
+		{
+			largest = covariance[i][i];
+			j = i;
+		}
+	}
+
+	if (largest < 1.0e-3f)
+	{
+		for (i = firstChannel; i < lastChannel; i++)
+		{
+			low[i] = mean[i];
+			high[i] = mean[i];
+		}
+		return;
+	}
+
+	for (i = firstChannel; i < lastChannel; i++)
+	{
+		axis[i] = covariance[j][i];
+	}
+
+	for (iteration = 0; iteration < POWER_ITERATIONS; iteration++)
+	{
+		length = 0.0f;
+		for (i = firstChannel; i < lastChannel; i++)
+		{
+			next[i] = 0.0f;
+			for (j = firstChannel; j < lastChannel; j++)
+			{
+				next[i] += covariance[i][j] * axis[j];
+			}
+			length = fabsf(next[i]) > length ? fabsf(next[i]) : length;
+		}
+
+		if (length == 0.0f)
+		{
+			break;
+		}
+
+		for (i = firstChannel; i < lastChannel; i++)
+		{
+			axis[i] = next[i] / length;
+		}
+	}
+
+	length = 0.0f;
+	for (i = firstChannel; i < lastChannel; i++)
+	{
+		length += axis[i] * axis[i];
+	}
+	length = sqrtf(length);
+	for (i = firstChannel; i < lastChannel; i++)
+	{
+		axis[i] /= length;
+	}
+
+	// The ends are the texels furthest along the axis either way.
+	minimum = FLT_MAX;
+	maximum = -FLT_MAX;
+	for (texel = 0; texel < 16; texel++)
+	{
+		projection = 0.0f;
+		for (i = firstChannel; i < lastChannel; i++)
+		{
+			projection += (block.channels[i][texel] - mean[i]) * axis[i];
+		}
+		minimum = projection < minimum ? projection : minimum;
+		maximum = projection > maximum ? projection : maximum;
+	}
+
+	for (i = firstChannel; i < lastChannel; i++)
+	{
+		low[i] = mean[i] + minimum * axis[i];
+		high[i] = mean[i] + maximum * axis[i];
+		low[i] = low[i] < 0.0f ? 0.0f : (low[i] > 255.0f ? 255.0f : low[i]);
+		high[i] = high[i] < 0.0f ? 0.0f : (high[i] > 255.0f ? 255.0f : high[i]);
+	}
+
+	return;
+}
+
+/*RefineEndpoints moves the endpoints to where they fit the texels best for the indices they got: every texel is
+the mix (1 - w) low + w high for the weight w of its index, and the least squares solution of that for every channel
+is a 2x2 system. It returns false when all texels got the same weight and the system has no single solution.*/
+static bool RefineEndpoints(const TextureBlockType& block, int firstChannel, int channelCount, const int* indices, const float* weights,
+	float* low, float* high)
+{
+	float lowLow, lowHigh, highHigh, lowSum[4], highSum[4], weight, inverse, determinant;
+	int texel, channel;
+
+	lowLow = 0.0f;
+	lowHigh = 0.0f;
+	highHigh = 0.0f;
+	for (channel = firstChannel; channel < firstChannel + channelCount; channel++)
+	{
+		lowSum[channel] = 0.0f;
+		highSum[channel] = 0.0f;
+	}
+
+	for (texel = 0; texel < 16; texel++)
+	{
+		weight = weights[indices[texel]];
+		inverse = 1.0f - weight;
+		lowLow += inverse * inverse;
+		lowHigh += inverse * weight;
+		highHigh += weight * weight;
+		for (channel = firstChannel; channel < firstChannel + channelCount; channel++)
+		{
+			lowSum[channel] += inverse * block.channels[channel][texel];
+			highSum[channel] += weight * block.channels[channel][texel];
+		}
+	}
+
+	determinant = lowLow * highHigh - lowHigh * lowHigh;
+	if (fabsf(determinant) < 1.0e-6f)
+	{
+		return false;
+	}
+
+	for (channel = firstChannel; channel < firstChannel + channelCount; channel++)
+	{
+		low[channel] = (highHigh * lowSum[channel] - lowHigh * highSum[channel]) / determinant;
+		high[channel] = (lowLow * highSum[channel] - lowHigh * lowSum[channel]) / determinant;
+		low[channel] = low[channel] < 0.0f ? 0.0f : (low[channel] > 255.0f ? 255.0f : low[channel]);
+		high[channel] = high[channel] < 0.0f ? 0.0f : (high[channel] > 255.0f ? 255.0f : high[channel]);
+	}
+
+	return true;
+}
+
+/*EncodeColorBlock writes the 8 byte color block of BC1 and BC3: two 5:6:5 endpoints and 2 bit indices. The first
+endpoint is kept the larger one so BC1 decodes the block in its four color mode.*/
+static void EncodeColorBlock(const TextureBlockType& block, TextureQuality quality, unsigned char* output)
+{
+	float low[4], high[4], palette[16][4], error, bestError;
+	int indices[16], bestIndices[16], refinements, pass, i;
+	unsigned short color0, color1, swap, bestColor0, bestColor1;
+	unsigned int bits;
+
+	FitEndpoints(block, 0, 3, low, high);
+	refinements = GetRefinements(quality);
+
+	bestError = FLT_MAX;
+	bestColor0 = 0;
+	bestColor1 = 0;
+	for (pass = 0; pass <= refinements; pass++)
+	{
+		color0 = PackColor(low);
+		color1 = PackColor(high);
+		if (color0 < color1)
+		{
+			swap = color0;
+			color0 = color1;
+			color1 = swap;
+		}
+
+		BuildColorPalette(color0, color1, palette);
+		error = FindIndices(block, palette, 4, 0, 3, indices);
+		if (error < bestError)
+		{
+			bestError = error;
+			bestColor0 = color0;
+			bestColor1 = color1;
+			memcpy(bestIndices, indices, sizeof(indices));
+		}
+
+		// Fit the endpoints to the indices of this pass for the next one.
+		if (pass == refinements || !RefineEndpoints(block, 0, 3, indices, COLOR_WEIGHTS, low, high))
+		{
+			break;
+		}
+	}
+
+	bits = 0;
+	for (i = 0; i < 16; i++)
+	{
+		bits |= (unsigned int)bestIndices[i] << (i * 2);
+	}
+
+	output[0] = (unsigned char)(bestColor0 & 0xff);
+	output[1] = (unsigned char)(bestColor0 >> 8);
+	output[2] = (unsigned char)(bestColor1 & 0xff);
+	output[3] = (unsigned char)(bestColor1 >> 8);
+	output[4] = (unsigned char)(bits & 0xff);
+	output[5] = (unsigned char)((bits >> 8) & 0xff);
+	output[6] = (unsigned char)((bits >> 16) & 0xff);
+	output[7] = (unsigned char)(bits >> 24);
+
+	return;
+}
+
+/*EncodeAlphaBlock writes the 8 byte alpha block of BC3: two 8 bit endpoints, the first the larger one so there are
+six values between them, and 3 bit indices.*/
+static void EncodeAlphaBlock(const TextureBlockType& block, TextureQuality quality, unsigned char* output)
+{
+	float low[4], high[4], palette[16][4], error, bestError, minimum, maximum;
+	int indices[16], bestIndices[16], refinements, pass, alpha0, alpha1, swap, bestAlpha0, bestAlpha1, i, position;
+
+	minimum = 255.0f;
+	maximum = 0.0f;
+	for (i = 0; i < 16; i++)
+	{
+		minimum = block.channels[3][i] < minimum ? block.channels[3][i] : minimum;
+		maximum = block.channels[3][i] > maximum ? block.channels[3][i] : maximum;
+	}
+	low[3] = maximum;
+	high[3] = minimum;
+
+	refinements = GetRefinements(quality);
+
+	bestError = FLT_MAX;
+	bestAlpha0 = (int)(maximum + 0.5f);
+	bestAlpha1 = bestAlpha0;
+	memset(bestIndices, 0, sizeof(bestIndices));
+	for (pass = 0; pass <= refinements; pass++)
+	{
+		alpha0 = (int)(low[3] + 0.5f);
+		alpha1 = (int)(high[3] + 0.5f);
+		if (alpha0 < alpha1)
+		{
+			swap = alpha0;
+			alpha0 = alpha1;
+			alpha1 = swap;
+		}
+
+		// A block of one alpha needs no indices, equal endpoints would also switch to the other mode.
+		if (alpha0 == alpha1)
+		{
+			if (pass == 0)
+			{
+				bestAlpha0 = alpha0;
+				bestAlpha1 = alpha1;
+			}
+			break;
+		}
+
+		BuildAlphaPalette(alpha0, alpha1, palette);
+		error = FindIndices(block, palette, 8, 3, 1, indices);
+		if (error < bestError)
+		{
+			bestError = error;
+			bestAlpha0 = alpha0;
+			bestAlpha1 = alpha1;
+			memcpy(bestIndices, indices, sizeof(indices));
+		}
+
+		low[3] = (float)alpha0;
+		high[3] = (float)alpha1;
+		if (pass == refinements || !RefineEndpoints(block, 3, 1, indices, ALPHA_WEIGHTS, low, high))
+		{
+			break;
+		}
+	}
+
+	memset(output, 0, 8);
+	output[0] = (unsigned char)bestAlpha0;
+	output[1] = (unsigned char)bestAlpha1;
+	position = 16;
+	for (i = 0; i < 16; i++)
+	{
+		WriteBits(output, position, (unsigned int)bestIndices[i], 3);
+	}
+
+	return;
+}
+
+/*EncodeBc7Block writes a 16 byte BC7 block in mode 6: the mode bit, two RGBA endpoints of 7 bits per channel, a
+parity bit per endpoint that is the lowest bit of all its channels, and 4 bit indices. The first index has no top bit,
+so the endpoints are swapped when it would need one.*/
+static void EncodeBc7Block(const TextureBlockType& block, TextureQuality quality, unsigned char* output)
+{
+	float low[4], high[4], palette[16][4], weights[16], error, bestError;
+	int indices[16], bestIndices[16], quantized0[4], quantized1[4], best0[4], best1[4], swap[4];
+	int refinements, pass, parity0, parity1, bestParity0, bestParity1, combination, i, position;
+
+	for (i = 0; i < 16; i++)
+	{
+		weights[i] = (float)BC7_WEIGHTS[i] / 64.0f;
+	}
+
+	FitEndpoints(block, 0, 4, low, high);
+	refinements = GetRefinements(quality);
+
+	bestError = FLT_MAX;
+	bestParity0 = 0;
+	bestParity1 = 0;
+	for (pass = 0; pass <= refinements; pass++)
+	{
+		// The high preset tries all four parity bits, the others the ones closest to the endpoints.
+		for (combination = 0; combination < 4; combination++)
+		{
+			if (quality == TEXTURE_QUALITY_HIGH)
+			{
+				parity0 = combination & 1;
+				parity1 = combination >> 1;
+			}
+			else
+			{
+				parity0 = -1;
+				parity1 = -1;
+			}
+
+			BuildBc7Palette(low, high, parity0, parity1, quantized0, quantized1, palette);
+			error = FindIndices(block, palette, 16, 0, 4, indices);
+			if (error < bestError)
+			{
+				bestError = error;
+				bestParity0 = quantized0[0] & 1;
+				bestParity1 = quantized1[0] & 1;
+				for (i = 0; i < 4; i++)
+				{
+					best0[i] = quantized0[i] >> 1;
+					best1[i] = quantized1[i] >> 1;
+				}
+				memcpy(bestIndices, indices, sizeof(indices));
+			}
+
+			if (quality != TEXTURE_QUALITY_HIGH)
+			{
+				break;
+			}
+		}
+
+		if (pass == refinements || !RefineEndpoints(block, 0, 4, bestIndices, weights, low, high))
+		{
+			break;
+		}
+	}
+
+	// The first index must fit in 3 bits.
+	if (bestIndices[0] >= 8)
+	{
+		memcpy(swap, best0, sizeof(swap));
+		memcpy(best0, best1, sizeof(swap));
+		memcpy(best1, swap, sizeof(swap));
+		i = bestParity0;
+		bestParity0 = bestParity1;
+		bestParity1 = i;
+		for (i = 0; i < 16; i++)
+		{
+			bestIndices[i] = 15 - bestIndices[i];
+		}
+	}
+
+	memset(output, 0, 16);
+	position = 0;
+	WriteBits(output, position, 1 << 6, 7);
+	for (i = 0; i < 4; i++)
+	{
+		WriteBits(output, position, (unsigned int)best0[i], 7);
+		WriteBits(output, position, (unsigned int)best1[i], 7);
+	}
+	WriteBits(output, position, (unsigned int)bestParity0, 1);
+	WriteBits(output, position, (unsigned int)bestParity1, 1);
+	WriteBits(output, position, (unsigned int)bestIndices[0], 3);
+	for (i = 1; i < 16; i++)
+	{
+		WriteBits(output, position, (unsigned int)bestIndices[i], 4);
+	}
+
+	return;
+}
+
+/*DecodeColorBlock decodes a BC1 or BC3 color block into 16 opaque RGBA texels. Only BC1 has the three color mode
+with transparent black when the first endpoint isn't the larger one.*/
+static void DecodeColorBlock(const unsigned char* input, bool bc1, unsigned char* texels)
+{
+	int colors[4][3], channel, i, index;
+	unsigned short color0, color1;
+	unsigned int bits;
+	bool threeColors;
+
+	color0 = (unsigned short)(input[0] | (input[1] << 8));
+	color1 = (unsigned short)(input[2] | (input[3] << 8));
+	bits = (unsigned int)input[4] | ((unsigned int)input[5] << 8) | ((unsigned int)input[6] << 16) | ((unsigned int)input[7] << 24);
+
+	UnpackColor(color0, colors[0]);
+	UnpackColor(color1, colors[1]);
+	threeColors = bc1 && color0 <= color1;
+	for (channel = 0; channel < 3; channel++)
+	{
+		if (threeColors)
+		{
+			colors[2][channel] = (colors[0][channel] + colors[1][channel]) / 2;
+			colors[3][channel] = 0;
+		}
+		else
+		{
+			colors[2][channel] = (2 * colors[0][channel] + colors[1][channel]) / 3;
+			colors[3][channel] = (colors[0][channel] + 2 * colors[1][channel]) / 3;
+		}
+	}
+
+	for (i = 0; i < 16; i++)
+	{
+		index = (bits >> (i * 2)) & 3;
+		texels[i * 4] = (unsigned char)colors[index][0];
+		texels[i * 4 + 1] = (unsigned char)colors[index][1];
+		texels[i * 4 + 2] = (unsigned char)colors[index][2];
+		texels[i * 4 + 3] = threeColors && index == 3 ? 0 : 255;
+	}
+
+	return;
+}
+
+/*DecodeAlphaBlock decodes the alpha block of BC3 into the alpha of 16 texels.*/
+static void DecodeAlphaBlock(const unsigned char* input, unsigned char* texels)
+{
+	float palette[16][4];
+	int i, position;
+
+	BuildAlphaPalette(input[0], input[1], palette);
+
+	position = 16;
+	for (i = 0; i < 16; i++)
+	{
+		texels[i * 4 + 3] = (unsigned char)palette[ReadBits(input, position, 3)][3];
+	}
+
+	return;
+}
+
+/*DecodeBc7Block decodes a mode 6 BC7 block into 16 RGBA texels. The other modes are never written by the encoder and
+decode to transparent black.*/
+static void DecodeBc7Block(const unsigned char* input, unsigned char* texels)
+{
+	int endpoint0[4], endpoint1[4], parity0, parity1, index, weight, channel, i, position;
+
+	position = 0;
+	if (ReadBits(input, position, 7) != 1 << 6)
+	{
+		memset(texels, 0, 64);
+		return;
+	}
+
+	for (channel = 0; channel < 4; channel++)
+	{
+		endpoint0[channel] = (int)ReadBits(input, position, 7) << 1;
+		endpoint1[channel] = (int)ReadBits(input, position, 7) << 1;
+	}
+	parity0 = (int)ReadBits(input, position, 1);
+	parity1 = (int)ReadBits(input, position, 1);
+
+	for (i = 0; i < 16; i++)
+	{
+		index = (int)ReadBits(input, position, i == 0 ? 3 : 4);
+		weight = BC7_WEIGHTS[index];
+		for (channel = 0; channel < 4; channel++)
+		{
+			texels[i * 4 + channel] = (unsigned char)(((64 - weight) * (endpoint0[channel] | parity0) + weight * (endpoint1[channel] | parity1) + 32) >> 6);
+		}
+	}
+
+	return;
+}
+
+/*BuildColorPalette expands two 5:6:5 endpoints to the four colors of a four color block, rounded the way the
+decoder rounds them.*/
+static void BuildColorPalette(unsigned short color0, unsigned short color1, float palette[][4])
+{
+	int colors[2][3], channel;
+
+	UnpackColor(color0, colors[0]);
+	UnpackColor(color1, colors[1]);
+
+	for (channel = 0; channel < 3; channel++)
+	{
+		palette[0][channel] = (float)colors[0][channel];
+		palette[1][channel] = (float)colors[1][channel];
+		palette[2][channel] = (float)((2 * colors[0][channel] + colors[1][channel]) / 3);
+		palette[3][channel] = (float)((colors[0][channel] + 2 * colors[1][channel]) / 3);
+	}
+
+	return;
+}
+
+/*BuildAlphaPalette fills the alpha of the eight entries of an alpha block with the first endpoint the larger one.*/
+static void BuildAlphaPalette(int alpha0, int alpha1, float palette[][4])
+{
+	int i;
+
+	palette[0][3] = (float)alpha0;
+	palette[1][3] = (float)alpha1;
+	for (i = 2; i < 8; i++)
+	{
+		palette[i][3] = (float)(((8 - i) * alpha0 + (i - 1) * alpha1 + 3) / 7);
+	}
+
+	return;
+}
+
+/*BuildBc7Palette quantizes two endpoints to 7 bits and a parity bit and fills the 16 entries between them. A parity
+of -1 picks the parity that keeps the endpoint closest. The quantized endpoints come back as 8 bit values with the
+parity in the lowest bit.*/
+static void BuildBc7Palette(const float* low, const float* high, int parity0, int parity1, int* quantized0, int* quantized1,
+	float palette[][4])
+{
+	const float* endpoints[2];
+	int* quantized[2];
+	int parities[2], values[2][4], endpoint, parity, channel, value, i;
+	float error, bestError, difference;
+
+	endpoints[0] = low;
+	endpoints[1] = high;
+	quantized[0] = quantized0;
+	quantized[1] = quantized1;
+	parities[0] = parity0;
+	parities[1] = parity1;
+
+	for (endpoint = 0; endpoint < 2; endpoint++)
+	{
+		bestError = FLT_MAX;
+		for (parity = 0; parity < 2; parity++)
+		{
+			if (parities[endpoint] >= 0 && parities[endpoint] != parity)
+			{
+				continue;
+			}
+
+			error = 0.0f;
+			for (channel = 0; channel < 4; channel++)
+			{
+				value = (int)floorf((endpoints[endpoint][channel] - (float)parity) * 0.5f + 0.5f);
+				value = value < 0 ? 0 : (value > 127 ? 127 : value);
+				values[parity][channel] = value * 2 + parity;
+				difference = (float)values[parity][channel] - endpoints[endpoint][channel];
+				error += difference * difference;
+			}
+
+			if (error < bestError)
+			{
+				bestError = error;
+				memcpy(quantized[endpoint], values[parity], sizeof(values[parity]));
+			}
+		}
+	}
+
+	for (i = 0; i < 16; i++)
+	{
+		for (channel = 0; channel < 4; channel++)
+		{
+			palette[i][channel] = (float)(((64 - BC7_WEIGHTS[i]) * quantized0[channel] + BC7_WEIGHTS[i] * quantized1[channel] + 32) >> 6);
+		}
+	}
+
+	return;
+}
+
+/*PackColor rounds an RGB color to 5:6:5.*/
+static unsigned short PackColor(const float* color)
+{
+	int red, green, blue;
+
+	red = (int)(color[0] * 31.0f / 255.0f + 0.5f);
+	green = (int)(color[1] * 63.0f / 255.0f + 0.5f);
+	blue = (int)(color[2] * 31.0f / 255.0f + 0.5f);
+	red = red < 0 ? 0 : (red > 31 ? 31 : red);
+	green = green < 0 ? 0 : (green > 63 ? 63 : green);
+	blue = blue < 0 ? 0 : (blue > 31 ? 31 : blue);
+
+	return (unsigned short)((red << 11) | (green << 5) | blue);
+}
+
+/*UnpackColor expands a 5:6:5 color to 8 bits per channel by repeating the top bits in the bottom ones.*/
+static void UnpackColor(unsigned short color, int* channels)
+{
+	int red, green, blue;
+
+	red = (color >> 11) & 31;
+	green = (color >> 5) & 63;
+	blue = color & 31;
+
+	channels[0] = (red << 3) | (red >> 2);
+	channels[1] = (green << 2) | (green >> 4);
+	channels[2] = (blue << 3) | (blue >> 2);
+
+	return;
+}
+
+/*WriteBits and ReadBits write and read the lowest bits of a value at a bit position of a block, lowest bit first, and
+move the position past them.*/
+static void WriteBits(unsigned char* block, int& position, unsigned int value, int count)
+{
+	int i;
+
+	for (i = 0; i < count; i++, position++)
+	{
+		block[position >> 3] |= (unsigned char)(((value >> i) & 1) << (position & 7));
+	}
+
+	return;
+}
+
+static unsigned int ReadBits(const unsigned char* block, int& position, int count)
+{
+	unsigned int value;
+	int i;
+
+	value = 0;
+	for (i = 0; i < count; i++, position++)
+	{
+		value |= (unsigned int)((block[position >> 3] >> (position & 7)) & 1) << i;
+	}
+
+	return value;
+}
+
+/*GetRefinements returns how many times the endpoints are fitted to the indices with each preset.*/
+static int GetRefinements(TextureQuality quality)
+{
+	switch (quality)
+	{
+	case TEXTURE_QUALITY_FAST:
+		return 0;
+	case TEXTURE_QUALITY_NORMAL:
+		return 1;
+	default:
+		return 4;
+	}
+}
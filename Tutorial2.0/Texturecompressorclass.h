@@ -0,0 +1,84 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: texturecompressorclass.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _TEXTURECOMPRESSORCLASS_H_
+#define _TEXTURECOMPRESSORCLASS_H_
+
+
+//////////////
+// INCLUDES //
+//////////////
+#include "renderdeviceclass.h"
+#include "jobsystemclass.h"
+
+
+/////////////
+// GLOBALS //
+/////////////
+/*How many rows of 4x4 blocks a job compresses at a time.*/
+const int TEXTURE_COMPRESSOR_BATCH_SIZE = 2;
+
+
+///////////
+// ENUMS //
+///////////
+/*How hard the compressor tries. Fast takes the endpoints of every block from the principal axis of its colors,
+normal refines them once with a least squares fit to the chosen indices and high refines them a few times and, for
+BC7, tries every combination of the parity bits.*/
+enum TextureQuality
+{
+	TEXTURE_QUALITY_FAST,
+	TEXTURE_QUALITY_NORMAL,
+	TEXTURE_QUALITY_HIGH
+};
+
+
+/////////////
+// TYPEDEFS //
+/////////////
+/*What a texture is imported as: the format of the texture and how hard the compressor tries. A format of
+RENDER_FORMAT_UNKNOWN lets the importer pick, see TextureCompressorClass::ChooseFormat.*/
+struct TexturePresetType
+{
+	RenderFormat format;
+	TextureQuality quality;
+};
+
+const TexturePresetType TEXTURE_PRESET_DEFAULT = { RENDER_FORMAT_UNKNOWN, TEXTURE_QUALITY_NORMAL };
+const TexturePresetType TEXTURE_PRESET_UNCOMPRESSED = { RENDER_FORMAT_R8G8B8A8_UNORM, TEXTURE_QUALITY_NORMAL };
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: TextureCompressorClass
+////////////////////////////////////////////////////////////////////////////////
+/*The TextureCompressorClass turns RGBA texels into the block compressed formats the video card samples directly. A
+BC1 texture takes an eighth of the memory and bandwidth of an RGBA one and a BC3 or BC7 texture a quarter.
+
+Every 4x4 block of texels is stored as two endpoint colors and an index per texel into a palette interpolated between
+them. The endpoints come from the principal axis of the colors of the block (found by power iteration on their
+covariance) and are refined with a least squares fit to the indices, the indices are the nearest palette entries.
+The nearest entries are searched with SSE for four texels at a time, the blocks are loaded straight into a structure
+of arrays of floats for that. Rows of blocks are spread over the job system.
+
+BC1 is written in its four color mode for opaque color. BC3 adds a block of alpha with eight interpolated values. Of
+the eight modes of BC7 only mode 6 is written, one pair of 7 bit RGBA endpoints with a parity bit each and 16 values
+between them, which handles opaque and transparent texels alike and is the mode most fast BC7 encoders use. The
+decoders are there to measure the quality of the encoders and only read what the encoders write.*/
+class TextureCompressorClass
+{
+public:
+	static RenderFormat ChooseFormat(const unsigned char*, int, int, const TexturePresetType&);
+	static bool IsBlockCompressed(RenderFormat);
+	static int GetBlockBytes(RenderFormat);
+	static int GetRowPitch(RenderFormat, int);
+	static int GetRowCount(RenderFormat, int);
+
+	static bool Compress(const unsigned char*, int, int, RenderFormat, TextureQuality, JobSystemClass*, unsigned char*);
+	static bool Decompress(const unsigned char*, int, int, RenderFormat, unsigned char*);
+	static double GetPsnr(const unsigned char*, const unsigned char*, int, int, bool);
+
+private:
+	static void CompressRows(void*, int, int);
+};
+
+#endif
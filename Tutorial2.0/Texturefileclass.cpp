@@ -0,0 +1,690 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: texturefileclass.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "texturefileclass.h"
+#include "profilerclass.h"
+#include <emmintrin.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+
+/////////////
+// GLOBALS //
+/////////////
+static const char TEXTURE_FILE_MAGIC[4] = { 'T', 'E', 'X', 'R' };
+static const unsigned long long TEXTURE_LEVEL_ALIGNMENT = 16;
+
+// The parts of a TGA file header we need, the header is 18 bytes without any padding.
+static const size_t TGA_HEADER_SIZE = 18;
+static const int TGA_TYPE_TRUE_COLOR = 2;
+static const int TGA_TYPE_GRAY = 3;
+static const int TGA_TYPE_RLE_TRUE_COLOR = 10;
+static const int TGA_TYPE_RLE_GRAY = 11;
+static const int TGA_DESCRIPTOR_ALPHA_BITS = 0x0f;
+static const int TGA_DESCRIPTOR_RIGHT_TO_LEFT = 0x10;
+static const int TGA_DESCRIPTOR_TOP_TO_BOTTOM = 0x20;
+
+
+///////////////////////
+// FUNCTION PROTOTYPES //
+///////////////////////
+static void ConvertTexels(const unsigned char*, int, int, unsigned int, unsigned int*);
+static unsigned long long AlignOffset(unsigned long long);
+
+
+TextureFileClass::TextureFileClass()
+{
+	m_header = 0;
+}
+
+TextureFileClass::TextureFileClass(const TextureFileClass& other)
+{
+}
+
+TextureFileClass::~TextureFileClass()
+{
+}
+
+/*Open opens a .texture file, or a .tga file through its .texture cache which is imported first when it is missing,
+older than the .tga or imported with another preset. The job system may be null. When the import fails errors tells why.*/
+bool TextureFileClass::Open(const char* filename, const TexturePresetType& preset, JobSystemClass* jobSystem, string& errors)
+{
+	PROFILE_FUNCTION();
+
+	string cacheFile;
+	size_t length;
+	bool result;
+
+	Close();
+
+	// Anything that isn't a .tga file must be a texture file already.
+	length = strlen(filename);
+	if (length < 4 || (strcmp(filename + length - 4, ".tga") != 0 && strcmp(filename + length - 4, ".TGA") != 0))
+	{
+		return OpenTexture(filename);
+	}
+
+	// Use the cache when it is up to date, a cache from an older version fails to open and gets imported again.
+	cacheFile = GetCacheFileName(filename);
+	if (IsCacheCurrent(filename, cacheFile.c_str()))
+	{
+		result = OpenTexture(cacheFile.c_str());
+		if (result && m_header->presetFormat == (unsigned int)preset.format && m_header->presetQuality == (unsigned int)preset.quality)
+		{
+			return true;
+		}
+		Close();
+	}
+
+	result = ImportTga(filename, cacheFile.c_str(), preset, jobSystem, errors);
+	if (!result)
+	{
+		return false;
+	}
+
+	return OpenTexture(cacheFile.c_str());
+}
+
+void TextureFileClass::Close()
+{
+	m_file.Close();
+	m_header = 0;
+
+	return;
+}
+
+int TextureFileClass::GetWidth()
+{
+	return m_header ? (int)m_header->width : 0;
+}
+
+int TextureFileClass::GetHeight()
+{
+	return m_header ? (int)m_header->height : 0;
+}
+
+RenderFormat TextureFileClass::GetFormat()
+{
+	return m_header ? (RenderFormat)m_header->format : RENDER_FORMAT_UNKNOWN;
+}
+
+int TextureFileClass::GetMipCount()
+{
+	return m_header ? (int)m_header->mipCount : 0;
+}
+
+TextureMipType TextureFileClass::GetMip(int level)
+{
+	return m_header->mips[level];
+}
+
+/*GetMipData points into the mapped file, it is only valid until Close.*/
+const void* TextureFileClass::GetMipData(int level)
+{
+	return (const char*)m_file.GetData() + m_header->mips[level].offset;
+}
+
+/*ImportTga turns a TGA file into a texture file with its whole mip chain, in the format the preset asks for. When it
+fails errors tells which file could not be read, compressed or written.*/
+bool TextureFileClass::ImportTga(const char* tgaFile, const char* textureFile, const TexturePresetType& preset, JobSystemClass* jobSystem,
+	string& errors)
+{
+	PROFILE_FUNCTION();
+
+	vector<unsigned char> texels, blocks;
+	vector<TextureMipType> mips, blockMips;
+	RenderFormat format;
+	int width, height;
+	bool result;
+
+	result = ReadTga(tgaFile, texels, width, height);
+	if (!result)
+	{
+		errors = string("Could not import ") + tgaFile + "\n";
+		return false;
+	}
+
+	GenerateMips(texels, width, height, mips);
+
+	format = TextureCompressorClass::ChooseFormat(&texels[0], width, height, preset);
+	if (TextureCompressorClass::IsBlockCompressed(format))
+	{
+		result = CompressMips(texels, mips, format, preset.quality, jobSystem, blocks, blockMips);
+		if (!result)
+		{
+			errors = string("Could not compress ") + tgaFile + "\n";
+			return false;
+		}
+
+		texels.swap(blocks);
+		mips.swap(blockMips);
+	}
+
+	result = WriteTexture(textureFile, preset, format, texels, mips);
+	if (!result)
+	{
+		errors = string("Could not write ") + textureFile + "\n";
+		return false;
+	}
+
+	return true;
+}
+
+/*ReadTga maps a TGA file and decodes it.*/
+bool TextureFileClass::ReadTga(const char* filename, vector<unsigned char>& texels, int& width, int& height)
+{
+	MappedFileClass file;
+	bool result;
+
+	result = file.Open(filename);
+	if (!result)
+	{
+		return false;
+	}
+
+	return DecodeTga(file.GetData(), file.GetSize(), texels, width, height);
+}
+
+/*DecodeTga turns the bytes of a TGA file into RGBA texels, 4 bytes each with the top row first, which is the order
+of RENDER_FORMAT_R8G8B8A8_UNORM. TGA files store blue, green, red and alpha, usually with the bottom row first, and
+may pack runs of the same texel into one (RLE). Runs can go on from the end of one row to the start of the next, so
+the texels are written in file order and every row is put where it belongs on the way. A 32 bit file that says it
+has no alpha bits gets opaque texels, gray files get the gray in red, green and blue.*/
+bool TextureFileClass::DecodeTga(const void* data, size_t size, vector<unsigned char>& texels, int& width, int& height)
+{
+	PROFILE_FUNCTION();
+
+	const unsigned char* header;
+	const unsigned char* source;
+	const unsigned char* end;
+	unsigned int* row;
+	unsigned int texel, alphaMask, swap;
+	size_t offset;
+	int imageType, bitsPerTexel, bytesPerTexel, descriptor, colorMapLength, colorMapBits, x, y, count, span, i;
+	bool compressed, topToBottom, run;
+
+	header = (const unsigned char*)data;
+	if (size < TGA_HEADER_SIZE)
+	{
+		return false;
+	}
+
+	imageType = header[2];
+	colorMapLength = header[5] | (header[6] << 8);
+	colorMapBits = header[7];
+	width = header[12] | (header[13] << 8);
+	height = header[14] | (header[15] << 8);
+	bitsPerTexel = header[16];
+	descriptor = header[17];
+
+	// Color mapped files aren't read, a true color file may still carry a color map nobody uses.
+	compressed = imageType == TGA_TYPE_RLE_TRUE_COLOR || imageType == TGA_TYPE_RLE_GRAY;
+	if (imageType == TGA_TYPE_TRUE_COLOR || imageType == TGA_TYPE_RLE_TRUE_COLOR)
+	{
+		if (bitsPerTexel != 24 && bitsPerTexel != 32)
+		{
+			return false;
+		}
+	}
+	else if (imageType == TGA_TYPE_GRAY || imageType == TGA_TYPE_RLE_GRAY)
+	{
+		if (bitsPerTexel != 8)
+		{
+			return false;
+		}
+	}
+	else
+	{
+		return false;
+	}
+
+	if (width == 0 || height == 0)
+	{
+		return false;
+	}
+
+	bytesPerTexel = bitsPerTexel / 8;
+	alphaMask = bitsPerTexel == 32 && (descriptor & TGA_DESCRIPTOR_ALPHA_BITS) != 0 ? 0 : 0xff000000;
+	topToBottom = (descriptor & TGA_DESCRIPTOR_TOP_TO_BOTTOM) != 0;
+
+	// The texels follow the image id and the color map.
+	offset = TGA_HEADER_SIZE + header[0] + (size_t)colorMapLength * ((colorMapBits + 7) / 8);
+	if (offset > size)
+	{
+		return false;
+	}
+	source = header + offset;
+	end = header + size;
+
+	texels.resize((size_t)width * height * 4);
+
+	if (!compressed)
+	{
+		if ((size_t)(end - source) < (size_t)width * height * bytesPerTexel)
+		{
+			return false;
+		}
+
+		for (y = 0; y < height; y++)
+		{
+			row = (unsigned int*)&texels[0] + (size_t)(topToBottom ? y : height - 1 - y) * width;
+			ConvertTexels(source, bytesPerTexel, width, alphaMask, row);
+			source += (size_t)width * bytesPerTexel;
+		}
+	}
+	else
+	{
+		x = 0;
+		y = 0;
+		row = (unsigned int*)&texels[0] + (size_t)(topToBottom ? 0 : height - 1) * width;
+		while (y < height)
+		{
+			// Every packet starts with a byte holding the number of texels minus one, the top bit marks a run.
+			if (source >= end)
+			{
+				return false;
+			}
+			count = (*source & 0x7f) + 1;
+			run = (*source & 0x80) != 0;
+			source++;
+
+			// A run holds one texel for all of them, a raw packet holds every texel.
+			if (end - source < (run ? 1 : count) * bytesPerTexel)
+			{
+				return false;
+			}
+
+			if (run)
+			{
+				ConvertTexels(source, bytesPerTexel, 1, alphaMask, &texel);
+				source += bytesPerTexel;
+			}
+
+			// Write the packet, it may cover the end of one row and the start of the next.
+			while (count > 0 && y < height)
+			{
+				span = count < width - x ? count : width - x;
+				if (run)
+				{
+					for (i = 0; i < span; i++)
+					{
+						row[x + i] = texel;
+					}
+				}
+				else
+				{
+					ConvertTexels(source, bytesPerTexel, span, alphaMask, row + x);
+					source += (size_t)span * bytesPerTexel;
+				}
+
+				count -= span;
+				x += span;
+				if (x == width)
+				{
+					x = 0;
+					y++;
+					if (y < height)
+					{
+						row = (unsigned int*)&texels[0] + (size_t)(topToBottom ? y : height - 1 - y) * width;
+					}
+				}
+			}
+		}
+	}
+
+	// Files stored right to left are rare, their rows are turned around afterwards.
+	if (descriptor & TGA_DESCRIPTOR_RIGHT_TO_LEFT)
+	{
+		for (y = 0; y < height; y++)
+		{
+			row = (unsigned int*)&texels[0] + (size_t)y * width;
+			for (i = 0; i < width / 2; i++)
+			{
+				swap = row[i];
+				row[i] = row[width - 1 - i];
+				row[width - 1 - i] = swap;
+			}
+		}
+	}
+
+	return true;
+}
+
+/*GenerateMips puts the mip levels of the texels after them, every level half the size of the one before it (rounded
+down) until the last one is a single texel. The levels start at 16 byte aligned offsets so the box filter and the video
+card can read them where they are.*/
+void TextureFileClass::GenerateMips(vector<unsigned char>& texels, int width, int height, vector<TextureMipType>& mips)
+{
+	PROFILE_FUNCTION();
+
+	TextureMipType mip;
+	unsigned long long offset;
+	int level;
+
+	// Work out where every level goes first, so the texels only grow once.
+	mips.clear();
+	offset = 0;
+	while (true)
+	{
+		mip.offset = offset;
+		mip.width = (unsigned int)width;
+		mip.height = (unsigned int)height;
+		mip.rowPitch = (unsigned int)width * 4;
+		mip.size = mip.rowPitch * (unsigned int)height;
+		mips.push_back(mip);
+
+		if ((width == 1 && height == 1) || (int)mips.size() == TEXTURE_MAX_MIPS)
+		{
+			break;
+		}
+
+		offset = AlignOffset(offset + mip.size);
+		width = width > 1 ? width / 2 : 1;
+		height = height > 1 ? height / 2 : 1;
+	}
+
+	texels.resize((size_t)(mips.back().offset + mips.back().size));
+
+	for (level = 1; level < (int)mips.size(); level++)
+	{
+		Downsample(&texels[(size_t)mips[level - 1].offset], (int)mips[level - 1].width, (int)mips[level - 1].height, &texels[(size_t)mips[level].offset]);
+	}
+
+	return;
+}
+
+/*Downsample box filters RGBA texels to half their width and height, every texel is the rounded mean of a 2x2 block.
+Odd sizes leave out the last column or row, a side that is already 1 texel stays 1 and filters the same texel twice.
+SSE2 is part of every x64 processor, the SIMD loop averages 8 texels of two rows into 4 at a time in 16 bits and the
+scalar one finishes the rest of the row.*/
+void TextureFileClass::Downsample(const unsigned char* source, int width, int height, unsigned char* destination)
+{
+	const unsigned char* row0;
+	const unsigned char* row1;
+	unsigned char* output;
+	__m128i zero, rounding, a0, a1, b0, b1, low, high, sum0, sum1;
+	int outputWidth, outputHeight, x, y, x0, x1, channel;
+
+	outputWidth = width > 1 ? width / 2 : 1;
+	outputHeight = height > 1 ? height / 2 : 1;
+
+	zero = _mm_setzero_si128();
+	rounding = _mm_set1_epi16(2);
+
+	for (y = 0; y < outputHeight; y++)
+	{
+		row0 = source + (size_t)(y * 2) * width * 4;
+		row1 = height > 1 ? row0 + (size_t)width * 4 : row0;
+		output = destination + (size_t)y * outputWidth * 4;
+
+		x = 0;
+		if (width > 1)
+		{
+			for (; x + 4 <= outputWidth; x += 4)
+			{
+				a0 = _mm_loadu_si128((const __m128i*)(row0 + x * 8));
+				a1 = _mm_loadu_si128((const __m128i*)(row0 + x * 8 + 16));
+				b0 = _mm_loadu_si128((const __m128i*)(row1 + x * 8));
+				b1 = _mm_loadu_si128((const __m128i*)(row1 + x * 8 + 16));
+
+				// Add the rows in 16 bits, then the two texels of every pair, which sit in the two halves of a register.
+				low = _mm_add_epi16(_mm_unpacklo_epi8(a0, zero), _mm_unpacklo_epi8(b0, zero));
+				high = _mm_add_epi16(_mm_unpackhi_epi8(a0, zero), _mm_unpackhi_epi8(b0, zero));
+				sum0 = _mm_add_epi16(_mm_unpacklo_epi64(low, high), _mm_unpackhi_epi64(low, high));
+
+				low = _mm_add_epi16(_mm_unpacklo_epi8(a1, zero), _mm_unpacklo_epi8(b1, zero));
+				high = _mm_add_epi16(_mm_unpackhi_epi8(a1, zero), _mm_unpackhi_epi8(b1, zero));
+				sum1 = _mm_add_epi16(_mm_unpacklo_epi64(low, high), _mm_unpackhi_epi64(low, high));
+
+				sum0 = _mm_srli_epi16(_mm_add_epi16(sum0, rounding), 2);
+				sum1 = _mm_srli_epi16(_mm_add_epi16(sum1, rounding), 2);
+				_mm_storeu_si128((__m128i*)(output + x * 4), _mm_packus_epi16(sum0, sum1));
+			}
+		}
+
+		for (; x < outputWidth; x++)
+		{
+			x0 = x * 2;
+			x1 = x0 + 1 < width ? x0 + 1 : x0;
+			for (channel = 0; channel < 4; channel++)
+			{
+				output[x * 4 + channel] = (unsigned char)((row0[x0 * 4 + channel] + row0[x1 * 4 + channel] + row1[x0 * 4 + channel] +
+					row1[x1 * 4 + channel] + 2) >> 2);
+			}
+		}
+	}
+
+	return;
+}
+
+/*CompressMips compresses every level made by GenerateMips into a block compressed format, laid out the same way.*/
+bool TextureFileClass::CompressMips(const vector<unsigned char>& texels, const vector<TextureMipType>& mips, RenderFormat format,
+	TextureQuality quality, JobSystemClass* jobSystem, vector<unsigned char>& blocks, vector<TextureMipType>& blockMips)
+{
+	PROFILE_FUNCTION();
+
+	unsigned long long offset;
+	size_t level;
+	bool result;
+
+	if (!TextureCompressorClass::IsBlockCompressed(format))
+	{
+		return false;
+	}
+
+	blockMips = mips;
+	offset = 0;
+	for (level = 0; level < mips.size(); level++)
+	{
+		blockMips[level].offset = offset;
+		blockMips[level].rowPitch = (unsigned int)TextureCompressorClass::GetRowPitch(format, (int)mips[level].width);
+		blockMips[level].size = blockMips[level].rowPitch * (unsigned int)TextureCompressorClass::GetRowCount(format, (int)mips[level].height);
+		offset = AlignOffset(offset + blockMips[level].size);
+	}
+
+	blocks.resize((size_t)(blockMips.back().offset + blockMips.back().size));
+
+	for (level = 0; level < mips.size(); level++)
+	{
+		result = TextureCompressorClass::Compress(&texels[(size_t)mips[level].offset], (int)mips[level].width, (int)mips[level].height, format,
+			quality, jobSystem, &blocks[(size_t)blockMips[level].offset]);
+		if (!result)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/*WriteTexture writes the mip levels made by GenerateMips or CompressMips as a texture file, in the given format.*/
+bool TextureFileClass::WriteTexture(const char* filename, const TexturePresetType& preset, RenderFormat format, const vector<unsigned char>& data,
+	const vector<TextureMipType>& mips)
+{
+	PROFILE_FUNCTION();
+
+	TextureFileHeaderType header;
+	const char padding[TEXTURE_LEVEL_ALIGNMENT] = { 0 };
+	unsigned long long dataOffset;
+	size_t written, i;
+	FILE* file;
+
+	if (mips.empty() || (int)mips.size() > TEXTURE_MAX_MIPS || data.empty())
+	{
+		return false;
+	}
+
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, TEXTURE_FILE_MAGIC, sizeof(header.magic));
+	header.version = TEXTURE_FILE_VERSION;
+	header.width = mips[0].width;
+	header.height = mips[0].height;
+	header.format = (unsigned int)format;
+	header.presetFormat = (unsigned int)preset.format;
+	header.presetQuality = (unsigned int)preset.quality;
+	header.mipCount = (unsigned int)mips.size();
+
+	// The levels are written right after the header, at the offsets they have in the data.
+	dataOffset = AlignOffset(sizeof(header));
+	for (i = 0; i < mips.size(); i++)
+	{
+		if (mips[i].offset + mips[i].size > data.size() || mips[i].offset % TEXTURE_LEVEL_ALIGNMENT != 0)
+		{
+			return false;
+		}
+
+		header.mips[i] = mips[i];
+		header.mips[i].offset += dataOffset;
+	}
+
+	file = fopen(filename, "wb");
+	if (!file)
+	{
+		return false;
+	}
+
+	written = fwrite(&header, sizeof(header), 1, file);
+	written += fwrite(padding, 1, (size_t)(dataOffset - sizeof(header)), file) == (size_t)(dataOffset - sizeof(header)) ? 1 : 0;
+	written += fwrite(&data[0], data.size(), 1, file);
+
+	if (fclose(file) != 0 || written != 3)
+	{
+		// Don't leave half a file behind for the next run to trip over.
+		remove(filename);
+		return false;
+	}
+
+	return true;
+}
+
+/*GetCacheFileName swaps the extension of a file for .texture.*/
+string TextureFileClass::GetCacheFileName(const char* filename)
+{
+	string name;
+	size_t dot, slash;
+
+	name = filename;
+	dot = name.find_last_of('.');
+	slash = name.find_last_of("/\\");
+	if (dot != string::npos && (slash == string::npos || dot > slash))
+	{
+		name.erase(dot);
+	}
+
+	return name + ".texture";
+}
+
+/*OpenTexture maps a texture file and checks that it is one of ours, of this version, and that every mip level is
+inside it and big enough for its rows.*/
+bool TextureFileClass::OpenTexture(const char* filename)
+{
+	const TextureFileHeaderType* header;
+	unsigned long long size;
+	unsigned int i;
+	bool result;
+
+	result = m_file.Open(filename);
+	if (!result)
+	{
+		return false;
+	}
+
+	size = m_file.GetSize();
+	header = (const TextureFileHeaderType*)m_file.GetData();
+	if (size < sizeof(TextureFileHeaderType) || memcmp(header->magic, TEXTURE_FILE_MAGIC, sizeof(header->magic)) != 0 ||
+		header->version != TEXTURE_FILE_VERSION || header->width == 0 || header->height == 0 || header->mipCount == 0 ||
+		header->mipCount > (unsigned int)TEXTURE_MAX_MIPS || header->mips[0].width != header->width || header->mips[0].height != header->height)
+	{
+		m_file.Close();
+		return false;
+	}
+
+	for (i = 0; i < header->mipCount; i++)
+	{
+		if (header->mips[i].offset % TEXTURE_LEVEL_ALIGNMENT != 0 || header->mips[i].offset + header->mips[i].size > size ||
+			header->mips[i].rowPitch == 0 ||
+			header->mips[i].size < (unsigned long long)header->mips[i].rowPitch * TextureCompressorClass::GetRowCount((RenderFormat)header->format, (int)header->mips[i].height))
+		{
+			m_file.Close();
+			return false;
+		}
+	}
+
+	m_header = header;
+
+	return true;
+}
+
+/*IsCacheCurrent checks if the cache file is at least as new as the source file. A cache without its source is used
+as it is, so a game can ship with only the texture files.*/
+bool TextureFileClass::IsCacheCurrent(const char* sourceFile, const char* cacheFile)
+{
+	struct stat sourceStatus, cacheStatus;
+
+	if (stat(cacheFile, &cacheStatus) != 0)
+	{
+		return false;
+	}
+
+	if (stat(sourceFile, &sourceStatus) != 0)
+	{
+		return true;
+	}
+
+	return cacheStatus.st_mtime >= sourceStatus.st_mtime;
+}
+
+/*ConvertTexels turns TGA texels of 1, 3 or 4 bytes into RGBA ones, with the alpha mask or'ed in. Four byte texels are
+by far the most common and go through SSE2 four at a time: red and blue are the low bytes of the two 16 bit halves of
+every texel, so swapping the halves of the masked texels swaps them.*/
+static void ConvertTexels(const unsigned char* source, int bytesPerTexel, int count, unsigned int alphaMask, unsigned int* destination)
+{
+	__m128i texels, redBlue, greenAlpha, alpha, redBlueMask, greenAlphaMask;
+	int i;
+
+	i = 0;
+	if (bytesPerTexel == 4)
+	{
+		redBlueMask = _mm_set1_epi32(0x00ff00ff);
+		greenAlphaMask = _mm_set1_epi32((int)0xff00ff00);
+		alpha = _mm_set1_epi32((int)alphaMask);
+		for (; i + 4 <= count; i += 4)
+		{
+			texels = _mm_loadu_si128((const __m128i*)(source + i * 4));
+			greenAlpha = _mm_and_si128(texels, greenAlphaMask);
+			redBlue = _mm_and_si128(texels, redBlueMask);
+			redBlue = _mm_shufflehi_epi16(_mm_shufflelo_epi16(redBlue, _MM_SHUFFLE(2, 3, 0, 1)), _MM_SHUFFLE(2, 3, 0, 1));
+			_mm_storeu_si128((__m128i*)(destination + i), _mm_or_si128(_mm_or_si128(greenAlpha, redBlue), alpha));
+		}
+
+		for (; i < count; i++)
+		{
+			destination[i] = ((unsigned int)source[i * 4 + 2] | ((unsigned int)source[i * 4 + 1] << 8) | ((unsigned int)source[i * 4] << 16) |
+				((unsigned int)source[i * 4 + 3] << 24)) | alphaMask;
+		}
+	}
+	else if (bytesPerTexel == 3)
+	{
+		for (; i < count; i++)
+		{
+			destination[i] = (unsigned int)source[i * 3 + 2] | ((unsigned int)source[i * 3 + 1] << 8) | ((unsigned int)source[i * 3] << 16) | 0xff000000;
+		}
+	}
+	else
+	{
+		for (; i < count; i++)
+		{
+			destination[i] = (unsigned int)source[i] * 0x00010101 | 0xff000000;
+		}
+	}
+
+	return;
+}
+
+/*AlignOffset rounds an offset up to the alignment of the mip levels.*/
+static unsigned long long AlignOffset(unsigned long long offset)
+{
+	return (offset + TEXTURE_LEVEL_ALIGNMENT - 1) & ~(TEXTURE_LEVEL_ALIGNMENT - 1);
+}
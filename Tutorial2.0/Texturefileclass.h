@@ -0,0 +1,111 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: texturefileclass.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _TEXTUREFILECLASS_H_
+#define _TEXTUREFILECLASS_H_
+
+
+//////////////
+// INCLUDES //
+//////////////
+#include <string>
+#include <vector>
+#include "mappedfileclass.h"
+#include "renderdeviceclass.h"
+#include "jobsystemclass.h"
+#include "texturecompressorclass.h"
+using namespace std;
+
+
+/////////////
+// GLOBALS //
+/////////////
+/*Bump the version whenever the layout of the file or the way the mip levels are made changes, old cache files are
+imported again.*/
+const unsigned int TEXTURE_FILE_VERSION = 2;
+
+/*Enough mip levels for a 32768 texel wide texture, more than Direct3D 11 allows.*/
+const int TEXTURE_MAX_MIPS = 16;
+
+
+/////////////
+// TYPEDEFS //
+/////////////
+/*Where one mip level is in a texture file, its size in texels and the bytes from one row of it to the next. A row of
+a block compressed level is a row of 4x4 blocks.*/
+struct TextureMipType
+{
+	unsigned long long offset;
+	unsigned int width;
+	unsigned int height;
+	unsigned int rowPitch;
+	unsigned int size;
+};
+
+/*The header at the start of every texture file. It is followed by the mip levels, largest first, each starting at a
+16 byte aligned offset and laid out exactly the way CreateTexture takes them. The preset is the one the texture was
+imported with, a cache imported with another one is imported again.*/
+struct TextureFileHeaderType
+{
+	char magic[4];
+	unsigned int version;
+	unsigned int width;
+	unsigned int height;
+	unsigned int format;
+	unsigned int presetFormat;
+	unsigned int presetQuality;
+	unsigned int mipCount;
+	TextureMipType mips[TEXTURE_MAX_MIPS];
+};
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: TextureFileClass
+////////////////////////////////////////////////////////////////////////////////
+/*The TextureFileClass loads textures from our own binary texture format: a header and every mip level of the texture
+the way the video card wants them. Like a mesh file it is memory mapped and its levels are handed to CreateTexture as
+they are, there is nothing left to decode or filter at load time.
+
+Artists give us Truevision TGA files. Opening a .tga imports it once into a .texture file next to it (stone01.tga
+becomes stone01.texture) and maps that, the next time the .texture file is used as long as it is newer than the .tga
+and has the current version and preset. The importer reads uncompressed and run length encoded TGA files with 8 bit
+gray, 24 bit or 32 bit texels straight from the mapped file into RGBA rows, top row first, and then builds the mip
+chain down to one texel with a 2x2 box filter. Last the TextureCompressorClass compresses every level into the format
+of the preset, on the job system when there is one.*/
+class TextureFileClass
+{
+public:
+	TextureFileClass();
+	TextureFileClass(const TextureFileClass&);
+	~TextureFileClass();
+
+	bool Open(const char*, const TexturePresetType&, JobSystemClass*, string&);
+	void Close();
+
+	int GetWidth();
+	int GetHeight();
+	RenderFormat GetFormat();
+	int GetMipCount();
+	TextureMipType GetMip(int);
+	const void* GetMipData(int);
+
+	static bool ImportTga(const char*, const char*, const TexturePresetType&, JobSystemClass*, string&);
+	static bool ReadTga(const char*, vector<unsigned char>&, int&, int&);
+	static bool DecodeTga(const void*, size_t, vector<unsigned char>&, int&, int&);
+	static void GenerateMips(vector<unsigned char>&, int, int, vector<TextureMipType>&);
+	static void Downsample(const unsigned char*, int, int, unsigned char*);
+	static bool CompressMips(const vector<unsigned char>&, const vector<TextureMipType>&, RenderFormat, TextureQuality, JobSystemClass*,
+		vector<unsigned char>&, vector<TextureMipType>&);
+	static bool WriteTexture(const char*, const TexturePresetType&, RenderFormat, const vector<unsigned char>&, const vector<TextureMipType>&);
+	static string GetCacheFileName(const char*);
+
+private:
+	bool OpenTexture(const char*);
+	static bool IsCacheCurrent(const char*, const char*);
+
+private:
+	MappedFileClass m_file;
+	const TextureFileHeaderType* m_header;
+};
+
+#endif
@@ -0,0 +1,45 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: timerclass.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "timerclass.h"
+
+TimerClass::TimerClass()
+{
+	m_startTime = std::chrono::steady_clock::now();
+}
+
+TimerClass::TimerClass(const TimerClass& other)
+{
+}
+
+TimerClass::~TimerClass()
+{
+}
+
+/*Start (re)starts the stopwatch.*/
+void TimerClass::Start()
+{
+	m_startTime = std::chrono::steady_clock::now();
+	return;
+}
+
+/*GetElapsedMilliseconds returns the time since the last call to Start in milliseconds, with sub microsecond precision.*/
+double TimerClass::GetElapsedMilliseconds()
+{
+	std::chrono::duration<double, std::milli> elapsed;
+
+	elapsed = std::chrono::steady_clock::now() - m_startTime;
+
+	return elapsed.count();
+}
+
+/*GetTimeSeconds returns the current time of the steady clock in seconds. The value itself means nothing, only the
+difference between two of them does.*/
+double TimerClass::GetTimeSeconds()
+{
+	std::chrono::duration<double> now;
+
+	now = std::chrono::steady_clock::now().time_since_epoch();
+
+	return now.count();
+}
@@ -0,0 +1,36 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: timerclass.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _TIMERCLASS_H_
+#define _TIMERCLASS_H_
+
+
+//////////////
+// INCLUDES //
+//////////////
+#include <chrono>
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: TimerClass
+////////////////////////////////////////////////////////////////////////////////
+/*The TimerClass is a high resolution stopwatch. It is built on the steady clock from the standard library, which
+uses QueryPerformanceCounter on Windows and a monotonic clock everywhere else, so the measurements are never thrown
+off by someone changing the system time.*/
+class TimerClass
+{
+public:
+	TimerClass();
+	TimerClass(const TimerClass&);
+	~TimerClass();
+
+	void Start();
+	double GetElapsedMilliseconds();
+
+	static double GetTimeSeconds();
+
+private:
+	std::chrono::steady_clock::time_point m_startTime;
+};
+
+#endif
@@ -0,0 +1,238 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: transformbatchclass.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "transformbatchclass.h"
+#include "profilerclass.h"
+#include <immintrin.h>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define TRANSFORM_AVX2_FUNCTION
+#else
+#define TRANSFORM_AVX2_FUNCTION __attribute__((target("avx2,fma")))
+#endif
+
+
+/*Multiply transforms count world matrices with the fastest path this processor supports.*/
+void TransformBatchClass::Multiply(const XMFLOAT4X4* worldMatrices, int count, const XMMATRIX& viewProjectionMatrix, XMFLOAT4X4* output)
+{
+	static TransformPath bestPath = GetBestPath();
+
+	Multiply(bestPath, worldMatrices, count, viewProjectionMatrix, output);
+
+	return;
+}
+
+/*This Multiply uses the given path, the benchmark uses it to compare them. The path must be supported.*/
+void TransformBatchClass::Multiply(TransformPath path, const XMFLOAT4X4* worldMatrices, int count, const XMMATRIX& viewProjectionMatrix,
+	XMFLOAT4X4* output)
+{
+	PROFILE_FUNCTION();
+
+	XMFLOAT4X4 viewProjection;
+
+	XMStoreFloat4x4(&viewProjection, viewProjectionMatrix);
+
+	switch (path)
+	{
+		case TRANSFORM_PATH_AVX2:
+			MultiplyAVX2(worldMatrices, count, viewProjection, output);
+			break;
+		case TRANSFORM_PATH_SSE:
+			MultiplySSE(worldMatrices, count, viewProjection, output);
+			break;
+		default:
+			MultiplyScalar(worldMatrices, count, viewProjection, output);
+			break;
+	}
+
+	return;
+}
+
+/*GetBestPath asks the processor what it supports. AVX2 also needs the operating system to save the AVX registers,
+that is what the XGETBV check is for. SSE2 is always there on x64. Other compilers than Visual C++ have a builtin that
+does the same checks.*/
+TransformPath TransformBatchClass::GetBestPath()
+{
+#if defined(_MSC_VER)
+	int info[4];
+	bool hasFma, osSavesAvx;
+
+	__cpuid(info, 1);
+
+	// Bit 12 of ecx is FMA, bit 27 is OSXSAVE and bit 28 is AVX.
+	hasFma = (info[2] & (1 << 12)) != 0;
+	osSavesAvx = false;
+	if ((info[2] & (1 << 27)) && (info[2] & (1 << 28)))
+	{
+		osSavesAvx = (_xgetbv(0) & 0x6) == 0x6;
+	}
+
+	if (hasFma && osSavesAvx)
+	{
+		// Bit 5 of ebx is AVX2.
+		__cpuidex(info, 7, 0);
+		if (info[1] & (1 << 5))
+		{
+			return TRANSFORM_PATH_AVX2;
+		}
+	}
+#else
+	if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+	{
+		return TRANSFORM_PATH_AVX2;
+	}
+#endif
+
+	return TRANSFORM_PATH_SSE;
+}
+
+bool TransformBatchClass::IsPathSupported(TransformPath path)
+{
+	return path <= GetBestPath();
+}
+
+const char* TransformBatchClass::GetPathName(TransformPath path)
+{
+	switch (path)
+	{
+		case TRANSFORM_PATH_AVX2:
+			return "avx2";
+		case TRANSFORM_PATH_SSE:
+			return "sse";
+		default:
+			return "scalar";
+	}
+}
+
+/*MultiplyScalar is the reference, every element is the dot product of a row of the world matrix and a column of the
+view-projection matrix, written to the transposed position.*/
+void TransformBatchClass::MultiplyScalar(const XMFLOAT4X4* worldMatrices, int count, const XMFLOAT4X4& viewProjection, XMFLOAT4X4* output)
+{
+	XMFLOAT4X4 world;
+	int i, row, column;
+
+	for (i = 0; i < count; i++)
+	{
+		// Copy the input first so the output can be the same matrix.
+		world = worldMatrices[i];
+
+		for (row = 0; row < 4; row++)
+		{
+			for (column = 0; column < 4; column++)
+			{
+				output[i].m[column][row] = world.m[row][0] * viewProjection.m[0][column] + world.m[row][1] * viewProjection.m[1][column] +
+					world.m[row][2] * viewProjection.m[2][column] + world.m[row][3] * viewProjection.m[3][column];
+			}
+		}
+	}
+
+	return;
+}
+
+/*MultiplySSE does one matrix at a time. A row of the result is the sum of the rows of the view-projection matrix, each
+scaled by one element of the world row, so every row takes four broadcasts and four multiply-adds. The four result
+rows are then transposed in registers.*/
+void TransformBatchClass::MultiplySSE(const XMFLOAT4X4* worldMatrices, int count, const XMFLOAT4X4& viewProjection, XMFLOAT4X4* output)
+{
+	__m128 viewProjection0, viewProjection1, viewProjection2, viewProjection3;
+	__m128 world0, world1, world2, world3;
+	__m128 result0, result1, result2, result3;
+	int i;
+
+	viewProjection0 = _mm_loadu_ps(viewProjection.m[0]);
+	viewProjection1 = _mm_loadu_ps(viewProjection.m[1]);
+	viewProjection2 = _mm_loadu_ps(viewProjection.m[2]);
+	viewProjection3 = _mm_loadu_ps(viewProjection.m[3]);
+
+	for (i = 0; i < count; i++)
+	{
+		world0 = _mm_loadu_ps(worldMatrices[i].m[0]);
+		world1 = _mm_loadu_ps(worldMatrices[i].m[1]);
+		world2 = _mm_loadu_ps(worldMatrices[i].m[2]);
+		world3 = _mm_loadu_ps(worldMatrices[i].m[3]);
+
+		result0 = _mm_mul_ps(_mm_shuffle_ps(world0, world0, 0x00), viewProjection0);
+		result0 = _mm_add_ps(result0, _mm_mul_ps(_mm_shuffle_ps(world0, world0, 0x55), viewProjection1));
+		result0 = _mm_add_ps(result0, _mm_mul_ps(_mm_shuffle_ps(world0, world0, 0xaa), viewProjection2));
+		result0 = _mm_add_ps(result0, _mm_mul_ps(_mm_shuffle_ps(world0, world0, 0xff), viewProjection3));
+
+		result1 = _mm_mul_ps(_mm_shuffle_ps(world1, world1, 0x00), viewProjection0);
+		result1 = _mm_add_ps(result1, _mm_mul_ps(_mm_shuffle_ps(world1, world1, 0x55), viewProjection1));
+		result1 = _mm_add_ps(result1, _mm_mul_ps(_mm_shuffle_ps(world1, world1, 0xaa), viewProjection2));
+		result1 = _mm_add_ps(result1, _mm_mul_ps(_mm_shuffle_ps(world1, world1, 0xff), viewProjection3));
+
+		result2 = _mm_mul_ps(_mm_shuffle_ps(world2, world2, 0x00), viewProjection0);
+		result2 = _mm_add_ps(result2, _mm_mul_ps(_mm_shuffle_ps(world2, world2, 0x55), viewProjection1));
+		result2 = _mm_add_ps(result2, _mm_mul_ps(_mm_shuffle_ps(world2, world2, 0xaa), viewProjection2));
+		result2 = _mm_add_ps(result2, _mm_mul_ps(_mm_shuffle_ps(world2, world2, 0xff), viewProjection3));
+
+		result3 = _mm_mul_ps(_mm_shuffle_ps(world3, world3, 0x00), viewProjection0);
+		result3 = _mm_add_ps(result3, _mm_mul_ps(_mm_shuffle_ps(world3, world3, 0x55), viewProjection1));
+		result3 = _mm_add_ps(result3, _mm_mul_ps(_mm_shuffle_ps(world3, world3, 0xaa), viewProjection2));
+		result3 = _mm_add_ps(result3, _mm_mul_ps(_mm_shuffle_ps(world3, world3, 0xff), viewProjection3));
+
+		_MM_TRANSPOSE4_PS(result0, result1, result2, result3);
+
+		_mm_storeu_ps(output[i].m[0], result0);
+		_mm_storeu_ps(output[i].m[1], result1);
+		_mm_storeu_ps(output[i].m[2], result2);
+		_mm_storeu_ps(output[i].m[3], result3);
+	}
+
+	return;
+}
+
+/*MultiplyAVX2 does two matrices at a time, the first in the low 128 bits of every register and the second in the
+high 128 bits. The shuffles and unpacks work on each half on its own, so the math is the same as the SSE path with
+fused multiply-adds, split in two chains so they don't wait on each other. At the end the halves are put back
+together so each matrix is written with two 256 bit stores. An odd last matrix goes through the SSE path.*/
+TRANSFORM_AVX2_FUNCTION void TransformBatchClass::MultiplyAVX2(const XMFLOAT4X4* worldMatrices, int count, const XMFLOAT4X4& viewProjection,
+	XMFLOAT4X4* output)
+{
+	__m256 viewProjection0, viewProjection1, viewProjection2, viewProjection3;
+	__m256 world, result[4], unpacked0, unpacked1, unpacked2, unpacked3;
+	int i, row;
+
+	// Both halves get the same view-projection rows.
+	viewProjection0 = _mm256_broadcast_ps((const __m128*)viewProjection.m[0]);
+	viewProjection1 = _mm256_broadcast_ps((const __m128*)viewProjection.m[1]);
+	viewProjection2 = _mm256_broadcast_ps((const __m128*)viewProjection.m[2]);
+	viewProjection3 = _mm256_broadcast_ps((const __m128*)viewProjection.m[3]);
+
+	for (i = 0; i + 1 < count; i += 2)
+	{
+		for (row = 0; row < 4; row++)
+		{
+			// The row of the first matrix in the low half, the same row of the second matrix in the high half.
+			world = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(worldMatrices[i].m[row])), _mm_loadu_ps(worldMatrices[i + 1].m[row]), 1);
+
+			result[row] = _mm256_add_ps(_mm256_fmadd_ps(_mm256_shuffle_ps(world, world, 0x55), viewProjection1, _mm256_mul_ps(_mm256_shuffle_ps(world, world, 0x00), viewProjection0)),
+				_mm256_fmadd_ps(_mm256_shuffle_ps(world, world, 0xff), viewProjection3, _mm256_mul_ps(_mm256_shuffle_ps(world, world, 0xaa), viewProjection2)));
+		}
+
+		// Transpose both 4x4 halves.
+		unpacked0 = _mm256_unpacklo_ps(result[0], result[1]);
+		unpacked1 = _mm256_unpackhi_ps(result[0], result[1]);
+		unpacked2 = _mm256_unpacklo_ps(result[2], result[3]);
+		unpacked3 = _mm256_unpackhi_ps(result[2], result[3]);
+
+		result[0] = _mm256_shuffle_ps(unpacked0, unpacked2, 0x44);
+		result[1] = _mm256_shuffle_ps(unpacked0, unpacked2, 0xee);
+		result[2] = _mm256_shuffle_ps(unpacked1, unpacked3, 0x44);
+		result[3] = _mm256_shuffle_ps(unpacked1, unpacked3, 0xee);
+
+		// Gather the rows of each matrix and store them.
+		_mm256_storeu_ps(output[i].m[0], _mm256_permute2f128_ps(result[0], result[1], 0x20));
+		_mm256_storeu_ps(output[i].m[2], _mm256_permute2f128_ps(result[2], result[3], 0x20));
+		_mm256_storeu_ps(output[i + 1].m[0], _mm256_permute2f128_ps(result[0], result[1], 0x31));
+		_mm256_storeu_ps(output[i + 1].m[2], _mm256_permute2f128_ps(result[2], result[3], 0x31));
+	}
+
+	if (i < count)
+	{
+		MultiplySSE(&worldMatrices[i], count - i, viewProjection, &output[i]);
+	}
+
+	return;
+}
@@ -0,0 +1,53 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: transformbatchclass.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _TRANSFORMBATCHCLASS_H_
+#define _TRANSFORMBATCHCLASS_H_
+
+
+//////////////
+// INCLUDES //
+//////////////
+#include <directxmath.h>
+using namespace DirectX;
+
+
+/////////////
+// TYPEDEFS //
+/////////////
+/*The ways TransformBatchClass can do the work. AVX2 does two matrices per step, SSE one and the scalar path is plain
+C++ for processors (or builds) without either.*/
+enum TransformPath
+{
+	TRANSFORM_PATH_SCALAR,
+	TRANSFORM_PATH_SSE,
+	TRANSFORM_PATH_AVX2
+};
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: TransformBatchClass
+////////////////////////////////////////////////////////////////////////////////
+/*The TransformBatchClass turns a whole array of world matrices into world-view-projection matrices in one go, instead
+of multiplying and transposing them one draw at a time. Every output matrix is world * viewProjection, transposed
+the way the shaders want it, so it can be copied into a constant buffer as it is. Multiply picks the fastest path
+the processor supports, the first time it is called.
+
+The input and output may be the same array.*/
+class TransformBatchClass
+{
+public:
+	static void Multiply(const XMFLOAT4X4*, int, const XMMATRIX&, XMFLOAT4X4*);
+	static void Multiply(TransformPath, const XMFLOAT4X4*, int, const XMMATRIX&, XMFLOAT4X4*);
+
+	static TransformPath GetBestPath();
+	static bool IsPathSupported(TransformPath);
+	static const char* GetPathName(TransformPath);
+
+private:
+	static void MultiplyScalar(const XMFLOAT4X4*, int, const XMFLOAT4X4&, XMFLOAT4X4*);
+	static void MultiplySSE(const XMFLOAT4X4*, int, const XMFLOAT4X4&, XMFLOAT4X4*);
+	static void MultiplyAVX2(const XMFLOAT4X4*, int, const XMFLOAT4X4&, XMFLOAT4X4*);
+};
+
+#endif
@@ -0,0 +1,426 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: vertexformatclass.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "vertexformatclass.h"
+#include <math.h>
+#include <string.h>
+
+
+///////////////////////
+// FUNCTION PROTOTYPES //
+///////////////////////
+static float Saturate(float);
+static float SignNotZero(float);
+
+
+/*IsValid checks that every attribute is there at most once, with an encoding that fits it, and that there is a
+position.*/
+bool VertexFormatClass::IsValid(const VertexFormatType& format)
+{
+	bool seen[3];
+	int i;
+
+	if (format.elementCount < 1 || format.elementCount > VERTEX_FORMAT_MAX_ELEMENTS)
+	{
+		return false;
+	}
+
+	seen[0] = seen[1] = seen[2] = false;
+	for (i = 0; i < format.elementCount; i++)
+	{
+		if (seen[format.elements[i].attribute])
+		{
+			return false;
+		}
+		seen[format.elements[i].attribute] = true;
+
+		switch (format.elements[i].attribute)
+		{
+		case VERTEX_ATTRIBUTE_POSITION:
+			if (format.elements[i].encoding != VERTEX_ENCODING_FLOAT3 && format.elements[i].encoding != VERTEX_ENCODING_UNORM16X4)
+			{
+				return false;
+			}
+			break;
+		case VERTEX_ATTRIBUTE_COLOR:
+			if (format.elements[i].encoding != VERTEX_ENCODING_FLOAT4 && format.elements[i].encoding != VERTEX_ENCODING_UNORM8X4)
+			{
+				return false;
+			}
+			break;
+		case VERTEX_ATTRIBUTE_NORMAL:
+			if (format.elements[i].encoding != VERTEX_ENCODING_FLOAT3 && format.elements[i].encoding != VERTEX_ENCODING_OCTAHEDRAL16)
+			{
+				return false;
+			}
+			break;
+		}
+	}
+
+	return seen[VERTEX_ATTRIBUTE_POSITION];
+}
+
+/*GetStride returns the size of one vertex in bytes.*/
+int VertexFormatClass::GetStride(const VertexFormatType& format)
+{
+	int stride, i;
+
+	stride = 0;
+	for (i = 0; i < format.elementCount; i++)
+	{
+		stride += GetEncodingSize(format.elements[i].encoding);
+	}
+
+	return stride;
+}
+
+/*GetHash returns a number that changes with the layout of the vertex, not with its name. The mesh file keeps it to
+know which format its vertices are in.*/
+unsigned int VertexFormatClass::GetHash(const VertexFormatType& format)
+{
+	unsigned int hash;
+	int i;
+
+	// FNV-1a over the attributes and encodings.
+	hash = 2166136261u;
+	hash = (hash ^ (unsigned int)format.elementCount) * 16777619u;
+	for (i = 0; i < format.elementCount; i++)
+	{
+		hash = (hash ^ (unsigned int)format.elements[i].attribute) * 16777619u;
+		hash = (hash ^ (unsigned int)format.elements[i].encoding) * 16777619u;
+	}
+
+	return hash;
+}
+
+bool VertexFormatClass::HasAttribute(const VertexFormatType& format, VertexAttribute attribute)
+{
+	int i;
+
+	for (i = 0; i < format.elementCount; i++)
+	{
+		if (format.elements[i].attribute == attribute)
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/*GetInputLayout describes the vertex to the input assembler, in input slot 0 one vertex at a time. The semantics are
+the ones in color_vs.hlsl.*/
+void VertexFormatClass::GetInputLayout(const VertexFormatType& format, vector<RenderInputElement>& elements)
+{
+	RenderInputElement element;
+	unsigned int offset;
+	int i;
+
+	elements.clear();
+	offset = 0;
+	for (i = 0; i < format.elementCount; i++)
+	{
+		switch (format.elements[i].attribute)
+		{
+		case VERTEX_ATTRIBUTE_POSITION:
+			element.SemanticName = "POSITION";
+			break;
+		case VERTEX_ATTRIBUTE_COLOR:
+			element.SemanticName = "COLOR";
+			break;
+		case VERTEX_ATTRIBUTE_NORMAL:
+			element.SemanticName = "NORMAL";
+			break;
+		}
+		element.SemanticIndex = 0;
+		element.Format = GetEncodingFormat(format.elements[i].encoding);
+		element.InputSlot = 0;
+		element.AlignedByteOffset = offset;
+		element.InputSlotClass = RENDER_INPUT_PER_VERTEX_DATA;
+		element.InstanceDataStepRate = 0;
+		elements.push_back(element);
+
+		offset += GetEncodingSize(format.elements[i].encoding);
+	}
+
+	return;
+}
+
+/*GetShaderDefines returns the defines color_vs.hlsl is compiled with, ending with the null entry CompileShader wants.
+Every define is always there, as 0 or 1, so the shader can use #if and a typo is an error instead of a silent 0.*/
+void VertexFormatClass::GetShaderDefines(const VertexFormatType& format, vector<RenderShaderDefine>& defines)
+{
+	RenderShaderDefine define;
+	int i;
+	bool quantized, normal, octahedral;
+
+	quantized = false;
+	normal = false;
+	octahedral = false;
+	for (i = 0; i < format.elementCount; i++)
+	{
+		if (format.elements[i].attribute == VERTEX_ATTRIBUTE_POSITION && format.elements[i].encoding == VERTEX_ENCODING_UNORM16X4)
+		{
+			quantized = true;
+		}
+
+		if (format.elements[i].attribute == VERTEX_ATTRIBUTE_NORMAL)
+		{
+			normal = true;
+			octahedral = format.elements[i].encoding == VERTEX_ENCODING_OCTAHEDRAL16;
+		}
+	}
+
+	defines.clear();
+
+	define.Name = "VERTEX_POSITION_QUANTIZED";
+	define.Definition = quantized ? "1" : "0";
+	defines.push_back(define);
+
+	define.Name = "VERTEX_NORMAL";
+	define.Definition = normal ? "1" : "0";
+	defines.push_back(define);
+
+	define.Name = "VERTEX_NORMAL_OCTAHEDRAL";
+	define.Definition = octahedral ? "1" : "0";
+	defines.push_back(define);
+
+	define.Name = 0;
+	define.Definition = 0;
+	defines.push_back(define);
+
+	return;
+}
+
+/*GetDecodeMatrix returns the matrix that takes the positions as the vertex shader reads them back to model space. It
+goes in front of the world matrix, for float positions it is the identity.*/
+XMMATRIX VertexFormatClass::GetDecodeMatrix(const VertexFormatType& format, const XMFLOAT3& boundsCenter, const XMFLOAT3& boundsExtents)
+{
+	XMFLOAT3 minimum, scale;
+	int i;
+
+	for (i = 0; i < format.elementCount; i++)
+	{
+		if (format.elements[i].attribute == VERTEX_ATTRIBUTE_POSITION && format.elements[i].encoding == VERTEX_ENCODING_UNORM16X4)
+		{
+			GetQuantization(boundsCenter, boundsExtents, minimum, scale);
+			return XMMatrixMultiply(XMMatrixScaling(scale.x, scale.y, scale.z), XMMatrixTranslation(minimum.x, minimum.y, minimum.z));
+		}
+	}
+
+	return XMMatrixIdentity();
+}
+
+/*Encode packs vertices into the given format. The bounds are the ones the positions are quantized against, they have
+to hold every position.*/
+void VertexFormatClass::Encode(const VertexFormatType& format, const MeshVertexType* vertices, int vertexCount, const XMFLOAT3& boundsCenter,
+	const XMFLOAT3& boundsExtents, void* output)
+{
+	unsigned char* destination;
+	unsigned short position[4];
+	unsigned char color[4];
+	short normal[2];
+	XMFLOAT3 minimum, scale;
+	float length, x, y, z, octahedralX;
+	int vertex, i;
+
+	GetQuantization(boundsCenter, boundsExtents, minimum, scale);
+
+	destination = (unsigned char*)output;
+	for (vertex = 0; vertex < vertexCount; vertex++)
+	{
+		for (i = 0; i < format.elementCount; i++)
+		{
+			switch (format.elements[i].encoding)
+			{
+			case VERTEX_ENCODING_FLOAT3:
+				memcpy(destination, format.elements[i].attribute == VERTEX_ATTRIBUTE_POSITION ? &vertices[vertex].position : &vertices[vertex].normal,
+					sizeof(XMFLOAT3));
+				break;
+
+			case VERTEX_ENCODING_FLOAT4:
+				memcpy(destination, &vertices[vertex].color, sizeof(XMFLOAT4));
+				break;
+
+			case VERTEX_ENCODING_UNORM16X4:
+				// The w of 1 saves the shader from setting it.
+				position[0] = (unsigned short)(Saturate((vertices[vertex].position.x - minimum.x) / scale.x) * 65535.0f + 0.5f);
+				position[1] = (unsigned short)(Saturate((vertices[vertex].position.y - minimum.y) / scale.y) * 65535.0f + 0.5f);
+				position[2] = (unsigned short)(Saturate((vertices[vertex].position.z - minimum.z) / scale.z) * 65535.0f + 0.5f);
+				position[3] = 65535;
+				memcpy(destination, position, sizeof(position));
+				break;
+
+			case VERTEX_ENCODING_UNORM8X4:
+				color[0] = (unsigned char)(Saturate(vertices[vertex].color.x) * 255.0f + 0.5f);
+				color[1] = (unsigned char)(Saturate(vertices[vertex].color.y) * 255.0f + 0.5f);
+				color[2] = (unsigned char)(Saturate(vertices[vertex].color.z) * 255.0f + 0.5f);
+				color[3] = (unsigned char)(Saturate(vertices[vertex].color.w) * 255.0f + 0.5f);
+				memcpy(destination, color, sizeof(color));
+				break;
+
+			case VERTEX_ENCODING_OCTAHEDRAL16:
+				// Project the normal onto the octahedron and fold the lower half over the upper one.
+				x = vertices[vertex].normal.x;
+				y = vertices[vertex].normal.y;
+				z = vertices[vertex].normal.z;
+				length = fabsf(x) + fabsf(y) + fabsf(z);
+				if (length > 0.0f)
+				{
+					x /= length;
+					y /= length;
+					z /= length;
+				}
+				else
+				{
+					z = 1.0f;
+				}
+
+				if (z < 0.0f)
+				{
+					octahedralX = (1.0f - fabsf(y)) * SignNotZero(x);
+					y = (1.0f - fabsf(x)) * SignNotZero(y);
+					x = octahedralX;
+				}
+
+				normal[0] = (short)lrintf((x < -1.0f ? -1.0f : (x > 1.0f ? 1.0f : x)) * 32767.0f);
+				normal[1] = (short)lrintf((y < -1.0f ? -1.0f : (y > 1.0f ? 1.0f : y)) * 32767.0f);
+				memcpy(destination, normal, sizeof(normal));
+				break;
+			}
+
+			destination += GetEncodingSize(format.elements[i].encoding);
+		}
+	}
+
+	return;
+}
+
+/*Decode unpacks vertices the way the input assembler and color_vs.hlsl do, with the decode matrix applied. The
+benchmark uses it to measure what the compression costs in precision. Attributes the format doesn't have come out as
+zero, with a white color.*/
+void VertexFormatClass::Decode(const VertexFormatType& format, const void* input, int vertexCount, const XMFLOAT3& boundsCenter,
+	const XMFLOAT3& boundsExtents, MeshVertexType* vertices)
+{
+	const unsigned char* source;
+	unsigned short position[4];
+	unsigned char color[4];
+	short normal[2];
+	XMFLOAT3 minimum, scale;
+	float x, y, z, t, length;
+	int vertex, i;
+
+	GetQuantization(boundsCenter, boundsExtents, minimum, scale);
+
+	source = (const unsigned char*)input;
+	for (vertex = 0; vertex < vertexCount; vertex++)
+	{
+		vertices[vertex].position = XMFLOAT3(0.0f, 0.0f, 0.0f);
+		vertices[vertex].color = XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f);
+		vertices[vertex].normal = XMFLOAT3(0.0f, 0.0f, 0.0f);
+
+		for (i = 0; i < format.elementCount; i++)
+		{
+			switch (format.elements[i].encoding)
+			{
+			case VERTEX_ENCODING_FLOAT3:
+				memcpy(format.elements[i].attribute == VERTEX_ATTRIBUTE_POSITION ? &vertices[vertex].position : &vertices[vertex].normal, source,
+					sizeof(XMFLOAT3));
+				break;
+
+			case VERTEX_ENCODING_FLOAT4:
+				memcpy(&vertices[vertex].color, source, sizeof(XMFLOAT4));
+				break;
+
+			case VERTEX_ENCODING_UNORM16X4:
+				memcpy(position, source, sizeof(position));
+				vertices[vertex].position.x = (float)position[0] / 65535.0f * scale.x + minimum.x;
+				vertices[vertex].position.y = (float)position[1] / 65535.0f * scale.y + minimum.y;
+				vertices[vertex].position.z = (float)position[2] / 65535.0f * scale.z + minimum.z;
+				break;
+
+			case VERTEX_ENCODING_UNORM8X4:
+				memcpy(color, source, sizeof(color));
+				vertices[vertex].color = XMFLOAT4((float)color[0] / 255.0f, (float)color[1] / 255.0f, (float)color[2] / 255.0f, (float)color[3] / 255.0f);
+				break;
+
+			case VERTEX_ENCODING_OCTAHEDRAL16:
+				// The same unfolding as DecodeNormal in color_vs.hlsl.
+				memcpy(normal, source, sizeof(normal));
+				x = (float)normal[0] / 32767.0f;
+				y = (float)normal[1] / 32767.0f;
+				x = x < -1.0f ? -1.0f : x;
+				y = y < -1.0f ? -1.0f : y;
+				z = 1.0f - fabsf(x) - fabsf(y);
+				t = Saturate(-z);
+				x += x >= 0.0f ? -t : t;
+				y += y >= 0.0f ? -t : t;
+				length = sqrtf(x * x + y * y + z * z);
+				vertices[vertex].normal = XMFLOAT3(x / length, y / length, z / length);
+				break;
+			}
+
+			source += GetEncodingSize(format.elements[i].encoding);
+		}
+	}
+
+	return;
+}
+
+int VertexFormatClass::GetEncodingSize(VertexEncoding encoding)
+{
+	switch (encoding)
+	{
+	case VERTEX_ENCODING_FLOAT3:
+		return 12;
+	case VERTEX_ENCODING_FLOAT4:
+		return 16;
+	case VERTEX_ENCODING_UNORM16X4:
+		return 8;
+	case VERTEX_ENCODING_UNORM8X4:
+	case VERTEX_ENCODING_OCTAHEDRAL16:
+		return 4;
+	}
+
+	return 0;
+}
+
+RenderFormat VertexFormatClass::GetEncodingFormat(VertexEncoding encoding)
+{
+	switch (encoding)
+	{
+	case VERTEX_ENCODING_FLOAT3:
+		return RENDER_FORMAT_R32G32B32_FLOAT;
+	case VERTEX_ENCODING_FLOAT4:
+		return RENDER_FORMAT_R32G32B32A32_FLOAT;
+	case VERTEX_ENCODING_UNORM16X4:
+		return RENDER_FORMAT_R16G16B16A16_UNORM;
+	case VERTEX_ENCODING_UNORM8X4:
+		return RENDER_FORMAT_R8G8B8A8_UNORM;
+	case VERTEX_ENCODING_OCTAHEDRAL16:
+		return RENDER_FORMAT_R16G16_SNORM;
+	}
+
+	return RENDER_FORMAT_UNKNOWN;
+}
+
+/*GetQuantization returns the corner of the bounding box the quantized positions start from and its size. A flat mesh
+has no size along one axis, that axis gets a size of 1 so nothing is divided by zero. All its positions are 0 there.*/
+void VertexFormatClass::GetQuantization(const XMFLOAT3& boundsCenter, const XMFLOAT3& boundsExtents, XMFLOAT3& minimum, XMFLOAT3& scale)
+{
+	minimum = XMFLOAT3(boundsCenter.x - boundsExtents.x, boundsCenter.y - boundsExtents.y, boundsCenter.z - boundsExtents.z);
+	scale = XMFLOAT3(boundsExtents.x > 0.0f ? boundsExtents.x * 2.0f : 1.0f, boundsExtents.y > 0.0f ? boundsExtents.y * 2.0f : 1.0f,
+		boundsExtents.z > 0.0f ? boundsExtents.z * 2.0f : 1.0f);
+
+	return;
+}
+
+static float Saturate(float value)
+{
+	return value < 0.0f ? 0.0f : (value > 1.0f ? 1.0f : value);
+}
+
+static float SignNotZero(float value)
+{
+	return value >= 0.0f ? 1.0f : -1.0f;
+}
@@ -0,0 +1,118 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: vertexformatclass.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _VERTEXFORMATCLASS_H_
+#define _VERTEXFORMATCLASS_H_
+
+
+//////////////
+// INCLUDES //
+//////////////
+#include <directxmath.h>
+#include <vector>
+#include "renderdeviceclass.h"
+using namespace DirectX;
+using namespace std;
+
+
+///////////
+// ENUMS //
+///////////
+enum VertexAttribute
+{
+	VERTEX_ATTRIBUTE_POSITION,
+	VERTEX_ATTRIBUTE_COLOR,
+	VERTEX_ATTRIBUTE_NORMAL
+};
+
+/*How an attribute is stored in the vertex buffer. The position can be full floats or 16 bits per axis, quantized
+against the bounds of the mesh. The color can be full floats or 8 bits per channel. The normal can be full floats or
+two 16 bit numbers with the octahedral encoding: the unit sphere is folded onto an octahedron and that is unfolded
+onto a square, which spreads the precision evenly over all directions.*/
+enum VertexEncoding
+{
+	VERTEX_ENCODING_FLOAT3,        // 12 bytes, R32G32B32_FLOAT.
+	VERTEX_ENCODING_FLOAT4,        // 16 bytes, R32G32B32A32_FLOAT.
+	VERTEX_ENCODING_UNORM16X4,     // 8 bytes, R16G16B16A16_UNORM, positions only.
+	VERTEX_ENCODING_UNORM8X4,      // 4 bytes, R8G8B8A8_UNORM, colors only.
+	VERTEX_ENCODING_OCTAHEDRAL16   // 4 bytes, R16G16_SNORM, normals only.
+};
+
+
+/////////////
+// GLOBALS //
+/////////////
+const int VERTEX_FORMAT_MAX_ELEMENTS = 3;
+
+
+/////////////
+// TYPEDEFS //
+/////////////
+/*The vertex the importer and the mesh optimizer work with, with everything at full precision. It is only turned into
+the vertex format of the vertex buffer when the mesh file is written.*/
+struct MeshVertexType
+{
+	XMFLOAT3 position;
+	XMFLOAT4 color;
+	XMFLOAT3 normal;
+};
+
+struct VertexElementType
+{
+	VertexAttribute attribute;
+	VertexEncoding encoding;
+};
+
+/*A vertex format is a list of attributes in the order they are stored in the vertex. The attributes are packed
+without gaps, every encoding is a multiple of 4 bytes.*/
+struct VertexFormatType
+{
+	const char* name;
+	int elementCount;
+	VertexElementType elements[VERTEX_FORMAT_MAX_ELEMENTS];
+};
+
+/*The formats the engine knows about. Float is the 28 byte vertex the engine always used, compact stores the same in
+12 bytes. The normal variants add a normal for shaders that light the model.*/
+const VertexFormatType VERTEX_FORMAT_FLOAT = { "float", 2, { { VERTEX_ATTRIBUTE_POSITION, VERTEX_ENCODING_FLOAT3 },
+	{ VERTEX_ATTRIBUTE_COLOR, VERTEX_ENCODING_FLOAT4 } } };
+const VertexFormatType VERTEX_FORMAT_FLOAT_NORMAL = { "float_normal", 3, { { VERTEX_ATTRIBUTE_POSITION, VERTEX_ENCODING_FLOAT3 },
+	{ VERTEX_ATTRIBUTE_COLOR, VERTEX_ENCODING_FLOAT4 }, { VERTEX_ATTRIBUTE_NORMAL, VERTEX_ENCODING_FLOAT3 } } };
+const VertexFormatType VERTEX_FORMAT_COMPACT = { "compact", 2, { { VERTEX_ATTRIBUTE_POSITION, VERTEX_ENCODING_UNORM16X4 },
+	{ VERTEX_ATTRIBUTE_COLOR, VERTEX_ENCODING_UNORM8X4 } } };
+const VertexFormatType VERTEX_FORMAT_COMPACT_NORMAL = { "compact_normal", 3, { { VERTEX_ATTRIBUTE_POSITION, VERTEX_ENCODING_UNORM16X4 },
+	{ VERTEX_ATTRIBUTE_COLOR, VERTEX_ENCODING_UNORM8X4 }, { VERTEX_ATTRIBUTE_NORMAL, VERTEX_ENCODING_OCTAHEDRAL16 } } };
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: VertexFormatClass
+////////////////////////////////////////////////////////////////////////////////
+/*The VertexFormatClass turns a vertex format description into everything that has to agree on it: the packed vertices
+in the mesh file, the input layout of the ColorShaderClass and the defines color_vs.hlsl is compiled with to pick the
+matching input types and decode code. Since all three come from the same description they can't drift apart.
+
+Quantized positions are stored as 0 to 1 across the bounding box of the mesh. The input assembler turns UNORM values
+into floats by itself, so instead of decoding in the shader the scale and offset back to model space are folded into
+the world matrix with GetDecodeMatrix, which costs nothing per vertex.*/
+class VertexFormatClass
+{
+public:
+	static bool IsValid(const VertexFormatType&);
+	static int GetStride(const VertexFormatType&);
+	static unsigned int GetHash(const VertexFormatType&);
+	static bool HasAttribute(const VertexFormatType&, VertexAttribute);
+
+	static void GetInputLayout(const VertexFormatType&, vector<RenderInputElement>&);
+	static void GetShaderDefines(const VertexFormatType&, vector<RenderShaderDefine>&);
+	static XMMATRIX GetDecodeMatrix(const VertexFormatType&, const XMFLOAT3&, const XMFLOAT3&);
+
+	static void Encode(const VertexFormatType&, const MeshVertexType*, int, const XMFLOAT3&, const XMFLOAT3&, void*);
+	static void Decode(const VertexFormatType&, const void*, int, const XMFLOAT3&, const XMFLOAT3&, MeshVertexType*);
+
+private:
+	static int GetEncodingSize(VertexEncoding);
+	static RenderFormat GetEncodingFormat(VertexEncoding);
+	static void GetQuantization(const XMFLOAT3&, const XMFLOAT3&, XMFLOAT3&, XMFLOAT3&);
+};
+
+#endif
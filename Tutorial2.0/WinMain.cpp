@@ -2,6 +2,11 @@
 // Filename: main.cpp
 ///////////////////
 #include "System.h"
+#include "benchmarkclass.h"
+#include "profilerclass.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 
 /*The frame work will begin with four items. It will have a WinMain function to handle the entry point of the application.
 It will also have a system class that encapsulates the entire application that will be called from within the WinMain function.
@@ -76,6 +81,49 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, PSTR lpCmdLine,
     System* system;
     bool result;
 
+	/*Starting the program with "-benchmark N" draws N frames on the headless device instead of opening the window
+	and writes the frame timings to benchmark.json. The Benchmark project does the same from the command line and can
+	also compare the results against a stored baseline. With "-replay file" as well the camera follows an input log
+	recorded with "-record file" instead of the scripted path.*/
+	if (strstr(lpCmdLine, "-benchmark"))
+	{
+		BenchmarkClass* benchmark;
+		char replayFile[MAX_PATH];
+		int frameCount;
+
+		frameCount = atoi(strstr(lpCmdLine, "-benchmark") + strlen("-benchmark"));
+		if (frameCount <= 0)
+		{
+			frameCount = 1000;
+		}
+
+		benchmark = new BenchmarkClass;
+		if (!benchmark)
+		{
+			return 1;
+		}
+
+		result = benchmark->Initialize(frameCount, frameCount / 10, 1, 0, 0, true);
+		if (result && strstr(lpCmdLine, "-replay"))
+		{
+			result = sscanf(strstr(lpCmdLine, "-replay") + strlen("-replay"), " %259s", replayFile) == 1 && benchmark->SetReplay(replayFile);
+		}
+		if (result)
+		{
+			result = benchmark->Run();
+		}
+		if (result)
+		{
+			result = benchmark->WriteResults("benchmark.json");
+		}
+
+		benchmark->Shutdown();
+		delete benchmark;
+		benchmark = 0;
+
+		return result ? 0 : 1;
+	}
+
 	// Create the system object.
 	system = new System;
 	if (!system) {
@@ -84,6 +132,15 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, PSTR lpCmdLine,
 
 	// Initialize and run the system object.
 	result = system->Initialize();
+
+	// Starting the program with "-record file" records the input of the run to the file, see InputLogClass.
+	if (result && strstr(lpCmdLine, "-record"))
+	{
+		char recordFile[MAX_PATH];
+
+		result = sscanf(strstr(lpCmdLine, "-record") + strlen("-record"), " %259s", recordFile) == 1 && system->StartRecording(recordFile);
+	}
+
 	if (result) {
 		system->Run();
 	}
@@ -95,6 +152,13 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, PSTR lpCmdLine,
 	delete system;
 	system = 0;
 
+	// Starting the program with "-trace" writes the profiler zones of the last frames to trace.json when it closes.
+	if (strstr(lpCmdLine, "-trace"))
+	{
+		ProfilerClass::WriteChromeTrace("trace.json");
+	}
+	ProfilerClass::Shutdown();
+
 	return 0;
 }
 /* As you can see we kept the WinMain function fairly simple. We create the system class and then initialize it.
@@ -9,13 +9,46 @@ represents the final pixel color. This pixel shader program is very simple as we
 it to color the pixel the same as the input value of the color. Note that the pixel shader 
 gets its input from the vertex shader output.*/
 
+/*The options are the ones of color.permutations that change the pixel shader. With TEXTURE the color is sampled from
+the texture in slot 0 instead of interpolated between the vertices, with FOG it is faded into the fog color by the
+fog factor of the vertex shader.*/
+#ifndef TEXTURE
+#define TEXTURE 0
+#endif
+
+#ifndef FOG
+#define FOG 0
+#endif
+
+
+/////////////
+// GLOBALS //
+/////////////
+#if FOG
+#include "fog.hlsli"
+#endif
+
+#if TEXTURE
+Texture2D shaderTexture : register(t0);
+SamplerState sampleType : register(s0);
+#endif
+
+
 //////////////
 // TYPEDEFS //
 //////////////
+/*This is the start of the output of the vertex shader, the normal after it isn't used here.*/
 struct PixelInputType
 {
 	float4 position : SV_POSITION;
+#if TEXTURE
+	float2 tex : TEXCOORD0;
+#else
 	float4 color : COLOR;
+#endif
+#if FOG
+	float fogFactor : FOGFACTOR;
+#endif
 };
 
 
@@ -24,5 +57,17 @@ struct PixelInputType
 ////////////////////////////////////////////////////////////////////////////////
 float4 ColorPixelShader(PixelInputType input) : SV_TARGET
 {
-	return input.color;
+	float4 color;
+
+#if TEXTURE
+	color = shaderTexture.Sample(sampleType, input.tex);
+#else
+	color = input.color;
+#endif
+
+#if FOG
+	color.rgb = lerp(fogColor.rgb, color.rgb, input.fogFactor);
+#endif
+
+	return color;
 }
\ No newline at end of file
@@ -24,16 +24,68 @@ Back then, there was only a single shared array of constants for the entire shad
 This required that you had to change the constant array every single time you called Draw.
 In Direct3D 10, constants were reorganized into one or more Constant Buffers to make it easier 
 to update some constants while leaving others alone, and thus sending less data to the GPU.*/
+/*The vertex format of the model decides what the vertex input looks like, the ColorShaderClass compiles this file with
+the defines of VertexFormatClass::GetShaderDefines. Quantized positions come in as 16 bit unsigned normalized values
+in the bounding box of the model, the world matrix already holds the scale and offset back to model space so nothing
+changes here. Normals are either three floats or two 16 bit values on an octahedron, see DecodeNormal.
+The other options are listed in color.permutations, every combination of them is compiled ahead of time into the
+shader archive (see ShaderArchiveClass). INSTANCED takes the world matrix of every instance from a second vertex
+buffer, TEXTURE replaces the vertex color with texture coordinates and FOG fades the color into the fog with the
+distance to the camera.*/
+#ifndef VERTEX_POSITION_QUANTIZED
+#define VERTEX_POSITION_QUANTIZED 0
+#endif
+
+#ifndef VERTEX_NORMAL
+#define VERTEX_NORMAL 0
+#endif
+
+#ifndef VERTEX_NORMAL_OCTAHEDRAL
+#define VERTEX_NORMAL_OCTAHEDRAL 0
+#endif
+
+#ifndef INSTANCED
+#define INSTANCED 0
+#endif
+
+#ifndef TEXTURE
+#define TEXTURE 0
+#endif
+
+#ifndef FOG
+#define FOG 0
+#endif
+
+#if VERTEX_NORMAL_OCTAHEDRAL
+#define VERTEX_NORMAL_TYPE float2
+#else
+#define VERTEX_NORMAL_TYPE float3
+#endif
+
+
 /////////////
 // GLOBALS //
 /////////////
-cbuffer MatrixBuffer
+/*The matrices are split over two buffers: FrameBuffer holds what is the same for the whole frame and ObjectBuffer
+the matrices of one draw. The C++ side binds both as slices of one big buffer that is filled once per frame.
+The world, view and projection matrices are multiplied together on the CPU for a whole batch of objects at once, so
+the vertex shaders only need the one worldViewProjectionMatrix. The view and projection matrices stay in the
+FrameBuffer for shaders that need them on their own.*/
+cbuffer FrameBuffer : register(b0)
 {
-	matrix worldMatrix;
 	matrix viewMatrix;
 	matrix projectionMatrix;
 };
 
+cbuffer ObjectBuffer : register(b1)
+{
+	matrix worldViewProjectionMatrix;
+};
+
+#if FOG
+#include "fog.hlsli"
+#endif
+
 /*Similar to C we can create our own type definitions. 
 We will use different types such as float4 that are available to HLSL which 
 make programming shaders easier and readable. In this example we are creating 
@@ -46,17 +98,64 @@ to add a number to the end such as COLOR0, COLOR1, and so forth.*/
 //////////////
 // TYPEDEFS //
 //////////////
+/*The instanced vertex shader gets the world matrix of its instance from the second vertex buffer. A matrix doesn't
+fit in one input element so it comes in as four rows, WORLD0 to WORLD3. The fog factor comes before the normal in the
+output so the pixel shader, which has no use for the normal, can leave it out of its input.*/
 struct VertexInputType
 {
 	float4 position : POSITION;
+#if TEXTURE
+	float2 tex : TEXCOORD0;
+#else
 	float4 color : COLOR;
+#endif
+#if VERTEX_NORMAL
+	VERTEX_NORMAL_TYPE normal : NORMAL;
+#endif
+#if INSTANCED
+	float4 world0 : WORLD0;
+	float4 world1 : WORLD1;
+	float4 world2 : WORLD2;
+	float4 world3 : WORLD3;
+#endif
 };
 
 struct PixelInputType
 {
 	float4 position : SV_POSITION;
+#if TEXTURE
+	float2 tex : TEXCOORD0;
+#else
 	float4 color : COLOR;
+#endif
+#if FOG
+	float fogFactor : FOGFACTOR;
+#endif
+#if VERTEX_NORMAL
+	float3 normal : NORMAL;
+#endif
 };
+
+/*DecodeNormal turns the normal of the vertex back into a unit vector in model space. An octahedral normal is the
+point on the octahedron |x| + |y| + |z| = 1 where the normal goes through it, with the lower half folded over the
+upper half so only x and y need to be stored. Unfolding the lower half is a subtraction, without branches.*/
+#if VERTEX_NORMAL
+float3 DecodeNormal(VERTEX_NORMAL_TYPE encoded)
+{
+#if VERTEX_NORMAL_OCTAHEDRAL
+	float3 normal;
+	float t;
+
+	normal = float3(encoded.x, encoded.y, 1.0f - abs(encoded.x) - abs(encoded.y));
+	t = saturate(-normal.z);
+	normal.xy += (normal.xy >= 0.0f) ? -t : t;
+
+	return normalize(normal);
+#else
+	return encoded;
+#endif
+}
+#endif
  
 /*The vertex shader is called by the GPU when it is processing data from the vertex buffers 
 that have been sent to it. This vertex shader which I named ColorVertexShader will be called for
@@ -78,17 +177,38 @@ undefined since we only read in a XYZ vector for position.*/
 PixelInputType ColorVertexShader(VertexInputType input)
 {
 	PixelInputType output;
+#if INSTANCED
+	float4x4 instanceMatrix;
+#endif
 
 	// Change the position vector to be 4 units for proper matrix calculations.
 	input.position.w = 1.0f;
 
-	// Calculate the position of the vertex against the world, view, and projection matrices.
-	output.position = mul(input.position, worldMatrix);
-	output.position = mul(output.position, viewMatrix);
-	output.position = mul(output.position, projectionMatrix);
+#if INSTANCED
+	// Put the rows of the instance world matrix back together and move the vertex into place with it first.
+	instanceMatrix = float4x4(input.world0, input.world1, input.world2, input.world3);
+	input.position = mul(input.position, instanceMatrix);
+#endif
+
+	// Calculate the position of the vertex against the world, view, and projection matrices, premultiplied.
+	output.position = mul(input.position, worldViewProjectionMatrix);
 
+#if TEXTURE
+	// Store the texture coordinates for the pixel shader to sample with.
+	output.tex = input.tex;
+#else
 	// Store the input color for the pixel shader to use.
 	output.color = input.color;
+#endif
+
+#if FOG
+	// The w of the projected position is the distance of the vertex in front of the camera.
+	output.fogFactor = GetFogFactor(output.position.w);
+#endif
+
+#if VERTEX_NORMAL
+	output.normal = DecodeNormal(input.normal);
+#endif
 
 	return output;
 }
\ No newline at end of file
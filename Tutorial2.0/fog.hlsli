@@ -0,0 +1,26 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: fog.hlsli
+////////////////////////////////////////////////////////////////////////////////
+
+
+/////////////
+// GLOBALS //
+/////////////
+/*The fog is linear: nothing of it in front of fogStart and nothing but fog behind fogEnd, both in units in front of
+the camera. The vertex shader uses the distances and the pixel shader the color, both include this file so they
+agree on the layout of the buffer.*/
+cbuffer FogBuffer : register(b2)
+{
+	float fogStart;
+	float fogEnd;
+	float2 fogPadding;
+	float4 fogColor;
+};
+
+
+/*GetFogFactor turns a depth in front of the camera into how much of the color is left, 1 before the fog starts
+and 0 where it ends.*/
+float GetFogFactor(float depth)
+{
+	return saturate((fogEnd - depth) / (fogEnd - fogStart));
+}